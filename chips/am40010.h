@@ -15,6 +15,10 @@
     ~~~C    
     CHIPS_ASSERT(c)
     ~~~
+
+    You need to include the following headers before including am40010.h:
+
+    - chips/chips_state.h
     
     ## Emulated Pins
 
@@ -146,6 +150,10 @@ typedef void (*am40010_bankswitch_t)(uint8_t ram_config, uint8_t rom_enable, uin
    and AY-3-8910 chips.
 */
 typedef uint64_t (*am40010_cclk_t)(void* user_data);
+/* optional callback when a line of the visible area has been decoded (y is the framebuffer line) */
+typedef void (*am40010_crtline_t)(int y, void* user_data);
+/* optional callback at the start of a new CRT frame (the frame in rgba8_buffer is complete) */
+typedef void (*am40010_vsync_t)(void* user_data);
 
 /* host system type (same as cpc_type_t) */
 typedef enum am40010_cpc_type_t {
@@ -159,6 +167,8 @@ typedef struct am40010_desc_t {
     am40010_cpc_type_t cpc_type;        /* host system type (mainly for bank switching) */
     am40010_bankswitch_t bankswitch_cb; /* memory bank-switching callback */
     am40010_cclk_t cclk_cb;             /* the 1 MHz CCLK callback */
+    am40010_crtline_t crtline_cb;       /* optional callback when a visible line has been decoded */
+    am40010_vsync_t vsync_cb;           /* optional callback at the start of a new CRT frame */
     const uint8_t* ram;                 /* direct pointer to the gate-array-visible 4*16 KByte RAM banks */
     uint32_t ram_size;                  /* must be >= 64 KBytes */
     uint32_t* rgba8_buffer;             /* pointer the RGBA8 output framebuffer */
@@ -220,6 +230,8 @@ typedef struct am40010_t {
     am40010_colors_t colors;
     am40010_bankswitch_t bankswitch_cb;
     am40010_cclk_t cclk_cb;
+    am40010_crtline_t crtline_cb;
+    am40010_vsync_t vsync_cb;
     const uint8_t* ram;
     uint32_t* rgba8_buffer;
     void* user_data;
@@ -247,6 +259,8 @@ void am40010_iorq(am40010_t* ga, uint64_t cpu_pins);
         Z80_INT         - interrupt request from the gate array was triggered
 */
 uint64_t am40010_tick(am40010_t* ga, int num_ticks, uint64_t cpu_pins);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* am40010_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -367,6 +381,8 @@ void am40010_init(am40010_t* ga, const am40010_desc_t* desc) {
     ga->cpc_type = desc->cpc_type;
     ga->bankswitch_cb = desc->bankswitch_cb;
     ga->cclk_cb = desc->cclk_cb;
+    ga->crtline_cb = desc->crtline_cb;
+    ga->vsync_cb = desc->vsync_cb;
     ga->ram = desc->ram;
     ga->rgba8_buffer = desc->rgba8_buffer;
     ga->user_data = desc->user_data;
@@ -517,7 +533,12 @@ static void _am40010_crt_tick(am40010_t* ga, bool sync) {
         }
     }
     if (new_line) {
-        /* new scanline */
+        /* new scanline, report the finished framebuffer line (not in debug visualization mode) */
+        if (ga->crtline_cb && ga->rgba8_buffer && !ga->dbg_vis &&
+            (crt->v_pos >= _AM40010_CRT_VIS_Y0) && (crt->v_pos < _AM40010_CRT_VIS_Y1))
+        {
+            ga->crtline_cb(crt->v_pos - _AM40010_CRT_VIS_Y0, ga->user_data);
+        }
         crt->h_pos = 0;
         crt->v_pos++;
         if (crt->v_pos == _AM40010_CRT_V_DISPLAY_START) {
@@ -536,6 +557,9 @@ static void _am40010_crt_tick(am40010_t* ga, bool sync) {
     }
     if (new_frame) {
         crt->v_pos = 0;
+        if (ga->vsync_cb) {
+            ga->vsync_cb(ga->user_data);
+        }
     }
 
     /* compute visible beam state */
@@ -709,6 +733,10 @@ static void _am40010_decode_pixels(am40010_t* ga, uint32_t* dst, uint64_t crtc_p
 
 /* video signal generator, call this at 1 MHz frequency */
 static void _am40010_decode_video(am40010_t* ga, uint64_t crtc_pins) {
+    /* a null framebuffer pointer means: skip video decoding (e.g. for run-ahead) */
+    if (0 == ga->rgba8_buffer) {
+        return;
+    }
     if (ga->dbg_vis) {
         int dst_x = ga->crt.h_pos * 16;
         int dst_y = ga->crt.v_pos;
@@ -863,4 +891,62 @@ uint64_t am40010_tick(am40010_t* ga, int num_ticks, uint64_t pins) {
     ga->pins = pins | ((AM40010_DE|AM40010_HS|AM40010_VS) & ga->crtc_pins);
     return pins;
 }
+
+static const chips_state_field_t _am40010_registers_state_fields[] = {
+    CHIPS_FIELD_U8(am40010_registers_t, inksel),
+    CHIPS_FIELD_U8(am40010_registers_t, config),
+    CHIPS_FIELD_U8(am40010_registers_t, border),
+    CHIPS_FIELD_U8(am40010_registers_t, ink),
+};
+
+static const chips_state_field_t _am40010_video_state_fields[] = {
+    CHIPS_FIELD_INT(am40010_video_t, hscount),
+    CHIPS_FIELD_INT(am40010_video_t, intcnt),
+    CHIPS_FIELD_INT(am40010_video_t, clkcnt),
+    CHIPS_FIELD_U8(am40010_video_t, mode),
+    CHIPS_FIELD_BOOL(am40010_video_t, sync),
+    CHIPS_FIELD_BOOL(am40010_video_t, intr),
+};
+
+static const chips_state_field_t _am40010_crt_state_fields[] = {
+    CHIPS_FIELD_INT(am40010_crt_t, pos_x),
+    CHIPS_FIELD_INT(am40010_crt_t, pos_y),
+    CHIPS_FIELD_INT(am40010_crt_t, sync_count),
+    CHIPS_FIELD_INT(am40010_crt_t, h_pos),
+    CHIPS_FIELD_INT(am40010_crt_t, v_pos),
+    CHIPS_FIELD_INT(am40010_crt_t, h_retrace),
+    CHIPS_FIELD_INT(am40010_crt_t, v_retrace),
+    CHIPS_FIELD_BOOL(am40010_crt_t, visible),
+    CHIPS_FIELD_BOOL(am40010_crt_t, sync),
+    CHIPS_FIELD_BOOL(am40010_crt_t, h_blank),
+    CHIPS_FIELD_BOOL(am40010_crt_t, v_blank),
+};
+
+static const chips_state_field_t _am40010_colors_state_fields[] = {
+    CHIPS_FIELD_BOOL(am40010_colors_t, dirty),
+    CHIPS_FIELD_U32(am40010_colors_t, ink_rgba8),
+    CHIPS_FIELD_U32(am40010_colors_t, border_rgba8),
+    CHIPS_FIELD_U32(am40010_colors_t, hw_rgba8),
+};
+
+static const chips_state_field_t _am40010_state_fields[] = {
+    CHIPS_FIELD_BOOL(am40010_t, dbg_vis),
+    CHIPS_FIELD_ENUM(am40010_t, cpc_type),
+    CHIPS_FIELD_U32(am40010_t, seq_tick_count),
+    CHIPS_FIELD_U64(am40010_t, crtc_pins),
+    CHIPS_FIELD_U8(am40010_t, rom_select),
+    CHIPS_FIELD_U8(am40010_t, ram_config),
+    CHIPS_FIELD_STRUCT(am40010_t, regs, am40010_registers_t, _am40010_registers_state_fields),
+    CHIPS_FIELD_STRUCT(am40010_t, video, am40010_video_t, _am40010_video_state_fields),
+    CHIPS_FIELD_STRUCT(am40010_t, crt, am40010_crt_t, _am40010_crt_state_fields),
+    CHIPS_FIELD_STRUCT(am40010_t, colors, am40010_colors_t, _am40010_colors_state_fields),
+    CHIPS_FIELD_U64(am40010_t, pins),
+};
+
+static const chips_state_desc_t _am40010_state_desc = CHIPS_STATE_DESC("am40010", am40010_t, _am40010_state_fields);
+
+const chips_state_desc_t* am40010_state_desc(void) {
+    return &_am40010_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
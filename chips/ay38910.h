@@ -11,6 +11,10 @@
     
     CHIPS_ASSERT(c)     -- your own assert macro (default: assert(c))
 
+    You need to include the following headers before including ay38910.h:
+
+    - chips/chips_state.h
+
     EMULATED PINS:
 
              +-----------+
@@ -255,6 +259,8 @@ void ay38910_reset(ay38910_t* ay);
 uint64_t ay38910_iorq(ay38910_t* ay, uint64_t pins);
 /* tick the AY-3-8910, return true if a new sample is ready */
 bool ay38910_tick(ay38910_t* ay);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* ay38910_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -595,4 +601,52 @@ uint64_t ay38910_iorq(ay38910_t* ay, uint64_t pins) {
     return pins;
 }
 
+static const chips_state_field_t _ay38910_tone_state_fields[] = {
+    CHIPS_FIELD_U16(ay38910_tone_t, period),
+    CHIPS_FIELD_U16(ay38910_tone_t, counter),
+    CHIPS_FIELD_U32(ay38910_tone_t, bit),
+    CHIPS_FIELD_U32(ay38910_tone_t, tone_disable),
+    CHIPS_FIELD_U32(ay38910_tone_t, noise_disable),
+};
+
+static const chips_state_field_t _ay38910_noise_state_fields[] = {
+    CHIPS_FIELD_U16(ay38910_noise_t, period),
+    CHIPS_FIELD_U16(ay38910_noise_t, counter),
+    CHIPS_FIELD_U32(ay38910_noise_t, rng),
+    CHIPS_FIELD_U32(ay38910_noise_t, bit),
+};
+
+static const chips_state_field_t _ay38910_env_state_fields[] = {
+    CHIPS_FIELD_U16(ay38910_env_t, period),
+    CHIPS_FIELD_U16(ay38910_env_t, counter),
+    CHIPS_FIELD_BOOL(ay38910_env_t, shape_holding),
+    CHIPS_FIELD_BOOL(ay38910_env_t, shape_hold),
+    CHIPS_FIELD_U8(ay38910_env_t, shape_counter),
+    CHIPS_FIELD_U8(ay38910_env_t, shape_state),
+};
+
+static const chips_state_field_t _ay38910_state_fields[] = {
+    CHIPS_FIELD_ENUM(ay38910_t, type),
+    CHIPS_FIELD_U32(ay38910_t, tick),
+    CHIPS_FIELD_U8(ay38910_t, addr),
+    CHIPS_FIELD_U8(ay38910_t, reg),
+    CHIPS_FIELD_STRUCT(ay38910_t, tone, ay38910_tone_t, _ay38910_tone_state_fields),
+    CHIPS_FIELD_STRUCT(ay38910_t, noise, ay38910_noise_t, _ay38910_noise_state_fields),
+    CHIPS_FIELD_STRUCT(ay38910_t, env, ay38910_env_t, _ay38910_env_state_fields),
+    CHIPS_FIELD_U64(ay38910_t, pins),
+    CHIPS_FIELD_INT(ay38910_t, sample_period),
+    CHIPS_FIELD_INT(ay38910_t, sample_counter),
+    CHIPS_FIELD_FLOAT(ay38910_t, mag),
+    CHIPS_FIELD_FLOAT(ay38910_t, sample),
+    CHIPS_FIELD_FLOAT(ay38910_t, dcadj_sum),
+    CHIPS_FIELD_U32(ay38910_t, dcadj_pos),
+    CHIPS_FIELD_FLOAT(ay38910_t, dcadj_buf),
+};
+
+static const chips_state_desc_t _ay38910_state_desc = CHIPS_STATE_DESC("ay38910", ay38910_t, _ay38910_state_fields);
+
+const chips_state_desc_t* ay38910_state_desc(void) {
+    return &_ay38910_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
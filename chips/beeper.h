@@ -4,6 +4,10 @@
 
     TODO: docs
 
+    You need to include the following headers before including beeper.h:
+
+    - chips/chips_state.h
+
     ## zlib/libpng license
 
     Copyright (c) 2018 Andre Weissflog
@@ -60,6 +64,8 @@ static inline void beeper_toggle(beeper_t* beeper) {
 }
 /* tick the beeper, return true if a new sample is ready */
 bool beeper_tick(beeper_t* beeper);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* beeper_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -112,5 +118,21 @@ bool beeper_tick(beeper_t* bp) {
     return false;
 }
 
+static const chips_state_field_t _beeper_state_fields[] = {
+    CHIPS_FIELD_INT(beeper_t, state),
+    CHIPS_FIELD_INT(beeper_t, period),
+    CHIPS_FIELD_INT(beeper_t, counter),
+    CHIPS_FIELD_FLOAT(beeper_t, mag),
+    CHIPS_FIELD_FLOAT(beeper_t, sample),
+    CHIPS_FIELD_FLOAT(beeper_t, dcadj_sum),
+    CHIPS_FIELD_U32(beeper_t, dcadj_pos),
+    CHIPS_FIELD_FLOAT(beeper_t, dcadj_buf),
+};
+
+static const chips_state_desc_t _beeper_state_desc = CHIPS_STATE_DESC("beeper", beeper_t, _beeper_state_fields);
+
+const chips_state_desc_t* beeper_state_desc(void) {
+    return &_beeper_state_desc;
+}
 
 #endif /* CHIPS_IMPL */
@@ -0,0 +1,120 @@
+#pragma once
+/*#
+    # chips_state.h
+
+    Chip state introspection types and helper macros, shared by all chip
+    headers which export a field descriptor table (e.g. z80_state_desc()).
+    Include this file once before including those chip headers:
+
+    ~~~C
+    #include "chips/chips_state.h"
+    #include "chips/z80.h"
+    #include "chips/ay38910.h"
+    ...
+    ~~~
+
+    See util/chipstate.h for the functions which operate on the
+    descriptor tables.
+
+    ## Field Descriptor Macros
+
+    ~~~C
+    CHIPS_FIELD_BOOL(type, field)
+    CHIPS_FIELD_U8(type, field)
+    CHIPS_FIELD_U16(type, field)
+    CHIPS_FIELD_U32(type, field)
+    CHIPS_FIELD_U64(type, field)
+    CHIPS_FIELD_INT(type, field)
+    CHIPS_FIELD_FLOAT(type, field)
+    ~~~
+        Describe a scalar or array field of the given element type, the
+        element count is derived from the field size.
+
+    ~~~C
+    CHIPS_FIELD_ENUM(type, field)
+    CHIPS_FIELD_ENUM_ARRAY(type, field)
+    ~~~
+        Describe an enum field, or an array of enums. The element size is
+        taken from the field itself, so use CHIPS_FIELD_ENUM_ARRAY for
+        arrays (CHIPS_FIELD_ENUM would describe the whole array as one
+        element).
+
+    ~~~C
+    CHIPS_FIELD_STRUCT(type, field, ctype, fields)
+    ~~~
+        Describe a nested struct (or array of structs) of type ctype,
+        with the nested descriptor table 'fields'.
+
+    ~~~C
+    CHIPS_STATE_DESC(name, type, fields)
+    ~~~
+        Build the top-level chips_state_desc_t for a chip state struct.
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    CHIPS_STATE_BOOL,
+    CHIPS_STATE_UINT,
+    CHIPS_STATE_INT,
+    CHIPS_STATE_FLOAT,
+    CHIPS_STATE_STRUCT,
+} chips_state_kind_t;
+
+typedef struct chips_state_field_t {
+    const char* name;           /* field name */
+    chips_state_kind_t kind;    /* CHIPS_STATE_xxx */
+    uint32_t offset;            /* byte offset in parent struct */
+    uint32_t size;              /* byte size of one element */
+    uint32_t count;             /* number of elements (1 if not an array) */
+    const struct chips_state_field_t* fields;   /* nested fields for CHIPS_STATE_STRUCT */
+    int num_fields;
+} chips_state_field_t;
+
+typedef struct {
+    const char* name;           /* chip name */
+    uint32_t size;              /* byte size of the chip state struct */
+    const chips_state_field_t* fields;
+    int num_fields;
+} chips_state_desc_t;
+
+/* helper macros to build field descriptor tables */
+#define _CHIPS_FIELD(kind, type, field, ctype) { #field, kind, (uint32_t)offsetof(type, field), (uint32_t)sizeof(ctype), (uint32_t)(sizeof(((type*)0)->field)/sizeof(ctype)), 0, 0 }
+#define CHIPS_FIELD_BOOL(type, field) _CHIPS_FIELD(CHIPS_STATE_BOOL, type, field, bool)
+#define CHIPS_FIELD_U8(type, field) _CHIPS_FIELD(CHIPS_STATE_UINT, type, field, uint8_t)
+#define CHIPS_FIELD_U16(type, field) _CHIPS_FIELD(CHIPS_STATE_UINT, type, field, uint16_t)
+#define CHIPS_FIELD_U32(type, field) _CHIPS_FIELD(CHIPS_STATE_UINT, type, field, uint32_t)
+#define CHIPS_FIELD_U64(type, field) _CHIPS_FIELD(CHIPS_STATE_UINT, type, field, uint64_t)
+#define CHIPS_FIELD_INT(type, field) _CHIPS_FIELD(CHIPS_STATE_INT, type, field, int)
+#define CHIPS_FIELD_ENUM(type, field) _CHIPS_FIELD(CHIPS_STATE_INT, type, field, ((type*)0)->field)
+#define CHIPS_FIELD_ENUM_ARRAY(type, field) _CHIPS_FIELD(CHIPS_STATE_INT, type, field, ((type*)0)->field[0])
+#define CHIPS_FIELD_FLOAT(type, field) _CHIPS_FIELD(CHIPS_STATE_FLOAT, type, field, float)
+#define CHIPS_FIELD_STRUCT(type, field, ctype, fields) { #field, CHIPS_STATE_STRUCT, (uint32_t)offsetof(type, field), (uint32_t)sizeof(ctype), (uint32_t)(sizeof(((type*)0)->field)/sizeof(ctype)), fields, (int)(sizeof(fields)/sizeof(fields[0])) }
+#define CHIPS_STATE_DESC(name, type, fields) { name, (uint32_t)sizeof(type), fields, (int)(sizeof(fields)/sizeof(fields[0])) }
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
@@ -35,7 +35,9 @@
     ~~~
         Compute the number of ticks to execute for the given number of micro-seconds.
         Usually this is called once per frame to compute the required
-        number of ticks for a CPU emulator to run in realtime.
+        number of ticks for a CPU emulator to run in realtime. The
+        fractional part of the tick count is carried over into the next
+        call, so that the emulated clock doesn't drift over time.
 
     ~~~C
     void clk_ticks_executed(clk_t* clk, uint32_t ticks)
@@ -46,6 +48,22 @@
         from the number of ticks to execute in the next call to
         clk_ticks_to_tun().
 
+    ~~~C
+    void clk_pacer_init(clk_pacer_t* pacer)
+    ~~~
+        Initialize a clk_pacer_t instance (see Audio Pacing below).
+
+    ~~~C
+    uint32_t clk_pace(clk_pacer_t* pacer, uint32_t frame_time_us, int audio_fill, int audio_capacity)
+    ~~~
+        Returns the number of micro-seconds to emulate for a host frame
+        of frame_time_us micro-seconds, slightly stretched or squeezed
+        depending on the fill level of the host's audio buffer.
+        audio_fill is the number of samples currently queued for
+        playback, and audio_capacity the size of the audio buffer in
+        samples. If audio_capacity is zero, the frame time is
+        passed through unmodified.
+
     ## Example
 
     For a Z80 system running a 2 MHz initialize a clk_t instance like
@@ -66,6 +84,36 @@
     clk_ticks_executed(&clk, ticks_executed);
     ~~~
 
+    ## Audio Pacing
+
+    The host display and the host audio device run on different clocks.
+    If the emulation is paced by the display, the emulated system
+    generates audio samples slightly faster or slower than the audio
+    device plays them back, and the host's audio buffer will eventually
+    run dry or overflow, which is audible as crackles.
+
+    A clk_pacer_t fixes this with 'dynamic rate control': the emulated
+    time per host frame is adjusted by up to +/-0.5% (CLK_PACER_MAX_PPM)
+    so that the audio buffer stays half full. If the buffer is more
+    than half full, a bit less time is emulated, if it is less than half
+    full, a bit more. The pitch change is too small to be noticeable.
+
+    The result of clk_pace() can be passed to any system's exec function,
+    for instance with sokol_audio.h:
+
+    ~~~C
+    static clk_pacer_t pacer;
+    clk_pacer_init(&pacer);
+    ...
+    // once per host frame
+    const int capacity = saudio_buffer_frames();
+    const int fill = capacity - saudio_expect();
+    c64_exec(&c64, clk_pace(&pacer, frame_time_us, fill, capacity));
+    ~~~
+
+    The fractional micro-seconds are carried over into the next frame,
+    so without audio feedback clk_pace() returns exactly the frame time.
+
     ## zlib/libpng license
 
     Copyright (c) 2018 Andre Weissflog
@@ -90,12 +138,22 @@
 extern "C" {
 #endif
 
+/* max audio pacing adjustment in parts per million (+/-0.5%) */
+#define CLK_PACER_MAX_PPM (5000)
+
 typedef struct {
     int64_t freq_hz;
     int ticks_to_run;
     int overrun_ticks;
+    uint32_t frac_ticks;    /* fractional ticks carried into next frame, in 1/1000000 ticks */
 } clk_t;
 
+/* paces emulated time by the host audio buffer fill level */
+typedef struct {
+    int rate_ppm;           /* current rate adjustment in parts per million */
+    uint32_t frac_us;       /* fractional micro-seconds carried into next frame, in 1/1000000 us */
+} clk_pacer_t;
+
 /* helper func to convert micro_seconds into ticks */
 uint32_t clk_us_to_ticks(uint64_t freq_hz, uint32_t micro_seconds);
 /* setup a clock instance with a frequency in Hz */
@@ -104,6 +162,10 @@ void clk_init(clk_t* clk, uint32_t freq_hz);
 uint32_t clk_ticks_to_run(clk_t* clk, uint32_t micro_seconds);
 /* call once per frame with actual number of executed ticks */
 void clk_ticks_executed(clk_t* clk, uint32_t ticks);
+/* setup an audio pacer */
+void clk_pacer_init(clk_pacer_t* pacer);
+/* call once per host frame to compute the emulated time for the frame */
+uint32_t clk_pace(clk_pacer_t* pacer, uint32_t frame_time_us, int audio_fill, int audio_capacity);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -130,7 +192,9 @@ uint32_t clk_us_to_ticks(uint64_t freq_hz, uint32_t micro_seconds) {
 
 uint32_t clk_ticks_to_run(clk_t* clk, uint32_t micro_seconds) {
     CHIPS_ASSERT(clk && (micro_seconds > 0));
-    int ticks = (int) ((clk->freq_hz * micro_seconds) / 1000000);
+    const int64_t t = clk->freq_hz * micro_seconds + clk->frac_ticks;
+    int ticks = (int) (t / 1000000);
+    clk->frac_ticks = (uint32_t) (t % 1000000);
     clk->ticks_to_run = ticks - clk->overrun_ticks;
     if (clk->ticks_to_run < 1) {
         clk->ticks_to_run = 1;
@@ -146,4 +210,30 @@ void clk_ticks_executed(clk_t* clk, uint32_t ticks_executed) {
         clk->overrun_ticks = 0;
     }
 }
+
+void clk_pacer_init(clk_pacer_t* pacer) {
+    CHIPS_ASSERT(pacer);
+    memset(pacer, 0, sizeof(clk_pacer_t));
+}
+
+uint32_t clk_pace(clk_pacer_t* pacer, uint32_t frame_time_us, int audio_fill, int audio_capacity) {
+    CHIPS_ASSERT(pacer && (audio_fill >= 0) && (audio_capacity >= 0));
+    if (audio_capacity > 0) {
+        /* linear rate control: +max at an empty buffer, -max at a full buffer */
+        int64_t ppm = ((int64_t)CLK_PACER_MAX_PPM * (audio_capacity - 2 * (int64_t)audio_fill)) / audio_capacity;
+        if (ppm > CLK_PACER_MAX_PPM) {
+            ppm = CLK_PACER_MAX_PPM;
+        }
+        else if (ppm < -CLK_PACER_MAX_PPM) {
+            ppm = -CLK_PACER_MAX_PPM;
+        }
+        pacer->rate_ppm = (int) ppm;
+    }
+    else {
+        pacer->rate_ppm = 0;
+    }
+    const uint64_t t = (uint64_t)frame_time_us * (uint64_t)(1000000 + pacer->rate_ppm) + pacer->frac_us;
+    pacer->frac_us = (uint32_t) (t % 1000000);
+    return (uint32_t) (t / 1000000);
+}
 #endif
@@ -11,6 +11,10 @@
     
         CHIPS_ASSERT(c)     -- your own assert macro (default: assert(c))
 
+    You need to include the following headers before including i8255.h:
+
+    - chips/chips_state.h
+
     EMULATED PINS:
 
                   +-----------+
@@ -241,6 +245,8 @@ void i8255_init(i8255_t* ppi);
 void i8255_reset(i8255_t* ppi);
 /* tick i8255_t instance */
 uint64_t i8255_tick(i8255_t* ppi, uint64_t pins);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* i8255_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -378,4 +384,22 @@ uint64_t i8255_tick(i8255_t* ppi, uint64_t pins) {
     return pins;
 }
 
+static const chips_state_field_t _i8255_port_state_fields[] = {
+    CHIPS_FIELD_U8(i8255_port_t, outp),
+};
+
+static const chips_state_field_t _i8255_state_fields[] = {
+    CHIPS_FIELD_STRUCT(i8255_t, pa, i8255_port_t, _i8255_port_state_fields),
+    CHIPS_FIELD_STRUCT(i8255_t, pb, i8255_port_t, _i8255_port_state_fields),
+    CHIPS_FIELD_STRUCT(i8255_t, pc, i8255_port_t, _i8255_port_state_fields),
+    CHIPS_FIELD_U8(i8255_t, control),
+    CHIPS_FIELD_U64(i8255_t, pins),
+};
+
+static const chips_state_desc_t _i8255_state_desc = CHIPS_STATE_DESC("i8255", i8255_t, _i8255_state_fields);
+
+const chips_state_desc_t* i8255_state_desc(void) {
+    return &_i8255_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
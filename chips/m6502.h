@@ -2,7 +2,7 @@
 /*#
     # m6502.h
 
-    MOS Technology 6502 / 6510 CPU emulator.
+    MOS Technology 6502 / 6510, Ricoh 2A03 and CMOS 65C02 CPU emulator.
 
     Project repo: https://github.com/floooh/chips/
     
@@ -21,6 +21,21 @@
     CHIPS_ASSERT(c)
     ~~~
 
+    ~~~C
+    CHIPS_M6502_COMPUTED_GOTO
+    ~~~
+        if defined, and the compiler is GCC or Clang, the tick functions
+        dispatch through a table of label addresses (the 'labels as values'
+        extension) instead of a switch-case statement, and each instruction
+        step has its own copy of the tick epilogue. This removes the jump
+        table bounds check and gives the branch predictor one jump site
+        per instruction step. On other compilers the define is ignored
+        and the regular switch-case decoder is used.
+
+    You need to include the following headers before including m6502.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
 
     ***********************************
@@ -40,6 +55,39 @@
 
     The input/output P0..P5 pins only exist on the m6510.
 
+    ## CPU Variants
+
+    Each supported CPU variant has its own code-generated instruction
+    decoder in a separate tick function, so that variant-specific behaviour
+    (like the decimal mode) is resolved when the decoder is generated
+    instead of being checked at runtime. Pick the tick function which
+    matches the emulated CPU, the m6502_t struct and m6502_init()
+    are shared between all variants:
+
+    - **m6502_tick()**: the NMOS 6502 including decimal mode and
+      the undocumented instructions
+    - **m6510_tick()**: same as m6502_tick(), but also updates the
+      M6510_P0..P5 IO port pins (see m6510_iorq())
+    - **m2a03_tick()**: the Ricoh 2A03 used in NES-class machines, this is an
+      NMOS 6502 without decimal mode (the D flag can be set and cleared,
+      but doesn't affect ADC and SBC)
+    - **m65c02_tick()**: the CMOS 65C02 (without the Rockwell/WDC
+      bit manipulation instructions). Differences to the NMOS 6502:
+        - the new instructions BRA, PHX, PHY, PLX, PLY, STZ, TRB, TSB,
+          INC A, DEC A, the (zp) addressing mode, BIT #/zp,X/abs,X and
+          JMP (abs,X)
+        - JMP (abs) doesn't have the page-wrap bug and takes 6 cycles
+        - the N and Z flags are valid in decimal mode, and ADC/SBC take
+          an additional cycle in decimal mode
+        - BRK and interrupts clear the D flag
+        - read-modify-write instructions perform a dummy read instead
+          of a dummy write, and ASL/LSR/ROL/ROR abs,X take 6 cycles
+          if no page boundary is crossed
+        - all undocumented NMOS instructions are NOPs of different
+          length and duration
+      The dummy read addresses of indexed addressing modes are not
+      emulated exactly.
+
     If the RDY pin is active (1) the CPU will loop on the next read
     access until the pin goes inactive.
 
@@ -54,7 +102,6 @@
 
         ~~~C
         typedef struct {
-            bool bcd_disabled;          // set to true if BCD mode is disabled
             m6510_in_t in_cb;           // only m6510: port IO input callback
             m6510_out_t out_cb;         // only m6510: port IO output callback
             uint8_t m6510_io_pullup;    // only m6510: IO port bits that are 1 when reading
@@ -71,7 +118,8 @@
     m6502_init() will return a 64-bit pin mask which must be the input argument
     to the first call of m6502_tick().
 
-    To execute instructions, call m6502_tick() in a loop. m6502_tick() takes
+    To execute instructions, call m6502_tick() (or one of the other
+    variant tick functions) in a loop. m6502_tick() takes
     a 64-bit pin mask as input, executes one clock tick, and returns
     a modified pin mask.
 
@@ -145,7 +193,6 @@
         initialization attributes:
             ~~~C
             typedef struct {
-                bool bcd_disabled;              // set to true if BCD mode is disabled
                 m6510_in_t m6510_in_cb;         // m6510 only: optional port IO input callback
                 m6510_out_t m6510_out_cb;       // m6510 only: optional port IO output callback
                 void* m6510_user_data;          // m6510 only: optional callback user data
@@ -166,10 +213,18 @@
         is the current state of the CPU pins used to communicate with the
         outside world (see the Overview section above for details).
 
+    ~~~C
+    uint64_t m6510_tick(m6502_t* cpu, uint64_t pins)
+    uint64_t m2a03_tick(m6502_t* cpu, uint64_t pins)
+    uint64_t m65c02_tick(m6502_t* cpu, uint64_t pins)
+    ~~~
+        Same as m6502_tick() for the other CPU variants (see the section
+        CPU Variants above).
+
     ~~~C
     uint64_t m6510_iorq(m6502_t* cpu, uint64_t pins)
     ~~~
-        For the 6510, call this function after the tick callback when memory
+        For the 6510, call this function after m6510_tick() when memory
         access to the special addresses 0 and 1 are requested. m6510_iorq()
         may call the input/output callback functions provided in m6502_desc_t.
 
@@ -277,7 +332,6 @@ typedef uint8_t (*m6510_in_t)(void* user_data);
 
 /* the desc structure provided to m6502_init() */
 typedef struct {
-    bool bcd_disabled;              /* set to true if BCD mode is disabled */
     m6510_in_t m6510_in_cb;         /* optional port IO input callback (only on m6510) */
     m6510_out_t m6510_out_cb;       /* optional port IO output callback (only on m6510) */
     void* m6510_user_data;          /* optional callback user data */
@@ -295,7 +349,6 @@ typedef struct {
     uint16_t irq_pip;
     uint16_t nmi_pip;
     uint8_t brk_flags;  /* M6502_BRK_* */
-    uint8_t bcd_enabled;
     /* 6510 IO port state */
     void* user_data;
     m6510_in_t in_cb;
@@ -311,8 +364,14 @@ typedef struct {
 
 /* initialize a new m6502 instance and return initial pin mask */
 uint64_t m6502_init(m6502_t* cpu, const m6502_desc_t* desc);
-/* execute one tick */
+/* execute one tick (NMOS 6502) */
 uint64_t m6502_tick(m6502_t* cpu, uint64_t pins);
+/* execute one tick (NMOS 6510 with IO port) */
+uint64_t m6510_tick(m6502_t* cpu, uint64_t pins);
+/* execute one tick (Ricoh 2A03, no decimal mode) */
+uint64_t m2a03_tick(m6502_t* cpu, uint64_t pins);
+/* execute one tick (CMOS 65C02) */
+uint64_t m65c02_tick(m6502_t* cpu, uint64_t pins);
 /* perform m6510 port IO (only call this if M6510_CHECK_IO(pins) is true) */
 uint64_t m6510_iorq(m6502_t* cpu, uint64_t pins);
 
@@ -346,6 +405,8 @@ uint16_t m6502_pc(m6502_t* cpu);
 #define M6510_SET_PORT(p,d) {p=(((p)&~M6510_PORT_BITS)|((((uint64_t)d)<<32)&M6510_PORT_BITS));}
 /* M6510: check for IO port access to address 0 or 1 */
 #define M6510_CHECK_IO(p) ((p&0xFFFEULL)==0)
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* m6502_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -376,8 +437,23 @@ uint16_t m6502_pc(m6502_t* cpu) { return cpu->PC; }
 /* helper macros and functions for code-generated instruction decoder */
 #define _M6502_NZ(p,v) ((p&~(M6502_NF|M6502_ZF))|((v&0xFF)?(v&M6502_NF):M6502_ZF))
 
+/* ADC without decimal mode */
+static inline void _m6502_adc_bin(m6502_t* cpu, uint8_t val) {
+    uint16_t sum = cpu->A + val + (cpu->P & M6502_CF ? 1:0);
+    cpu->P &= ~(M6502_VF|M6502_CF);
+    cpu->P = _M6502_NZ(cpu->P,sum);
+    if (~(cpu->A^val) & (cpu->A^sum) & 0x80) {
+        cpu->P |= M6502_VF;
+    }
+    if (sum & 0xFF00) {
+        cpu->P |= M6502_CF;
+    }
+    cpu->A = sum & 0xFF;
+}
+
+/* ADC with NMOS decimal mode */
 static inline void _m6502_adc(m6502_t* cpu, uint8_t val) {
-    if (cpu->bcd_enabled && (cpu->P & M6502_DF)) {
+    if (cpu->P & M6502_DF) {
         /* decimal mode (credit goes to MAME) */
         uint8_t c = cpu->P & M6502_CF ? 1 : 0;
         cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
@@ -404,22 +480,35 @@ static inline void _m6502_adc(m6502_t* cpu, uint8_t val) {
         cpu->A = (ah<<4) | (al & 0x0F);
     }
     else {
-        /* default mode */
-        uint16_t sum = cpu->A + val + (cpu->P & M6502_CF ? 1:0);
-        cpu->P &= ~(M6502_VF|M6502_CF);
-        cpu->P = _M6502_NZ(cpu->P,sum);
-        if (~(cpu->A^val) & (cpu->A^sum) & 0x80) {
-            cpu->P |= M6502_VF;
-        }
-        if (sum & 0xFF00) {
-            cpu->P |= M6502_CF;
-        }
-        cpu->A = sum & 0xFF;
-    }    
+        _m6502_adc_bin(cpu, val);
+    }
+}
+
+/* ADC with CMOS decimal mode (N and Z flags are valid) */
+static inline void _m65c02_adc(m6502_t* cpu, uint8_t val) {
+    _m6502_adc(cpu, val);
+    if (cpu->P & M6502_DF) {
+        cpu->P = _M6502_NZ(cpu->P, cpu->A);
+    }
 }
 
+/* SBC without decimal mode */
+static inline void _m6502_sbc_bin(m6502_t* cpu, uint8_t val) {
+    uint16_t diff = cpu->A - val - (cpu->P & M6502_CF ? 0 : 1);
+    cpu->P &= ~(M6502_VF|M6502_CF);
+    cpu->P = _M6502_NZ(cpu->P, (uint8_t)diff);
+    if ((cpu->A^val) & (cpu->A^diff) & 0x80) {
+        cpu->P |= M6502_VF;
+    }
+    if (!(diff & 0xFF00)) {
+        cpu->P |= M6502_CF;
+    }
+    cpu->A = diff & 0xFF;
+}
+
+/* SBC with NMOS decimal mode */
 static inline void _m6502_sbc(m6502_t* cpu, uint8_t val) {
-    if (cpu->bcd_enabled && (cpu->P & M6502_DF)) {
+    if (cpu->P & M6502_DF) {
         /* decimal mode (credit goes to MAME) */
         uint8_t c = cpu->P & M6502_CF ? 0 : 1;
         cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
@@ -447,17 +536,15 @@ static inline void _m6502_sbc(m6502_t* cpu, uint8_t val) {
         cpu->A = (ah<<4) | (al & 0x0F);
     }
     else {
-        /* default mode */
-        uint16_t diff = cpu->A - val - (cpu->P & M6502_CF ? 0 : 1);
-        cpu->P &= ~(M6502_VF|M6502_CF);
-        cpu->P = _M6502_NZ(cpu->P, (uint8_t)diff);
-        if ((cpu->A^val) & (cpu->A^diff) & 0x80) {
-            cpu->P |= M6502_VF;
-        }
-        if (!(diff & 0xFF00)) {
-            cpu->P |= M6502_CF;
-        }
-        cpu->A = diff & 0xFF;
+        _m6502_sbc_bin(cpu, val);
+    }
+}
+
+/* SBC with CMOS decimal mode (N and Z flags are valid) */
+static inline void _m65c02_sbc(m6502_t* cpu, uint8_t val) {
+    _m6502_sbc(cpu, val);
+    if (cpu->P & M6502_DF) {
+        cpu->P = _M6502_NZ(cpu->P, cpu->A);
     }
 }
 
@@ -513,12 +600,29 @@ static inline void _m6502_bit(m6502_t* cpu, uint8_t v) {
     cpu->P |= v & (M6502_NF|M6502_VF);
 }
 
+/* undocumented ARR instruction without decimal mode */
+static inline void _m6502_arr_bin(m6502_t* cpu) {
+    bool c = cpu->P & M6502_CF;
+    cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
+    cpu->A >>= 1;
+    if (c) {
+        cpu->A |= 0x80;
+    }
+    cpu->P = _M6502_NZ(cpu->P,cpu->A);
+    if (cpu->A & 0x40) {
+        cpu->P |= M6502_VF|M6502_CF;
+    }
+    if (cpu->A & 0x20) {
+        cpu->P ^= M6502_VF;
+    }
+}
+
 static inline void _m6502_arr(m6502_t* cpu) {
     /* undocumented, unreliable ARR instruction, but this is tested
        by the Wolfgang Lorenz C64 test suite
        implementation taken from MAME
     */
-    if (cpu->bcd_enabled && (cpu->P & M6502_DF)) {
+    if (cpu->P & M6502_DF) {
         bool c = cpu->P & M6502_CF;
         cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
         uint8_t a = cpu->A>>1;
@@ -539,19 +643,7 @@ static inline void _m6502_arr(m6502_t* cpu) {
         cpu->A = a;
     }
     else {
-        bool c = cpu->P & M6502_CF;
-        cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
-        cpu->A >>= 1;
-        if (c) {
-            cpu->A |= 0x80;
-        }
-        cpu->P = _M6502_NZ(cpu->P,cpu->A);
-        if (cpu->A & 0x40) {
-            cpu->P |= M6502_VF|M6502_CF;
-        }
-        if (cpu->A & 0x20) {
-            cpu->P ^= M6502_VF;
-        }
+        _m6502_arr_bin(cpu);
     }
 }
 
@@ -574,7 +666,6 @@ uint64_t m6502_init(m6502_t* c, const m6502_desc_t* desc) {
     CHIPS_ASSERT(c && desc);
     memset(c, 0, sizeof(*c));
     c->P = M6502_ZF;
-    c->bcd_enabled = !desc->bcd_disabled;
     c->PINS = M6502_RW | M6502_SYNC | M6502_RES;
     c->in_cb = desc->m6510_in_cb;
     c->out_cb = desc->m6510_out_cb;
@@ -648,7 +739,12 @@ uint64_t m6510_iorq(m6502_t* c, uint64_t pins) {
 #pragma warning(disable:4244)   /* conversion from 'uint16_t' to 'uint8_t', possible loss of data */
 #endif
 
-uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
+/* common tick prologue, handles interrupt detection, the RDY pin and
+   the start of a new instruction, returns true if the CPU is stalled
+   by the RDY pin
+*/
+static inline bool _m6502_tick_begin(m6502_t* c, uint64_t* pins_ptr) {
+    uint64_t pins = *pins_ptr;
     if (pins & (M6502_SYNC|M6502_IRQ|M6502_NMI|M6502_RDY|M6502_RES)) {
         // interrupt detection also works in RDY phases, but only NMI is "sticky"
         
@@ -663,10 +759,10 @@ uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
         
         // RDY pin is only checked during read cycles
         if ((pins & (M6502_RW|M6502_RDY)) == (M6502_RW|M6502_RDY)) {
-            M6510_SET_PORT(pins, c->io_pins);
             c->PINS = pins;
             c->irq_pip <<= 1;
-            return pins;
+            *pins_ptr = pins;
+            return true;
         }
         if (pins & M6502_SYNC) {
             // load new instruction into 'instruction register' and restart tick counter
@@ -708,2321 +804,7769 @@ uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
             }
         }
     }
+    *pins_ptr = pins;
+    return false;
+}
+
+/* common tick epilogue */
+#define _M6502_TICK_END() c->PINS=pins;c->irq_pip<<=1;c->nmi_pip<<=1;
+
+/* instruction step dispatch, either switch-case, or computed goto with
+   the tick epilogue replicated into each instruction step
+*/
+#if defined(CHIPS_M6502_COMPUTED_GOTO) && (defined(__GNUC__) || defined(__clang__))
+#define _M6502_COMPUTED_GOTO (1)
+#define _OP(op,t) _m6502_op_##op##_##t
+#define _NEXT() _M6502_TICK_END();return pins;
+#define _DISPATCH(table) goto *table[c->IR++]; {
+#else
+#define _OP(op,t) case (op<<3)|t
+#define _NEXT() break;
+#define _DISPATCH(table) switch (c->IR++) {
+#endif
+
+/* NMOS 6502 instruction decoder */
+uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
+    if (_m6502_tick_begin(c, &pins)) {
+        return pins;
+    }
     // reads are default, writes are special
     _RD();
-    switch (c->IR++) {
+    #if defined(_M6502_COMPUTED_GOTO)
+    static const void* _m6502_op_table[2048] = {
+        &&_m6502_op_0x00_0,&&_m6502_op_0x00_1,&&_m6502_op_0x00_2,&&_m6502_op_0x00_3,&&_m6502_op_0x00_4,&&_m6502_op_0x00_5,&&_m6502_op_0x00_6,&&_m6502_op_0x00_7,
+        &&_m6502_op_0x01_0,&&_m6502_op_0x01_1,&&_m6502_op_0x01_2,&&_m6502_op_0x01_3,&&_m6502_op_0x01_4,&&_m6502_op_0x01_5,&&_m6502_op_0x01_6,&&_m6502_op_0x01_7,
+        &&_m6502_op_0x02_0,&&_m6502_op_0x02_1,&&_m6502_op_0x02_2,&&_m6502_op_0x02_3,&&_m6502_op_0x02_4,&&_m6502_op_0x02_5,&&_m6502_op_0x02_6,&&_m6502_op_0x02_7,
+        &&_m6502_op_0x03_0,&&_m6502_op_0x03_1,&&_m6502_op_0x03_2,&&_m6502_op_0x03_3,&&_m6502_op_0x03_4,&&_m6502_op_0x03_5,&&_m6502_op_0x03_6,&&_m6502_op_0x03_7,
+        &&_m6502_op_0x04_0,&&_m6502_op_0x04_1,&&_m6502_op_0x04_2,&&_m6502_op_0x04_3,&&_m6502_op_0x04_4,&&_m6502_op_0x04_5,&&_m6502_op_0x04_6,&&_m6502_op_0x04_7,
+        &&_m6502_op_0x05_0,&&_m6502_op_0x05_1,&&_m6502_op_0x05_2,&&_m6502_op_0x05_3,&&_m6502_op_0x05_4,&&_m6502_op_0x05_5,&&_m6502_op_0x05_6,&&_m6502_op_0x05_7,
+        &&_m6502_op_0x06_0,&&_m6502_op_0x06_1,&&_m6502_op_0x06_2,&&_m6502_op_0x06_3,&&_m6502_op_0x06_4,&&_m6502_op_0x06_5,&&_m6502_op_0x06_6,&&_m6502_op_0x06_7,
+        &&_m6502_op_0x07_0,&&_m6502_op_0x07_1,&&_m6502_op_0x07_2,&&_m6502_op_0x07_3,&&_m6502_op_0x07_4,&&_m6502_op_0x07_5,&&_m6502_op_0x07_6,&&_m6502_op_0x07_7,
+        &&_m6502_op_0x08_0,&&_m6502_op_0x08_1,&&_m6502_op_0x08_2,&&_m6502_op_0x08_3,&&_m6502_op_0x08_4,&&_m6502_op_0x08_5,&&_m6502_op_0x08_6,&&_m6502_op_0x08_7,
+        &&_m6502_op_0x09_0,&&_m6502_op_0x09_1,&&_m6502_op_0x09_2,&&_m6502_op_0x09_3,&&_m6502_op_0x09_4,&&_m6502_op_0x09_5,&&_m6502_op_0x09_6,&&_m6502_op_0x09_7,
+        &&_m6502_op_0x0A_0,&&_m6502_op_0x0A_1,&&_m6502_op_0x0A_2,&&_m6502_op_0x0A_3,&&_m6502_op_0x0A_4,&&_m6502_op_0x0A_5,&&_m6502_op_0x0A_6,&&_m6502_op_0x0A_7,
+        &&_m6502_op_0x0B_0,&&_m6502_op_0x0B_1,&&_m6502_op_0x0B_2,&&_m6502_op_0x0B_3,&&_m6502_op_0x0B_4,&&_m6502_op_0x0B_5,&&_m6502_op_0x0B_6,&&_m6502_op_0x0B_7,
+        &&_m6502_op_0x0C_0,&&_m6502_op_0x0C_1,&&_m6502_op_0x0C_2,&&_m6502_op_0x0C_3,&&_m6502_op_0x0C_4,&&_m6502_op_0x0C_5,&&_m6502_op_0x0C_6,&&_m6502_op_0x0C_7,
+        &&_m6502_op_0x0D_0,&&_m6502_op_0x0D_1,&&_m6502_op_0x0D_2,&&_m6502_op_0x0D_3,&&_m6502_op_0x0D_4,&&_m6502_op_0x0D_5,&&_m6502_op_0x0D_6,&&_m6502_op_0x0D_7,
+        &&_m6502_op_0x0E_0,&&_m6502_op_0x0E_1,&&_m6502_op_0x0E_2,&&_m6502_op_0x0E_3,&&_m6502_op_0x0E_4,&&_m6502_op_0x0E_5,&&_m6502_op_0x0E_6,&&_m6502_op_0x0E_7,
+        &&_m6502_op_0x0F_0,&&_m6502_op_0x0F_1,&&_m6502_op_0x0F_2,&&_m6502_op_0x0F_3,&&_m6502_op_0x0F_4,&&_m6502_op_0x0F_5,&&_m6502_op_0x0F_6,&&_m6502_op_0x0F_7,
+        &&_m6502_op_0x10_0,&&_m6502_op_0x10_1,&&_m6502_op_0x10_2,&&_m6502_op_0x10_3,&&_m6502_op_0x10_4,&&_m6502_op_0x10_5,&&_m6502_op_0x10_6,&&_m6502_op_0x10_7,
+        &&_m6502_op_0x11_0,&&_m6502_op_0x11_1,&&_m6502_op_0x11_2,&&_m6502_op_0x11_3,&&_m6502_op_0x11_4,&&_m6502_op_0x11_5,&&_m6502_op_0x11_6,&&_m6502_op_0x11_7,
+        &&_m6502_op_0x12_0,&&_m6502_op_0x12_1,&&_m6502_op_0x12_2,&&_m6502_op_0x12_3,&&_m6502_op_0x12_4,&&_m6502_op_0x12_5,&&_m6502_op_0x12_6,&&_m6502_op_0x12_7,
+        &&_m6502_op_0x13_0,&&_m6502_op_0x13_1,&&_m6502_op_0x13_2,&&_m6502_op_0x13_3,&&_m6502_op_0x13_4,&&_m6502_op_0x13_5,&&_m6502_op_0x13_6,&&_m6502_op_0x13_7,
+        &&_m6502_op_0x14_0,&&_m6502_op_0x14_1,&&_m6502_op_0x14_2,&&_m6502_op_0x14_3,&&_m6502_op_0x14_4,&&_m6502_op_0x14_5,&&_m6502_op_0x14_6,&&_m6502_op_0x14_7,
+        &&_m6502_op_0x15_0,&&_m6502_op_0x15_1,&&_m6502_op_0x15_2,&&_m6502_op_0x15_3,&&_m6502_op_0x15_4,&&_m6502_op_0x15_5,&&_m6502_op_0x15_6,&&_m6502_op_0x15_7,
+        &&_m6502_op_0x16_0,&&_m6502_op_0x16_1,&&_m6502_op_0x16_2,&&_m6502_op_0x16_3,&&_m6502_op_0x16_4,&&_m6502_op_0x16_5,&&_m6502_op_0x16_6,&&_m6502_op_0x16_7,
+        &&_m6502_op_0x17_0,&&_m6502_op_0x17_1,&&_m6502_op_0x17_2,&&_m6502_op_0x17_3,&&_m6502_op_0x17_4,&&_m6502_op_0x17_5,&&_m6502_op_0x17_6,&&_m6502_op_0x17_7,
+        &&_m6502_op_0x18_0,&&_m6502_op_0x18_1,&&_m6502_op_0x18_2,&&_m6502_op_0x18_3,&&_m6502_op_0x18_4,&&_m6502_op_0x18_5,&&_m6502_op_0x18_6,&&_m6502_op_0x18_7,
+        &&_m6502_op_0x19_0,&&_m6502_op_0x19_1,&&_m6502_op_0x19_2,&&_m6502_op_0x19_3,&&_m6502_op_0x19_4,&&_m6502_op_0x19_5,&&_m6502_op_0x19_6,&&_m6502_op_0x19_7,
+        &&_m6502_op_0x1A_0,&&_m6502_op_0x1A_1,&&_m6502_op_0x1A_2,&&_m6502_op_0x1A_3,&&_m6502_op_0x1A_4,&&_m6502_op_0x1A_5,&&_m6502_op_0x1A_6,&&_m6502_op_0x1A_7,
+        &&_m6502_op_0x1B_0,&&_m6502_op_0x1B_1,&&_m6502_op_0x1B_2,&&_m6502_op_0x1B_3,&&_m6502_op_0x1B_4,&&_m6502_op_0x1B_5,&&_m6502_op_0x1B_6,&&_m6502_op_0x1B_7,
+        &&_m6502_op_0x1C_0,&&_m6502_op_0x1C_1,&&_m6502_op_0x1C_2,&&_m6502_op_0x1C_3,&&_m6502_op_0x1C_4,&&_m6502_op_0x1C_5,&&_m6502_op_0x1C_6,&&_m6502_op_0x1C_7,
+        &&_m6502_op_0x1D_0,&&_m6502_op_0x1D_1,&&_m6502_op_0x1D_2,&&_m6502_op_0x1D_3,&&_m6502_op_0x1D_4,&&_m6502_op_0x1D_5,&&_m6502_op_0x1D_6,&&_m6502_op_0x1D_7,
+        &&_m6502_op_0x1E_0,&&_m6502_op_0x1E_1,&&_m6502_op_0x1E_2,&&_m6502_op_0x1E_3,&&_m6502_op_0x1E_4,&&_m6502_op_0x1E_5,&&_m6502_op_0x1E_6,&&_m6502_op_0x1E_7,
+        &&_m6502_op_0x1F_0,&&_m6502_op_0x1F_1,&&_m6502_op_0x1F_2,&&_m6502_op_0x1F_3,&&_m6502_op_0x1F_4,&&_m6502_op_0x1F_5,&&_m6502_op_0x1F_6,&&_m6502_op_0x1F_7,
+        &&_m6502_op_0x20_0,&&_m6502_op_0x20_1,&&_m6502_op_0x20_2,&&_m6502_op_0x20_3,&&_m6502_op_0x20_4,&&_m6502_op_0x20_5,&&_m6502_op_0x20_6,&&_m6502_op_0x20_7,
+        &&_m6502_op_0x21_0,&&_m6502_op_0x21_1,&&_m6502_op_0x21_2,&&_m6502_op_0x21_3,&&_m6502_op_0x21_4,&&_m6502_op_0x21_5,&&_m6502_op_0x21_6,&&_m6502_op_0x21_7,
+        &&_m6502_op_0x22_0,&&_m6502_op_0x22_1,&&_m6502_op_0x22_2,&&_m6502_op_0x22_3,&&_m6502_op_0x22_4,&&_m6502_op_0x22_5,&&_m6502_op_0x22_6,&&_m6502_op_0x22_7,
+        &&_m6502_op_0x23_0,&&_m6502_op_0x23_1,&&_m6502_op_0x23_2,&&_m6502_op_0x23_3,&&_m6502_op_0x23_4,&&_m6502_op_0x23_5,&&_m6502_op_0x23_6,&&_m6502_op_0x23_7,
+        &&_m6502_op_0x24_0,&&_m6502_op_0x24_1,&&_m6502_op_0x24_2,&&_m6502_op_0x24_3,&&_m6502_op_0x24_4,&&_m6502_op_0x24_5,&&_m6502_op_0x24_6,&&_m6502_op_0x24_7,
+        &&_m6502_op_0x25_0,&&_m6502_op_0x25_1,&&_m6502_op_0x25_2,&&_m6502_op_0x25_3,&&_m6502_op_0x25_4,&&_m6502_op_0x25_5,&&_m6502_op_0x25_6,&&_m6502_op_0x25_7,
+        &&_m6502_op_0x26_0,&&_m6502_op_0x26_1,&&_m6502_op_0x26_2,&&_m6502_op_0x26_3,&&_m6502_op_0x26_4,&&_m6502_op_0x26_5,&&_m6502_op_0x26_6,&&_m6502_op_0x26_7,
+        &&_m6502_op_0x27_0,&&_m6502_op_0x27_1,&&_m6502_op_0x27_2,&&_m6502_op_0x27_3,&&_m6502_op_0x27_4,&&_m6502_op_0x27_5,&&_m6502_op_0x27_6,&&_m6502_op_0x27_7,
+        &&_m6502_op_0x28_0,&&_m6502_op_0x28_1,&&_m6502_op_0x28_2,&&_m6502_op_0x28_3,&&_m6502_op_0x28_4,&&_m6502_op_0x28_5,&&_m6502_op_0x28_6,&&_m6502_op_0x28_7,
+        &&_m6502_op_0x29_0,&&_m6502_op_0x29_1,&&_m6502_op_0x29_2,&&_m6502_op_0x29_3,&&_m6502_op_0x29_4,&&_m6502_op_0x29_5,&&_m6502_op_0x29_6,&&_m6502_op_0x29_7,
+        &&_m6502_op_0x2A_0,&&_m6502_op_0x2A_1,&&_m6502_op_0x2A_2,&&_m6502_op_0x2A_3,&&_m6502_op_0x2A_4,&&_m6502_op_0x2A_5,&&_m6502_op_0x2A_6,&&_m6502_op_0x2A_7,
+        &&_m6502_op_0x2B_0,&&_m6502_op_0x2B_1,&&_m6502_op_0x2B_2,&&_m6502_op_0x2B_3,&&_m6502_op_0x2B_4,&&_m6502_op_0x2B_5,&&_m6502_op_0x2B_6,&&_m6502_op_0x2B_7,
+        &&_m6502_op_0x2C_0,&&_m6502_op_0x2C_1,&&_m6502_op_0x2C_2,&&_m6502_op_0x2C_3,&&_m6502_op_0x2C_4,&&_m6502_op_0x2C_5,&&_m6502_op_0x2C_6,&&_m6502_op_0x2C_7,
+        &&_m6502_op_0x2D_0,&&_m6502_op_0x2D_1,&&_m6502_op_0x2D_2,&&_m6502_op_0x2D_3,&&_m6502_op_0x2D_4,&&_m6502_op_0x2D_5,&&_m6502_op_0x2D_6,&&_m6502_op_0x2D_7,
+        &&_m6502_op_0x2E_0,&&_m6502_op_0x2E_1,&&_m6502_op_0x2E_2,&&_m6502_op_0x2E_3,&&_m6502_op_0x2E_4,&&_m6502_op_0x2E_5,&&_m6502_op_0x2E_6,&&_m6502_op_0x2E_7,
+        &&_m6502_op_0x2F_0,&&_m6502_op_0x2F_1,&&_m6502_op_0x2F_2,&&_m6502_op_0x2F_3,&&_m6502_op_0x2F_4,&&_m6502_op_0x2F_5,&&_m6502_op_0x2F_6,&&_m6502_op_0x2F_7,
+        &&_m6502_op_0x30_0,&&_m6502_op_0x30_1,&&_m6502_op_0x30_2,&&_m6502_op_0x30_3,&&_m6502_op_0x30_4,&&_m6502_op_0x30_5,&&_m6502_op_0x30_6,&&_m6502_op_0x30_7,
+        &&_m6502_op_0x31_0,&&_m6502_op_0x31_1,&&_m6502_op_0x31_2,&&_m6502_op_0x31_3,&&_m6502_op_0x31_4,&&_m6502_op_0x31_5,&&_m6502_op_0x31_6,&&_m6502_op_0x31_7,
+        &&_m6502_op_0x32_0,&&_m6502_op_0x32_1,&&_m6502_op_0x32_2,&&_m6502_op_0x32_3,&&_m6502_op_0x32_4,&&_m6502_op_0x32_5,&&_m6502_op_0x32_6,&&_m6502_op_0x32_7,
+        &&_m6502_op_0x33_0,&&_m6502_op_0x33_1,&&_m6502_op_0x33_2,&&_m6502_op_0x33_3,&&_m6502_op_0x33_4,&&_m6502_op_0x33_5,&&_m6502_op_0x33_6,&&_m6502_op_0x33_7,
+        &&_m6502_op_0x34_0,&&_m6502_op_0x34_1,&&_m6502_op_0x34_2,&&_m6502_op_0x34_3,&&_m6502_op_0x34_4,&&_m6502_op_0x34_5,&&_m6502_op_0x34_6,&&_m6502_op_0x34_7,
+        &&_m6502_op_0x35_0,&&_m6502_op_0x35_1,&&_m6502_op_0x35_2,&&_m6502_op_0x35_3,&&_m6502_op_0x35_4,&&_m6502_op_0x35_5,&&_m6502_op_0x35_6,&&_m6502_op_0x35_7,
+        &&_m6502_op_0x36_0,&&_m6502_op_0x36_1,&&_m6502_op_0x36_2,&&_m6502_op_0x36_3,&&_m6502_op_0x36_4,&&_m6502_op_0x36_5,&&_m6502_op_0x36_6,&&_m6502_op_0x36_7,
+        &&_m6502_op_0x37_0,&&_m6502_op_0x37_1,&&_m6502_op_0x37_2,&&_m6502_op_0x37_3,&&_m6502_op_0x37_4,&&_m6502_op_0x37_5,&&_m6502_op_0x37_6,&&_m6502_op_0x37_7,
+        &&_m6502_op_0x38_0,&&_m6502_op_0x38_1,&&_m6502_op_0x38_2,&&_m6502_op_0x38_3,&&_m6502_op_0x38_4,&&_m6502_op_0x38_5,&&_m6502_op_0x38_6,&&_m6502_op_0x38_7,
+        &&_m6502_op_0x39_0,&&_m6502_op_0x39_1,&&_m6502_op_0x39_2,&&_m6502_op_0x39_3,&&_m6502_op_0x39_4,&&_m6502_op_0x39_5,&&_m6502_op_0x39_6,&&_m6502_op_0x39_7,
+        &&_m6502_op_0x3A_0,&&_m6502_op_0x3A_1,&&_m6502_op_0x3A_2,&&_m6502_op_0x3A_3,&&_m6502_op_0x3A_4,&&_m6502_op_0x3A_5,&&_m6502_op_0x3A_6,&&_m6502_op_0x3A_7,
+        &&_m6502_op_0x3B_0,&&_m6502_op_0x3B_1,&&_m6502_op_0x3B_2,&&_m6502_op_0x3B_3,&&_m6502_op_0x3B_4,&&_m6502_op_0x3B_5,&&_m6502_op_0x3B_6,&&_m6502_op_0x3B_7,
+        &&_m6502_op_0x3C_0,&&_m6502_op_0x3C_1,&&_m6502_op_0x3C_2,&&_m6502_op_0x3C_3,&&_m6502_op_0x3C_4,&&_m6502_op_0x3C_5,&&_m6502_op_0x3C_6,&&_m6502_op_0x3C_7,
+        &&_m6502_op_0x3D_0,&&_m6502_op_0x3D_1,&&_m6502_op_0x3D_2,&&_m6502_op_0x3D_3,&&_m6502_op_0x3D_4,&&_m6502_op_0x3D_5,&&_m6502_op_0x3D_6,&&_m6502_op_0x3D_7,
+        &&_m6502_op_0x3E_0,&&_m6502_op_0x3E_1,&&_m6502_op_0x3E_2,&&_m6502_op_0x3E_3,&&_m6502_op_0x3E_4,&&_m6502_op_0x3E_5,&&_m6502_op_0x3E_6,&&_m6502_op_0x3E_7,
+        &&_m6502_op_0x3F_0,&&_m6502_op_0x3F_1,&&_m6502_op_0x3F_2,&&_m6502_op_0x3F_3,&&_m6502_op_0x3F_4,&&_m6502_op_0x3F_5,&&_m6502_op_0x3F_6,&&_m6502_op_0x3F_7,
+        &&_m6502_op_0x40_0,&&_m6502_op_0x40_1,&&_m6502_op_0x40_2,&&_m6502_op_0x40_3,&&_m6502_op_0x40_4,&&_m6502_op_0x40_5,&&_m6502_op_0x40_6,&&_m6502_op_0x40_7,
+        &&_m6502_op_0x41_0,&&_m6502_op_0x41_1,&&_m6502_op_0x41_2,&&_m6502_op_0x41_3,&&_m6502_op_0x41_4,&&_m6502_op_0x41_5,&&_m6502_op_0x41_6,&&_m6502_op_0x41_7,
+        &&_m6502_op_0x42_0,&&_m6502_op_0x42_1,&&_m6502_op_0x42_2,&&_m6502_op_0x42_3,&&_m6502_op_0x42_4,&&_m6502_op_0x42_5,&&_m6502_op_0x42_6,&&_m6502_op_0x42_7,
+        &&_m6502_op_0x43_0,&&_m6502_op_0x43_1,&&_m6502_op_0x43_2,&&_m6502_op_0x43_3,&&_m6502_op_0x43_4,&&_m6502_op_0x43_5,&&_m6502_op_0x43_6,&&_m6502_op_0x43_7,
+        &&_m6502_op_0x44_0,&&_m6502_op_0x44_1,&&_m6502_op_0x44_2,&&_m6502_op_0x44_3,&&_m6502_op_0x44_4,&&_m6502_op_0x44_5,&&_m6502_op_0x44_6,&&_m6502_op_0x44_7,
+        &&_m6502_op_0x45_0,&&_m6502_op_0x45_1,&&_m6502_op_0x45_2,&&_m6502_op_0x45_3,&&_m6502_op_0x45_4,&&_m6502_op_0x45_5,&&_m6502_op_0x45_6,&&_m6502_op_0x45_7,
+        &&_m6502_op_0x46_0,&&_m6502_op_0x46_1,&&_m6502_op_0x46_2,&&_m6502_op_0x46_3,&&_m6502_op_0x46_4,&&_m6502_op_0x46_5,&&_m6502_op_0x46_6,&&_m6502_op_0x46_7,
+        &&_m6502_op_0x47_0,&&_m6502_op_0x47_1,&&_m6502_op_0x47_2,&&_m6502_op_0x47_3,&&_m6502_op_0x47_4,&&_m6502_op_0x47_5,&&_m6502_op_0x47_6,&&_m6502_op_0x47_7,
+        &&_m6502_op_0x48_0,&&_m6502_op_0x48_1,&&_m6502_op_0x48_2,&&_m6502_op_0x48_3,&&_m6502_op_0x48_4,&&_m6502_op_0x48_5,&&_m6502_op_0x48_6,&&_m6502_op_0x48_7,
+        &&_m6502_op_0x49_0,&&_m6502_op_0x49_1,&&_m6502_op_0x49_2,&&_m6502_op_0x49_3,&&_m6502_op_0x49_4,&&_m6502_op_0x49_5,&&_m6502_op_0x49_6,&&_m6502_op_0x49_7,
+        &&_m6502_op_0x4A_0,&&_m6502_op_0x4A_1,&&_m6502_op_0x4A_2,&&_m6502_op_0x4A_3,&&_m6502_op_0x4A_4,&&_m6502_op_0x4A_5,&&_m6502_op_0x4A_6,&&_m6502_op_0x4A_7,
+        &&_m6502_op_0x4B_0,&&_m6502_op_0x4B_1,&&_m6502_op_0x4B_2,&&_m6502_op_0x4B_3,&&_m6502_op_0x4B_4,&&_m6502_op_0x4B_5,&&_m6502_op_0x4B_6,&&_m6502_op_0x4B_7,
+        &&_m6502_op_0x4C_0,&&_m6502_op_0x4C_1,&&_m6502_op_0x4C_2,&&_m6502_op_0x4C_3,&&_m6502_op_0x4C_4,&&_m6502_op_0x4C_5,&&_m6502_op_0x4C_6,&&_m6502_op_0x4C_7,
+        &&_m6502_op_0x4D_0,&&_m6502_op_0x4D_1,&&_m6502_op_0x4D_2,&&_m6502_op_0x4D_3,&&_m6502_op_0x4D_4,&&_m6502_op_0x4D_5,&&_m6502_op_0x4D_6,&&_m6502_op_0x4D_7,
+        &&_m6502_op_0x4E_0,&&_m6502_op_0x4E_1,&&_m6502_op_0x4E_2,&&_m6502_op_0x4E_3,&&_m6502_op_0x4E_4,&&_m6502_op_0x4E_5,&&_m6502_op_0x4E_6,&&_m6502_op_0x4E_7,
+        &&_m6502_op_0x4F_0,&&_m6502_op_0x4F_1,&&_m6502_op_0x4F_2,&&_m6502_op_0x4F_3,&&_m6502_op_0x4F_4,&&_m6502_op_0x4F_5,&&_m6502_op_0x4F_6,&&_m6502_op_0x4F_7,
+        &&_m6502_op_0x50_0,&&_m6502_op_0x50_1,&&_m6502_op_0x50_2,&&_m6502_op_0x50_3,&&_m6502_op_0x50_4,&&_m6502_op_0x50_5,&&_m6502_op_0x50_6,&&_m6502_op_0x50_7,
+        &&_m6502_op_0x51_0,&&_m6502_op_0x51_1,&&_m6502_op_0x51_2,&&_m6502_op_0x51_3,&&_m6502_op_0x51_4,&&_m6502_op_0x51_5,&&_m6502_op_0x51_6,&&_m6502_op_0x51_7,
+        &&_m6502_op_0x52_0,&&_m6502_op_0x52_1,&&_m6502_op_0x52_2,&&_m6502_op_0x52_3,&&_m6502_op_0x52_4,&&_m6502_op_0x52_5,&&_m6502_op_0x52_6,&&_m6502_op_0x52_7,
+        &&_m6502_op_0x53_0,&&_m6502_op_0x53_1,&&_m6502_op_0x53_2,&&_m6502_op_0x53_3,&&_m6502_op_0x53_4,&&_m6502_op_0x53_5,&&_m6502_op_0x53_6,&&_m6502_op_0x53_7,
+        &&_m6502_op_0x54_0,&&_m6502_op_0x54_1,&&_m6502_op_0x54_2,&&_m6502_op_0x54_3,&&_m6502_op_0x54_4,&&_m6502_op_0x54_5,&&_m6502_op_0x54_6,&&_m6502_op_0x54_7,
+        &&_m6502_op_0x55_0,&&_m6502_op_0x55_1,&&_m6502_op_0x55_2,&&_m6502_op_0x55_3,&&_m6502_op_0x55_4,&&_m6502_op_0x55_5,&&_m6502_op_0x55_6,&&_m6502_op_0x55_7,
+        &&_m6502_op_0x56_0,&&_m6502_op_0x56_1,&&_m6502_op_0x56_2,&&_m6502_op_0x56_3,&&_m6502_op_0x56_4,&&_m6502_op_0x56_5,&&_m6502_op_0x56_6,&&_m6502_op_0x56_7,
+        &&_m6502_op_0x57_0,&&_m6502_op_0x57_1,&&_m6502_op_0x57_2,&&_m6502_op_0x57_3,&&_m6502_op_0x57_4,&&_m6502_op_0x57_5,&&_m6502_op_0x57_6,&&_m6502_op_0x57_7,
+        &&_m6502_op_0x58_0,&&_m6502_op_0x58_1,&&_m6502_op_0x58_2,&&_m6502_op_0x58_3,&&_m6502_op_0x58_4,&&_m6502_op_0x58_5,&&_m6502_op_0x58_6,&&_m6502_op_0x58_7,
+        &&_m6502_op_0x59_0,&&_m6502_op_0x59_1,&&_m6502_op_0x59_2,&&_m6502_op_0x59_3,&&_m6502_op_0x59_4,&&_m6502_op_0x59_5,&&_m6502_op_0x59_6,&&_m6502_op_0x59_7,
+        &&_m6502_op_0x5A_0,&&_m6502_op_0x5A_1,&&_m6502_op_0x5A_2,&&_m6502_op_0x5A_3,&&_m6502_op_0x5A_4,&&_m6502_op_0x5A_5,&&_m6502_op_0x5A_6,&&_m6502_op_0x5A_7,
+        &&_m6502_op_0x5B_0,&&_m6502_op_0x5B_1,&&_m6502_op_0x5B_2,&&_m6502_op_0x5B_3,&&_m6502_op_0x5B_4,&&_m6502_op_0x5B_5,&&_m6502_op_0x5B_6,&&_m6502_op_0x5B_7,
+        &&_m6502_op_0x5C_0,&&_m6502_op_0x5C_1,&&_m6502_op_0x5C_2,&&_m6502_op_0x5C_3,&&_m6502_op_0x5C_4,&&_m6502_op_0x5C_5,&&_m6502_op_0x5C_6,&&_m6502_op_0x5C_7,
+        &&_m6502_op_0x5D_0,&&_m6502_op_0x5D_1,&&_m6502_op_0x5D_2,&&_m6502_op_0x5D_3,&&_m6502_op_0x5D_4,&&_m6502_op_0x5D_5,&&_m6502_op_0x5D_6,&&_m6502_op_0x5D_7,
+        &&_m6502_op_0x5E_0,&&_m6502_op_0x5E_1,&&_m6502_op_0x5E_2,&&_m6502_op_0x5E_3,&&_m6502_op_0x5E_4,&&_m6502_op_0x5E_5,&&_m6502_op_0x5E_6,&&_m6502_op_0x5E_7,
+        &&_m6502_op_0x5F_0,&&_m6502_op_0x5F_1,&&_m6502_op_0x5F_2,&&_m6502_op_0x5F_3,&&_m6502_op_0x5F_4,&&_m6502_op_0x5F_5,&&_m6502_op_0x5F_6,&&_m6502_op_0x5F_7,
+        &&_m6502_op_0x60_0,&&_m6502_op_0x60_1,&&_m6502_op_0x60_2,&&_m6502_op_0x60_3,&&_m6502_op_0x60_4,&&_m6502_op_0x60_5,&&_m6502_op_0x60_6,&&_m6502_op_0x60_7,
+        &&_m6502_op_0x61_0,&&_m6502_op_0x61_1,&&_m6502_op_0x61_2,&&_m6502_op_0x61_3,&&_m6502_op_0x61_4,&&_m6502_op_0x61_5,&&_m6502_op_0x61_6,&&_m6502_op_0x61_7,
+        &&_m6502_op_0x62_0,&&_m6502_op_0x62_1,&&_m6502_op_0x62_2,&&_m6502_op_0x62_3,&&_m6502_op_0x62_4,&&_m6502_op_0x62_5,&&_m6502_op_0x62_6,&&_m6502_op_0x62_7,
+        &&_m6502_op_0x63_0,&&_m6502_op_0x63_1,&&_m6502_op_0x63_2,&&_m6502_op_0x63_3,&&_m6502_op_0x63_4,&&_m6502_op_0x63_5,&&_m6502_op_0x63_6,&&_m6502_op_0x63_7,
+        &&_m6502_op_0x64_0,&&_m6502_op_0x64_1,&&_m6502_op_0x64_2,&&_m6502_op_0x64_3,&&_m6502_op_0x64_4,&&_m6502_op_0x64_5,&&_m6502_op_0x64_6,&&_m6502_op_0x64_7,
+        &&_m6502_op_0x65_0,&&_m6502_op_0x65_1,&&_m6502_op_0x65_2,&&_m6502_op_0x65_3,&&_m6502_op_0x65_4,&&_m6502_op_0x65_5,&&_m6502_op_0x65_6,&&_m6502_op_0x65_7,
+        &&_m6502_op_0x66_0,&&_m6502_op_0x66_1,&&_m6502_op_0x66_2,&&_m6502_op_0x66_3,&&_m6502_op_0x66_4,&&_m6502_op_0x66_5,&&_m6502_op_0x66_6,&&_m6502_op_0x66_7,
+        &&_m6502_op_0x67_0,&&_m6502_op_0x67_1,&&_m6502_op_0x67_2,&&_m6502_op_0x67_3,&&_m6502_op_0x67_4,&&_m6502_op_0x67_5,&&_m6502_op_0x67_6,&&_m6502_op_0x67_7,
+        &&_m6502_op_0x68_0,&&_m6502_op_0x68_1,&&_m6502_op_0x68_2,&&_m6502_op_0x68_3,&&_m6502_op_0x68_4,&&_m6502_op_0x68_5,&&_m6502_op_0x68_6,&&_m6502_op_0x68_7,
+        &&_m6502_op_0x69_0,&&_m6502_op_0x69_1,&&_m6502_op_0x69_2,&&_m6502_op_0x69_3,&&_m6502_op_0x69_4,&&_m6502_op_0x69_5,&&_m6502_op_0x69_6,&&_m6502_op_0x69_7,
+        &&_m6502_op_0x6A_0,&&_m6502_op_0x6A_1,&&_m6502_op_0x6A_2,&&_m6502_op_0x6A_3,&&_m6502_op_0x6A_4,&&_m6502_op_0x6A_5,&&_m6502_op_0x6A_6,&&_m6502_op_0x6A_7,
+        &&_m6502_op_0x6B_0,&&_m6502_op_0x6B_1,&&_m6502_op_0x6B_2,&&_m6502_op_0x6B_3,&&_m6502_op_0x6B_4,&&_m6502_op_0x6B_5,&&_m6502_op_0x6B_6,&&_m6502_op_0x6B_7,
+        &&_m6502_op_0x6C_0,&&_m6502_op_0x6C_1,&&_m6502_op_0x6C_2,&&_m6502_op_0x6C_3,&&_m6502_op_0x6C_4,&&_m6502_op_0x6C_5,&&_m6502_op_0x6C_6,&&_m6502_op_0x6C_7,
+        &&_m6502_op_0x6D_0,&&_m6502_op_0x6D_1,&&_m6502_op_0x6D_2,&&_m6502_op_0x6D_3,&&_m6502_op_0x6D_4,&&_m6502_op_0x6D_5,&&_m6502_op_0x6D_6,&&_m6502_op_0x6D_7,
+        &&_m6502_op_0x6E_0,&&_m6502_op_0x6E_1,&&_m6502_op_0x6E_2,&&_m6502_op_0x6E_3,&&_m6502_op_0x6E_4,&&_m6502_op_0x6E_5,&&_m6502_op_0x6E_6,&&_m6502_op_0x6E_7,
+        &&_m6502_op_0x6F_0,&&_m6502_op_0x6F_1,&&_m6502_op_0x6F_2,&&_m6502_op_0x6F_3,&&_m6502_op_0x6F_4,&&_m6502_op_0x6F_5,&&_m6502_op_0x6F_6,&&_m6502_op_0x6F_7,
+        &&_m6502_op_0x70_0,&&_m6502_op_0x70_1,&&_m6502_op_0x70_2,&&_m6502_op_0x70_3,&&_m6502_op_0x70_4,&&_m6502_op_0x70_5,&&_m6502_op_0x70_6,&&_m6502_op_0x70_7,
+        &&_m6502_op_0x71_0,&&_m6502_op_0x71_1,&&_m6502_op_0x71_2,&&_m6502_op_0x71_3,&&_m6502_op_0x71_4,&&_m6502_op_0x71_5,&&_m6502_op_0x71_6,&&_m6502_op_0x71_7,
+        &&_m6502_op_0x72_0,&&_m6502_op_0x72_1,&&_m6502_op_0x72_2,&&_m6502_op_0x72_3,&&_m6502_op_0x72_4,&&_m6502_op_0x72_5,&&_m6502_op_0x72_6,&&_m6502_op_0x72_7,
+        &&_m6502_op_0x73_0,&&_m6502_op_0x73_1,&&_m6502_op_0x73_2,&&_m6502_op_0x73_3,&&_m6502_op_0x73_4,&&_m6502_op_0x73_5,&&_m6502_op_0x73_6,&&_m6502_op_0x73_7,
+        &&_m6502_op_0x74_0,&&_m6502_op_0x74_1,&&_m6502_op_0x74_2,&&_m6502_op_0x74_3,&&_m6502_op_0x74_4,&&_m6502_op_0x74_5,&&_m6502_op_0x74_6,&&_m6502_op_0x74_7,
+        &&_m6502_op_0x75_0,&&_m6502_op_0x75_1,&&_m6502_op_0x75_2,&&_m6502_op_0x75_3,&&_m6502_op_0x75_4,&&_m6502_op_0x75_5,&&_m6502_op_0x75_6,&&_m6502_op_0x75_7,
+        &&_m6502_op_0x76_0,&&_m6502_op_0x76_1,&&_m6502_op_0x76_2,&&_m6502_op_0x76_3,&&_m6502_op_0x76_4,&&_m6502_op_0x76_5,&&_m6502_op_0x76_6,&&_m6502_op_0x76_7,
+        &&_m6502_op_0x77_0,&&_m6502_op_0x77_1,&&_m6502_op_0x77_2,&&_m6502_op_0x77_3,&&_m6502_op_0x77_4,&&_m6502_op_0x77_5,&&_m6502_op_0x77_6,&&_m6502_op_0x77_7,
+        &&_m6502_op_0x78_0,&&_m6502_op_0x78_1,&&_m6502_op_0x78_2,&&_m6502_op_0x78_3,&&_m6502_op_0x78_4,&&_m6502_op_0x78_5,&&_m6502_op_0x78_6,&&_m6502_op_0x78_7,
+        &&_m6502_op_0x79_0,&&_m6502_op_0x79_1,&&_m6502_op_0x79_2,&&_m6502_op_0x79_3,&&_m6502_op_0x79_4,&&_m6502_op_0x79_5,&&_m6502_op_0x79_6,&&_m6502_op_0x79_7,
+        &&_m6502_op_0x7A_0,&&_m6502_op_0x7A_1,&&_m6502_op_0x7A_2,&&_m6502_op_0x7A_3,&&_m6502_op_0x7A_4,&&_m6502_op_0x7A_5,&&_m6502_op_0x7A_6,&&_m6502_op_0x7A_7,
+        &&_m6502_op_0x7B_0,&&_m6502_op_0x7B_1,&&_m6502_op_0x7B_2,&&_m6502_op_0x7B_3,&&_m6502_op_0x7B_4,&&_m6502_op_0x7B_5,&&_m6502_op_0x7B_6,&&_m6502_op_0x7B_7,
+        &&_m6502_op_0x7C_0,&&_m6502_op_0x7C_1,&&_m6502_op_0x7C_2,&&_m6502_op_0x7C_3,&&_m6502_op_0x7C_4,&&_m6502_op_0x7C_5,&&_m6502_op_0x7C_6,&&_m6502_op_0x7C_7,
+        &&_m6502_op_0x7D_0,&&_m6502_op_0x7D_1,&&_m6502_op_0x7D_2,&&_m6502_op_0x7D_3,&&_m6502_op_0x7D_4,&&_m6502_op_0x7D_5,&&_m6502_op_0x7D_6,&&_m6502_op_0x7D_7,
+        &&_m6502_op_0x7E_0,&&_m6502_op_0x7E_1,&&_m6502_op_0x7E_2,&&_m6502_op_0x7E_3,&&_m6502_op_0x7E_4,&&_m6502_op_0x7E_5,&&_m6502_op_0x7E_6,&&_m6502_op_0x7E_7,
+        &&_m6502_op_0x7F_0,&&_m6502_op_0x7F_1,&&_m6502_op_0x7F_2,&&_m6502_op_0x7F_3,&&_m6502_op_0x7F_4,&&_m6502_op_0x7F_5,&&_m6502_op_0x7F_6,&&_m6502_op_0x7F_7,
+        &&_m6502_op_0x80_0,&&_m6502_op_0x80_1,&&_m6502_op_0x80_2,&&_m6502_op_0x80_3,&&_m6502_op_0x80_4,&&_m6502_op_0x80_5,&&_m6502_op_0x80_6,&&_m6502_op_0x80_7,
+        &&_m6502_op_0x81_0,&&_m6502_op_0x81_1,&&_m6502_op_0x81_2,&&_m6502_op_0x81_3,&&_m6502_op_0x81_4,&&_m6502_op_0x81_5,&&_m6502_op_0x81_6,&&_m6502_op_0x81_7,
+        &&_m6502_op_0x82_0,&&_m6502_op_0x82_1,&&_m6502_op_0x82_2,&&_m6502_op_0x82_3,&&_m6502_op_0x82_4,&&_m6502_op_0x82_5,&&_m6502_op_0x82_6,&&_m6502_op_0x82_7,
+        &&_m6502_op_0x83_0,&&_m6502_op_0x83_1,&&_m6502_op_0x83_2,&&_m6502_op_0x83_3,&&_m6502_op_0x83_4,&&_m6502_op_0x83_5,&&_m6502_op_0x83_6,&&_m6502_op_0x83_7,
+        &&_m6502_op_0x84_0,&&_m6502_op_0x84_1,&&_m6502_op_0x84_2,&&_m6502_op_0x84_3,&&_m6502_op_0x84_4,&&_m6502_op_0x84_5,&&_m6502_op_0x84_6,&&_m6502_op_0x84_7,
+        &&_m6502_op_0x85_0,&&_m6502_op_0x85_1,&&_m6502_op_0x85_2,&&_m6502_op_0x85_3,&&_m6502_op_0x85_4,&&_m6502_op_0x85_5,&&_m6502_op_0x85_6,&&_m6502_op_0x85_7,
+        &&_m6502_op_0x86_0,&&_m6502_op_0x86_1,&&_m6502_op_0x86_2,&&_m6502_op_0x86_3,&&_m6502_op_0x86_4,&&_m6502_op_0x86_5,&&_m6502_op_0x86_6,&&_m6502_op_0x86_7,
+        &&_m6502_op_0x87_0,&&_m6502_op_0x87_1,&&_m6502_op_0x87_2,&&_m6502_op_0x87_3,&&_m6502_op_0x87_4,&&_m6502_op_0x87_5,&&_m6502_op_0x87_6,&&_m6502_op_0x87_7,
+        &&_m6502_op_0x88_0,&&_m6502_op_0x88_1,&&_m6502_op_0x88_2,&&_m6502_op_0x88_3,&&_m6502_op_0x88_4,&&_m6502_op_0x88_5,&&_m6502_op_0x88_6,&&_m6502_op_0x88_7,
+        &&_m6502_op_0x89_0,&&_m6502_op_0x89_1,&&_m6502_op_0x89_2,&&_m6502_op_0x89_3,&&_m6502_op_0x89_4,&&_m6502_op_0x89_5,&&_m6502_op_0x89_6,&&_m6502_op_0x89_7,
+        &&_m6502_op_0x8A_0,&&_m6502_op_0x8A_1,&&_m6502_op_0x8A_2,&&_m6502_op_0x8A_3,&&_m6502_op_0x8A_4,&&_m6502_op_0x8A_5,&&_m6502_op_0x8A_6,&&_m6502_op_0x8A_7,
+        &&_m6502_op_0x8B_0,&&_m6502_op_0x8B_1,&&_m6502_op_0x8B_2,&&_m6502_op_0x8B_3,&&_m6502_op_0x8B_4,&&_m6502_op_0x8B_5,&&_m6502_op_0x8B_6,&&_m6502_op_0x8B_7,
+        &&_m6502_op_0x8C_0,&&_m6502_op_0x8C_1,&&_m6502_op_0x8C_2,&&_m6502_op_0x8C_3,&&_m6502_op_0x8C_4,&&_m6502_op_0x8C_5,&&_m6502_op_0x8C_6,&&_m6502_op_0x8C_7,
+        &&_m6502_op_0x8D_0,&&_m6502_op_0x8D_1,&&_m6502_op_0x8D_2,&&_m6502_op_0x8D_3,&&_m6502_op_0x8D_4,&&_m6502_op_0x8D_5,&&_m6502_op_0x8D_6,&&_m6502_op_0x8D_7,
+        &&_m6502_op_0x8E_0,&&_m6502_op_0x8E_1,&&_m6502_op_0x8E_2,&&_m6502_op_0x8E_3,&&_m6502_op_0x8E_4,&&_m6502_op_0x8E_5,&&_m6502_op_0x8E_6,&&_m6502_op_0x8E_7,
+        &&_m6502_op_0x8F_0,&&_m6502_op_0x8F_1,&&_m6502_op_0x8F_2,&&_m6502_op_0x8F_3,&&_m6502_op_0x8F_4,&&_m6502_op_0x8F_5,&&_m6502_op_0x8F_6,&&_m6502_op_0x8F_7,
+        &&_m6502_op_0x90_0,&&_m6502_op_0x90_1,&&_m6502_op_0x90_2,&&_m6502_op_0x90_3,&&_m6502_op_0x90_4,&&_m6502_op_0x90_5,&&_m6502_op_0x90_6,&&_m6502_op_0x90_7,
+        &&_m6502_op_0x91_0,&&_m6502_op_0x91_1,&&_m6502_op_0x91_2,&&_m6502_op_0x91_3,&&_m6502_op_0x91_4,&&_m6502_op_0x91_5,&&_m6502_op_0x91_6,&&_m6502_op_0x91_7,
+        &&_m6502_op_0x92_0,&&_m6502_op_0x92_1,&&_m6502_op_0x92_2,&&_m6502_op_0x92_3,&&_m6502_op_0x92_4,&&_m6502_op_0x92_5,&&_m6502_op_0x92_6,&&_m6502_op_0x92_7,
+        &&_m6502_op_0x93_0,&&_m6502_op_0x93_1,&&_m6502_op_0x93_2,&&_m6502_op_0x93_3,&&_m6502_op_0x93_4,&&_m6502_op_0x93_5,&&_m6502_op_0x93_6,&&_m6502_op_0x93_7,
+        &&_m6502_op_0x94_0,&&_m6502_op_0x94_1,&&_m6502_op_0x94_2,&&_m6502_op_0x94_3,&&_m6502_op_0x94_4,&&_m6502_op_0x94_5,&&_m6502_op_0x94_6,&&_m6502_op_0x94_7,
+        &&_m6502_op_0x95_0,&&_m6502_op_0x95_1,&&_m6502_op_0x95_2,&&_m6502_op_0x95_3,&&_m6502_op_0x95_4,&&_m6502_op_0x95_5,&&_m6502_op_0x95_6,&&_m6502_op_0x95_7,
+        &&_m6502_op_0x96_0,&&_m6502_op_0x96_1,&&_m6502_op_0x96_2,&&_m6502_op_0x96_3,&&_m6502_op_0x96_4,&&_m6502_op_0x96_5,&&_m6502_op_0x96_6,&&_m6502_op_0x96_7,
+        &&_m6502_op_0x97_0,&&_m6502_op_0x97_1,&&_m6502_op_0x97_2,&&_m6502_op_0x97_3,&&_m6502_op_0x97_4,&&_m6502_op_0x97_5,&&_m6502_op_0x97_6,&&_m6502_op_0x97_7,
+        &&_m6502_op_0x98_0,&&_m6502_op_0x98_1,&&_m6502_op_0x98_2,&&_m6502_op_0x98_3,&&_m6502_op_0x98_4,&&_m6502_op_0x98_5,&&_m6502_op_0x98_6,&&_m6502_op_0x98_7,
+        &&_m6502_op_0x99_0,&&_m6502_op_0x99_1,&&_m6502_op_0x99_2,&&_m6502_op_0x99_3,&&_m6502_op_0x99_4,&&_m6502_op_0x99_5,&&_m6502_op_0x99_6,&&_m6502_op_0x99_7,
+        &&_m6502_op_0x9A_0,&&_m6502_op_0x9A_1,&&_m6502_op_0x9A_2,&&_m6502_op_0x9A_3,&&_m6502_op_0x9A_4,&&_m6502_op_0x9A_5,&&_m6502_op_0x9A_6,&&_m6502_op_0x9A_7,
+        &&_m6502_op_0x9B_0,&&_m6502_op_0x9B_1,&&_m6502_op_0x9B_2,&&_m6502_op_0x9B_3,&&_m6502_op_0x9B_4,&&_m6502_op_0x9B_5,&&_m6502_op_0x9B_6,&&_m6502_op_0x9B_7,
+        &&_m6502_op_0x9C_0,&&_m6502_op_0x9C_1,&&_m6502_op_0x9C_2,&&_m6502_op_0x9C_3,&&_m6502_op_0x9C_4,&&_m6502_op_0x9C_5,&&_m6502_op_0x9C_6,&&_m6502_op_0x9C_7,
+        &&_m6502_op_0x9D_0,&&_m6502_op_0x9D_1,&&_m6502_op_0x9D_2,&&_m6502_op_0x9D_3,&&_m6502_op_0x9D_4,&&_m6502_op_0x9D_5,&&_m6502_op_0x9D_6,&&_m6502_op_0x9D_7,
+        &&_m6502_op_0x9E_0,&&_m6502_op_0x9E_1,&&_m6502_op_0x9E_2,&&_m6502_op_0x9E_3,&&_m6502_op_0x9E_4,&&_m6502_op_0x9E_5,&&_m6502_op_0x9E_6,&&_m6502_op_0x9E_7,
+        &&_m6502_op_0x9F_0,&&_m6502_op_0x9F_1,&&_m6502_op_0x9F_2,&&_m6502_op_0x9F_3,&&_m6502_op_0x9F_4,&&_m6502_op_0x9F_5,&&_m6502_op_0x9F_6,&&_m6502_op_0x9F_7,
+        &&_m6502_op_0xA0_0,&&_m6502_op_0xA0_1,&&_m6502_op_0xA0_2,&&_m6502_op_0xA0_3,&&_m6502_op_0xA0_4,&&_m6502_op_0xA0_5,&&_m6502_op_0xA0_6,&&_m6502_op_0xA0_7,
+        &&_m6502_op_0xA1_0,&&_m6502_op_0xA1_1,&&_m6502_op_0xA1_2,&&_m6502_op_0xA1_3,&&_m6502_op_0xA1_4,&&_m6502_op_0xA1_5,&&_m6502_op_0xA1_6,&&_m6502_op_0xA1_7,
+        &&_m6502_op_0xA2_0,&&_m6502_op_0xA2_1,&&_m6502_op_0xA2_2,&&_m6502_op_0xA2_3,&&_m6502_op_0xA2_4,&&_m6502_op_0xA2_5,&&_m6502_op_0xA2_6,&&_m6502_op_0xA2_7,
+        &&_m6502_op_0xA3_0,&&_m6502_op_0xA3_1,&&_m6502_op_0xA3_2,&&_m6502_op_0xA3_3,&&_m6502_op_0xA3_4,&&_m6502_op_0xA3_5,&&_m6502_op_0xA3_6,&&_m6502_op_0xA3_7,
+        &&_m6502_op_0xA4_0,&&_m6502_op_0xA4_1,&&_m6502_op_0xA4_2,&&_m6502_op_0xA4_3,&&_m6502_op_0xA4_4,&&_m6502_op_0xA4_5,&&_m6502_op_0xA4_6,&&_m6502_op_0xA4_7,
+        &&_m6502_op_0xA5_0,&&_m6502_op_0xA5_1,&&_m6502_op_0xA5_2,&&_m6502_op_0xA5_3,&&_m6502_op_0xA5_4,&&_m6502_op_0xA5_5,&&_m6502_op_0xA5_6,&&_m6502_op_0xA5_7,
+        &&_m6502_op_0xA6_0,&&_m6502_op_0xA6_1,&&_m6502_op_0xA6_2,&&_m6502_op_0xA6_3,&&_m6502_op_0xA6_4,&&_m6502_op_0xA6_5,&&_m6502_op_0xA6_6,&&_m6502_op_0xA6_7,
+        &&_m6502_op_0xA7_0,&&_m6502_op_0xA7_1,&&_m6502_op_0xA7_2,&&_m6502_op_0xA7_3,&&_m6502_op_0xA7_4,&&_m6502_op_0xA7_5,&&_m6502_op_0xA7_6,&&_m6502_op_0xA7_7,
+        &&_m6502_op_0xA8_0,&&_m6502_op_0xA8_1,&&_m6502_op_0xA8_2,&&_m6502_op_0xA8_3,&&_m6502_op_0xA8_4,&&_m6502_op_0xA8_5,&&_m6502_op_0xA8_6,&&_m6502_op_0xA8_7,
+        &&_m6502_op_0xA9_0,&&_m6502_op_0xA9_1,&&_m6502_op_0xA9_2,&&_m6502_op_0xA9_3,&&_m6502_op_0xA9_4,&&_m6502_op_0xA9_5,&&_m6502_op_0xA9_6,&&_m6502_op_0xA9_7,
+        &&_m6502_op_0xAA_0,&&_m6502_op_0xAA_1,&&_m6502_op_0xAA_2,&&_m6502_op_0xAA_3,&&_m6502_op_0xAA_4,&&_m6502_op_0xAA_5,&&_m6502_op_0xAA_6,&&_m6502_op_0xAA_7,
+        &&_m6502_op_0xAB_0,&&_m6502_op_0xAB_1,&&_m6502_op_0xAB_2,&&_m6502_op_0xAB_3,&&_m6502_op_0xAB_4,&&_m6502_op_0xAB_5,&&_m6502_op_0xAB_6,&&_m6502_op_0xAB_7,
+        &&_m6502_op_0xAC_0,&&_m6502_op_0xAC_1,&&_m6502_op_0xAC_2,&&_m6502_op_0xAC_3,&&_m6502_op_0xAC_4,&&_m6502_op_0xAC_5,&&_m6502_op_0xAC_6,&&_m6502_op_0xAC_7,
+        &&_m6502_op_0xAD_0,&&_m6502_op_0xAD_1,&&_m6502_op_0xAD_2,&&_m6502_op_0xAD_3,&&_m6502_op_0xAD_4,&&_m6502_op_0xAD_5,&&_m6502_op_0xAD_6,&&_m6502_op_0xAD_7,
+        &&_m6502_op_0xAE_0,&&_m6502_op_0xAE_1,&&_m6502_op_0xAE_2,&&_m6502_op_0xAE_3,&&_m6502_op_0xAE_4,&&_m6502_op_0xAE_5,&&_m6502_op_0xAE_6,&&_m6502_op_0xAE_7,
+        &&_m6502_op_0xAF_0,&&_m6502_op_0xAF_1,&&_m6502_op_0xAF_2,&&_m6502_op_0xAF_3,&&_m6502_op_0xAF_4,&&_m6502_op_0xAF_5,&&_m6502_op_0xAF_6,&&_m6502_op_0xAF_7,
+        &&_m6502_op_0xB0_0,&&_m6502_op_0xB0_1,&&_m6502_op_0xB0_2,&&_m6502_op_0xB0_3,&&_m6502_op_0xB0_4,&&_m6502_op_0xB0_5,&&_m6502_op_0xB0_6,&&_m6502_op_0xB0_7,
+        &&_m6502_op_0xB1_0,&&_m6502_op_0xB1_1,&&_m6502_op_0xB1_2,&&_m6502_op_0xB1_3,&&_m6502_op_0xB1_4,&&_m6502_op_0xB1_5,&&_m6502_op_0xB1_6,&&_m6502_op_0xB1_7,
+        &&_m6502_op_0xB2_0,&&_m6502_op_0xB2_1,&&_m6502_op_0xB2_2,&&_m6502_op_0xB2_3,&&_m6502_op_0xB2_4,&&_m6502_op_0xB2_5,&&_m6502_op_0xB2_6,&&_m6502_op_0xB2_7,
+        &&_m6502_op_0xB3_0,&&_m6502_op_0xB3_1,&&_m6502_op_0xB3_2,&&_m6502_op_0xB3_3,&&_m6502_op_0xB3_4,&&_m6502_op_0xB3_5,&&_m6502_op_0xB3_6,&&_m6502_op_0xB3_7,
+        &&_m6502_op_0xB4_0,&&_m6502_op_0xB4_1,&&_m6502_op_0xB4_2,&&_m6502_op_0xB4_3,&&_m6502_op_0xB4_4,&&_m6502_op_0xB4_5,&&_m6502_op_0xB4_6,&&_m6502_op_0xB4_7,
+        &&_m6502_op_0xB5_0,&&_m6502_op_0xB5_1,&&_m6502_op_0xB5_2,&&_m6502_op_0xB5_3,&&_m6502_op_0xB5_4,&&_m6502_op_0xB5_5,&&_m6502_op_0xB5_6,&&_m6502_op_0xB5_7,
+        &&_m6502_op_0xB6_0,&&_m6502_op_0xB6_1,&&_m6502_op_0xB6_2,&&_m6502_op_0xB6_3,&&_m6502_op_0xB6_4,&&_m6502_op_0xB6_5,&&_m6502_op_0xB6_6,&&_m6502_op_0xB6_7,
+        &&_m6502_op_0xB7_0,&&_m6502_op_0xB7_1,&&_m6502_op_0xB7_2,&&_m6502_op_0xB7_3,&&_m6502_op_0xB7_4,&&_m6502_op_0xB7_5,&&_m6502_op_0xB7_6,&&_m6502_op_0xB7_7,
+        &&_m6502_op_0xB8_0,&&_m6502_op_0xB8_1,&&_m6502_op_0xB8_2,&&_m6502_op_0xB8_3,&&_m6502_op_0xB8_4,&&_m6502_op_0xB8_5,&&_m6502_op_0xB8_6,&&_m6502_op_0xB8_7,
+        &&_m6502_op_0xB9_0,&&_m6502_op_0xB9_1,&&_m6502_op_0xB9_2,&&_m6502_op_0xB9_3,&&_m6502_op_0xB9_4,&&_m6502_op_0xB9_5,&&_m6502_op_0xB9_6,&&_m6502_op_0xB9_7,
+        &&_m6502_op_0xBA_0,&&_m6502_op_0xBA_1,&&_m6502_op_0xBA_2,&&_m6502_op_0xBA_3,&&_m6502_op_0xBA_4,&&_m6502_op_0xBA_5,&&_m6502_op_0xBA_6,&&_m6502_op_0xBA_7,
+        &&_m6502_op_0xBB_0,&&_m6502_op_0xBB_1,&&_m6502_op_0xBB_2,&&_m6502_op_0xBB_3,&&_m6502_op_0xBB_4,&&_m6502_op_0xBB_5,&&_m6502_op_0xBB_6,&&_m6502_op_0xBB_7,
+        &&_m6502_op_0xBC_0,&&_m6502_op_0xBC_1,&&_m6502_op_0xBC_2,&&_m6502_op_0xBC_3,&&_m6502_op_0xBC_4,&&_m6502_op_0xBC_5,&&_m6502_op_0xBC_6,&&_m6502_op_0xBC_7,
+        &&_m6502_op_0xBD_0,&&_m6502_op_0xBD_1,&&_m6502_op_0xBD_2,&&_m6502_op_0xBD_3,&&_m6502_op_0xBD_4,&&_m6502_op_0xBD_5,&&_m6502_op_0xBD_6,&&_m6502_op_0xBD_7,
+        &&_m6502_op_0xBE_0,&&_m6502_op_0xBE_1,&&_m6502_op_0xBE_2,&&_m6502_op_0xBE_3,&&_m6502_op_0xBE_4,&&_m6502_op_0xBE_5,&&_m6502_op_0xBE_6,&&_m6502_op_0xBE_7,
+        &&_m6502_op_0xBF_0,&&_m6502_op_0xBF_1,&&_m6502_op_0xBF_2,&&_m6502_op_0xBF_3,&&_m6502_op_0xBF_4,&&_m6502_op_0xBF_5,&&_m6502_op_0xBF_6,&&_m6502_op_0xBF_7,
+        &&_m6502_op_0xC0_0,&&_m6502_op_0xC0_1,&&_m6502_op_0xC0_2,&&_m6502_op_0xC0_3,&&_m6502_op_0xC0_4,&&_m6502_op_0xC0_5,&&_m6502_op_0xC0_6,&&_m6502_op_0xC0_7,
+        &&_m6502_op_0xC1_0,&&_m6502_op_0xC1_1,&&_m6502_op_0xC1_2,&&_m6502_op_0xC1_3,&&_m6502_op_0xC1_4,&&_m6502_op_0xC1_5,&&_m6502_op_0xC1_6,&&_m6502_op_0xC1_7,
+        &&_m6502_op_0xC2_0,&&_m6502_op_0xC2_1,&&_m6502_op_0xC2_2,&&_m6502_op_0xC2_3,&&_m6502_op_0xC2_4,&&_m6502_op_0xC2_5,&&_m6502_op_0xC2_6,&&_m6502_op_0xC2_7,
+        &&_m6502_op_0xC3_0,&&_m6502_op_0xC3_1,&&_m6502_op_0xC3_2,&&_m6502_op_0xC3_3,&&_m6502_op_0xC3_4,&&_m6502_op_0xC3_5,&&_m6502_op_0xC3_6,&&_m6502_op_0xC3_7,
+        &&_m6502_op_0xC4_0,&&_m6502_op_0xC4_1,&&_m6502_op_0xC4_2,&&_m6502_op_0xC4_3,&&_m6502_op_0xC4_4,&&_m6502_op_0xC4_5,&&_m6502_op_0xC4_6,&&_m6502_op_0xC4_7,
+        &&_m6502_op_0xC5_0,&&_m6502_op_0xC5_1,&&_m6502_op_0xC5_2,&&_m6502_op_0xC5_3,&&_m6502_op_0xC5_4,&&_m6502_op_0xC5_5,&&_m6502_op_0xC5_6,&&_m6502_op_0xC5_7,
+        &&_m6502_op_0xC6_0,&&_m6502_op_0xC6_1,&&_m6502_op_0xC6_2,&&_m6502_op_0xC6_3,&&_m6502_op_0xC6_4,&&_m6502_op_0xC6_5,&&_m6502_op_0xC6_6,&&_m6502_op_0xC6_7,
+        &&_m6502_op_0xC7_0,&&_m6502_op_0xC7_1,&&_m6502_op_0xC7_2,&&_m6502_op_0xC7_3,&&_m6502_op_0xC7_4,&&_m6502_op_0xC7_5,&&_m6502_op_0xC7_6,&&_m6502_op_0xC7_7,
+        &&_m6502_op_0xC8_0,&&_m6502_op_0xC8_1,&&_m6502_op_0xC8_2,&&_m6502_op_0xC8_3,&&_m6502_op_0xC8_4,&&_m6502_op_0xC8_5,&&_m6502_op_0xC8_6,&&_m6502_op_0xC8_7,
+        &&_m6502_op_0xC9_0,&&_m6502_op_0xC9_1,&&_m6502_op_0xC9_2,&&_m6502_op_0xC9_3,&&_m6502_op_0xC9_4,&&_m6502_op_0xC9_5,&&_m6502_op_0xC9_6,&&_m6502_op_0xC9_7,
+        &&_m6502_op_0xCA_0,&&_m6502_op_0xCA_1,&&_m6502_op_0xCA_2,&&_m6502_op_0xCA_3,&&_m6502_op_0xCA_4,&&_m6502_op_0xCA_5,&&_m6502_op_0xCA_6,&&_m6502_op_0xCA_7,
+        &&_m6502_op_0xCB_0,&&_m6502_op_0xCB_1,&&_m6502_op_0xCB_2,&&_m6502_op_0xCB_3,&&_m6502_op_0xCB_4,&&_m6502_op_0xCB_5,&&_m6502_op_0xCB_6,&&_m6502_op_0xCB_7,
+        &&_m6502_op_0xCC_0,&&_m6502_op_0xCC_1,&&_m6502_op_0xCC_2,&&_m6502_op_0xCC_3,&&_m6502_op_0xCC_4,&&_m6502_op_0xCC_5,&&_m6502_op_0xCC_6,&&_m6502_op_0xCC_7,
+        &&_m6502_op_0xCD_0,&&_m6502_op_0xCD_1,&&_m6502_op_0xCD_2,&&_m6502_op_0xCD_3,&&_m6502_op_0xCD_4,&&_m6502_op_0xCD_5,&&_m6502_op_0xCD_6,&&_m6502_op_0xCD_7,
+        &&_m6502_op_0xCE_0,&&_m6502_op_0xCE_1,&&_m6502_op_0xCE_2,&&_m6502_op_0xCE_3,&&_m6502_op_0xCE_4,&&_m6502_op_0xCE_5,&&_m6502_op_0xCE_6,&&_m6502_op_0xCE_7,
+        &&_m6502_op_0xCF_0,&&_m6502_op_0xCF_1,&&_m6502_op_0xCF_2,&&_m6502_op_0xCF_3,&&_m6502_op_0xCF_4,&&_m6502_op_0xCF_5,&&_m6502_op_0xCF_6,&&_m6502_op_0xCF_7,
+        &&_m6502_op_0xD0_0,&&_m6502_op_0xD0_1,&&_m6502_op_0xD0_2,&&_m6502_op_0xD0_3,&&_m6502_op_0xD0_4,&&_m6502_op_0xD0_5,&&_m6502_op_0xD0_6,&&_m6502_op_0xD0_7,
+        &&_m6502_op_0xD1_0,&&_m6502_op_0xD1_1,&&_m6502_op_0xD1_2,&&_m6502_op_0xD1_3,&&_m6502_op_0xD1_4,&&_m6502_op_0xD1_5,&&_m6502_op_0xD1_6,&&_m6502_op_0xD1_7,
+        &&_m6502_op_0xD2_0,&&_m6502_op_0xD2_1,&&_m6502_op_0xD2_2,&&_m6502_op_0xD2_3,&&_m6502_op_0xD2_4,&&_m6502_op_0xD2_5,&&_m6502_op_0xD2_6,&&_m6502_op_0xD2_7,
+        &&_m6502_op_0xD3_0,&&_m6502_op_0xD3_1,&&_m6502_op_0xD3_2,&&_m6502_op_0xD3_3,&&_m6502_op_0xD3_4,&&_m6502_op_0xD3_5,&&_m6502_op_0xD3_6,&&_m6502_op_0xD3_7,
+        &&_m6502_op_0xD4_0,&&_m6502_op_0xD4_1,&&_m6502_op_0xD4_2,&&_m6502_op_0xD4_3,&&_m6502_op_0xD4_4,&&_m6502_op_0xD4_5,&&_m6502_op_0xD4_6,&&_m6502_op_0xD4_7,
+        &&_m6502_op_0xD5_0,&&_m6502_op_0xD5_1,&&_m6502_op_0xD5_2,&&_m6502_op_0xD5_3,&&_m6502_op_0xD5_4,&&_m6502_op_0xD5_5,&&_m6502_op_0xD5_6,&&_m6502_op_0xD5_7,
+        &&_m6502_op_0xD6_0,&&_m6502_op_0xD6_1,&&_m6502_op_0xD6_2,&&_m6502_op_0xD6_3,&&_m6502_op_0xD6_4,&&_m6502_op_0xD6_5,&&_m6502_op_0xD6_6,&&_m6502_op_0xD6_7,
+        &&_m6502_op_0xD7_0,&&_m6502_op_0xD7_1,&&_m6502_op_0xD7_2,&&_m6502_op_0xD7_3,&&_m6502_op_0xD7_4,&&_m6502_op_0xD7_5,&&_m6502_op_0xD7_6,&&_m6502_op_0xD7_7,
+        &&_m6502_op_0xD8_0,&&_m6502_op_0xD8_1,&&_m6502_op_0xD8_2,&&_m6502_op_0xD8_3,&&_m6502_op_0xD8_4,&&_m6502_op_0xD8_5,&&_m6502_op_0xD8_6,&&_m6502_op_0xD8_7,
+        &&_m6502_op_0xD9_0,&&_m6502_op_0xD9_1,&&_m6502_op_0xD9_2,&&_m6502_op_0xD9_3,&&_m6502_op_0xD9_4,&&_m6502_op_0xD9_5,&&_m6502_op_0xD9_6,&&_m6502_op_0xD9_7,
+        &&_m6502_op_0xDA_0,&&_m6502_op_0xDA_1,&&_m6502_op_0xDA_2,&&_m6502_op_0xDA_3,&&_m6502_op_0xDA_4,&&_m6502_op_0xDA_5,&&_m6502_op_0xDA_6,&&_m6502_op_0xDA_7,
+        &&_m6502_op_0xDB_0,&&_m6502_op_0xDB_1,&&_m6502_op_0xDB_2,&&_m6502_op_0xDB_3,&&_m6502_op_0xDB_4,&&_m6502_op_0xDB_5,&&_m6502_op_0xDB_6,&&_m6502_op_0xDB_7,
+        &&_m6502_op_0xDC_0,&&_m6502_op_0xDC_1,&&_m6502_op_0xDC_2,&&_m6502_op_0xDC_3,&&_m6502_op_0xDC_4,&&_m6502_op_0xDC_5,&&_m6502_op_0xDC_6,&&_m6502_op_0xDC_7,
+        &&_m6502_op_0xDD_0,&&_m6502_op_0xDD_1,&&_m6502_op_0xDD_2,&&_m6502_op_0xDD_3,&&_m6502_op_0xDD_4,&&_m6502_op_0xDD_5,&&_m6502_op_0xDD_6,&&_m6502_op_0xDD_7,
+        &&_m6502_op_0xDE_0,&&_m6502_op_0xDE_1,&&_m6502_op_0xDE_2,&&_m6502_op_0xDE_3,&&_m6502_op_0xDE_4,&&_m6502_op_0xDE_5,&&_m6502_op_0xDE_6,&&_m6502_op_0xDE_7,
+        &&_m6502_op_0xDF_0,&&_m6502_op_0xDF_1,&&_m6502_op_0xDF_2,&&_m6502_op_0xDF_3,&&_m6502_op_0xDF_4,&&_m6502_op_0xDF_5,&&_m6502_op_0xDF_6,&&_m6502_op_0xDF_7,
+        &&_m6502_op_0xE0_0,&&_m6502_op_0xE0_1,&&_m6502_op_0xE0_2,&&_m6502_op_0xE0_3,&&_m6502_op_0xE0_4,&&_m6502_op_0xE0_5,&&_m6502_op_0xE0_6,&&_m6502_op_0xE0_7,
+        &&_m6502_op_0xE1_0,&&_m6502_op_0xE1_1,&&_m6502_op_0xE1_2,&&_m6502_op_0xE1_3,&&_m6502_op_0xE1_4,&&_m6502_op_0xE1_5,&&_m6502_op_0xE1_6,&&_m6502_op_0xE1_7,
+        &&_m6502_op_0xE2_0,&&_m6502_op_0xE2_1,&&_m6502_op_0xE2_2,&&_m6502_op_0xE2_3,&&_m6502_op_0xE2_4,&&_m6502_op_0xE2_5,&&_m6502_op_0xE2_6,&&_m6502_op_0xE2_7,
+        &&_m6502_op_0xE3_0,&&_m6502_op_0xE3_1,&&_m6502_op_0xE3_2,&&_m6502_op_0xE3_3,&&_m6502_op_0xE3_4,&&_m6502_op_0xE3_5,&&_m6502_op_0xE3_6,&&_m6502_op_0xE3_7,
+        &&_m6502_op_0xE4_0,&&_m6502_op_0xE4_1,&&_m6502_op_0xE4_2,&&_m6502_op_0xE4_3,&&_m6502_op_0xE4_4,&&_m6502_op_0xE4_5,&&_m6502_op_0xE4_6,&&_m6502_op_0xE4_7,
+        &&_m6502_op_0xE5_0,&&_m6502_op_0xE5_1,&&_m6502_op_0xE5_2,&&_m6502_op_0xE5_3,&&_m6502_op_0xE5_4,&&_m6502_op_0xE5_5,&&_m6502_op_0xE5_6,&&_m6502_op_0xE5_7,
+        &&_m6502_op_0xE6_0,&&_m6502_op_0xE6_1,&&_m6502_op_0xE6_2,&&_m6502_op_0xE6_3,&&_m6502_op_0xE6_4,&&_m6502_op_0xE6_5,&&_m6502_op_0xE6_6,&&_m6502_op_0xE6_7,
+        &&_m6502_op_0xE7_0,&&_m6502_op_0xE7_1,&&_m6502_op_0xE7_2,&&_m6502_op_0xE7_3,&&_m6502_op_0xE7_4,&&_m6502_op_0xE7_5,&&_m6502_op_0xE7_6,&&_m6502_op_0xE7_7,
+        &&_m6502_op_0xE8_0,&&_m6502_op_0xE8_1,&&_m6502_op_0xE8_2,&&_m6502_op_0xE8_3,&&_m6502_op_0xE8_4,&&_m6502_op_0xE8_5,&&_m6502_op_0xE8_6,&&_m6502_op_0xE8_7,
+        &&_m6502_op_0xE9_0,&&_m6502_op_0xE9_1,&&_m6502_op_0xE9_2,&&_m6502_op_0xE9_3,&&_m6502_op_0xE9_4,&&_m6502_op_0xE9_5,&&_m6502_op_0xE9_6,&&_m6502_op_0xE9_7,
+        &&_m6502_op_0xEA_0,&&_m6502_op_0xEA_1,&&_m6502_op_0xEA_2,&&_m6502_op_0xEA_3,&&_m6502_op_0xEA_4,&&_m6502_op_0xEA_5,&&_m6502_op_0xEA_6,&&_m6502_op_0xEA_7,
+        &&_m6502_op_0xEB_0,&&_m6502_op_0xEB_1,&&_m6502_op_0xEB_2,&&_m6502_op_0xEB_3,&&_m6502_op_0xEB_4,&&_m6502_op_0xEB_5,&&_m6502_op_0xEB_6,&&_m6502_op_0xEB_7,
+        &&_m6502_op_0xEC_0,&&_m6502_op_0xEC_1,&&_m6502_op_0xEC_2,&&_m6502_op_0xEC_3,&&_m6502_op_0xEC_4,&&_m6502_op_0xEC_5,&&_m6502_op_0xEC_6,&&_m6502_op_0xEC_7,
+        &&_m6502_op_0xED_0,&&_m6502_op_0xED_1,&&_m6502_op_0xED_2,&&_m6502_op_0xED_3,&&_m6502_op_0xED_4,&&_m6502_op_0xED_5,&&_m6502_op_0xED_6,&&_m6502_op_0xED_7,
+        &&_m6502_op_0xEE_0,&&_m6502_op_0xEE_1,&&_m6502_op_0xEE_2,&&_m6502_op_0xEE_3,&&_m6502_op_0xEE_4,&&_m6502_op_0xEE_5,&&_m6502_op_0xEE_6,&&_m6502_op_0xEE_7,
+        &&_m6502_op_0xEF_0,&&_m6502_op_0xEF_1,&&_m6502_op_0xEF_2,&&_m6502_op_0xEF_3,&&_m6502_op_0xEF_4,&&_m6502_op_0xEF_5,&&_m6502_op_0xEF_6,&&_m6502_op_0xEF_7,
+        &&_m6502_op_0xF0_0,&&_m6502_op_0xF0_1,&&_m6502_op_0xF0_2,&&_m6502_op_0xF0_3,&&_m6502_op_0xF0_4,&&_m6502_op_0xF0_5,&&_m6502_op_0xF0_6,&&_m6502_op_0xF0_7,
+        &&_m6502_op_0xF1_0,&&_m6502_op_0xF1_1,&&_m6502_op_0xF1_2,&&_m6502_op_0xF1_3,&&_m6502_op_0xF1_4,&&_m6502_op_0xF1_5,&&_m6502_op_0xF1_6,&&_m6502_op_0xF1_7,
+        &&_m6502_op_0xF2_0,&&_m6502_op_0xF2_1,&&_m6502_op_0xF2_2,&&_m6502_op_0xF2_3,&&_m6502_op_0xF2_4,&&_m6502_op_0xF2_5,&&_m6502_op_0xF2_6,&&_m6502_op_0xF2_7,
+        &&_m6502_op_0xF3_0,&&_m6502_op_0xF3_1,&&_m6502_op_0xF3_2,&&_m6502_op_0xF3_3,&&_m6502_op_0xF3_4,&&_m6502_op_0xF3_5,&&_m6502_op_0xF3_6,&&_m6502_op_0xF3_7,
+        &&_m6502_op_0xF4_0,&&_m6502_op_0xF4_1,&&_m6502_op_0xF4_2,&&_m6502_op_0xF4_3,&&_m6502_op_0xF4_4,&&_m6502_op_0xF4_5,&&_m6502_op_0xF4_6,&&_m6502_op_0xF4_7,
+        &&_m6502_op_0xF5_0,&&_m6502_op_0xF5_1,&&_m6502_op_0xF5_2,&&_m6502_op_0xF5_3,&&_m6502_op_0xF5_4,&&_m6502_op_0xF5_5,&&_m6502_op_0xF5_6,&&_m6502_op_0xF5_7,
+        &&_m6502_op_0xF6_0,&&_m6502_op_0xF6_1,&&_m6502_op_0xF6_2,&&_m6502_op_0xF6_3,&&_m6502_op_0xF6_4,&&_m6502_op_0xF6_5,&&_m6502_op_0xF6_6,&&_m6502_op_0xF6_7,
+        &&_m6502_op_0xF7_0,&&_m6502_op_0xF7_1,&&_m6502_op_0xF7_2,&&_m6502_op_0xF7_3,&&_m6502_op_0xF7_4,&&_m6502_op_0xF7_5,&&_m6502_op_0xF7_6,&&_m6502_op_0xF7_7,
+        &&_m6502_op_0xF8_0,&&_m6502_op_0xF8_1,&&_m6502_op_0xF8_2,&&_m6502_op_0xF8_3,&&_m6502_op_0xF8_4,&&_m6502_op_0xF8_5,&&_m6502_op_0xF8_6,&&_m6502_op_0xF8_7,
+        &&_m6502_op_0xF9_0,&&_m6502_op_0xF9_1,&&_m6502_op_0xF9_2,&&_m6502_op_0xF9_3,&&_m6502_op_0xF9_4,&&_m6502_op_0xF9_5,&&_m6502_op_0xF9_6,&&_m6502_op_0xF9_7,
+        &&_m6502_op_0xFA_0,&&_m6502_op_0xFA_1,&&_m6502_op_0xFA_2,&&_m6502_op_0xFA_3,&&_m6502_op_0xFA_4,&&_m6502_op_0xFA_5,&&_m6502_op_0xFA_6,&&_m6502_op_0xFA_7,
+        &&_m6502_op_0xFB_0,&&_m6502_op_0xFB_1,&&_m6502_op_0xFB_2,&&_m6502_op_0xFB_3,&&_m6502_op_0xFB_4,&&_m6502_op_0xFB_5,&&_m6502_op_0xFB_6,&&_m6502_op_0xFB_7,
+        &&_m6502_op_0xFC_0,&&_m6502_op_0xFC_1,&&_m6502_op_0xFC_2,&&_m6502_op_0xFC_3,&&_m6502_op_0xFC_4,&&_m6502_op_0xFC_5,&&_m6502_op_0xFC_6,&&_m6502_op_0xFC_7,
+        &&_m6502_op_0xFD_0,&&_m6502_op_0xFD_1,&&_m6502_op_0xFD_2,&&_m6502_op_0xFD_3,&&_m6502_op_0xFD_4,&&_m6502_op_0xFD_5,&&_m6502_op_0xFD_6,&&_m6502_op_0xFD_7,
+        &&_m6502_op_0xFE_0,&&_m6502_op_0xFE_1,&&_m6502_op_0xFE_2,&&_m6502_op_0xFE_3,&&_m6502_op_0xFE_4,&&_m6502_op_0xFE_5,&&_m6502_op_0xFE_6,&&_m6502_op_0xFE_7,
+        &&_m6502_op_0xFF_0,&&_m6502_op_0xFF_1,&&_m6502_op_0xFF_2,&&_m6502_op_0xFF_3,&&_m6502_op_0xFF_4,&&_m6502_op_0xFF_5,&&_m6502_op_0xFF_6,&&_m6502_op_0xFF_7,
+    };
+    #endif
+    _DISPATCH(_m6502_op_table)
     /* BRK  */
-        case (0x00<<3)|0: _SA(c->PC);break;
-        case (0x00<<3)|1: if(0==(c->brk_flags&(M6502_BRK_IRQ|M6502_BRK_NMI))){c->PC++;}_SAD(0x0100|c->S--,c->PC>>8);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}break;
-        case (0x00<<3)|2: _SAD(0x0100|c->S--,c->PC);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}break;
-        case (0x00<<3)|3: _SAD(0x0100|c->S--,c->P|M6502_XF);if(c->brk_flags&M6502_BRK_RESET){c->AD=0xFFFC;}else{_WR();if(c->brk_flags&M6502_BRK_NMI){c->AD=0xFFFA;}else{c->AD=0xFFFE;}}break;
-        case (0x00<<3)|4: _SA(c->AD++);c->P|=(M6502_IF|M6502_BF);c->brk_flags=0; /* RES/NMI hijacking */break;
-        case (0x00<<3)|5: _SA(c->AD);c->AD=_GD(); /* NMI "half-hijacking" not possible */break;
-        case (0x00<<3)|6: c->PC=(_GD()<<8)|c->AD;_FETCH();break;
-        case (0x00<<3)|7: assert(false);break;
+        _OP(0x00,0): _SA(c->PC);_NEXT()
+        _OP(0x00,1): if(0==(c->brk_flags&(M6502_BRK_IRQ|M6502_BRK_NMI))){c->PC++;}_SAD(0x0100|c->S--,c->PC>>8);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}_NEXT()
+        _OP(0x00,2): _SAD(0x0100|c->S--,c->PC);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}_NEXT()
+        _OP(0x00,3): _SAD(0x0100|c->S--,c->P|M6502_XF);if(c->brk_flags&M6502_BRK_RESET){c->AD=0xFFFC;}else{_WR();if(c->brk_flags&M6502_BRK_NMI){c->AD=0xFFFA;}else{c->AD=0xFFFE;}}_NEXT()
+        _OP(0x00,4): _SA(c->AD++);c->P|=(M6502_IF|M6502_BF);c->brk_flags=0; /* RES/NMI hijacking */_NEXT()
+        _OP(0x00,5): _SA(c->AD);c->AD=_GD(); /* NMI "half-hijacking" not possible */_NEXT()
+        _OP(0x00,6): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x00,7): assert(false);_NEXT()
     /* ORA (zp,X) */
-        case (0x01<<3)|0: _SA(c->PC++);break;
-        case (0x01<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x01<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x01<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x01<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0x01<<3)|5: c->A|=_GD();_NZ(c->A);_FETCH();break;
-        case (0x01<<3)|6: assert(false);break;
-        case (0x01<<3)|7: assert(false);break;
+        _OP(0x01,0): _SA(c->PC++);_NEXT()
+        _OP(0x01,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x01,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x01,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x01,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x01,5): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x01,6): assert(false);_NEXT()
+        _OP(0x01,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x02<<3)|0: _SA(c->PC);break;
-        case (0x02<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x02<<3)|2: assert(false);break;
-        case (0x02<<3)|3: assert(false);break;
-        case (0x02<<3)|4: assert(false);break;
-        case (0x02<<3)|5: assert(false);break;
-        case (0x02<<3)|6: assert(false);break;
-        case (0x02<<3)|7: assert(false);break;
+        _OP(0x02,0): _SA(c->PC);_NEXT()
+        _OP(0x02,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x02,2): assert(false);_NEXT()
+        _OP(0x02,3): assert(false);_NEXT()
+        _OP(0x02,4): assert(false);_NEXT()
+        _OP(0x02,5): assert(false);_NEXT()
+        _OP(0x02,6): assert(false);_NEXT()
+        _OP(0x02,7): assert(false);_NEXT()
     /* SLO (zp,X) (undoc) */
-        case (0x03<<3)|0: _SA(c->PC++);break;
-        case (0x03<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x03<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x03<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x03<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0x03<<3)|5: c->AD=_GD();_WR();break;
-        case (0x03<<3)|6: c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();break;
-        case (0x03<<3)|7: _FETCH();break;
+        _OP(0x03,0): _SA(c->PC++);_NEXT()
+        _OP(0x03,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x03,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x03,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x03,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x03,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x03,6): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x03,7): _FETCH();_NEXT()
     /* NOP zp (undoc) */
-        case (0x04<<3)|0: _SA(c->PC++);break;
-        case (0x04<<3)|1: _SA(_GD());break;
-        case (0x04<<3)|2: _FETCH();break;
-        case (0x04<<3)|3: assert(false);break;
-        case (0x04<<3)|4: assert(false);break;
-        case (0x04<<3)|5: assert(false);break;
-        case (0x04<<3)|6: assert(false);break;
-        case (0x04<<3)|7: assert(false);break;
+        _OP(0x04,0): _SA(c->PC++);_NEXT()
+        _OP(0x04,1): _SA(_GD());_NEXT()
+        _OP(0x04,2): _FETCH();_NEXT()
+        _OP(0x04,3): assert(false);_NEXT()
+        _OP(0x04,4): assert(false);_NEXT()
+        _OP(0x04,5): assert(false);_NEXT()
+        _OP(0x04,6): assert(false);_NEXT()
+        _OP(0x04,7): assert(false);_NEXT()
     /* ORA zp */
-        case (0x05<<3)|0: _SA(c->PC++);break;
-        case (0x05<<3)|1: _SA(_GD());break;
-        case (0x05<<3)|2: c->A|=_GD();_NZ(c->A);_FETCH();break;
-        case (0x05<<3)|3: assert(false);break;
-        case (0x05<<3)|4: assert(false);break;
-        case (0x05<<3)|5: assert(false);break;
-        case (0x05<<3)|6: assert(false);break;
-        case (0x05<<3)|7: assert(false);break;
+        _OP(0x05,0): _SA(c->PC++);_NEXT()
+        _OP(0x05,1): _SA(_GD());_NEXT()
+        _OP(0x05,2): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x05,3): assert(false);_NEXT()
+        _OP(0x05,4): assert(false);_NEXT()
+        _OP(0x05,5): assert(false);_NEXT()
+        _OP(0x05,6): assert(false);_NEXT()
+        _OP(0x05,7): assert(false);_NEXT()
     /* ASL zp */
-        case (0x06<<3)|0: _SA(c->PC++);break;
-        case (0x06<<3)|1: _SA(_GD());break;
-        case (0x06<<3)|2: c->AD=_GD();_WR();break;
-        case (0x06<<3)|3: _SD(_m6502_asl(c,c->AD));_WR();break;
-        case (0x06<<3)|4: _FETCH();break;
-        case (0x06<<3)|5: assert(false);break;
-        case (0x06<<3)|6: assert(false);break;
-        case (0x06<<3)|7: assert(false);break;
+        _OP(0x06,0): _SA(c->PC++);_NEXT()
+        _OP(0x06,1): _SA(_GD());_NEXT()
+        _OP(0x06,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x06,3): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x06,4): _FETCH();_NEXT()
+        _OP(0x06,5): assert(false);_NEXT()
+        _OP(0x06,6): assert(false);_NEXT()
+        _OP(0x06,7): assert(false);_NEXT()
     /* SLO zp (undoc) */
-        case (0x07<<3)|0: _SA(c->PC++);break;
-        case (0x07<<3)|1: _SA(_GD());break;
-        case (0x07<<3)|2: c->AD=_GD();_WR();break;
-        case (0x07<<3)|3: c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();break;
-        case (0x07<<3)|4: _FETCH();break;
-        case (0x07<<3)|5: assert(false);break;
-        case (0x07<<3)|6: assert(false);break;
-        case (0x07<<3)|7: assert(false);break;
+        _OP(0x07,0): _SA(c->PC++);_NEXT()
+        _OP(0x07,1): _SA(_GD());_NEXT()
+        _OP(0x07,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x07,3): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x07,4): _FETCH();_NEXT()
+        _OP(0x07,5): assert(false);_NEXT()
+        _OP(0x07,6): assert(false);_NEXT()
+        _OP(0x07,7): assert(false);_NEXT()
     /* PHP  */
-        case (0x08<<3)|0: _SA(c->PC);break;
-        case (0x08<<3)|1: _SAD(0x0100|c->S--,c->P|M6502_XF);_WR();break;
-        case (0x08<<3)|2: _FETCH();break;
-        case (0x08<<3)|3: assert(false);break;
-        case (0x08<<3)|4: assert(false);break;
-        case (0x08<<3)|5: assert(false);break;
-        case (0x08<<3)|6: assert(false);break;
-        case (0x08<<3)|7: assert(false);break;
+        _OP(0x08,0): _SA(c->PC);_NEXT()
+        _OP(0x08,1): _SAD(0x0100|c->S--,c->P|M6502_XF);_WR();_NEXT()
+        _OP(0x08,2): _FETCH();_NEXT()
+        _OP(0x08,3): assert(false);_NEXT()
+        _OP(0x08,4): assert(false);_NEXT()
+        _OP(0x08,5): assert(false);_NEXT()
+        _OP(0x08,6): assert(false);_NEXT()
+        _OP(0x08,7): assert(false);_NEXT()
     /* ORA # */
-        case (0x09<<3)|0: _SA(c->PC++);break;
-        case (0x09<<3)|1: c->A|=_GD();_NZ(c->A);_FETCH();break;
-        case (0x09<<3)|2: assert(false);break;
-        case (0x09<<3)|3: assert(false);break;
-        case (0x09<<3)|4: assert(false);break;
-        case (0x09<<3)|5: assert(false);break;
-        case (0x09<<3)|6: assert(false);break;
-        case (0x09<<3)|7: assert(false);break;
+        _OP(0x09,0): _SA(c->PC++);_NEXT()
+        _OP(0x09,1): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x09,2): assert(false);_NEXT()
+        _OP(0x09,3): assert(false);_NEXT()
+        _OP(0x09,4): assert(false);_NEXT()
+        _OP(0x09,5): assert(false);_NEXT()
+        _OP(0x09,6): assert(false);_NEXT()
+        _OP(0x09,7): assert(false);_NEXT()
     /* ASLA  */
-        case (0x0A<<3)|0: _SA(c->PC);break;
-        case (0x0A<<3)|1: c->A=_m6502_asl(c,c->A);_FETCH();break;
-        case (0x0A<<3)|2: assert(false);break;
-        case (0x0A<<3)|3: assert(false);break;
-        case (0x0A<<3)|4: assert(false);break;
-        case (0x0A<<3)|5: assert(false);break;
-        case (0x0A<<3)|6: assert(false);break;
-        case (0x0A<<3)|7: assert(false);break;
+        _OP(0x0A,0): _SA(c->PC);_NEXT()
+        _OP(0x0A,1): c->A=_m6502_asl(c,c->A);_FETCH();_NEXT()
+        _OP(0x0A,2): assert(false);_NEXT()
+        _OP(0x0A,3): assert(false);_NEXT()
+        _OP(0x0A,4): assert(false);_NEXT()
+        _OP(0x0A,5): assert(false);_NEXT()
+        _OP(0x0A,6): assert(false);_NEXT()
+        _OP(0x0A,7): assert(false);_NEXT()
     /* ANC # (undoc) */
-        case (0x0B<<3)|0: _SA(c->PC++);break;
-        case (0x0B<<3)|1: c->A&=_GD();_NZ(c->A);if(c->A&0x80){c->P|=M6502_CF;}else{c->P&=~M6502_CF;}_FETCH();break;
-        case (0x0B<<3)|2: assert(false);break;
-        case (0x0B<<3)|3: assert(false);break;
-        case (0x0B<<3)|4: assert(false);break;
-        case (0x0B<<3)|5: assert(false);break;
-        case (0x0B<<3)|6: assert(false);break;
-        case (0x0B<<3)|7: assert(false);break;
+        _OP(0x0B,0): _SA(c->PC++);_NEXT()
+        _OP(0x0B,1): c->A&=_GD();_NZ(c->A);if(c->A&0x80){c->P|=M6502_CF;}else{c->P&=~M6502_CF;}_FETCH();_NEXT()
+        _OP(0x0B,2): assert(false);_NEXT()
+        _OP(0x0B,3): assert(false);_NEXT()
+        _OP(0x0B,4): assert(false);_NEXT()
+        _OP(0x0B,5): assert(false);_NEXT()
+        _OP(0x0B,6): assert(false);_NEXT()
+        _OP(0x0B,7): assert(false);_NEXT()
     /* NOP abs (undoc) */
-        case (0x0C<<3)|0: _SA(c->PC++);break;
-        case (0x0C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x0C<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x0C<<3)|3: _FETCH();break;
-        case (0x0C<<3)|4: assert(false);break;
-        case (0x0C<<3)|5: assert(false);break;
-        case (0x0C<<3)|6: assert(false);break;
-        case (0x0C<<3)|7: assert(false);break;
+        _OP(0x0C,0): _SA(c->PC++);_NEXT()
+        _OP(0x0C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0C,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0C,3): _FETCH();_NEXT()
+        _OP(0x0C,4): assert(false);_NEXT()
+        _OP(0x0C,5): assert(false);_NEXT()
+        _OP(0x0C,6): assert(false);_NEXT()
+        _OP(0x0C,7): assert(false);_NEXT()
     /* ORA abs */
-        case (0x0D<<3)|0: _SA(c->PC++);break;
-        case (0x0D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x0D<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x0D<<3)|3: c->A|=_GD();_NZ(c->A);_FETCH();break;
-        case (0x0D<<3)|4: assert(false);break;
-        case (0x0D<<3)|5: assert(false);break;
-        case (0x0D<<3)|6: assert(false);break;
-        case (0x0D<<3)|7: assert(false);break;
+        _OP(0x0D,0): _SA(c->PC++);_NEXT()
+        _OP(0x0D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0D,3): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x0D,4): assert(false);_NEXT()
+        _OP(0x0D,5): assert(false);_NEXT()
+        _OP(0x0D,6): assert(false);_NEXT()
+        _OP(0x0D,7): assert(false);_NEXT()
     /* ASL abs */
-        case (0x0E<<3)|0: _SA(c->PC++);break;
-        case (0x0E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x0E<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x0E<<3)|3: c->AD=_GD();_WR();break;
-        case (0x0E<<3)|4: _SD(_m6502_asl(c,c->AD));_WR();break;
-        case (0x0E<<3)|5: _FETCH();break;
-        case (0x0E<<3)|6: assert(false);break;
-        case (0x0E<<3)|7: assert(false);break;
+        _OP(0x0E,0): _SA(c->PC++);_NEXT()
+        _OP(0x0E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0E,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x0E,4): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x0E,5): _FETCH();_NEXT()
+        _OP(0x0E,6): assert(false);_NEXT()
+        _OP(0x0E,7): assert(false);_NEXT()
     /* SLO abs (undoc) */
-        case (0x0F<<3)|0: _SA(c->PC++);break;
-        case (0x0F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x0F<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x0F<<3)|3: c->AD=_GD();_WR();break;
-        case (0x0F<<3)|4: c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();break;
-        case (0x0F<<3)|5: _FETCH();break;
-        case (0x0F<<3)|6: assert(false);break;
-        case (0x0F<<3)|7: assert(false);break;
+        _OP(0x0F,0): _SA(c->PC++);_NEXT()
+        _OP(0x0F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0F,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0F,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x0F,4): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x0F,5): _FETCH();_NEXT()
+        _OP(0x0F,6): assert(false);_NEXT()
+        _OP(0x0F,7): assert(false);_NEXT()
     /* BPL # */
-        case (0x10<<3)|0: _SA(c->PC++);break;
-        case (0x10<<3)|1: _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x80)!=0x0){_FETCH();};break;
-        case (0x10<<3)|2: _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};break;
-        case (0x10<<3)|3: c->PC=c->AD;_FETCH();break;
-        case (0x10<<3)|4: assert(false);break;
-        case (0x10<<3)|5: assert(false);break;
-        case (0x10<<3)|6: assert(false);break;
-        case (0x10<<3)|7: assert(false);break;
+        _OP(0x10,0): _SA(c->PC++);_NEXT()
+        _OP(0x10,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x80)!=0x0){_FETCH();};_NEXT()
+        _OP(0x10,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x10,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x10,4): assert(false);_NEXT()
+        _OP(0x10,5): assert(false);_NEXT()
+        _OP(0x10,6): assert(false);_NEXT()
+        _OP(0x10,7): assert(false);_NEXT()
     /* ORA (zp),Y */
-        case (0x11<<3)|0: _SA(c->PC++);break;
-        case (0x11<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x11<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x11<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0x11<<3)|4: _SA(c->AD+c->Y);break;
-        case (0x11<<3)|5: c->A|=_GD();_NZ(c->A);_FETCH();break;
-        case (0x11<<3)|6: assert(false);break;
-        case (0x11<<3)|7: assert(false);break;
+        _OP(0x11,0): _SA(c->PC++);_NEXT()
+        _OP(0x11,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x11,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x11,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x11,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x11,5): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x11,6): assert(false);_NEXT()
+        _OP(0x11,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x12<<3)|0: _SA(c->PC);break;
-        case (0x12<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x12<<3)|2: assert(false);break;
-        case (0x12<<3)|3: assert(false);break;
-        case (0x12<<3)|4: assert(false);break;
-        case (0x12<<3)|5: assert(false);break;
-        case (0x12<<3)|6: assert(false);break;
-        case (0x12<<3)|7: assert(false);break;
+        _OP(0x12,0): _SA(c->PC);_NEXT()
+        _OP(0x12,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x12,2): assert(false);_NEXT()
+        _OP(0x12,3): assert(false);_NEXT()
+        _OP(0x12,4): assert(false);_NEXT()
+        _OP(0x12,5): assert(false);_NEXT()
+        _OP(0x12,6): assert(false);_NEXT()
+        _OP(0x12,7): assert(false);_NEXT()
     /* SLO (zp),Y (undoc) */
-        case (0x13<<3)|0: _SA(c->PC++);break;
-        case (0x13<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x13<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x13<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x13<<3)|4: _SA(c->AD+c->Y);break;
-        case (0x13<<3)|5: c->AD=_GD();_WR();break;
-        case (0x13<<3)|6: c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();break;
-        case (0x13<<3)|7: _FETCH();break;
+        _OP(0x13,0): _SA(c->PC++);_NEXT()
+        _OP(0x13,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x13,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x13,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x13,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x13,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x13,6): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x13,7): _FETCH();_NEXT()
     /* NOP zp,X (undoc) */
-        case (0x14<<3)|0: _SA(c->PC++);break;
-        case (0x14<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x14<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x14<<3)|3: _FETCH();break;
-        case (0x14<<3)|4: assert(false);break;
-        case (0x14<<3)|5: assert(false);break;
-        case (0x14<<3)|6: assert(false);break;
-        case (0x14<<3)|7: assert(false);break;
+        _OP(0x14,0): _SA(c->PC++);_NEXT()
+        _OP(0x14,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x14,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x14,3): _FETCH();_NEXT()
+        _OP(0x14,4): assert(false);_NEXT()
+        _OP(0x14,5): assert(false);_NEXT()
+        _OP(0x14,6): assert(false);_NEXT()
+        _OP(0x14,7): assert(false);_NEXT()
     /* ORA zp,X */
-        case (0x15<<3)|0: _SA(c->PC++);break;
-        case (0x15<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x15<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x15<<3)|3: c->A|=_GD();_NZ(c->A);_FETCH();break;
-        case (0x15<<3)|4: assert(false);break;
-        case (0x15<<3)|5: assert(false);break;
-        case (0x15<<3)|6: assert(false);break;
-        case (0x15<<3)|7: assert(false);break;
+        _OP(0x15,0): _SA(c->PC++);_NEXT()
+        _OP(0x15,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x15,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x15,3): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x15,4): assert(false);_NEXT()
+        _OP(0x15,5): assert(false);_NEXT()
+        _OP(0x15,6): assert(false);_NEXT()
+        _OP(0x15,7): assert(false);_NEXT()
     /* ASL zp,X */
-        case (0x16<<3)|0: _SA(c->PC++);break;
-        case (0x16<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x16<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x16<<3)|3: c->AD=_GD();_WR();break;
-        case (0x16<<3)|4: _SD(_m6502_asl(c,c->AD));_WR();break;
-        case (0x16<<3)|5: _FETCH();break;
-        case (0x16<<3)|6: assert(false);break;
-        case (0x16<<3)|7: assert(false);break;
+        _OP(0x16,0): _SA(c->PC++);_NEXT()
+        _OP(0x16,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x16,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x16,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x16,4): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x16,5): _FETCH();_NEXT()
+        _OP(0x16,6): assert(false);_NEXT()
+        _OP(0x16,7): assert(false);_NEXT()
     /* SLO zp,X (undoc) */
-        case (0x17<<3)|0: _SA(c->PC++);break;
-        case (0x17<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x17<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x17<<3)|3: c->AD=_GD();_WR();break;
-        case (0x17<<3)|4: c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();break;
-        case (0x17<<3)|5: _FETCH();break;
-        case (0x17<<3)|6: assert(false);break;
-        case (0x17<<3)|7: assert(false);break;
+        _OP(0x17,0): _SA(c->PC++);_NEXT()
+        _OP(0x17,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x17,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x17,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x17,4): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x17,5): _FETCH();_NEXT()
+        _OP(0x17,6): assert(false);_NEXT()
+        _OP(0x17,7): assert(false);_NEXT()
     /* CLC  */
-        case (0x18<<3)|0: _SA(c->PC);break;
-        case (0x18<<3)|1: c->P&=~0x1;_FETCH();break;
-        case (0x18<<3)|2: assert(false);break;
-        case (0x18<<3)|3: assert(false);break;
-        case (0x18<<3)|4: assert(false);break;
-        case (0x18<<3)|5: assert(false);break;
-        case (0x18<<3)|6: assert(false);break;
-        case (0x18<<3)|7: assert(false);break;
+        _OP(0x18,0): _SA(c->PC);_NEXT()
+        _OP(0x18,1): c->P&=~0x1;_FETCH();_NEXT()
+        _OP(0x18,2): assert(false);_NEXT()
+        _OP(0x18,3): assert(false);_NEXT()
+        _OP(0x18,4): assert(false);_NEXT()
+        _OP(0x18,5): assert(false);_NEXT()
+        _OP(0x18,6): assert(false);_NEXT()
+        _OP(0x18,7): assert(false);_NEXT()
     /* ORA abs,Y */
-        case (0x19<<3)|0: _SA(c->PC++);break;
-        case (0x19<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x19<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0x19<<3)|3: _SA(c->AD+c->Y);break;
-        case (0x19<<3)|4: c->A|=_GD();_NZ(c->A);_FETCH();break;
-        case (0x19<<3)|5: assert(false);break;
-        case (0x19<<3)|6: assert(false);break;
-        case (0x19<<3)|7: assert(false);break;
+        _OP(0x19,0): _SA(c->PC++);_NEXT()
+        _OP(0x19,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x19,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x19,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x19,4): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x19,5): assert(false);_NEXT()
+        _OP(0x19,6): assert(false);_NEXT()
+        _OP(0x19,7): assert(false);_NEXT()
     /* NOP  (undoc) */
-        case (0x1A<<3)|0: _SA(c->PC);break;
-        case (0x1A<<3)|1: _FETCH();break;
-        case (0x1A<<3)|2: assert(false);break;
-        case (0x1A<<3)|3: assert(false);break;
-        case (0x1A<<3)|4: assert(false);break;
-        case (0x1A<<3)|5: assert(false);break;
-        case (0x1A<<3)|6: assert(false);break;
-        case (0x1A<<3)|7: assert(false);break;
+        _OP(0x1A,0): _SA(c->PC);_NEXT()
+        _OP(0x1A,1): _FETCH();_NEXT()
+        _OP(0x1A,2): assert(false);_NEXT()
+        _OP(0x1A,3): assert(false);_NEXT()
+        _OP(0x1A,4): assert(false);_NEXT()
+        _OP(0x1A,5): assert(false);_NEXT()
+        _OP(0x1A,6): assert(false);_NEXT()
+        _OP(0x1A,7): assert(false);_NEXT()
     /* SLO abs,Y (undoc) */
-        case (0x1B<<3)|0: _SA(c->PC++);break;
-        case (0x1B<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x1B<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x1B<<3)|3: _SA(c->AD+c->Y);break;
-        case (0x1B<<3)|4: c->AD=_GD();_WR();break;
-        case (0x1B<<3)|5: c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();break;
-        case (0x1B<<3)|6: _FETCH();break;
-        case (0x1B<<3)|7: assert(false);break;
+        _OP(0x1B,0): _SA(c->PC++);_NEXT()
+        _OP(0x1B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x1B,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x1B,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x1B,5): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x1B,6): _FETCH();_NEXT()
+        _OP(0x1B,7): assert(false);_NEXT()
     /* NOP abs,X (undoc) */
-        case (0x1C<<3)|0: _SA(c->PC++);break;
-        case (0x1C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x1C<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0x1C<<3)|3: _SA(c->AD+c->X);break;
-        case (0x1C<<3)|4: _FETCH();break;
-        case (0x1C<<3)|5: assert(false);break;
-        case (0x1C<<3)|6: assert(false);break;
-        case (0x1C<<3)|7: assert(false);break;
+        _OP(0x1C,0): _SA(c->PC++);_NEXT()
+        _OP(0x1C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x1C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1C,4): _FETCH();_NEXT()
+        _OP(0x1C,5): assert(false);_NEXT()
+        _OP(0x1C,6): assert(false);_NEXT()
+        _OP(0x1C,7): assert(false);_NEXT()
     /* ORA abs,X */
-        case (0x1D<<3)|0: _SA(c->PC++);break;
-        case (0x1D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x1D<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0x1D<<3)|3: _SA(c->AD+c->X);break;
-        case (0x1D<<3)|4: c->A|=_GD();_NZ(c->A);_FETCH();break;
-        case (0x1D<<3)|5: assert(false);break;
-        case (0x1D<<3)|6: assert(false);break;
-        case (0x1D<<3)|7: assert(false);break;
+        _OP(0x1D,0): _SA(c->PC++);_NEXT()
+        _OP(0x1D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x1D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1D,4): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x1D,5): assert(false);_NEXT()
+        _OP(0x1D,6): assert(false);_NEXT()
+        _OP(0x1D,7): assert(false);_NEXT()
     /* ASL abs,X */
-        case (0x1E<<3)|0: _SA(c->PC++);break;
-        case (0x1E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x1E<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x1E<<3)|3: _SA(c->AD+c->X);break;
-        case (0x1E<<3)|4: c->AD=_GD();_WR();break;
-        case (0x1E<<3)|5: _SD(_m6502_asl(c,c->AD));_WR();break;
-        case (0x1E<<3)|6: _FETCH();break;
-        case (0x1E<<3)|7: assert(false);break;
+        _OP(0x1E,0): _SA(c->PC++);_NEXT()
+        _OP(0x1E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x1E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1E,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x1E,5): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x1E,6): _FETCH();_NEXT()
+        _OP(0x1E,7): assert(false);_NEXT()
     /* SLO abs,X (undoc) */
-        case (0x1F<<3)|0: _SA(c->PC++);break;
-        case (0x1F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x1F<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x1F<<3)|3: _SA(c->AD+c->X);break;
-        case (0x1F<<3)|4: c->AD=_GD();_WR();break;
-        case (0x1F<<3)|5: c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();break;
-        case (0x1F<<3)|6: _FETCH();break;
-        case (0x1F<<3)|7: assert(false);break;
+        _OP(0x1F,0): _SA(c->PC++);_NEXT()
+        _OP(0x1F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x1F,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1F,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x1F,5): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x1F,6): _FETCH();_NEXT()
+        _OP(0x1F,7): assert(false);_NEXT()
     /* JSR  */
-        case (0x20<<3)|0: _SA(c->PC++);break;
-        case (0x20<<3)|1: _SA(0x0100|c->S);c->AD=_GD();break;
-        case (0x20<<3)|2: _SAD(0x0100|c->S--,c->PC>>8);_WR();break;
-        case (0x20<<3)|3: _SAD(0x0100|c->S--,c->PC);_WR();break;
-        case (0x20<<3)|4: _SA(c->PC);break;
-        case (0x20<<3)|5: c->PC=(_GD()<<8)|c->AD;_FETCH();break;
-        case (0x20<<3)|6: assert(false);break;
-        case (0x20<<3)|7: assert(false);break;
+        _OP(0x20,0): _SA(c->PC++);_NEXT()
+        _OP(0x20,1): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x20,2): _SAD(0x0100|c->S--,c->PC>>8);_WR();_NEXT()
+        _OP(0x20,3): _SAD(0x0100|c->S--,c->PC);_WR();_NEXT()
+        _OP(0x20,4): _SA(c->PC);_NEXT()
+        _OP(0x20,5): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x20,6): assert(false);_NEXT()
+        _OP(0x20,7): assert(false);_NEXT()
     /* AND (zp,X) */
-        case (0x21<<3)|0: _SA(c->PC++);break;
-        case (0x21<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x21<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x21<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x21<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0x21<<3)|5: c->A&=_GD();_NZ(c->A);_FETCH();break;
-        case (0x21<<3)|6: assert(false);break;
-        case (0x21<<3)|7: assert(false);break;
+        _OP(0x21,0): _SA(c->PC++);_NEXT()
+        _OP(0x21,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x21,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x21,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x21,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x21,5): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x21,6): assert(false);_NEXT()
+        _OP(0x21,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x22<<3)|0: _SA(c->PC);break;
-        case (0x22<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x22<<3)|2: assert(false);break;
-        case (0x22<<3)|3: assert(false);break;
-        case (0x22<<3)|4: assert(false);break;
-        case (0x22<<3)|5: assert(false);break;
-        case (0x22<<3)|6: assert(false);break;
-        case (0x22<<3)|7: assert(false);break;
+        _OP(0x22,0): _SA(c->PC);_NEXT()
+        _OP(0x22,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x22,2): assert(false);_NEXT()
+        _OP(0x22,3): assert(false);_NEXT()
+        _OP(0x22,4): assert(false);_NEXT()
+        _OP(0x22,5): assert(false);_NEXT()
+        _OP(0x22,6): assert(false);_NEXT()
+        _OP(0x22,7): assert(false);_NEXT()
     /* RLA (zp,X) (undoc) */
-        case (0x23<<3)|0: _SA(c->PC++);break;
-        case (0x23<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x23<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x23<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x23<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0x23<<3)|5: c->AD=_GD();_WR();break;
-        case (0x23<<3)|6: c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();break;
-        case (0x23<<3)|7: _FETCH();break;
+        _OP(0x23,0): _SA(c->PC++);_NEXT()
+        _OP(0x23,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x23,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x23,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x23,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x23,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x23,6): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x23,7): _FETCH();_NEXT()
     /* BIT zp */
-        case (0x24<<3)|0: _SA(c->PC++);break;
-        case (0x24<<3)|1: _SA(_GD());break;
-        case (0x24<<3)|2: _m6502_bit(c,_GD());_FETCH();break;
-        case (0x24<<3)|3: assert(false);break;
-        case (0x24<<3)|4: assert(false);break;
-        case (0x24<<3)|5: assert(false);break;
-        case (0x24<<3)|6: assert(false);break;
-        case (0x24<<3)|7: assert(false);break;
+        _OP(0x24,0): _SA(c->PC++);_NEXT()
+        _OP(0x24,1): _SA(_GD());_NEXT()
+        _OP(0x24,2): _m6502_bit(c,_GD());_FETCH();_NEXT()
+        _OP(0x24,3): assert(false);_NEXT()
+        _OP(0x24,4): assert(false);_NEXT()
+        _OP(0x24,5): assert(false);_NEXT()
+        _OP(0x24,6): assert(false);_NEXT()
+        _OP(0x24,7): assert(false);_NEXT()
     /* AND zp */
-        case (0x25<<3)|0: _SA(c->PC++);break;
-        case (0x25<<3)|1: _SA(_GD());break;
-        case (0x25<<3)|2: c->A&=_GD();_NZ(c->A);_FETCH();break;
-        case (0x25<<3)|3: assert(false);break;
-        case (0x25<<3)|4: assert(false);break;
-        case (0x25<<3)|5: assert(false);break;
-        case (0x25<<3)|6: assert(false);break;
-        case (0x25<<3)|7: assert(false);break;
+        _OP(0x25,0): _SA(c->PC++);_NEXT()
+        _OP(0x25,1): _SA(_GD());_NEXT()
+        _OP(0x25,2): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x25,3): assert(false);_NEXT()
+        _OP(0x25,4): assert(false);_NEXT()
+        _OP(0x25,5): assert(false);_NEXT()
+        _OP(0x25,6): assert(false);_NEXT()
+        _OP(0x25,7): assert(false);_NEXT()
     /* ROL zp */
-        case (0x26<<3)|0: _SA(c->PC++);break;
-        case (0x26<<3)|1: _SA(_GD());break;
-        case (0x26<<3)|2: c->AD=_GD();_WR();break;
-        case (0x26<<3)|3: _SD(_m6502_rol(c,c->AD));_WR();break;
-        case (0x26<<3)|4: _FETCH();break;
-        case (0x26<<3)|5: assert(false);break;
-        case (0x26<<3)|6: assert(false);break;
-        case (0x26<<3)|7: assert(false);break;
+        _OP(0x26,0): _SA(c->PC++);_NEXT()
+        _OP(0x26,1): _SA(_GD());_NEXT()
+        _OP(0x26,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x26,3): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x26,4): _FETCH();_NEXT()
+        _OP(0x26,5): assert(false);_NEXT()
+        _OP(0x26,6): assert(false);_NEXT()
+        _OP(0x26,7): assert(false);_NEXT()
     /* RLA zp (undoc) */
-        case (0x27<<3)|0: _SA(c->PC++);break;
-        case (0x27<<3)|1: _SA(_GD());break;
-        case (0x27<<3)|2: c->AD=_GD();_WR();break;
-        case (0x27<<3)|3: c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();break;
-        case (0x27<<3)|4: _FETCH();break;
-        case (0x27<<3)|5: assert(false);break;
-        case (0x27<<3)|6: assert(false);break;
-        case (0x27<<3)|7: assert(false);break;
+        _OP(0x27,0): _SA(c->PC++);_NEXT()
+        _OP(0x27,1): _SA(_GD());_NEXT()
+        _OP(0x27,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x27,3): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x27,4): _FETCH();_NEXT()
+        _OP(0x27,5): assert(false);_NEXT()
+        _OP(0x27,6): assert(false);_NEXT()
+        _OP(0x27,7): assert(false);_NEXT()
     /* PLP  */
-        case (0x28<<3)|0: _SA(c->PC);break;
-        case (0x28<<3)|1: _SA(0x0100|c->S++);break;
-        case (0x28<<3)|2: _SA(0x0100|c->S);break;
-        case (0x28<<3)|3: c->P=(_GD()|M6502_BF)&~M6502_XF;_FETCH();break;
-        case (0x28<<3)|4: assert(false);break;
-        case (0x28<<3)|5: assert(false);break;
-        case (0x28<<3)|6: assert(false);break;
-        case (0x28<<3)|7: assert(false);break;
+        _OP(0x28,0): _SA(c->PC);_NEXT()
+        _OP(0x28,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x28,2): _SA(0x0100|c->S);_NEXT()
+        _OP(0x28,3): c->P=(_GD()|M6502_BF)&~M6502_XF;_FETCH();_NEXT()
+        _OP(0x28,4): assert(false);_NEXT()
+        _OP(0x28,5): assert(false);_NEXT()
+        _OP(0x28,6): assert(false);_NEXT()
+        _OP(0x28,7): assert(false);_NEXT()
     /* AND # */
-        case (0x29<<3)|0: _SA(c->PC++);break;
-        case (0x29<<3)|1: c->A&=_GD();_NZ(c->A);_FETCH();break;
-        case (0x29<<3)|2: assert(false);break;
-        case (0x29<<3)|3: assert(false);break;
-        case (0x29<<3)|4: assert(false);break;
-        case (0x29<<3)|5: assert(false);break;
-        case (0x29<<3)|6: assert(false);break;
-        case (0x29<<3)|7: assert(false);break;
+        _OP(0x29,0): _SA(c->PC++);_NEXT()
+        _OP(0x29,1): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x29,2): assert(false);_NEXT()
+        _OP(0x29,3): assert(false);_NEXT()
+        _OP(0x29,4): assert(false);_NEXT()
+        _OP(0x29,5): assert(false);_NEXT()
+        _OP(0x29,6): assert(false);_NEXT()
+        _OP(0x29,7): assert(false);_NEXT()
     /* ROLA  */
-        case (0x2A<<3)|0: _SA(c->PC);break;
-        case (0x2A<<3)|1: c->A=_m6502_rol(c,c->A);_FETCH();break;
-        case (0x2A<<3)|2: assert(false);break;
-        case (0x2A<<3)|3: assert(false);break;
-        case (0x2A<<3)|4: assert(false);break;
-        case (0x2A<<3)|5: assert(false);break;
-        case (0x2A<<3)|6: assert(false);break;
-        case (0x2A<<3)|7: assert(false);break;
+        _OP(0x2A,0): _SA(c->PC);_NEXT()
+        _OP(0x2A,1): c->A=_m6502_rol(c,c->A);_FETCH();_NEXT()
+        _OP(0x2A,2): assert(false);_NEXT()
+        _OP(0x2A,3): assert(false);_NEXT()
+        _OP(0x2A,4): assert(false);_NEXT()
+        _OP(0x2A,5): assert(false);_NEXT()
+        _OP(0x2A,6): assert(false);_NEXT()
+        _OP(0x2A,7): assert(false);_NEXT()
     /* ANC # (undoc) */
-        case (0x2B<<3)|0: _SA(c->PC++);break;
-        case (0x2B<<3)|1: c->A&=_GD();_NZ(c->A);if(c->A&0x80){c->P|=M6502_CF;}else{c->P&=~M6502_CF;}_FETCH();break;
-        case (0x2B<<3)|2: assert(false);break;
-        case (0x2B<<3)|3: assert(false);break;
-        case (0x2B<<3)|4: assert(false);break;
-        case (0x2B<<3)|5: assert(false);break;
-        case (0x2B<<3)|6: assert(false);break;
-        case (0x2B<<3)|7: assert(false);break;
+        _OP(0x2B,0): _SA(c->PC++);_NEXT()
+        _OP(0x2B,1): c->A&=_GD();_NZ(c->A);if(c->A&0x80){c->P|=M6502_CF;}else{c->P&=~M6502_CF;}_FETCH();_NEXT()
+        _OP(0x2B,2): assert(false);_NEXT()
+        _OP(0x2B,3): assert(false);_NEXT()
+        _OP(0x2B,4): assert(false);_NEXT()
+        _OP(0x2B,5): assert(false);_NEXT()
+        _OP(0x2B,6): assert(false);_NEXT()
+        _OP(0x2B,7): assert(false);_NEXT()
     /* BIT abs */
-        case (0x2C<<3)|0: _SA(c->PC++);break;
-        case (0x2C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x2C<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x2C<<3)|3: _m6502_bit(c,_GD());_FETCH();break;
-        case (0x2C<<3)|4: assert(false);break;
-        case (0x2C<<3)|5: assert(false);break;
-        case (0x2C<<3)|6: assert(false);break;
-        case (0x2C<<3)|7: assert(false);break;
+        _OP(0x2C,0): _SA(c->PC++);_NEXT()
+        _OP(0x2C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2C,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2C,3): _m6502_bit(c,_GD());_FETCH();_NEXT()
+        _OP(0x2C,4): assert(false);_NEXT()
+        _OP(0x2C,5): assert(false);_NEXT()
+        _OP(0x2C,6): assert(false);_NEXT()
+        _OP(0x2C,7): assert(false);_NEXT()
     /* AND abs */
-        case (0x2D<<3)|0: _SA(c->PC++);break;
-        case (0x2D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x2D<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x2D<<3)|3: c->A&=_GD();_NZ(c->A);_FETCH();break;
-        case (0x2D<<3)|4: assert(false);break;
-        case (0x2D<<3)|5: assert(false);break;
-        case (0x2D<<3)|6: assert(false);break;
-        case (0x2D<<3)|7: assert(false);break;
+        _OP(0x2D,0): _SA(c->PC++);_NEXT()
+        _OP(0x2D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2D,3): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x2D,4): assert(false);_NEXT()
+        _OP(0x2D,5): assert(false);_NEXT()
+        _OP(0x2D,6): assert(false);_NEXT()
+        _OP(0x2D,7): assert(false);_NEXT()
     /* ROL abs */
-        case (0x2E<<3)|0: _SA(c->PC++);break;
-        case (0x2E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x2E<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x2E<<3)|3: c->AD=_GD();_WR();break;
-        case (0x2E<<3)|4: _SD(_m6502_rol(c,c->AD));_WR();break;
-        case (0x2E<<3)|5: _FETCH();break;
-        case (0x2E<<3)|6: assert(false);break;
-        case (0x2E<<3)|7: assert(false);break;
+        _OP(0x2E,0): _SA(c->PC++);_NEXT()
+        _OP(0x2E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2E,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x2E,4): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x2E,5): _FETCH();_NEXT()
+        _OP(0x2E,6): assert(false);_NEXT()
+        _OP(0x2E,7): assert(false);_NEXT()
     /* RLA abs (undoc) */
-        case (0x2F<<3)|0: _SA(c->PC++);break;
-        case (0x2F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x2F<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x2F<<3)|3: c->AD=_GD();_WR();break;
-        case (0x2F<<3)|4: c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();break;
-        case (0x2F<<3)|5: _FETCH();break;
-        case (0x2F<<3)|6: assert(false);break;
-        case (0x2F<<3)|7: assert(false);break;
+        _OP(0x2F,0): _SA(c->PC++);_NEXT()
+        _OP(0x2F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2F,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2F,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x2F,4): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x2F,5): _FETCH();_NEXT()
+        _OP(0x2F,6): assert(false);_NEXT()
+        _OP(0x2F,7): assert(false);_NEXT()
     /* BMI # */
-        case (0x30<<3)|0: _SA(c->PC++);break;
-        case (0x30<<3)|1: _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x80)!=0x80){_FETCH();};break;
-        case (0x30<<3)|2: _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};break;
-        case (0x30<<3)|3: c->PC=c->AD;_FETCH();break;
-        case (0x30<<3)|4: assert(false);break;
-        case (0x30<<3)|5: assert(false);break;
-        case (0x30<<3)|6: assert(false);break;
-        case (0x30<<3)|7: assert(false);break;
+        _OP(0x30,0): _SA(c->PC++);_NEXT()
+        _OP(0x30,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x80)!=0x80){_FETCH();};_NEXT()
+        _OP(0x30,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x30,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x30,4): assert(false);_NEXT()
+        _OP(0x30,5): assert(false);_NEXT()
+        _OP(0x30,6): assert(false);_NEXT()
+        _OP(0x30,7): assert(false);_NEXT()
     /* AND (zp),Y */
-        case (0x31<<3)|0: _SA(c->PC++);break;
-        case (0x31<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x31<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x31<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0x31<<3)|4: _SA(c->AD+c->Y);break;
-        case (0x31<<3)|5: c->A&=_GD();_NZ(c->A);_FETCH();break;
-        case (0x31<<3)|6: assert(false);break;
-        case (0x31<<3)|7: assert(false);break;
+        _OP(0x31,0): _SA(c->PC++);_NEXT()
+        _OP(0x31,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x31,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x31,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x31,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x31,5): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x31,6): assert(false);_NEXT()
+        _OP(0x31,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x32<<3)|0: _SA(c->PC);break;
-        case (0x32<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x32<<3)|2: assert(false);break;
-        case (0x32<<3)|3: assert(false);break;
-        case (0x32<<3)|4: assert(false);break;
-        case (0x32<<3)|5: assert(false);break;
-        case (0x32<<3)|6: assert(false);break;
-        case (0x32<<3)|7: assert(false);break;
+        _OP(0x32,0): _SA(c->PC);_NEXT()
+        _OP(0x32,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x32,2): assert(false);_NEXT()
+        _OP(0x32,3): assert(false);_NEXT()
+        _OP(0x32,4): assert(false);_NEXT()
+        _OP(0x32,5): assert(false);_NEXT()
+        _OP(0x32,6): assert(false);_NEXT()
+        _OP(0x32,7): assert(false);_NEXT()
     /* RLA (zp),Y (undoc) */
-        case (0x33<<3)|0: _SA(c->PC++);break;
-        case (0x33<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x33<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x33<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x33<<3)|4: _SA(c->AD+c->Y);break;
-        case (0x33<<3)|5: c->AD=_GD();_WR();break;
-        case (0x33<<3)|6: c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();break;
-        case (0x33<<3)|7: _FETCH();break;
+        _OP(0x33,0): _SA(c->PC++);_NEXT()
+        _OP(0x33,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x33,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x33,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x33,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x33,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x33,6): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x33,7): _FETCH();_NEXT()
     /* NOP zp,X (undoc) */
-        case (0x34<<3)|0: _SA(c->PC++);break;
-        case (0x34<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x34<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x34<<3)|3: _FETCH();break;
-        case (0x34<<3)|4: assert(false);break;
-        case (0x34<<3)|5: assert(false);break;
-        case (0x34<<3)|6: assert(false);break;
-        case (0x34<<3)|7: assert(false);break;
+        _OP(0x34,0): _SA(c->PC++);_NEXT()
+        _OP(0x34,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x34,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x34,3): _FETCH();_NEXT()
+        _OP(0x34,4): assert(false);_NEXT()
+        _OP(0x34,5): assert(false);_NEXT()
+        _OP(0x34,6): assert(false);_NEXT()
+        _OP(0x34,7): assert(false);_NEXT()
     /* AND zp,X */
-        case (0x35<<3)|0: _SA(c->PC++);break;
-        case (0x35<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x35<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x35<<3)|3: c->A&=_GD();_NZ(c->A);_FETCH();break;
-        case (0x35<<3)|4: assert(false);break;
-        case (0x35<<3)|5: assert(false);break;
-        case (0x35<<3)|6: assert(false);break;
-        case (0x35<<3)|7: assert(false);break;
+        _OP(0x35,0): _SA(c->PC++);_NEXT()
+        _OP(0x35,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x35,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x35,3): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x35,4): assert(false);_NEXT()
+        _OP(0x35,5): assert(false);_NEXT()
+        _OP(0x35,6): assert(false);_NEXT()
+        _OP(0x35,7): assert(false);_NEXT()
     /* ROL zp,X */
-        case (0x36<<3)|0: _SA(c->PC++);break;
-        case (0x36<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x36<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x36<<3)|3: c->AD=_GD();_WR();break;
-        case (0x36<<3)|4: _SD(_m6502_rol(c,c->AD));_WR();break;
-        case (0x36<<3)|5: _FETCH();break;
-        case (0x36<<3)|6: assert(false);break;
-        case (0x36<<3)|7: assert(false);break;
+        _OP(0x36,0): _SA(c->PC++);_NEXT()
+        _OP(0x36,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x36,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x36,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x36,4): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x36,5): _FETCH();_NEXT()
+        _OP(0x36,6): assert(false);_NEXT()
+        _OP(0x36,7): assert(false);_NEXT()
     /* RLA zp,X (undoc) */
-        case (0x37<<3)|0: _SA(c->PC++);break;
-        case (0x37<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x37<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x37<<3)|3: c->AD=_GD();_WR();break;
-        case (0x37<<3)|4: c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();break;
-        case (0x37<<3)|5: _FETCH();break;
-        case (0x37<<3)|6: assert(false);break;
-        case (0x37<<3)|7: assert(false);break;
+        _OP(0x37,0): _SA(c->PC++);_NEXT()
+        _OP(0x37,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x37,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x37,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x37,4): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x37,5): _FETCH();_NEXT()
+        _OP(0x37,6): assert(false);_NEXT()
+        _OP(0x37,7): assert(false);_NEXT()
     /* SEC  */
-        case (0x38<<3)|0: _SA(c->PC);break;
-        case (0x38<<3)|1: c->P|=0x1;_FETCH();break;
-        case (0x38<<3)|2: assert(false);break;
-        case (0x38<<3)|3: assert(false);break;
-        case (0x38<<3)|4: assert(false);break;
-        case (0x38<<3)|5: assert(false);break;
-        case (0x38<<3)|6: assert(false);break;
-        case (0x38<<3)|7: assert(false);break;
+        _OP(0x38,0): _SA(c->PC);_NEXT()
+        _OP(0x38,1): c->P|=0x1;_FETCH();_NEXT()
+        _OP(0x38,2): assert(false);_NEXT()
+        _OP(0x38,3): assert(false);_NEXT()
+        _OP(0x38,4): assert(false);_NEXT()
+        _OP(0x38,5): assert(false);_NEXT()
+        _OP(0x38,6): assert(false);_NEXT()
+        _OP(0x38,7): assert(false);_NEXT()
     /* AND abs,Y */
-        case (0x39<<3)|0: _SA(c->PC++);break;
-        case (0x39<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x39<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0x39<<3)|3: _SA(c->AD+c->Y);break;
-        case (0x39<<3)|4: c->A&=_GD();_NZ(c->A);_FETCH();break;
-        case (0x39<<3)|5: assert(false);break;
-        case (0x39<<3)|6: assert(false);break;
-        case (0x39<<3)|7: assert(false);break;
+        _OP(0x39,0): _SA(c->PC++);_NEXT()
+        _OP(0x39,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x39,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x39,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x39,4): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x39,5): assert(false);_NEXT()
+        _OP(0x39,6): assert(false);_NEXT()
+        _OP(0x39,7): assert(false);_NEXT()
     /* NOP  (undoc) */
-        case (0x3A<<3)|0: _SA(c->PC);break;
-        case (0x3A<<3)|1: _FETCH();break;
-        case (0x3A<<3)|2: assert(false);break;
-        case (0x3A<<3)|3: assert(false);break;
-        case (0x3A<<3)|4: assert(false);break;
-        case (0x3A<<3)|5: assert(false);break;
-        case (0x3A<<3)|6: assert(false);break;
-        case (0x3A<<3)|7: assert(false);break;
+        _OP(0x3A,0): _SA(c->PC);_NEXT()
+        _OP(0x3A,1): _FETCH();_NEXT()
+        _OP(0x3A,2): assert(false);_NEXT()
+        _OP(0x3A,3): assert(false);_NEXT()
+        _OP(0x3A,4): assert(false);_NEXT()
+        _OP(0x3A,5): assert(false);_NEXT()
+        _OP(0x3A,6): assert(false);_NEXT()
+        _OP(0x3A,7): assert(false);_NEXT()
     /* RLA abs,Y (undoc) */
-        case (0x3B<<3)|0: _SA(c->PC++);break;
-        case (0x3B<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x3B<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x3B<<3)|3: _SA(c->AD+c->Y);break;
-        case (0x3B<<3)|4: c->AD=_GD();_WR();break;
-        case (0x3B<<3)|5: c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();break;
-        case (0x3B<<3)|6: _FETCH();break;
-        case (0x3B<<3)|7: assert(false);break;
+        _OP(0x3B,0): _SA(c->PC++);_NEXT()
+        _OP(0x3B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x3B,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x3B,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x3B,5): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x3B,6): _FETCH();_NEXT()
+        _OP(0x3B,7): assert(false);_NEXT()
     /* NOP abs,X (undoc) */
-        case (0x3C<<3)|0: _SA(c->PC++);break;
-        case (0x3C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x3C<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0x3C<<3)|3: _SA(c->AD+c->X);break;
-        case (0x3C<<3)|4: _FETCH();break;
-        case (0x3C<<3)|5: assert(false);break;
-        case (0x3C<<3)|6: assert(false);break;
-        case (0x3C<<3)|7: assert(false);break;
+        _OP(0x3C,0): _SA(c->PC++);_NEXT()
+        _OP(0x3C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x3C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3C,4): _FETCH();_NEXT()
+        _OP(0x3C,5): assert(false);_NEXT()
+        _OP(0x3C,6): assert(false);_NEXT()
+        _OP(0x3C,7): assert(false);_NEXT()
     /* AND abs,X */
-        case (0x3D<<3)|0: _SA(c->PC++);break;
-        case (0x3D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x3D<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0x3D<<3)|3: _SA(c->AD+c->X);break;
-        case (0x3D<<3)|4: c->A&=_GD();_NZ(c->A);_FETCH();break;
-        case (0x3D<<3)|5: assert(false);break;
-        case (0x3D<<3)|6: assert(false);break;
-        case (0x3D<<3)|7: assert(false);break;
+        _OP(0x3D,0): _SA(c->PC++);_NEXT()
+        _OP(0x3D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x3D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3D,4): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x3D,5): assert(false);_NEXT()
+        _OP(0x3D,6): assert(false);_NEXT()
+        _OP(0x3D,7): assert(false);_NEXT()
     /* ROL abs,X */
-        case (0x3E<<3)|0: _SA(c->PC++);break;
-        case (0x3E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x3E<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x3E<<3)|3: _SA(c->AD+c->X);break;
-        case (0x3E<<3)|4: c->AD=_GD();_WR();break;
-        case (0x3E<<3)|5: _SD(_m6502_rol(c,c->AD));_WR();break;
-        case (0x3E<<3)|6: _FETCH();break;
-        case (0x3E<<3)|7: assert(false);break;
+        _OP(0x3E,0): _SA(c->PC++);_NEXT()
+        _OP(0x3E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x3E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3E,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x3E,5): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x3E,6): _FETCH();_NEXT()
+        _OP(0x3E,7): assert(false);_NEXT()
     /* RLA abs,X (undoc) */
-        case (0x3F<<3)|0: _SA(c->PC++);break;
-        case (0x3F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x3F<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x3F<<3)|3: _SA(c->AD+c->X);break;
-        case (0x3F<<3)|4: c->AD=_GD();_WR();break;
-        case (0x3F<<3)|5: c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();break;
-        case (0x3F<<3)|6: _FETCH();break;
-        case (0x3F<<3)|7: assert(false);break;
+        _OP(0x3F,0): _SA(c->PC++);_NEXT()
+        _OP(0x3F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x3F,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3F,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x3F,5): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x3F,6): _FETCH();_NEXT()
+        _OP(0x3F,7): assert(false);_NEXT()
     /* RTI  */
-        case (0x40<<3)|0: _SA(c->PC);break;
-        case (0x40<<3)|1: _SA(0x0100|c->S++);break;
-        case (0x40<<3)|2: _SA(0x0100|c->S++);break;
-        case (0x40<<3)|3: _SA(0x0100|c->S++);c->P=(_GD()|M6502_BF)&~M6502_XF;break;
-        case (0x40<<3)|4: _SA(0x0100|c->S);c->AD=_GD();break;
-        case (0x40<<3)|5: c->PC=(_GD()<<8)|c->AD;_FETCH();break;
-        case (0x40<<3)|6: assert(false);break;
-        case (0x40<<3)|7: assert(false);break;
+        _OP(0x40,0): _SA(c->PC);_NEXT()
+        _OP(0x40,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x40,2): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x40,3): _SA(0x0100|c->S++);c->P=(_GD()|M6502_BF)&~M6502_XF;_NEXT()
+        _OP(0x40,4): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x40,5): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x40,6): assert(false);_NEXT()
+        _OP(0x40,7): assert(false);_NEXT()
     /* EOR (zp,X) */
-        case (0x41<<3)|0: _SA(c->PC++);break;
-        case (0x41<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x41<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x41<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x41<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0x41<<3)|5: c->A^=_GD();_NZ(c->A);_FETCH();break;
-        case (0x41<<3)|6: assert(false);break;
-        case (0x41<<3)|7: assert(false);break;
+        _OP(0x41,0): _SA(c->PC++);_NEXT()
+        _OP(0x41,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x41,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x41,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x41,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x41,5): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x41,6): assert(false);_NEXT()
+        _OP(0x41,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x42<<3)|0: _SA(c->PC);break;
-        case (0x42<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x42<<3)|2: assert(false);break;
-        case (0x42<<3)|3: assert(false);break;
-        case (0x42<<3)|4: assert(false);break;
-        case (0x42<<3)|5: assert(false);break;
-        case (0x42<<3)|6: assert(false);break;
-        case (0x42<<3)|7: assert(false);break;
+        _OP(0x42,0): _SA(c->PC);_NEXT()
+        _OP(0x42,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x42,2): assert(false);_NEXT()
+        _OP(0x42,3): assert(false);_NEXT()
+        _OP(0x42,4): assert(false);_NEXT()
+        _OP(0x42,5): assert(false);_NEXT()
+        _OP(0x42,6): assert(false);_NEXT()
+        _OP(0x42,7): assert(false);_NEXT()
     /* SRE (zp,X) (undoc) */
-        case (0x43<<3)|0: _SA(c->PC++);break;
-        case (0x43<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x43<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x43<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x43<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0x43<<3)|5: c->AD=_GD();_WR();break;
-        case (0x43<<3)|6: c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();break;
-        case (0x43<<3)|7: _FETCH();break;
+        _OP(0x43,0): _SA(c->PC++);_NEXT()
+        _OP(0x43,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x43,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x43,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x43,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x43,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x43,6): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x43,7): _FETCH();_NEXT()
     /* NOP zp (undoc) */
-        case (0x44<<3)|0: _SA(c->PC++);break;
-        case (0x44<<3)|1: _SA(_GD());break;
-        case (0x44<<3)|2: _FETCH();break;
-        case (0x44<<3)|3: assert(false);break;
-        case (0x44<<3)|4: assert(false);break;
-        case (0x44<<3)|5: assert(false);break;
-        case (0x44<<3)|6: assert(false);break;
-        case (0x44<<3)|7: assert(false);break;
+        _OP(0x44,0): _SA(c->PC++);_NEXT()
+        _OP(0x44,1): _SA(_GD());_NEXT()
+        _OP(0x44,2): _FETCH();_NEXT()
+        _OP(0x44,3): assert(false);_NEXT()
+        _OP(0x44,4): assert(false);_NEXT()
+        _OP(0x44,5): assert(false);_NEXT()
+        _OP(0x44,6): assert(false);_NEXT()
+        _OP(0x44,7): assert(false);_NEXT()
     /* EOR zp */
-        case (0x45<<3)|0: _SA(c->PC++);break;
-        case (0x45<<3)|1: _SA(_GD());break;
-        case (0x45<<3)|2: c->A^=_GD();_NZ(c->A);_FETCH();break;
-        case (0x45<<3)|3: assert(false);break;
-        case (0x45<<3)|4: assert(false);break;
-        case (0x45<<3)|5: assert(false);break;
-        case (0x45<<3)|6: assert(false);break;
-        case (0x45<<3)|7: assert(false);break;
+        _OP(0x45,0): _SA(c->PC++);_NEXT()
+        _OP(0x45,1): _SA(_GD());_NEXT()
+        _OP(0x45,2): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x45,3): assert(false);_NEXT()
+        _OP(0x45,4): assert(false);_NEXT()
+        _OP(0x45,5): assert(false);_NEXT()
+        _OP(0x45,6): assert(false);_NEXT()
+        _OP(0x45,7): assert(false);_NEXT()
     /* LSR zp */
-        case (0x46<<3)|0: _SA(c->PC++);break;
-        case (0x46<<3)|1: _SA(_GD());break;
-        case (0x46<<3)|2: c->AD=_GD();_WR();break;
-        case (0x46<<3)|3: _SD(_m6502_lsr(c,c->AD));_WR();break;
-        case (0x46<<3)|4: _FETCH();break;
-        case (0x46<<3)|5: assert(false);break;
-        case (0x46<<3)|6: assert(false);break;
-        case (0x46<<3)|7: assert(false);break;
+        _OP(0x46,0): _SA(c->PC++);_NEXT()
+        _OP(0x46,1): _SA(_GD());_NEXT()
+        _OP(0x46,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x46,3): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x46,4): _FETCH();_NEXT()
+        _OP(0x46,5): assert(false);_NEXT()
+        _OP(0x46,6): assert(false);_NEXT()
+        _OP(0x46,7): assert(false);_NEXT()
     /* SRE zp (undoc) */
-        case (0x47<<3)|0: _SA(c->PC++);break;
-        case (0x47<<3)|1: _SA(_GD());break;
-        case (0x47<<3)|2: c->AD=_GD();_WR();break;
-        case (0x47<<3)|3: c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();break;
-        case (0x47<<3)|4: _FETCH();break;
-        case (0x47<<3)|5: assert(false);break;
-        case (0x47<<3)|6: assert(false);break;
-        case (0x47<<3)|7: assert(false);break;
+        _OP(0x47,0): _SA(c->PC++);_NEXT()
+        _OP(0x47,1): _SA(_GD());_NEXT()
+        _OP(0x47,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x47,3): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x47,4): _FETCH();_NEXT()
+        _OP(0x47,5): assert(false);_NEXT()
+        _OP(0x47,6): assert(false);_NEXT()
+        _OP(0x47,7): assert(false);_NEXT()
     /* PHA  */
-        case (0x48<<3)|0: _SA(c->PC);break;
-        case (0x48<<3)|1: _SAD(0x0100|c->S--,c->A);_WR();break;
-        case (0x48<<3)|2: _FETCH();break;
-        case (0x48<<3)|3: assert(false);break;
-        case (0x48<<3)|4: assert(false);break;
-        case (0x48<<3)|5: assert(false);break;
-        case (0x48<<3)|6: assert(false);break;
-        case (0x48<<3)|7: assert(false);break;
+        _OP(0x48,0): _SA(c->PC);_NEXT()
+        _OP(0x48,1): _SAD(0x0100|c->S--,c->A);_WR();_NEXT()
+        _OP(0x48,2): _FETCH();_NEXT()
+        _OP(0x48,3): assert(false);_NEXT()
+        _OP(0x48,4): assert(false);_NEXT()
+        _OP(0x48,5): assert(false);_NEXT()
+        _OP(0x48,6): assert(false);_NEXT()
+        _OP(0x48,7): assert(false);_NEXT()
     /* EOR # */
-        case (0x49<<3)|0: _SA(c->PC++);break;
-        case (0x49<<3)|1: c->A^=_GD();_NZ(c->A);_FETCH();break;
-        case (0x49<<3)|2: assert(false);break;
-        case (0x49<<3)|3: assert(false);break;
-        case (0x49<<3)|4: assert(false);break;
-        case (0x49<<3)|5: assert(false);break;
-        case (0x49<<3)|6: assert(false);break;
-        case (0x49<<3)|7: assert(false);break;
+        _OP(0x49,0): _SA(c->PC++);_NEXT()
+        _OP(0x49,1): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x49,2): assert(false);_NEXT()
+        _OP(0x49,3): assert(false);_NEXT()
+        _OP(0x49,4): assert(false);_NEXT()
+        _OP(0x49,5): assert(false);_NEXT()
+        _OP(0x49,6): assert(false);_NEXT()
+        _OP(0x49,7): assert(false);_NEXT()
     /* LSRA  */
-        case (0x4A<<3)|0: _SA(c->PC);break;
-        case (0x4A<<3)|1: c->A=_m6502_lsr(c,c->A);_FETCH();break;
-        case (0x4A<<3)|2: assert(false);break;
-        case (0x4A<<3)|3: assert(false);break;
-        case (0x4A<<3)|4: assert(false);break;
-        case (0x4A<<3)|5: assert(false);break;
-        case (0x4A<<3)|6: assert(false);break;
-        case (0x4A<<3)|7: assert(false);break;
+        _OP(0x4A,0): _SA(c->PC);_NEXT()
+        _OP(0x4A,1): c->A=_m6502_lsr(c,c->A);_FETCH();_NEXT()
+        _OP(0x4A,2): assert(false);_NEXT()
+        _OP(0x4A,3): assert(false);_NEXT()
+        _OP(0x4A,4): assert(false);_NEXT()
+        _OP(0x4A,5): assert(false);_NEXT()
+        _OP(0x4A,6): assert(false);_NEXT()
+        _OP(0x4A,7): assert(false);_NEXT()
     /* ASR # (undoc) */
-        case (0x4B<<3)|0: _SA(c->PC++);break;
-        case (0x4B<<3)|1: c->A&=_GD();c->A=_m6502_lsr(c,c->A);_FETCH();break;
-        case (0x4B<<3)|2: assert(false);break;
-        case (0x4B<<3)|3: assert(false);break;
-        case (0x4B<<3)|4: assert(false);break;
-        case (0x4B<<3)|5: assert(false);break;
-        case (0x4B<<3)|6: assert(false);break;
-        case (0x4B<<3)|7: assert(false);break;
+        _OP(0x4B,0): _SA(c->PC++);_NEXT()
+        _OP(0x4B,1): c->A&=_GD();c->A=_m6502_lsr(c,c->A);_FETCH();_NEXT()
+        _OP(0x4B,2): assert(false);_NEXT()
+        _OP(0x4B,3): assert(false);_NEXT()
+        _OP(0x4B,4): assert(false);_NEXT()
+        _OP(0x4B,5): assert(false);_NEXT()
+        _OP(0x4B,6): assert(false);_NEXT()
+        _OP(0x4B,7): assert(false);_NEXT()
     /* JMP  */
-        case (0x4C<<3)|0: _SA(c->PC++);break;
-        case (0x4C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x4C<<3)|2: c->PC=(_GD()<<8)|c->AD;_FETCH();break;
-        case (0x4C<<3)|3: assert(false);break;
-        case (0x4C<<3)|4: assert(false);break;
-        case (0x4C<<3)|5: assert(false);break;
-        case (0x4C<<3)|6: assert(false);break;
-        case (0x4C<<3)|7: assert(false);break;
+        _OP(0x4C,0): _SA(c->PC++);_NEXT()
+        _OP(0x4C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4C,2): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x4C,3): assert(false);_NEXT()
+        _OP(0x4C,4): assert(false);_NEXT()
+        _OP(0x4C,5): assert(false);_NEXT()
+        _OP(0x4C,6): assert(false);_NEXT()
+        _OP(0x4C,7): assert(false);_NEXT()
     /* EOR abs */
-        case (0x4D<<3)|0: _SA(c->PC++);break;
-        case (0x4D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x4D<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x4D<<3)|3: c->A^=_GD();_NZ(c->A);_FETCH();break;
-        case (0x4D<<3)|4: assert(false);break;
-        case (0x4D<<3)|5: assert(false);break;
-        case (0x4D<<3)|6: assert(false);break;
-        case (0x4D<<3)|7: assert(false);break;
+        _OP(0x4D,0): _SA(c->PC++);_NEXT()
+        _OP(0x4D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x4D,3): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x4D,4): assert(false);_NEXT()
+        _OP(0x4D,5): assert(false);_NEXT()
+        _OP(0x4D,6): assert(false);_NEXT()
+        _OP(0x4D,7): assert(false);_NEXT()
     /* LSR abs */
-        case (0x4E<<3)|0: _SA(c->PC++);break;
-        case (0x4E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x4E<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x4E<<3)|3: c->AD=_GD();_WR();break;
-        case (0x4E<<3)|4: _SD(_m6502_lsr(c,c->AD));_WR();break;
-        case (0x4E<<3)|5: _FETCH();break;
-        case (0x4E<<3)|6: assert(false);break;
-        case (0x4E<<3)|7: assert(false);break;
+        _OP(0x4E,0): _SA(c->PC++);_NEXT()
+        _OP(0x4E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x4E,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x4E,4): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x4E,5): _FETCH();_NEXT()
+        _OP(0x4E,6): assert(false);_NEXT()
+        _OP(0x4E,7): assert(false);_NEXT()
     /* SRE abs (undoc) */
-        case (0x4F<<3)|0: _SA(c->PC++);break;
-        case (0x4F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x4F<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x4F<<3)|3: c->AD=_GD();_WR();break;
-        case (0x4F<<3)|4: c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();break;
-        case (0x4F<<3)|5: _FETCH();break;
-        case (0x4F<<3)|6: assert(false);break;
-        case (0x4F<<3)|7: assert(false);break;
+        _OP(0x4F,0): _SA(c->PC++);_NEXT()
+        _OP(0x4F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4F,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x4F,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x4F,4): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x4F,5): _FETCH();_NEXT()
+        _OP(0x4F,6): assert(false);_NEXT()
+        _OP(0x4F,7): assert(false);_NEXT()
     /* BVC # */
-        case (0x50<<3)|0: _SA(c->PC++);break;
-        case (0x50<<3)|1: _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x40)!=0x0){_FETCH();};break;
-        case (0x50<<3)|2: _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};break;
-        case (0x50<<3)|3: c->PC=c->AD;_FETCH();break;
-        case (0x50<<3)|4: assert(false);break;
-        case (0x50<<3)|5: assert(false);break;
-        case (0x50<<3)|6: assert(false);break;
-        case (0x50<<3)|7: assert(false);break;
+        _OP(0x50,0): _SA(c->PC++);_NEXT()
+        _OP(0x50,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x40)!=0x0){_FETCH();};_NEXT()
+        _OP(0x50,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x50,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x50,4): assert(false);_NEXT()
+        _OP(0x50,5): assert(false);_NEXT()
+        _OP(0x50,6): assert(false);_NEXT()
+        _OP(0x50,7): assert(false);_NEXT()
     /* EOR (zp),Y */
-        case (0x51<<3)|0: _SA(c->PC++);break;
-        case (0x51<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x51<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x51<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0x51<<3)|4: _SA(c->AD+c->Y);break;
-        case (0x51<<3)|5: c->A^=_GD();_NZ(c->A);_FETCH();break;
-        case (0x51<<3)|6: assert(false);break;
-        case (0x51<<3)|7: assert(false);break;
+        _OP(0x51,0): _SA(c->PC++);_NEXT()
+        _OP(0x51,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x51,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x51,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x51,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x51,5): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x51,6): assert(false);_NEXT()
+        _OP(0x51,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x52<<3)|0: _SA(c->PC);break;
-        case (0x52<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x52<<3)|2: assert(false);break;
-        case (0x52<<3)|3: assert(false);break;
-        case (0x52<<3)|4: assert(false);break;
-        case (0x52<<3)|5: assert(false);break;
-        case (0x52<<3)|6: assert(false);break;
-        case (0x52<<3)|7: assert(false);break;
+        _OP(0x52,0): _SA(c->PC);_NEXT()
+        _OP(0x52,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x52,2): assert(false);_NEXT()
+        _OP(0x52,3): assert(false);_NEXT()
+        _OP(0x52,4): assert(false);_NEXT()
+        _OP(0x52,5): assert(false);_NEXT()
+        _OP(0x52,6): assert(false);_NEXT()
+        _OP(0x52,7): assert(false);_NEXT()
     /* SRE (zp),Y (undoc) */
-        case (0x53<<3)|0: _SA(c->PC++);break;
-        case (0x53<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x53<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x53<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x53<<3)|4: _SA(c->AD+c->Y);break;
-        case (0x53<<3)|5: c->AD=_GD();_WR();break;
-        case (0x53<<3)|6: c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();break;
-        case (0x53<<3)|7: _FETCH();break;
+        _OP(0x53,0): _SA(c->PC++);_NEXT()
+        _OP(0x53,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x53,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x53,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x53,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x53,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x53,6): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x53,7): _FETCH();_NEXT()
     /* NOP zp,X (undoc) */
-        case (0x54<<3)|0: _SA(c->PC++);break;
-        case (0x54<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x54<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x54<<3)|3: _FETCH();break;
-        case (0x54<<3)|4: assert(false);break;
-        case (0x54<<3)|5: assert(false);break;
-        case (0x54<<3)|6: assert(false);break;
-        case (0x54<<3)|7: assert(false);break;
+        _OP(0x54,0): _SA(c->PC++);_NEXT()
+        _OP(0x54,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x54,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x54,3): _FETCH();_NEXT()
+        _OP(0x54,4): assert(false);_NEXT()
+        _OP(0x54,5): assert(false);_NEXT()
+        _OP(0x54,6): assert(false);_NEXT()
+        _OP(0x54,7): assert(false);_NEXT()
     /* EOR zp,X */
-        case (0x55<<3)|0: _SA(c->PC++);break;
-        case (0x55<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x55<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x55<<3)|3: c->A^=_GD();_NZ(c->A);_FETCH();break;
-        case (0x55<<3)|4: assert(false);break;
-        case (0x55<<3)|5: assert(false);break;
-        case (0x55<<3)|6: assert(false);break;
-        case (0x55<<3)|7: assert(false);break;
+        _OP(0x55,0): _SA(c->PC++);_NEXT()
+        _OP(0x55,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x55,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x55,3): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x55,4): assert(false);_NEXT()
+        _OP(0x55,5): assert(false);_NEXT()
+        _OP(0x55,6): assert(false);_NEXT()
+        _OP(0x55,7): assert(false);_NEXT()
     /* LSR zp,X */
-        case (0x56<<3)|0: _SA(c->PC++);break;
-        case (0x56<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x56<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x56<<3)|3: c->AD=_GD();_WR();break;
-        case (0x56<<3)|4: _SD(_m6502_lsr(c,c->AD));_WR();break;
-        case (0x56<<3)|5: _FETCH();break;
-        case (0x56<<3)|6: assert(false);break;
-        case (0x56<<3)|7: assert(false);break;
+        _OP(0x56,0): _SA(c->PC++);_NEXT()
+        _OP(0x56,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x56,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x56,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x56,4): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x56,5): _FETCH();_NEXT()
+        _OP(0x56,6): assert(false);_NEXT()
+        _OP(0x56,7): assert(false);_NEXT()
     /* SRE zp,X (undoc) */
-        case (0x57<<3)|0: _SA(c->PC++);break;
-        case (0x57<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x57<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x57<<3)|3: c->AD=_GD();_WR();break;
-        case (0x57<<3)|4: c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();break;
-        case (0x57<<3)|5: _FETCH();break;
-        case (0x57<<3)|6: assert(false);break;
-        case (0x57<<3)|7: assert(false);break;
+        _OP(0x57,0): _SA(c->PC++);_NEXT()
+        _OP(0x57,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x57,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x57,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x57,4): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x57,5): _FETCH();_NEXT()
+        _OP(0x57,6): assert(false);_NEXT()
+        _OP(0x57,7): assert(false);_NEXT()
     /* CLI  */
-        case (0x58<<3)|0: _SA(c->PC);break;
-        case (0x58<<3)|1: c->P&=~0x4;_FETCH();break;
-        case (0x58<<3)|2: assert(false);break;
-        case (0x58<<3)|3: assert(false);break;
-        case (0x58<<3)|4: assert(false);break;
-        case (0x58<<3)|5: assert(false);break;
-        case (0x58<<3)|6: assert(false);break;
-        case (0x58<<3)|7: assert(false);break;
+        _OP(0x58,0): _SA(c->PC);_NEXT()
+        _OP(0x58,1): c->P&=~0x4;_FETCH();_NEXT()
+        _OP(0x58,2): assert(false);_NEXT()
+        _OP(0x58,3): assert(false);_NEXT()
+        _OP(0x58,4): assert(false);_NEXT()
+        _OP(0x58,5): assert(false);_NEXT()
+        _OP(0x58,6): assert(false);_NEXT()
+        _OP(0x58,7): assert(false);_NEXT()
     /* EOR abs,Y */
-        case (0x59<<3)|0: _SA(c->PC++);break;
-        case (0x59<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x59<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0x59<<3)|3: _SA(c->AD+c->Y);break;
-        case (0x59<<3)|4: c->A^=_GD();_NZ(c->A);_FETCH();break;
-        case (0x59<<3)|5: assert(false);break;
-        case (0x59<<3)|6: assert(false);break;
-        case (0x59<<3)|7: assert(false);break;
+        _OP(0x59,0): _SA(c->PC++);_NEXT()
+        _OP(0x59,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x59,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x59,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x59,4): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x59,5): assert(false);_NEXT()
+        _OP(0x59,6): assert(false);_NEXT()
+        _OP(0x59,7): assert(false);_NEXT()
     /* NOP  (undoc) */
-        case (0x5A<<3)|0: _SA(c->PC);break;
-        case (0x5A<<3)|1: _FETCH();break;
-        case (0x5A<<3)|2: assert(false);break;
-        case (0x5A<<3)|3: assert(false);break;
-        case (0x5A<<3)|4: assert(false);break;
-        case (0x5A<<3)|5: assert(false);break;
-        case (0x5A<<3)|6: assert(false);break;
-        case (0x5A<<3)|7: assert(false);break;
+        _OP(0x5A,0): _SA(c->PC);_NEXT()
+        _OP(0x5A,1): _FETCH();_NEXT()
+        _OP(0x5A,2): assert(false);_NEXT()
+        _OP(0x5A,3): assert(false);_NEXT()
+        _OP(0x5A,4): assert(false);_NEXT()
+        _OP(0x5A,5): assert(false);_NEXT()
+        _OP(0x5A,6): assert(false);_NEXT()
+        _OP(0x5A,7): assert(false);_NEXT()
     /* SRE abs,Y (undoc) */
-        case (0x5B<<3)|0: _SA(c->PC++);break;
-        case (0x5B<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x5B<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x5B<<3)|3: _SA(c->AD+c->Y);break;
-        case (0x5B<<3)|4: c->AD=_GD();_WR();break;
-        case (0x5B<<3)|5: c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();break;
-        case (0x5B<<3)|6: _FETCH();break;
-        case (0x5B<<3)|7: assert(false);break;
+        _OP(0x5B,0): _SA(c->PC++);_NEXT()
+        _OP(0x5B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x5B,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x5B,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x5B,5): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x5B,6): _FETCH();_NEXT()
+        _OP(0x5B,7): assert(false);_NEXT()
     /* NOP abs,X (undoc) */
-        case (0x5C<<3)|0: _SA(c->PC++);break;
-        case (0x5C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x5C<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0x5C<<3)|3: _SA(c->AD+c->X);break;
-        case (0x5C<<3)|4: _FETCH();break;
-        case (0x5C<<3)|5: assert(false);break;
-        case (0x5C<<3)|6: assert(false);break;
-        case (0x5C<<3)|7: assert(false);break;
+        _OP(0x5C,0): _SA(c->PC++);_NEXT()
+        _OP(0x5C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x5C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5C,4): _FETCH();_NEXT()
+        _OP(0x5C,5): assert(false);_NEXT()
+        _OP(0x5C,6): assert(false);_NEXT()
+        _OP(0x5C,7): assert(false);_NEXT()
     /* EOR abs,X */
-        case (0x5D<<3)|0: _SA(c->PC++);break;
-        case (0x5D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x5D<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0x5D<<3)|3: _SA(c->AD+c->X);break;
-        case (0x5D<<3)|4: c->A^=_GD();_NZ(c->A);_FETCH();break;
-        case (0x5D<<3)|5: assert(false);break;
-        case (0x5D<<3)|6: assert(false);break;
-        case (0x5D<<3)|7: assert(false);break;
+        _OP(0x5D,0): _SA(c->PC++);_NEXT()
+        _OP(0x5D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x5D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5D,4): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x5D,5): assert(false);_NEXT()
+        _OP(0x5D,6): assert(false);_NEXT()
+        _OP(0x5D,7): assert(false);_NEXT()
     /* LSR abs,X */
-        case (0x5E<<3)|0: _SA(c->PC++);break;
-        case (0x5E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x5E<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x5E<<3)|3: _SA(c->AD+c->X);break;
-        case (0x5E<<3)|4: c->AD=_GD();_WR();break;
-        case (0x5E<<3)|5: _SD(_m6502_lsr(c,c->AD));_WR();break;
-        case (0x5E<<3)|6: _FETCH();break;
-        case (0x5E<<3)|7: assert(false);break;
+        _OP(0x5E,0): _SA(c->PC++);_NEXT()
+        _OP(0x5E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x5E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5E,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x5E,5): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x5E,6): _FETCH();_NEXT()
+        _OP(0x5E,7): assert(false);_NEXT()
     /* SRE abs,X (undoc) */
-        case (0x5F<<3)|0: _SA(c->PC++);break;
-        case (0x5F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x5F<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x5F<<3)|3: _SA(c->AD+c->X);break;
-        case (0x5F<<3)|4: c->AD=_GD();_WR();break;
-        case (0x5F<<3)|5: c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();break;
-        case (0x5F<<3)|6: _FETCH();break;
-        case (0x5F<<3)|7: assert(false);break;
+        _OP(0x5F,0): _SA(c->PC++);_NEXT()
+        _OP(0x5F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x5F,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5F,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x5F,5): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x5F,6): _FETCH();_NEXT()
+        _OP(0x5F,7): assert(false);_NEXT()
     /* RTS  */
-        case (0x60<<3)|0: _SA(c->PC);break;
-        case (0x60<<3)|1: _SA(0x0100|c->S++);break;
-        case (0x60<<3)|2: _SA(0x0100|c->S++);break;
-        case (0x60<<3)|3: _SA(0x0100|c->S);c->AD=_GD();break;
-        case (0x60<<3)|4: c->PC=(_GD()<<8)|c->AD;_SA(c->PC++);break;
-        case (0x60<<3)|5: _FETCH();break;
-        case (0x60<<3)|6: assert(false);break;
-        case (0x60<<3)|7: assert(false);break;
+        _OP(0x60,0): _SA(c->PC);_NEXT()
+        _OP(0x60,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x60,2): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x60,3): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x60,4): c->PC=(_GD()<<8)|c->AD;_SA(c->PC++);_NEXT()
+        _OP(0x60,5): _FETCH();_NEXT()
+        _OP(0x60,6): assert(false);_NEXT()
+        _OP(0x60,7): assert(false);_NEXT()
     /* ADC (zp,X) */
-        case (0x61<<3)|0: _SA(c->PC++);break;
-        case (0x61<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x61<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x61<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x61<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0x61<<3)|5: _m6502_adc(c,_GD());_FETCH();break;
-        case (0x61<<3)|6: assert(false);break;
-        case (0x61<<3)|7: assert(false);break;
+        _OP(0x61,0): _SA(c->PC++);_NEXT()
+        _OP(0x61,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x61,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x61,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x61,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x61,5): _m6502_adc(c,_GD());_FETCH();_NEXT()
+        _OP(0x61,6): assert(false);_NEXT()
+        _OP(0x61,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x62<<3)|0: _SA(c->PC);break;
-        case (0x62<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x62<<3)|2: assert(false);break;
-        case (0x62<<3)|3: assert(false);break;
-        case (0x62<<3)|4: assert(false);break;
-        case (0x62<<3)|5: assert(false);break;
-        case (0x62<<3)|6: assert(false);break;
-        case (0x62<<3)|7: assert(false);break;
+        _OP(0x62,0): _SA(c->PC);_NEXT()
+        _OP(0x62,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x62,2): assert(false);_NEXT()
+        _OP(0x62,3): assert(false);_NEXT()
+        _OP(0x62,4): assert(false);_NEXT()
+        _OP(0x62,5): assert(false);_NEXT()
+        _OP(0x62,6): assert(false);_NEXT()
+        _OP(0x62,7): assert(false);_NEXT()
     /* RRA (zp,X) (undoc) */
-        case (0x63<<3)|0: _SA(c->PC++);break;
-        case (0x63<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x63<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x63<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x63<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0x63<<3)|5: c->AD=_GD();_WR();break;
-        case (0x63<<3)|6: c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();break;
-        case (0x63<<3)|7: _FETCH();break;
+        _OP(0x63,0): _SA(c->PC++);_NEXT()
+        _OP(0x63,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x63,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x63,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x63,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x63,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x63,6): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();_NEXT()
+        _OP(0x63,7): _FETCH();_NEXT()
     /* NOP zp (undoc) */
-        case (0x64<<3)|0: _SA(c->PC++);break;
-        case (0x64<<3)|1: _SA(_GD());break;
-        case (0x64<<3)|2: _FETCH();break;
-        case (0x64<<3)|3: assert(false);break;
-        case (0x64<<3)|4: assert(false);break;
-        case (0x64<<3)|5: assert(false);break;
-        case (0x64<<3)|6: assert(false);break;
-        case (0x64<<3)|7: assert(false);break;
+        _OP(0x64,0): _SA(c->PC++);_NEXT()
+        _OP(0x64,1): _SA(_GD());_NEXT()
+        _OP(0x64,2): _FETCH();_NEXT()
+        _OP(0x64,3): assert(false);_NEXT()
+        _OP(0x64,4): assert(false);_NEXT()
+        _OP(0x64,5): assert(false);_NEXT()
+        _OP(0x64,6): assert(false);_NEXT()
+        _OP(0x64,7): assert(false);_NEXT()
     /* ADC zp */
-        case (0x65<<3)|0: _SA(c->PC++);break;
-        case (0x65<<3)|1: _SA(_GD());break;
-        case (0x65<<3)|2: _m6502_adc(c,_GD());_FETCH();break;
-        case (0x65<<3)|3: assert(false);break;
-        case (0x65<<3)|4: assert(false);break;
-        case (0x65<<3)|5: assert(false);break;
-        case (0x65<<3)|6: assert(false);break;
-        case (0x65<<3)|7: assert(false);break;
+        _OP(0x65,0): _SA(c->PC++);_NEXT()
+        _OP(0x65,1): _SA(_GD());_NEXT()
+        _OP(0x65,2): _m6502_adc(c,_GD());_FETCH();_NEXT()
+        _OP(0x65,3): assert(false);_NEXT()
+        _OP(0x65,4): assert(false);_NEXT()
+        _OP(0x65,5): assert(false);_NEXT()
+        _OP(0x65,6): assert(false);_NEXT()
+        _OP(0x65,7): assert(false);_NEXT()
     /* ROR zp */
-        case (0x66<<3)|0: _SA(c->PC++);break;
-        case (0x66<<3)|1: _SA(_GD());break;
-        case (0x66<<3)|2: c->AD=_GD();_WR();break;
-        case (0x66<<3)|3: _SD(_m6502_ror(c,c->AD));_WR();break;
-        case (0x66<<3)|4: _FETCH();break;
-        case (0x66<<3)|5: assert(false);break;
-        case (0x66<<3)|6: assert(false);break;
-        case (0x66<<3)|7: assert(false);break;
+        _OP(0x66,0): _SA(c->PC++);_NEXT()
+        _OP(0x66,1): _SA(_GD());_NEXT()
+        _OP(0x66,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x66,3): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x66,4): _FETCH();_NEXT()
+        _OP(0x66,5): assert(false);_NEXT()
+        _OP(0x66,6): assert(false);_NEXT()
+        _OP(0x66,7): assert(false);_NEXT()
     /* RRA zp (undoc) */
-        case (0x67<<3)|0: _SA(c->PC++);break;
-        case (0x67<<3)|1: _SA(_GD());break;
-        case (0x67<<3)|2: c->AD=_GD();_WR();break;
-        case (0x67<<3)|3: c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();break;
-        case (0x67<<3)|4: _FETCH();break;
-        case (0x67<<3)|5: assert(false);break;
-        case (0x67<<3)|6: assert(false);break;
-        case (0x67<<3)|7: assert(false);break;
+        _OP(0x67,0): _SA(c->PC++);_NEXT()
+        _OP(0x67,1): _SA(_GD());_NEXT()
+        _OP(0x67,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x67,3): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();_NEXT()
+        _OP(0x67,4): _FETCH();_NEXT()
+        _OP(0x67,5): assert(false);_NEXT()
+        _OP(0x67,6): assert(false);_NEXT()
+        _OP(0x67,7): assert(false);_NEXT()
     /* PLA  */
-        case (0x68<<3)|0: _SA(c->PC);break;
-        case (0x68<<3)|1: _SA(0x0100|c->S++);break;
-        case (0x68<<3)|2: _SA(0x0100|c->S);break;
-        case (0x68<<3)|3: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0x68<<3)|4: assert(false);break;
-        case (0x68<<3)|5: assert(false);break;
-        case (0x68<<3)|6: assert(false);break;
-        case (0x68<<3)|7: assert(false);break;
+        _OP(0x68,0): _SA(c->PC);_NEXT()
+        _OP(0x68,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x68,2): _SA(0x0100|c->S);_NEXT()
+        _OP(0x68,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x68,4): assert(false);_NEXT()
+        _OP(0x68,5): assert(false);_NEXT()
+        _OP(0x68,6): assert(false);_NEXT()
+        _OP(0x68,7): assert(false);_NEXT()
     /* ADC # */
-        case (0x69<<3)|0: _SA(c->PC++);break;
-        case (0x69<<3)|1: _m6502_adc(c,_GD());_FETCH();break;
-        case (0x69<<3)|2: assert(false);break;
-        case (0x69<<3)|3: assert(false);break;
-        case (0x69<<3)|4: assert(false);break;
-        case (0x69<<3)|5: assert(false);break;
-        case (0x69<<3)|6: assert(false);break;
-        case (0x69<<3)|7: assert(false);break;
+        _OP(0x69,0): _SA(c->PC++);_NEXT()
+        _OP(0x69,1): _m6502_adc(c,_GD());_FETCH();_NEXT()
+        _OP(0x69,2): assert(false);_NEXT()
+        _OP(0x69,3): assert(false);_NEXT()
+        _OP(0x69,4): assert(false);_NEXT()
+        _OP(0x69,5): assert(false);_NEXT()
+        _OP(0x69,6): assert(false);_NEXT()
+        _OP(0x69,7): assert(false);_NEXT()
     /* RORA  */
-        case (0x6A<<3)|0: _SA(c->PC);break;
-        case (0x6A<<3)|1: c->A=_m6502_ror(c,c->A);_FETCH();break;
-        case (0x6A<<3)|2: assert(false);break;
-        case (0x6A<<3)|3: assert(false);break;
-        case (0x6A<<3)|4: assert(false);break;
-        case (0x6A<<3)|5: assert(false);break;
-        case (0x6A<<3)|6: assert(false);break;
-        case (0x6A<<3)|7: assert(false);break;
+        _OP(0x6A,0): _SA(c->PC);_NEXT()
+        _OP(0x6A,1): c->A=_m6502_ror(c,c->A);_FETCH();_NEXT()
+        _OP(0x6A,2): assert(false);_NEXT()
+        _OP(0x6A,3): assert(false);_NEXT()
+        _OP(0x6A,4): assert(false);_NEXT()
+        _OP(0x6A,5): assert(false);_NEXT()
+        _OP(0x6A,6): assert(false);_NEXT()
+        _OP(0x6A,7): assert(false);_NEXT()
     /* ARR # (undoc) */
-        case (0x6B<<3)|0: _SA(c->PC++);break;
-        case (0x6B<<3)|1: c->A&=_GD();_m6502_arr(c);_FETCH();break;
-        case (0x6B<<3)|2: assert(false);break;
-        case (0x6B<<3)|3: assert(false);break;
-        case (0x6B<<3)|4: assert(false);break;
-        case (0x6B<<3)|5: assert(false);break;
-        case (0x6B<<3)|6: assert(false);break;
-        case (0x6B<<3)|7: assert(false);break;
+        _OP(0x6B,0): _SA(c->PC++);_NEXT()
+        _OP(0x6B,1): c->A&=_GD();_m6502_arr(c);_FETCH();_NEXT()
+        _OP(0x6B,2): assert(false);_NEXT()
+        _OP(0x6B,3): assert(false);_NEXT()
+        _OP(0x6B,4): assert(false);_NEXT()
+        _OP(0x6B,5): assert(false);_NEXT()
+        _OP(0x6B,6): assert(false);_NEXT()
+        _OP(0x6B,7): assert(false);_NEXT()
     /* JMPI  */
-        case (0x6C<<3)|0: _SA(c->PC++);break;
-        case (0x6C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x6C<<3)|2: c->AD|=_GD()<<8;_SA(c->AD);break;
-        case (0x6C<<3)|3: _SA((c->AD&0xFF00)|((c->AD+1)&0x00FF));c->AD=_GD();break;
-        case (0x6C<<3)|4: c->PC=(_GD()<<8)|c->AD;_FETCH();break;
-        case (0x6C<<3)|5: assert(false);break;
-        case (0x6C<<3)|6: assert(false);break;
-        case (0x6C<<3)|7: assert(false);break;
+        _OP(0x6C,0): _SA(c->PC++);_NEXT()
+        _OP(0x6C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6C,2): c->AD|=_GD()<<8;_SA(c->AD);_NEXT()
+        _OP(0x6C,3): _SA((c->AD&0xFF00)|((c->AD+1)&0x00FF));c->AD=_GD();_NEXT()
+        _OP(0x6C,4): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x6C,5): assert(false);_NEXT()
+        _OP(0x6C,6): assert(false);_NEXT()
+        _OP(0x6C,7): assert(false);_NEXT()
     /* ADC abs */
-        case (0x6D<<3)|0: _SA(c->PC++);break;
-        case (0x6D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x6D<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x6D<<3)|3: _m6502_adc(c,_GD());_FETCH();break;
-        case (0x6D<<3)|4: assert(false);break;
-        case (0x6D<<3)|5: assert(false);break;
-        case (0x6D<<3)|6: assert(false);break;
-        case (0x6D<<3)|7: assert(false);break;
+        _OP(0x6D,0): _SA(c->PC++);_NEXT()
+        _OP(0x6D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x6D,3): _m6502_adc(c,_GD());_FETCH();_NEXT()
+        _OP(0x6D,4): assert(false);_NEXT()
+        _OP(0x6D,5): assert(false);_NEXT()
+        _OP(0x6D,6): assert(false);_NEXT()
+        _OP(0x6D,7): assert(false);_NEXT()
     /* ROR abs */
-        case (0x6E<<3)|0: _SA(c->PC++);break;
-        case (0x6E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x6E<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x6E<<3)|3: c->AD=_GD();_WR();break;
-        case (0x6E<<3)|4: _SD(_m6502_ror(c,c->AD));_WR();break;
-        case (0x6E<<3)|5: _FETCH();break;
-        case (0x6E<<3)|6: assert(false);break;
-        case (0x6E<<3)|7: assert(false);break;
+        _OP(0x6E,0): _SA(c->PC++);_NEXT()
+        _OP(0x6E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x6E,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x6E,4): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x6E,5): _FETCH();_NEXT()
+        _OP(0x6E,6): assert(false);_NEXT()
+        _OP(0x6E,7): assert(false);_NEXT()
     /* RRA abs (undoc) */
-        case (0x6F<<3)|0: _SA(c->PC++);break;
-        case (0x6F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x6F<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0x6F<<3)|3: c->AD=_GD();_WR();break;
-        case (0x6F<<3)|4: c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();break;
-        case (0x6F<<3)|5: _FETCH();break;
-        case (0x6F<<3)|6: assert(false);break;
-        case (0x6F<<3)|7: assert(false);break;
+        _OP(0x6F,0): _SA(c->PC++);_NEXT()
+        _OP(0x6F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6F,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x6F,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x6F,4): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();_NEXT()
+        _OP(0x6F,5): _FETCH();_NEXT()
+        _OP(0x6F,6): assert(false);_NEXT()
+        _OP(0x6F,7): assert(false);_NEXT()
     /* BVS # */
-        case (0x70<<3)|0: _SA(c->PC++);break;
-        case (0x70<<3)|1: _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x40)!=0x40){_FETCH();};break;
-        case (0x70<<3)|2: _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};break;
-        case (0x70<<3)|3: c->PC=c->AD;_FETCH();break;
-        case (0x70<<3)|4: assert(false);break;
-        case (0x70<<3)|5: assert(false);break;
-        case (0x70<<3)|6: assert(false);break;
-        case (0x70<<3)|7: assert(false);break;
+        _OP(0x70,0): _SA(c->PC++);_NEXT()
+        _OP(0x70,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x40)!=0x40){_FETCH();};_NEXT()
+        _OP(0x70,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x70,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x70,4): assert(false);_NEXT()
+        _OP(0x70,5): assert(false);_NEXT()
+        _OP(0x70,6): assert(false);_NEXT()
+        _OP(0x70,7): assert(false);_NEXT()
     /* ADC (zp),Y */
-        case (0x71<<3)|0: _SA(c->PC++);break;
-        case (0x71<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x71<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x71<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0x71<<3)|4: _SA(c->AD+c->Y);break;
-        case (0x71<<3)|5: _m6502_adc(c,_GD());_FETCH();break;
-        case (0x71<<3)|6: assert(false);break;
-        case (0x71<<3)|7: assert(false);break;
+        _OP(0x71,0): _SA(c->PC++);_NEXT()
+        _OP(0x71,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x71,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x71,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x71,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x71,5): _m6502_adc(c,_GD());_FETCH();_NEXT()
+        _OP(0x71,6): assert(false);_NEXT()
+        _OP(0x71,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x72<<3)|0: _SA(c->PC);break;
-        case (0x72<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x72<<3)|2: assert(false);break;
-        case (0x72<<3)|3: assert(false);break;
-        case (0x72<<3)|4: assert(false);break;
-        case (0x72<<3)|5: assert(false);break;
-        case (0x72<<3)|6: assert(false);break;
-        case (0x72<<3)|7: assert(false);break;
+        _OP(0x72,0): _SA(c->PC);_NEXT()
+        _OP(0x72,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x72,2): assert(false);_NEXT()
+        _OP(0x72,3): assert(false);_NEXT()
+        _OP(0x72,4): assert(false);_NEXT()
+        _OP(0x72,5): assert(false);_NEXT()
+        _OP(0x72,6): assert(false);_NEXT()
+        _OP(0x72,7): assert(false);_NEXT()
     /* RRA (zp),Y (undoc) */
-        case (0x73<<3)|0: _SA(c->PC++);break;
-        case (0x73<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x73<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x73<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x73<<3)|4: _SA(c->AD+c->Y);break;
-        case (0x73<<3)|5: c->AD=_GD();_WR();break;
-        case (0x73<<3)|6: c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();break;
-        case (0x73<<3)|7: _FETCH();break;
+        _OP(0x73,0): _SA(c->PC++);_NEXT()
+        _OP(0x73,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x73,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x73,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x73,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x73,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x73,6): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();_NEXT()
+        _OP(0x73,7): _FETCH();_NEXT()
     /* NOP zp,X (undoc) */
-        case (0x74<<3)|0: _SA(c->PC++);break;
-        case (0x74<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x74<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x74<<3)|3: _FETCH();break;
-        case (0x74<<3)|4: assert(false);break;
-        case (0x74<<3)|5: assert(false);break;
-        case (0x74<<3)|6: assert(false);break;
-        case (0x74<<3)|7: assert(false);break;
+        _OP(0x74,0): _SA(c->PC++);_NEXT()
+        _OP(0x74,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x74,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x74,3): _FETCH();_NEXT()
+        _OP(0x74,4): assert(false);_NEXT()
+        _OP(0x74,5): assert(false);_NEXT()
+        _OP(0x74,6): assert(false);_NEXT()
+        _OP(0x74,7): assert(false);_NEXT()
     /* ADC zp,X */
-        case (0x75<<3)|0: _SA(c->PC++);break;
-        case (0x75<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x75<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x75<<3)|3: _m6502_adc(c,_GD());_FETCH();break;
-        case (0x75<<3)|4: assert(false);break;
-        case (0x75<<3)|5: assert(false);break;
-        case (0x75<<3)|6: assert(false);break;
-        case (0x75<<3)|7: assert(false);break;
+        _OP(0x75,0): _SA(c->PC++);_NEXT()
+        _OP(0x75,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x75,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x75,3): _m6502_adc(c,_GD());_FETCH();_NEXT()
+        _OP(0x75,4): assert(false);_NEXT()
+        _OP(0x75,5): assert(false);_NEXT()
+        _OP(0x75,6): assert(false);_NEXT()
+        _OP(0x75,7): assert(false);_NEXT()
     /* ROR zp,X */
-        case (0x76<<3)|0: _SA(c->PC++);break;
-        case (0x76<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x76<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x76<<3)|3: c->AD=_GD();_WR();break;
-        case (0x76<<3)|4: _SD(_m6502_ror(c,c->AD));_WR();break;
-        case (0x76<<3)|5: _FETCH();break;
-        case (0x76<<3)|6: assert(false);break;
-        case (0x76<<3)|7: assert(false);break;
+        _OP(0x76,0): _SA(c->PC++);_NEXT()
+        _OP(0x76,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x76,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x76,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x76,4): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x76,5): _FETCH();_NEXT()
+        _OP(0x76,6): assert(false);_NEXT()
+        _OP(0x76,7): assert(false);_NEXT()
     /* RRA zp,X (undoc) */
-        case (0x77<<3)|0: _SA(c->PC++);break;
-        case (0x77<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x77<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0x77<<3)|3: c->AD=_GD();_WR();break;
-        case (0x77<<3)|4: c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();break;
-        case (0x77<<3)|5: _FETCH();break;
-        case (0x77<<3)|6: assert(false);break;
-        case (0x77<<3)|7: assert(false);break;
+        _OP(0x77,0): _SA(c->PC++);_NEXT()
+        _OP(0x77,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x77,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x77,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x77,4): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();_NEXT()
+        _OP(0x77,5): _FETCH();_NEXT()
+        _OP(0x77,6): assert(false);_NEXT()
+        _OP(0x77,7): assert(false);_NEXT()
     /* SEI  */
-        case (0x78<<3)|0: _SA(c->PC);break;
-        case (0x78<<3)|1: c->P|=0x4;_FETCH();break;
-        case (0x78<<3)|2: assert(false);break;
-        case (0x78<<3)|3: assert(false);break;
-        case (0x78<<3)|4: assert(false);break;
-        case (0x78<<3)|5: assert(false);break;
-        case (0x78<<3)|6: assert(false);break;
-        case (0x78<<3)|7: assert(false);break;
+        _OP(0x78,0): _SA(c->PC);_NEXT()
+        _OP(0x78,1): c->P|=0x4;_FETCH();_NEXT()
+        _OP(0x78,2): assert(false);_NEXT()
+        _OP(0x78,3): assert(false);_NEXT()
+        _OP(0x78,4): assert(false);_NEXT()
+        _OP(0x78,5): assert(false);_NEXT()
+        _OP(0x78,6): assert(false);_NEXT()
+        _OP(0x78,7): assert(false);_NEXT()
     /* ADC abs,Y */
-        case (0x79<<3)|0: _SA(c->PC++);break;
-        case (0x79<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x79<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0x79<<3)|3: _SA(c->AD+c->Y);break;
-        case (0x79<<3)|4: _m6502_adc(c,_GD());_FETCH();break;
-        case (0x79<<3)|5: assert(false);break;
-        case (0x79<<3)|6: assert(false);break;
-        case (0x79<<3)|7: assert(false);break;
+        _OP(0x79,0): _SA(c->PC++);_NEXT()
+        _OP(0x79,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x79,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x79,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x79,4): _m6502_adc(c,_GD());_FETCH();_NEXT()
+        _OP(0x79,5): assert(false);_NEXT()
+        _OP(0x79,6): assert(false);_NEXT()
+        _OP(0x79,7): assert(false);_NEXT()
     /* NOP  (undoc) */
-        case (0x7A<<3)|0: _SA(c->PC);break;
-        case (0x7A<<3)|1: _FETCH();break;
-        case (0x7A<<3)|2: assert(false);break;
-        case (0x7A<<3)|3: assert(false);break;
-        case (0x7A<<3)|4: assert(false);break;
-        case (0x7A<<3)|5: assert(false);break;
-        case (0x7A<<3)|6: assert(false);break;
-        case (0x7A<<3)|7: assert(false);break;
+        _OP(0x7A,0): _SA(c->PC);_NEXT()
+        _OP(0x7A,1): _FETCH();_NEXT()
+        _OP(0x7A,2): assert(false);_NEXT()
+        _OP(0x7A,3): assert(false);_NEXT()
+        _OP(0x7A,4): assert(false);_NEXT()
+        _OP(0x7A,5): assert(false);_NEXT()
+        _OP(0x7A,6): assert(false);_NEXT()
+        _OP(0x7A,7): assert(false);_NEXT()
     /* RRA abs,Y (undoc) */
-        case (0x7B<<3)|0: _SA(c->PC++);break;
-        case (0x7B<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x7B<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x7B<<3)|3: _SA(c->AD+c->Y);break;
-        case (0x7B<<3)|4: c->AD=_GD();_WR();break;
-        case (0x7B<<3)|5: c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();break;
-        case (0x7B<<3)|6: _FETCH();break;
-        case (0x7B<<3)|7: assert(false);break;
+        _OP(0x7B,0): _SA(c->PC++);_NEXT()
+        _OP(0x7B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x7B,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x7B,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x7B,5): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();_NEXT()
+        _OP(0x7B,6): _FETCH();_NEXT()
+        _OP(0x7B,7): assert(false);_NEXT()
     /* NOP abs,X (undoc) */
-        case (0x7C<<3)|0: _SA(c->PC++);break;
-        case (0x7C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x7C<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0x7C<<3)|3: _SA(c->AD+c->X);break;
-        case (0x7C<<3)|4: _FETCH();break;
-        case (0x7C<<3)|5: assert(false);break;
-        case (0x7C<<3)|6: assert(false);break;
-        case (0x7C<<3)|7: assert(false);break;
+        _OP(0x7C,0): _SA(c->PC++);_NEXT()
+        _OP(0x7C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x7C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7C,4): _FETCH();_NEXT()
+        _OP(0x7C,5): assert(false);_NEXT()
+        _OP(0x7C,6): assert(false);_NEXT()
+        _OP(0x7C,7): assert(false);_NEXT()
     /* ADC abs,X */
-        case (0x7D<<3)|0: _SA(c->PC++);break;
-        case (0x7D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x7D<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0x7D<<3)|3: _SA(c->AD+c->X);break;
-        case (0x7D<<3)|4: _m6502_adc(c,_GD());_FETCH();break;
-        case (0x7D<<3)|5: assert(false);break;
-        case (0x7D<<3)|6: assert(false);break;
-        case (0x7D<<3)|7: assert(false);break;
+        _OP(0x7D,0): _SA(c->PC++);_NEXT()
+        _OP(0x7D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x7D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7D,4): _m6502_adc(c,_GD());_FETCH();_NEXT()
+        _OP(0x7D,5): assert(false);_NEXT()
+        _OP(0x7D,6): assert(false);_NEXT()
+        _OP(0x7D,7): assert(false);_NEXT()
     /* ROR abs,X */
-        case (0x7E<<3)|0: _SA(c->PC++);break;
-        case (0x7E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x7E<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x7E<<3)|3: _SA(c->AD+c->X);break;
-        case (0x7E<<3)|4: c->AD=_GD();_WR();break;
-        case (0x7E<<3)|5: _SD(_m6502_ror(c,c->AD));_WR();break;
-        case (0x7E<<3)|6: _FETCH();break;
-        case (0x7E<<3)|7: assert(false);break;
+        _OP(0x7E,0): _SA(c->PC++);_NEXT()
+        _OP(0x7E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x7E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7E,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x7E,5): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x7E,6): _FETCH();_NEXT()
+        _OP(0x7E,7): assert(false);_NEXT()
     /* RRA abs,X (undoc) */
-        case (0x7F<<3)|0: _SA(c->PC++);break;
-        case (0x7F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x7F<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x7F<<3)|3: _SA(c->AD+c->X);break;
-        case (0x7F<<3)|4: c->AD=_GD();_WR();break;
-        case (0x7F<<3)|5: c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();break;
-        case (0x7F<<3)|6: _FETCH();break;
-        case (0x7F<<3)|7: assert(false);break;
+        _OP(0x7F,0): _SA(c->PC++);_NEXT()
+        _OP(0x7F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x7F,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7F,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x7F,5): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();_NEXT()
+        _OP(0x7F,6): _FETCH();_NEXT()
+        _OP(0x7F,7): assert(false);_NEXT()
     /* NOP # (undoc) */
-        case (0x80<<3)|0: _SA(c->PC++);break;
-        case (0x80<<3)|1: _FETCH();break;
-        case (0x80<<3)|2: assert(false);break;
-        case (0x80<<3)|3: assert(false);break;
-        case (0x80<<3)|4: assert(false);break;
-        case (0x80<<3)|5: assert(false);break;
-        case (0x80<<3)|6: assert(false);break;
-        case (0x80<<3)|7: assert(false);break;
+        _OP(0x80,0): _SA(c->PC++);_NEXT()
+        _OP(0x80,1): _FETCH();_NEXT()
+        _OP(0x80,2): assert(false);_NEXT()
+        _OP(0x80,3): assert(false);_NEXT()
+        _OP(0x80,4): assert(false);_NEXT()
+        _OP(0x80,5): assert(false);_NEXT()
+        _OP(0x80,6): assert(false);_NEXT()
+        _OP(0x80,7): assert(false);_NEXT()
     /* STA (zp,X) */
-        case (0x81<<3)|0: _SA(c->PC++);break;
-        case (0x81<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x81<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x81<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x81<<3)|4: _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();break;
-        case (0x81<<3)|5: _FETCH();break;
-        case (0x81<<3)|6: assert(false);break;
-        case (0x81<<3)|7: assert(false);break;
+        _OP(0x81,0): _SA(c->PC++);_NEXT()
+        _OP(0x81,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x81,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x81,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x81,4): _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();_NEXT()
+        _OP(0x81,5): _FETCH();_NEXT()
+        _OP(0x81,6): assert(false);_NEXT()
+        _OP(0x81,7): assert(false);_NEXT()
     /* NOP # (undoc) */
-        case (0x82<<3)|0: _SA(c->PC++);break;
-        case (0x82<<3)|1: _FETCH();break;
-        case (0x82<<3)|2: assert(false);break;
-        case (0x82<<3)|3: assert(false);break;
-        case (0x82<<3)|4: assert(false);break;
-        case (0x82<<3)|5: assert(false);break;
-        case (0x82<<3)|6: assert(false);break;
-        case (0x82<<3)|7: assert(false);break;
+        _OP(0x82,0): _SA(c->PC++);_NEXT()
+        _OP(0x82,1): _FETCH();_NEXT()
+        _OP(0x82,2): assert(false);_NEXT()
+        _OP(0x82,3): assert(false);_NEXT()
+        _OP(0x82,4): assert(false);_NEXT()
+        _OP(0x82,5): assert(false);_NEXT()
+        _OP(0x82,6): assert(false);_NEXT()
+        _OP(0x82,7): assert(false);_NEXT()
     /* SAX (zp,X) (undoc) */
-        case (0x83<<3)|0: _SA(c->PC++);break;
-        case (0x83<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x83<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0x83<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x83<<3)|4: _SA((_GD()<<8)|c->AD);_SD(c->A&c->X);_WR();break;
-        case (0x83<<3)|5: _FETCH();break;
-        case (0x83<<3)|6: assert(false);break;
-        case (0x83<<3)|7: assert(false);break;
+        _OP(0x83,0): _SA(c->PC++);_NEXT()
+        _OP(0x83,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x83,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x83,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x83,4): _SA((_GD()<<8)|c->AD);_SD(c->A&c->X);_WR();_NEXT()
+        _OP(0x83,5): _FETCH();_NEXT()
+        _OP(0x83,6): assert(false);_NEXT()
+        _OP(0x83,7): assert(false);_NEXT()
     /* STY zp */
-        case (0x84<<3)|0: _SA(c->PC++);break;
-        case (0x84<<3)|1: _SA(_GD());_SD(c->Y);_WR();break;
-        case (0x84<<3)|2: _FETCH();break;
-        case (0x84<<3)|3: assert(false);break;
-        case (0x84<<3)|4: assert(false);break;
-        case (0x84<<3)|5: assert(false);break;
-        case (0x84<<3)|6: assert(false);break;
-        case (0x84<<3)|7: assert(false);break;
+        _OP(0x84,0): _SA(c->PC++);_NEXT()
+        _OP(0x84,1): _SA(_GD());_SD(c->Y);_WR();_NEXT()
+        _OP(0x84,2): _FETCH();_NEXT()
+        _OP(0x84,3): assert(false);_NEXT()
+        _OP(0x84,4): assert(false);_NEXT()
+        _OP(0x84,5): assert(false);_NEXT()
+        _OP(0x84,6): assert(false);_NEXT()
+        _OP(0x84,7): assert(false);_NEXT()
     /* STA zp */
-        case (0x85<<3)|0: _SA(c->PC++);break;
-        case (0x85<<3)|1: _SA(_GD());_SD(c->A);_WR();break;
-        case (0x85<<3)|2: _FETCH();break;
-        case (0x85<<3)|3: assert(false);break;
-        case (0x85<<3)|4: assert(false);break;
-        case (0x85<<3)|5: assert(false);break;
-        case (0x85<<3)|6: assert(false);break;
-        case (0x85<<3)|7: assert(false);break;
+        _OP(0x85,0): _SA(c->PC++);_NEXT()
+        _OP(0x85,1): _SA(_GD());_SD(c->A);_WR();_NEXT()
+        _OP(0x85,2): _FETCH();_NEXT()
+        _OP(0x85,3): assert(false);_NEXT()
+        _OP(0x85,4): assert(false);_NEXT()
+        _OP(0x85,5): assert(false);_NEXT()
+        _OP(0x85,6): assert(false);_NEXT()
+        _OP(0x85,7): assert(false);_NEXT()
     /* STX zp */
-        case (0x86<<3)|0: _SA(c->PC++);break;
-        case (0x86<<3)|1: _SA(_GD());_SD(c->X);_WR();break;
-        case (0x86<<3)|2: _FETCH();break;
-        case (0x86<<3)|3: assert(false);break;
-        case (0x86<<3)|4: assert(false);break;
-        case (0x86<<3)|5: assert(false);break;
-        case (0x86<<3)|6: assert(false);break;
-        case (0x86<<3)|7: assert(false);break;
+        _OP(0x86,0): _SA(c->PC++);_NEXT()
+        _OP(0x86,1): _SA(_GD());_SD(c->X);_WR();_NEXT()
+        _OP(0x86,2): _FETCH();_NEXT()
+        _OP(0x86,3): assert(false);_NEXT()
+        _OP(0x86,4): assert(false);_NEXT()
+        _OP(0x86,5): assert(false);_NEXT()
+        _OP(0x86,6): assert(false);_NEXT()
+        _OP(0x86,7): assert(false);_NEXT()
     /* SAX zp (undoc) */
-        case (0x87<<3)|0: _SA(c->PC++);break;
-        case (0x87<<3)|1: _SA(_GD());_SD(c->A&c->X);_WR();break;
-        case (0x87<<3)|2: _FETCH();break;
-        case (0x87<<3)|3: assert(false);break;
-        case (0x87<<3)|4: assert(false);break;
-        case (0x87<<3)|5: assert(false);break;
-        case (0x87<<3)|6: assert(false);break;
-        case (0x87<<3)|7: assert(false);break;
+        _OP(0x87,0): _SA(c->PC++);_NEXT()
+        _OP(0x87,1): _SA(_GD());_SD(c->A&c->X);_WR();_NEXT()
+        _OP(0x87,2): _FETCH();_NEXT()
+        _OP(0x87,3): assert(false);_NEXT()
+        _OP(0x87,4): assert(false);_NEXT()
+        _OP(0x87,5): assert(false);_NEXT()
+        _OP(0x87,6): assert(false);_NEXT()
+        _OP(0x87,7): assert(false);_NEXT()
     /* DEY  */
-        case (0x88<<3)|0: _SA(c->PC);break;
-        case (0x88<<3)|1: c->Y--;_NZ(c->Y);_FETCH();break;
-        case (0x88<<3)|2: assert(false);break;
-        case (0x88<<3)|3: assert(false);break;
-        case (0x88<<3)|4: assert(false);break;
-        case (0x88<<3)|5: assert(false);break;
-        case (0x88<<3)|6: assert(false);break;
-        case (0x88<<3)|7: assert(false);break;
+        _OP(0x88,0): _SA(c->PC);_NEXT()
+        _OP(0x88,1): c->Y--;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0x88,2): assert(false);_NEXT()
+        _OP(0x88,3): assert(false);_NEXT()
+        _OP(0x88,4): assert(false);_NEXT()
+        _OP(0x88,5): assert(false);_NEXT()
+        _OP(0x88,6): assert(false);_NEXT()
+        _OP(0x88,7): assert(false);_NEXT()
     /* NOP # (undoc) */
-        case (0x89<<3)|0: _SA(c->PC++);break;
-        case (0x89<<3)|1: _FETCH();break;
-        case (0x89<<3)|2: assert(false);break;
-        case (0x89<<3)|3: assert(false);break;
-        case (0x89<<3)|4: assert(false);break;
-        case (0x89<<3)|5: assert(false);break;
-        case (0x89<<3)|6: assert(false);break;
-        case (0x89<<3)|7: assert(false);break;
+        _OP(0x89,0): _SA(c->PC++);_NEXT()
+        _OP(0x89,1): _FETCH();_NEXT()
+        _OP(0x89,2): assert(false);_NEXT()
+        _OP(0x89,3): assert(false);_NEXT()
+        _OP(0x89,4): assert(false);_NEXT()
+        _OP(0x89,5): assert(false);_NEXT()
+        _OP(0x89,6): assert(false);_NEXT()
+        _OP(0x89,7): assert(false);_NEXT()
     /* TXA  */
-        case (0x8A<<3)|0: _SA(c->PC);break;
-        case (0x8A<<3)|1: c->A=c->X;_NZ(c->A);_FETCH();break;
-        case (0x8A<<3)|2: assert(false);break;
-        case (0x8A<<3)|3: assert(false);break;
-        case (0x8A<<3)|4: assert(false);break;
-        case (0x8A<<3)|5: assert(false);break;
-        case (0x8A<<3)|6: assert(false);break;
-        case (0x8A<<3)|7: assert(false);break;
+        _OP(0x8A,0): _SA(c->PC);_NEXT()
+        _OP(0x8A,1): c->A=c->X;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x8A,2): assert(false);_NEXT()
+        _OP(0x8A,3): assert(false);_NEXT()
+        _OP(0x8A,4): assert(false);_NEXT()
+        _OP(0x8A,5): assert(false);_NEXT()
+        _OP(0x8A,6): assert(false);_NEXT()
+        _OP(0x8A,7): assert(false);_NEXT()
     /* ANE # (undoc) */
-        case (0x8B<<3)|0: _SA(c->PC++);break;
-        case (0x8B<<3)|1: c->A=(c->A|0xEE)&c->X&_GD();_NZ(c->A);_FETCH();break;
-        case (0x8B<<3)|2: assert(false);break;
-        case (0x8B<<3)|3: assert(false);break;
-        case (0x8B<<3)|4: assert(false);break;
-        case (0x8B<<3)|5: assert(false);break;
-        case (0x8B<<3)|6: assert(false);break;
-        case (0x8B<<3)|7: assert(false);break;
+        _OP(0x8B,0): _SA(c->PC++);_NEXT()
+        _OP(0x8B,1): c->A=(c->A|0xEE)&c->X&_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x8B,2): assert(false);_NEXT()
+        _OP(0x8B,3): assert(false);_NEXT()
+        _OP(0x8B,4): assert(false);_NEXT()
+        _OP(0x8B,5): assert(false);_NEXT()
+        _OP(0x8B,6): assert(false);_NEXT()
+        _OP(0x8B,7): assert(false);_NEXT()
     /* STY abs */
-        case (0x8C<<3)|0: _SA(c->PC++);break;
-        case (0x8C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x8C<<3)|2: _SA((_GD()<<8)|c->AD);_SD(c->Y);_WR();break;
-        case (0x8C<<3)|3: _FETCH();break;
-        case (0x8C<<3)|4: assert(false);break;
-        case (0x8C<<3)|5: assert(false);break;
-        case (0x8C<<3)|6: assert(false);break;
-        case (0x8C<<3)|7: assert(false);break;
+        _OP(0x8C,0): _SA(c->PC++);_NEXT()
+        _OP(0x8C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8C,2): _SA((_GD()<<8)|c->AD);_SD(c->Y);_WR();_NEXT()
+        _OP(0x8C,3): _FETCH();_NEXT()
+        _OP(0x8C,4): assert(false);_NEXT()
+        _OP(0x8C,5): assert(false);_NEXT()
+        _OP(0x8C,6): assert(false);_NEXT()
+        _OP(0x8C,7): assert(false);_NEXT()
     /* STA abs */
-        case (0x8D<<3)|0: _SA(c->PC++);break;
-        case (0x8D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x8D<<3)|2: _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();break;
-        case (0x8D<<3)|3: _FETCH();break;
-        case (0x8D<<3)|4: assert(false);break;
-        case (0x8D<<3)|5: assert(false);break;
-        case (0x8D<<3)|6: assert(false);break;
-        case (0x8D<<3)|7: assert(false);break;
+        _OP(0x8D,0): _SA(c->PC++);_NEXT()
+        _OP(0x8D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8D,2): _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();_NEXT()
+        _OP(0x8D,3): _FETCH();_NEXT()
+        _OP(0x8D,4): assert(false);_NEXT()
+        _OP(0x8D,5): assert(false);_NEXT()
+        _OP(0x8D,6): assert(false);_NEXT()
+        _OP(0x8D,7): assert(false);_NEXT()
     /* STX abs */
-        case (0x8E<<3)|0: _SA(c->PC++);break;
-        case (0x8E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x8E<<3)|2: _SA((_GD()<<8)|c->AD);_SD(c->X);_WR();break;
-        case (0x8E<<3)|3: _FETCH();break;
-        case (0x8E<<3)|4: assert(false);break;
-        case (0x8E<<3)|5: assert(false);break;
-        case (0x8E<<3)|6: assert(false);break;
-        case (0x8E<<3)|7: assert(false);break;
+        _OP(0x8E,0): _SA(c->PC++);_NEXT()
+        _OP(0x8E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8E,2): _SA((_GD()<<8)|c->AD);_SD(c->X);_WR();_NEXT()
+        _OP(0x8E,3): _FETCH();_NEXT()
+        _OP(0x8E,4): assert(false);_NEXT()
+        _OP(0x8E,5): assert(false);_NEXT()
+        _OP(0x8E,6): assert(false);_NEXT()
+        _OP(0x8E,7): assert(false);_NEXT()
     /* SAX abs (undoc) */
-        case (0x8F<<3)|0: _SA(c->PC++);break;
-        case (0x8F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x8F<<3)|2: _SA((_GD()<<8)|c->AD);_SD(c->A&c->X);_WR();break;
-        case (0x8F<<3)|3: _FETCH();break;
-        case (0x8F<<3)|4: assert(false);break;
-        case (0x8F<<3)|5: assert(false);break;
-        case (0x8F<<3)|6: assert(false);break;
-        case (0x8F<<3)|7: assert(false);break;
+        _OP(0x8F,0): _SA(c->PC++);_NEXT()
+        _OP(0x8F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8F,2): _SA((_GD()<<8)|c->AD);_SD(c->A&c->X);_WR();_NEXT()
+        _OP(0x8F,3): _FETCH();_NEXT()
+        _OP(0x8F,4): assert(false);_NEXT()
+        _OP(0x8F,5): assert(false);_NEXT()
+        _OP(0x8F,6): assert(false);_NEXT()
+        _OP(0x8F,7): assert(false);_NEXT()
     /* BCC # */
-        case (0x90<<3)|0: _SA(c->PC++);break;
-        case (0x90<<3)|1: _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x1)!=0x0){_FETCH();};break;
-        case (0x90<<3)|2: _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};break;
-        case (0x90<<3)|3: c->PC=c->AD;_FETCH();break;
-        case (0x90<<3)|4: assert(false);break;
-        case (0x90<<3)|5: assert(false);break;
-        case (0x90<<3)|6: assert(false);break;
-        case (0x90<<3)|7: assert(false);break;
+        _OP(0x90,0): _SA(c->PC++);_NEXT()
+        _OP(0x90,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x1)!=0x0){_FETCH();};_NEXT()
+        _OP(0x90,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x90,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x90,4): assert(false);_NEXT()
+        _OP(0x90,5): assert(false);_NEXT()
+        _OP(0x90,6): assert(false);_NEXT()
+        _OP(0x90,7): assert(false);_NEXT()
     /* STA (zp),Y */
-        case (0x91<<3)|0: _SA(c->PC++);break;
-        case (0x91<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x91<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x91<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x91<<3)|4: _SA(c->AD+c->Y);_SD(c->A);_WR();break;
-        case (0x91<<3)|5: _FETCH();break;
-        case (0x91<<3)|6: assert(false);break;
-        case (0x91<<3)|7: assert(false);break;
+        _OP(0x91,0): _SA(c->PC++);_NEXT()
+        _OP(0x91,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x91,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x91,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x91,4): _SA(c->AD+c->Y);_SD(c->A);_WR();_NEXT()
+        _OP(0x91,5): _FETCH();_NEXT()
+        _OP(0x91,6): assert(false);_NEXT()
+        _OP(0x91,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0x92<<3)|0: _SA(c->PC);break;
-        case (0x92<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0x92<<3)|2: assert(false);break;
-        case (0x92<<3)|3: assert(false);break;
-        case (0x92<<3)|4: assert(false);break;
-        case (0x92<<3)|5: assert(false);break;
-        case (0x92<<3)|6: assert(false);break;
-        case (0x92<<3)|7: assert(false);break;
+        _OP(0x92,0): _SA(c->PC);_NEXT()
+        _OP(0x92,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x92,2): assert(false);_NEXT()
+        _OP(0x92,3): assert(false);_NEXT()
+        _OP(0x92,4): assert(false);_NEXT()
+        _OP(0x92,5): assert(false);_NEXT()
+        _OP(0x92,6): assert(false);_NEXT()
+        _OP(0x92,7): assert(false);_NEXT()
     /* SHA (zp),Y (undoc) */
-        case (0x93<<3)|0: _SA(c->PC++);break;
-        case (0x93<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x93<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0x93<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x93<<3)|4: _SA(c->AD+c->Y);_SD(c->A&c->X&(uint8_t)((_GA()>>8)+1));_WR();break;
-        case (0x93<<3)|5: _FETCH();break;
-        case (0x93<<3)|6: assert(false);break;
-        case (0x93<<3)|7: assert(false);break;
+        _OP(0x93,0): _SA(c->PC++);_NEXT()
+        _OP(0x93,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x93,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x93,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x93,4): _SA(c->AD+c->Y);_SD(c->A&c->X&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x93,5): _FETCH();_NEXT()
+        _OP(0x93,6): assert(false);_NEXT()
+        _OP(0x93,7): assert(false);_NEXT()
     /* STY zp,X */
-        case (0x94<<3)|0: _SA(c->PC++);break;
-        case (0x94<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x94<<3)|2: _SA((c->AD+c->X)&0x00FF);_SD(c->Y);_WR();break;
-        case (0x94<<3)|3: _FETCH();break;
-        case (0x94<<3)|4: assert(false);break;
-        case (0x94<<3)|5: assert(false);break;
-        case (0x94<<3)|6: assert(false);break;
-        case (0x94<<3)|7: assert(false);break;
+        _OP(0x94,0): _SA(c->PC++);_NEXT()
+        _OP(0x94,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x94,2): _SA((c->AD+c->X)&0x00FF);_SD(c->Y);_WR();_NEXT()
+        _OP(0x94,3): _FETCH();_NEXT()
+        _OP(0x94,4): assert(false);_NEXT()
+        _OP(0x94,5): assert(false);_NEXT()
+        _OP(0x94,6): assert(false);_NEXT()
+        _OP(0x94,7): assert(false);_NEXT()
     /* STA zp,X */
-        case (0x95<<3)|0: _SA(c->PC++);break;
-        case (0x95<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x95<<3)|2: _SA((c->AD+c->X)&0x00FF);_SD(c->A);_WR();break;
-        case (0x95<<3)|3: _FETCH();break;
-        case (0x95<<3)|4: assert(false);break;
-        case (0x95<<3)|5: assert(false);break;
-        case (0x95<<3)|6: assert(false);break;
-        case (0x95<<3)|7: assert(false);break;
+        _OP(0x95,0): _SA(c->PC++);_NEXT()
+        _OP(0x95,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x95,2): _SA((c->AD+c->X)&0x00FF);_SD(c->A);_WR();_NEXT()
+        _OP(0x95,3): _FETCH();_NEXT()
+        _OP(0x95,4): assert(false);_NEXT()
+        _OP(0x95,5): assert(false);_NEXT()
+        _OP(0x95,6): assert(false);_NEXT()
+        _OP(0x95,7): assert(false);_NEXT()
     /* STX zp,Y */
-        case (0x96<<3)|0: _SA(c->PC++);break;
-        case (0x96<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x96<<3)|2: _SA((c->AD+c->Y)&0x00FF);_SD(c->X);_WR();break;
-        case (0x96<<3)|3: _FETCH();break;
-        case (0x96<<3)|4: assert(false);break;
-        case (0x96<<3)|5: assert(false);break;
-        case (0x96<<3)|6: assert(false);break;
-        case (0x96<<3)|7: assert(false);break;
+        _OP(0x96,0): _SA(c->PC++);_NEXT()
+        _OP(0x96,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x96,2): _SA((c->AD+c->Y)&0x00FF);_SD(c->X);_WR();_NEXT()
+        _OP(0x96,3): _FETCH();_NEXT()
+        _OP(0x96,4): assert(false);_NEXT()
+        _OP(0x96,5): assert(false);_NEXT()
+        _OP(0x96,6): assert(false);_NEXT()
+        _OP(0x96,7): assert(false);_NEXT()
     /* SAX zp,Y (undoc) */
-        case (0x97<<3)|0: _SA(c->PC++);break;
-        case (0x97<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0x97<<3)|2: _SA((c->AD+c->Y)&0x00FF);_SD(c->A&c->X);_WR();break;
-        case (0x97<<3)|3: _FETCH();break;
-        case (0x97<<3)|4: assert(false);break;
-        case (0x97<<3)|5: assert(false);break;
-        case (0x97<<3)|6: assert(false);break;
-        case (0x97<<3)|7: assert(false);break;
+        _OP(0x97,0): _SA(c->PC++);_NEXT()
+        _OP(0x97,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x97,2): _SA((c->AD+c->Y)&0x00FF);_SD(c->A&c->X);_WR();_NEXT()
+        _OP(0x97,3): _FETCH();_NEXT()
+        _OP(0x97,4): assert(false);_NEXT()
+        _OP(0x97,5): assert(false);_NEXT()
+        _OP(0x97,6): assert(false);_NEXT()
+        _OP(0x97,7): assert(false);_NEXT()
     /* TYA  */
-        case (0x98<<3)|0: _SA(c->PC);break;
-        case (0x98<<3)|1: c->A=c->Y;_NZ(c->A);_FETCH();break;
-        case (0x98<<3)|2: assert(false);break;
-        case (0x98<<3)|3: assert(false);break;
-        case (0x98<<3)|4: assert(false);break;
-        case (0x98<<3)|5: assert(false);break;
-        case (0x98<<3)|6: assert(false);break;
-        case (0x98<<3)|7: assert(false);break;
+        _OP(0x98,0): _SA(c->PC);_NEXT()
+        _OP(0x98,1): c->A=c->Y;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x98,2): assert(false);_NEXT()
+        _OP(0x98,3): assert(false);_NEXT()
+        _OP(0x98,4): assert(false);_NEXT()
+        _OP(0x98,5): assert(false);_NEXT()
+        _OP(0x98,6): assert(false);_NEXT()
+        _OP(0x98,7): assert(false);_NEXT()
     /* STA abs,Y */
-        case (0x99<<3)|0: _SA(c->PC++);break;
-        case (0x99<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x99<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x99<<3)|3: _SA(c->AD+c->Y);_SD(c->A);_WR();break;
-        case (0x99<<3)|4: _FETCH();break;
-        case (0x99<<3)|5: assert(false);break;
-        case (0x99<<3)|6: assert(false);break;
-        case (0x99<<3)|7: assert(false);break;
+        _OP(0x99,0): _SA(c->PC++);_NEXT()
+        _OP(0x99,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x99,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x99,3): _SA(c->AD+c->Y);_SD(c->A);_WR();_NEXT()
+        _OP(0x99,4): _FETCH();_NEXT()
+        _OP(0x99,5): assert(false);_NEXT()
+        _OP(0x99,6): assert(false);_NEXT()
+        _OP(0x99,7): assert(false);_NEXT()
     /* TXS  */
-        case (0x9A<<3)|0: _SA(c->PC);break;
-        case (0x9A<<3)|1: c->S=c->X;_FETCH();break;
-        case (0x9A<<3)|2: assert(false);break;
-        case (0x9A<<3)|3: assert(false);break;
-        case (0x9A<<3)|4: assert(false);break;
-        case (0x9A<<3)|5: assert(false);break;
-        case (0x9A<<3)|6: assert(false);break;
-        case (0x9A<<3)|7: assert(false);break;
+        _OP(0x9A,0): _SA(c->PC);_NEXT()
+        _OP(0x9A,1): c->S=c->X;_FETCH();_NEXT()
+        _OP(0x9A,2): assert(false);_NEXT()
+        _OP(0x9A,3): assert(false);_NEXT()
+        _OP(0x9A,4): assert(false);_NEXT()
+        _OP(0x9A,5): assert(false);_NEXT()
+        _OP(0x9A,6): assert(false);_NEXT()
+        _OP(0x9A,7): assert(false);_NEXT()
     /* SHS abs,Y (undoc) */
-        case (0x9B<<3)|0: _SA(c->PC++);break;
-        case (0x9B<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x9B<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x9B<<3)|3: _SA(c->AD+c->Y);c->S=c->A&c->X;_SD(c->S&(uint8_t)((_GA()>>8)+1));_WR();break;
-        case (0x9B<<3)|4: _FETCH();break;
-        case (0x9B<<3)|5: assert(false);break;
-        case (0x9B<<3)|6: assert(false);break;
-        case (0x9B<<3)|7: assert(false);break;
+        _OP(0x9B,0): _SA(c->PC++);_NEXT()
+        _OP(0x9B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x9B,3): _SA(c->AD+c->Y);c->S=c->A&c->X;_SD(c->S&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x9B,4): _FETCH();_NEXT()
+        _OP(0x9B,5): assert(false);_NEXT()
+        _OP(0x9B,6): assert(false);_NEXT()
+        _OP(0x9B,7): assert(false);_NEXT()
     /* SHY abs,X (undoc) */
-        case (0x9C<<3)|0: _SA(c->PC++);break;
-        case (0x9C<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x9C<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x9C<<3)|3: _SA(c->AD+c->X);_SD(c->Y&(uint8_t)((_GA()>>8)+1));_WR();break;
-        case (0x9C<<3)|4: _FETCH();break;
-        case (0x9C<<3)|5: assert(false);break;
-        case (0x9C<<3)|6: assert(false);break;
-        case (0x9C<<3)|7: assert(false);break;
+        _OP(0x9C,0): _SA(c->PC++);_NEXT()
+        _OP(0x9C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x9C,3): _SA(c->AD+c->X);_SD(c->Y&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x9C,4): _FETCH();_NEXT()
+        _OP(0x9C,5): assert(false);_NEXT()
+        _OP(0x9C,6): assert(false);_NEXT()
+        _OP(0x9C,7): assert(false);_NEXT()
     /* STA abs,X */
-        case (0x9D<<3)|0: _SA(c->PC++);break;
-        case (0x9D<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x9D<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0x9D<<3)|3: _SA(c->AD+c->X);_SD(c->A);_WR();break;
-        case (0x9D<<3)|4: _FETCH();break;
-        case (0x9D<<3)|5: assert(false);break;
-        case (0x9D<<3)|6: assert(false);break;
-        case (0x9D<<3)|7: assert(false);break;
+        _OP(0x9D,0): _SA(c->PC++);_NEXT()
+        _OP(0x9D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x9D,3): _SA(c->AD+c->X);_SD(c->A);_WR();_NEXT()
+        _OP(0x9D,4): _FETCH();_NEXT()
+        _OP(0x9D,5): assert(false);_NEXT()
+        _OP(0x9D,6): assert(false);_NEXT()
+        _OP(0x9D,7): assert(false);_NEXT()
     /* SHX abs,Y (undoc) */
-        case (0x9E<<3)|0: _SA(c->PC++);break;
-        case (0x9E<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x9E<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x9E<<3)|3: _SA(c->AD+c->Y);_SD(c->X&(uint8_t)((_GA()>>8)+1));_WR();break;
-        case (0x9E<<3)|4: _FETCH();break;
-        case (0x9E<<3)|5: assert(false);break;
-        case (0x9E<<3)|6: assert(false);break;
-        case (0x9E<<3)|7: assert(false);break;
+        _OP(0x9E,0): _SA(c->PC++);_NEXT()
+        _OP(0x9E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x9E,3): _SA(c->AD+c->Y);_SD(c->X&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x9E,4): _FETCH();_NEXT()
+        _OP(0x9E,5): assert(false);_NEXT()
+        _OP(0x9E,6): assert(false);_NEXT()
+        _OP(0x9E,7): assert(false);_NEXT()
     /* SHA abs,Y (undoc) */
-        case (0x9F<<3)|0: _SA(c->PC++);break;
-        case (0x9F<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0x9F<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0x9F<<3)|3: _SA(c->AD+c->Y);_SD(c->A&c->X&(uint8_t)((_GA()>>8)+1));_WR();break;
-        case (0x9F<<3)|4: _FETCH();break;
-        case (0x9F<<3)|5: assert(false);break;
-        case (0x9F<<3)|6: assert(false);break;
-        case (0x9F<<3)|7: assert(false);break;
+        _OP(0x9F,0): _SA(c->PC++);_NEXT()
+        _OP(0x9F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x9F,3): _SA(c->AD+c->Y);_SD(c->A&c->X&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x9F,4): _FETCH();_NEXT()
+        _OP(0x9F,5): assert(false);_NEXT()
+        _OP(0x9F,6): assert(false);_NEXT()
+        _OP(0x9F,7): assert(false);_NEXT()
     /* LDY # */
-        case (0xA0<<3)|0: _SA(c->PC++);break;
-        case (0xA0<<3)|1: c->Y=_GD();_NZ(c->Y);_FETCH();break;
-        case (0xA0<<3)|2: assert(false);break;
-        case (0xA0<<3)|3: assert(false);break;
-        case (0xA0<<3)|4: assert(false);break;
-        case (0xA0<<3)|5: assert(false);break;
-        case (0xA0<<3)|6: assert(false);break;
-        case (0xA0<<3)|7: assert(false);break;
+        _OP(0xA0,0): _SA(c->PC++);_NEXT()
+        _OP(0xA0,1): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA0,2): assert(false);_NEXT()
+        _OP(0xA0,3): assert(false);_NEXT()
+        _OP(0xA0,4): assert(false);_NEXT()
+        _OP(0xA0,5): assert(false);_NEXT()
+        _OP(0xA0,6): assert(false);_NEXT()
+        _OP(0xA0,7): assert(false);_NEXT()
     /* LDA (zp,X) */
-        case (0xA1<<3)|0: _SA(c->PC++);break;
-        case (0xA1<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xA1<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0xA1<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xA1<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0xA1<<3)|5: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0xA1<<3)|6: assert(false);break;
-        case (0xA1<<3)|7: assert(false);break;
+        _OP(0xA1,0): _SA(c->PC++);_NEXT()
+        _OP(0xA1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xA1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xA1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xA1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xA1,5): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA1,6): assert(false);_NEXT()
+        _OP(0xA1,7): assert(false);_NEXT()
     /* LDX # */
-        case (0xA2<<3)|0: _SA(c->PC++);break;
-        case (0xA2<<3)|1: c->X=_GD();_NZ(c->X);_FETCH();break;
-        case (0xA2<<3)|2: assert(false);break;
-        case (0xA2<<3)|3: assert(false);break;
-        case (0xA2<<3)|4: assert(false);break;
-        case (0xA2<<3)|5: assert(false);break;
-        case (0xA2<<3)|6: assert(false);break;
-        case (0xA2<<3)|7: assert(false);break;
+        _OP(0xA2,0): _SA(c->PC++);_NEXT()
+        _OP(0xA2,1): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xA2,2): assert(false);_NEXT()
+        _OP(0xA2,3): assert(false);_NEXT()
+        _OP(0xA2,4): assert(false);_NEXT()
+        _OP(0xA2,5): assert(false);_NEXT()
+        _OP(0xA2,6): assert(false);_NEXT()
+        _OP(0xA2,7): assert(false);_NEXT()
     /* LAX (zp,X) (undoc) */
-        case (0xA3<<3)|0: _SA(c->PC++);break;
-        case (0xA3<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xA3<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0xA3<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xA3<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0xA3<<3)|5: c->A=c->X=_GD();_NZ(c->A);_FETCH();break;
-        case (0xA3<<3)|6: assert(false);break;
-        case (0xA3<<3)|7: assert(false);break;
+        _OP(0xA3,0): _SA(c->PC++);_NEXT()
+        _OP(0xA3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xA3,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xA3,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xA3,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xA3,5): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA3,6): assert(false);_NEXT()
+        _OP(0xA3,7): assert(false);_NEXT()
     /* LDY zp */
-        case (0xA4<<3)|0: _SA(c->PC++);break;
-        case (0xA4<<3)|1: _SA(_GD());break;
-        case (0xA4<<3)|2: c->Y=_GD();_NZ(c->Y);_FETCH();break;
-        case (0xA4<<3)|3: assert(false);break;
-        case (0xA4<<3)|4: assert(false);break;
-        case (0xA4<<3)|5: assert(false);break;
-        case (0xA4<<3)|6: assert(false);break;
-        case (0xA4<<3)|7: assert(false);break;
+        _OP(0xA4,0): _SA(c->PC++);_NEXT()
+        _OP(0xA4,1): _SA(_GD());_NEXT()
+        _OP(0xA4,2): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA4,3): assert(false);_NEXT()
+        _OP(0xA4,4): assert(false);_NEXT()
+        _OP(0xA4,5): assert(false);_NEXT()
+        _OP(0xA4,6): assert(false);_NEXT()
+        _OP(0xA4,7): assert(false);_NEXT()
     /* LDA zp */
-        case (0xA5<<3)|0: _SA(c->PC++);break;
-        case (0xA5<<3)|1: _SA(_GD());break;
-        case (0xA5<<3)|2: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0xA5<<3)|3: assert(false);break;
-        case (0xA5<<3)|4: assert(false);break;
-        case (0xA5<<3)|5: assert(false);break;
-        case (0xA5<<3)|6: assert(false);break;
-        case (0xA5<<3)|7: assert(false);break;
+        _OP(0xA5,0): _SA(c->PC++);_NEXT()
+        _OP(0xA5,1): _SA(_GD());_NEXT()
+        _OP(0xA5,2): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA5,3): assert(false);_NEXT()
+        _OP(0xA5,4): assert(false);_NEXT()
+        _OP(0xA5,5): assert(false);_NEXT()
+        _OP(0xA5,6): assert(false);_NEXT()
+        _OP(0xA5,7): assert(false);_NEXT()
     /* LDX zp */
-        case (0xA6<<3)|0: _SA(c->PC++);break;
-        case (0xA6<<3)|1: _SA(_GD());break;
-        case (0xA6<<3)|2: c->X=_GD();_NZ(c->X);_FETCH();break;
-        case (0xA6<<3)|3: assert(false);break;
-        case (0xA6<<3)|4: assert(false);break;
-        case (0xA6<<3)|5: assert(false);break;
-        case (0xA6<<3)|6: assert(false);break;
-        case (0xA6<<3)|7: assert(false);break;
+        _OP(0xA6,0): _SA(c->PC++);_NEXT()
+        _OP(0xA6,1): _SA(_GD());_NEXT()
+        _OP(0xA6,2): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xA6,3): assert(false);_NEXT()
+        _OP(0xA6,4): assert(false);_NEXT()
+        _OP(0xA6,5): assert(false);_NEXT()
+        _OP(0xA6,6): assert(false);_NEXT()
+        _OP(0xA6,7): assert(false);_NEXT()
     /* LAX zp (undoc) */
-        case (0xA7<<3)|0: _SA(c->PC++);break;
-        case (0xA7<<3)|1: _SA(_GD());break;
-        case (0xA7<<3)|2: c->A=c->X=_GD();_NZ(c->A);_FETCH();break;
-        case (0xA7<<3)|3: assert(false);break;
-        case (0xA7<<3)|4: assert(false);break;
-        case (0xA7<<3)|5: assert(false);break;
-        case (0xA7<<3)|6: assert(false);break;
-        case (0xA7<<3)|7: assert(false);break;
+        _OP(0xA7,0): _SA(c->PC++);_NEXT()
+        _OP(0xA7,1): _SA(_GD());_NEXT()
+        _OP(0xA7,2): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA7,3): assert(false);_NEXT()
+        _OP(0xA7,4): assert(false);_NEXT()
+        _OP(0xA7,5): assert(false);_NEXT()
+        _OP(0xA7,6): assert(false);_NEXT()
+        _OP(0xA7,7): assert(false);_NEXT()
     /* TAY  */
-        case (0xA8<<3)|0: _SA(c->PC);break;
-        case (0xA8<<3)|1: c->Y=c->A;_NZ(c->Y);_FETCH();break;
-        case (0xA8<<3)|2: assert(false);break;
-        case (0xA8<<3)|3: assert(false);break;
-        case (0xA8<<3)|4: assert(false);break;
-        case (0xA8<<3)|5: assert(false);break;
-        case (0xA8<<3)|6: assert(false);break;
-        case (0xA8<<3)|7: assert(false);break;
+        _OP(0xA8,0): _SA(c->PC);_NEXT()
+        _OP(0xA8,1): c->Y=c->A;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA8,2): assert(false);_NEXT()
+        _OP(0xA8,3): assert(false);_NEXT()
+        _OP(0xA8,4): assert(false);_NEXT()
+        _OP(0xA8,5): assert(false);_NEXT()
+        _OP(0xA8,6): assert(false);_NEXT()
+        _OP(0xA8,7): assert(false);_NEXT()
     /* LDA # */
-        case (0xA9<<3)|0: _SA(c->PC++);break;
-        case (0xA9<<3)|1: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0xA9<<3)|2: assert(false);break;
-        case (0xA9<<3)|3: assert(false);break;
-        case (0xA9<<3)|4: assert(false);break;
-        case (0xA9<<3)|5: assert(false);break;
-        case (0xA9<<3)|6: assert(false);break;
-        case (0xA9<<3)|7: assert(false);break;
+        _OP(0xA9,0): _SA(c->PC++);_NEXT()
+        _OP(0xA9,1): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA9,2): assert(false);_NEXT()
+        _OP(0xA9,3): assert(false);_NEXT()
+        _OP(0xA9,4): assert(false);_NEXT()
+        _OP(0xA9,5): assert(false);_NEXT()
+        _OP(0xA9,6): assert(false);_NEXT()
+        _OP(0xA9,7): assert(false);_NEXT()
     /* TAX  */
-        case (0xAA<<3)|0: _SA(c->PC);break;
-        case (0xAA<<3)|1: c->X=c->A;_NZ(c->X);_FETCH();break;
-        case (0xAA<<3)|2: assert(false);break;
-        case (0xAA<<3)|3: assert(false);break;
-        case (0xAA<<3)|4: assert(false);break;
-        case (0xAA<<3)|5: assert(false);break;
-        case (0xAA<<3)|6: assert(false);break;
-        case (0xAA<<3)|7: assert(false);break;
+        _OP(0xAA,0): _SA(c->PC);_NEXT()
+        _OP(0xAA,1): c->X=c->A;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xAA,2): assert(false);_NEXT()
+        _OP(0xAA,3): assert(false);_NEXT()
+        _OP(0xAA,4): assert(false);_NEXT()
+        _OP(0xAA,5): assert(false);_NEXT()
+        _OP(0xAA,6): assert(false);_NEXT()
+        _OP(0xAA,7): assert(false);_NEXT()
     /* LXA # (undoc) */
-        case (0xAB<<3)|0: _SA(c->PC++);break;
-        case (0xAB<<3)|1: c->A=c->X=(c->A|0xEE)&_GD();_NZ(c->A);_FETCH();break;
-        case (0xAB<<3)|2: assert(false);break;
-        case (0xAB<<3)|3: assert(false);break;
-        case (0xAB<<3)|4: assert(false);break;
-        case (0xAB<<3)|5: assert(false);break;
-        case (0xAB<<3)|6: assert(false);break;
-        case (0xAB<<3)|7: assert(false);break;
+        _OP(0xAB,0): _SA(c->PC++);_NEXT()
+        _OP(0xAB,1): c->A=c->X=(c->A|0xEE)&_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xAB,2): assert(false);_NEXT()
+        _OP(0xAB,3): assert(false);_NEXT()
+        _OP(0xAB,4): assert(false);_NEXT()
+        _OP(0xAB,5): assert(false);_NEXT()
+        _OP(0xAB,6): assert(false);_NEXT()
+        _OP(0xAB,7): assert(false);_NEXT()
     /* LDY abs */
-        case (0xAC<<3)|0: _SA(c->PC++);break;
-        case (0xAC<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xAC<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xAC<<3)|3: c->Y=_GD();_NZ(c->Y);_FETCH();break;
-        case (0xAC<<3)|4: assert(false);break;
-        case (0xAC<<3)|5: assert(false);break;
-        case (0xAC<<3)|6: assert(false);break;
-        case (0xAC<<3)|7: assert(false);break;
+        _OP(0xAC,0): _SA(c->PC++);_NEXT()
+        _OP(0xAC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAC,3): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xAC,4): assert(false);_NEXT()
+        _OP(0xAC,5): assert(false);_NEXT()
+        _OP(0xAC,6): assert(false);_NEXT()
+        _OP(0xAC,7): assert(false);_NEXT()
     /* LDA abs */
-        case (0xAD<<3)|0: _SA(c->PC++);break;
-        case (0xAD<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xAD<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xAD<<3)|3: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0xAD<<3)|4: assert(false);break;
-        case (0xAD<<3)|5: assert(false);break;
-        case (0xAD<<3)|6: assert(false);break;
-        case (0xAD<<3)|7: assert(false);break;
+        _OP(0xAD,0): _SA(c->PC++);_NEXT()
+        _OP(0xAD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAD,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAD,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xAD,4): assert(false);_NEXT()
+        _OP(0xAD,5): assert(false);_NEXT()
+        _OP(0xAD,6): assert(false);_NEXT()
+        _OP(0xAD,7): assert(false);_NEXT()
     /* LDX abs */
-        case (0xAE<<3)|0: _SA(c->PC++);break;
-        case (0xAE<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xAE<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xAE<<3)|3: c->X=_GD();_NZ(c->X);_FETCH();break;
-        case (0xAE<<3)|4: assert(false);break;
-        case (0xAE<<3)|5: assert(false);break;
-        case (0xAE<<3)|6: assert(false);break;
-        case (0xAE<<3)|7: assert(false);break;
+        _OP(0xAE,0): _SA(c->PC++);_NEXT()
+        _OP(0xAE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAE,3): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xAE,4): assert(false);_NEXT()
+        _OP(0xAE,5): assert(false);_NEXT()
+        _OP(0xAE,6): assert(false);_NEXT()
+        _OP(0xAE,7): assert(false);_NEXT()
     /* LAX abs (undoc) */
-        case (0xAF<<3)|0: _SA(c->PC++);break;
-        case (0xAF<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xAF<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xAF<<3)|3: c->A=c->X=_GD();_NZ(c->A);_FETCH();break;
-        case (0xAF<<3)|4: assert(false);break;
-        case (0xAF<<3)|5: assert(false);break;
-        case (0xAF<<3)|6: assert(false);break;
-        case (0xAF<<3)|7: assert(false);break;
+        _OP(0xAF,0): _SA(c->PC++);_NEXT()
+        _OP(0xAF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAF,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAF,3): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xAF,4): assert(false);_NEXT()
+        _OP(0xAF,5): assert(false);_NEXT()
+        _OP(0xAF,6): assert(false);_NEXT()
+        _OP(0xAF,7): assert(false);_NEXT()
     /* BCS # */
-        case (0xB0<<3)|0: _SA(c->PC++);break;
-        case (0xB0<<3)|1: _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x1)!=0x1){_FETCH();};break;
-        case (0xB0<<3)|2: _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};break;
-        case (0xB0<<3)|3: c->PC=c->AD;_FETCH();break;
-        case (0xB0<<3)|4: assert(false);break;
-        case (0xB0<<3)|5: assert(false);break;
-        case (0xB0<<3)|6: assert(false);break;
-        case (0xB0<<3)|7: assert(false);break;
+        _OP(0xB0,0): _SA(c->PC++);_NEXT()
+        _OP(0xB0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x1)!=0x1){_FETCH();};_NEXT()
+        _OP(0xB0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xB0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xB0,4): assert(false);_NEXT()
+        _OP(0xB0,5): assert(false);_NEXT()
+        _OP(0xB0,6): assert(false);_NEXT()
+        _OP(0xB0,7): assert(false);_NEXT()
     /* LDA (zp),Y */
-        case (0xB1<<3)|0: _SA(c->PC++);break;
-        case (0xB1<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xB1<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xB1<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xB1<<3)|4: _SA(c->AD+c->Y);break;
-        case (0xB1<<3)|5: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0xB1<<3)|6: assert(false);break;
-        case (0xB1<<3)|7: assert(false);break;
+        _OP(0xB1,0): _SA(c->PC++);_NEXT()
+        _OP(0xB1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xB1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xB1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xB1,5): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB1,6): assert(false);_NEXT()
+        _OP(0xB1,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0xB2<<3)|0: _SA(c->PC);break;
-        case (0xB2<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0xB2<<3)|2: assert(false);break;
-        case (0xB2<<3)|3: assert(false);break;
-        case (0xB2<<3)|4: assert(false);break;
-        case (0xB2<<3)|5: assert(false);break;
-        case (0xB2<<3)|6: assert(false);break;
-        case (0xB2<<3)|7: assert(false);break;
+        _OP(0xB2,0): _SA(c->PC);_NEXT()
+        _OP(0xB2,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0xB2,2): assert(false);_NEXT()
+        _OP(0xB2,3): assert(false);_NEXT()
+        _OP(0xB2,4): assert(false);_NEXT()
+        _OP(0xB2,5): assert(false);_NEXT()
+        _OP(0xB2,6): assert(false);_NEXT()
+        _OP(0xB2,7): assert(false);_NEXT()
     /* LAX (zp),Y (undoc) */
-        case (0xB3<<3)|0: _SA(c->PC++);break;
-        case (0xB3<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xB3<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xB3<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xB3<<3)|4: _SA(c->AD+c->Y);break;
-        case (0xB3<<3)|5: c->A=c->X=_GD();_NZ(c->A);_FETCH();break;
-        case (0xB3<<3)|6: assert(false);break;
-        case (0xB3<<3)|7: assert(false);break;
+        _OP(0xB3,0): _SA(c->PC++);_NEXT()
+        _OP(0xB3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB3,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xB3,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xB3,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xB3,5): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB3,6): assert(false);_NEXT()
+        _OP(0xB3,7): assert(false);_NEXT()
     /* LDY zp,X */
-        case (0xB4<<3)|0: _SA(c->PC++);break;
-        case (0xB4<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xB4<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xB4<<3)|3: c->Y=_GD();_NZ(c->Y);_FETCH();break;
-        case (0xB4<<3)|4: assert(false);break;
-        case (0xB4<<3)|5: assert(false);break;
-        case (0xB4<<3)|6: assert(false);break;
-        case (0xB4<<3)|7: assert(false);break;
+        _OP(0xB4,0): _SA(c->PC++);_NEXT()
+        _OP(0xB4,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB4,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xB4,3): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xB4,4): assert(false);_NEXT()
+        _OP(0xB4,5): assert(false);_NEXT()
+        _OP(0xB4,6): assert(false);_NEXT()
+        _OP(0xB4,7): assert(false);_NEXT()
     /* LDA zp,X */
-        case (0xB5<<3)|0: _SA(c->PC++);break;
-        case (0xB5<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xB5<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xB5<<3)|3: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0xB5<<3)|4: assert(false);break;
-        case (0xB5<<3)|5: assert(false);break;
-        case (0xB5<<3)|6: assert(false);break;
-        case (0xB5<<3)|7: assert(false);break;
+        _OP(0xB5,0): _SA(c->PC++);_NEXT()
+        _OP(0xB5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xB5,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB5,4): assert(false);_NEXT()
+        _OP(0xB5,5): assert(false);_NEXT()
+        _OP(0xB5,6): assert(false);_NEXT()
+        _OP(0xB5,7): assert(false);_NEXT()
     /* LDX zp,Y */
-        case (0xB6<<3)|0: _SA(c->PC++);break;
-        case (0xB6<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xB6<<3)|2: _SA((c->AD+c->Y)&0x00FF);break;
-        case (0xB6<<3)|3: c->X=_GD();_NZ(c->X);_FETCH();break;
-        case (0xB6<<3)|4: assert(false);break;
-        case (0xB6<<3)|5: assert(false);break;
-        case (0xB6<<3)|6: assert(false);break;
-        case (0xB6<<3)|7: assert(false);break;
+        _OP(0xB6,0): _SA(c->PC++);_NEXT()
+        _OP(0xB6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB6,2): _SA((c->AD+c->Y)&0x00FF);_NEXT()
+        _OP(0xB6,3): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xB6,4): assert(false);_NEXT()
+        _OP(0xB6,5): assert(false);_NEXT()
+        _OP(0xB6,6): assert(false);_NEXT()
+        _OP(0xB6,7): assert(false);_NEXT()
     /* LAX zp,Y (undoc) */
-        case (0xB7<<3)|0: _SA(c->PC++);break;
-        case (0xB7<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xB7<<3)|2: _SA((c->AD+c->Y)&0x00FF);break;
-        case (0xB7<<3)|3: c->A=c->X=_GD();_NZ(c->A);_FETCH();break;
-        case (0xB7<<3)|4: assert(false);break;
-        case (0xB7<<3)|5: assert(false);break;
-        case (0xB7<<3)|6: assert(false);break;
-        case (0xB7<<3)|7: assert(false);break;
+        _OP(0xB7,0): _SA(c->PC++);_NEXT()
+        _OP(0xB7,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB7,2): _SA((c->AD+c->Y)&0x00FF);_NEXT()
+        _OP(0xB7,3): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB7,4): assert(false);_NEXT()
+        _OP(0xB7,5): assert(false);_NEXT()
+        _OP(0xB7,6): assert(false);_NEXT()
+        _OP(0xB7,7): assert(false);_NEXT()
     /* CLV  */
-        case (0xB8<<3)|0: _SA(c->PC);break;
-        case (0xB8<<3)|1: c->P&=~0x40;_FETCH();break;
-        case (0xB8<<3)|2: assert(false);break;
-        case (0xB8<<3)|3: assert(false);break;
-        case (0xB8<<3)|4: assert(false);break;
-        case (0xB8<<3)|5: assert(false);break;
-        case (0xB8<<3)|6: assert(false);break;
-        case (0xB8<<3)|7: assert(false);break;
+        _OP(0xB8,0): _SA(c->PC);_NEXT()
+        _OP(0xB8,1): c->P&=~0x40;_FETCH();_NEXT()
+        _OP(0xB8,2): assert(false);_NEXT()
+        _OP(0xB8,3): assert(false);_NEXT()
+        _OP(0xB8,4): assert(false);_NEXT()
+        _OP(0xB8,5): assert(false);_NEXT()
+        _OP(0xB8,6): assert(false);_NEXT()
+        _OP(0xB8,7): assert(false);_NEXT()
     /* LDA abs,Y */
-        case (0xB9<<3)|0: _SA(c->PC++);break;
-        case (0xB9<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xB9<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xB9<<3)|3: _SA(c->AD+c->Y);break;
-        case (0xB9<<3)|4: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0xB9<<3)|5: assert(false);break;
-        case (0xB9<<3)|6: assert(false);break;
-        case (0xB9<<3)|7: assert(false);break;
+        _OP(0xB9,0): _SA(c->PC++);_NEXT()
+        _OP(0xB9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xB9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xB9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xB9,4): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB9,5): assert(false);_NEXT()
+        _OP(0xB9,6): assert(false);_NEXT()
+        _OP(0xB9,7): assert(false);_NEXT()
     /* TSX  */
-        case (0xBA<<3)|0: _SA(c->PC);break;
-        case (0xBA<<3)|1: c->X=c->S;_NZ(c->X);_FETCH();break;
-        case (0xBA<<3)|2: assert(false);break;
-        case (0xBA<<3)|3: assert(false);break;
-        case (0xBA<<3)|4: assert(false);break;
-        case (0xBA<<3)|5: assert(false);break;
-        case (0xBA<<3)|6: assert(false);break;
-        case (0xBA<<3)|7: assert(false);break;
+        _OP(0xBA,0): _SA(c->PC);_NEXT()
+        _OP(0xBA,1): c->X=c->S;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xBA,2): assert(false);_NEXT()
+        _OP(0xBA,3): assert(false);_NEXT()
+        _OP(0xBA,4): assert(false);_NEXT()
+        _OP(0xBA,5): assert(false);_NEXT()
+        _OP(0xBA,6): assert(false);_NEXT()
+        _OP(0xBA,7): assert(false);_NEXT()
     /* LAS abs,Y (undoc) */
-        case (0xBB<<3)|0: _SA(c->PC++);break;
-        case (0xBB<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xBB<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xBB<<3)|3: _SA(c->AD+c->Y);break;
-        case (0xBB<<3)|4: c->A=c->X=c->S=_GD()&c->S;_NZ(c->A);_FETCH();break;
-        case (0xBB<<3)|5: assert(false);break;
-        case (0xBB<<3)|6: assert(false);break;
-        case (0xBB<<3)|7: assert(false);break;
+        _OP(0xBB,0): _SA(c->PC++);_NEXT()
+        _OP(0xBB,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBB,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xBB,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xBB,4): c->A=c->X=c->S=_GD()&c->S;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xBB,5): assert(false);_NEXT()
+        _OP(0xBB,6): assert(false);_NEXT()
+        _OP(0xBB,7): assert(false);_NEXT()
     /* LDY abs,X */
-        case (0xBC<<3)|0: _SA(c->PC++);break;
-        case (0xBC<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xBC<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0xBC<<3)|3: _SA(c->AD+c->X);break;
-        case (0xBC<<3)|4: c->Y=_GD();_NZ(c->Y);_FETCH();break;
-        case (0xBC<<3)|5: assert(false);break;
-        case (0xBC<<3)|6: assert(false);break;
-        case (0xBC<<3)|7: assert(false);break;
+        _OP(0xBC,0): _SA(c->PC++);_NEXT()
+        _OP(0xBC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBC,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xBC,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xBC,4): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xBC,5): assert(false);_NEXT()
+        _OP(0xBC,6): assert(false);_NEXT()
+        _OP(0xBC,7): assert(false);_NEXT()
     /* LDA abs,X */
-        case (0xBD<<3)|0: _SA(c->PC++);break;
-        case (0xBD<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xBD<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0xBD<<3)|3: _SA(c->AD+c->X);break;
-        case (0xBD<<3)|4: c->A=_GD();_NZ(c->A);_FETCH();break;
-        case (0xBD<<3)|5: assert(false);break;
-        case (0xBD<<3)|6: assert(false);break;
-        case (0xBD<<3)|7: assert(false);break;
+        _OP(0xBD,0): _SA(c->PC++);_NEXT()
+        _OP(0xBD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xBD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xBD,4): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xBD,5): assert(false);_NEXT()
+        _OP(0xBD,6): assert(false);_NEXT()
+        _OP(0xBD,7): assert(false);_NEXT()
     /* LDX abs,Y */
-        case (0xBE<<3)|0: _SA(c->PC++);break;
-        case (0xBE<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xBE<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xBE<<3)|3: _SA(c->AD+c->Y);break;
-        case (0xBE<<3)|4: c->X=_GD();_NZ(c->X);_FETCH();break;
-        case (0xBE<<3)|5: assert(false);break;
-        case (0xBE<<3)|6: assert(false);break;
-        case (0xBE<<3)|7: assert(false);break;
+        _OP(0xBE,0): _SA(c->PC++);_NEXT()
+        _OP(0xBE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xBE,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xBE,4): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xBE,5): assert(false);_NEXT()
+        _OP(0xBE,6): assert(false);_NEXT()
+        _OP(0xBE,7): assert(false);_NEXT()
     /* LAX abs,Y (undoc) */
-        case (0xBF<<3)|0: _SA(c->PC++);break;
-        case (0xBF<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xBF<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xBF<<3)|3: _SA(c->AD+c->Y);break;
-        case (0xBF<<3)|4: c->A=c->X=_GD();_NZ(c->A);_FETCH();break;
-        case (0xBF<<3)|5: assert(false);break;
-        case (0xBF<<3)|6: assert(false);break;
-        case (0xBF<<3)|7: assert(false);break;
+        _OP(0xBF,0): _SA(c->PC++);_NEXT()
+        _OP(0xBF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBF,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xBF,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xBF,4): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xBF,5): assert(false);_NEXT()
+        _OP(0xBF,6): assert(false);_NEXT()
+        _OP(0xBF,7): assert(false);_NEXT()
     /* CPY # */
-        case (0xC0<<3)|0: _SA(c->PC++);break;
-        case (0xC0<<3)|1: _m6502_cmp(c, c->Y, _GD());_FETCH();break;
-        case (0xC0<<3)|2: assert(false);break;
-        case (0xC0<<3)|3: assert(false);break;
-        case (0xC0<<3)|4: assert(false);break;
-        case (0xC0<<3)|5: assert(false);break;
-        case (0xC0<<3)|6: assert(false);break;
-        case (0xC0<<3)|7: assert(false);break;
+        _OP(0xC0,0): _SA(c->PC++);_NEXT()
+        _OP(0xC0,1): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xC0,2): assert(false);_NEXT()
+        _OP(0xC0,3): assert(false);_NEXT()
+        _OP(0xC0,4): assert(false);_NEXT()
+        _OP(0xC0,5): assert(false);_NEXT()
+        _OP(0xC0,6): assert(false);_NEXT()
+        _OP(0xC0,7): assert(false);_NEXT()
     /* CMP (zp,X) */
-        case (0xC1<<3)|0: _SA(c->PC++);break;
-        case (0xC1<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xC1<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0xC1<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xC1<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0xC1<<3)|5: _m6502_cmp(c, c->A, _GD());_FETCH();break;
-        case (0xC1<<3)|6: assert(false);break;
-        case (0xC1<<3)|7: assert(false);break;
+        _OP(0xC1,0): _SA(c->PC++);_NEXT()
+        _OP(0xC1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xC1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xC1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xC1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xC1,5): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC1,6): assert(false);_NEXT()
+        _OP(0xC1,7): assert(false);_NEXT()
     /* NOP # (undoc) */
-        case (0xC2<<3)|0: _SA(c->PC++);break;
-        case (0xC2<<3)|1: _FETCH();break;
-        case (0xC2<<3)|2: assert(false);break;
-        case (0xC2<<3)|3: assert(false);break;
-        case (0xC2<<3)|4: assert(false);break;
-        case (0xC2<<3)|5: assert(false);break;
-        case (0xC2<<3)|6: assert(false);break;
-        case (0xC2<<3)|7: assert(false);break;
+        _OP(0xC2,0): _SA(c->PC++);_NEXT()
+        _OP(0xC2,1): _FETCH();_NEXT()
+        _OP(0xC2,2): assert(false);_NEXT()
+        _OP(0xC2,3): assert(false);_NEXT()
+        _OP(0xC2,4): assert(false);_NEXT()
+        _OP(0xC2,5): assert(false);_NEXT()
+        _OP(0xC2,6): assert(false);_NEXT()
+        _OP(0xC2,7): assert(false);_NEXT()
     /* DCP (zp,X) (undoc) */
-        case (0xC3<<3)|0: _SA(c->PC++);break;
-        case (0xC3<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xC3<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0xC3<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xC3<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0xC3<<3)|5: c->AD=_GD();_WR();break;
-        case (0xC3<<3)|6: c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();break;
-        case (0xC3<<3)|7: _FETCH();break;
+        _OP(0xC3,0): _SA(c->PC++);_NEXT()
+        _OP(0xC3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xC3,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xC3,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xC3,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xC3,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0xC3,6): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xC3,7): _FETCH();_NEXT()
     /* CPY zp */
-        case (0xC4<<3)|0: _SA(c->PC++);break;
-        case (0xC4<<3)|1: _SA(_GD());break;
-        case (0xC4<<3)|2: _m6502_cmp(c, c->Y, _GD());_FETCH();break;
-        case (0xC4<<3)|3: assert(false);break;
-        case (0xC4<<3)|4: assert(false);break;
-        case (0xC4<<3)|5: assert(false);break;
-        case (0xC4<<3)|6: assert(false);break;
-        case (0xC4<<3)|7: assert(false);break;
+        _OP(0xC4,0): _SA(c->PC++);_NEXT()
+        _OP(0xC4,1): _SA(_GD());_NEXT()
+        _OP(0xC4,2): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xC4,3): assert(false);_NEXT()
+        _OP(0xC4,4): assert(false);_NEXT()
+        _OP(0xC4,5): assert(false);_NEXT()
+        _OP(0xC4,6): assert(false);_NEXT()
+        _OP(0xC4,7): assert(false);_NEXT()
     /* CMP zp */
-        case (0xC5<<3)|0: _SA(c->PC++);break;
-        case (0xC5<<3)|1: _SA(_GD());break;
-        case (0xC5<<3)|2: _m6502_cmp(c, c->A, _GD());_FETCH();break;
-        case (0xC5<<3)|3: assert(false);break;
-        case (0xC5<<3)|4: assert(false);break;
-        case (0xC5<<3)|5: assert(false);break;
-        case (0xC5<<3)|6: assert(false);break;
-        case (0xC5<<3)|7: assert(false);break;
+        _OP(0xC5,0): _SA(c->PC++);_NEXT()
+        _OP(0xC5,1): _SA(_GD());_NEXT()
+        _OP(0xC5,2): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC5,3): assert(false);_NEXT()
+        _OP(0xC5,4): assert(false);_NEXT()
+        _OP(0xC5,5): assert(false);_NEXT()
+        _OP(0xC5,6): assert(false);_NEXT()
+        _OP(0xC5,7): assert(false);_NEXT()
     /* DEC zp */
-        case (0xC6<<3)|0: _SA(c->PC++);break;
-        case (0xC6<<3)|1: _SA(_GD());break;
-        case (0xC6<<3)|2: c->AD=_GD();_WR();break;
-        case (0xC6<<3)|3: c->AD--;_NZ(c->AD);_SD(c->AD);_WR();break;
-        case (0xC6<<3)|4: _FETCH();break;
-        case (0xC6<<3)|5: assert(false);break;
-        case (0xC6<<3)|6: assert(false);break;
-        case (0xC6<<3)|7: assert(false);break;
+        _OP(0xC6,0): _SA(c->PC++);_NEXT()
+        _OP(0xC6,1): _SA(_GD());_NEXT()
+        _OP(0xC6,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0xC6,3): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xC6,4): _FETCH();_NEXT()
+        _OP(0xC6,5): assert(false);_NEXT()
+        _OP(0xC6,6): assert(false);_NEXT()
+        _OP(0xC6,7): assert(false);_NEXT()
     /* DCP zp (undoc) */
-        case (0xC7<<3)|0: _SA(c->PC++);break;
-        case (0xC7<<3)|1: _SA(_GD());break;
-        case (0xC7<<3)|2: c->AD=_GD();_WR();break;
-        case (0xC7<<3)|3: c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();break;
-        case (0xC7<<3)|4: _FETCH();break;
-        case (0xC7<<3)|5: assert(false);break;
-        case (0xC7<<3)|6: assert(false);break;
-        case (0xC7<<3)|7: assert(false);break;
+        _OP(0xC7,0): _SA(c->PC++);_NEXT()
+        _OP(0xC7,1): _SA(_GD());_NEXT()
+        _OP(0xC7,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0xC7,3): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xC7,4): _FETCH();_NEXT()
+        _OP(0xC7,5): assert(false);_NEXT()
+        _OP(0xC7,6): assert(false);_NEXT()
+        _OP(0xC7,7): assert(false);_NEXT()
     /* INY  */
-        case (0xC8<<3)|0: _SA(c->PC);break;
-        case (0xC8<<3)|1: c->Y++;_NZ(c->Y);_FETCH();break;
-        case (0xC8<<3)|2: assert(false);break;
-        case (0xC8<<3)|3: assert(false);break;
-        case (0xC8<<3)|4: assert(false);break;
-        case (0xC8<<3)|5: assert(false);break;
-        case (0xC8<<3)|6: assert(false);break;
-        case (0xC8<<3)|7: assert(false);break;
+        _OP(0xC8,0): _SA(c->PC);_NEXT()
+        _OP(0xC8,1): c->Y++;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xC8,2): assert(false);_NEXT()
+        _OP(0xC8,3): assert(false);_NEXT()
+        _OP(0xC8,4): assert(false);_NEXT()
+        _OP(0xC8,5): assert(false);_NEXT()
+        _OP(0xC8,6): assert(false);_NEXT()
+        _OP(0xC8,7): assert(false);_NEXT()
     /* CMP # */
-        case (0xC9<<3)|0: _SA(c->PC++);break;
-        case (0xC9<<3)|1: _m6502_cmp(c, c->A, _GD());_FETCH();break;
-        case (0xC9<<3)|2: assert(false);break;
-        case (0xC9<<3)|3: assert(false);break;
-        case (0xC9<<3)|4: assert(false);break;
-        case (0xC9<<3)|5: assert(false);break;
-        case (0xC9<<3)|6: assert(false);break;
-        case (0xC9<<3)|7: assert(false);break;
+        _OP(0xC9,0): _SA(c->PC++);_NEXT()
+        _OP(0xC9,1): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC9,2): assert(false);_NEXT()
+        _OP(0xC9,3): assert(false);_NEXT()
+        _OP(0xC9,4): assert(false);_NEXT()
+        _OP(0xC9,5): assert(false);_NEXT()
+        _OP(0xC9,6): assert(false);_NEXT()
+        _OP(0xC9,7): assert(false);_NEXT()
     /* DEX  */
-        case (0xCA<<3)|0: _SA(c->PC);break;
-        case (0xCA<<3)|1: c->X--;_NZ(c->X);_FETCH();break;
-        case (0xCA<<3)|2: assert(false);break;
-        case (0xCA<<3)|3: assert(false);break;
-        case (0xCA<<3)|4: assert(false);break;
-        case (0xCA<<3)|5: assert(false);break;
-        case (0xCA<<3)|6: assert(false);break;
-        case (0xCA<<3)|7: assert(false);break;
+        _OP(0xCA,0): _SA(c->PC);_NEXT()
+        _OP(0xCA,1): c->X--;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xCA,2): assert(false);_NEXT()
+        _OP(0xCA,3): assert(false);_NEXT()
+        _OP(0xCA,4): assert(false);_NEXT()
+        _OP(0xCA,5): assert(false);_NEXT()
+        _OP(0xCA,6): assert(false);_NEXT()
+        _OP(0xCA,7): assert(false);_NEXT()
     /* SBX # (undoc) */
-        case (0xCB<<3)|0: _SA(c->PC++);break;
-        case (0xCB<<3)|1: _m6502_sbx(c, _GD());_FETCH();break;
-        case (0xCB<<3)|2: assert(false);break;
-        case (0xCB<<3)|3: assert(false);break;
-        case (0xCB<<3)|4: assert(false);break;
-        case (0xCB<<3)|5: assert(false);break;
-        case (0xCB<<3)|6: assert(false);break;
-        case (0xCB<<3)|7: assert(false);break;
+        _OP(0xCB,0): _SA(c->PC++);_NEXT()
+        _OP(0xCB,1): _m6502_sbx(c, _GD());_FETCH();_NEXT()
+        _OP(0xCB,2): assert(false);_NEXT()
+        _OP(0xCB,3): assert(false);_NEXT()
+        _OP(0xCB,4): assert(false);_NEXT()
+        _OP(0xCB,5): assert(false);_NEXT()
+        _OP(0xCB,6): assert(false);_NEXT()
+        _OP(0xCB,7): assert(false);_NEXT()
     /* CPY abs */
-        case (0xCC<<3)|0: _SA(c->PC++);break;
-        case (0xCC<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xCC<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xCC<<3)|3: _m6502_cmp(c, c->Y, _GD());_FETCH();break;
-        case (0xCC<<3)|4: assert(false);break;
-        case (0xCC<<3)|5: assert(false);break;
-        case (0xCC<<3)|6: assert(false);break;
-        case (0xCC<<3)|7: assert(false);break;
+        _OP(0xCC,0): _SA(c->PC++);_NEXT()
+        _OP(0xCC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCC,3): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xCC,4): assert(false);_NEXT()
+        _OP(0xCC,5): assert(false);_NEXT()
+        _OP(0xCC,6): assert(false);_NEXT()
+        _OP(0xCC,7): assert(false);_NEXT()
     /* CMP abs */
-        case (0xCD<<3)|0: _SA(c->PC++);break;
-        case (0xCD<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xCD<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xCD<<3)|3: _m6502_cmp(c, c->A, _GD());_FETCH();break;
-        case (0xCD<<3)|4: assert(false);break;
-        case (0xCD<<3)|5: assert(false);break;
-        case (0xCD<<3)|6: assert(false);break;
-        case (0xCD<<3)|7: assert(false);break;
+        _OP(0xCD,0): _SA(c->PC++);_NEXT()
+        _OP(0xCD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCD,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCD,3): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xCD,4): assert(false);_NEXT()
+        _OP(0xCD,5): assert(false);_NEXT()
+        _OP(0xCD,6): assert(false);_NEXT()
+        _OP(0xCD,7): assert(false);_NEXT()
     /* DEC abs */
-        case (0xCE<<3)|0: _SA(c->PC++);break;
-        case (0xCE<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xCE<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xCE<<3)|3: c->AD=_GD();_WR();break;
-        case (0xCE<<3)|4: c->AD--;_NZ(c->AD);_SD(c->AD);_WR();break;
-        case (0xCE<<3)|5: _FETCH();break;
-        case (0xCE<<3)|6: assert(false);break;
-        case (0xCE<<3)|7: assert(false);break;
+        _OP(0xCE,0): _SA(c->PC++);_NEXT()
+        _OP(0xCE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCE,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xCE,4): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xCE,5): _FETCH();_NEXT()
+        _OP(0xCE,6): assert(false);_NEXT()
+        _OP(0xCE,7): assert(false);_NEXT()
     /* DCP abs (undoc) */
-        case (0xCF<<3)|0: _SA(c->PC++);break;
-        case (0xCF<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xCF<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xCF<<3)|3: c->AD=_GD();_WR();break;
-        case (0xCF<<3)|4: c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();break;
-        case (0xCF<<3)|5: _FETCH();break;
-        case (0xCF<<3)|6: assert(false);break;
-        case (0xCF<<3)|7: assert(false);break;
+        _OP(0xCF,0): _SA(c->PC++);_NEXT()
+        _OP(0xCF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCF,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCF,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xCF,4): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xCF,5): _FETCH();_NEXT()
+        _OP(0xCF,6): assert(false);_NEXT()
+        _OP(0xCF,7): assert(false);_NEXT()
     /* BNE # */
-        case (0xD0<<3)|0: _SA(c->PC++);break;
-        case (0xD0<<3)|1: _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x2)!=0x0){_FETCH();};break;
-        case (0xD0<<3)|2: _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};break;
-        case (0xD0<<3)|3: c->PC=c->AD;_FETCH();break;
-        case (0xD0<<3)|4: assert(false);break;
-        case (0xD0<<3)|5: assert(false);break;
-        case (0xD0<<3)|6: assert(false);break;
-        case (0xD0<<3)|7: assert(false);break;
+        _OP(0xD0,0): _SA(c->PC++);_NEXT()
+        _OP(0xD0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x2)!=0x0){_FETCH();};_NEXT()
+        _OP(0xD0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xD0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xD0,4): assert(false);_NEXT()
+        _OP(0xD0,5): assert(false);_NEXT()
+        _OP(0xD0,6): assert(false);_NEXT()
+        _OP(0xD0,7): assert(false);_NEXT()
     /* CMP (zp),Y */
-        case (0xD1<<3)|0: _SA(c->PC++);break;
-        case (0xD1<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xD1<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xD1<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xD1<<3)|4: _SA(c->AD+c->Y);break;
-        case (0xD1<<3)|5: _m6502_cmp(c, c->A, _GD());_FETCH();break;
-        case (0xD1<<3)|6: assert(false);break;
-        case (0xD1<<3)|7: assert(false);break;
+        _OP(0xD1,0): _SA(c->PC++);_NEXT()
+        _OP(0xD1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xD1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xD1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xD1,5): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD1,6): assert(false);_NEXT()
+        _OP(0xD1,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0xD2<<3)|0: _SA(c->PC);break;
-        case (0xD2<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0xD2<<3)|2: assert(false);break;
-        case (0xD2<<3)|3: assert(false);break;
-        case (0xD2<<3)|4: assert(false);break;
-        case (0xD2<<3)|5: assert(false);break;
-        case (0xD2<<3)|6: assert(false);break;
-        case (0xD2<<3)|7: assert(false);break;
+        _OP(0xD2,0): _SA(c->PC);_NEXT()
+        _OP(0xD2,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0xD2,2): assert(false);_NEXT()
+        _OP(0xD2,3): assert(false);_NEXT()
+        _OP(0xD2,4): assert(false);_NEXT()
+        _OP(0xD2,5): assert(false);_NEXT()
+        _OP(0xD2,6): assert(false);_NEXT()
+        _OP(0xD2,7): assert(false);_NEXT()
     /* DCP (zp),Y (undoc) */
-        case (0xD3<<3)|0: _SA(c->PC++);break;
-        case (0xD3<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xD3<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xD3<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0xD3<<3)|4: _SA(c->AD+c->Y);break;
-        case (0xD3<<3)|5: c->AD=_GD();_WR();break;
-        case (0xD3<<3)|6: c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();break;
-        case (0xD3<<3)|7: _FETCH();break;
+        _OP(0xD3,0): _SA(c->PC++);_NEXT()
+        _OP(0xD3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD3,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xD3,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0xD3,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xD3,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0xD3,6): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xD3,7): _FETCH();_NEXT()
     /* NOP zp,X (undoc) */
-        case (0xD4<<3)|0: _SA(c->PC++);break;
-        case (0xD4<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xD4<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xD4<<3)|3: _FETCH();break;
-        case (0xD4<<3)|4: assert(false);break;
-        case (0xD4<<3)|5: assert(false);break;
-        case (0xD4<<3)|6: assert(false);break;
-        case (0xD4<<3)|7: assert(false);break;
+        _OP(0xD4,0): _SA(c->PC++);_NEXT()
+        _OP(0xD4,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD4,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD4,3): _FETCH();_NEXT()
+        _OP(0xD4,4): assert(false);_NEXT()
+        _OP(0xD4,5): assert(false);_NEXT()
+        _OP(0xD4,6): assert(false);_NEXT()
+        _OP(0xD4,7): assert(false);_NEXT()
     /* CMP zp,X */
-        case (0xD5<<3)|0: _SA(c->PC++);break;
-        case (0xD5<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xD5<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xD5<<3)|3: _m6502_cmp(c, c->A, _GD());_FETCH();break;
-        case (0xD5<<3)|4: assert(false);break;
-        case (0xD5<<3)|5: assert(false);break;
-        case (0xD5<<3)|6: assert(false);break;
-        case (0xD5<<3)|7: assert(false);break;
+        _OP(0xD5,0): _SA(c->PC++);_NEXT()
+        _OP(0xD5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD5,3): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD5,4): assert(false);_NEXT()
+        _OP(0xD5,5): assert(false);_NEXT()
+        _OP(0xD5,6): assert(false);_NEXT()
+        _OP(0xD5,7): assert(false);_NEXT()
     /* DEC zp,X */
-        case (0xD6<<3)|0: _SA(c->PC++);break;
-        case (0xD6<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xD6<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xD6<<3)|3: c->AD=_GD();_WR();break;
-        case (0xD6<<3)|4: c->AD--;_NZ(c->AD);_SD(c->AD);_WR();break;
-        case (0xD6<<3)|5: _FETCH();break;
-        case (0xD6<<3)|6: assert(false);break;
-        case (0xD6<<3)|7: assert(false);break;
+        _OP(0xD6,0): _SA(c->PC++);_NEXT()
+        _OP(0xD6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD6,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD6,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xD6,4): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xD6,5): _FETCH();_NEXT()
+        _OP(0xD6,6): assert(false);_NEXT()
+        _OP(0xD6,7): assert(false);_NEXT()
     /* DCP zp,X (undoc) */
-        case (0xD7<<3)|0: _SA(c->PC++);break;
-        case (0xD7<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xD7<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xD7<<3)|3: c->AD=_GD();_WR();break;
-        case (0xD7<<3)|4: c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();break;
-        case (0xD7<<3)|5: _FETCH();break;
-        case (0xD7<<3)|6: assert(false);break;
-        case (0xD7<<3)|7: assert(false);break;
+        _OP(0xD7,0): _SA(c->PC++);_NEXT()
+        _OP(0xD7,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD7,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD7,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xD7,4): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xD7,5): _FETCH();_NEXT()
+        _OP(0xD7,6): assert(false);_NEXT()
+        _OP(0xD7,7): assert(false);_NEXT()
     /* CLD  */
-        case (0xD8<<3)|0: _SA(c->PC);break;
-        case (0xD8<<3)|1: c->P&=~0x8;_FETCH();break;
-        case (0xD8<<3)|2: assert(false);break;
-        case (0xD8<<3)|3: assert(false);break;
-        case (0xD8<<3)|4: assert(false);break;
-        case (0xD8<<3)|5: assert(false);break;
-        case (0xD8<<3)|6: assert(false);break;
-        case (0xD8<<3)|7: assert(false);break;
+        _OP(0xD8,0): _SA(c->PC);_NEXT()
+        _OP(0xD8,1): c->P&=~0x8;_FETCH();_NEXT()
+        _OP(0xD8,2): assert(false);_NEXT()
+        _OP(0xD8,3): assert(false);_NEXT()
+        _OP(0xD8,4): assert(false);_NEXT()
+        _OP(0xD8,5): assert(false);_NEXT()
+        _OP(0xD8,6): assert(false);_NEXT()
+        _OP(0xD8,7): assert(false);_NEXT()
     /* CMP abs,Y */
-        case (0xD9<<3)|0: _SA(c->PC++);break;
-        case (0xD9<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xD9<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xD9<<3)|3: _SA(c->AD+c->Y);break;
-        case (0xD9<<3)|4: _m6502_cmp(c, c->A, _GD());_FETCH();break;
-        case (0xD9<<3)|5: assert(false);break;
-        case (0xD9<<3)|6: assert(false);break;
-        case (0xD9<<3)|7: assert(false);break;
+        _OP(0xD9,0): _SA(c->PC++);_NEXT()
+        _OP(0xD9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xD9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xD9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xD9,4): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD9,5): assert(false);_NEXT()
+        _OP(0xD9,6): assert(false);_NEXT()
+        _OP(0xD9,7): assert(false);_NEXT()
     /* NOP  (undoc) */
-        case (0xDA<<3)|0: _SA(c->PC);break;
-        case (0xDA<<3)|1: _FETCH();break;
-        case (0xDA<<3)|2: assert(false);break;
-        case (0xDA<<3)|3: assert(false);break;
-        case (0xDA<<3)|4: assert(false);break;
-        case (0xDA<<3)|5: assert(false);break;
-        case (0xDA<<3)|6: assert(false);break;
-        case (0xDA<<3)|7: assert(false);break;
+        _OP(0xDA,0): _SA(c->PC);_NEXT()
+        _OP(0xDA,1): _FETCH();_NEXT()
+        _OP(0xDA,2): assert(false);_NEXT()
+        _OP(0xDA,3): assert(false);_NEXT()
+        _OP(0xDA,4): assert(false);_NEXT()
+        _OP(0xDA,5): assert(false);_NEXT()
+        _OP(0xDA,6): assert(false);_NEXT()
+        _OP(0xDA,7): assert(false);_NEXT()
     /* DCP abs,Y (undoc) */
-        case (0xDB<<3)|0: _SA(c->PC++);break;
-        case (0xDB<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xDB<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0xDB<<3)|3: _SA(c->AD+c->Y);break;
-        case (0xDB<<3)|4: c->AD=_GD();_WR();break;
-        case (0xDB<<3)|5: c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();break;
-        case (0xDB<<3)|6: _FETCH();break;
-        case (0xDB<<3)|7: assert(false);break;
+        _OP(0xDB,0): _SA(c->PC++);_NEXT()
+        _OP(0xDB,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDB,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0xDB,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xDB,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xDB,5): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xDB,6): _FETCH();_NEXT()
+        _OP(0xDB,7): assert(false);_NEXT()
     /* NOP abs,X (undoc) */
-        case (0xDC<<3)|0: _SA(c->PC++);break;
-        case (0xDC<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xDC<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0xDC<<3)|3: _SA(c->AD+c->X);break;
-        case (0xDC<<3)|4: _FETCH();break;
-        case (0xDC<<3)|5: assert(false);break;
-        case (0xDC<<3)|6: assert(false);break;
-        case (0xDC<<3)|7: assert(false);break;
+        _OP(0xDC,0): _SA(c->PC++);_NEXT()
+        _OP(0xDC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDC,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xDC,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDC,4): _FETCH();_NEXT()
+        _OP(0xDC,5): assert(false);_NEXT()
+        _OP(0xDC,6): assert(false);_NEXT()
+        _OP(0xDC,7): assert(false);_NEXT()
     /* CMP abs,X */
-        case (0xDD<<3)|0: _SA(c->PC++);break;
-        case (0xDD<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xDD<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0xDD<<3)|3: _SA(c->AD+c->X);break;
-        case (0xDD<<3)|4: _m6502_cmp(c, c->A, _GD());_FETCH();break;
-        case (0xDD<<3)|5: assert(false);break;
-        case (0xDD<<3)|6: assert(false);break;
-        case (0xDD<<3)|7: assert(false);break;
+        _OP(0xDD,0): _SA(c->PC++);_NEXT()
+        _OP(0xDD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xDD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDD,4): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xDD,5): assert(false);_NEXT()
+        _OP(0xDD,6): assert(false);_NEXT()
+        _OP(0xDD,7): assert(false);_NEXT()
     /* DEC abs,X */
-        case (0xDE<<3)|0: _SA(c->PC++);break;
-        case (0xDE<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xDE<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0xDE<<3)|3: _SA(c->AD+c->X);break;
-        case (0xDE<<3)|4: c->AD=_GD();_WR();break;
-        case (0xDE<<3)|5: c->AD--;_NZ(c->AD);_SD(c->AD);_WR();break;
-        case (0xDE<<3)|6: _FETCH();break;
-        case (0xDE<<3)|7: assert(false);break;
+        _OP(0xDE,0): _SA(c->PC++);_NEXT()
+        _OP(0xDE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xDE,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDE,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xDE,5): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xDE,6): _FETCH();_NEXT()
+        _OP(0xDE,7): assert(false);_NEXT()
     /* DCP abs,X (undoc) */
-        case (0xDF<<3)|0: _SA(c->PC++);break;
-        case (0xDF<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xDF<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0xDF<<3)|3: _SA(c->AD+c->X);break;
-        case (0xDF<<3)|4: c->AD=_GD();_WR();break;
-        case (0xDF<<3)|5: c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();break;
-        case (0xDF<<3)|6: _FETCH();break;
-        case (0xDF<<3)|7: assert(false);break;
+        _OP(0xDF,0): _SA(c->PC++);_NEXT()
+        _OP(0xDF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDF,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xDF,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDF,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xDF,5): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xDF,6): _FETCH();_NEXT()
+        _OP(0xDF,7): assert(false);_NEXT()
     /* CPX # */
-        case (0xE0<<3)|0: _SA(c->PC++);break;
-        case (0xE0<<3)|1: _m6502_cmp(c, c->X, _GD());_FETCH();break;
-        case (0xE0<<3)|2: assert(false);break;
-        case (0xE0<<3)|3: assert(false);break;
-        case (0xE0<<3)|4: assert(false);break;
-        case (0xE0<<3)|5: assert(false);break;
-        case (0xE0<<3)|6: assert(false);break;
-        case (0xE0<<3)|7: assert(false);break;
+        _OP(0xE0,0): _SA(c->PC++);_NEXT()
+        _OP(0xE0,1): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xE0,2): assert(false);_NEXT()
+        _OP(0xE0,3): assert(false);_NEXT()
+        _OP(0xE0,4): assert(false);_NEXT()
+        _OP(0xE0,5): assert(false);_NEXT()
+        _OP(0xE0,6): assert(false);_NEXT()
+        _OP(0xE0,7): assert(false);_NEXT()
     /* SBC (zp,X) */
-        case (0xE1<<3)|0: _SA(c->PC++);break;
-        case (0xE1<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xE1<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0xE1<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xE1<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0xE1<<3)|5: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xE1<<3)|6: assert(false);break;
-        case (0xE1<<3)|7: assert(false);break;
+        _OP(0xE1,0): _SA(c->PC++);_NEXT()
+        _OP(0xE1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xE1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xE1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xE1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xE1,5): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xE1,6): assert(false);_NEXT()
+        _OP(0xE1,7): assert(false);_NEXT()
     /* NOP # (undoc) */
-        case (0xE2<<3)|0: _SA(c->PC++);break;
-        case (0xE2<<3)|1: _FETCH();break;
-        case (0xE2<<3)|2: assert(false);break;
-        case (0xE2<<3)|3: assert(false);break;
-        case (0xE2<<3)|4: assert(false);break;
-        case (0xE2<<3)|5: assert(false);break;
-        case (0xE2<<3)|6: assert(false);break;
-        case (0xE2<<3)|7: assert(false);break;
+        _OP(0xE2,0): _SA(c->PC++);_NEXT()
+        _OP(0xE2,1): _FETCH();_NEXT()
+        _OP(0xE2,2): assert(false);_NEXT()
+        _OP(0xE2,3): assert(false);_NEXT()
+        _OP(0xE2,4): assert(false);_NEXT()
+        _OP(0xE2,5): assert(false);_NEXT()
+        _OP(0xE2,6): assert(false);_NEXT()
+        _OP(0xE2,7): assert(false);_NEXT()
     /* ISB (zp,X) (undoc) */
-        case (0xE3<<3)|0: _SA(c->PC++);break;
-        case (0xE3<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xE3<<3)|2: c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);break;
-        case (0xE3<<3)|3: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xE3<<3)|4: _SA((_GD()<<8)|c->AD);break;
-        case (0xE3<<3)|5: c->AD=_GD();_WR();break;
-        case (0xE3<<3)|6: c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();break;
-        case (0xE3<<3)|7: _FETCH();break;
+        _OP(0xE3,0): _SA(c->PC++);_NEXT()
+        _OP(0xE3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xE3,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xE3,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xE3,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xE3,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0xE3,6): c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();_NEXT()
+        _OP(0xE3,7): _FETCH();_NEXT()
     /* CPX zp */
-        case (0xE4<<3)|0: _SA(c->PC++);break;
-        case (0xE4<<3)|1: _SA(_GD());break;
-        case (0xE4<<3)|2: _m6502_cmp(c, c->X, _GD());_FETCH();break;
-        case (0xE4<<3)|3: assert(false);break;
-        case (0xE4<<3)|4: assert(false);break;
-        case (0xE4<<3)|5: assert(false);break;
-        case (0xE4<<3)|6: assert(false);break;
-        case (0xE4<<3)|7: assert(false);break;
+        _OP(0xE4,0): _SA(c->PC++);_NEXT()
+        _OP(0xE4,1): _SA(_GD());_NEXT()
+        _OP(0xE4,2): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xE4,3): assert(false);_NEXT()
+        _OP(0xE4,4): assert(false);_NEXT()
+        _OP(0xE4,5): assert(false);_NEXT()
+        _OP(0xE4,6): assert(false);_NEXT()
+        _OP(0xE4,7): assert(false);_NEXT()
     /* SBC zp */
-        case (0xE5<<3)|0: _SA(c->PC++);break;
-        case (0xE5<<3)|1: _SA(_GD());break;
-        case (0xE5<<3)|2: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xE5<<3)|3: assert(false);break;
-        case (0xE5<<3)|4: assert(false);break;
-        case (0xE5<<3)|5: assert(false);break;
-        case (0xE5<<3)|6: assert(false);break;
-        case (0xE5<<3)|7: assert(false);break;
+        _OP(0xE5,0): _SA(c->PC++);_NEXT()
+        _OP(0xE5,1): _SA(_GD());_NEXT()
+        _OP(0xE5,2): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xE5,3): assert(false);_NEXT()
+        _OP(0xE5,4): assert(false);_NEXT()
+        _OP(0xE5,5): assert(false);_NEXT()
+        _OP(0xE5,6): assert(false);_NEXT()
+        _OP(0xE5,7): assert(false);_NEXT()
     /* INC zp */
-        case (0xE6<<3)|0: _SA(c->PC++);break;
-        case (0xE6<<3)|1: _SA(_GD());break;
-        case (0xE6<<3)|2: c->AD=_GD();_WR();break;
-        case (0xE6<<3)|3: c->AD++;_NZ(c->AD);_SD(c->AD);_WR();break;
-        case (0xE6<<3)|4: _FETCH();break;
-        case (0xE6<<3)|5: assert(false);break;
-        case (0xE6<<3)|6: assert(false);break;
-        case (0xE6<<3)|7: assert(false);break;
+        _OP(0xE6,0): _SA(c->PC++);_NEXT()
+        _OP(0xE6,1): _SA(_GD());_NEXT()
+        _OP(0xE6,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0xE6,3): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xE6,4): _FETCH();_NEXT()
+        _OP(0xE6,5): assert(false);_NEXT()
+        _OP(0xE6,6): assert(false);_NEXT()
+        _OP(0xE6,7): assert(false);_NEXT()
     /* ISB zp (undoc) */
-        case (0xE7<<3)|0: _SA(c->PC++);break;
-        case (0xE7<<3)|1: _SA(_GD());break;
-        case (0xE7<<3)|2: c->AD=_GD();_WR();break;
-        case (0xE7<<3)|3: c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();break;
-        case (0xE7<<3)|4: _FETCH();break;
-        case (0xE7<<3)|5: assert(false);break;
-        case (0xE7<<3)|6: assert(false);break;
-        case (0xE7<<3)|7: assert(false);break;
+        _OP(0xE7,0): _SA(c->PC++);_NEXT()
+        _OP(0xE7,1): _SA(_GD());_NEXT()
+        _OP(0xE7,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0xE7,3): c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();_NEXT()
+        _OP(0xE7,4): _FETCH();_NEXT()
+        _OP(0xE7,5): assert(false);_NEXT()
+        _OP(0xE7,6): assert(false);_NEXT()
+        _OP(0xE7,7): assert(false);_NEXT()
     /* INX  */
-        case (0xE8<<3)|0: _SA(c->PC);break;
-        case (0xE8<<3)|1: c->X++;_NZ(c->X);_FETCH();break;
-        case (0xE8<<3)|2: assert(false);break;
-        case (0xE8<<3)|3: assert(false);break;
-        case (0xE8<<3)|4: assert(false);break;
-        case (0xE8<<3)|5: assert(false);break;
-        case (0xE8<<3)|6: assert(false);break;
-        case (0xE8<<3)|7: assert(false);break;
+        _OP(0xE8,0): _SA(c->PC);_NEXT()
+        _OP(0xE8,1): c->X++;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xE8,2): assert(false);_NEXT()
+        _OP(0xE8,3): assert(false);_NEXT()
+        _OP(0xE8,4): assert(false);_NEXT()
+        _OP(0xE8,5): assert(false);_NEXT()
+        _OP(0xE8,6): assert(false);_NEXT()
+        _OP(0xE8,7): assert(false);_NEXT()
     /* SBC # */
-        case (0xE9<<3)|0: _SA(c->PC++);break;
-        case (0xE9<<3)|1: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xE9<<3)|2: assert(false);break;
-        case (0xE9<<3)|3: assert(false);break;
-        case (0xE9<<3)|4: assert(false);break;
-        case (0xE9<<3)|5: assert(false);break;
-        case (0xE9<<3)|6: assert(false);break;
-        case (0xE9<<3)|7: assert(false);break;
+        _OP(0xE9,0): _SA(c->PC++);_NEXT()
+        _OP(0xE9,1): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xE9,2): assert(false);_NEXT()
+        _OP(0xE9,3): assert(false);_NEXT()
+        _OP(0xE9,4): assert(false);_NEXT()
+        _OP(0xE9,5): assert(false);_NEXT()
+        _OP(0xE9,6): assert(false);_NEXT()
+        _OP(0xE9,7): assert(false);_NEXT()
     /* NOP  */
-        case (0xEA<<3)|0: _SA(c->PC);break;
-        case (0xEA<<3)|1: _FETCH();break;
-        case (0xEA<<3)|2: assert(false);break;
-        case (0xEA<<3)|3: assert(false);break;
-        case (0xEA<<3)|4: assert(false);break;
-        case (0xEA<<3)|5: assert(false);break;
-        case (0xEA<<3)|6: assert(false);break;
-        case (0xEA<<3)|7: assert(false);break;
+        _OP(0xEA,0): _SA(c->PC);_NEXT()
+        _OP(0xEA,1): _FETCH();_NEXT()
+        _OP(0xEA,2): assert(false);_NEXT()
+        _OP(0xEA,3): assert(false);_NEXT()
+        _OP(0xEA,4): assert(false);_NEXT()
+        _OP(0xEA,5): assert(false);_NEXT()
+        _OP(0xEA,6): assert(false);_NEXT()
+        _OP(0xEA,7): assert(false);_NEXT()
     /* SBC # (undoc) */
-        case (0xEB<<3)|0: _SA(c->PC++);break;
-        case (0xEB<<3)|1: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xEB<<3)|2: assert(false);break;
-        case (0xEB<<3)|3: assert(false);break;
-        case (0xEB<<3)|4: assert(false);break;
-        case (0xEB<<3)|5: assert(false);break;
-        case (0xEB<<3)|6: assert(false);break;
-        case (0xEB<<3)|7: assert(false);break;
+        _OP(0xEB,0): _SA(c->PC++);_NEXT()
+        _OP(0xEB,1): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xEB,2): assert(false);_NEXT()
+        _OP(0xEB,3): assert(false);_NEXT()
+        _OP(0xEB,4): assert(false);_NEXT()
+        _OP(0xEB,5): assert(false);_NEXT()
+        _OP(0xEB,6): assert(false);_NEXT()
+        _OP(0xEB,7): assert(false);_NEXT()
     /* CPX abs */
-        case (0xEC<<3)|0: _SA(c->PC++);break;
-        case (0xEC<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xEC<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xEC<<3)|3: _m6502_cmp(c, c->X, _GD());_FETCH();break;
-        case (0xEC<<3)|4: assert(false);break;
-        case (0xEC<<3)|5: assert(false);break;
-        case (0xEC<<3)|6: assert(false);break;
-        case (0xEC<<3)|7: assert(false);break;
+        _OP(0xEC,0): _SA(c->PC++);_NEXT()
+        _OP(0xEC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xEC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xEC,3): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xEC,4): assert(false);_NEXT()
+        _OP(0xEC,5): assert(false);_NEXT()
+        _OP(0xEC,6): assert(false);_NEXT()
+        _OP(0xEC,7): assert(false);_NEXT()
     /* SBC abs */
-        case (0xED<<3)|0: _SA(c->PC++);break;
-        case (0xED<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xED<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xED<<3)|3: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xED<<3)|4: assert(false);break;
-        case (0xED<<3)|5: assert(false);break;
-        case (0xED<<3)|6: assert(false);break;
-        case (0xED<<3)|7: assert(false);break;
+        _OP(0xED,0): _SA(c->PC++);_NEXT()
+        _OP(0xED,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xED,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xED,3): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xED,4): assert(false);_NEXT()
+        _OP(0xED,5): assert(false);_NEXT()
+        _OP(0xED,6): assert(false);_NEXT()
+        _OP(0xED,7): assert(false);_NEXT()
     /* INC abs */
-        case (0xEE<<3)|0: _SA(c->PC++);break;
-        case (0xEE<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xEE<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xEE<<3)|3: c->AD=_GD();_WR();break;
-        case (0xEE<<3)|4: c->AD++;_NZ(c->AD);_SD(c->AD);_WR();break;
-        case (0xEE<<3)|5: _FETCH();break;
-        case (0xEE<<3)|6: assert(false);break;
-        case (0xEE<<3)|7: assert(false);break;
+        _OP(0xEE,0): _SA(c->PC++);_NEXT()
+        _OP(0xEE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xEE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xEE,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xEE,4): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xEE,5): _FETCH();_NEXT()
+        _OP(0xEE,6): assert(false);_NEXT()
+        _OP(0xEE,7): assert(false);_NEXT()
     /* ISB abs (undoc) */
-        case (0xEF<<3)|0: _SA(c->PC++);break;
-        case (0xEF<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xEF<<3)|2: _SA((_GD()<<8)|c->AD);break;
-        case (0xEF<<3)|3: c->AD=_GD();_WR();break;
-        case (0xEF<<3)|4: c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();break;
-        case (0xEF<<3)|5: _FETCH();break;
-        case (0xEF<<3)|6: assert(false);break;
-        case (0xEF<<3)|7: assert(false);break;
+        _OP(0xEF,0): _SA(c->PC++);_NEXT()
+        _OP(0xEF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xEF,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xEF,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xEF,4): c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();_NEXT()
+        _OP(0xEF,5): _FETCH();_NEXT()
+        _OP(0xEF,6): assert(false);_NEXT()
+        _OP(0xEF,7): assert(false);_NEXT()
     /* BEQ # */
-        case (0xF0<<3)|0: _SA(c->PC++);break;
-        case (0xF0<<3)|1: _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x2)!=0x2){_FETCH();};break;
-        case (0xF0<<3)|2: _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};break;
-        case (0xF0<<3)|3: c->PC=c->AD;_FETCH();break;
-        case (0xF0<<3)|4: assert(false);break;
-        case (0xF0<<3)|5: assert(false);break;
-        case (0xF0<<3)|6: assert(false);break;
-        case (0xF0<<3)|7: assert(false);break;
+        _OP(0xF0,0): _SA(c->PC++);_NEXT()
+        _OP(0xF0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x2)!=0x2){_FETCH();};_NEXT()
+        _OP(0xF0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xF0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xF0,4): assert(false);_NEXT()
+        _OP(0xF0,5): assert(false);_NEXT()
+        _OP(0xF0,6): assert(false);_NEXT()
+        _OP(0xF0,7): assert(false);_NEXT()
     /* SBC (zp),Y */
-        case (0xF1<<3)|0: _SA(c->PC++);break;
-        case (0xF1<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xF1<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xF1<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xF1<<3)|4: _SA(c->AD+c->Y);break;
-        case (0xF1<<3)|5: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xF1<<3)|6: assert(false);break;
-        case (0xF1<<3)|7: assert(false);break;
+        _OP(0xF1,0): _SA(c->PC++);_NEXT()
+        _OP(0xF1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xF1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xF1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xF1,5): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xF1,6): assert(false);_NEXT()
+        _OP(0xF1,7): assert(false);_NEXT()
     /* JAM INVALID (undoc) */
-        case (0xF2<<3)|0: _SA(c->PC);break;
-        case (0xF2<<3)|1: _SAD(0xFFFF,0xFF);c->IR--;break;
-        case (0xF2<<3)|2: assert(false);break;
-        case (0xF2<<3)|3: assert(false);break;
-        case (0xF2<<3)|4: assert(false);break;
-        case (0xF2<<3)|5: assert(false);break;
-        case (0xF2<<3)|6: assert(false);break;
-        case (0xF2<<3)|7: assert(false);break;
+        _OP(0xF2,0): _SA(c->PC);_NEXT()
+        _OP(0xF2,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0xF2,2): assert(false);_NEXT()
+        _OP(0xF2,3): assert(false);_NEXT()
+        _OP(0xF2,4): assert(false);_NEXT()
+        _OP(0xF2,5): assert(false);_NEXT()
+        _OP(0xF2,6): assert(false);_NEXT()
+        _OP(0xF2,7): assert(false);_NEXT()
     /* ISB (zp),Y (undoc) */
-        case (0xF3<<3)|0: _SA(c->PC++);break;
-        case (0xF3<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xF3<<3)|2: _SA((c->AD+1)&0xFF);c->AD=_GD();break;
-        case (0xF3<<3)|3: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0xF3<<3)|4: _SA(c->AD+c->Y);break;
-        case (0xF3<<3)|5: c->AD=_GD();_WR();break;
-        case (0xF3<<3)|6: c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();break;
-        case (0xF3<<3)|7: _FETCH();break;
+        _OP(0xF3,0): _SA(c->PC++);_NEXT()
+        _OP(0xF3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF3,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xF3,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0xF3,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xF3,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0xF3,6): c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();_NEXT()
+        _OP(0xF3,7): _FETCH();_NEXT()
     /* NOP zp,X (undoc) */
-        case (0xF4<<3)|0: _SA(c->PC++);break;
-        case (0xF4<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xF4<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xF4<<3)|3: _FETCH();break;
-        case (0xF4<<3)|4: assert(false);break;
-        case (0xF4<<3)|5: assert(false);break;
-        case (0xF4<<3)|6: assert(false);break;
-        case (0xF4<<3)|7: assert(false);break;
+        _OP(0xF4,0): _SA(c->PC++);_NEXT()
+        _OP(0xF4,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF4,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF4,3): _FETCH();_NEXT()
+        _OP(0xF4,4): assert(false);_NEXT()
+        _OP(0xF4,5): assert(false);_NEXT()
+        _OP(0xF4,6): assert(false);_NEXT()
+        _OP(0xF4,7): assert(false);_NEXT()
     /* SBC zp,X */
-        case (0xF5<<3)|0: _SA(c->PC++);break;
-        case (0xF5<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xF5<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xF5<<3)|3: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xF5<<3)|4: assert(false);break;
-        case (0xF5<<3)|5: assert(false);break;
-        case (0xF5<<3)|6: assert(false);break;
-        case (0xF5<<3)|7: assert(false);break;
+        _OP(0xF5,0): _SA(c->PC++);_NEXT()
+        _OP(0xF5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF5,3): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xF5,4): assert(false);_NEXT()
+        _OP(0xF5,5): assert(false);_NEXT()
+        _OP(0xF5,6): assert(false);_NEXT()
+        _OP(0xF5,7): assert(false);_NEXT()
     /* INC zp,X */
-        case (0xF6<<3)|0: _SA(c->PC++);break;
-        case (0xF6<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xF6<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xF6<<3)|3: c->AD=_GD();_WR();break;
-        case (0xF6<<3)|4: c->AD++;_NZ(c->AD);_SD(c->AD);_WR();break;
-        case (0xF6<<3)|5: _FETCH();break;
-        case (0xF6<<3)|6: assert(false);break;
-        case (0xF6<<3)|7: assert(false);break;
+        _OP(0xF6,0): _SA(c->PC++);_NEXT()
+        _OP(0xF6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF6,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF6,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xF6,4): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xF6,5): _FETCH();_NEXT()
+        _OP(0xF6,6): assert(false);_NEXT()
+        _OP(0xF6,7): assert(false);_NEXT()
     /* ISB zp,X (undoc) */
-        case (0xF7<<3)|0: _SA(c->PC++);break;
-        case (0xF7<<3)|1: c->AD=_GD();_SA(c->AD);break;
-        case (0xF7<<3)|2: _SA((c->AD+c->X)&0x00FF);break;
-        case (0xF7<<3)|3: c->AD=_GD();_WR();break;
-        case (0xF7<<3)|4: c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();break;
-        case (0xF7<<3)|5: _FETCH();break;
-        case (0xF7<<3)|6: assert(false);break;
-        case (0xF7<<3)|7: assert(false);break;
+        _OP(0xF7,0): _SA(c->PC++);_NEXT()
+        _OP(0xF7,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF7,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF7,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xF7,4): c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();_NEXT()
+        _OP(0xF7,5): _FETCH();_NEXT()
+        _OP(0xF7,6): assert(false);_NEXT()
+        _OP(0xF7,7): assert(false);_NEXT()
     /* SED  */
-        case (0xF8<<3)|0: _SA(c->PC);break;
-        case (0xF8<<3)|1: c->P|=0x8;_FETCH();break;
-        case (0xF8<<3)|2: assert(false);break;
-        case (0xF8<<3)|3: assert(false);break;
-        case (0xF8<<3)|4: assert(false);break;
-        case (0xF8<<3)|5: assert(false);break;
-        case (0xF8<<3)|6: assert(false);break;
-        case (0xF8<<3)|7: assert(false);break;
+        _OP(0xF8,0): _SA(c->PC);_NEXT()
+        _OP(0xF8,1): c->P|=0x8;_FETCH();_NEXT()
+        _OP(0xF8,2): assert(false);_NEXT()
+        _OP(0xF8,3): assert(false);_NEXT()
+        _OP(0xF8,4): assert(false);_NEXT()
+        _OP(0xF8,5): assert(false);_NEXT()
+        _OP(0xF8,6): assert(false);_NEXT()
+        _OP(0xF8,7): assert(false);_NEXT()
     /* SBC abs,Y */
-        case (0xF9<<3)|0: _SA(c->PC++);break;
-        case (0xF9<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xF9<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;break;
-        case (0xF9<<3)|3: _SA(c->AD+c->Y);break;
-        case (0xF9<<3)|4: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xF9<<3)|5: assert(false);break;
-        case (0xF9<<3)|6: assert(false);break;
-        case (0xF9<<3)|7: assert(false);break;
+        _OP(0xF9,0): _SA(c->PC++);_NEXT()
+        _OP(0xF9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xF9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xF9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xF9,4): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xF9,5): assert(false);_NEXT()
+        _OP(0xF9,6): assert(false);_NEXT()
+        _OP(0xF9,7): assert(false);_NEXT()
     /* NOP  (undoc) */
-        case (0xFA<<3)|0: _SA(c->PC);break;
-        case (0xFA<<3)|1: _FETCH();break;
-        case (0xFA<<3)|2: assert(false);break;
-        case (0xFA<<3)|3: assert(false);break;
-        case (0xFA<<3)|4: assert(false);break;
-        case (0xFA<<3)|5: assert(false);break;
-        case (0xFA<<3)|6: assert(false);break;
-        case (0xFA<<3)|7: assert(false);break;
+        _OP(0xFA,0): _SA(c->PC);_NEXT()
+        _OP(0xFA,1): _FETCH();_NEXT()
+        _OP(0xFA,2): assert(false);_NEXT()
+        _OP(0xFA,3): assert(false);_NEXT()
+        _OP(0xFA,4): assert(false);_NEXT()
+        _OP(0xFA,5): assert(false);_NEXT()
+        _OP(0xFA,6): assert(false);_NEXT()
+        _OP(0xFA,7): assert(false);_NEXT()
     /* ISB abs,Y (undoc) */
-        case (0xFB<<3)|0: _SA(c->PC++);break;
-        case (0xFB<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xFB<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));break;
-        case (0xFB<<3)|3: _SA(c->AD+c->Y);break;
-        case (0xFB<<3)|4: c->AD=_GD();_WR();break;
-        case (0xFB<<3)|5: c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();break;
-        case (0xFB<<3)|6: _FETCH();break;
-        case (0xFB<<3)|7: assert(false);break;
+        _OP(0xFB,0): _SA(c->PC++);_NEXT()
+        _OP(0xFB,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFB,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0xFB,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xFB,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xFB,5): c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();_NEXT()
+        _OP(0xFB,6): _FETCH();_NEXT()
+        _OP(0xFB,7): assert(false);_NEXT()
     /* NOP abs,X (undoc) */
-        case (0xFC<<3)|0: _SA(c->PC++);break;
-        case (0xFC<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xFC<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0xFC<<3)|3: _SA(c->AD+c->X);break;
-        case (0xFC<<3)|4: _FETCH();break;
-        case (0xFC<<3)|5: assert(false);break;
-        case (0xFC<<3)|6: assert(false);break;
-        case (0xFC<<3)|7: assert(false);break;
+        _OP(0xFC,0): _SA(c->PC++);_NEXT()
+        _OP(0xFC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFC,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xFC,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFC,4): _FETCH();_NEXT()
+        _OP(0xFC,5): assert(false);_NEXT()
+        _OP(0xFC,6): assert(false);_NEXT()
+        _OP(0xFC,7): assert(false);_NEXT()
     /* SBC abs,X */
-        case (0xFD<<3)|0: _SA(c->PC++);break;
-        case (0xFD<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xFD<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;break;
-        case (0xFD<<3)|3: _SA(c->AD+c->X);break;
-        case (0xFD<<3)|4: _m6502_sbc(c,_GD());_FETCH();break;
-        case (0xFD<<3)|5: assert(false);break;
-        case (0xFD<<3)|6: assert(false);break;
-        case (0xFD<<3)|7: assert(false);break;
+        _OP(0xFD,0): _SA(c->PC++);_NEXT()
+        _OP(0xFD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xFD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFD,4): _m6502_sbc(c,_GD());_FETCH();_NEXT()
+        _OP(0xFD,5): assert(false);_NEXT()
+        _OP(0xFD,6): assert(false);_NEXT()
+        _OP(0xFD,7): assert(false);_NEXT()
     /* INC abs,X */
-        case (0xFE<<3)|0: _SA(c->PC++);break;
-        case (0xFE<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xFE<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0xFE<<3)|3: _SA(c->AD+c->X);break;
-        case (0xFE<<3)|4: c->AD=_GD();_WR();break;
-        case (0xFE<<3)|5: c->AD++;_NZ(c->AD);_SD(c->AD);_WR();break;
-        case (0xFE<<3)|6: _FETCH();break;
-        case (0xFE<<3)|7: assert(false);break;
+        _OP(0xFE,0): _SA(c->PC++);_NEXT()
+        _OP(0xFE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xFE,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFE,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xFE,5): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xFE,6): _FETCH();_NEXT()
+        _OP(0xFE,7): assert(false);_NEXT()
     /* ISB abs,X (undoc) */
-        case (0xFF<<3)|0: _SA(c->PC++);break;
-        case (0xFF<<3)|1: _SA(c->PC++);c->AD=_GD();break;
-        case (0xFF<<3)|2: c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));break;
-        case (0xFF<<3)|3: _SA(c->AD+c->X);break;
-        case (0xFF<<3)|4: c->AD=_GD();_WR();break;
-        case (0xFF<<3)|5: c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();break;
-        case (0xFF<<3)|6: _FETCH();break;
-        case (0xFF<<3)|7: assert(false);break;
+        _OP(0xFF,0): _SA(c->PC++);_NEXT()
+        _OP(0xFF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFF,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xFF,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFF,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xFF,5): c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();_NEXT()
+        _OP(0xFF,6): _FETCH();_NEXT()
+        _OP(0xFF,7): assert(false);_NEXT()
 
     }
+    _M6502_TICK_END();
+    return pins;
+}
+
+/* NMOS 6510, same as the 6502 but also updates the IO port pins */
+uint64_t m6510_tick(m6502_t* c, uint64_t pins) {
+    pins = m6502_tick(c, pins);
     M6510_SET_PORT(pins, c->io_pins);
     c->PINS = pins;
-    c->irq_pip <<= 1;
-    c->nmi_pip <<= 1;
     return pins;
 }
+
+/* Ricoh 2A03 instruction decoder (NMOS 6502 without decimal mode) */
+uint64_t m2a03_tick(m6502_t* c, uint64_t pins) {
+    if (_m6502_tick_begin(c, &pins)) {
+        return pins;
+    }
+    // reads are default, writes are special
+    _RD();
+    #if defined(_M6502_COMPUTED_GOTO)
+    static const void* _m6502_op_table[2048] = {
+        &&_m6502_op_0x00_0,&&_m6502_op_0x00_1,&&_m6502_op_0x00_2,&&_m6502_op_0x00_3,&&_m6502_op_0x00_4,&&_m6502_op_0x00_5,&&_m6502_op_0x00_6,&&_m6502_op_0x00_7,
+        &&_m6502_op_0x01_0,&&_m6502_op_0x01_1,&&_m6502_op_0x01_2,&&_m6502_op_0x01_3,&&_m6502_op_0x01_4,&&_m6502_op_0x01_5,&&_m6502_op_0x01_6,&&_m6502_op_0x01_7,
+        &&_m6502_op_0x02_0,&&_m6502_op_0x02_1,&&_m6502_op_0x02_2,&&_m6502_op_0x02_3,&&_m6502_op_0x02_4,&&_m6502_op_0x02_5,&&_m6502_op_0x02_6,&&_m6502_op_0x02_7,
+        &&_m6502_op_0x03_0,&&_m6502_op_0x03_1,&&_m6502_op_0x03_2,&&_m6502_op_0x03_3,&&_m6502_op_0x03_4,&&_m6502_op_0x03_5,&&_m6502_op_0x03_6,&&_m6502_op_0x03_7,
+        &&_m6502_op_0x04_0,&&_m6502_op_0x04_1,&&_m6502_op_0x04_2,&&_m6502_op_0x04_3,&&_m6502_op_0x04_4,&&_m6502_op_0x04_5,&&_m6502_op_0x04_6,&&_m6502_op_0x04_7,
+        &&_m6502_op_0x05_0,&&_m6502_op_0x05_1,&&_m6502_op_0x05_2,&&_m6502_op_0x05_3,&&_m6502_op_0x05_4,&&_m6502_op_0x05_5,&&_m6502_op_0x05_6,&&_m6502_op_0x05_7,
+        &&_m6502_op_0x06_0,&&_m6502_op_0x06_1,&&_m6502_op_0x06_2,&&_m6502_op_0x06_3,&&_m6502_op_0x06_4,&&_m6502_op_0x06_5,&&_m6502_op_0x06_6,&&_m6502_op_0x06_7,
+        &&_m6502_op_0x07_0,&&_m6502_op_0x07_1,&&_m6502_op_0x07_2,&&_m6502_op_0x07_3,&&_m6502_op_0x07_4,&&_m6502_op_0x07_5,&&_m6502_op_0x07_6,&&_m6502_op_0x07_7,
+        &&_m6502_op_0x08_0,&&_m6502_op_0x08_1,&&_m6502_op_0x08_2,&&_m6502_op_0x08_3,&&_m6502_op_0x08_4,&&_m6502_op_0x08_5,&&_m6502_op_0x08_6,&&_m6502_op_0x08_7,
+        &&_m6502_op_0x09_0,&&_m6502_op_0x09_1,&&_m6502_op_0x09_2,&&_m6502_op_0x09_3,&&_m6502_op_0x09_4,&&_m6502_op_0x09_5,&&_m6502_op_0x09_6,&&_m6502_op_0x09_7,
+        &&_m6502_op_0x0A_0,&&_m6502_op_0x0A_1,&&_m6502_op_0x0A_2,&&_m6502_op_0x0A_3,&&_m6502_op_0x0A_4,&&_m6502_op_0x0A_5,&&_m6502_op_0x0A_6,&&_m6502_op_0x0A_7,
+        &&_m6502_op_0x0B_0,&&_m6502_op_0x0B_1,&&_m6502_op_0x0B_2,&&_m6502_op_0x0B_3,&&_m6502_op_0x0B_4,&&_m6502_op_0x0B_5,&&_m6502_op_0x0B_6,&&_m6502_op_0x0B_7,
+        &&_m6502_op_0x0C_0,&&_m6502_op_0x0C_1,&&_m6502_op_0x0C_2,&&_m6502_op_0x0C_3,&&_m6502_op_0x0C_4,&&_m6502_op_0x0C_5,&&_m6502_op_0x0C_6,&&_m6502_op_0x0C_7,
+        &&_m6502_op_0x0D_0,&&_m6502_op_0x0D_1,&&_m6502_op_0x0D_2,&&_m6502_op_0x0D_3,&&_m6502_op_0x0D_4,&&_m6502_op_0x0D_5,&&_m6502_op_0x0D_6,&&_m6502_op_0x0D_7,
+        &&_m6502_op_0x0E_0,&&_m6502_op_0x0E_1,&&_m6502_op_0x0E_2,&&_m6502_op_0x0E_3,&&_m6502_op_0x0E_4,&&_m6502_op_0x0E_5,&&_m6502_op_0x0E_6,&&_m6502_op_0x0E_7,
+        &&_m6502_op_0x0F_0,&&_m6502_op_0x0F_1,&&_m6502_op_0x0F_2,&&_m6502_op_0x0F_3,&&_m6502_op_0x0F_4,&&_m6502_op_0x0F_5,&&_m6502_op_0x0F_6,&&_m6502_op_0x0F_7,
+        &&_m6502_op_0x10_0,&&_m6502_op_0x10_1,&&_m6502_op_0x10_2,&&_m6502_op_0x10_3,&&_m6502_op_0x10_4,&&_m6502_op_0x10_5,&&_m6502_op_0x10_6,&&_m6502_op_0x10_7,
+        &&_m6502_op_0x11_0,&&_m6502_op_0x11_1,&&_m6502_op_0x11_2,&&_m6502_op_0x11_3,&&_m6502_op_0x11_4,&&_m6502_op_0x11_5,&&_m6502_op_0x11_6,&&_m6502_op_0x11_7,
+        &&_m6502_op_0x12_0,&&_m6502_op_0x12_1,&&_m6502_op_0x12_2,&&_m6502_op_0x12_3,&&_m6502_op_0x12_4,&&_m6502_op_0x12_5,&&_m6502_op_0x12_6,&&_m6502_op_0x12_7,
+        &&_m6502_op_0x13_0,&&_m6502_op_0x13_1,&&_m6502_op_0x13_2,&&_m6502_op_0x13_3,&&_m6502_op_0x13_4,&&_m6502_op_0x13_5,&&_m6502_op_0x13_6,&&_m6502_op_0x13_7,
+        &&_m6502_op_0x14_0,&&_m6502_op_0x14_1,&&_m6502_op_0x14_2,&&_m6502_op_0x14_3,&&_m6502_op_0x14_4,&&_m6502_op_0x14_5,&&_m6502_op_0x14_6,&&_m6502_op_0x14_7,
+        &&_m6502_op_0x15_0,&&_m6502_op_0x15_1,&&_m6502_op_0x15_2,&&_m6502_op_0x15_3,&&_m6502_op_0x15_4,&&_m6502_op_0x15_5,&&_m6502_op_0x15_6,&&_m6502_op_0x15_7,
+        &&_m6502_op_0x16_0,&&_m6502_op_0x16_1,&&_m6502_op_0x16_2,&&_m6502_op_0x16_3,&&_m6502_op_0x16_4,&&_m6502_op_0x16_5,&&_m6502_op_0x16_6,&&_m6502_op_0x16_7,
+        &&_m6502_op_0x17_0,&&_m6502_op_0x17_1,&&_m6502_op_0x17_2,&&_m6502_op_0x17_3,&&_m6502_op_0x17_4,&&_m6502_op_0x17_5,&&_m6502_op_0x17_6,&&_m6502_op_0x17_7,
+        &&_m6502_op_0x18_0,&&_m6502_op_0x18_1,&&_m6502_op_0x18_2,&&_m6502_op_0x18_3,&&_m6502_op_0x18_4,&&_m6502_op_0x18_5,&&_m6502_op_0x18_6,&&_m6502_op_0x18_7,
+        &&_m6502_op_0x19_0,&&_m6502_op_0x19_1,&&_m6502_op_0x19_2,&&_m6502_op_0x19_3,&&_m6502_op_0x19_4,&&_m6502_op_0x19_5,&&_m6502_op_0x19_6,&&_m6502_op_0x19_7,
+        &&_m6502_op_0x1A_0,&&_m6502_op_0x1A_1,&&_m6502_op_0x1A_2,&&_m6502_op_0x1A_3,&&_m6502_op_0x1A_4,&&_m6502_op_0x1A_5,&&_m6502_op_0x1A_6,&&_m6502_op_0x1A_7,
+        &&_m6502_op_0x1B_0,&&_m6502_op_0x1B_1,&&_m6502_op_0x1B_2,&&_m6502_op_0x1B_3,&&_m6502_op_0x1B_4,&&_m6502_op_0x1B_5,&&_m6502_op_0x1B_6,&&_m6502_op_0x1B_7,
+        &&_m6502_op_0x1C_0,&&_m6502_op_0x1C_1,&&_m6502_op_0x1C_2,&&_m6502_op_0x1C_3,&&_m6502_op_0x1C_4,&&_m6502_op_0x1C_5,&&_m6502_op_0x1C_6,&&_m6502_op_0x1C_7,
+        &&_m6502_op_0x1D_0,&&_m6502_op_0x1D_1,&&_m6502_op_0x1D_2,&&_m6502_op_0x1D_3,&&_m6502_op_0x1D_4,&&_m6502_op_0x1D_5,&&_m6502_op_0x1D_6,&&_m6502_op_0x1D_7,
+        &&_m6502_op_0x1E_0,&&_m6502_op_0x1E_1,&&_m6502_op_0x1E_2,&&_m6502_op_0x1E_3,&&_m6502_op_0x1E_4,&&_m6502_op_0x1E_5,&&_m6502_op_0x1E_6,&&_m6502_op_0x1E_7,
+        &&_m6502_op_0x1F_0,&&_m6502_op_0x1F_1,&&_m6502_op_0x1F_2,&&_m6502_op_0x1F_3,&&_m6502_op_0x1F_4,&&_m6502_op_0x1F_5,&&_m6502_op_0x1F_6,&&_m6502_op_0x1F_7,
+        &&_m6502_op_0x20_0,&&_m6502_op_0x20_1,&&_m6502_op_0x20_2,&&_m6502_op_0x20_3,&&_m6502_op_0x20_4,&&_m6502_op_0x20_5,&&_m6502_op_0x20_6,&&_m6502_op_0x20_7,
+        &&_m6502_op_0x21_0,&&_m6502_op_0x21_1,&&_m6502_op_0x21_2,&&_m6502_op_0x21_3,&&_m6502_op_0x21_4,&&_m6502_op_0x21_5,&&_m6502_op_0x21_6,&&_m6502_op_0x21_7,
+        &&_m6502_op_0x22_0,&&_m6502_op_0x22_1,&&_m6502_op_0x22_2,&&_m6502_op_0x22_3,&&_m6502_op_0x22_4,&&_m6502_op_0x22_5,&&_m6502_op_0x22_6,&&_m6502_op_0x22_7,
+        &&_m6502_op_0x23_0,&&_m6502_op_0x23_1,&&_m6502_op_0x23_2,&&_m6502_op_0x23_3,&&_m6502_op_0x23_4,&&_m6502_op_0x23_5,&&_m6502_op_0x23_6,&&_m6502_op_0x23_7,
+        &&_m6502_op_0x24_0,&&_m6502_op_0x24_1,&&_m6502_op_0x24_2,&&_m6502_op_0x24_3,&&_m6502_op_0x24_4,&&_m6502_op_0x24_5,&&_m6502_op_0x24_6,&&_m6502_op_0x24_7,
+        &&_m6502_op_0x25_0,&&_m6502_op_0x25_1,&&_m6502_op_0x25_2,&&_m6502_op_0x25_3,&&_m6502_op_0x25_4,&&_m6502_op_0x25_5,&&_m6502_op_0x25_6,&&_m6502_op_0x25_7,
+        &&_m6502_op_0x26_0,&&_m6502_op_0x26_1,&&_m6502_op_0x26_2,&&_m6502_op_0x26_3,&&_m6502_op_0x26_4,&&_m6502_op_0x26_5,&&_m6502_op_0x26_6,&&_m6502_op_0x26_7,
+        &&_m6502_op_0x27_0,&&_m6502_op_0x27_1,&&_m6502_op_0x27_2,&&_m6502_op_0x27_3,&&_m6502_op_0x27_4,&&_m6502_op_0x27_5,&&_m6502_op_0x27_6,&&_m6502_op_0x27_7,
+        &&_m6502_op_0x28_0,&&_m6502_op_0x28_1,&&_m6502_op_0x28_2,&&_m6502_op_0x28_3,&&_m6502_op_0x28_4,&&_m6502_op_0x28_5,&&_m6502_op_0x28_6,&&_m6502_op_0x28_7,
+        &&_m6502_op_0x29_0,&&_m6502_op_0x29_1,&&_m6502_op_0x29_2,&&_m6502_op_0x29_3,&&_m6502_op_0x29_4,&&_m6502_op_0x29_5,&&_m6502_op_0x29_6,&&_m6502_op_0x29_7,
+        &&_m6502_op_0x2A_0,&&_m6502_op_0x2A_1,&&_m6502_op_0x2A_2,&&_m6502_op_0x2A_3,&&_m6502_op_0x2A_4,&&_m6502_op_0x2A_5,&&_m6502_op_0x2A_6,&&_m6502_op_0x2A_7,
+        &&_m6502_op_0x2B_0,&&_m6502_op_0x2B_1,&&_m6502_op_0x2B_2,&&_m6502_op_0x2B_3,&&_m6502_op_0x2B_4,&&_m6502_op_0x2B_5,&&_m6502_op_0x2B_6,&&_m6502_op_0x2B_7,
+        &&_m6502_op_0x2C_0,&&_m6502_op_0x2C_1,&&_m6502_op_0x2C_2,&&_m6502_op_0x2C_3,&&_m6502_op_0x2C_4,&&_m6502_op_0x2C_5,&&_m6502_op_0x2C_6,&&_m6502_op_0x2C_7,
+        &&_m6502_op_0x2D_0,&&_m6502_op_0x2D_1,&&_m6502_op_0x2D_2,&&_m6502_op_0x2D_3,&&_m6502_op_0x2D_4,&&_m6502_op_0x2D_5,&&_m6502_op_0x2D_6,&&_m6502_op_0x2D_7,
+        &&_m6502_op_0x2E_0,&&_m6502_op_0x2E_1,&&_m6502_op_0x2E_2,&&_m6502_op_0x2E_3,&&_m6502_op_0x2E_4,&&_m6502_op_0x2E_5,&&_m6502_op_0x2E_6,&&_m6502_op_0x2E_7,
+        &&_m6502_op_0x2F_0,&&_m6502_op_0x2F_1,&&_m6502_op_0x2F_2,&&_m6502_op_0x2F_3,&&_m6502_op_0x2F_4,&&_m6502_op_0x2F_5,&&_m6502_op_0x2F_6,&&_m6502_op_0x2F_7,
+        &&_m6502_op_0x30_0,&&_m6502_op_0x30_1,&&_m6502_op_0x30_2,&&_m6502_op_0x30_3,&&_m6502_op_0x30_4,&&_m6502_op_0x30_5,&&_m6502_op_0x30_6,&&_m6502_op_0x30_7,
+        &&_m6502_op_0x31_0,&&_m6502_op_0x31_1,&&_m6502_op_0x31_2,&&_m6502_op_0x31_3,&&_m6502_op_0x31_4,&&_m6502_op_0x31_5,&&_m6502_op_0x31_6,&&_m6502_op_0x31_7,
+        &&_m6502_op_0x32_0,&&_m6502_op_0x32_1,&&_m6502_op_0x32_2,&&_m6502_op_0x32_3,&&_m6502_op_0x32_4,&&_m6502_op_0x32_5,&&_m6502_op_0x32_6,&&_m6502_op_0x32_7,
+        &&_m6502_op_0x33_0,&&_m6502_op_0x33_1,&&_m6502_op_0x33_2,&&_m6502_op_0x33_3,&&_m6502_op_0x33_4,&&_m6502_op_0x33_5,&&_m6502_op_0x33_6,&&_m6502_op_0x33_7,
+        &&_m6502_op_0x34_0,&&_m6502_op_0x34_1,&&_m6502_op_0x34_2,&&_m6502_op_0x34_3,&&_m6502_op_0x34_4,&&_m6502_op_0x34_5,&&_m6502_op_0x34_6,&&_m6502_op_0x34_7,
+        &&_m6502_op_0x35_0,&&_m6502_op_0x35_1,&&_m6502_op_0x35_2,&&_m6502_op_0x35_3,&&_m6502_op_0x35_4,&&_m6502_op_0x35_5,&&_m6502_op_0x35_6,&&_m6502_op_0x35_7,
+        &&_m6502_op_0x36_0,&&_m6502_op_0x36_1,&&_m6502_op_0x36_2,&&_m6502_op_0x36_3,&&_m6502_op_0x36_4,&&_m6502_op_0x36_5,&&_m6502_op_0x36_6,&&_m6502_op_0x36_7,
+        &&_m6502_op_0x37_0,&&_m6502_op_0x37_1,&&_m6502_op_0x37_2,&&_m6502_op_0x37_3,&&_m6502_op_0x37_4,&&_m6502_op_0x37_5,&&_m6502_op_0x37_6,&&_m6502_op_0x37_7,
+        &&_m6502_op_0x38_0,&&_m6502_op_0x38_1,&&_m6502_op_0x38_2,&&_m6502_op_0x38_3,&&_m6502_op_0x38_4,&&_m6502_op_0x38_5,&&_m6502_op_0x38_6,&&_m6502_op_0x38_7,
+        &&_m6502_op_0x39_0,&&_m6502_op_0x39_1,&&_m6502_op_0x39_2,&&_m6502_op_0x39_3,&&_m6502_op_0x39_4,&&_m6502_op_0x39_5,&&_m6502_op_0x39_6,&&_m6502_op_0x39_7,
+        &&_m6502_op_0x3A_0,&&_m6502_op_0x3A_1,&&_m6502_op_0x3A_2,&&_m6502_op_0x3A_3,&&_m6502_op_0x3A_4,&&_m6502_op_0x3A_5,&&_m6502_op_0x3A_6,&&_m6502_op_0x3A_7,
+        &&_m6502_op_0x3B_0,&&_m6502_op_0x3B_1,&&_m6502_op_0x3B_2,&&_m6502_op_0x3B_3,&&_m6502_op_0x3B_4,&&_m6502_op_0x3B_5,&&_m6502_op_0x3B_6,&&_m6502_op_0x3B_7,
+        &&_m6502_op_0x3C_0,&&_m6502_op_0x3C_1,&&_m6502_op_0x3C_2,&&_m6502_op_0x3C_3,&&_m6502_op_0x3C_4,&&_m6502_op_0x3C_5,&&_m6502_op_0x3C_6,&&_m6502_op_0x3C_7,
+        &&_m6502_op_0x3D_0,&&_m6502_op_0x3D_1,&&_m6502_op_0x3D_2,&&_m6502_op_0x3D_3,&&_m6502_op_0x3D_4,&&_m6502_op_0x3D_5,&&_m6502_op_0x3D_6,&&_m6502_op_0x3D_7,
+        &&_m6502_op_0x3E_0,&&_m6502_op_0x3E_1,&&_m6502_op_0x3E_2,&&_m6502_op_0x3E_3,&&_m6502_op_0x3E_4,&&_m6502_op_0x3E_5,&&_m6502_op_0x3E_6,&&_m6502_op_0x3E_7,
+        &&_m6502_op_0x3F_0,&&_m6502_op_0x3F_1,&&_m6502_op_0x3F_2,&&_m6502_op_0x3F_3,&&_m6502_op_0x3F_4,&&_m6502_op_0x3F_5,&&_m6502_op_0x3F_6,&&_m6502_op_0x3F_7,
+        &&_m6502_op_0x40_0,&&_m6502_op_0x40_1,&&_m6502_op_0x40_2,&&_m6502_op_0x40_3,&&_m6502_op_0x40_4,&&_m6502_op_0x40_5,&&_m6502_op_0x40_6,&&_m6502_op_0x40_7,
+        &&_m6502_op_0x41_0,&&_m6502_op_0x41_1,&&_m6502_op_0x41_2,&&_m6502_op_0x41_3,&&_m6502_op_0x41_4,&&_m6502_op_0x41_5,&&_m6502_op_0x41_6,&&_m6502_op_0x41_7,
+        &&_m6502_op_0x42_0,&&_m6502_op_0x42_1,&&_m6502_op_0x42_2,&&_m6502_op_0x42_3,&&_m6502_op_0x42_4,&&_m6502_op_0x42_5,&&_m6502_op_0x42_6,&&_m6502_op_0x42_7,
+        &&_m6502_op_0x43_0,&&_m6502_op_0x43_1,&&_m6502_op_0x43_2,&&_m6502_op_0x43_3,&&_m6502_op_0x43_4,&&_m6502_op_0x43_5,&&_m6502_op_0x43_6,&&_m6502_op_0x43_7,
+        &&_m6502_op_0x44_0,&&_m6502_op_0x44_1,&&_m6502_op_0x44_2,&&_m6502_op_0x44_3,&&_m6502_op_0x44_4,&&_m6502_op_0x44_5,&&_m6502_op_0x44_6,&&_m6502_op_0x44_7,
+        &&_m6502_op_0x45_0,&&_m6502_op_0x45_1,&&_m6502_op_0x45_2,&&_m6502_op_0x45_3,&&_m6502_op_0x45_4,&&_m6502_op_0x45_5,&&_m6502_op_0x45_6,&&_m6502_op_0x45_7,
+        &&_m6502_op_0x46_0,&&_m6502_op_0x46_1,&&_m6502_op_0x46_2,&&_m6502_op_0x46_3,&&_m6502_op_0x46_4,&&_m6502_op_0x46_5,&&_m6502_op_0x46_6,&&_m6502_op_0x46_7,
+        &&_m6502_op_0x47_0,&&_m6502_op_0x47_1,&&_m6502_op_0x47_2,&&_m6502_op_0x47_3,&&_m6502_op_0x47_4,&&_m6502_op_0x47_5,&&_m6502_op_0x47_6,&&_m6502_op_0x47_7,
+        &&_m6502_op_0x48_0,&&_m6502_op_0x48_1,&&_m6502_op_0x48_2,&&_m6502_op_0x48_3,&&_m6502_op_0x48_4,&&_m6502_op_0x48_5,&&_m6502_op_0x48_6,&&_m6502_op_0x48_7,
+        &&_m6502_op_0x49_0,&&_m6502_op_0x49_1,&&_m6502_op_0x49_2,&&_m6502_op_0x49_3,&&_m6502_op_0x49_4,&&_m6502_op_0x49_5,&&_m6502_op_0x49_6,&&_m6502_op_0x49_7,
+        &&_m6502_op_0x4A_0,&&_m6502_op_0x4A_1,&&_m6502_op_0x4A_2,&&_m6502_op_0x4A_3,&&_m6502_op_0x4A_4,&&_m6502_op_0x4A_5,&&_m6502_op_0x4A_6,&&_m6502_op_0x4A_7,
+        &&_m6502_op_0x4B_0,&&_m6502_op_0x4B_1,&&_m6502_op_0x4B_2,&&_m6502_op_0x4B_3,&&_m6502_op_0x4B_4,&&_m6502_op_0x4B_5,&&_m6502_op_0x4B_6,&&_m6502_op_0x4B_7,
+        &&_m6502_op_0x4C_0,&&_m6502_op_0x4C_1,&&_m6502_op_0x4C_2,&&_m6502_op_0x4C_3,&&_m6502_op_0x4C_4,&&_m6502_op_0x4C_5,&&_m6502_op_0x4C_6,&&_m6502_op_0x4C_7,
+        &&_m6502_op_0x4D_0,&&_m6502_op_0x4D_1,&&_m6502_op_0x4D_2,&&_m6502_op_0x4D_3,&&_m6502_op_0x4D_4,&&_m6502_op_0x4D_5,&&_m6502_op_0x4D_6,&&_m6502_op_0x4D_7,
+        &&_m6502_op_0x4E_0,&&_m6502_op_0x4E_1,&&_m6502_op_0x4E_2,&&_m6502_op_0x4E_3,&&_m6502_op_0x4E_4,&&_m6502_op_0x4E_5,&&_m6502_op_0x4E_6,&&_m6502_op_0x4E_7,
+        &&_m6502_op_0x4F_0,&&_m6502_op_0x4F_1,&&_m6502_op_0x4F_2,&&_m6502_op_0x4F_3,&&_m6502_op_0x4F_4,&&_m6502_op_0x4F_5,&&_m6502_op_0x4F_6,&&_m6502_op_0x4F_7,
+        &&_m6502_op_0x50_0,&&_m6502_op_0x50_1,&&_m6502_op_0x50_2,&&_m6502_op_0x50_3,&&_m6502_op_0x50_4,&&_m6502_op_0x50_5,&&_m6502_op_0x50_6,&&_m6502_op_0x50_7,
+        &&_m6502_op_0x51_0,&&_m6502_op_0x51_1,&&_m6502_op_0x51_2,&&_m6502_op_0x51_3,&&_m6502_op_0x51_4,&&_m6502_op_0x51_5,&&_m6502_op_0x51_6,&&_m6502_op_0x51_7,
+        &&_m6502_op_0x52_0,&&_m6502_op_0x52_1,&&_m6502_op_0x52_2,&&_m6502_op_0x52_3,&&_m6502_op_0x52_4,&&_m6502_op_0x52_5,&&_m6502_op_0x52_6,&&_m6502_op_0x52_7,
+        &&_m6502_op_0x53_0,&&_m6502_op_0x53_1,&&_m6502_op_0x53_2,&&_m6502_op_0x53_3,&&_m6502_op_0x53_4,&&_m6502_op_0x53_5,&&_m6502_op_0x53_6,&&_m6502_op_0x53_7,
+        &&_m6502_op_0x54_0,&&_m6502_op_0x54_1,&&_m6502_op_0x54_2,&&_m6502_op_0x54_3,&&_m6502_op_0x54_4,&&_m6502_op_0x54_5,&&_m6502_op_0x54_6,&&_m6502_op_0x54_7,
+        &&_m6502_op_0x55_0,&&_m6502_op_0x55_1,&&_m6502_op_0x55_2,&&_m6502_op_0x55_3,&&_m6502_op_0x55_4,&&_m6502_op_0x55_5,&&_m6502_op_0x55_6,&&_m6502_op_0x55_7,
+        &&_m6502_op_0x56_0,&&_m6502_op_0x56_1,&&_m6502_op_0x56_2,&&_m6502_op_0x56_3,&&_m6502_op_0x56_4,&&_m6502_op_0x56_5,&&_m6502_op_0x56_6,&&_m6502_op_0x56_7,
+        &&_m6502_op_0x57_0,&&_m6502_op_0x57_1,&&_m6502_op_0x57_2,&&_m6502_op_0x57_3,&&_m6502_op_0x57_4,&&_m6502_op_0x57_5,&&_m6502_op_0x57_6,&&_m6502_op_0x57_7,
+        &&_m6502_op_0x58_0,&&_m6502_op_0x58_1,&&_m6502_op_0x58_2,&&_m6502_op_0x58_3,&&_m6502_op_0x58_4,&&_m6502_op_0x58_5,&&_m6502_op_0x58_6,&&_m6502_op_0x58_7,
+        &&_m6502_op_0x59_0,&&_m6502_op_0x59_1,&&_m6502_op_0x59_2,&&_m6502_op_0x59_3,&&_m6502_op_0x59_4,&&_m6502_op_0x59_5,&&_m6502_op_0x59_6,&&_m6502_op_0x59_7,
+        &&_m6502_op_0x5A_0,&&_m6502_op_0x5A_1,&&_m6502_op_0x5A_2,&&_m6502_op_0x5A_3,&&_m6502_op_0x5A_4,&&_m6502_op_0x5A_5,&&_m6502_op_0x5A_6,&&_m6502_op_0x5A_7,
+        &&_m6502_op_0x5B_0,&&_m6502_op_0x5B_1,&&_m6502_op_0x5B_2,&&_m6502_op_0x5B_3,&&_m6502_op_0x5B_4,&&_m6502_op_0x5B_5,&&_m6502_op_0x5B_6,&&_m6502_op_0x5B_7,
+        &&_m6502_op_0x5C_0,&&_m6502_op_0x5C_1,&&_m6502_op_0x5C_2,&&_m6502_op_0x5C_3,&&_m6502_op_0x5C_4,&&_m6502_op_0x5C_5,&&_m6502_op_0x5C_6,&&_m6502_op_0x5C_7,
+        &&_m6502_op_0x5D_0,&&_m6502_op_0x5D_1,&&_m6502_op_0x5D_2,&&_m6502_op_0x5D_3,&&_m6502_op_0x5D_4,&&_m6502_op_0x5D_5,&&_m6502_op_0x5D_6,&&_m6502_op_0x5D_7,
+        &&_m6502_op_0x5E_0,&&_m6502_op_0x5E_1,&&_m6502_op_0x5E_2,&&_m6502_op_0x5E_3,&&_m6502_op_0x5E_4,&&_m6502_op_0x5E_5,&&_m6502_op_0x5E_6,&&_m6502_op_0x5E_7,
+        &&_m6502_op_0x5F_0,&&_m6502_op_0x5F_1,&&_m6502_op_0x5F_2,&&_m6502_op_0x5F_3,&&_m6502_op_0x5F_4,&&_m6502_op_0x5F_5,&&_m6502_op_0x5F_6,&&_m6502_op_0x5F_7,
+        &&_m6502_op_0x60_0,&&_m6502_op_0x60_1,&&_m6502_op_0x60_2,&&_m6502_op_0x60_3,&&_m6502_op_0x60_4,&&_m6502_op_0x60_5,&&_m6502_op_0x60_6,&&_m6502_op_0x60_7,
+        &&_m6502_op_0x61_0,&&_m6502_op_0x61_1,&&_m6502_op_0x61_2,&&_m6502_op_0x61_3,&&_m6502_op_0x61_4,&&_m6502_op_0x61_5,&&_m6502_op_0x61_6,&&_m6502_op_0x61_7,
+        &&_m6502_op_0x62_0,&&_m6502_op_0x62_1,&&_m6502_op_0x62_2,&&_m6502_op_0x62_3,&&_m6502_op_0x62_4,&&_m6502_op_0x62_5,&&_m6502_op_0x62_6,&&_m6502_op_0x62_7,
+        &&_m6502_op_0x63_0,&&_m6502_op_0x63_1,&&_m6502_op_0x63_2,&&_m6502_op_0x63_3,&&_m6502_op_0x63_4,&&_m6502_op_0x63_5,&&_m6502_op_0x63_6,&&_m6502_op_0x63_7,
+        &&_m6502_op_0x64_0,&&_m6502_op_0x64_1,&&_m6502_op_0x64_2,&&_m6502_op_0x64_3,&&_m6502_op_0x64_4,&&_m6502_op_0x64_5,&&_m6502_op_0x64_6,&&_m6502_op_0x64_7,
+        &&_m6502_op_0x65_0,&&_m6502_op_0x65_1,&&_m6502_op_0x65_2,&&_m6502_op_0x65_3,&&_m6502_op_0x65_4,&&_m6502_op_0x65_5,&&_m6502_op_0x65_6,&&_m6502_op_0x65_7,
+        &&_m6502_op_0x66_0,&&_m6502_op_0x66_1,&&_m6502_op_0x66_2,&&_m6502_op_0x66_3,&&_m6502_op_0x66_4,&&_m6502_op_0x66_5,&&_m6502_op_0x66_6,&&_m6502_op_0x66_7,
+        &&_m6502_op_0x67_0,&&_m6502_op_0x67_1,&&_m6502_op_0x67_2,&&_m6502_op_0x67_3,&&_m6502_op_0x67_4,&&_m6502_op_0x67_5,&&_m6502_op_0x67_6,&&_m6502_op_0x67_7,
+        &&_m6502_op_0x68_0,&&_m6502_op_0x68_1,&&_m6502_op_0x68_2,&&_m6502_op_0x68_3,&&_m6502_op_0x68_4,&&_m6502_op_0x68_5,&&_m6502_op_0x68_6,&&_m6502_op_0x68_7,
+        &&_m6502_op_0x69_0,&&_m6502_op_0x69_1,&&_m6502_op_0x69_2,&&_m6502_op_0x69_3,&&_m6502_op_0x69_4,&&_m6502_op_0x69_5,&&_m6502_op_0x69_6,&&_m6502_op_0x69_7,
+        &&_m6502_op_0x6A_0,&&_m6502_op_0x6A_1,&&_m6502_op_0x6A_2,&&_m6502_op_0x6A_3,&&_m6502_op_0x6A_4,&&_m6502_op_0x6A_5,&&_m6502_op_0x6A_6,&&_m6502_op_0x6A_7,
+        &&_m6502_op_0x6B_0,&&_m6502_op_0x6B_1,&&_m6502_op_0x6B_2,&&_m6502_op_0x6B_3,&&_m6502_op_0x6B_4,&&_m6502_op_0x6B_5,&&_m6502_op_0x6B_6,&&_m6502_op_0x6B_7,
+        &&_m6502_op_0x6C_0,&&_m6502_op_0x6C_1,&&_m6502_op_0x6C_2,&&_m6502_op_0x6C_3,&&_m6502_op_0x6C_4,&&_m6502_op_0x6C_5,&&_m6502_op_0x6C_6,&&_m6502_op_0x6C_7,
+        &&_m6502_op_0x6D_0,&&_m6502_op_0x6D_1,&&_m6502_op_0x6D_2,&&_m6502_op_0x6D_3,&&_m6502_op_0x6D_4,&&_m6502_op_0x6D_5,&&_m6502_op_0x6D_6,&&_m6502_op_0x6D_7,
+        &&_m6502_op_0x6E_0,&&_m6502_op_0x6E_1,&&_m6502_op_0x6E_2,&&_m6502_op_0x6E_3,&&_m6502_op_0x6E_4,&&_m6502_op_0x6E_5,&&_m6502_op_0x6E_6,&&_m6502_op_0x6E_7,
+        &&_m6502_op_0x6F_0,&&_m6502_op_0x6F_1,&&_m6502_op_0x6F_2,&&_m6502_op_0x6F_3,&&_m6502_op_0x6F_4,&&_m6502_op_0x6F_5,&&_m6502_op_0x6F_6,&&_m6502_op_0x6F_7,
+        &&_m6502_op_0x70_0,&&_m6502_op_0x70_1,&&_m6502_op_0x70_2,&&_m6502_op_0x70_3,&&_m6502_op_0x70_4,&&_m6502_op_0x70_5,&&_m6502_op_0x70_6,&&_m6502_op_0x70_7,
+        &&_m6502_op_0x71_0,&&_m6502_op_0x71_1,&&_m6502_op_0x71_2,&&_m6502_op_0x71_3,&&_m6502_op_0x71_4,&&_m6502_op_0x71_5,&&_m6502_op_0x71_6,&&_m6502_op_0x71_7,
+        &&_m6502_op_0x72_0,&&_m6502_op_0x72_1,&&_m6502_op_0x72_2,&&_m6502_op_0x72_3,&&_m6502_op_0x72_4,&&_m6502_op_0x72_5,&&_m6502_op_0x72_6,&&_m6502_op_0x72_7,
+        &&_m6502_op_0x73_0,&&_m6502_op_0x73_1,&&_m6502_op_0x73_2,&&_m6502_op_0x73_3,&&_m6502_op_0x73_4,&&_m6502_op_0x73_5,&&_m6502_op_0x73_6,&&_m6502_op_0x73_7,
+        &&_m6502_op_0x74_0,&&_m6502_op_0x74_1,&&_m6502_op_0x74_2,&&_m6502_op_0x74_3,&&_m6502_op_0x74_4,&&_m6502_op_0x74_5,&&_m6502_op_0x74_6,&&_m6502_op_0x74_7,
+        &&_m6502_op_0x75_0,&&_m6502_op_0x75_1,&&_m6502_op_0x75_2,&&_m6502_op_0x75_3,&&_m6502_op_0x75_4,&&_m6502_op_0x75_5,&&_m6502_op_0x75_6,&&_m6502_op_0x75_7,
+        &&_m6502_op_0x76_0,&&_m6502_op_0x76_1,&&_m6502_op_0x76_2,&&_m6502_op_0x76_3,&&_m6502_op_0x76_4,&&_m6502_op_0x76_5,&&_m6502_op_0x76_6,&&_m6502_op_0x76_7,
+        &&_m6502_op_0x77_0,&&_m6502_op_0x77_1,&&_m6502_op_0x77_2,&&_m6502_op_0x77_3,&&_m6502_op_0x77_4,&&_m6502_op_0x77_5,&&_m6502_op_0x77_6,&&_m6502_op_0x77_7,
+        &&_m6502_op_0x78_0,&&_m6502_op_0x78_1,&&_m6502_op_0x78_2,&&_m6502_op_0x78_3,&&_m6502_op_0x78_4,&&_m6502_op_0x78_5,&&_m6502_op_0x78_6,&&_m6502_op_0x78_7,
+        &&_m6502_op_0x79_0,&&_m6502_op_0x79_1,&&_m6502_op_0x79_2,&&_m6502_op_0x79_3,&&_m6502_op_0x79_4,&&_m6502_op_0x79_5,&&_m6502_op_0x79_6,&&_m6502_op_0x79_7,
+        &&_m6502_op_0x7A_0,&&_m6502_op_0x7A_1,&&_m6502_op_0x7A_2,&&_m6502_op_0x7A_3,&&_m6502_op_0x7A_4,&&_m6502_op_0x7A_5,&&_m6502_op_0x7A_6,&&_m6502_op_0x7A_7,
+        &&_m6502_op_0x7B_0,&&_m6502_op_0x7B_1,&&_m6502_op_0x7B_2,&&_m6502_op_0x7B_3,&&_m6502_op_0x7B_4,&&_m6502_op_0x7B_5,&&_m6502_op_0x7B_6,&&_m6502_op_0x7B_7,
+        &&_m6502_op_0x7C_0,&&_m6502_op_0x7C_1,&&_m6502_op_0x7C_2,&&_m6502_op_0x7C_3,&&_m6502_op_0x7C_4,&&_m6502_op_0x7C_5,&&_m6502_op_0x7C_6,&&_m6502_op_0x7C_7,
+        &&_m6502_op_0x7D_0,&&_m6502_op_0x7D_1,&&_m6502_op_0x7D_2,&&_m6502_op_0x7D_3,&&_m6502_op_0x7D_4,&&_m6502_op_0x7D_5,&&_m6502_op_0x7D_6,&&_m6502_op_0x7D_7,
+        &&_m6502_op_0x7E_0,&&_m6502_op_0x7E_1,&&_m6502_op_0x7E_2,&&_m6502_op_0x7E_3,&&_m6502_op_0x7E_4,&&_m6502_op_0x7E_5,&&_m6502_op_0x7E_6,&&_m6502_op_0x7E_7,
+        &&_m6502_op_0x7F_0,&&_m6502_op_0x7F_1,&&_m6502_op_0x7F_2,&&_m6502_op_0x7F_3,&&_m6502_op_0x7F_4,&&_m6502_op_0x7F_5,&&_m6502_op_0x7F_6,&&_m6502_op_0x7F_7,
+        &&_m6502_op_0x80_0,&&_m6502_op_0x80_1,&&_m6502_op_0x80_2,&&_m6502_op_0x80_3,&&_m6502_op_0x80_4,&&_m6502_op_0x80_5,&&_m6502_op_0x80_6,&&_m6502_op_0x80_7,
+        &&_m6502_op_0x81_0,&&_m6502_op_0x81_1,&&_m6502_op_0x81_2,&&_m6502_op_0x81_3,&&_m6502_op_0x81_4,&&_m6502_op_0x81_5,&&_m6502_op_0x81_6,&&_m6502_op_0x81_7,
+        &&_m6502_op_0x82_0,&&_m6502_op_0x82_1,&&_m6502_op_0x82_2,&&_m6502_op_0x82_3,&&_m6502_op_0x82_4,&&_m6502_op_0x82_5,&&_m6502_op_0x82_6,&&_m6502_op_0x82_7,
+        &&_m6502_op_0x83_0,&&_m6502_op_0x83_1,&&_m6502_op_0x83_2,&&_m6502_op_0x83_3,&&_m6502_op_0x83_4,&&_m6502_op_0x83_5,&&_m6502_op_0x83_6,&&_m6502_op_0x83_7,
+        &&_m6502_op_0x84_0,&&_m6502_op_0x84_1,&&_m6502_op_0x84_2,&&_m6502_op_0x84_3,&&_m6502_op_0x84_4,&&_m6502_op_0x84_5,&&_m6502_op_0x84_6,&&_m6502_op_0x84_7,
+        &&_m6502_op_0x85_0,&&_m6502_op_0x85_1,&&_m6502_op_0x85_2,&&_m6502_op_0x85_3,&&_m6502_op_0x85_4,&&_m6502_op_0x85_5,&&_m6502_op_0x85_6,&&_m6502_op_0x85_7,
+        &&_m6502_op_0x86_0,&&_m6502_op_0x86_1,&&_m6502_op_0x86_2,&&_m6502_op_0x86_3,&&_m6502_op_0x86_4,&&_m6502_op_0x86_5,&&_m6502_op_0x86_6,&&_m6502_op_0x86_7,
+        &&_m6502_op_0x87_0,&&_m6502_op_0x87_1,&&_m6502_op_0x87_2,&&_m6502_op_0x87_3,&&_m6502_op_0x87_4,&&_m6502_op_0x87_5,&&_m6502_op_0x87_6,&&_m6502_op_0x87_7,
+        &&_m6502_op_0x88_0,&&_m6502_op_0x88_1,&&_m6502_op_0x88_2,&&_m6502_op_0x88_3,&&_m6502_op_0x88_4,&&_m6502_op_0x88_5,&&_m6502_op_0x88_6,&&_m6502_op_0x88_7,
+        &&_m6502_op_0x89_0,&&_m6502_op_0x89_1,&&_m6502_op_0x89_2,&&_m6502_op_0x89_3,&&_m6502_op_0x89_4,&&_m6502_op_0x89_5,&&_m6502_op_0x89_6,&&_m6502_op_0x89_7,
+        &&_m6502_op_0x8A_0,&&_m6502_op_0x8A_1,&&_m6502_op_0x8A_2,&&_m6502_op_0x8A_3,&&_m6502_op_0x8A_4,&&_m6502_op_0x8A_5,&&_m6502_op_0x8A_6,&&_m6502_op_0x8A_7,
+        &&_m6502_op_0x8B_0,&&_m6502_op_0x8B_1,&&_m6502_op_0x8B_2,&&_m6502_op_0x8B_3,&&_m6502_op_0x8B_4,&&_m6502_op_0x8B_5,&&_m6502_op_0x8B_6,&&_m6502_op_0x8B_7,
+        &&_m6502_op_0x8C_0,&&_m6502_op_0x8C_1,&&_m6502_op_0x8C_2,&&_m6502_op_0x8C_3,&&_m6502_op_0x8C_4,&&_m6502_op_0x8C_5,&&_m6502_op_0x8C_6,&&_m6502_op_0x8C_7,
+        &&_m6502_op_0x8D_0,&&_m6502_op_0x8D_1,&&_m6502_op_0x8D_2,&&_m6502_op_0x8D_3,&&_m6502_op_0x8D_4,&&_m6502_op_0x8D_5,&&_m6502_op_0x8D_6,&&_m6502_op_0x8D_7,
+        &&_m6502_op_0x8E_0,&&_m6502_op_0x8E_1,&&_m6502_op_0x8E_2,&&_m6502_op_0x8E_3,&&_m6502_op_0x8E_4,&&_m6502_op_0x8E_5,&&_m6502_op_0x8E_6,&&_m6502_op_0x8E_7,
+        &&_m6502_op_0x8F_0,&&_m6502_op_0x8F_1,&&_m6502_op_0x8F_2,&&_m6502_op_0x8F_3,&&_m6502_op_0x8F_4,&&_m6502_op_0x8F_5,&&_m6502_op_0x8F_6,&&_m6502_op_0x8F_7,
+        &&_m6502_op_0x90_0,&&_m6502_op_0x90_1,&&_m6502_op_0x90_2,&&_m6502_op_0x90_3,&&_m6502_op_0x90_4,&&_m6502_op_0x90_5,&&_m6502_op_0x90_6,&&_m6502_op_0x90_7,
+        &&_m6502_op_0x91_0,&&_m6502_op_0x91_1,&&_m6502_op_0x91_2,&&_m6502_op_0x91_3,&&_m6502_op_0x91_4,&&_m6502_op_0x91_5,&&_m6502_op_0x91_6,&&_m6502_op_0x91_7,
+        &&_m6502_op_0x92_0,&&_m6502_op_0x92_1,&&_m6502_op_0x92_2,&&_m6502_op_0x92_3,&&_m6502_op_0x92_4,&&_m6502_op_0x92_5,&&_m6502_op_0x92_6,&&_m6502_op_0x92_7,
+        &&_m6502_op_0x93_0,&&_m6502_op_0x93_1,&&_m6502_op_0x93_2,&&_m6502_op_0x93_3,&&_m6502_op_0x93_4,&&_m6502_op_0x93_5,&&_m6502_op_0x93_6,&&_m6502_op_0x93_7,
+        &&_m6502_op_0x94_0,&&_m6502_op_0x94_1,&&_m6502_op_0x94_2,&&_m6502_op_0x94_3,&&_m6502_op_0x94_4,&&_m6502_op_0x94_5,&&_m6502_op_0x94_6,&&_m6502_op_0x94_7,
+        &&_m6502_op_0x95_0,&&_m6502_op_0x95_1,&&_m6502_op_0x95_2,&&_m6502_op_0x95_3,&&_m6502_op_0x95_4,&&_m6502_op_0x95_5,&&_m6502_op_0x95_6,&&_m6502_op_0x95_7,
+        &&_m6502_op_0x96_0,&&_m6502_op_0x96_1,&&_m6502_op_0x96_2,&&_m6502_op_0x96_3,&&_m6502_op_0x96_4,&&_m6502_op_0x96_5,&&_m6502_op_0x96_6,&&_m6502_op_0x96_7,
+        &&_m6502_op_0x97_0,&&_m6502_op_0x97_1,&&_m6502_op_0x97_2,&&_m6502_op_0x97_3,&&_m6502_op_0x97_4,&&_m6502_op_0x97_5,&&_m6502_op_0x97_6,&&_m6502_op_0x97_7,
+        &&_m6502_op_0x98_0,&&_m6502_op_0x98_1,&&_m6502_op_0x98_2,&&_m6502_op_0x98_3,&&_m6502_op_0x98_4,&&_m6502_op_0x98_5,&&_m6502_op_0x98_6,&&_m6502_op_0x98_7,
+        &&_m6502_op_0x99_0,&&_m6502_op_0x99_1,&&_m6502_op_0x99_2,&&_m6502_op_0x99_3,&&_m6502_op_0x99_4,&&_m6502_op_0x99_5,&&_m6502_op_0x99_6,&&_m6502_op_0x99_7,
+        &&_m6502_op_0x9A_0,&&_m6502_op_0x9A_1,&&_m6502_op_0x9A_2,&&_m6502_op_0x9A_3,&&_m6502_op_0x9A_4,&&_m6502_op_0x9A_5,&&_m6502_op_0x9A_6,&&_m6502_op_0x9A_7,
+        &&_m6502_op_0x9B_0,&&_m6502_op_0x9B_1,&&_m6502_op_0x9B_2,&&_m6502_op_0x9B_3,&&_m6502_op_0x9B_4,&&_m6502_op_0x9B_5,&&_m6502_op_0x9B_6,&&_m6502_op_0x9B_7,
+        &&_m6502_op_0x9C_0,&&_m6502_op_0x9C_1,&&_m6502_op_0x9C_2,&&_m6502_op_0x9C_3,&&_m6502_op_0x9C_4,&&_m6502_op_0x9C_5,&&_m6502_op_0x9C_6,&&_m6502_op_0x9C_7,
+        &&_m6502_op_0x9D_0,&&_m6502_op_0x9D_1,&&_m6502_op_0x9D_2,&&_m6502_op_0x9D_3,&&_m6502_op_0x9D_4,&&_m6502_op_0x9D_5,&&_m6502_op_0x9D_6,&&_m6502_op_0x9D_7,
+        &&_m6502_op_0x9E_0,&&_m6502_op_0x9E_1,&&_m6502_op_0x9E_2,&&_m6502_op_0x9E_3,&&_m6502_op_0x9E_4,&&_m6502_op_0x9E_5,&&_m6502_op_0x9E_6,&&_m6502_op_0x9E_7,
+        &&_m6502_op_0x9F_0,&&_m6502_op_0x9F_1,&&_m6502_op_0x9F_2,&&_m6502_op_0x9F_3,&&_m6502_op_0x9F_4,&&_m6502_op_0x9F_5,&&_m6502_op_0x9F_6,&&_m6502_op_0x9F_7,
+        &&_m6502_op_0xA0_0,&&_m6502_op_0xA0_1,&&_m6502_op_0xA0_2,&&_m6502_op_0xA0_3,&&_m6502_op_0xA0_4,&&_m6502_op_0xA0_5,&&_m6502_op_0xA0_6,&&_m6502_op_0xA0_7,
+        &&_m6502_op_0xA1_0,&&_m6502_op_0xA1_1,&&_m6502_op_0xA1_2,&&_m6502_op_0xA1_3,&&_m6502_op_0xA1_4,&&_m6502_op_0xA1_5,&&_m6502_op_0xA1_6,&&_m6502_op_0xA1_7,
+        &&_m6502_op_0xA2_0,&&_m6502_op_0xA2_1,&&_m6502_op_0xA2_2,&&_m6502_op_0xA2_3,&&_m6502_op_0xA2_4,&&_m6502_op_0xA2_5,&&_m6502_op_0xA2_6,&&_m6502_op_0xA2_7,
+        &&_m6502_op_0xA3_0,&&_m6502_op_0xA3_1,&&_m6502_op_0xA3_2,&&_m6502_op_0xA3_3,&&_m6502_op_0xA3_4,&&_m6502_op_0xA3_5,&&_m6502_op_0xA3_6,&&_m6502_op_0xA3_7,
+        &&_m6502_op_0xA4_0,&&_m6502_op_0xA4_1,&&_m6502_op_0xA4_2,&&_m6502_op_0xA4_3,&&_m6502_op_0xA4_4,&&_m6502_op_0xA4_5,&&_m6502_op_0xA4_6,&&_m6502_op_0xA4_7,
+        &&_m6502_op_0xA5_0,&&_m6502_op_0xA5_1,&&_m6502_op_0xA5_2,&&_m6502_op_0xA5_3,&&_m6502_op_0xA5_4,&&_m6502_op_0xA5_5,&&_m6502_op_0xA5_6,&&_m6502_op_0xA5_7,
+        &&_m6502_op_0xA6_0,&&_m6502_op_0xA6_1,&&_m6502_op_0xA6_2,&&_m6502_op_0xA6_3,&&_m6502_op_0xA6_4,&&_m6502_op_0xA6_5,&&_m6502_op_0xA6_6,&&_m6502_op_0xA6_7,
+        &&_m6502_op_0xA7_0,&&_m6502_op_0xA7_1,&&_m6502_op_0xA7_2,&&_m6502_op_0xA7_3,&&_m6502_op_0xA7_4,&&_m6502_op_0xA7_5,&&_m6502_op_0xA7_6,&&_m6502_op_0xA7_7,
+        &&_m6502_op_0xA8_0,&&_m6502_op_0xA8_1,&&_m6502_op_0xA8_2,&&_m6502_op_0xA8_3,&&_m6502_op_0xA8_4,&&_m6502_op_0xA8_5,&&_m6502_op_0xA8_6,&&_m6502_op_0xA8_7,
+        &&_m6502_op_0xA9_0,&&_m6502_op_0xA9_1,&&_m6502_op_0xA9_2,&&_m6502_op_0xA9_3,&&_m6502_op_0xA9_4,&&_m6502_op_0xA9_5,&&_m6502_op_0xA9_6,&&_m6502_op_0xA9_7,
+        &&_m6502_op_0xAA_0,&&_m6502_op_0xAA_1,&&_m6502_op_0xAA_2,&&_m6502_op_0xAA_3,&&_m6502_op_0xAA_4,&&_m6502_op_0xAA_5,&&_m6502_op_0xAA_6,&&_m6502_op_0xAA_7,
+        &&_m6502_op_0xAB_0,&&_m6502_op_0xAB_1,&&_m6502_op_0xAB_2,&&_m6502_op_0xAB_3,&&_m6502_op_0xAB_4,&&_m6502_op_0xAB_5,&&_m6502_op_0xAB_6,&&_m6502_op_0xAB_7,
+        &&_m6502_op_0xAC_0,&&_m6502_op_0xAC_1,&&_m6502_op_0xAC_2,&&_m6502_op_0xAC_3,&&_m6502_op_0xAC_4,&&_m6502_op_0xAC_5,&&_m6502_op_0xAC_6,&&_m6502_op_0xAC_7,
+        &&_m6502_op_0xAD_0,&&_m6502_op_0xAD_1,&&_m6502_op_0xAD_2,&&_m6502_op_0xAD_3,&&_m6502_op_0xAD_4,&&_m6502_op_0xAD_5,&&_m6502_op_0xAD_6,&&_m6502_op_0xAD_7,
+        &&_m6502_op_0xAE_0,&&_m6502_op_0xAE_1,&&_m6502_op_0xAE_2,&&_m6502_op_0xAE_3,&&_m6502_op_0xAE_4,&&_m6502_op_0xAE_5,&&_m6502_op_0xAE_6,&&_m6502_op_0xAE_7,
+        &&_m6502_op_0xAF_0,&&_m6502_op_0xAF_1,&&_m6502_op_0xAF_2,&&_m6502_op_0xAF_3,&&_m6502_op_0xAF_4,&&_m6502_op_0xAF_5,&&_m6502_op_0xAF_6,&&_m6502_op_0xAF_7,
+        &&_m6502_op_0xB0_0,&&_m6502_op_0xB0_1,&&_m6502_op_0xB0_2,&&_m6502_op_0xB0_3,&&_m6502_op_0xB0_4,&&_m6502_op_0xB0_5,&&_m6502_op_0xB0_6,&&_m6502_op_0xB0_7,
+        &&_m6502_op_0xB1_0,&&_m6502_op_0xB1_1,&&_m6502_op_0xB1_2,&&_m6502_op_0xB1_3,&&_m6502_op_0xB1_4,&&_m6502_op_0xB1_5,&&_m6502_op_0xB1_6,&&_m6502_op_0xB1_7,
+        &&_m6502_op_0xB2_0,&&_m6502_op_0xB2_1,&&_m6502_op_0xB2_2,&&_m6502_op_0xB2_3,&&_m6502_op_0xB2_4,&&_m6502_op_0xB2_5,&&_m6502_op_0xB2_6,&&_m6502_op_0xB2_7,
+        &&_m6502_op_0xB3_0,&&_m6502_op_0xB3_1,&&_m6502_op_0xB3_2,&&_m6502_op_0xB3_3,&&_m6502_op_0xB3_4,&&_m6502_op_0xB3_5,&&_m6502_op_0xB3_6,&&_m6502_op_0xB3_7,
+        &&_m6502_op_0xB4_0,&&_m6502_op_0xB4_1,&&_m6502_op_0xB4_2,&&_m6502_op_0xB4_3,&&_m6502_op_0xB4_4,&&_m6502_op_0xB4_5,&&_m6502_op_0xB4_6,&&_m6502_op_0xB4_7,
+        &&_m6502_op_0xB5_0,&&_m6502_op_0xB5_1,&&_m6502_op_0xB5_2,&&_m6502_op_0xB5_3,&&_m6502_op_0xB5_4,&&_m6502_op_0xB5_5,&&_m6502_op_0xB5_6,&&_m6502_op_0xB5_7,
+        &&_m6502_op_0xB6_0,&&_m6502_op_0xB6_1,&&_m6502_op_0xB6_2,&&_m6502_op_0xB6_3,&&_m6502_op_0xB6_4,&&_m6502_op_0xB6_5,&&_m6502_op_0xB6_6,&&_m6502_op_0xB6_7,
+        &&_m6502_op_0xB7_0,&&_m6502_op_0xB7_1,&&_m6502_op_0xB7_2,&&_m6502_op_0xB7_3,&&_m6502_op_0xB7_4,&&_m6502_op_0xB7_5,&&_m6502_op_0xB7_6,&&_m6502_op_0xB7_7,
+        &&_m6502_op_0xB8_0,&&_m6502_op_0xB8_1,&&_m6502_op_0xB8_2,&&_m6502_op_0xB8_3,&&_m6502_op_0xB8_4,&&_m6502_op_0xB8_5,&&_m6502_op_0xB8_6,&&_m6502_op_0xB8_7,
+        &&_m6502_op_0xB9_0,&&_m6502_op_0xB9_1,&&_m6502_op_0xB9_2,&&_m6502_op_0xB9_3,&&_m6502_op_0xB9_4,&&_m6502_op_0xB9_5,&&_m6502_op_0xB9_6,&&_m6502_op_0xB9_7,
+        &&_m6502_op_0xBA_0,&&_m6502_op_0xBA_1,&&_m6502_op_0xBA_2,&&_m6502_op_0xBA_3,&&_m6502_op_0xBA_4,&&_m6502_op_0xBA_5,&&_m6502_op_0xBA_6,&&_m6502_op_0xBA_7,
+        &&_m6502_op_0xBB_0,&&_m6502_op_0xBB_1,&&_m6502_op_0xBB_2,&&_m6502_op_0xBB_3,&&_m6502_op_0xBB_4,&&_m6502_op_0xBB_5,&&_m6502_op_0xBB_6,&&_m6502_op_0xBB_7,
+        &&_m6502_op_0xBC_0,&&_m6502_op_0xBC_1,&&_m6502_op_0xBC_2,&&_m6502_op_0xBC_3,&&_m6502_op_0xBC_4,&&_m6502_op_0xBC_5,&&_m6502_op_0xBC_6,&&_m6502_op_0xBC_7,
+        &&_m6502_op_0xBD_0,&&_m6502_op_0xBD_1,&&_m6502_op_0xBD_2,&&_m6502_op_0xBD_3,&&_m6502_op_0xBD_4,&&_m6502_op_0xBD_5,&&_m6502_op_0xBD_6,&&_m6502_op_0xBD_7,
+        &&_m6502_op_0xBE_0,&&_m6502_op_0xBE_1,&&_m6502_op_0xBE_2,&&_m6502_op_0xBE_3,&&_m6502_op_0xBE_4,&&_m6502_op_0xBE_5,&&_m6502_op_0xBE_6,&&_m6502_op_0xBE_7,
+        &&_m6502_op_0xBF_0,&&_m6502_op_0xBF_1,&&_m6502_op_0xBF_2,&&_m6502_op_0xBF_3,&&_m6502_op_0xBF_4,&&_m6502_op_0xBF_5,&&_m6502_op_0xBF_6,&&_m6502_op_0xBF_7,
+        &&_m6502_op_0xC0_0,&&_m6502_op_0xC0_1,&&_m6502_op_0xC0_2,&&_m6502_op_0xC0_3,&&_m6502_op_0xC0_4,&&_m6502_op_0xC0_5,&&_m6502_op_0xC0_6,&&_m6502_op_0xC0_7,
+        &&_m6502_op_0xC1_0,&&_m6502_op_0xC1_1,&&_m6502_op_0xC1_2,&&_m6502_op_0xC1_3,&&_m6502_op_0xC1_4,&&_m6502_op_0xC1_5,&&_m6502_op_0xC1_6,&&_m6502_op_0xC1_7,
+        &&_m6502_op_0xC2_0,&&_m6502_op_0xC2_1,&&_m6502_op_0xC2_2,&&_m6502_op_0xC2_3,&&_m6502_op_0xC2_4,&&_m6502_op_0xC2_5,&&_m6502_op_0xC2_6,&&_m6502_op_0xC2_7,
+        &&_m6502_op_0xC3_0,&&_m6502_op_0xC3_1,&&_m6502_op_0xC3_2,&&_m6502_op_0xC3_3,&&_m6502_op_0xC3_4,&&_m6502_op_0xC3_5,&&_m6502_op_0xC3_6,&&_m6502_op_0xC3_7,
+        &&_m6502_op_0xC4_0,&&_m6502_op_0xC4_1,&&_m6502_op_0xC4_2,&&_m6502_op_0xC4_3,&&_m6502_op_0xC4_4,&&_m6502_op_0xC4_5,&&_m6502_op_0xC4_6,&&_m6502_op_0xC4_7,
+        &&_m6502_op_0xC5_0,&&_m6502_op_0xC5_1,&&_m6502_op_0xC5_2,&&_m6502_op_0xC5_3,&&_m6502_op_0xC5_4,&&_m6502_op_0xC5_5,&&_m6502_op_0xC5_6,&&_m6502_op_0xC5_7,
+        &&_m6502_op_0xC6_0,&&_m6502_op_0xC6_1,&&_m6502_op_0xC6_2,&&_m6502_op_0xC6_3,&&_m6502_op_0xC6_4,&&_m6502_op_0xC6_5,&&_m6502_op_0xC6_6,&&_m6502_op_0xC6_7,
+        &&_m6502_op_0xC7_0,&&_m6502_op_0xC7_1,&&_m6502_op_0xC7_2,&&_m6502_op_0xC7_3,&&_m6502_op_0xC7_4,&&_m6502_op_0xC7_5,&&_m6502_op_0xC7_6,&&_m6502_op_0xC7_7,
+        &&_m6502_op_0xC8_0,&&_m6502_op_0xC8_1,&&_m6502_op_0xC8_2,&&_m6502_op_0xC8_3,&&_m6502_op_0xC8_4,&&_m6502_op_0xC8_5,&&_m6502_op_0xC8_6,&&_m6502_op_0xC8_7,
+        &&_m6502_op_0xC9_0,&&_m6502_op_0xC9_1,&&_m6502_op_0xC9_2,&&_m6502_op_0xC9_3,&&_m6502_op_0xC9_4,&&_m6502_op_0xC9_5,&&_m6502_op_0xC9_6,&&_m6502_op_0xC9_7,
+        &&_m6502_op_0xCA_0,&&_m6502_op_0xCA_1,&&_m6502_op_0xCA_2,&&_m6502_op_0xCA_3,&&_m6502_op_0xCA_4,&&_m6502_op_0xCA_5,&&_m6502_op_0xCA_6,&&_m6502_op_0xCA_7,
+        &&_m6502_op_0xCB_0,&&_m6502_op_0xCB_1,&&_m6502_op_0xCB_2,&&_m6502_op_0xCB_3,&&_m6502_op_0xCB_4,&&_m6502_op_0xCB_5,&&_m6502_op_0xCB_6,&&_m6502_op_0xCB_7,
+        &&_m6502_op_0xCC_0,&&_m6502_op_0xCC_1,&&_m6502_op_0xCC_2,&&_m6502_op_0xCC_3,&&_m6502_op_0xCC_4,&&_m6502_op_0xCC_5,&&_m6502_op_0xCC_6,&&_m6502_op_0xCC_7,
+        &&_m6502_op_0xCD_0,&&_m6502_op_0xCD_1,&&_m6502_op_0xCD_2,&&_m6502_op_0xCD_3,&&_m6502_op_0xCD_4,&&_m6502_op_0xCD_5,&&_m6502_op_0xCD_6,&&_m6502_op_0xCD_7,
+        &&_m6502_op_0xCE_0,&&_m6502_op_0xCE_1,&&_m6502_op_0xCE_2,&&_m6502_op_0xCE_3,&&_m6502_op_0xCE_4,&&_m6502_op_0xCE_5,&&_m6502_op_0xCE_6,&&_m6502_op_0xCE_7,
+        &&_m6502_op_0xCF_0,&&_m6502_op_0xCF_1,&&_m6502_op_0xCF_2,&&_m6502_op_0xCF_3,&&_m6502_op_0xCF_4,&&_m6502_op_0xCF_5,&&_m6502_op_0xCF_6,&&_m6502_op_0xCF_7,
+        &&_m6502_op_0xD0_0,&&_m6502_op_0xD0_1,&&_m6502_op_0xD0_2,&&_m6502_op_0xD0_3,&&_m6502_op_0xD0_4,&&_m6502_op_0xD0_5,&&_m6502_op_0xD0_6,&&_m6502_op_0xD0_7,
+        &&_m6502_op_0xD1_0,&&_m6502_op_0xD1_1,&&_m6502_op_0xD1_2,&&_m6502_op_0xD1_3,&&_m6502_op_0xD1_4,&&_m6502_op_0xD1_5,&&_m6502_op_0xD1_6,&&_m6502_op_0xD1_7,
+        &&_m6502_op_0xD2_0,&&_m6502_op_0xD2_1,&&_m6502_op_0xD2_2,&&_m6502_op_0xD2_3,&&_m6502_op_0xD2_4,&&_m6502_op_0xD2_5,&&_m6502_op_0xD2_6,&&_m6502_op_0xD2_7,
+        &&_m6502_op_0xD3_0,&&_m6502_op_0xD3_1,&&_m6502_op_0xD3_2,&&_m6502_op_0xD3_3,&&_m6502_op_0xD3_4,&&_m6502_op_0xD3_5,&&_m6502_op_0xD3_6,&&_m6502_op_0xD3_7,
+        &&_m6502_op_0xD4_0,&&_m6502_op_0xD4_1,&&_m6502_op_0xD4_2,&&_m6502_op_0xD4_3,&&_m6502_op_0xD4_4,&&_m6502_op_0xD4_5,&&_m6502_op_0xD4_6,&&_m6502_op_0xD4_7,
+        &&_m6502_op_0xD5_0,&&_m6502_op_0xD5_1,&&_m6502_op_0xD5_2,&&_m6502_op_0xD5_3,&&_m6502_op_0xD5_4,&&_m6502_op_0xD5_5,&&_m6502_op_0xD5_6,&&_m6502_op_0xD5_7,
+        &&_m6502_op_0xD6_0,&&_m6502_op_0xD6_1,&&_m6502_op_0xD6_2,&&_m6502_op_0xD6_3,&&_m6502_op_0xD6_4,&&_m6502_op_0xD6_5,&&_m6502_op_0xD6_6,&&_m6502_op_0xD6_7,
+        &&_m6502_op_0xD7_0,&&_m6502_op_0xD7_1,&&_m6502_op_0xD7_2,&&_m6502_op_0xD7_3,&&_m6502_op_0xD7_4,&&_m6502_op_0xD7_5,&&_m6502_op_0xD7_6,&&_m6502_op_0xD7_7,
+        &&_m6502_op_0xD8_0,&&_m6502_op_0xD8_1,&&_m6502_op_0xD8_2,&&_m6502_op_0xD8_3,&&_m6502_op_0xD8_4,&&_m6502_op_0xD8_5,&&_m6502_op_0xD8_6,&&_m6502_op_0xD8_7,
+        &&_m6502_op_0xD9_0,&&_m6502_op_0xD9_1,&&_m6502_op_0xD9_2,&&_m6502_op_0xD9_3,&&_m6502_op_0xD9_4,&&_m6502_op_0xD9_5,&&_m6502_op_0xD9_6,&&_m6502_op_0xD9_7,
+        &&_m6502_op_0xDA_0,&&_m6502_op_0xDA_1,&&_m6502_op_0xDA_2,&&_m6502_op_0xDA_3,&&_m6502_op_0xDA_4,&&_m6502_op_0xDA_5,&&_m6502_op_0xDA_6,&&_m6502_op_0xDA_7,
+        &&_m6502_op_0xDB_0,&&_m6502_op_0xDB_1,&&_m6502_op_0xDB_2,&&_m6502_op_0xDB_3,&&_m6502_op_0xDB_4,&&_m6502_op_0xDB_5,&&_m6502_op_0xDB_6,&&_m6502_op_0xDB_7,
+        &&_m6502_op_0xDC_0,&&_m6502_op_0xDC_1,&&_m6502_op_0xDC_2,&&_m6502_op_0xDC_3,&&_m6502_op_0xDC_4,&&_m6502_op_0xDC_5,&&_m6502_op_0xDC_6,&&_m6502_op_0xDC_7,
+        &&_m6502_op_0xDD_0,&&_m6502_op_0xDD_1,&&_m6502_op_0xDD_2,&&_m6502_op_0xDD_3,&&_m6502_op_0xDD_4,&&_m6502_op_0xDD_5,&&_m6502_op_0xDD_6,&&_m6502_op_0xDD_7,
+        &&_m6502_op_0xDE_0,&&_m6502_op_0xDE_1,&&_m6502_op_0xDE_2,&&_m6502_op_0xDE_3,&&_m6502_op_0xDE_4,&&_m6502_op_0xDE_5,&&_m6502_op_0xDE_6,&&_m6502_op_0xDE_7,
+        &&_m6502_op_0xDF_0,&&_m6502_op_0xDF_1,&&_m6502_op_0xDF_2,&&_m6502_op_0xDF_3,&&_m6502_op_0xDF_4,&&_m6502_op_0xDF_5,&&_m6502_op_0xDF_6,&&_m6502_op_0xDF_7,
+        &&_m6502_op_0xE0_0,&&_m6502_op_0xE0_1,&&_m6502_op_0xE0_2,&&_m6502_op_0xE0_3,&&_m6502_op_0xE0_4,&&_m6502_op_0xE0_5,&&_m6502_op_0xE0_6,&&_m6502_op_0xE0_7,
+        &&_m6502_op_0xE1_0,&&_m6502_op_0xE1_1,&&_m6502_op_0xE1_2,&&_m6502_op_0xE1_3,&&_m6502_op_0xE1_4,&&_m6502_op_0xE1_5,&&_m6502_op_0xE1_6,&&_m6502_op_0xE1_7,
+        &&_m6502_op_0xE2_0,&&_m6502_op_0xE2_1,&&_m6502_op_0xE2_2,&&_m6502_op_0xE2_3,&&_m6502_op_0xE2_4,&&_m6502_op_0xE2_5,&&_m6502_op_0xE2_6,&&_m6502_op_0xE2_7,
+        &&_m6502_op_0xE3_0,&&_m6502_op_0xE3_1,&&_m6502_op_0xE3_2,&&_m6502_op_0xE3_3,&&_m6502_op_0xE3_4,&&_m6502_op_0xE3_5,&&_m6502_op_0xE3_6,&&_m6502_op_0xE3_7,
+        &&_m6502_op_0xE4_0,&&_m6502_op_0xE4_1,&&_m6502_op_0xE4_2,&&_m6502_op_0xE4_3,&&_m6502_op_0xE4_4,&&_m6502_op_0xE4_5,&&_m6502_op_0xE4_6,&&_m6502_op_0xE4_7,
+        &&_m6502_op_0xE5_0,&&_m6502_op_0xE5_1,&&_m6502_op_0xE5_2,&&_m6502_op_0xE5_3,&&_m6502_op_0xE5_4,&&_m6502_op_0xE5_5,&&_m6502_op_0xE5_6,&&_m6502_op_0xE5_7,
+        &&_m6502_op_0xE6_0,&&_m6502_op_0xE6_1,&&_m6502_op_0xE6_2,&&_m6502_op_0xE6_3,&&_m6502_op_0xE6_4,&&_m6502_op_0xE6_5,&&_m6502_op_0xE6_6,&&_m6502_op_0xE6_7,
+        &&_m6502_op_0xE7_0,&&_m6502_op_0xE7_1,&&_m6502_op_0xE7_2,&&_m6502_op_0xE7_3,&&_m6502_op_0xE7_4,&&_m6502_op_0xE7_5,&&_m6502_op_0xE7_6,&&_m6502_op_0xE7_7,
+        &&_m6502_op_0xE8_0,&&_m6502_op_0xE8_1,&&_m6502_op_0xE8_2,&&_m6502_op_0xE8_3,&&_m6502_op_0xE8_4,&&_m6502_op_0xE8_5,&&_m6502_op_0xE8_6,&&_m6502_op_0xE8_7,
+        &&_m6502_op_0xE9_0,&&_m6502_op_0xE9_1,&&_m6502_op_0xE9_2,&&_m6502_op_0xE9_3,&&_m6502_op_0xE9_4,&&_m6502_op_0xE9_5,&&_m6502_op_0xE9_6,&&_m6502_op_0xE9_7,
+        &&_m6502_op_0xEA_0,&&_m6502_op_0xEA_1,&&_m6502_op_0xEA_2,&&_m6502_op_0xEA_3,&&_m6502_op_0xEA_4,&&_m6502_op_0xEA_5,&&_m6502_op_0xEA_6,&&_m6502_op_0xEA_7,
+        &&_m6502_op_0xEB_0,&&_m6502_op_0xEB_1,&&_m6502_op_0xEB_2,&&_m6502_op_0xEB_3,&&_m6502_op_0xEB_4,&&_m6502_op_0xEB_5,&&_m6502_op_0xEB_6,&&_m6502_op_0xEB_7,
+        &&_m6502_op_0xEC_0,&&_m6502_op_0xEC_1,&&_m6502_op_0xEC_2,&&_m6502_op_0xEC_3,&&_m6502_op_0xEC_4,&&_m6502_op_0xEC_5,&&_m6502_op_0xEC_6,&&_m6502_op_0xEC_7,
+        &&_m6502_op_0xED_0,&&_m6502_op_0xED_1,&&_m6502_op_0xED_2,&&_m6502_op_0xED_3,&&_m6502_op_0xED_4,&&_m6502_op_0xED_5,&&_m6502_op_0xED_6,&&_m6502_op_0xED_7,
+        &&_m6502_op_0xEE_0,&&_m6502_op_0xEE_1,&&_m6502_op_0xEE_2,&&_m6502_op_0xEE_3,&&_m6502_op_0xEE_4,&&_m6502_op_0xEE_5,&&_m6502_op_0xEE_6,&&_m6502_op_0xEE_7,
+        &&_m6502_op_0xEF_0,&&_m6502_op_0xEF_1,&&_m6502_op_0xEF_2,&&_m6502_op_0xEF_3,&&_m6502_op_0xEF_4,&&_m6502_op_0xEF_5,&&_m6502_op_0xEF_6,&&_m6502_op_0xEF_7,
+        &&_m6502_op_0xF0_0,&&_m6502_op_0xF0_1,&&_m6502_op_0xF0_2,&&_m6502_op_0xF0_3,&&_m6502_op_0xF0_4,&&_m6502_op_0xF0_5,&&_m6502_op_0xF0_6,&&_m6502_op_0xF0_7,
+        &&_m6502_op_0xF1_0,&&_m6502_op_0xF1_1,&&_m6502_op_0xF1_2,&&_m6502_op_0xF1_3,&&_m6502_op_0xF1_4,&&_m6502_op_0xF1_5,&&_m6502_op_0xF1_6,&&_m6502_op_0xF1_7,
+        &&_m6502_op_0xF2_0,&&_m6502_op_0xF2_1,&&_m6502_op_0xF2_2,&&_m6502_op_0xF2_3,&&_m6502_op_0xF2_4,&&_m6502_op_0xF2_5,&&_m6502_op_0xF2_6,&&_m6502_op_0xF2_7,
+        &&_m6502_op_0xF3_0,&&_m6502_op_0xF3_1,&&_m6502_op_0xF3_2,&&_m6502_op_0xF3_3,&&_m6502_op_0xF3_4,&&_m6502_op_0xF3_5,&&_m6502_op_0xF3_6,&&_m6502_op_0xF3_7,
+        &&_m6502_op_0xF4_0,&&_m6502_op_0xF4_1,&&_m6502_op_0xF4_2,&&_m6502_op_0xF4_3,&&_m6502_op_0xF4_4,&&_m6502_op_0xF4_5,&&_m6502_op_0xF4_6,&&_m6502_op_0xF4_7,
+        &&_m6502_op_0xF5_0,&&_m6502_op_0xF5_1,&&_m6502_op_0xF5_2,&&_m6502_op_0xF5_3,&&_m6502_op_0xF5_4,&&_m6502_op_0xF5_5,&&_m6502_op_0xF5_6,&&_m6502_op_0xF5_7,
+        &&_m6502_op_0xF6_0,&&_m6502_op_0xF6_1,&&_m6502_op_0xF6_2,&&_m6502_op_0xF6_3,&&_m6502_op_0xF6_4,&&_m6502_op_0xF6_5,&&_m6502_op_0xF6_6,&&_m6502_op_0xF6_7,
+        &&_m6502_op_0xF7_0,&&_m6502_op_0xF7_1,&&_m6502_op_0xF7_2,&&_m6502_op_0xF7_3,&&_m6502_op_0xF7_4,&&_m6502_op_0xF7_5,&&_m6502_op_0xF7_6,&&_m6502_op_0xF7_7,
+        &&_m6502_op_0xF8_0,&&_m6502_op_0xF8_1,&&_m6502_op_0xF8_2,&&_m6502_op_0xF8_3,&&_m6502_op_0xF8_4,&&_m6502_op_0xF8_5,&&_m6502_op_0xF8_6,&&_m6502_op_0xF8_7,
+        &&_m6502_op_0xF9_0,&&_m6502_op_0xF9_1,&&_m6502_op_0xF9_2,&&_m6502_op_0xF9_3,&&_m6502_op_0xF9_4,&&_m6502_op_0xF9_5,&&_m6502_op_0xF9_6,&&_m6502_op_0xF9_7,
+        &&_m6502_op_0xFA_0,&&_m6502_op_0xFA_1,&&_m6502_op_0xFA_2,&&_m6502_op_0xFA_3,&&_m6502_op_0xFA_4,&&_m6502_op_0xFA_5,&&_m6502_op_0xFA_6,&&_m6502_op_0xFA_7,
+        &&_m6502_op_0xFB_0,&&_m6502_op_0xFB_1,&&_m6502_op_0xFB_2,&&_m6502_op_0xFB_3,&&_m6502_op_0xFB_4,&&_m6502_op_0xFB_5,&&_m6502_op_0xFB_6,&&_m6502_op_0xFB_7,
+        &&_m6502_op_0xFC_0,&&_m6502_op_0xFC_1,&&_m6502_op_0xFC_2,&&_m6502_op_0xFC_3,&&_m6502_op_0xFC_4,&&_m6502_op_0xFC_5,&&_m6502_op_0xFC_6,&&_m6502_op_0xFC_7,
+        &&_m6502_op_0xFD_0,&&_m6502_op_0xFD_1,&&_m6502_op_0xFD_2,&&_m6502_op_0xFD_3,&&_m6502_op_0xFD_4,&&_m6502_op_0xFD_5,&&_m6502_op_0xFD_6,&&_m6502_op_0xFD_7,
+        &&_m6502_op_0xFE_0,&&_m6502_op_0xFE_1,&&_m6502_op_0xFE_2,&&_m6502_op_0xFE_3,&&_m6502_op_0xFE_4,&&_m6502_op_0xFE_5,&&_m6502_op_0xFE_6,&&_m6502_op_0xFE_7,
+        &&_m6502_op_0xFF_0,&&_m6502_op_0xFF_1,&&_m6502_op_0xFF_2,&&_m6502_op_0xFF_3,&&_m6502_op_0xFF_4,&&_m6502_op_0xFF_5,&&_m6502_op_0xFF_6,&&_m6502_op_0xFF_7,
+    };
+    #endif
+    _DISPATCH(_m6502_op_table)
+    /* BRK  */
+        _OP(0x00,0): _SA(c->PC);_NEXT()
+        _OP(0x00,1): if(0==(c->brk_flags&(M6502_BRK_IRQ|M6502_BRK_NMI))){c->PC++;}_SAD(0x0100|c->S--,c->PC>>8);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}_NEXT()
+        _OP(0x00,2): _SAD(0x0100|c->S--,c->PC);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}_NEXT()
+        _OP(0x00,3): _SAD(0x0100|c->S--,c->P|M6502_XF);if(c->brk_flags&M6502_BRK_RESET){c->AD=0xFFFC;}else{_WR();if(c->brk_flags&M6502_BRK_NMI){c->AD=0xFFFA;}else{c->AD=0xFFFE;}}_NEXT()
+        _OP(0x00,4): _SA(c->AD++);c->P|=(M6502_IF|M6502_BF);c->brk_flags=0; /* RES/NMI hijacking */_NEXT()
+        _OP(0x00,5): _SA(c->AD);c->AD=_GD(); /* NMI "half-hijacking" not possible */_NEXT()
+        _OP(0x00,6): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x00,7): assert(false);_NEXT()
+    /* ORA (zp,X) */
+        _OP(0x01,0): _SA(c->PC++);_NEXT()
+        _OP(0x01,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x01,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x01,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x01,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x01,5): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x01,6): assert(false);_NEXT()
+        _OP(0x01,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x02,0): _SA(c->PC);_NEXT()
+        _OP(0x02,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x02,2): assert(false);_NEXT()
+        _OP(0x02,3): assert(false);_NEXT()
+        _OP(0x02,4): assert(false);_NEXT()
+        _OP(0x02,5): assert(false);_NEXT()
+        _OP(0x02,6): assert(false);_NEXT()
+        _OP(0x02,7): assert(false);_NEXT()
+    /* SLO (zp,X) (undoc) */
+        _OP(0x03,0): _SA(c->PC++);_NEXT()
+        _OP(0x03,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x03,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x03,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x03,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x03,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x03,6): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x03,7): _FETCH();_NEXT()
+    /* NOP zp (undoc) */
+        _OP(0x04,0): _SA(c->PC++);_NEXT()
+        _OP(0x04,1): _SA(_GD());_NEXT()
+        _OP(0x04,2): _FETCH();_NEXT()
+        _OP(0x04,3): assert(false);_NEXT()
+        _OP(0x04,4): assert(false);_NEXT()
+        _OP(0x04,5): assert(false);_NEXT()
+        _OP(0x04,6): assert(false);_NEXT()
+        _OP(0x04,7): assert(false);_NEXT()
+    /* ORA zp */
+        _OP(0x05,0): _SA(c->PC++);_NEXT()
+        _OP(0x05,1): _SA(_GD());_NEXT()
+        _OP(0x05,2): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x05,3): assert(false);_NEXT()
+        _OP(0x05,4): assert(false);_NEXT()
+        _OP(0x05,5): assert(false);_NEXT()
+        _OP(0x05,6): assert(false);_NEXT()
+        _OP(0x05,7): assert(false);_NEXT()
+    /* ASL zp */
+        _OP(0x06,0): _SA(c->PC++);_NEXT()
+        _OP(0x06,1): _SA(_GD());_NEXT()
+        _OP(0x06,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x06,3): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x06,4): _FETCH();_NEXT()
+        _OP(0x06,5): assert(false);_NEXT()
+        _OP(0x06,6): assert(false);_NEXT()
+        _OP(0x06,7): assert(false);_NEXT()
+    /* SLO zp (undoc) */
+        _OP(0x07,0): _SA(c->PC++);_NEXT()
+        _OP(0x07,1): _SA(_GD());_NEXT()
+        _OP(0x07,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x07,3): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x07,4): _FETCH();_NEXT()
+        _OP(0x07,5): assert(false);_NEXT()
+        _OP(0x07,6): assert(false);_NEXT()
+        _OP(0x07,7): assert(false);_NEXT()
+    /* PHP  */
+        _OP(0x08,0): _SA(c->PC);_NEXT()
+        _OP(0x08,1): _SAD(0x0100|c->S--,c->P|M6502_XF);_WR();_NEXT()
+        _OP(0x08,2): _FETCH();_NEXT()
+        _OP(0x08,3): assert(false);_NEXT()
+        _OP(0x08,4): assert(false);_NEXT()
+        _OP(0x08,5): assert(false);_NEXT()
+        _OP(0x08,6): assert(false);_NEXT()
+        _OP(0x08,7): assert(false);_NEXT()
+    /* ORA # */
+        _OP(0x09,0): _SA(c->PC++);_NEXT()
+        _OP(0x09,1): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x09,2): assert(false);_NEXT()
+        _OP(0x09,3): assert(false);_NEXT()
+        _OP(0x09,4): assert(false);_NEXT()
+        _OP(0x09,5): assert(false);_NEXT()
+        _OP(0x09,6): assert(false);_NEXT()
+        _OP(0x09,7): assert(false);_NEXT()
+    /* ASLA  */
+        _OP(0x0A,0): _SA(c->PC);_NEXT()
+        _OP(0x0A,1): c->A=_m6502_asl(c,c->A);_FETCH();_NEXT()
+        _OP(0x0A,2): assert(false);_NEXT()
+        _OP(0x0A,3): assert(false);_NEXT()
+        _OP(0x0A,4): assert(false);_NEXT()
+        _OP(0x0A,5): assert(false);_NEXT()
+        _OP(0x0A,6): assert(false);_NEXT()
+        _OP(0x0A,7): assert(false);_NEXT()
+    /* ANC # (undoc) */
+        _OP(0x0B,0): _SA(c->PC++);_NEXT()
+        _OP(0x0B,1): c->A&=_GD();_NZ(c->A);if(c->A&0x80){c->P|=M6502_CF;}else{c->P&=~M6502_CF;}_FETCH();_NEXT()
+        _OP(0x0B,2): assert(false);_NEXT()
+        _OP(0x0B,3): assert(false);_NEXT()
+        _OP(0x0B,4): assert(false);_NEXT()
+        _OP(0x0B,5): assert(false);_NEXT()
+        _OP(0x0B,6): assert(false);_NEXT()
+        _OP(0x0B,7): assert(false);_NEXT()
+    /* NOP abs (undoc) */
+        _OP(0x0C,0): _SA(c->PC++);_NEXT()
+        _OP(0x0C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0C,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0C,3): _FETCH();_NEXT()
+        _OP(0x0C,4): assert(false);_NEXT()
+        _OP(0x0C,5): assert(false);_NEXT()
+        _OP(0x0C,6): assert(false);_NEXT()
+        _OP(0x0C,7): assert(false);_NEXT()
+    /* ORA abs */
+        _OP(0x0D,0): _SA(c->PC++);_NEXT()
+        _OP(0x0D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0D,3): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x0D,4): assert(false);_NEXT()
+        _OP(0x0D,5): assert(false);_NEXT()
+        _OP(0x0D,6): assert(false);_NEXT()
+        _OP(0x0D,7): assert(false);_NEXT()
+    /* ASL abs */
+        _OP(0x0E,0): _SA(c->PC++);_NEXT()
+        _OP(0x0E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0E,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x0E,4): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x0E,5): _FETCH();_NEXT()
+        _OP(0x0E,6): assert(false);_NEXT()
+        _OP(0x0E,7): assert(false);_NEXT()
+    /* SLO abs (undoc) */
+        _OP(0x0F,0): _SA(c->PC++);_NEXT()
+        _OP(0x0F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0F,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0F,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x0F,4): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x0F,5): _FETCH();_NEXT()
+        _OP(0x0F,6): assert(false);_NEXT()
+        _OP(0x0F,7): assert(false);_NEXT()
+    /* BPL # */
+        _OP(0x10,0): _SA(c->PC++);_NEXT()
+        _OP(0x10,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x80)!=0x0){_FETCH();};_NEXT()
+        _OP(0x10,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x10,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x10,4): assert(false);_NEXT()
+        _OP(0x10,5): assert(false);_NEXT()
+        _OP(0x10,6): assert(false);_NEXT()
+        _OP(0x10,7): assert(false);_NEXT()
+    /* ORA (zp),Y */
+        _OP(0x11,0): _SA(c->PC++);_NEXT()
+        _OP(0x11,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x11,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x11,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x11,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x11,5): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x11,6): assert(false);_NEXT()
+        _OP(0x11,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x12,0): _SA(c->PC);_NEXT()
+        _OP(0x12,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x12,2): assert(false);_NEXT()
+        _OP(0x12,3): assert(false);_NEXT()
+        _OP(0x12,4): assert(false);_NEXT()
+        _OP(0x12,5): assert(false);_NEXT()
+        _OP(0x12,6): assert(false);_NEXT()
+        _OP(0x12,7): assert(false);_NEXT()
+    /* SLO (zp),Y (undoc) */
+        _OP(0x13,0): _SA(c->PC++);_NEXT()
+        _OP(0x13,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x13,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x13,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x13,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x13,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x13,6): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x13,7): _FETCH();_NEXT()
+    /* NOP zp,X (undoc) */
+        _OP(0x14,0): _SA(c->PC++);_NEXT()
+        _OP(0x14,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x14,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x14,3): _FETCH();_NEXT()
+        _OP(0x14,4): assert(false);_NEXT()
+        _OP(0x14,5): assert(false);_NEXT()
+        _OP(0x14,6): assert(false);_NEXT()
+        _OP(0x14,7): assert(false);_NEXT()
+    /* ORA zp,X */
+        _OP(0x15,0): _SA(c->PC++);_NEXT()
+        _OP(0x15,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x15,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x15,3): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x15,4): assert(false);_NEXT()
+        _OP(0x15,5): assert(false);_NEXT()
+        _OP(0x15,6): assert(false);_NEXT()
+        _OP(0x15,7): assert(false);_NEXT()
+    /* ASL zp,X */
+        _OP(0x16,0): _SA(c->PC++);_NEXT()
+        _OP(0x16,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x16,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x16,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x16,4): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x16,5): _FETCH();_NEXT()
+        _OP(0x16,6): assert(false);_NEXT()
+        _OP(0x16,7): assert(false);_NEXT()
+    /* SLO zp,X (undoc) */
+        _OP(0x17,0): _SA(c->PC++);_NEXT()
+        _OP(0x17,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x17,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x17,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x17,4): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x17,5): _FETCH();_NEXT()
+        _OP(0x17,6): assert(false);_NEXT()
+        _OP(0x17,7): assert(false);_NEXT()
+    /* CLC  */
+        _OP(0x18,0): _SA(c->PC);_NEXT()
+        _OP(0x18,1): c->P&=~0x1;_FETCH();_NEXT()
+        _OP(0x18,2): assert(false);_NEXT()
+        _OP(0x18,3): assert(false);_NEXT()
+        _OP(0x18,4): assert(false);_NEXT()
+        _OP(0x18,5): assert(false);_NEXT()
+        _OP(0x18,6): assert(false);_NEXT()
+        _OP(0x18,7): assert(false);_NEXT()
+    /* ORA abs,Y */
+        _OP(0x19,0): _SA(c->PC++);_NEXT()
+        _OP(0x19,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x19,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x19,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x19,4): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x19,5): assert(false);_NEXT()
+        _OP(0x19,6): assert(false);_NEXT()
+        _OP(0x19,7): assert(false);_NEXT()
+    /* NOP  (undoc) */
+        _OP(0x1A,0): _SA(c->PC);_NEXT()
+        _OP(0x1A,1): _FETCH();_NEXT()
+        _OP(0x1A,2): assert(false);_NEXT()
+        _OP(0x1A,3): assert(false);_NEXT()
+        _OP(0x1A,4): assert(false);_NEXT()
+        _OP(0x1A,5): assert(false);_NEXT()
+        _OP(0x1A,6): assert(false);_NEXT()
+        _OP(0x1A,7): assert(false);_NEXT()
+    /* SLO abs,Y (undoc) */
+        _OP(0x1B,0): _SA(c->PC++);_NEXT()
+        _OP(0x1B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x1B,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x1B,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x1B,5): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x1B,6): _FETCH();_NEXT()
+        _OP(0x1B,7): assert(false);_NEXT()
+    /* NOP abs,X (undoc) */
+        _OP(0x1C,0): _SA(c->PC++);_NEXT()
+        _OP(0x1C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x1C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1C,4): _FETCH();_NEXT()
+        _OP(0x1C,5): assert(false);_NEXT()
+        _OP(0x1C,6): assert(false);_NEXT()
+        _OP(0x1C,7): assert(false);_NEXT()
+    /* ORA abs,X */
+        _OP(0x1D,0): _SA(c->PC++);_NEXT()
+        _OP(0x1D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x1D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1D,4): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x1D,5): assert(false);_NEXT()
+        _OP(0x1D,6): assert(false);_NEXT()
+        _OP(0x1D,7): assert(false);_NEXT()
+    /* ASL abs,X */
+        _OP(0x1E,0): _SA(c->PC++);_NEXT()
+        _OP(0x1E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x1E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1E,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x1E,5): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x1E,6): _FETCH();_NEXT()
+        _OP(0x1E,7): assert(false);_NEXT()
+    /* SLO abs,X (undoc) */
+        _OP(0x1F,0): _SA(c->PC++);_NEXT()
+        _OP(0x1F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x1F,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1F,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x1F,5): c->AD=_m6502_asl(c,c->AD);_SD(c->AD);c->A|=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x1F,6): _FETCH();_NEXT()
+        _OP(0x1F,7): assert(false);_NEXT()
+    /* JSR  */
+        _OP(0x20,0): _SA(c->PC++);_NEXT()
+        _OP(0x20,1): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x20,2): _SAD(0x0100|c->S--,c->PC>>8);_WR();_NEXT()
+        _OP(0x20,3): _SAD(0x0100|c->S--,c->PC);_WR();_NEXT()
+        _OP(0x20,4): _SA(c->PC);_NEXT()
+        _OP(0x20,5): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x20,6): assert(false);_NEXT()
+        _OP(0x20,7): assert(false);_NEXT()
+    /* AND (zp,X) */
+        _OP(0x21,0): _SA(c->PC++);_NEXT()
+        _OP(0x21,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x21,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x21,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x21,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x21,5): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x21,6): assert(false);_NEXT()
+        _OP(0x21,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x22,0): _SA(c->PC);_NEXT()
+        _OP(0x22,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x22,2): assert(false);_NEXT()
+        _OP(0x22,3): assert(false);_NEXT()
+        _OP(0x22,4): assert(false);_NEXT()
+        _OP(0x22,5): assert(false);_NEXT()
+        _OP(0x22,6): assert(false);_NEXT()
+        _OP(0x22,7): assert(false);_NEXT()
+    /* RLA (zp,X) (undoc) */
+        _OP(0x23,0): _SA(c->PC++);_NEXT()
+        _OP(0x23,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x23,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x23,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x23,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x23,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x23,6): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x23,7): _FETCH();_NEXT()
+    /* BIT zp */
+        _OP(0x24,0): _SA(c->PC++);_NEXT()
+        _OP(0x24,1): _SA(_GD());_NEXT()
+        _OP(0x24,2): _m6502_bit(c,_GD());_FETCH();_NEXT()
+        _OP(0x24,3): assert(false);_NEXT()
+        _OP(0x24,4): assert(false);_NEXT()
+        _OP(0x24,5): assert(false);_NEXT()
+        _OP(0x24,6): assert(false);_NEXT()
+        _OP(0x24,7): assert(false);_NEXT()
+    /* AND zp */
+        _OP(0x25,0): _SA(c->PC++);_NEXT()
+        _OP(0x25,1): _SA(_GD());_NEXT()
+        _OP(0x25,2): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x25,3): assert(false);_NEXT()
+        _OP(0x25,4): assert(false);_NEXT()
+        _OP(0x25,5): assert(false);_NEXT()
+        _OP(0x25,6): assert(false);_NEXT()
+        _OP(0x25,7): assert(false);_NEXT()
+    /* ROL zp */
+        _OP(0x26,0): _SA(c->PC++);_NEXT()
+        _OP(0x26,1): _SA(_GD());_NEXT()
+        _OP(0x26,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x26,3): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x26,4): _FETCH();_NEXT()
+        _OP(0x26,5): assert(false);_NEXT()
+        _OP(0x26,6): assert(false);_NEXT()
+        _OP(0x26,7): assert(false);_NEXT()
+    /* RLA zp (undoc) */
+        _OP(0x27,0): _SA(c->PC++);_NEXT()
+        _OP(0x27,1): _SA(_GD());_NEXT()
+        _OP(0x27,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x27,3): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x27,4): _FETCH();_NEXT()
+        _OP(0x27,5): assert(false);_NEXT()
+        _OP(0x27,6): assert(false);_NEXT()
+        _OP(0x27,7): assert(false);_NEXT()
+    /* PLP  */
+        _OP(0x28,0): _SA(c->PC);_NEXT()
+        _OP(0x28,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x28,2): _SA(0x0100|c->S);_NEXT()
+        _OP(0x28,3): c->P=(_GD()|M6502_BF)&~M6502_XF;_FETCH();_NEXT()
+        _OP(0x28,4): assert(false);_NEXT()
+        _OP(0x28,5): assert(false);_NEXT()
+        _OP(0x28,6): assert(false);_NEXT()
+        _OP(0x28,7): assert(false);_NEXT()
+    /* AND # */
+        _OP(0x29,0): _SA(c->PC++);_NEXT()
+        _OP(0x29,1): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x29,2): assert(false);_NEXT()
+        _OP(0x29,3): assert(false);_NEXT()
+        _OP(0x29,4): assert(false);_NEXT()
+        _OP(0x29,5): assert(false);_NEXT()
+        _OP(0x29,6): assert(false);_NEXT()
+        _OP(0x29,7): assert(false);_NEXT()
+    /* ROLA  */
+        _OP(0x2A,0): _SA(c->PC);_NEXT()
+        _OP(0x2A,1): c->A=_m6502_rol(c,c->A);_FETCH();_NEXT()
+        _OP(0x2A,2): assert(false);_NEXT()
+        _OP(0x2A,3): assert(false);_NEXT()
+        _OP(0x2A,4): assert(false);_NEXT()
+        _OP(0x2A,5): assert(false);_NEXT()
+        _OP(0x2A,6): assert(false);_NEXT()
+        _OP(0x2A,7): assert(false);_NEXT()
+    /* ANC # (undoc) */
+        _OP(0x2B,0): _SA(c->PC++);_NEXT()
+        _OP(0x2B,1): c->A&=_GD();_NZ(c->A);if(c->A&0x80){c->P|=M6502_CF;}else{c->P&=~M6502_CF;}_FETCH();_NEXT()
+        _OP(0x2B,2): assert(false);_NEXT()
+        _OP(0x2B,3): assert(false);_NEXT()
+        _OP(0x2B,4): assert(false);_NEXT()
+        _OP(0x2B,5): assert(false);_NEXT()
+        _OP(0x2B,6): assert(false);_NEXT()
+        _OP(0x2B,7): assert(false);_NEXT()
+    /* BIT abs */
+        _OP(0x2C,0): _SA(c->PC++);_NEXT()
+        _OP(0x2C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2C,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2C,3): _m6502_bit(c,_GD());_FETCH();_NEXT()
+        _OP(0x2C,4): assert(false);_NEXT()
+        _OP(0x2C,5): assert(false);_NEXT()
+        _OP(0x2C,6): assert(false);_NEXT()
+        _OP(0x2C,7): assert(false);_NEXT()
+    /* AND abs */
+        _OP(0x2D,0): _SA(c->PC++);_NEXT()
+        _OP(0x2D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2D,3): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x2D,4): assert(false);_NEXT()
+        _OP(0x2D,5): assert(false);_NEXT()
+        _OP(0x2D,6): assert(false);_NEXT()
+        _OP(0x2D,7): assert(false);_NEXT()
+    /* ROL abs */
+        _OP(0x2E,0): _SA(c->PC++);_NEXT()
+        _OP(0x2E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2E,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x2E,4): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x2E,5): _FETCH();_NEXT()
+        _OP(0x2E,6): assert(false);_NEXT()
+        _OP(0x2E,7): assert(false);_NEXT()
+    /* RLA abs (undoc) */
+        _OP(0x2F,0): _SA(c->PC++);_NEXT()
+        _OP(0x2F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2F,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2F,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x2F,4): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x2F,5): _FETCH();_NEXT()
+        _OP(0x2F,6): assert(false);_NEXT()
+        _OP(0x2F,7): assert(false);_NEXT()
+    /* BMI # */
+        _OP(0x30,0): _SA(c->PC++);_NEXT()
+        _OP(0x30,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x80)!=0x80){_FETCH();};_NEXT()
+        _OP(0x30,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x30,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x30,4): assert(false);_NEXT()
+        _OP(0x30,5): assert(false);_NEXT()
+        _OP(0x30,6): assert(false);_NEXT()
+        _OP(0x30,7): assert(false);_NEXT()
+    /* AND (zp),Y */
+        _OP(0x31,0): _SA(c->PC++);_NEXT()
+        _OP(0x31,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x31,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x31,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x31,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x31,5): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x31,6): assert(false);_NEXT()
+        _OP(0x31,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x32,0): _SA(c->PC);_NEXT()
+        _OP(0x32,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x32,2): assert(false);_NEXT()
+        _OP(0x32,3): assert(false);_NEXT()
+        _OP(0x32,4): assert(false);_NEXT()
+        _OP(0x32,5): assert(false);_NEXT()
+        _OP(0x32,6): assert(false);_NEXT()
+        _OP(0x32,7): assert(false);_NEXT()
+    /* RLA (zp),Y (undoc) */
+        _OP(0x33,0): _SA(c->PC++);_NEXT()
+        _OP(0x33,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x33,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x33,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x33,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x33,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x33,6): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x33,7): _FETCH();_NEXT()
+    /* NOP zp,X (undoc) */
+        _OP(0x34,0): _SA(c->PC++);_NEXT()
+        _OP(0x34,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x34,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x34,3): _FETCH();_NEXT()
+        _OP(0x34,4): assert(false);_NEXT()
+        _OP(0x34,5): assert(false);_NEXT()
+        _OP(0x34,6): assert(false);_NEXT()
+        _OP(0x34,7): assert(false);_NEXT()
+    /* AND zp,X */
+        _OP(0x35,0): _SA(c->PC++);_NEXT()
+        _OP(0x35,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x35,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x35,3): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x35,4): assert(false);_NEXT()
+        _OP(0x35,5): assert(false);_NEXT()
+        _OP(0x35,6): assert(false);_NEXT()
+        _OP(0x35,7): assert(false);_NEXT()
+    /* ROL zp,X */
+        _OP(0x36,0): _SA(c->PC++);_NEXT()
+        _OP(0x36,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x36,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x36,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x36,4): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x36,5): _FETCH();_NEXT()
+        _OP(0x36,6): assert(false);_NEXT()
+        _OP(0x36,7): assert(false);_NEXT()
+    /* RLA zp,X (undoc) */
+        _OP(0x37,0): _SA(c->PC++);_NEXT()
+        _OP(0x37,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x37,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x37,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x37,4): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x37,5): _FETCH();_NEXT()
+        _OP(0x37,6): assert(false);_NEXT()
+        _OP(0x37,7): assert(false);_NEXT()
+    /* SEC  */
+        _OP(0x38,0): _SA(c->PC);_NEXT()
+        _OP(0x38,1): c->P|=0x1;_FETCH();_NEXT()
+        _OP(0x38,2): assert(false);_NEXT()
+        _OP(0x38,3): assert(false);_NEXT()
+        _OP(0x38,4): assert(false);_NEXT()
+        _OP(0x38,5): assert(false);_NEXT()
+        _OP(0x38,6): assert(false);_NEXT()
+        _OP(0x38,7): assert(false);_NEXT()
+    /* AND abs,Y */
+        _OP(0x39,0): _SA(c->PC++);_NEXT()
+        _OP(0x39,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x39,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x39,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x39,4): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x39,5): assert(false);_NEXT()
+        _OP(0x39,6): assert(false);_NEXT()
+        _OP(0x39,7): assert(false);_NEXT()
+    /* NOP  (undoc) */
+        _OP(0x3A,0): _SA(c->PC);_NEXT()
+        _OP(0x3A,1): _FETCH();_NEXT()
+        _OP(0x3A,2): assert(false);_NEXT()
+        _OP(0x3A,3): assert(false);_NEXT()
+        _OP(0x3A,4): assert(false);_NEXT()
+        _OP(0x3A,5): assert(false);_NEXT()
+        _OP(0x3A,6): assert(false);_NEXT()
+        _OP(0x3A,7): assert(false);_NEXT()
+    /* RLA abs,Y (undoc) */
+        _OP(0x3B,0): _SA(c->PC++);_NEXT()
+        _OP(0x3B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x3B,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x3B,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x3B,5): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x3B,6): _FETCH();_NEXT()
+        _OP(0x3B,7): assert(false);_NEXT()
+    /* NOP abs,X (undoc) */
+        _OP(0x3C,0): _SA(c->PC++);_NEXT()
+        _OP(0x3C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x3C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3C,4): _FETCH();_NEXT()
+        _OP(0x3C,5): assert(false);_NEXT()
+        _OP(0x3C,6): assert(false);_NEXT()
+        _OP(0x3C,7): assert(false);_NEXT()
+    /* AND abs,X */
+        _OP(0x3D,0): _SA(c->PC++);_NEXT()
+        _OP(0x3D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x3D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3D,4): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x3D,5): assert(false);_NEXT()
+        _OP(0x3D,6): assert(false);_NEXT()
+        _OP(0x3D,7): assert(false);_NEXT()
+    /* ROL abs,X */
+        _OP(0x3E,0): _SA(c->PC++);_NEXT()
+        _OP(0x3E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x3E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3E,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x3E,5): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x3E,6): _FETCH();_NEXT()
+        _OP(0x3E,7): assert(false);_NEXT()
+    /* RLA abs,X (undoc) */
+        _OP(0x3F,0): _SA(c->PC++);_NEXT()
+        _OP(0x3F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x3F,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3F,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x3F,5): c->AD=_m6502_rol(c,c->AD);_SD(c->AD);c->A&=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x3F,6): _FETCH();_NEXT()
+        _OP(0x3F,7): assert(false);_NEXT()
+    /* RTI  */
+        _OP(0x40,0): _SA(c->PC);_NEXT()
+        _OP(0x40,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x40,2): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x40,3): _SA(0x0100|c->S++);c->P=(_GD()|M6502_BF)&~M6502_XF;_NEXT()
+        _OP(0x40,4): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x40,5): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x40,6): assert(false);_NEXT()
+        _OP(0x40,7): assert(false);_NEXT()
+    /* EOR (zp,X) */
+        _OP(0x41,0): _SA(c->PC++);_NEXT()
+        _OP(0x41,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x41,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x41,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x41,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x41,5): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x41,6): assert(false);_NEXT()
+        _OP(0x41,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x42,0): _SA(c->PC);_NEXT()
+        _OP(0x42,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x42,2): assert(false);_NEXT()
+        _OP(0x42,3): assert(false);_NEXT()
+        _OP(0x42,4): assert(false);_NEXT()
+        _OP(0x42,5): assert(false);_NEXT()
+        _OP(0x42,6): assert(false);_NEXT()
+        _OP(0x42,7): assert(false);_NEXT()
+    /* SRE (zp,X) (undoc) */
+        _OP(0x43,0): _SA(c->PC++);_NEXT()
+        _OP(0x43,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x43,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x43,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x43,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x43,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x43,6): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x43,7): _FETCH();_NEXT()
+    /* NOP zp (undoc) */
+        _OP(0x44,0): _SA(c->PC++);_NEXT()
+        _OP(0x44,1): _SA(_GD());_NEXT()
+        _OP(0x44,2): _FETCH();_NEXT()
+        _OP(0x44,3): assert(false);_NEXT()
+        _OP(0x44,4): assert(false);_NEXT()
+        _OP(0x44,5): assert(false);_NEXT()
+        _OP(0x44,6): assert(false);_NEXT()
+        _OP(0x44,7): assert(false);_NEXT()
+    /* EOR zp */
+        _OP(0x45,0): _SA(c->PC++);_NEXT()
+        _OP(0x45,1): _SA(_GD());_NEXT()
+        _OP(0x45,2): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x45,3): assert(false);_NEXT()
+        _OP(0x45,4): assert(false);_NEXT()
+        _OP(0x45,5): assert(false);_NEXT()
+        _OP(0x45,6): assert(false);_NEXT()
+        _OP(0x45,7): assert(false);_NEXT()
+    /* LSR zp */
+        _OP(0x46,0): _SA(c->PC++);_NEXT()
+        _OP(0x46,1): _SA(_GD());_NEXT()
+        _OP(0x46,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x46,3): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x46,4): _FETCH();_NEXT()
+        _OP(0x46,5): assert(false);_NEXT()
+        _OP(0x46,6): assert(false);_NEXT()
+        _OP(0x46,7): assert(false);_NEXT()
+    /* SRE zp (undoc) */
+        _OP(0x47,0): _SA(c->PC++);_NEXT()
+        _OP(0x47,1): _SA(_GD());_NEXT()
+        _OP(0x47,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x47,3): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x47,4): _FETCH();_NEXT()
+        _OP(0x47,5): assert(false);_NEXT()
+        _OP(0x47,6): assert(false);_NEXT()
+        _OP(0x47,7): assert(false);_NEXT()
+    /* PHA  */
+        _OP(0x48,0): _SA(c->PC);_NEXT()
+        _OP(0x48,1): _SAD(0x0100|c->S--,c->A);_WR();_NEXT()
+        _OP(0x48,2): _FETCH();_NEXT()
+        _OP(0x48,3): assert(false);_NEXT()
+        _OP(0x48,4): assert(false);_NEXT()
+        _OP(0x48,5): assert(false);_NEXT()
+        _OP(0x48,6): assert(false);_NEXT()
+        _OP(0x48,7): assert(false);_NEXT()
+    /* EOR # */
+        _OP(0x49,0): _SA(c->PC++);_NEXT()
+        _OP(0x49,1): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x49,2): assert(false);_NEXT()
+        _OP(0x49,3): assert(false);_NEXT()
+        _OP(0x49,4): assert(false);_NEXT()
+        _OP(0x49,5): assert(false);_NEXT()
+        _OP(0x49,6): assert(false);_NEXT()
+        _OP(0x49,7): assert(false);_NEXT()
+    /* LSRA  */
+        _OP(0x4A,0): _SA(c->PC);_NEXT()
+        _OP(0x4A,1): c->A=_m6502_lsr(c,c->A);_FETCH();_NEXT()
+        _OP(0x4A,2): assert(false);_NEXT()
+        _OP(0x4A,3): assert(false);_NEXT()
+        _OP(0x4A,4): assert(false);_NEXT()
+        _OP(0x4A,5): assert(false);_NEXT()
+        _OP(0x4A,6): assert(false);_NEXT()
+        _OP(0x4A,7): assert(false);_NEXT()
+    /* ASR # (undoc) */
+        _OP(0x4B,0): _SA(c->PC++);_NEXT()
+        _OP(0x4B,1): c->A&=_GD();c->A=_m6502_lsr(c,c->A);_FETCH();_NEXT()
+        _OP(0x4B,2): assert(false);_NEXT()
+        _OP(0x4B,3): assert(false);_NEXT()
+        _OP(0x4B,4): assert(false);_NEXT()
+        _OP(0x4B,5): assert(false);_NEXT()
+        _OP(0x4B,6): assert(false);_NEXT()
+        _OP(0x4B,7): assert(false);_NEXT()
+    /* JMP  */
+        _OP(0x4C,0): _SA(c->PC++);_NEXT()
+        _OP(0x4C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4C,2): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x4C,3): assert(false);_NEXT()
+        _OP(0x4C,4): assert(false);_NEXT()
+        _OP(0x4C,5): assert(false);_NEXT()
+        _OP(0x4C,6): assert(false);_NEXT()
+        _OP(0x4C,7): assert(false);_NEXT()
+    /* EOR abs */
+        _OP(0x4D,0): _SA(c->PC++);_NEXT()
+        _OP(0x4D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x4D,3): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x4D,4): assert(false);_NEXT()
+        _OP(0x4D,5): assert(false);_NEXT()
+        _OP(0x4D,6): assert(false);_NEXT()
+        _OP(0x4D,7): assert(false);_NEXT()
+    /* LSR abs */
+        _OP(0x4E,0): _SA(c->PC++);_NEXT()
+        _OP(0x4E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x4E,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x4E,4): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x4E,5): _FETCH();_NEXT()
+        _OP(0x4E,6): assert(false);_NEXT()
+        _OP(0x4E,7): assert(false);_NEXT()
+    /* SRE abs (undoc) */
+        _OP(0x4F,0): _SA(c->PC++);_NEXT()
+        _OP(0x4F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4F,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x4F,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x4F,4): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x4F,5): _FETCH();_NEXT()
+        _OP(0x4F,6): assert(false);_NEXT()
+        _OP(0x4F,7): assert(false);_NEXT()
+    /* BVC # */
+        _OP(0x50,0): _SA(c->PC++);_NEXT()
+        _OP(0x50,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x40)!=0x0){_FETCH();};_NEXT()
+        _OP(0x50,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x50,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x50,4): assert(false);_NEXT()
+        _OP(0x50,5): assert(false);_NEXT()
+        _OP(0x50,6): assert(false);_NEXT()
+        _OP(0x50,7): assert(false);_NEXT()
+    /* EOR (zp),Y */
+        _OP(0x51,0): _SA(c->PC++);_NEXT()
+        _OP(0x51,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x51,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x51,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x51,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x51,5): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x51,6): assert(false);_NEXT()
+        _OP(0x51,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x52,0): _SA(c->PC);_NEXT()
+        _OP(0x52,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x52,2): assert(false);_NEXT()
+        _OP(0x52,3): assert(false);_NEXT()
+        _OP(0x52,4): assert(false);_NEXT()
+        _OP(0x52,5): assert(false);_NEXT()
+        _OP(0x52,6): assert(false);_NEXT()
+        _OP(0x52,7): assert(false);_NEXT()
+    /* SRE (zp),Y (undoc) */
+        _OP(0x53,0): _SA(c->PC++);_NEXT()
+        _OP(0x53,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x53,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x53,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x53,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x53,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x53,6): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x53,7): _FETCH();_NEXT()
+    /* NOP zp,X (undoc) */
+        _OP(0x54,0): _SA(c->PC++);_NEXT()
+        _OP(0x54,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x54,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x54,3): _FETCH();_NEXT()
+        _OP(0x54,4): assert(false);_NEXT()
+        _OP(0x54,5): assert(false);_NEXT()
+        _OP(0x54,6): assert(false);_NEXT()
+        _OP(0x54,7): assert(false);_NEXT()
+    /* EOR zp,X */
+        _OP(0x55,0): _SA(c->PC++);_NEXT()
+        _OP(0x55,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x55,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x55,3): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x55,4): assert(false);_NEXT()
+        _OP(0x55,5): assert(false);_NEXT()
+        _OP(0x55,6): assert(false);_NEXT()
+        _OP(0x55,7): assert(false);_NEXT()
+    /* LSR zp,X */
+        _OP(0x56,0): _SA(c->PC++);_NEXT()
+        _OP(0x56,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x56,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x56,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x56,4): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x56,5): _FETCH();_NEXT()
+        _OP(0x56,6): assert(false);_NEXT()
+        _OP(0x56,7): assert(false);_NEXT()
+    /* SRE zp,X (undoc) */
+        _OP(0x57,0): _SA(c->PC++);_NEXT()
+        _OP(0x57,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x57,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x57,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x57,4): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x57,5): _FETCH();_NEXT()
+        _OP(0x57,6): assert(false);_NEXT()
+        _OP(0x57,7): assert(false);_NEXT()
+    /* CLI  */
+        _OP(0x58,0): _SA(c->PC);_NEXT()
+        _OP(0x58,1): c->P&=~0x4;_FETCH();_NEXT()
+        _OP(0x58,2): assert(false);_NEXT()
+        _OP(0x58,3): assert(false);_NEXT()
+        _OP(0x58,4): assert(false);_NEXT()
+        _OP(0x58,5): assert(false);_NEXT()
+        _OP(0x58,6): assert(false);_NEXT()
+        _OP(0x58,7): assert(false);_NEXT()
+    /* EOR abs,Y */
+        _OP(0x59,0): _SA(c->PC++);_NEXT()
+        _OP(0x59,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x59,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x59,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x59,4): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x59,5): assert(false);_NEXT()
+        _OP(0x59,6): assert(false);_NEXT()
+        _OP(0x59,7): assert(false);_NEXT()
+    /* NOP  (undoc) */
+        _OP(0x5A,0): _SA(c->PC);_NEXT()
+        _OP(0x5A,1): _FETCH();_NEXT()
+        _OP(0x5A,2): assert(false);_NEXT()
+        _OP(0x5A,3): assert(false);_NEXT()
+        _OP(0x5A,4): assert(false);_NEXT()
+        _OP(0x5A,5): assert(false);_NEXT()
+        _OP(0x5A,6): assert(false);_NEXT()
+        _OP(0x5A,7): assert(false);_NEXT()
+    /* SRE abs,Y (undoc) */
+        _OP(0x5B,0): _SA(c->PC++);_NEXT()
+        _OP(0x5B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x5B,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x5B,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x5B,5): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x5B,6): _FETCH();_NEXT()
+        _OP(0x5B,7): assert(false);_NEXT()
+    /* NOP abs,X (undoc) */
+        _OP(0x5C,0): _SA(c->PC++);_NEXT()
+        _OP(0x5C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x5C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5C,4): _FETCH();_NEXT()
+        _OP(0x5C,5): assert(false);_NEXT()
+        _OP(0x5C,6): assert(false);_NEXT()
+        _OP(0x5C,7): assert(false);_NEXT()
+    /* EOR abs,X */
+        _OP(0x5D,0): _SA(c->PC++);_NEXT()
+        _OP(0x5D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x5D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5D,4): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x5D,5): assert(false);_NEXT()
+        _OP(0x5D,6): assert(false);_NEXT()
+        _OP(0x5D,7): assert(false);_NEXT()
+    /* LSR abs,X */
+        _OP(0x5E,0): _SA(c->PC++);_NEXT()
+        _OP(0x5E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x5E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5E,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x5E,5): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x5E,6): _FETCH();_NEXT()
+        _OP(0x5E,7): assert(false);_NEXT()
+    /* SRE abs,X (undoc) */
+        _OP(0x5F,0): _SA(c->PC++);_NEXT()
+        _OP(0x5F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x5F,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5F,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x5F,5): c->AD=_m6502_lsr(c,c->AD);_SD(c->AD);c->A^=c->AD;_NZ(c->A);_WR();_NEXT()
+        _OP(0x5F,6): _FETCH();_NEXT()
+        _OP(0x5F,7): assert(false);_NEXT()
+    /* RTS  */
+        _OP(0x60,0): _SA(c->PC);_NEXT()
+        _OP(0x60,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x60,2): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x60,3): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x60,4): c->PC=(_GD()<<8)|c->AD;_SA(c->PC++);_NEXT()
+        _OP(0x60,5): _FETCH();_NEXT()
+        _OP(0x60,6): assert(false);_NEXT()
+        _OP(0x60,7): assert(false);_NEXT()
+    /* ADC (zp,X) */
+        _OP(0x61,0): _SA(c->PC++);_NEXT()
+        _OP(0x61,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x61,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x61,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x61,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x61,5): _m6502_adc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0x61,6): assert(false);_NEXT()
+        _OP(0x61,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x62,0): _SA(c->PC);_NEXT()
+        _OP(0x62,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x62,2): assert(false);_NEXT()
+        _OP(0x62,3): assert(false);_NEXT()
+        _OP(0x62,4): assert(false);_NEXT()
+        _OP(0x62,5): assert(false);_NEXT()
+        _OP(0x62,6): assert(false);_NEXT()
+        _OP(0x62,7): assert(false);_NEXT()
+    /* RRA (zp,X) (undoc) */
+        _OP(0x63,0): _SA(c->PC++);_NEXT()
+        _OP(0x63,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x63,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x63,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x63,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x63,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x63,6): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0x63,7): _FETCH();_NEXT()
+    /* NOP zp (undoc) */
+        _OP(0x64,0): _SA(c->PC++);_NEXT()
+        _OP(0x64,1): _SA(_GD());_NEXT()
+        _OP(0x64,2): _FETCH();_NEXT()
+        _OP(0x64,3): assert(false);_NEXT()
+        _OP(0x64,4): assert(false);_NEXT()
+        _OP(0x64,5): assert(false);_NEXT()
+        _OP(0x64,6): assert(false);_NEXT()
+        _OP(0x64,7): assert(false);_NEXT()
+    /* ADC zp */
+        _OP(0x65,0): _SA(c->PC++);_NEXT()
+        _OP(0x65,1): _SA(_GD());_NEXT()
+        _OP(0x65,2): _m6502_adc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0x65,3): assert(false);_NEXT()
+        _OP(0x65,4): assert(false);_NEXT()
+        _OP(0x65,5): assert(false);_NEXT()
+        _OP(0x65,6): assert(false);_NEXT()
+        _OP(0x65,7): assert(false);_NEXT()
+    /* ROR zp */
+        _OP(0x66,0): _SA(c->PC++);_NEXT()
+        _OP(0x66,1): _SA(_GD());_NEXT()
+        _OP(0x66,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x66,3): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x66,4): _FETCH();_NEXT()
+        _OP(0x66,5): assert(false);_NEXT()
+        _OP(0x66,6): assert(false);_NEXT()
+        _OP(0x66,7): assert(false);_NEXT()
+    /* RRA zp (undoc) */
+        _OP(0x67,0): _SA(c->PC++);_NEXT()
+        _OP(0x67,1): _SA(_GD());_NEXT()
+        _OP(0x67,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0x67,3): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0x67,4): _FETCH();_NEXT()
+        _OP(0x67,5): assert(false);_NEXT()
+        _OP(0x67,6): assert(false);_NEXT()
+        _OP(0x67,7): assert(false);_NEXT()
+    /* PLA  */
+        _OP(0x68,0): _SA(c->PC);_NEXT()
+        _OP(0x68,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x68,2): _SA(0x0100|c->S);_NEXT()
+        _OP(0x68,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x68,4): assert(false);_NEXT()
+        _OP(0x68,5): assert(false);_NEXT()
+        _OP(0x68,6): assert(false);_NEXT()
+        _OP(0x68,7): assert(false);_NEXT()
+    /* ADC # */
+        _OP(0x69,0): _SA(c->PC++);_NEXT()
+        _OP(0x69,1): _m6502_adc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0x69,2): assert(false);_NEXT()
+        _OP(0x69,3): assert(false);_NEXT()
+        _OP(0x69,4): assert(false);_NEXT()
+        _OP(0x69,5): assert(false);_NEXT()
+        _OP(0x69,6): assert(false);_NEXT()
+        _OP(0x69,7): assert(false);_NEXT()
+    /* RORA  */
+        _OP(0x6A,0): _SA(c->PC);_NEXT()
+        _OP(0x6A,1): c->A=_m6502_ror(c,c->A);_FETCH();_NEXT()
+        _OP(0x6A,2): assert(false);_NEXT()
+        _OP(0x6A,3): assert(false);_NEXT()
+        _OP(0x6A,4): assert(false);_NEXT()
+        _OP(0x6A,5): assert(false);_NEXT()
+        _OP(0x6A,6): assert(false);_NEXT()
+        _OP(0x6A,7): assert(false);_NEXT()
+    /* ARR # (undoc) */
+        _OP(0x6B,0): _SA(c->PC++);_NEXT()
+        _OP(0x6B,1): c->A&=_GD();_m6502_arr_bin(c);_FETCH();_NEXT()
+        _OP(0x6B,2): assert(false);_NEXT()
+        _OP(0x6B,3): assert(false);_NEXT()
+        _OP(0x6B,4): assert(false);_NEXT()
+        _OP(0x6B,5): assert(false);_NEXT()
+        _OP(0x6B,6): assert(false);_NEXT()
+        _OP(0x6B,7): assert(false);_NEXT()
+    /* JMPI  */
+        _OP(0x6C,0): _SA(c->PC++);_NEXT()
+        _OP(0x6C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6C,2): c->AD|=_GD()<<8;_SA(c->AD);_NEXT()
+        _OP(0x6C,3): _SA((c->AD&0xFF00)|((c->AD+1)&0x00FF));c->AD=_GD();_NEXT()
+        _OP(0x6C,4): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x6C,5): assert(false);_NEXT()
+        _OP(0x6C,6): assert(false);_NEXT()
+        _OP(0x6C,7): assert(false);_NEXT()
+    /* ADC abs */
+        _OP(0x6D,0): _SA(c->PC++);_NEXT()
+        _OP(0x6D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x6D,3): _m6502_adc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0x6D,4): assert(false);_NEXT()
+        _OP(0x6D,5): assert(false);_NEXT()
+        _OP(0x6D,6): assert(false);_NEXT()
+        _OP(0x6D,7): assert(false);_NEXT()
+    /* ROR abs */
+        _OP(0x6E,0): _SA(c->PC++);_NEXT()
+        _OP(0x6E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x6E,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x6E,4): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x6E,5): _FETCH();_NEXT()
+        _OP(0x6E,6): assert(false);_NEXT()
+        _OP(0x6E,7): assert(false);_NEXT()
+    /* RRA abs (undoc) */
+        _OP(0x6F,0): _SA(c->PC++);_NEXT()
+        _OP(0x6F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6F,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x6F,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x6F,4): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0x6F,5): _FETCH();_NEXT()
+        _OP(0x6F,6): assert(false);_NEXT()
+        _OP(0x6F,7): assert(false);_NEXT()
+    /* BVS # */
+        _OP(0x70,0): _SA(c->PC++);_NEXT()
+        _OP(0x70,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x40)!=0x40){_FETCH();};_NEXT()
+        _OP(0x70,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x70,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x70,4): assert(false);_NEXT()
+        _OP(0x70,5): assert(false);_NEXT()
+        _OP(0x70,6): assert(false);_NEXT()
+        _OP(0x70,7): assert(false);_NEXT()
+    /* ADC (zp),Y */
+        _OP(0x71,0): _SA(c->PC++);_NEXT()
+        _OP(0x71,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x71,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x71,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x71,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x71,5): _m6502_adc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0x71,6): assert(false);_NEXT()
+        _OP(0x71,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x72,0): _SA(c->PC);_NEXT()
+        _OP(0x72,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x72,2): assert(false);_NEXT()
+        _OP(0x72,3): assert(false);_NEXT()
+        _OP(0x72,4): assert(false);_NEXT()
+        _OP(0x72,5): assert(false);_NEXT()
+        _OP(0x72,6): assert(false);_NEXT()
+        _OP(0x72,7): assert(false);_NEXT()
+    /* RRA (zp),Y (undoc) */
+        _OP(0x73,0): _SA(c->PC++);_NEXT()
+        _OP(0x73,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x73,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x73,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x73,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x73,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0x73,6): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0x73,7): _FETCH();_NEXT()
+    /* NOP zp,X (undoc) */
+        _OP(0x74,0): _SA(c->PC++);_NEXT()
+        _OP(0x74,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x74,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x74,3): _FETCH();_NEXT()
+        _OP(0x74,4): assert(false);_NEXT()
+        _OP(0x74,5): assert(false);_NEXT()
+        _OP(0x74,6): assert(false);_NEXT()
+        _OP(0x74,7): assert(false);_NEXT()
+    /* ADC zp,X */
+        _OP(0x75,0): _SA(c->PC++);_NEXT()
+        _OP(0x75,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x75,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x75,3): _m6502_adc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0x75,4): assert(false);_NEXT()
+        _OP(0x75,5): assert(false);_NEXT()
+        _OP(0x75,6): assert(false);_NEXT()
+        _OP(0x75,7): assert(false);_NEXT()
+    /* ROR zp,X */
+        _OP(0x76,0): _SA(c->PC++);_NEXT()
+        _OP(0x76,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x76,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x76,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x76,4): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x76,5): _FETCH();_NEXT()
+        _OP(0x76,6): assert(false);_NEXT()
+        _OP(0x76,7): assert(false);_NEXT()
+    /* RRA zp,X (undoc) */
+        _OP(0x77,0): _SA(c->PC++);_NEXT()
+        _OP(0x77,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x77,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x77,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0x77,4): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0x77,5): _FETCH();_NEXT()
+        _OP(0x77,6): assert(false);_NEXT()
+        _OP(0x77,7): assert(false);_NEXT()
+    /* SEI  */
+        _OP(0x78,0): _SA(c->PC);_NEXT()
+        _OP(0x78,1): c->P|=0x4;_FETCH();_NEXT()
+        _OP(0x78,2): assert(false);_NEXT()
+        _OP(0x78,3): assert(false);_NEXT()
+        _OP(0x78,4): assert(false);_NEXT()
+        _OP(0x78,5): assert(false);_NEXT()
+        _OP(0x78,6): assert(false);_NEXT()
+        _OP(0x78,7): assert(false);_NEXT()
+    /* ADC abs,Y */
+        _OP(0x79,0): _SA(c->PC++);_NEXT()
+        _OP(0x79,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x79,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x79,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x79,4): _m6502_adc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0x79,5): assert(false);_NEXT()
+        _OP(0x79,6): assert(false);_NEXT()
+        _OP(0x79,7): assert(false);_NEXT()
+    /* NOP  (undoc) */
+        _OP(0x7A,0): _SA(c->PC);_NEXT()
+        _OP(0x7A,1): _FETCH();_NEXT()
+        _OP(0x7A,2): assert(false);_NEXT()
+        _OP(0x7A,3): assert(false);_NEXT()
+        _OP(0x7A,4): assert(false);_NEXT()
+        _OP(0x7A,5): assert(false);_NEXT()
+        _OP(0x7A,6): assert(false);_NEXT()
+        _OP(0x7A,7): assert(false);_NEXT()
+    /* RRA abs,Y (undoc) */
+        _OP(0x7B,0): _SA(c->PC++);_NEXT()
+        _OP(0x7B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x7B,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x7B,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x7B,5): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0x7B,6): _FETCH();_NEXT()
+        _OP(0x7B,7): assert(false);_NEXT()
+    /* NOP abs,X (undoc) */
+        _OP(0x7C,0): _SA(c->PC++);_NEXT()
+        _OP(0x7C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x7C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7C,4): _FETCH();_NEXT()
+        _OP(0x7C,5): assert(false);_NEXT()
+        _OP(0x7C,6): assert(false);_NEXT()
+        _OP(0x7C,7): assert(false);_NEXT()
+    /* ADC abs,X */
+        _OP(0x7D,0): _SA(c->PC++);_NEXT()
+        _OP(0x7D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x7D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7D,4): _m6502_adc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0x7D,5): assert(false);_NEXT()
+        _OP(0x7D,6): assert(false);_NEXT()
+        _OP(0x7D,7): assert(false);_NEXT()
+    /* ROR abs,X */
+        _OP(0x7E,0): _SA(c->PC++);_NEXT()
+        _OP(0x7E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x7E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7E,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x7E,5): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x7E,6): _FETCH();_NEXT()
+        _OP(0x7E,7): assert(false);_NEXT()
+    /* RRA abs,X (undoc) */
+        _OP(0x7F,0): _SA(c->PC++);_NEXT()
+        _OP(0x7F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x7F,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7F,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0x7F,5): c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0x7F,6): _FETCH();_NEXT()
+        _OP(0x7F,7): assert(false);_NEXT()
+    /* NOP # (undoc) */
+        _OP(0x80,0): _SA(c->PC++);_NEXT()
+        _OP(0x80,1): _FETCH();_NEXT()
+        _OP(0x80,2): assert(false);_NEXT()
+        _OP(0x80,3): assert(false);_NEXT()
+        _OP(0x80,4): assert(false);_NEXT()
+        _OP(0x80,5): assert(false);_NEXT()
+        _OP(0x80,6): assert(false);_NEXT()
+        _OP(0x80,7): assert(false);_NEXT()
+    /* STA (zp,X) */
+        _OP(0x81,0): _SA(c->PC++);_NEXT()
+        _OP(0x81,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x81,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x81,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x81,4): _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();_NEXT()
+        _OP(0x81,5): _FETCH();_NEXT()
+        _OP(0x81,6): assert(false);_NEXT()
+        _OP(0x81,7): assert(false);_NEXT()
+    /* NOP # (undoc) */
+        _OP(0x82,0): _SA(c->PC++);_NEXT()
+        _OP(0x82,1): _FETCH();_NEXT()
+        _OP(0x82,2): assert(false);_NEXT()
+        _OP(0x82,3): assert(false);_NEXT()
+        _OP(0x82,4): assert(false);_NEXT()
+        _OP(0x82,5): assert(false);_NEXT()
+        _OP(0x82,6): assert(false);_NEXT()
+        _OP(0x82,7): assert(false);_NEXT()
+    /* SAX (zp,X) (undoc) */
+        _OP(0x83,0): _SA(c->PC++);_NEXT()
+        _OP(0x83,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x83,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x83,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x83,4): _SA((_GD()<<8)|c->AD);_SD(c->A&c->X);_WR();_NEXT()
+        _OP(0x83,5): _FETCH();_NEXT()
+        _OP(0x83,6): assert(false);_NEXT()
+        _OP(0x83,7): assert(false);_NEXT()
+    /* STY zp */
+        _OP(0x84,0): _SA(c->PC++);_NEXT()
+        _OP(0x84,1): _SA(_GD());_SD(c->Y);_WR();_NEXT()
+        _OP(0x84,2): _FETCH();_NEXT()
+        _OP(0x84,3): assert(false);_NEXT()
+        _OP(0x84,4): assert(false);_NEXT()
+        _OP(0x84,5): assert(false);_NEXT()
+        _OP(0x84,6): assert(false);_NEXT()
+        _OP(0x84,7): assert(false);_NEXT()
+    /* STA zp */
+        _OP(0x85,0): _SA(c->PC++);_NEXT()
+        _OP(0x85,1): _SA(_GD());_SD(c->A);_WR();_NEXT()
+        _OP(0x85,2): _FETCH();_NEXT()
+        _OP(0x85,3): assert(false);_NEXT()
+        _OP(0x85,4): assert(false);_NEXT()
+        _OP(0x85,5): assert(false);_NEXT()
+        _OP(0x85,6): assert(false);_NEXT()
+        _OP(0x85,7): assert(false);_NEXT()
+    /* STX zp */
+        _OP(0x86,0): _SA(c->PC++);_NEXT()
+        _OP(0x86,1): _SA(_GD());_SD(c->X);_WR();_NEXT()
+        _OP(0x86,2): _FETCH();_NEXT()
+        _OP(0x86,3): assert(false);_NEXT()
+        _OP(0x86,4): assert(false);_NEXT()
+        _OP(0x86,5): assert(false);_NEXT()
+        _OP(0x86,6): assert(false);_NEXT()
+        _OP(0x86,7): assert(false);_NEXT()
+    /* SAX zp (undoc) */
+        _OP(0x87,0): _SA(c->PC++);_NEXT()
+        _OP(0x87,1): _SA(_GD());_SD(c->A&c->X);_WR();_NEXT()
+        _OP(0x87,2): _FETCH();_NEXT()
+        _OP(0x87,3): assert(false);_NEXT()
+        _OP(0x87,4): assert(false);_NEXT()
+        _OP(0x87,5): assert(false);_NEXT()
+        _OP(0x87,6): assert(false);_NEXT()
+        _OP(0x87,7): assert(false);_NEXT()
+    /* DEY  */
+        _OP(0x88,0): _SA(c->PC);_NEXT()
+        _OP(0x88,1): c->Y--;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0x88,2): assert(false);_NEXT()
+        _OP(0x88,3): assert(false);_NEXT()
+        _OP(0x88,4): assert(false);_NEXT()
+        _OP(0x88,5): assert(false);_NEXT()
+        _OP(0x88,6): assert(false);_NEXT()
+        _OP(0x88,7): assert(false);_NEXT()
+    /* NOP # (undoc) */
+        _OP(0x89,0): _SA(c->PC++);_NEXT()
+        _OP(0x89,1): _FETCH();_NEXT()
+        _OP(0x89,2): assert(false);_NEXT()
+        _OP(0x89,3): assert(false);_NEXT()
+        _OP(0x89,4): assert(false);_NEXT()
+        _OP(0x89,5): assert(false);_NEXT()
+        _OP(0x89,6): assert(false);_NEXT()
+        _OP(0x89,7): assert(false);_NEXT()
+    /* TXA  */
+        _OP(0x8A,0): _SA(c->PC);_NEXT()
+        _OP(0x8A,1): c->A=c->X;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x8A,2): assert(false);_NEXT()
+        _OP(0x8A,3): assert(false);_NEXT()
+        _OP(0x8A,4): assert(false);_NEXT()
+        _OP(0x8A,5): assert(false);_NEXT()
+        _OP(0x8A,6): assert(false);_NEXT()
+        _OP(0x8A,7): assert(false);_NEXT()
+    /* ANE # (undoc) */
+        _OP(0x8B,0): _SA(c->PC++);_NEXT()
+        _OP(0x8B,1): c->A=(c->A|0xEE)&c->X&_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x8B,2): assert(false);_NEXT()
+        _OP(0x8B,3): assert(false);_NEXT()
+        _OP(0x8B,4): assert(false);_NEXT()
+        _OP(0x8B,5): assert(false);_NEXT()
+        _OP(0x8B,6): assert(false);_NEXT()
+        _OP(0x8B,7): assert(false);_NEXT()
+    /* STY abs */
+        _OP(0x8C,0): _SA(c->PC++);_NEXT()
+        _OP(0x8C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8C,2): _SA((_GD()<<8)|c->AD);_SD(c->Y);_WR();_NEXT()
+        _OP(0x8C,3): _FETCH();_NEXT()
+        _OP(0x8C,4): assert(false);_NEXT()
+        _OP(0x8C,5): assert(false);_NEXT()
+        _OP(0x8C,6): assert(false);_NEXT()
+        _OP(0x8C,7): assert(false);_NEXT()
+    /* STA abs */
+        _OP(0x8D,0): _SA(c->PC++);_NEXT()
+        _OP(0x8D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8D,2): _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();_NEXT()
+        _OP(0x8D,3): _FETCH();_NEXT()
+        _OP(0x8D,4): assert(false);_NEXT()
+        _OP(0x8D,5): assert(false);_NEXT()
+        _OP(0x8D,6): assert(false);_NEXT()
+        _OP(0x8D,7): assert(false);_NEXT()
+    /* STX abs */
+        _OP(0x8E,0): _SA(c->PC++);_NEXT()
+        _OP(0x8E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8E,2): _SA((_GD()<<8)|c->AD);_SD(c->X);_WR();_NEXT()
+        _OP(0x8E,3): _FETCH();_NEXT()
+        _OP(0x8E,4): assert(false);_NEXT()
+        _OP(0x8E,5): assert(false);_NEXT()
+        _OP(0x8E,6): assert(false);_NEXT()
+        _OP(0x8E,7): assert(false);_NEXT()
+    /* SAX abs (undoc) */
+        _OP(0x8F,0): _SA(c->PC++);_NEXT()
+        _OP(0x8F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8F,2): _SA((_GD()<<8)|c->AD);_SD(c->A&c->X);_WR();_NEXT()
+        _OP(0x8F,3): _FETCH();_NEXT()
+        _OP(0x8F,4): assert(false);_NEXT()
+        _OP(0x8F,5): assert(false);_NEXT()
+        _OP(0x8F,6): assert(false);_NEXT()
+        _OP(0x8F,7): assert(false);_NEXT()
+    /* BCC # */
+        _OP(0x90,0): _SA(c->PC++);_NEXT()
+        _OP(0x90,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x1)!=0x0){_FETCH();};_NEXT()
+        _OP(0x90,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x90,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x90,4): assert(false);_NEXT()
+        _OP(0x90,5): assert(false);_NEXT()
+        _OP(0x90,6): assert(false);_NEXT()
+        _OP(0x90,7): assert(false);_NEXT()
+    /* STA (zp),Y */
+        _OP(0x91,0): _SA(c->PC++);_NEXT()
+        _OP(0x91,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x91,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x91,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x91,4): _SA(c->AD+c->Y);_SD(c->A);_WR();_NEXT()
+        _OP(0x91,5): _FETCH();_NEXT()
+        _OP(0x91,6): assert(false);_NEXT()
+        _OP(0x91,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0x92,0): _SA(c->PC);_NEXT()
+        _OP(0x92,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0x92,2): assert(false);_NEXT()
+        _OP(0x92,3): assert(false);_NEXT()
+        _OP(0x92,4): assert(false);_NEXT()
+        _OP(0x92,5): assert(false);_NEXT()
+        _OP(0x92,6): assert(false);_NEXT()
+        _OP(0x92,7): assert(false);_NEXT()
+    /* SHA (zp),Y (undoc) */
+        _OP(0x93,0): _SA(c->PC++);_NEXT()
+        _OP(0x93,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x93,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x93,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x93,4): _SA(c->AD+c->Y);_SD(c->A&c->X&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x93,5): _FETCH();_NEXT()
+        _OP(0x93,6): assert(false);_NEXT()
+        _OP(0x93,7): assert(false);_NEXT()
+    /* STY zp,X */
+        _OP(0x94,0): _SA(c->PC++);_NEXT()
+        _OP(0x94,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x94,2): _SA((c->AD+c->X)&0x00FF);_SD(c->Y);_WR();_NEXT()
+        _OP(0x94,3): _FETCH();_NEXT()
+        _OP(0x94,4): assert(false);_NEXT()
+        _OP(0x94,5): assert(false);_NEXT()
+        _OP(0x94,6): assert(false);_NEXT()
+        _OP(0x94,7): assert(false);_NEXT()
+    /* STA zp,X */
+        _OP(0x95,0): _SA(c->PC++);_NEXT()
+        _OP(0x95,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x95,2): _SA((c->AD+c->X)&0x00FF);_SD(c->A);_WR();_NEXT()
+        _OP(0x95,3): _FETCH();_NEXT()
+        _OP(0x95,4): assert(false);_NEXT()
+        _OP(0x95,5): assert(false);_NEXT()
+        _OP(0x95,6): assert(false);_NEXT()
+        _OP(0x95,7): assert(false);_NEXT()
+    /* STX zp,Y */
+        _OP(0x96,0): _SA(c->PC++);_NEXT()
+        _OP(0x96,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x96,2): _SA((c->AD+c->Y)&0x00FF);_SD(c->X);_WR();_NEXT()
+        _OP(0x96,3): _FETCH();_NEXT()
+        _OP(0x96,4): assert(false);_NEXT()
+        _OP(0x96,5): assert(false);_NEXT()
+        _OP(0x96,6): assert(false);_NEXT()
+        _OP(0x96,7): assert(false);_NEXT()
+    /* SAX zp,Y (undoc) */
+        _OP(0x97,0): _SA(c->PC++);_NEXT()
+        _OP(0x97,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x97,2): _SA((c->AD+c->Y)&0x00FF);_SD(c->A&c->X);_WR();_NEXT()
+        _OP(0x97,3): _FETCH();_NEXT()
+        _OP(0x97,4): assert(false);_NEXT()
+        _OP(0x97,5): assert(false);_NEXT()
+        _OP(0x97,6): assert(false);_NEXT()
+        _OP(0x97,7): assert(false);_NEXT()
+    /* TYA  */
+        _OP(0x98,0): _SA(c->PC);_NEXT()
+        _OP(0x98,1): c->A=c->Y;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x98,2): assert(false);_NEXT()
+        _OP(0x98,3): assert(false);_NEXT()
+        _OP(0x98,4): assert(false);_NEXT()
+        _OP(0x98,5): assert(false);_NEXT()
+        _OP(0x98,6): assert(false);_NEXT()
+        _OP(0x98,7): assert(false);_NEXT()
+    /* STA abs,Y */
+        _OP(0x99,0): _SA(c->PC++);_NEXT()
+        _OP(0x99,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x99,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x99,3): _SA(c->AD+c->Y);_SD(c->A);_WR();_NEXT()
+        _OP(0x99,4): _FETCH();_NEXT()
+        _OP(0x99,5): assert(false);_NEXT()
+        _OP(0x99,6): assert(false);_NEXT()
+        _OP(0x99,7): assert(false);_NEXT()
+    /* TXS  */
+        _OP(0x9A,0): _SA(c->PC);_NEXT()
+        _OP(0x9A,1): c->S=c->X;_FETCH();_NEXT()
+        _OP(0x9A,2): assert(false);_NEXT()
+        _OP(0x9A,3): assert(false);_NEXT()
+        _OP(0x9A,4): assert(false);_NEXT()
+        _OP(0x9A,5): assert(false);_NEXT()
+        _OP(0x9A,6): assert(false);_NEXT()
+        _OP(0x9A,7): assert(false);_NEXT()
+    /* SHS abs,Y (undoc) */
+        _OP(0x9B,0): _SA(c->PC++);_NEXT()
+        _OP(0x9B,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9B,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x9B,3): _SA(c->AD+c->Y);c->S=c->A&c->X;_SD(c->S&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x9B,4): _FETCH();_NEXT()
+        _OP(0x9B,5): assert(false);_NEXT()
+        _OP(0x9B,6): assert(false);_NEXT()
+        _OP(0x9B,7): assert(false);_NEXT()
+    /* SHY abs,X (undoc) */
+        _OP(0x9C,0): _SA(c->PC++);_NEXT()
+        _OP(0x9C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x9C,3): _SA(c->AD+c->X);_SD(c->Y&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x9C,4): _FETCH();_NEXT()
+        _OP(0x9C,5): assert(false);_NEXT()
+        _OP(0x9C,6): assert(false);_NEXT()
+        _OP(0x9C,7): assert(false);_NEXT()
+    /* STA abs,X */
+        _OP(0x9D,0): _SA(c->PC++);_NEXT()
+        _OP(0x9D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x9D,3): _SA(c->AD+c->X);_SD(c->A);_WR();_NEXT()
+        _OP(0x9D,4): _FETCH();_NEXT()
+        _OP(0x9D,5): assert(false);_NEXT()
+        _OP(0x9D,6): assert(false);_NEXT()
+        _OP(0x9D,7): assert(false);_NEXT()
+    /* SHX abs,Y (undoc) */
+        _OP(0x9E,0): _SA(c->PC++);_NEXT()
+        _OP(0x9E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x9E,3): _SA(c->AD+c->Y);_SD(c->X&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x9E,4): _FETCH();_NEXT()
+        _OP(0x9E,5): assert(false);_NEXT()
+        _OP(0x9E,6): assert(false);_NEXT()
+        _OP(0x9E,7): assert(false);_NEXT()
+    /* SHA abs,Y (undoc) */
+        _OP(0x9F,0): _SA(c->PC++);_NEXT()
+        _OP(0x9F,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9F,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x9F,3): _SA(c->AD+c->Y);_SD(c->A&c->X&(uint8_t)((_GA()>>8)+1));_WR();_NEXT()
+        _OP(0x9F,4): _FETCH();_NEXT()
+        _OP(0x9F,5): assert(false);_NEXT()
+        _OP(0x9F,6): assert(false);_NEXT()
+        _OP(0x9F,7): assert(false);_NEXT()
+    /* LDY # */
+        _OP(0xA0,0): _SA(c->PC++);_NEXT()
+        _OP(0xA0,1): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA0,2): assert(false);_NEXT()
+        _OP(0xA0,3): assert(false);_NEXT()
+        _OP(0xA0,4): assert(false);_NEXT()
+        _OP(0xA0,5): assert(false);_NEXT()
+        _OP(0xA0,6): assert(false);_NEXT()
+        _OP(0xA0,7): assert(false);_NEXT()
+    /* LDA (zp,X) */
+        _OP(0xA1,0): _SA(c->PC++);_NEXT()
+        _OP(0xA1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xA1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xA1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xA1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xA1,5): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA1,6): assert(false);_NEXT()
+        _OP(0xA1,7): assert(false);_NEXT()
+    /* LDX # */
+        _OP(0xA2,0): _SA(c->PC++);_NEXT()
+        _OP(0xA2,1): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xA2,2): assert(false);_NEXT()
+        _OP(0xA2,3): assert(false);_NEXT()
+        _OP(0xA2,4): assert(false);_NEXT()
+        _OP(0xA2,5): assert(false);_NEXT()
+        _OP(0xA2,6): assert(false);_NEXT()
+        _OP(0xA2,7): assert(false);_NEXT()
+    /* LAX (zp,X) (undoc) */
+        _OP(0xA3,0): _SA(c->PC++);_NEXT()
+        _OP(0xA3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xA3,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xA3,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xA3,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xA3,5): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA3,6): assert(false);_NEXT()
+        _OP(0xA3,7): assert(false);_NEXT()
+    /* LDY zp */
+        _OP(0xA4,0): _SA(c->PC++);_NEXT()
+        _OP(0xA4,1): _SA(_GD());_NEXT()
+        _OP(0xA4,2): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA4,3): assert(false);_NEXT()
+        _OP(0xA4,4): assert(false);_NEXT()
+        _OP(0xA4,5): assert(false);_NEXT()
+        _OP(0xA4,6): assert(false);_NEXT()
+        _OP(0xA4,7): assert(false);_NEXT()
+    /* LDA zp */
+        _OP(0xA5,0): _SA(c->PC++);_NEXT()
+        _OP(0xA5,1): _SA(_GD());_NEXT()
+        _OP(0xA5,2): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA5,3): assert(false);_NEXT()
+        _OP(0xA5,4): assert(false);_NEXT()
+        _OP(0xA5,5): assert(false);_NEXT()
+        _OP(0xA5,6): assert(false);_NEXT()
+        _OP(0xA5,7): assert(false);_NEXT()
+    /* LDX zp */
+        _OP(0xA6,0): _SA(c->PC++);_NEXT()
+        _OP(0xA6,1): _SA(_GD());_NEXT()
+        _OP(0xA6,2): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xA6,3): assert(false);_NEXT()
+        _OP(0xA6,4): assert(false);_NEXT()
+        _OP(0xA6,5): assert(false);_NEXT()
+        _OP(0xA6,6): assert(false);_NEXT()
+        _OP(0xA6,7): assert(false);_NEXT()
+    /* LAX zp (undoc) */
+        _OP(0xA7,0): _SA(c->PC++);_NEXT()
+        _OP(0xA7,1): _SA(_GD());_NEXT()
+        _OP(0xA7,2): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA7,3): assert(false);_NEXT()
+        _OP(0xA7,4): assert(false);_NEXT()
+        _OP(0xA7,5): assert(false);_NEXT()
+        _OP(0xA7,6): assert(false);_NEXT()
+        _OP(0xA7,7): assert(false);_NEXT()
+    /* TAY  */
+        _OP(0xA8,0): _SA(c->PC);_NEXT()
+        _OP(0xA8,1): c->Y=c->A;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA8,2): assert(false);_NEXT()
+        _OP(0xA8,3): assert(false);_NEXT()
+        _OP(0xA8,4): assert(false);_NEXT()
+        _OP(0xA8,5): assert(false);_NEXT()
+        _OP(0xA8,6): assert(false);_NEXT()
+        _OP(0xA8,7): assert(false);_NEXT()
+    /* LDA # */
+        _OP(0xA9,0): _SA(c->PC++);_NEXT()
+        _OP(0xA9,1): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA9,2): assert(false);_NEXT()
+        _OP(0xA9,3): assert(false);_NEXT()
+        _OP(0xA9,4): assert(false);_NEXT()
+        _OP(0xA9,5): assert(false);_NEXT()
+        _OP(0xA9,6): assert(false);_NEXT()
+        _OP(0xA9,7): assert(false);_NEXT()
+    /* TAX  */
+        _OP(0xAA,0): _SA(c->PC);_NEXT()
+        _OP(0xAA,1): c->X=c->A;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xAA,2): assert(false);_NEXT()
+        _OP(0xAA,3): assert(false);_NEXT()
+        _OP(0xAA,4): assert(false);_NEXT()
+        _OP(0xAA,5): assert(false);_NEXT()
+        _OP(0xAA,6): assert(false);_NEXT()
+        _OP(0xAA,7): assert(false);_NEXT()
+    /* LXA # (undoc) */
+        _OP(0xAB,0): _SA(c->PC++);_NEXT()
+        _OP(0xAB,1): c->A=c->X=(c->A|0xEE)&_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xAB,2): assert(false);_NEXT()
+        _OP(0xAB,3): assert(false);_NEXT()
+        _OP(0xAB,4): assert(false);_NEXT()
+        _OP(0xAB,5): assert(false);_NEXT()
+        _OP(0xAB,6): assert(false);_NEXT()
+        _OP(0xAB,7): assert(false);_NEXT()
+    /* LDY abs */
+        _OP(0xAC,0): _SA(c->PC++);_NEXT()
+        _OP(0xAC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAC,3): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xAC,4): assert(false);_NEXT()
+        _OP(0xAC,5): assert(false);_NEXT()
+        _OP(0xAC,6): assert(false);_NEXT()
+        _OP(0xAC,7): assert(false);_NEXT()
+    /* LDA abs */
+        _OP(0xAD,0): _SA(c->PC++);_NEXT()
+        _OP(0xAD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAD,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAD,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xAD,4): assert(false);_NEXT()
+        _OP(0xAD,5): assert(false);_NEXT()
+        _OP(0xAD,6): assert(false);_NEXT()
+        _OP(0xAD,7): assert(false);_NEXT()
+    /* LDX abs */
+        _OP(0xAE,0): _SA(c->PC++);_NEXT()
+        _OP(0xAE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAE,3): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xAE,4): assert(false);_NEXT()
+        _OP(0xAE,5): assert(false);_NEXT()
+        _OP(0xAE,6): assert(false);_NEXT()
+        _OP(0xAE,7): assert(false);_NEXT()
+    /* LAX abs (undoc) */
+        _OP(0xAF,0): _SA(c->PC++);_NEXT()
+        _OP(0xAF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAF,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAF,3): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xAF,4): assert(false);_NEXT()
+        _OP(0xAF,5): assert(false);_NEXT()
+        _OP(0xAF,6): assert(false);_NEXT()
+        _OP(0xAF,7): assert(false);_NEXT()
+    /* BCS # */
+        _OP(0xB0,0): _SA(c->PC++);_NEXT()
+        _OP(0xB0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x1)!=0x1){_FETCH();};_NEXT()
+        _OP(0xB0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xB0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xB0,4): assert(false);_NEXT()
+        _OP(0xB0,5): assert(false);_NEXT()
+        _OP(0xB0,6): assert(false);_NEXT()
+        _OP(0xB0,7): assert(false);_NEXT()
+    /* LDA (zp),Y */
+        _OP(0xB1,0): _SA(c->PC++);_NEXT()
+        _OP(0xB1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xB1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xB1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xB1,5): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB1,6): assert(false);_NEXT()
+        _OP(0xB1,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0xB2,0): _SA(c->PC);_NEXT()
+        _OP(0xB2,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0xB2,2): assert(false);_NEXT()
+        _OP(0xB2,3): assert(false);_NEXT()
+        _OP(0xB2,4): assert(false);_NEXT()
+        _OP(0xB2,5): assert(false);_NEXT()
+        _OP(0xB2,6): assert(false);_NEXT()
+        _OP(0xB2,7): assert(false);_NEXT()
+    /* LAX (zp),Y (undoc) */
+        _OP(0xB3,0): _SA(c->PC++);_NEXT()
+        _OP(0xB3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB3,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xB3,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xB3,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xB3,5): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB3,6): assert(false);_NEXT()
+        _OP(0xB3,7): assert(false);_NEXT()
+    /* LDY zp,X */
+        _OP(0xB4,0): _SA(c->PC++);_NEXT()
+        _OP(0xB4,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB4,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xB4,3): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xB4,4): assert(false);_NEXT()
+        _OP(0xB4,5): assert(false);_NEXT()
+        _OP(0xB4,6): assert(false);_NEXT()
+        _OP(0xB4,7): assert(false);_NEXT()
+    /* LDA zp,X */
+        _OP(0xB5,0): _SA(c->PC++);_NEXT()
+        _OP(0xB5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xB5,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB5,4): assert(false);_NEXT()
+        _OP(0xB5,5): assert(false);_NEXT()
+        _OP(0xB5,6): assert(false);_NEXT()
+        _OP(0xB5,7): assert(false);_NEXT()
+    /* LDX zp,Y */
+        _OP(0xB6,0): _SA(c->PC++);_NEXT()
+        _OP(0xB6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB6,2): _SA((c->AD+c->Y)&0x00FF);_NEXT()
+        _OP(0xB6,3): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xB6,4): assert(false);_NEXT()
+        _OP(0xB6,5): assert(false);_NEXT()
+        _OP(0xB6,6): assert(false);_NEXT()
+        _OP(0xB6,7): assert(false);_NEXT()
+    /* LAX zp,Y (undoc) */
+        _OP(0xB7,0): _SA(c->PC++);_NEXT()
+        _OP(0xB7,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB7,2): _SA((c->AD+c->Y)&0x00FF);_NEXT()
+        _OP(0xB7,3): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB7,4): assert(false);_NEXT()
+        _OP(0xB7,5): assert(false);_NEXT()
+        _OP(0xB7,6): assert(false);_NEXT()
+        _OP(0xB7,7): assert(false);_NEXT()
+    /* CLV  */
+        _OP(0xB8,0): _SA(c->PC);_NEXT()
+        _OP(0xB8,1): c->P&=~0x40;_FETCH();_NEXT()
+        _OP(0xB8,2): assert(false);_NEXT()
+        _OP(0xB8,3): assert(false);_NEXT()
+        _OP(0xB8,4): assert(false);_NEXT()
+        _OP(0xB8,5): assert(false);_NEXT()
+        _OP(0xB8,6): assert(false);_NEXT()
+        _OP(0xB8,7): assert(false);_NEXT()
+    /* LDA abs,Y */
+        _OP(0xB9,0): _SA(c->PC++);_NEXT()
+        _OP(0xB9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xB9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xB9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xB9,4): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB9,5): assert(false);_NEXT()
+        _OP(0xB9,6): assert(false);_NEXT()
+        _OP(0xB9,7): assert(false);_NEXT()
+    /* TSX  */
+        _OP(0xBA,0): _SA(c->PC);_NEXT()
+        _OP(0xBA,1): c->X=c->S;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xBA,2): assert(false);_NEXT()
+        _OP(0xBA,3): assert(false);_NEXT()
+        _OP(0xBA,4): assert(false);_NEXT()
+        _OP(0xBA,5): assert(false);_NEXT()
+        _OP(0xBA,6): assert(false);_NEXT()
+        _OP(0xBA,7): assert(false);_NEXT()
+    /* LAS abs,Y (undoc) */
+        _OP(0xBB,0): _SA(c->PC++);_NEXT()
+        _OP(0xBB,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBB,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xBB,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xBB,4): c->A=c->X=c->S=_GD()&c->S;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xBB,5): assert(false);_NEXT()
+        _OP(0xBB,6): assert(false);_NEXT()
+        _OP(0xBB,7): assert(false);_NEXT()
+    /* LDY abs,X */
+        _OP(0xBC,0): _SA(c->PC++);_NEXT()
+        _OP(0xBC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBC,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xBC,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xBC,4): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xBC,5): assert(false);_NEXT()
+        _OP(0xBC,6): assert(false);_NEXT()
+        _OP(0xBC,7): assert(false);_NEXT()
+    /* LDA abs,X */
+        _OP(0xBD,0): _SA(c->PC++);_NEXT()
+        _OP(0xBD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xBD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xBD,4): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xBD,5): assert(false);_NEXT()
+        _OP(0xBD,6): assert(false);_NEXT()
+        _OP(0xBD,7): assert(false);_NEXT()
+    /* LDX abs,Y */
+        _OP(0xBE,0): _SA(c->PC++);_NEXT()
+        _OP(0xBE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xBE,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xBE,4): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xBE,5): assert(false);_NEXT()
+        _OP(0xBE,6): assert(false);_NEXT()
+        _OP(0xBE,7): assert(false);_NEXT()
+    /* LAX abs,Y (undoc) */
+        _OP(0xBF,0): _SA(c->PC++);_NEXT()
+        _OP(0xBF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBF,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xBF,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xBF,4): c->A=c->X=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xBF,5): assert(false);_NEXT()
+        _OP(0xBF,6): assert(false);_NEXT()
+        _OP(0xBF,7): assert(false);_NEXT()
+    /* CPY # */
+        _OP(0xC0,0): _SA(c->PC++);_NEXT()
+        _OP(0xC0,1): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xC0,2): assert(false);_NEXT()
+        _OP(0xC0,3): assert(false);_NEXT()
+        _OP(0xC0,4): assert(false);_NEXT()
+        _OP(0xC0,5): assert(false);_NEXT()
+        _OP(0xC0,6): assert(false);_NEXT()
+        _OP(0xC0,7): assert(false);_NEXT()
+    /* CMP (zp,X) */
+        _OP(0xC1,0): _SA(c->PC++);_NEXT()
+        _OP(0xC1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xC1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xC1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xC1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xC1,5): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC1,6): assert(false);_NEXT()
+        _OP(0xC1,7): assert(false);_NEXT()
+    /* NOP # (undoc) */
+        _OP(0xC2,0): _SA(c->PC++);_NEXT()
+        _OP(0xC2,1): _FETCH();_NEXT()
+        _OP(0xC2,2): assert(false);_NEXT()
+        _OP(0xC2,3): assert(false);_NEXT()
+        _OP(0xC2,4): assert(false);_NEXT()
+        _OP(0xC2,5): assert(false);_NEXT()
+        _OP(0xC2,6): assert(false);_NEXT()
+        _OP(0xC2,7): assert(false);_NEXT()
+    /* DCP (zp,X) (undoc) */
+        _OP(0xC3,0): _SA(c->PC++);_NEXT()
+        _OP(0xC3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xC3,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xC3,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xC3,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xC3,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0xC3,6): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xC3,7): _FETCH();_NEXT()
+    /* CPY zp */
+        _OP(0xC4,0): _SA(c->PC++);_NEXT()
+        _OP(0xC4,1): _SA(_GD());_NEXT()
+        _OP(0xC4,2): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xC4,3): assert(false);_NEXT()
+        _OP(0xC4,4): assert(false);_NEXT()
+        _OP(0xC4,5): assert(false);_NEXT()
+        _OP(0xC4,6): assert(false);_NEXT()
+        _OP(0xC4,7): assert(false);_NEXT()
+    /* CMP zp */
+        _OP(0xC5,0): _SA(c->PC++);_NEXT()
+        _OP(0xC5,1): _SA(_GD());_NEXT()
+        _OP(0xC5,2): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC5,3): assert(false);_NEXT()
+        _OP(0xC5,4): assert(false);_NEXT()
+        _OP(0xC5,5): assert(false);_NEXT()
+        _OP(0xC5,6): assert(false);_NEXT()
+        _OP(0xC5,7): assert(false);_NEXT()
+    /* DEC zp */
+        _OP(0xC6,0): _SA(c->PC++);_NEXT()
+        _OP(0xC6,1): _SA(_GD());_NEXT()
+        _OP(0xC6,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0xC6,3): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xC6,4): _FETCH();_NEXT()
+        _OP(0xC6,5): assert(false);_NEXT()
+        _OP(0xC6,6): assert(false);_NEXT()
+        _OP(0xC6,7): assert(false);_NEXT()
+    /* DCP zp (undoc) */
+        _OP(0xC7,0): _SA(c->PC++);_NEXT()
+        _OP(0xC7,1): _SA(_GD());_NEXT()
+        _OP(0xC7,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0xC7,3): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xC7,4): _FETCH();_NEXT()
+        _OP(0xC7,5): assert(false);_NEXT()
+        _OP(0xC7,6): assert(false);_NEXT()
+        _OP(0xC7,7): assert(false);_NEXT()
+    /* INY  */
+        _OP(0xC8,0): _SA(c->PC);_NEXT()
+        _OP(0xC8,1): c->Y++;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xC8,2): assert(false);_NEXT()
+        _OP(0xC8,3): assert(false);_NEXT()
+        _OP(0xC8,4): assert(false);_NEXT()
+        _OP(0xC8,5): assert(false);_NEXT()
+        _OP(0xC8,6): assert(false);_NEXT()
+        _OP(0xC8,7): assert(false);_NEXT()
+    /* CMP # */
+        _OP(0xC9,0): _SA(c->PC++);_NEXT()
+        _OP(0xC9,1): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC9,2): assert(false);_NEXT()
+        _OP(0xC9,3): assert(false);_NEXT()
+        _OP(0xC9,4): assert(false);_NEXT()
+        _OP(0xC9,5): assert(false);_NEXT()
+        _OP(0xC9,6): assert(false);_NEXT()
+        _OP(0xC9,7): assert(false);_NEXT()
+    /* DEX  */
+        _OP(0xCA,0): _SA(c->PC);_NEXT()
+        _OP(0xCA,1): c->X--;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xCA,2): assert(false);_NEXT()
+        _OP(0xCA,3): assert(false);_NEXT()
+        _OP(0xCA,4): assert(false);_NEXT()
+        _OP(0xCA,5): assert(false);_NEXT()
+        _OP(0xCA,6): assert(false);_NEXT()
+        _OP(0xCA,7): assert(false);_NEXT()
+    /* SBX # (undoc) */
+        _OP(0xCB,0): _SA(c->PC++);_NEXT()
+        _OP(0xCB,1): _m6502_sbx(c, _GD());_FETCH();_NEXT()
+        _OP(0xCB,2): assert(false);_NEXT()
+        _OP(0xCB,3): assert(false);_NEXT()
+        _OP(0xCB,4): assert(false);_NEXT()
+        _OP(0xCB,5): assert(false);_NEXT()
+        _OP(0xCB,6): assert(false);_NEXT()
+        _OP(0xCB,7): assert(false);_NEXT()
+    /* CPY abs */
+        _OP(0xCC,0): _SA(c->PC++);_NEXT()
+        _OP(0xCC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCC,3): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xCC,4): assert(false);_NEXT()
+        _OP(0xCC,5): assert(false);_NEXT()
+        _OP(0xCC,6): assert(false);_NEXT()
+        _OP(0xCC,7): assert(false);_NEXT()
+    /* CMP abs */
+        _OP(0xCD,0): _SA(c->PC++);_NEXT()
+        _OP(0xCD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCD,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCD,3): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xCD,4): assert(false);_NEXT()
+        _OP(0xCD,5): assert(false);_NEXT()
+        _OP(0xCD,6): assert(false);_NEXT()
+        _OP(0xCD,7): assert(false);_NEXT()
+    /* DEC abs */
+        _OP(0xCE,0): _SA(c->PC++);_NEXT()
+        _OP(0xCE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCE,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xCE,4): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xCE,5): _FETCH();_NEXT()
+        _OP(0xCE,6): assert(false);_NEXT()
+        _OP(0xCE,7): assert(false);_NEXT()
+    /* DCP abs (undoc) */
+        _OP(0xCF,0): _SA(c->PC++);_NEXT()
+        _OP(0xCF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCF,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCF,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xCF,4): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xCF,5): _FETCH();_NEXT()
+        _OP(0xCF,6): assert(false);_NEXT()
+        _OP(0xCF,7): assert(false);_NEXT()
+    /* BNE # */
+        _OP(0xD0,0): _SA(c->PC++);_NEXT()
+        _OP(0xD0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x2)!=0x0){_FETCH();};_NEXT()
+        _OP(0xD0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xD0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xD0,4): assert(false);_NEXT()
+        _OP(0xD0,5): assert(false);_NEXT()
+        _OP(0xD0,6): assert(false);_NEXT()
+        _OP(0xD0,7): assert(false);_NEXT()
+    /* CMP (zp),Y */
+        _OP(0xD1,0): _SA(c->PC++);_NEXT()
+        _OP(0xD1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xD1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xD1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xD1,5): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD1,6): assert(false);_NEXT()
+        _OP(0xD1,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0xD2,0): _SA(c->PC);_NEXT()
+        _OP(0xD2,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0xD2,2): assert(false);_NEXT()
+        _OP(0xD2,3): assert(false);_NEXT()
+        _OP(0xD2,4): assert(false);_NEXT()
+        _OP(0xD2,5): assert(false);_NEXT()
+        _OP(0xD2,6): assert(false);_NEXT()
+        _OP(0xD2,7): assert(false);_NEXT()
+    /* DCP (zp),Y (undoc) */
+        _OP(0xD3,0): _SA(c->PC++);_NEXT()
+        _OP(0xD3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD3,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xD3,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0xD3,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xD3,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0xD3,6): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xD3,7): _FETCH();_NEXT()
+    /* NOP zp,X (undoc) */
+        _OP(0xD4,0): _SA(c->PC++);_NEXT()
+        _OP(0xD4,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD4,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD4,3): _FETCH();_NEXT()
+        _OP(0xD4,4): assert(false);_NEXT()
+        _OP(0xD4,5): assert(false);_NEXT()
+        _OP(0xD4,6): assert(false);_NEXT()
+        _OP(0xD4,7): assert(false);_NEXT()
+    /* CMP zp,X */
+        _OP(0xD5,0): _SA(c->PC++);_NEXT()
+        _OP(0xD5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD5,3): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD5,4): assert(false);_NEXT()
+        _OP(0xD5,5): assert(false);_NEXT()
+        _OP(0xD5,6): assert(false);_NEXT()
+        _OP(0xD5,7): assert(false);_NEXT()
+    /* DEC zp,X */
+        _OP(0xD6,0): _SA(c->PC++);_NEXT()
+        _OP(0xD6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD6,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD6,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xD6,4): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xD6,5): _FETCH();_NEXT()
+        _OP(0xD6,6): assert(false);_NEXT()
+        _OP(0xD6,7): assert(false);_NEXT()
+    /* DCP zp,X (undoc) */
+        _OP(0xD7,0): _SA(c->PC++);_NEXT()
+        _OP(0xD7,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD7,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD7,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xD7,4): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xD7,5): _FETCH();_NEXT()
+        _OP(0xD7,6): assert(false);_NEXT()
+        _OP(0xD7,7): assert(false);_NEXT()
+    /* CLD  */
+        _OP(0xD8,0): _SA(c->PC);_NEXT()
+        _OP(0xD8,1): c->P&=~0x8;_FETCH();_NEXT()
+        _OP(0xD8,2): assert(false);_NEXT()
+        _OP(0xD8,3): assert(false);_NEXT()
+        _OP(0xD8,4): assert(false);_NEXT()
+        _OP(0xD8,5): assert(false);_NEXT()
+        _OP(0xD8,6): assert(false);_NEXT()
+        _OP(0xD8,7): assert(false);_NEXT()
+    /* CMP abs,Y */
+        _OP(0xD9,0): _SA(c->PC++);_NEXT()
+        _OP(0xD9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xD9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xD9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xD9,4): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD9,5): assert(false);_NEXT()
+        _OP(0xD9,6): assert(false);_NEXT()
+        _OP(0xD9,7): assert(false);_NEXT()
+    /* NOP  (undoc) */
+        _OP(0xDA,0): _SA(c->PC);_NEXT()
+        _OP(0xDA,1): _FETCH();_NEXT()
+        _OP(0xDA,2): assert(false);_NEXT()
+        _OP(0xDA,3): assert(false);_NEXT()
+        _OP(0xDA,4): assert(false);_NEXT()
+        _OP(0xDA,5): assert(false);_NEXT()
+        _OP(0xDA,6): assert(false);_NEXT()
+        _OP(0xDA,7): assert(false);_NEXT()
+    /* DCP abs,Y (undoc) */
+        _OP(0xDB,0): _SA(c->PC++);_NEXT()
+        _OP(0xDB,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDB,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0xDB,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xDB,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xDB,5): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xDB,6): _FETCH();_NEXT()
+        _OP(0xDB,7): assert(false);_NEXT()
+    /* NOP abs,X (undoc) */
+        _OP(0xDC,0): _SA(c->PC++);_NEXT()
+        _OP(0xDC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDC,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xDC,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDC,4): _FETCH();_NEXT()
+        _OP(0xDC,5): assert(false);_NEXT()
+        _OP(0xDC,6): assert(false);_NEXT()
+        _OP(0xDC,7): assert(false);_NEXT()
+    /* CMP abs,X */
+        _OP(0xDD,0): _SA(c->PC++);_NEXT()
+        _OP(0xDD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xDD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDD,4): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xDD,5): assert(false);_NEXT()
+        _OP(0xDD,6): assert(false);_NEXT()
+        _OP(0xDD,7): assert(false);_NEXT()
+    /* DEC abs,X */
+        _OP(0xDE,0): _SA(c->PC++);_NEXT()
+        _OP(0xDE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xDE,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDE,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xDE,5): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xDE,6): _FETCH();_NEXT()
+        _OP(0xDE,7): assert(false);_NEXT()
+    /* DCP abs,X (undoc) */
+        _OP(0xDF,0): _SA(c->PC++);_NEXT()
+        _OP(0xDF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDF,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xDF,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDF,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xDF,5): c->AD--;_NZ(c->AD);_SD(c->AD);_m6502_cmp(c, c->A, c->AD);_WR();_NEXT()
+        _OP(0xDF,6): _FETCH();_NEXT()
+        _OP(0xDF,7): assert(false);_NEXT()
+    /* CPX # */
+        _OP(0xE0,0): _SA(c->PC++);_NEXT()
+        _OP(0xE0,1): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xE0,2): assert(false);_NEXT()
+        _OP(0xE0,3): assert(false);_NEXT()
+        _OP(0xE0,4): assert(false);_NEXT()
+        _OP(0xE0,5): assert(false);_NEXT()
+        _OP(0xE0,6): assert(false);_NEXT()
+        _OP(0xE0,7): assert(false);_NEXT()
+    /* SBC (zp,X) */
+        _OP(0xE1,0): _SA(c->PC++);_NEXT()
+        _OP(0xE1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xE1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xE1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xE1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xE1,5): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xE1,6): assert(false);_NEXT()
+        _OP(0xE1,7): assert(false);_NEXT()
+    /* NOP # (undoc) */
+        _OP(0xE2,0): _SA(c->PC++);_NEXT()
+        _OP(0xE2,1): _FETCH();_NEXT()
+        _OP(0xE2,2): assert(false);_NEXT()
+        _OP(0xE2,3): assert(false);_NEXT()
+        _OP(0xE2,4): assert(false);_NEXT()
+        _OP(0xE2,5): assert(false);_NEXT()
+        _OP(0xE2,6): assert(false);_NEXT()
+        _OP(0xE2,7): assert(false);_NEXT()
+    /* ISB (zp,X) (undoc) */
+        _OP(0xE3,0): _SA(c->PC++);_NEXT()
+        _OP(0xE3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xE3,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xE3,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xE3,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xE3,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0xE3,6): c->AD++;_SD(c->AD);_m6502_sbc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0xE3,7): _FETCH();_NEXT()
+    /* CPX zp */
+        _OP(0xE4,0): _SA(c->PC++);_NEXT()
+        _OP(0xE4,1): _SA(_GD());_NEXT()
+        _OP(0xE4,2): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xE4,3): assert(false);_NEXT()
+        _OP(0xE4,4): assert(false);_NEXT()
+        _OP(0xE4,5): assert(false);_NEXT()
+        _OP(0xE4,6): assert(false);_NEXT()
+        _OP(0xE4,7): assert(false);_NEXT()
+    /* SBC zp */
+        _OP(0xE5,0): _SA(c->PC++);_NEXT()
+        _OP(0xE5,1): _SA(_GD());_NEXT()
+        _OP(0xE5,2): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xE5,3): assert(false);_NEXT()
+        _OP(0xE5,4): assert(false);_NEXT()
+        _OP(0xE5,5): assert(false);_NEXT()
+        _OP(0xE5,6): assert(false);_NEXT()
+        _OP(0xE5,7): assert(false);_NEXT()
+    /* INC zp */
+        _OP(0xE6,0): _SA(c->PC++);_NEXT()
+        _OP(0xE6,1): _SA(_GD());_NEXT()
+        _OP(0xE6,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0xE6,3): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xE6,4): _FETCH();_NEXT()
+        _OP(0xE6,5): assert(false);_NEXT()
+        _OP(0xE6,6): assert(false);_NEXT()
+        _OP(0xE6,7): assert(false);_NEXT()
+    /* ISB zp (undoc) */
+        _OP(0xE7,0): _SA(c->PC++);_NEXT()
+        _OP(0xE7,1): _SA(_GD());_NEXT()
+        _OP(0xE7,2): c->AD=_GD();_WR();_NEXT()
+        _OP(0xE7,3): c->AD++;_SD(c->AD);_m6502_sbc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0xE7,4): _FETCH();_NEXT()
+        _OP(0xE7,5): assert(false);_NEXT()
+        _OP(0xE7,6): assert(false);_NEXT()
+        _OP(0xE7,7): assert(false);_NEXT()
+    /* INX  */
+        _OP(0xE8,0): _SA(c->PC);_NEXT()
+        _OP(0xE8,1): c->X++;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xE8,2): assert(false);_NEXT()
+        _OP(0xE8,3): assert(false);_NEXT()
+        _OP(0xE8,4): assert(false);_NEXT()
+        _OP(0xE8,5): assert(false);_NEXT()
+        _OP(0xE8,6): assert(false);_NEXT()
+        _OP(0xE8,7): assert(false);_NEXT()
+    /* SBC # */
+        _OP(0xE9,0): _SA(c->PC++);_NEXT()
+        _OP(0xE9,1): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xE9,2): assert(false);_NEXT()
+        _OP(0xE9,3): assert(false);_NEXT()
+        _OP(0xE9,4): assert(false);_NEXT()
+        _OP(0xE9,5): assert(false);_NEXT()
+        _OP(0xE9,6): assert(false);_NEXT()
+        _OP(0xE9,7): assert(false);_NEXT()
+    /* NOP  */
+        _OP(0xEA,0): _SA(c->PC);_NEXT()
+        _OP(0xEA,1): _FETCH();_NEXT()
+        _OP(0xEA,2): assert(false);_NEXT()
+        _OP(0xEA,3): assert(false);_NEXT()
+        _OP(0xEA,4): assert(false);_NEXT()
+        _OP(0xEA,5): assert(false);_NEXT()
+        _OP(0xEA,6): assert(false);_NEXT()
+        _OP(0xEA,7): assert(false);_NEXT()
+    /* SBC # (undoc) */
+        _OP(0xEB,0): _SA(c->PC++);_NEXT()
+        _OP(0xEB,1): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xEB,2): assert(false);_NEXT()
+        _OP(0xEB,3): assert(false);_NEXT()
+        _OP(0xEB,4): assert(false);_NEXT()
+        _OP(0xEB,5): assert(false);_NEXT()
+        _OP(0xEB,6): assert(false);_NEXT()
+        _OP(0xEB,7): assert(false);_NEXT()
+    /* CPX abs */
+        _OP(0xEC,0): _SA(c->PC++);_NEXT()
+        _OP(0xEC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xEC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xEC,3): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xEC,4): assert(false);_NEXT()
+        _OP(0xEC,5): assert(false);_NEXT()
+        _OP(0xEC,6): assert(false);_NEXT()
+        _OP(0xEC,7): assert(false);_NEXT()
+    /* SBC abs */
+        _OP(0xED,0): _SA(c->PC++);_NEXT()
+        _OP(0xED,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xED,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xED,3): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xED,4): assert(false);_NEXT()
+        _OP(0xED,5): assert(false);_NEXT()
+        _OP(0xED,6): assert(false);_NEXT()
+        _OP(0xED,7): assert(false);_NEXT()
+    /* INC abs */
+        _OP(0xEE,0): _SA(c->PC++);_NEXT()
+        _OP(0xEE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xEE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xEE,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xEE,4): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xEE,5): _FETCH();_NEXT()
+        _OP(0xEE,6): assert(false);_NEXT()
+        _OP(0xEE,7): assert(false);_NEXT()
+    /* ISB abs (undoc) */
+        _OP(0xEF,0): _SA(c->PC++);_NEXT()
+        _OP(0xEF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xEF,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xEF,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xEF,4): c->AD++;_SD(c->AD);_m6502_sbc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0xEF,5): _FETCH();_NEXT()
+        _OP(0xEF,6): assert(false);_NEXT()
+        _OP(0xEF,7): assert(false);_NEXT()
+    /* BEQ # */
+        _OP(0xF0,0): _SA(c->PC++);_NEXT()
+        _OP(0xF0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x2)!=0x2){_FETCH();};_NEXT()
+        _OP(0xF0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xF0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xF0,4): assert(false);_NEXT()
+        _OP(0xF0,5): assert(false);_NEXT()
+        _OP(0xF0,6): assert(false);_NEXT()
+        _OP(0xF0,7): assert(false);_NEXT()
+    /* SBC (zp),Y */
+        _OP(0xF1,0): _SA(c->PC++);_NEXT()
+        _OP(0xF1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xF1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xF1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xF1,5): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xF1,6): assert(false);_NEXT()
+        _OP(0xF1,7): assert(false);_NEXT()
+    /* JAM INVALID (undoc) */
+        _OP(0xF2,0): _SA(c->PC);_NEXT()
+        _OP(0xF2,1): _SAD(0xFFFF,0xFF);c->IR--;_NEXT()
+        _OP(0xF2,2): assert(false);_NEXT()
+        _OP(0xF2,3): assert(false);_NEXT()
+        _OP(0xF2,4): assert(false);_NEXT()
+        _OP(0xF2,5): assert(false);_NEXT()
+        _OP(0xF2,6): assert(false);_NEXT()
+        _OP(0xF2,7): assert(false);_NEXT()
+    /* ISB (zp),Y (undoc) */
+        _OP(0xF3,0): _SA(c->PC++);_NEXT()
+        _OP(0xF3,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF3,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xF3,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0xF3,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xF3,5): c->AD=_GD();_WR();_NEXT()
+        _OP(0xF3,6): c->AD++;_SD(c->AD);_m6502_sbc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0xF3,7): _FETCH();_NEXT()
+    /* NOP zp,X (undoc) */
+        _OP(0xF4,0): _SA(c->PC++);_NEXT()
+        _OP(0xF4,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF4,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF4,3): _FETCH();_NEXT()
+        _OP(0xF4,4): assert(false);_NEXT()
+        _OP(0xF4,5): assert(false);_NEXT()
+        _OP(0xF4,6): assert(false);_NEXT()
+        _OP(0xF4,7): assert(false);_NEXT()
+    /* SBC zp,X */
+        _OP(0xF5,0): _SA(c->PC++);_NEXT()
+        _OP(0xF5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF5,3): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xF5,4): assert(false);_NEXT()
+        _OP(0xF5,5): assert(false);_NEXT()
+        _OP(0xF5,6): assert(false);_NEXT()
+        _OP(0xF5,7): assert(false);_NEXT()
+    /* INC zp,X */
+        _OP(0xF6,0): _SA(c->PC++);_NEXT()
+        _OP(0xF6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF6,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF6,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xF6,4): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xF6,5): _FETCH();_NEXT()
+        _OP(0xF6,6): assert(false);_NEXT()
+        _OP(0xF6,7): assert(false);_NEXT()
+    /* ISB zp,X (undoc) */
+        _OP(0xF7,0): _SA(c->PC++);_NEXT()
+        _OP(0xF7,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF7,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF7,3): c->AD=_GD();_WR();_NEXT()
+        _OP(0xF7,4): c->AD++;_SD(c->AD);_m6502_sbc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0xF7,5): _FETCH();_NEXT()
+        _OP(0xF7,6): assert(false);_NEXT()
+        _OP(0xF7,7): assert(false);_NEXT()
+    /* SED  */
+        _OP(0xF8,0): _SA(c->PC);_NEXT()
+        _OP(0xF8,1): c->P|=0x8;_FETCH();_NEXT()
+        _OP(0xF8,2): assert(false);_NEXT()
+        _OP(0xF8,3): assert(false);_NEXT()
+        _OP(0xF8,4): assert(false);_NEXT()
+        _OP(0xF8,5): assert(false);_NEXT()
+        _OP(0xF8,6): assert(false);_NEXT()
+        _OP(0xF8,7): assert(false);_NEXT()
+    /* SBC abs,Y */
+        _OP(0xF9,0): _SA(c->PC++);_NEXT()
+        _OP(0xF9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xF9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xF9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xF9,4): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xF9,5): assert(false);_NEXT()
+        _OP(0xF9,6): assert(false);_NEXT()
+        _OP(0xF9,7): assert(false);_NEXT()
+    /* NOP  (undoc) */
+        _OP(0xFA,0): _SA(c->PC);_NEXT()
+        _OP(0xFA,1): _FETCH();_NEXT()
+        _OP(0xFA,2): assert(false);_NEXT()
+        _OP(0xFA,3): assert(false);_NEXT()
+        _OP(0xFA,4): assert(false);_NEXT()
+        _OP(0xFA,5): assert(false);_NEXT()
+        _OP(0xFA,6): assert(false);_NEXT()
+        _OP(0xFA,7): assert(false);_NEXT()
+    /* ISB abs,Y (undoc) */
+        _OP(0xFB,0): _SA(c->PC++);_NEXT()
+        _OP(0xFB,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFB,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0xFB,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xFB,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xFB,5): c->AD++;_SD(c->AD);_m6502_sbc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0xFB,6): _FETCH();_NEXT()
+        _OP(0xFB,7): assert(false);_NEXT()
+    /* NOP abs,X (undoc) */
+        _OP(0xFC,0): _SA(c->PC++);_NEXT()
+        _OP(0xFC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFC,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xFC,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFC,4): _FETCH();_NEXT()
+        _OP(0xFC,5): assert(false);_NEXT()
+        _OP(0xFC,6): assert(false);_NEXT()
+        _OP(0xFC,7): assert(false);_NEXT()
+    /* SBC abs,X */
+        _OP(0xFD,0): _SA(c->PC++);_NEXT()
+        _OP(0xFD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xFD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFD,4): _m6502_sbc_bin(c,_GD());_FETCH();_NEXT()
+        _OP(0xFD,5): assert(false);_NEXT()
+        _OP(0xFD,6): assert(false);_NEXT()
+        _OP(0xFD,7): assert(false);_NEXT()
+    /* INC abs,X */
+        _OP(0xFE,0): _SA(c->PC++);_NEXT()
+        _OP(0xFE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xFE,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFE,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xFE,5): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xFE,6): _FETCH();_NEXT()
+        _OP(0xFE,7): assert(false);_NEXT()
+    /* ISB abs,X (undoc) */
+        _OP(0xFF,0): _SA(c->PC++);_NEXT()
+        _OP(0xFF,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFF,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xFF,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFF,4): c->AD=_GD();_WR();_NEXT()
+        _OP(0xFF,5): c->AD++;_SD(c->AD);_m6502_sbc_bin(c,c->AD);_WR();_NEXT()
+        _OP(0xFF,6): _FETCH();_NEXT()
+        _OP(0xFF,7): assert(false);_NEXT()
+
+    }
+    _M6502_TICK_END();
+    return pins;
+}
+
+/* CMOS 65C02 instruction decoder */
+uint64_t m65c02_tick(m6502_t* c, uint64_t pins) {
+    if (_m6502_tick_begin(c, &pins)) {
+        return pins;
+    }
+    // reads are default, writes are special
+    _RD();
+    #if defined(_M6502_COMPUTED_GOTO)
+    static const void* _m6502_op_table[2048] = {
+        &&_m6502_op_0x00_0,&&_m6502_op_0x00_1,&&_m6502_op_0x00_2,&&_m6502_op_0x00_3,&&_m6502_op_0x00_4,&&_m6502_op_0x00_5,&&_m6502_op_0x00_6,&&_m6502_op_0x00_7,
+        &&_m6502_op_0x01_0,&&_m6502_op_0x01_1,&&_m6502_op_0x01_2,&&_m6502_op_0x01_3,&&_m6502_op_0x01_4,&&_m6502_op_0x01_5,&&_m6502_op_0x01_6,&&_m6502_op_0x01_7,
+        &&_m6502_op_0x02_0,&&_m6502_op_0x02_1,&&_m6502_op_0x02_2,&&_m6502_op_0x02_3,&&_m6502_op_0x02_4,&&_m6502_op_0x02_5,&&_m6502_op_0x02_6,&&_m6502_op_0x02_7,
+        &&_m6502_op_0x03_0,&&_m6502_op_0x03_1,&&_m6502_op_0x03_2,&&_m6502_op_0x03_3,&&_m6502_op_0x03_4,&&_m6502_op_0x03_5,&&_m6502_op_0x03_6,&&_m6502_op_0x03_7,
+        &&_m6502_op_0x04_0,&&_m6502_op_0x04_1,&&_m6502_op_0x04_2,&&_m6502_op_0x04_3,&&_m6502_op_0x04_4,&&_m6502_op_0x04_5,&&_m6502_op_0x04_6,&&_m6502_op_0x04_7,
+        &&_m6502_op_0x05_0,&&_m6502_op_0x05_1,&&_m6502_op_0x05_2,&&_m6502_op_0x05_3,&&_m6502_op_0x05_4,&&_m6502_op_0x05_5,&&_m6502_op_0x05_6,&&_m6502_op_0x05_7,
+        &&_m6502_op_0x06_0,&&_m6502_op_0x06_1,&&_m6502_op_0x06_2,&&_m6502_op_0x06_3,&&_m6502_op_0x06_4,&&_m6502_op_0x06_5,&&_m6502_op_0x06_6,&&_m6502_op_0x06_7,
+        &&_m6502_op_0x07_0,&&_m6502_op_0x07_1,&&_m6502_op_0x07_2,&&_m6502_op_0x07_3,&&_m6502_op_0x07_4,&&_m6502_op_0x07_5,&&_m6502_op_0x07_6,&&_m6502_op_0x07_7,
+        &&_m6502_op_0x08_0,&&_m6502_op_0x08_1,&&_m6502_op_0x08_2,&&_m6502_op_0x08_3,&&_m6502_op_0x08_4,&&_m6502_op_0x08_5,&&_m6502_op_0x08_6,&&_m6502_op_0x08_7,
+        &&_m6502_op_0x09_0,&&_m6502_op_0x09_1,&&_m6502_op_0x09_2,&&_m6502_op_0x09_3,&&_m6502_op_0x09_4,&&_m6502_op_0x09_5,&&_m6502_op_0x09_6,&&_m6502_op_0x09_7,
+        &&_m6502_op_0x0A_0,&&_m6502_op_0x0A_1,&&_m6502_op_0x0A_2,&&_m6502_op_0x0A_3,&&_m6502_op_0x0A_4,&&_m6502_op_0x0A_5,&&_m6502_op_0x0A_6,&&_m6502_op_0x0A_7,
+        &&_m6502_op_0x0B_0,&&_m6502_op_0x0B_1,&&_m6502_op_0x0B_2,&&_m6502_op_0x0B_3,&&_m6502_op_0x0B_4,&&_m6502_op_0x0B_5,&&_m6502_op_0x0B_6,&&_m6502_op_0x0B_7,
+        &&_m6502_op_0x0C_0,&&_m6502_op_0x0C_1,&&_m6502_op_0x0C_2,&&_m6502_op_0x0C_3,&&_m6502_op_0x0C_4,&&_m6502_op_0x0C_5,&&_m6502_op_0x0C_6,&&_m6502_op_0x0C_7,
+        &&_m6502_op_0x0D_0,&&_m6502_op_0x0D_1,&&_m6502_op_0x0D_2,&&_m6502_op_0x0D_3,&&_m6502_op_0x0D_4,&&_m6502_op_0x0D_5,&&_m6502_op_0x0D_6,&&_m6502_op_0x0D_7,
+        &&_m6502_op_0x0E_0,&&_m6502_op_0x0E_1,&&_m6502_op_0x0E_2,&&_m6502_op_0x0E_3,&&_m6502_op_0x0E_4,&&_m6502_op_0x0E_5,&&_m6502_op_0x0E_6,&&_m6502_op_0x0E_7,
+        &&_m6502_op_0x0F_0,&&_m6502_op_0x0F_1,&&_m6502_op_0x0F_2,&&_m6502_op_0x0F_3,&&_m6502_op_0x0F_4,&&_m6502_op_0x0F_5,&&_m6502_op_0x0F_6,&&_m6502_op_0x0F_7,
+        &&_m6502_op_0x10_0,&&_m6502_op_0x10_1,&&_m6502_op_0x10_2,&&_m6502_op_0x10_3,&&_m6502_op_0x10_4,&&_m6502_op_0x10_5,&&_m6502_op_0x10_6,&&_m6502_op_0x10_7,
+        &&_m6502_op_0x11_0,&&_m6502_op_0x11_1,&&_m6502_op_0x11_2,&&_m6502_op_0x11_3,&&_m6502_op_0x11_4,&&_m6502_op_0x11_5,&&_m6502_op_0x11_6,&&_m6502_op_0x11_7,
+        &&_m6502_op_0x12_0,&&_m6502_op_0x12_1,&&_m6502_op_0x12_2,&&_m6502_op_0x12_3,&&_m6502_op_0x12_4,&&_m6502_op_0x12_5,&&_m6502_op_0x12_6,&&_m6502_op_0x12_7,
+        &&_m6502_op_0x13_0,&&_m6502_op_0x13_1,&&_m6502_op_0x13_2,&&_m6502_op_0x13_3,&&_m6502_op_0x13_4,&&_m6502_op_0x13_5,&&_m6502_op_0x13_6,&&_m6502_op_0x13_7,
+        &&_m6502_op_0x14_0,&&_m6502_op_0x14_1,&&_m6502_op_0x14_2,&&_m6502_op_0x14_3,&&_m6502_op_0x14_4,&&_m6502_op_0x14_5,&&_m6502_op_0x14_6,&&_m6502_op_0x14_7,
+        &&_m6502_op_0x15_0,&&_m6502_op_0x15_1,&&_m6502_op_0x15_2,&&_m6502_op_0x15_3,&&_m6502_op_0x15_4,&&_m6502_op_0x15_5,&&_m6502_op_0x15_6,&&_m6502_op_0x15_7,
+        &&_m6502_op_0x16_0,&&_m6502_op_0x16_1,&&_m6502_op_0x16_2,&&_m6502_op_0x16_3,&&_m6502_op_0x16_4,&&_m6502_op_0x16_5,&&_m6502_op_0x16_6,&&_m6502_op_0x16_7,
+        &&_m6502_op_0x17_0,&&_m6502_op_0x17_1,&&_m6502_op_0x17_2,&&_m6502_op_0x17_3,&&_m6502_op_0x17_4,&&_m6502_op_0x17_5,&&_m6502_op_0x17_6,&&_m6502_op_0x17_7,
+        &&_m6502_op_0x18_0,&&_m6502_op_0x18_1,&&_m6502_op_0x18_2,&&_m6502_op_0x18_3,&&_m6502_op_0x18_4,&&_m6502_op_0x18_5,&&_m6502_op_0x18_6,&&_m6502_op_0x18_7,
+        &&_m6502_op_0x19_0,&&_m6502_op_0x19_1,&&_m6502_op_0x19_2,&&_m6502_op_0x19_3,&&_m6502_op_0x19_4,&&_m6502_op_0x19_5,&&_m6502_op_0x19_6,&&_m6502_op_0x19_7,
+        &&_m6502_op_0x1A_0,&&_m6502_op_0x1A_1,&&_m6502_op_0x1A_2,&&_m6502_op_0x1A_3,&&_m6502_op_0x1A_4,&&_m6502_op_0x1A_5,&&_m6502_op_0x1A_6,&&_m6502_op_0x1A_7,
+        &&_m6502_op_0x1B_0,&&_m6502_op_0x1B_1,&&_m6502_op_0x1B_2,&&_m6502_op_0x1B_3,&&_m6502_op_0x1B_4,&&_m6502_op_0x1B_5,&&_m6502_op_0x1B_6,&&_m6502_op_0x1B_7,
+        &&_m6502_op_0x1C_0,&&_m6502_op_0x1C_1,&&_m6502_op_0x1C_2,&&_m6502_op_0x1C_3,&&_m6502_op_0x1C_4,&&_m6502_op_0x1C_5,&&_m6502_op_0x1C_6,&&_m6502_op_0x1C_7,
+        &&_m6502_op_0x1D_0,&&_m6502_op_0x1D_1,&&_m6502_op_0x1D_2,&&_m6502_op_0x1D_3,&&_m6502_op_0x1D_4,&&_m6502_op_0x1D_5,&&_m6502_op_0x1D_6,&&_m6502_op_0x1D_7,
+        &&_m6502_op_0x1E_0,&&_m6502_op_0x1E_1,&&_m6502_op_0x1E_2,&&_m6502_op_0x1E_3,&&_m6502_op_0x1E_4,&&_m6502_op_0x1E_5,&&_m6502_op_0x1E_6,&&_m6502_op_0x1E_7,
+        &&_m6502_op_0x1F_0,&&_m6502_op_0x1F_1,&&_m6502_op_0x1F_2,&&_m6502_op_0x1F_3,&&_m6502_op_0x1F_4,&&_m6502_op_0x1F_5,&&_m6502_op_0x1F_6,&&_m6502_op_0x1F_7,
+        &&_m6502_op_0x20_0,&&_m6502_op_0x20_1,&&_m6502_op_0x20_2,&&_m6502_op_0x20_3,&&_m6502_op_0x20_4,&&_m6502_op_0x20_5,&&_m6502_op_0x20_6,&&_m6502_op_0x20_7,
+        &&_m6502_op_0x21_0,&&_m6502_op_0x21_1,&&_m6502_op_0x21_2,&&_m6502_op_0x21_3,&&_m6502_op_0x21_4,&&_m6502_op_0x21_5,&&_m6502_op_0x21_6,&&_m6502_op_0x21_7,
+        &&_m6502_op_0x22_0,&&_m6502_op_0x22_1,&&_m6502_op_0x22_2,&&_m6502_op_0x22_3,&&_m6502_op_0x22_4,&&_m6502_op_0x22_5,&&_m6502_op_0x22_6,&&_m6502_op_0x22_7,
+        &&_m6502_op_0x23_0,&&_m6502_op_0x23_1,&&_m6502_op_0x23_2,&&_m6502_op_0x23_3,&&_m6502_op_0x23_4,&&_m6502_op_0x23_5,&&_m6502_op_0x23_6,&&_m6502_op_0x23_7,
+        &&_m6502_op_0x24_0,&&_m6502_op_0x24_1,&&_m6502_op_0x24_2,&&_m6502_op_0x24_3,&&_m6502_op_0x24_4,&&_m6502_op_0x24_5,&&_m6502_op_0x24_6,&&_m6502_op_0x24_7,
+        &&_m6502_op_0x25_0,&&_m6502_op_0x25_1,&&_m6502_op_0x25_2,&&_m6502_op_0x25_3,&&_m6502_op_0x25_4,&&_m6502_op_0x25_5,&&_m6502_op_0x25_6,&&_m6502_op_0x25_7,
+        &&_m6502_op_0x26_0,&&_m6502_op_0x26_1,&&_m6502_op_0x26_2,&&_m6502_op_0x26_3,&&_m6502_op_0x26_4,&&_m6502_op_0x26_5,&&_m6502_op_0x26_6,&&_m6502_op_0x26_7,
+        &&_m6502_op_0x27_0,&&_m6502_op_0x27_1,&&_m6502_op_0x27_2,&&_m6502_op_0x27_3,&&_m6502_op_0x27_4,&&_m6502_op_0x27_5,&&_m6502_op_0x27_6,&&_m6502_op_0x27_7,
+        &&_m6502_op_0x28_0,&&_m6502_op_0x28_1,&&_m6502_op_0x28_2,&&_m6502_op_0x28_3,&&_m6502_op_0x28_4,&&_m6502_op_0x28_5,&&_m6502_op_0x28_6,&&_m6502_op_0x28_7,
+        &&_m6502_op_0x29_0,&&_m6502_op_0x29_1,&&_m6502_op_0x29_2,&&_m6502_op_0x29_3,&&_m6502_op_0x29_4,&&_m6502_op_0x29_5,&&_m6502_op_0x29_6,&&_m6502_op_0x29_7,
+        &&_m6502_op_0x2A_0,&&_m6502_op_0x2A_1,&&_m6502_op_0x2A_2,&&_m6502_op_0x2A_3,&&_m6502_op_0x2A_4,&&_m6502_op_0x2A_5,&&_m6502_op_0x2A_6,&&_m6502_op_0x2A_7,
+        &&_m6502_op_0x2B_0,&&_m6502_op_0x2B_1,&&_m6502_op_0x2B_2,&&_m6502_op_0x2B_3,&&_m6502_op_0x2B_4,&&_m6502_op_0x2B_5,&&_m6502_op_0x2B_6,&&_m6502_op_0x2B_7,
+        &&_m6502_op_0x2C_0,&&_m6502_op_0x2C_1,&&_m6502_op_0x2C_2,&&_m6502_op_0x2C_3,&&_m6502_op_0x2C_4,&&_m6502_op_0x2C_5,&&_m6502_op_0x2C_6,&&_m6502_op_0x2C_7,
+        &&_m6502_op_0x2D_0,&&_m6502_op_0x2D_1,&&_m6502_op_0x2D_2,&&_m6502_op_0x2D_3,&&_m6502_op_0x2D_4,&&_m6502_op_0x2D_5,&&_m6502_op_0x2D_6,&&_m6502_op_0x2D_7,
+        &&_m6502_op_0x2E_0,&&_m6502_op_0x2E_1,&&_m6502_op_0x2E_2,&&_m6502_op_0x2E_3,&&_m6502_op_0x2E_4,&&_m6502_op_0x2E_5,&&_m6502_op_0x2E_6,&&_m6502_op_0x2E_7,
+        &&_m6502_op_0x2F_0,&&_m6502_op_0x2F_1,&&_m6502_op_0x2F_2,&&_m6502_op_0x2F_3,&&_m6502_op_0x2F_4,&&_m6502_op_0x2F_5,&&_m6502_op_0x2F_6,&&_m6502_op_0x2F_7,
+        &&_m6502_op_0x30_0,&&_m6502_op_0x30_1,&&_m6502_op_0x30_2,&&_m6502_op_0x30_3,&&_m6502_op_0x30_4,&&_m6502_op_0x30_5,&&_m6502_op_0x30_6,&&_m6502_op_0x30_7,
+        &&_m6502_op_0x31_0,&&_m6502_op_0x31_1,&&_m6502_op_0x31_2,&&_m6502_op_0x31_3,&&_m6502_op_0x31_4,&&_m6502_op_0x31_5,&&_m6502_op_0x31_6,&&_m6502_op_0x31_7,
+        &&_m6502_op_0x32_0,&&_m6502_op_0x32_1,&&_m6502_op_0x32_2,&&_m6502_op_0x32_3,&&_m6502_op_0x32_4,&&_m6502_op_0x32_5,&&_m6502_op_0x32_6,&&_m6502_op_0x32_7,
+        &&_m6502_op_0x33_0,&&_m6502_op_0x33_1,&&_m6502_op_0x33_2,&&_m6502_op_0x33_3,&&_m6502_op_0x33_4,&&_m6502_op_0x33_5,&&_m6502_op_0x33_6,&&_m6502_op_0x33_7,
+        &&_m6502_op_0x34_0,&&_m6502_op_0x34_1,&&_m6502_op_0x34_2,&&_m6502_op_0x34_3,&&_m6502_op_0x34_4,&&_m6502_op_0x34_5,&&_m6502_op_0x34_6,&&_m6502_op_0x34_7,
+        &&_m6502_op_0x35_0,&&_m6502_op_0x35_1,&&_m6502_op_0x35_2,&&_m6502_op_0x35_3,&&_m6502_op_0x35_4,&&_m6502_op_0x35_5,&&_m6502_op_0x35_6,&&_m6502_op_0x35_7,
+        &&_m6502_op_0x36_0,&&_m6502_op_0x36_1,&&_m6502_op_0x36_2,&&_m6502_op_0x36_3,&&_m6502_op_0x36_4,&&_m6502_op_0x36_5,&&_m6502_op_0x36_6,&&_m6502_op_0x36_7,
+        &&_m6502_op_0x37_0,&&_m6502_op_0x37_1,&&_m6502_op_0x37_2,&&_m6502_op_0x37_3,&&_m6502_op_0x37_4,&&_m6502_op_0x37_5,&&_m6502_op_0x37_6,&&_m6502_op_0x37_7,
+        &&_m6502_op_0x38_0,&&_m6502_op_0x38_1,&&_m6502_op_0x38_2,&&_m6502_op_0x38_3,&&_m6502_op_0x38_4,&&_m6502_op_0x38_5,&&_m6502_op_0x38_6,&&_m6502_op_0x38_7,
+        &&_m6502_op_0x39_0,&&_m6502_op_0x39_1,&&_m6502_op_0x39_2,&&_m6502_op_0x39_3,&&_m6502_op_0x39_4,&&_m6502_op_0x39_5,&&_m6502_op_0x39_6,&&_m6502_op_0x39_7,
+        &&_m6502_op_0x3A_0,&&_m6502_op_0x3A_1,&&_m6502_op_0x3A_2,&&_m6502_op_0x3A_3,&&_m6502_op_0x3A_4,&&_m6502_op_0x3A_5,&&_m6502_op_0x3A_6,&&_m6502_op_0x3A_7,
+        &&_m6502_op_0x3B_0,&&_m6502_op_0x3B_1,&&_m6502_op_0x3B_2,&&_m6502_op_0x3B_3,&&_m6502_op_0x3B_4,&&_m6502_op_0x3B_5,&&_m6502_op_0x3B_6,&&_m6502_op_0x3B_7,
+        &&_m6502_op_0x3C_0,&&_m6502_op_0x3C_1,&&_m6502_op_0x3C_2,&&_m6502_op_0x3C_3,&&_m6502_op_0x3C_4,&&_m6502_op_0x3C_5,&&_m6502_op_0x3C_6,&&_m6502_op_0x3C_7,
+        &&_m6502_op_0x3D_0,&&_m6502_op_0x3D_1,&&_m6502_op_0x3D_2,&&_m6502_op_0x3D_3,&&_m6502_op_0x3D_4,&&_m6502_op_0x3D_5,&&_m6502_op_0x3D_6,&&_m6502_op_0x3D_7,
+        &&_m6502_op_0x3E_0,&&_m6502_op_0x3E_1,&&_m6502_op_0x3E_2,&&_m6502_op_0x3E_3,&&_m6502_op_0x3E_4,&&_m6502_op_0x3E_5,&&_m6502_op_0x3E_6,&&_m6502_op_0x3E_7,
+        &&_m6502_op_0x3F_0,&&_m6502_op_0x3F_1,&&_m6502_op_0x3F_2,&&_m6502_op_0x3F_3,&&_m6502_op_0x3F_4,&&_m6502_op_0x3F_5,&&_m6502_op_0x3F_6,&&_m6502_op_0x3F_7,
+        &&_m6502_op_0x40_0,&&_m6502_op_0x40_1,&&_m6502_op_0x40_2,&&_m6502_op_0x40_3,&&_m6502_op_0x40_4,&&_m6502_op_0x40_5,&&_m6502_op_0x40_6,&&_m6502_op_0x40_7,
+        &&_m6502_op_0x41_0,&&_m6502_op_0x41_1,&&_m6502_op_0x41_2,&&_m6502_op_0x41_3,&&_m6502_op_0x41_4,&&_m6502_op_0x41_5,&&_m6502_op_0x41_6,&&_m6502_op_0x41_7,
+        &&_m6502_op_0x42_0,&&_m6502_op_0x42_1,&&_m6502_op_0x42_2,&&_m6502_op_0x42_3,&&_m6502_op_0x42_4,&&_m6502_op_0x42_5,&&_m6502_op_0x42_6,&&_m6502_op_0x42_7,
+        &&_m6502_op_0x43_0,&&_m6502_op_0x43_1,&&_m6502_op_0x43_2,&&_m6502_op_0x43_3,&&_m6502_op_0x43_4,&&_m6502_op_0x43_5,&&_m6502_op_0x43_6,&&_m6502_op_0x43_7,
+        &&_m6502_op_0x44_0,&&_m6502_op_0x44_1,&&_m6502_op_0x44_2,&&_m6502_op_0x44_3,&&_m6502_op_0x44_4,&&_m6502_op_0x44_5,&&_m6502_op_0x44_6,&&_m6502_op_0x44_7,
+        &&_m6502_op_0x45_0,&&_m6502_op_0x45_1,&&_m6502_op_0x45_2,&&_m6502_op_0x45_3,&&_m6502_op_0x45_4,&&_m6502_op_0x45_5,&&_m6502_op_0x45_6,&&_m6502_op_0x45_7,
+        &&_m6502_op_0x46_0,&&_m6502_op_0x46_1,&&_m6502_op_0x46_2,&&_m6502_op_0x46_3,&&_m6502_op_0x46_4,&&_m6502_op_0x46_5,&&_m6502_op_0x46_6,&&_m6502_op_0x46_7,
+        &&_m6502_op_0x47_0,&&_m6502_op_0x47_1,&&_m6502_op_0x47_2,&&_m6502_op_0x47_3,&&_m6502_op_0x47_4,&&_m6502_op_0x47_5,&&_m6502_op_0x47_6,&&_m6502_op_0x47_7,
+        &&_m6502_op_0x48_0,&&_m6502_op_0x48_1,&&_m6502_op_0x48_2,&&_m6502_op_0x48_3,&&_m6502_op_0x48_4,&&_m6502_op_0x48_5,&&_m6502_op_0x48_6,&&_m6502_op_0x48_7,
+        &&_m6502_op_0x49_0,&&_m6502_op_0x49_1,&&_m6502_op_0x49_2,&&_m6502_op_0x49_3,&&_m6502_op_0x49_4,&&_m6502_op_0x49_5,&&_m6502_op_0x49_6,&&_m6502_op_0x49_7,
+        &&_m6502_op_0x4A_0,&&_m6502_op_0x4A_1,&&_m6502_op_0x4A_2,&&_m6502_op_0x4A_3,&&_m6502_op_0x4A_4,&&_m6502_op_0x4A_5,&&_m6502_op_0x4A_6,&&_m6502_op_0x4A_7,
+        &&_m6502_op_0x4B_0,&&_m6502_op_0x4B_1,&&_m6502_op_0x4B_2,&&_m6502_op_0x4B_3,&&_m6502_op_0x4B_4,&&_m6502_op_0x4B_5,&&_m6502_op_0x4B_6,&&_m6502_op_0x4B_7,
+        &&_m6502_op_0x4C_0,&&_m6502_op_0x4C_1,&&_m6502_op_0x4C_2,&&_m6502_op_0x4C_3,&&_m6502_op_0x4C_4,&&_m6502_op_0x4C_5,&&_m6502_op_0x4C_6,&&_m6502_op_0x4C_7,
+        &&_m6502_op_0x4D_0,&&_m6502_op_0x4D_1,&&_m6502_op_0x4D_2,&&_m6502_op_0x4D_3,&&_m6502_op_0x4D_4,&&_m6502_op_0x4D_5,&&_m6502_op_0x4D_6,&&_m6502_op_0x4D_7,
+        &&_m6502_op_0x4E_0,&&_m6502_op_0x4E_1,&&_m6502_op_0x4E_2,&&_m6502_op_0x4E_3,&&_m6502_op_0x4E_4,&&_m6502_op_0x4E_5,&&_m6502_op_0x4E_6,&&_m6502_op_0x4E_7,
+        &&_m6502_op_0x4F_0,&&_m6502_op_0x4F_1,&&_m6502_op_0x4F_2,&&_m6502_op_0x4F_3,&&_m6502_op_0x4F_4,&&_m6502_op_0x4F_5,&&_m6502_op_0x4F_6,&&_m6502_op_0x4F_7,
+        &&_m6502_op_0x50_0,&&_m6502_op_0x50_1,&&_m6502_op_0x50_2,&&_m6502_op_0x50_3,&&_m6502_op_0x50_4,&&_m6502_op_0x50_5,&&_m6502_op_0x50_6,&&_m6502_op_0x50_7,
+        &&_m6502_op_0x51_0,&&_m6502_op_0x51_1,&&_m6502_op_0x51_2,&&_m6502_op_0x51_3,&&_m6502_op_0x51_4,&&_m6502_op_0x51_5,&&_m6502_op_0x51_6,&&_m6502_op_0x51_7,
+        &&_m6502_op_0x52_0,&&_m6502_op_0x52_1,&&_m6502_op_0x52_2,&&_m6502_op_0x52_3,&&_m6502_op_0x52_4,&&_m6502_op_0x52_5,&&_m6502_op_0x52_6,&&_m6502_op_0x52_7,
+        &&_m6502_op_0x53_0,&&_m6502_op_0x53_1,&&_m6502_op_0x53_2,&&_m6502_op_0x53_3,&&_m6502_op_0x53_4,&&_m6502_op_0x53_5,&&_m6502_op_0x53_6,&&_m6502_op_0x53_7,
+        &&_m6502_op_0x54_0,&&_m6502_op_0x54_1,&&_m6502_op_0x54_2,&&_m6502_op_0x54_3,&&_m6502_op_0x54_4,&&_m6502_op_0x54_5,&&_m6502_op_0x54_6,&&_m6502_op_0x54_7,
+        &&_m6502_op_0x55_0,&&_m6502_op_0x55_1,&&_m6502_op_0x55_2,&&_m6502_op_0x55_3,&&_m6502_op_0x55_4,&&_m6502_op_0x55_5,&&_m6502_op_0x55_6,&&_m6502_op_0x55_7,
+        &&_m6502_op_0x56_0,&&_m6502_op_0x56_1,&&_m6502_op_0x56_2,&&_m6502_op_0x56_3,&&_m6502_op_0x56_4,&&_m6502_op_0x56_5,&&_m6502_op_0x56_6,&&_m6502_op_0x56_7,
+        &&_m6502_op_0x57_0,&&_m6502_op_0x57_1,&&_m6502_op_0x57_2,&&_m6502_op_0x57_3,&&_m6502_op_0x57_4,&&_m6502_op_0x57_5,&&_m6502_op_0x57_6,&&_m6502_op_0x57_7,
+        &&_m6502_op_0x58_0,&&_m6502_op_0x58_1,&&_m6502_op_0x58_2,&&_m6502_op_0x58_3,&&_m6502_op_0x58_4,&&_m6502_op_0x58_5,&&_m6502_op_0x58_6,&&_m6502_op_0x58_7,
+        &&_m6502_op_0x59_0,&&_m6502_op_0x59_1,&&_m6502_op_0x59_2,&&_m6502_op_0x59_3,&&_m6502_op_0x59_4,&&_m6502_op_0x59_5,&&_m6502_op_0x59_6,&&_m6502_op_0x59_7,
+        &&_m6502_op_0x5A_0,&&_m6502_op_0x5A_1,&&_m6502_op_0x5A_2,&&_m6502_op_0x5A_3,&&_m6502_op_0x5A_4,&&_m6502_op_0x5A_5,&&_m6502_op_0x5A_6,&&_m6502_op_0x5A_7,
+        &&_m6502_op_0x5B_0,&&_m6502_op_0x5B_1,&&_m6502_op_0x5B_2,&&_m6502_op_0x5B_3,&&_m6502_op_0x5B_4,&&_m6502_op_0x5B_5,&&_m6502_op_0x5B_6,&&_m6502_op_0x5B_7,
+        &&_m6502_op_0x5C_0,&&_m6502_op_0x5C_1,&&_m6502_op_0x5C_2,&&_m6502_op_0x5C_3,&&_m6502_op_0x5C_4,&&_m6502_op_0x5C_5,&&_m6502_op_0x5C_6,&&_m6502_op_0x5C_7,
+        &&_m6502_op_0x5D_0,&&_m6502_op_0x5D_1,&&_m6502_op_0x5D_2,&&_m6502_op_0x5D_3,&&_m6502_op_0x5D_4,&&_m6502_op_0x5D_5,&&_m6502_op_0x5D_6,&&_m6502_op_0x5D_7,
+        &&_m6502_op_0x5E_0,&&_m6502_op_0x5E_1,&&_m6502_op_0x5E_2,&&_m6502_op_0x5E_3,&&_m6502_op_0x5E_4,&&_m6502_op_0x5E_5,&&_m6502_op_0x5E_6,&&_m6502_op_0x5E_7,
+        &&_m6502_op_0x5F_0,&&_m6502_op_0x5F_1,&&_m6502_op_0x5F_2,&&_m6502_op_0x5F_3,&&_m6502_op_0x5F_4,&&_m6502_op_0x5F_5,&&_m6502_op_0x5F_6,&&_m6502_op_0x5F_7,
+        &&_m6502_op_0x60_0,&&_m6502_op_0x60_1,&&_m6502_op_0x60_2,&&_m6502_op_0x60_3,&&_m6502_op_0x60_4,&&_m6502_op_0x60_5,&&_m6502_op_0x60_6,&&_m6502_op_0x60_7,
+        &&_m6502_op_0x61_0,&&_m6502_op_0x61_1,&&_m6502_op_0x61_2,&&_m6502_op_0x61_3,&&_m6502_op_0x61_4,&&_m6502_op_0x61_5,&&_m6502_op_0x61_6,&&_m6502_op_0x61_7,
+        &&_m6502_op_0x62_0,&&_m6502_op_0x62_1,&&_m6502_op_0x62_2,&&_m6502_op_0x62_3,&&_m6502_op_0x62_4,&&_m6502_op_0x62_5,&&_m6502_op_0x62_6,&&_m6502_op_0x62_7,
+        &&_m6502_op_0x63_0,&&_m6502_op_0x63_1,&&_m6502_op_0x63_2,&&_m6502_op_0x63_3,&&_m6502_op_0x63_4,&&_m6502_op_0x63_5,&&_m6502_op_0x63_6,&&_m6502_op_0x63_7,
+        &&_m6502_op_0x64_0,&&_m6502_op_0x64_1,&&_m6502_op_0x64_2,&&_m6502_op_0x64_3,&&_m6502_op_0x64_4,&&_m6502_op_0x64_5,&&_m6502_op_0x64_6,&&_m6502_op_0x64_7,
+        &&_m6502_op_0x65_0,&&_m6502_op_0x65_1,&&_m6502_op_0x65_2,&&_m6502_op_0x65_3,&&_m6502_op_0x65_4,&&_m6502_op_0x65_5,&&_m6502_op_0x65_6,&&_m6502_op_0x65_7,
+        &&_m6502_op_0x66_0,&&_m6502_op_0x66_1,&&_m6502_op_0x66_2,&&_m6502_op_0x66_3,&&_m6502_op_0x66_4,&&_m6502_op_0x66_5,&&_m6502_op_0x66_6,&&_m6502_op_0x66_7,
+        &&_m6502_op_0x67_0,&&_m6502_op_0x67_1,&&_m6502_op_0x67_2,&&_m6502_op_0x67_3,&&_m6502_op_0x67_4,&&_m6502_op_0x67_5,&&_m6502_op_0x67_6,&&_m6502_op_0x67_7,
+        &&_m6502_op_0x68_0,&&_m6502_op_0x68_1,&&_m6502_op_0x68_2,&&_m6502_op_0x68_3,&&_m6502_op_0x68_4,&&_m6502_op_0x68_5,&&_m6502_op_0x68_6,&&_m6502_op_0x68_7,
+        &&_m6502_op_0x69_0,&&_m6502_op_0x69_1,&&_m6502_op_0x69_2,&&_m6502_op_0x69_3,&&_m6502_op_0x69_4,&&_m6502_op_0x69_5,&&_m6502_op_0x69_6,&&_m6502_op_0x69_7,
+        &&_m6502_op_0x6A_0,&&_m6502_op_0x6A_1,&&_m6502_op_0x6A_2,&&_m6502_op_0x6A_3,&&_m6502_op_0x6A_4,&&_m6502_op_0x6A_5,&&_m6502_op_0x6A_6,&&_m6502_op_0x6A_7,
+        &&_m6502_op_0x6B_0,&&_m6502_op_0x6B_1,&&_m6502_op_0x6B_2,&&_m6502_op_0x6B_3,&&_m6502_op_0x6B_4,&&_m6502_op_0x6B_5,&&_m6502_op_0x6B_6,&&_m6502_op_0x6B_7,
+        &&_m6502_op_0x6C_0,&&_m6502_op_0x6C_1,&&_m6502_op_0x6C_2,&&_m6502_op_0x6C_3,&&_m6502_op_0x6C_4,&&_m6502_op_0x6C_5,&&_m6502_op_0x6C_6,&&_m6502_op_0x6C_7,
+        &&_m6502_op_0x6D_0,&&_m6502_op_0x6D_1,&&_m6502_op_0x6D_2,&&_m6502_op_0x6D_3,&&_m6502_op_0x6D_4,&&_m6502_op_0x6D_5,&&_m6502_op_0x6D_6,&&_m6502_op_0x6D_7,
+        &&_m6502_op_0x6E_0,&&_m6502_op_0x6E_1,&&_m6502_op_0x6E_2,&&_m6502_op_0x6E_3,&&_m6502_op_0x6E_4,&&_m6502_op_0x6E_5,&&_m6502_op_0x6E_6,&&_m6502_op_0x6E_7,
+        &&_m6502_op_0x6F_0,&&_m6502_op_0x6F_1,&&_m6502_op_0x6F_2,&&_m6502_op_0x6F_3,&&_m6502_op_0x6F_4,&&_m6502_op_0x6F_5,&&_m6502_op_0x6F_6,&&_m6502_op_0x6F_7,
+        &&_m6502_op_0x70_0,&&_m6502_op_0x70_1,&&_m6502_op_0x70_2,&&_m6502_op_0x70_3,&&_m6502_op_0x70_4,&&_m6502_op_0x70_5,&&_m6502_op_0x70_6,&&_m6502_op_0x70_7,
+        &&_m6502_op_0x71_0,&&_m6502_op_0x71_1,&&_m6502_op_0x71_2,&&_m6502_op_0x71_3,&&_m6502_op_0x71_4,&&_m6502_op_0x71_5,&&_m6502_op_0x71_6,&&_m6502_op_0x71_7,
+        &&_m6502_op_0x72_0,&&_m6502_op_0x72_1,&&_m6502_op_0x72_2,&&_m6502_op_0x72_3,&&_m6502_op_0x72_4,&&_m6502_op_0x72_5,&&_m6502_op_0x72_6,&&_m6502_op_0x72_7,
+        &&_m6502_op_0x73_0,&&_m6502_op_0x73_1,&&_m6502_op_0x73_2,&&_m6502_op_0x73_3,&&_m6502_op_0x73_4,&&_m6502_op_0x73_5,&&_m6502_op_0x73_6,&&_m6502_op_0x73_7,
+        &&_m6502_op_0x74_0,&&_m6502_op_0x74_1,&&_m6502_op_0x74_2,&&_m6502_op_0x74_3,&&_m6502_op_0x74_4,&&_m6502_op_0x74_5,&&_m6502_op_0x74_6,&&_m6502_op_0x74_7,
+        &&_m6502_op_0x75_0,&&_m6502_op_0x75_1,&&_m6502_op_0x75_2,&&_m6502_op_0x75_3,&&_m6502_op_0x75_4,&&_m6502_op_0x75_5,&&_m6502_op_0x75_6,&&_m6502_op_0x75_7,
+        &&_m6502_op_0x76_0,&&_m6502_op_0x76_1,&&_m6502_op_0x76_2,&&_m6502_op_0x76_3,&&_m6502_op_0x76_4,&&_m6502_op_0x76_5,&&_m6502_op_0x76_6,&&_m6502_op_0x76_7,
+        &&_m6502_op_0x77_0,&&_m6502_op_0x77_1,&&_m6502_op_0x77_2,&&_m6502_op_0x77_3,&&_m6502_op_0x77_4,&&_m6502_op_0x77_5,&&_m6502_op_0x77_6,&&_m6502_op_0x77_7,
+        &&_m6502_op_0x78_0,&&_m6502_op_0x78_1,&&_m6502_op_0x78_2,&&_m6502_op_0x78_3,&&_m6502_op_0x78_4,&&_m6502_op_0x78_5,&&_m6502_op_0x78_6,&&_m6502_op_0x78_7,
+        &&_m6502_op_0x79_0,&&_m6502_op_0x79_1,&&_m6502_op_0x79_2,&&_m6502_op_0x79_3,&&_m6502_op_0x79_4,&&_m6502_op_0x79_5,&&_m6502_op_0x79_6,&&_m6502_op_0x79_7,
+        &&_m6502_op_0x7A_0,&&_m6502_op_0x7A_1,&&_m6502_op_0x7A_2,&&_m6502_op_0x7A_3,&&_m6502_op_0x7A_4,&&_m6502_op_0x7A_5,&&_m6502_op_0x7A_6,&&_m6502_op_0x7A_7,
+        &&_m6502_op_0x7B_0,&&_m6502_op_0x7B_1,&&_m6502_op_0x7B_2,&&_m6502_op_0x7B_3,&&_m6502_op_0x7B_4,&&_m6502_op_0x7B_5,&&_m6502_op_0x7B_6,&&_m6502_op_0x7B_7,
+        &&_m6502_op_0x7C_0,&&_m6502_op_0x7C_1,&&_m6502_op_0x7C_2,&&_m6502_op_0x7C_3,&&_m6502_op_0x7C_4,&&_m6502_op_0x7C_5,&&_m6502_op_0x7C_6,&&_m6502_op_0x7C_7,
+        &&_m6502_op_0x7D_0,&&_m6502_op_0x7D_1,&&_m6502_op_0x7D_2,&&_m6502_op_0x7D_3,&&_m6502_op_0x7D_4,&&_m6502_op_0x7D_5,&&_m6502_op_0x7D_6,&&_m6502_op_0x7D_7,
+        &&_m6502_op_0x7E_0,&&_m6502_op_0x7E_1,&&_m6502_op_0x7E_2,&&_m6502_op_0x7E_3,&&_m6502_op_0x7E_4,&&_m6502_op_0x7E_5,&&_m6502_op_0x7E_6,&&_m6502_op_0x7E_7,
+        &&_m6502_op_0x7F_0,&&_m6502_op_0x7F_1,&&_m6502_op_0x7F_2,&&_m6502_op_0x7F_3,&&_m6502_op_0x7F_4,&&_m6502_op_0x7F_5,&&_m6502_op_0x7F_6,&&_m6502_op_0x7F_7,
+        &&_m6502_op_0x80_0,&&_m6502_op_0x80_1,&&_m6502_op_0x80_2,&&_m6502_op_0x80_3,&&_m6502_op_0x80_4,&&_m6502_op_0x80_5,&&_m6502_op_0x80_6,&&_m6502_op_0x80_7,
+        &&_m6502_op_0x81_0,&&_m6502_op_0x81_1,&&_m6502_op_0x81_2,&&_m6502_op_0x81_3,&&_m6502_op_0x81_4,&&_m6502_op_0x81_5,&&_m6502_op_0x81_6,&&_m6502_op_0x81_7,
+        &&_m6502_op_0x82_0,&&_m6502_op_0x82_1,&&_m6502_op_0x82_2,&&_m6502_op_0x82_3,&&_m6502_op_0x82_4,&&_m6502_op_0x82_5,&&_m6502_op_0x82_6,&&_m6502_op_0x82_7,
+        &&_m6502_op_0x83_0,&&_m6502_op_0x83_1,&&_m6502_op_0x83_2,&&_m6502_op_0x83_3,&&_m6502_op_0x83_4,&&_m6502_op_0x83_5,&&_m6502_op_0x83_6,&&_m6502_op_0x83_7,
+        &&_m6502_op_0x84_0,&&_m6502_op_0x84_1,&&_m6502_op_0x84_2,&&_m6502_op_0x84_3,&&_m6502_op_0x84_4,&&_m6502_op_0x84_5,&&_m6502_op_0x84_6,&&_m6502_op_0x84_7,
+        &&_m6502_op_0x85_0,&&_m6502_op_0x85_1,&&_m6502_op_0x85_2,&&_m6502_op_0x85_3,&&_m6502_op_0x85_4,&&_m6502_op_0x85_5,&&_m6502_op_0x85_6,&&_m6502_op_0x85_7,
+        &&_m6502_op_0x86_0,&&_m6502_op_0x86_1,&&_m6502_op_0x86_2,&&_m6502_op_0x86_3,&&_m6502_op_0x86_4,&&_m6502_op_0x86_5,&&_m6502_op_0x86_6,&&_m6502_op_0x86_7,
+        &&_m6502_op_0x87_0,&&_m6502_op_0x87_1,&&_m6502_op_0x87_2,&&_m6502_op_0x87_3,&&_m6502_op_0x87_4,&&_m6502_op_0x87_5,&&_m6502_op_0x87_6,&&_m6502_op_0x87_7,
+        &&_m6502_op_0x88_0,&&_m6502_op_0x88_1,&&_m6502_op_0x88_2,&&_m6502_op_0x88_3,&&_m6502_op_0x88_4,&&_m6502_op_0x88_5,&&_m6502_op_0x88_6,&&_m6502_op_0x88_7,
+        &&_m6502_op_0x89_0,&&_m6502_op_0x89_1,&&_m6502_op_0x89_2,&&_m6502_op_0x89_3,&&_m6502_op_0x89_4,&&_m6502_op_0x89_5,&&_m6502_op_0x89_6,&&_m6502_op_0x89_7,
+        &&_m6502_op_0x8A_0,&&_m6502_op_0x8A_1,&&_m6502_op_0x8A_2,&&_m6502_op_0x8A_3,&&_m6502_op_0x8A_4,&&_m6502_op_0x8A_5,&&_m6502_op_0x8A_6,&&_m6502_op_0x8A_7,
+        &&_m6502_op_0x8B_0,&&_m6502_op_0x8B_1,&&_m6502_op_0x8B_2,&&_m6502_op_0x8B_3,&&_m6502_op_0x8B_4,&&_m6502_op_0x8B_5,&&_m6502_op_0x8B_6,&&_m6502_op_0x8B_7,
+        &&_m6502_op_0x8C_0,&&_m6502_op_0x8C_1,&&_m6502_op_0x8C_2,&&_m6502_op_0x8C_3,&&_m6502_op_0x8C_4,&&_m6502_op_0x8C_5,&&_m6502_op_0x8C_6,&&_m6502_op_0x8C_7,
+        &&_m6502_op_0x8D_0,&&_m6502_op_0x8D_1,&&_m6502_op_0x8D_2,&&_m6502_op_0x8D_3,&&_m6502_op_0x8D_4,&&_m6502_op_0x8D_5,&&_m6502_op_0x8D_6,&&_m6502_op_0x8D_7,
+        &&_m6502_op_0x8E_0,&&_m6502_op_0x8E_1,&&_m6502_op_0x8E_2,&&_m6502_op_0x8E_3,&&_m6502_op_0x8E_4,&&_m6502_op_0x8E_5,&&_m6502_op_0x8E_6,&&_m6502_op_0x8E_7,
+        &&_m6502_op_0x8F_0,&&_m6502_op_0x8F_1,&&_m6502_op_0x8F_2,&&_m6502_op_0x8F_3,&&_m6502_op_0x8F_4,&&_m6502_op_0x8F_5,&&_m6502_op_0x8F_6,&&_m6502_op_0x8F_7,
+        &&_m6502_op_0x90_0,&&_m6502_op_0x90_1,&&_m6502_op_0x90_2,&&_m6502_op_0x90_3,&&_m6502_op_0x90_4,&&_m6502_op_0x90_5,&&_m6502_op_0x90_6,&&_m6502_op_0x90_7,
+        &&_m6502_op_0x91_0,&&_m6502_op_0x91_1,&&_m6502_op_0x91_2,&&_m6502_op_0x91_3,&&_m6502_op_0x91_4,&&_m6502_op_0x91_5,&&_m6502_op_0x91_6,&&_m6502_op_0x91_7,
+        &&_m6502_op_0x92_0,&&_m6502_op_0x92_1,&&_m6502_op_0x92_2,&&_m6502_op_0x92_3,&&_m6502_op_0x92_4,&&_m6502_op_0x92_5,&&_m6502_op_0x92_6,&&_m6502_op_0x92_7,
+        &&_m6502_op_0x93_0,&&_m6502_op_0x93_1,&&_m6502_op_0x93_2,&&_m6502_op_0x93_3,&&_m6502_op_0x93_4,&&_m6502_op_0x93_5,&&_m6502_op_0x93_6,&&_m6502_op_0x93_7,
+        &&_m6502_op_0x94_0,&&_m6502_op_0x94_1,&&_m6502_op_0x94_2,&&_m6502_op_0x94_3,&&_m6502_op_0x94_4,&&_m6502_op_0x94_5,&&_m6502_op_0x94_6,&&_m6502_op_0x94_7,
+        &&_m6502_op_0x95_0,&&_m6502_op_0x95_1,&&_m6502_op_0x95_2,&&_m6502_op_0x95_3,&&_m6502_op_0x95_4,&&_m6502_op_0x95_5,&&_m6502_op_0x95_6,&&_m6502_op_0x95_7,
+        &&_m6502_op_0x96_0,&&_m6502_op_0x96_1,&&_m6502_op_0x96_2,&&_m6502_op_0x96_3,&&_m6502_op_0x96_4,&&_m6502_op_0x96_5,&&_m6502_op_0x96_6,&&_m6502_op_0x96_7,
+        &&_m6502_op_0x97_0,&&_m6502_op_0x97_1,&&_m6502_op_0x97_2,&&_m6502_op_0x97_3,&&_m6502_op_0x97_4,&&_m6502_op_0x97_5,&&_m6502_op_0x97_6,&&_m6502_op_0x97_7,
+        &&_m6502_op_0x98_0,&&_m6502_op_0x98_1,&&_m6502_op_0x98_2,&&_m6502_op_0x98_3,&&_m6502_op_0x98_4,&&_m6502_op_0x98_5,&&_m6502_op_0x98_6,&&_m6502_op_0x98_7,
+        &&_m6502_op_0x99_0,&&_m6502_op_0x99_1,&&_m6502_op_0x99_2,&&_m6502_op_0x99_3,&&_m6502_op_0x99_4,&&_m6502_op_0x99_5,&&_m6502_op_0x99_6,&&_m6502_op_0x99_7,
+        &&_m6502_op_0x9A_0,&&_m6502_op_0x9A_1,&&_m6502_op_0x9A_2,&&_m6502_op_0x9A_3,&&_m6502_op_0x9A_4,&&_m6502_op_0x9A_5,&&_m6502_op_0x9A_6,&&_m6502_op_0x9A_7,
+        &&_m6502_op_0x9B_0,&&_m6502_op_0x9B_1,&&_m6502_op_0x9B_2,&&_m6502_op_0x9B_3,&&_m6502_op_0x9B_4,&&_m6502_op_0x9B_5,&&_m6502_op_0x9B_6,&&_m6502_op_0x9B_7,
+        &&_m6502_op_0x9C_0,&&_m6502_op_0x9C_1,&&_m6502_op_0x9C_2,&&_m6502_op_0x9C_3,&&_m6502_op_0x9C_4,&&_m6502_op_0x9C_5,&&_m6502_op_0x9C_6,&&_m6502_op_0x9C_7,
+        &&_m6502_op_0x9D_0,&&_m6502_op_0x9D_1,&&_m6502_op_0x9D_2,&&_m6502_op_0x9D_3,&&_m6502_op_0x9D_4,&&_m6502_op_0x9D_5,&&_m6502_op_0x9D_6,&&_m6502_op_0x9D_7,
+        &&_m6502_op_0x9E_0,&&_m6502_op_0x9E_1,&&_m6502_op_0x9E_2,&&_m6502_op_0x9E_3,&&_m6502_op_0x9E_4,&&_m6502_op_0x9E_5,&&_m6502_op_0x9E_6,&&_m6502_op_0x9E_7,
+        &&_m6502_op_0x9F_0,&&_m6502_op_0x9F_1,&&_m6502_op_0x9F_2,&&_m6502_op_0x9F_3,&&_m6502_op_0x9F_4,&&_m6502_op_0x9F_5,&&_m6502_op_0x9F_6,&&_m6502_op_0x9F_7,
+        &&_m6502_op_0xA0_0,&&_m6502_op_0xA0_1,&&_m6502_op_0xA0_2,&&_m6502_op_0xA0_3,&&_m6502_op_0xA0_4,&&_m6502_op_0xA0_5,&&_m6502_op_0xA0_6,&&_m6502_op_0xA0_7,
+        &&_m6502_op_0xA1_0,&&_m6502_op_0xA1_1,&&_m6502_op_0xA1_2,&&_m6502_op_0xA1_3,&&_m6502_op_0xA1_4,&&_m6502_op_0xA1_5,&&_m6502_op_0xA1_6,&&_m6502_op_0xA1_7,
+        &&_m6502_op_0xA2_0,&&_m6502_op_0xA2_1,&&_m6502_op_0xA2_2,&&_m6502_op_0xA2_3,&&_m6502_op_0xA2_4,&&_m6502_op_0xA2_5,&&_m6502_op_0xA2_6,&&_m6502_op_0xA2_7,
+        &&_m6502_op_0xA3_0,&&_m6502_op_0xA3_1,&&_m6502_op_0xA3_2,&&_m6502_op_0xA3_3,&&_m6502_op_0xA3_4,&&_m6502_op_0xA3_5,&&_m6502_op_0xA3_6,&&_m6502_op_0xA3_7,
+        &&_m6502_op_0xA4_0,&&_m6502_op_0xA4_1,&&_m6502_op_0xA4_2,&&_m6502_op_0xA4_3,&&_m6502_op_0xA4_4,&&_m6502_op_0xA4_5,&&_m6502_op_0xA4_6,&&_m6502_op_0xA4_7,
+        &&_m6502_op_0xA5_0,&&_m6502_op_0xA5_1,&&_m6502_op_0xA5_2,&&_m6502_op_0xA5_3,&&_m6502_op_0xA5_4,&&_m6502_op_0xA5_5,&&_m6502_op_0xA5_6,&&_m6502_op_0xA5_7,
+        &&_m6502_op_0xA6_0,&&_m6502_op_0xA6_1,&&_m6502_op_0xA6_2,&&_m6502_op_0xA6_3,&&_m6502_op_0xA6_4,&&_m6502_op_0xA6_5,&&_m6502_op_0xA6_6,&&_m6502_op_0xA6_7,
+        &&_m6502_op_0xA7_0,&&_m6502_op_0xA7_1,&&_m6502_op_0xA7_2,&&_m6502_op_0xA7_3,&&_m6502_op_0xA7_4,&&_m6502_op_0xA7_5,&&_m6502_op_0xA7_6,&&_m6502_op_0xA7_7,
+        &&_m6502_op_0xA8_0,&&_m6502_op_0xA8_1,&&_m6502_op_0xA8_2,&&_m6502_op_0xA8_3,&&_m6502_op_0xA8_4,&&_m6502_op_0xA8_5,&&_m6502_op_0xA8_6,&&_m6502_op_0xA8_7,
+        &&_m6502_op_0xA9_0,&&_m6502_op_0xA9_1,&&_m6502_op_0xA9_2,&&_m6502_op_0xA9_3,&&_m6502_op_0xA9_4,&&_m6502_op_0xA9_5,&&_m6502_op_0xA9_6,&&_m6502_op_0xA9_7,
+        &&_m6502_op_0xAA_0,&&_m6502_op_0xAA_1,&&_m6502_op_0xAA_2,&&_m6502_op_0xAA_3,&&_m6502_op_0xAA_4,&&_m6502_op_0xAA_5,&&_m6502_op_0xAA_6,&&_m6502_op_0xAA_7,
+        &&_m6502_op_0xAB_0,&&_m6502_op_0xAB_1,&&_m6502_op_0xAB_2,&&_m6502_op_0xAB_3,&&_m6502_op_0xAB_4,&&_m6502_op_0xAB_5,&&_m6502_op_0xAB_6,&&_m6502_op_0xAB_7,
+        &&_m6502_op_0xAC_0,&&_m6502_op_0xAC_1,&&_m6502_op_0xAC_2,&&_m6502_op_0xAC_3,&&_m6502_op_0xAC_4,&&_m6502_op_0xAC_5,&&_m6502_op_0xAC_6,&&_m6502_op_0xAC_7,
+        &&_m6502_op_0xAD_0,&&_m6502_op_0xAD_1,&&_m6502_op_0xAD_2,&&_m6502_op_0xAD_3,&&_m6502_op_0xAD_4,&&_m6502_op_0xAD_5,&&_m6502_op_0xAD_6,&&_m6502_op_0xAD_7,
+        &&_m6502_op_0xAE_0,&&_m6502_op_0xAE_1,&&_m6502_op_0xAE_2,&&_m6502_op_0xAE_3,&&_m6502_op_0xAE_4,&&_m6502_op_0xAE_5,&&_m6502_op_0xAE_6,&&_m6502_op_0xAE_7,
+        &&_m6502_op_0xAF_0,&&_m6502_op_0xAF_1,&&_m6502_op_0xAF_2,&&_m6502_op_0xAF_3,&&_m6502_op_0xAF_4,&&_m6502_op_0xAF_5,&&_m6502_op_0xAF_6,&&_m6502_op_0xAF_7,
+        &&_m6502_op_0xB0_0,&&_m6502_op_0xB0_1,&&_m6502_op_0xB0_2,&&_m6502_op_0xB0_3,&&_m6502_op_0xB0_4,&&_m6502_op_0xB0_5,&&_m6502_op_0xB0_6,&&_m6502_op_0xB0_7,
+        &&_m6502_op_0xB1_0,&&_m6502_op_0xB1_1,&&_m6502_op_0xB1_2,&&_m6502_op_0xB1_3,&&_m6502_op_0xB1_4,&&_m6502_op_0xB1_5,&&_m6502_op_0xB1_6,&&_m6502_op_0xB1_7,
+        &&_m6502_op_0xB2_0,&&_m6502_op_0xB2_1,&&_m6502_op_0xB2_2,&&_m6502_op_0xB2_3,&&_m6502_op_0xB2_4,&&_m6502_op_0xB2_5,&&_m6502_op_0xB2_6,&&_m6502_op_0xB2_7,
+        &&_m6502_op_0xB3_0,&&_m6502_op_0xB3_1,&&_m6502_op_0xB3_2,&&_m6502_op_0xB3_3,&&_m6502_op_0xB3_4,&&_m6502_op_0xB3_5,&&_m6502_op_0xB3_6,&&_m6502_op_0xB3_7,
+        &&_m6502_op_0xB4_0,&&_m6502_op_0xB4_1,&&_m6502_op_0xB4_2,&&_m6502_op_0xB4_3,&&_m6502_op_0xB4_4,&&_m6502_op_0xB4_5,&&_m6502_op_0xB4_6,&&_m6502_op_0xB4_7,
+        &&_m6502_op_0xB5_0,&&_m6502_op_0xB5_1,&&_m6502_op_0xB5_2,&&_m6502_op_0xB5_3,&&_m6502_op_0xB5_4,&&_m6502_op_0xB5_5,&&_m6502_op_0xB5_6,&&_m6502_op_0xB5_7,
+        &&_m6502_op_0xB6_0,&&_m6502_op_0xB6_1,&&_m6502_op_0xB6_2,&&_m6502_op_0xB6_3,&&_m6502_op_0xB6_4,&&_m6502_op_0xB6_5,&&_m6502_op_0xB6_6,&&_m6502_op_0xB6_7,
+        &&_m6502_op_0xB7_0,&&_m6502_op_0xB7_1,&&_m6502_op_0xB7_2,&&_m6502_op_0xB7_3,&&_m6502_op_0xB7_4,&&_m6502_op_0xB7_5,&&_m6502_op_0xB7_6,&&_m6502_op_0xB7_7,
+        &&_m6502_op_0xB8_0,&&_m6502_op_0xB8_1,&&_m6502_op_0xB8_2,&&_m6502_op_0xB8_3,&&_m6502_op_0xB8_4,&&_m6502_op_0xB8_5,&&_m6502_op_0xB8_6,&&_m6502_op_0xB8_7,
+        &&_m6502_op_0xB9_0,&&_m6502_op_0xB9_1,&&_m6502_op_0xB9_2,&&_m6502_op_0xB9_3,&&_m6502_op_0xB9_4,&&_m6502_op_0xB9_5,&&_m6502_op_0xB9_6,&&_m6502_op_0xB9_7,
+        &&_m6502_op_0xBA_0,&&_m6502_op_0xBA_1,&&_m6502_op_0xBA_2,&&_m6502_op_0xBA_3,&&_m6502_op_0xBA_4,&&_m6502_op_0xBA_5,&&_m6502_op_0xBA_6,&&_m6502_op_0xBA_7,
+        &&_m6502_op_0xBB_0,&&_m6502_op_0xBB_1,&&_m6502_op_0xBB_2,&&_m6502_op_0xBB_3,&&_m6502_op_0xBB_4,&&_m6502_op_0xBB_5,&&_m6502_op_0xBB_6,&&_m6502_op_0xBB_7,
+        &&_m6502_op_0xBC_0,&&_m6502_op_0xBC_1,&&_m6502_op_0xBC_2,&&_m6502_op_0xBC_3,&&_m6502_op_0xBC_4,&&_m6502_op_0xBC_5,&&_m6502_op_0xBC_6,&&_m6502_op_0xBC_7,
+        &&_m6502_op_0xBD_0,&&_m6502_op_0xBD_1,&&_m6502_op_0xBD_2,&&_m6502_op_0xBD_3,&&_m6502_op_0xBD_4,&&_m6502_op_0xBD_5,&&_m6502_op_0xBD_6,&&_m6502_op_0xBD_7,
+        &&_m6502_op_0xBE_0,&&_m6502_op_0xBE_1,&&_m6502_op_0xBE_2,&&_m6502_op_0xBE_3,&&_m6502_op_0xBE_4,&&_m6502_op_0xBE_5,&&_m6502_op_0xBE_6,&&_m6502_op_0xBE_7,
+        &&_m6502_op_0xBF_0,&&_m6502_op_0xBF_1,&&_m6502_op_0xBF_2,&&_m6502_op_0xBF_3,&&_m6502_op_0xBF_4,&&_m6502_op_0xBF_5,&&_m6502_op_0xBF_6,&&_m6502_op_0xBF_7,
+        &&_m6502_op_0xC0_0,&&_m6502_op_0xC0_1,&&_m6502_op_0xC0_2,&&_m6502_op_0xC0_3,&&_m6502_op_0xC0_4,&&_m6502_op_0xC0_5,&&_m6502_op_0xC0_6,&&_m6502_op_0xC0_7,
+        &&_m6502_op_0xC1_0,&&_m6502_op_0xC1_1,&&_m6502_op_0xC1_2,&&_m6502_op_0xC1_3,&&_m6502_op_0xC1_4,&&_m6502_op_0xC1_5,&&_m6502_op_0xC1_6,&&_m6502_op_0xC1_7,
+        &&_m6502_op_0xC2_0,&&_m6502_op_0xC2_1,&&_m6502_op_0xC2_2,&&_m6502_op_0xC2_3,&&_m6502_op_0xC2_4,&&_m6502_op_0xC2_5,&&_m6502_op_0xC2_6,&&_m6502_op_0xC2_7,
+        &&_m6502_op_0xC3_0,&&_m6502_op_0xC3_1,&&_m6502_op_0xC3_2,&&_m6502_op_0xC3_3,&&_m6502_op_0xC3_4,&&_m6502_op_0xC3_5,&&_m6502_op_0xC3_6,&&_m6502_op_0xC3_7,
+        &&_m6502_op_0xC4_0,&&_m6502_op_0xC4_1,&&_m6502_op_0xC4_2,&&_m6502_op_0xC4_3,&&_m6502_op_0xC4_4,&&_m6502_op_0xC4_5,&&_m6502_op_0xC4_6,&&_m6502_op_0xC4_7,
+        &&_m6502_op_0xC5_0,&&_m6502_op_0xC5_1,&&_m6502_op_0xC5_2,&&_m6502_op_0xC5_3,&&_m6502_op_0xC5_4,&&_m6502_op_0xC5_5,&&_m6502_op_0xC5_6,&&_m6502_op_0xC5_7,
+        &&_m6502_op_0xC6_0,&&_m6502_op_0xC6_1,&&_m6502_op_0xC6_2,&&_m6502_op_0xC6_3,&&_m6502_op_0xC6_4,&&_m6502_op_0xC6_5,&&_m6502_op_0xC6_6,&&_m6502_op_0xC6_7,
+        &&_m6502_op_0xC7_0,&&_m6502_op_0xC7_1,&&_m6502_op_0xC7_2,&&_m6502_op_0xC7_3,&&_m6502_op_0xC7_4,&&_m6502_op_0xC7_5,&&_m6502_op_0xC7_6,&&_m6502_op_0xC7_7,
+        &&_m6502_op_0xC8_0,&&_m6502_op_0xC8_1,&&_m6502_op_0xC8_2,&&_m6502_op_0xC8_3,&&_m6502_op_0xC8_4,&&_m6502_op_0xC8_5,&&_m6502_op_0xC8_6,&&_m6502_op_0xC8_7,
+        &&_m6502_op_0xC9_0,&&_m6502_op_0xC9_1,&&_m6502_op_0xC9_2,&&_m6502_op_0xC9_3,&&_m6502_op_0xC9_4,&&_m6502_op_0xC9_5,&&_m6502_op_0xC9_6,&&_m6502_op_0xC9_7,
+        &&_m6502_op_0xCA_0,&&_m6502_op_0xCA_1,&&_m6502_op_0xCA_2,&&_m6502_op_0xCA_3,&&_m6502_op_0xCA_4,&&_m6502_op_0xCA_5,&&_m6502_op_0xCA_6,&&_m6502_op_0xCA_7,
+        &&_m6502_op_0xCB_0,&&_m6502_op_0xCB_1,&&_m6502_op_0xCB_2,&&_m6502_op_0xCB_3,&&_m6502_op_0xCB_4,&&_m6502_op_0xCB_5,&&_m6502_op_0xCB_6,&&_m6502_op_0xCB_7,
+        &&_m6502_op_0xCC_0,&&_m6502_op_0xCC_1,&&_m6502_op_0xCC_2,&&_m6502_op_0xCC_3,&&_m6502_op_0xCC_4,&&_m6502_op_0xCC_5,&&_m6502_op_0xCC_6,&&_m6502_op_0xCC_7,
+        &&_m6502_op_0xCD_0,&&_m6502_op_0xCD_1,&&_m6502_op_0xCD_2,&&_m6502_op_0xCD_3,&&_m6502_op_0xCD_4,&&_m6502_op_0xCD_5,&&_m6502_op_0xCD_6,&&_m6502_op_0xCD_7,
+        &&_m6502_op_0xCE_0,&&_m6502_op_0xCE_1,&&_m6502_op_0xCE_2,&&_m6502_op_0xCE_3,&&_m6502_op_0xCE_4,&&_m6502_op_0xCE_5,&&_m6502_op_0xCE_6,&&_m6502_op_0xCE_7,
+        &&_m6502_op_0xCF_0,&&_m6502_op_0xCF_1,&&_m6502_op_0xCF_2,&&_m6502_op_0xCF_3,&&_m6502_op_0xCF_4,&&_m6502_op_0xCF_5,&&_m6502_op_0xCF_6,&&_m6502_op_0xCF_7,
+        &&_m6502_op_0xD0_0,&&_m6502_op_0xD0_1,&&_m6502_op_0xD0_2,&&_m6502_op_0xD0_3,&&_m6502_op_0xD0_4,&&_m6502_op_0xD0_5,&&_m6502_op_0xD0_6,&&_m6502_op_0xD0_7,
+        &&_m6502_op_0xD1_0,&&_m6502_op_0xD1_1,&&_m6502_op_0xD1_2,&&_m6502_op_0xD1_3,&&_m6502_op_0xD1_4,&&_m6502_op_0xD1_5,&&_m6502_op_0xD1_6,&&_m6502_op_0xD1_7,
+        &&_m6502_op_0xD2_0,&&_m6502_op_0xD2_1,&&_m6502_op_0xD2_2,&&_m6502_op_0xD2_3,&&_m6502_op_0xD2_4,&&_m6502_op_0xD2_5,&&_m6502_op_0xD2_6,&&_m6502_op_0xD2_7,
+        &&_m6502_op_0xD3_0,&&_m6502_op_0xD3_1,&&_m6502_op_0xD3_2,&&_m6502_op_0xD3_3,&&_m6502_op_0xD3_4,&&_m6502_op_0xD3_5,&&_m6502_op_0xD3_6,&&_m6502_op_0xD3_7,
+        &&_m6502_op_0xD4_0,&&_m6502_op_0xD4_1,&&_m6502_op_0xD4_2,&&_m6502_op_0xD4_3,&&_m6502_op_0xD4_4,&&_m6502_op_0xD4_5,&&_m6502_op_0xD4_6,&&_m6502_op_0xD4_7,
+        &&_m6502_op_0xD5_0,&&_m6502_op_0xD5_1,&&_m6502_op_0xD5_2,&&_m6502_op_0xD5_3,&&_m6502_op_0xD5_4,&&_m6502_op_0xD5_5,&&_m6502_op_0xD5_6,&&_m6502_op_0xD5_7,
+        &&_m6502_op_0xD6_0,&&_m6502_op_0xD6_1,&&_m6502_op_0xD6_2,&&_m6502_op_0xD6_3,&&_m6502_op_0xD6_4,&&_m6502_op_0xD6_5,&&_m6502_op_0xD6_6,&&_m6502_op_0xD6_7,
+        &&_m6502_op_0xD7_0,&&_m6502_op_0xD7_1,&&_m6502_op_0xD7_2,&&_m6502_op_0xD7_3,&&_m6502_op_0xD7_4,&&_m6502_op_0xD7_5,&&_m6502_op_0xD7_6,&&_m6502_op_0xD7_7,
+        &&_m6502_op_0xD8_0,&&_m6502_op_0xD8_1,&&_m6502_op_0xD8_2,&&_m6502_op_0xD8_3,&&_m6502_op_0xD8_4,&&_m6502_op_0xD8_5,&&_m6502_op_0xD8_6,&&_m6502_op_0xD8_7,
+        &&_m6502_op_0xD9_0,&&_m6502_op_0xD9_1,&&_m6502_op_0xD9_2,&&_m6502_op_0xD9_3,&&_m6502_op_0xD9_4,&&_m6502_op_0xD9_5,&&_m6502_op_0xD9_6,&&_m6502_op_0xD9_7,
+        &&_m6502_op_0xDA_0,&&_m6502_op_0xDA_1,&&_m6502_op_0xDA_2,&&_m6502_op_0xDA_3,&&_m6502_op_0xDA_4,&&_m6502_op_0xDA_5,&&_m6502_op_0xDA_6,&&_m6502_op_0xDA_7,
+        &&_m6502_op_0xDB_0,&&_m6502_op_0xDB_1,&&_m6502_op_0xDB_2,&&_m6502_op_0xDB_3,&&_m6502_op_0xDB_4,&&_m6502_op_0xDB_5,&&_m6502_op_0xDB_6,&&_m6502_op_0xDB_7,
+        &&_m6502_op_0xDC_0,&&_m6502_op_0xDC_1,&&_m6502_op_0xDC_2,&&_m6502_op_0xDC_3,&&_m6502_op_0xDC_4,&&_m6502_op_0xDC_5,&&_m6502_op_0xDC_6,&&_m6502_op_0xDC_7,
+        &&_m6502_op_0xDD_0,&&_m6502_op_0xDD_1,&&_m6502_op_0xDD_2,&&_m6502_op_0xDD_3,&&_m6502_op_0xDD_4,&&_m6502_op_0xDD_5,&&_m6502_op_0xDD_6,&&_m6502_op_0xDD_7,
+        &&_m6502_op_0xDE_0,&&_m6502_op_0xDE_1,&&_m6502_op_0xDE_2,&&_m6502_op_0xDE_3,&&_m6502_op_0xDE_4,&&_m6502_op_0xDE_5,&&_m6502_op_0xDE_6,&&_m6502_op_0xDE_7,
+        &&_m6502_op_0xDF_0,&&_m6502_op_0xDF_1,&&_m6502_op_0xDF_2,&&_m6502_op_0xDF_3,&&_m6502_op_0xDF_4,&&_m6502_op_0xDF_5,&&_m6502_op_0xDF_6,&&_m6502_op_0xDF_7,
+        &&_m6502_op_0xE0_0,&&_m6502_op_0xE0_1,&&_m6502_op_0xE0_2,&&_m6502_op_0xE0_3,&&_m6502_op_0xE0_4,&&_m6502_op_0xE0_5,&&_m6502_op_0xE0_6,&&_m6502_op_0xE0_7,
+        &&_m6502_op_0xE1_0,&&_m6502_op_0xE1_1,&&_m6502_op_0xE1_2,&&_m6502_op_0xE1_3,&&_m6502_op_0xE1_4,&&_m6502_op_0xE1_5,&&_m6502_op_0xE1_6,&&_m6502_op_0xE1_7,
+        &&_m6502_op_0xE2_0,&&_m6502_op_0xE2_1,&&_m6502_op_0xE2_2,&&_m6502_op_0xE2_3,&&_m6502_op_0xE2_4,&&_m6502_op_0xE2_5,&&_m6502_op_0xE2_6,&&_m6502_op_0xE2_7,
+        &&_m6502_op_0xE3_0,&&_m6502_op_0xE3_1,&&_m6502_op_0xE3_2,&&_m6502_op_0xE3_3,&&_m6502_op_0xE3_4,&&_m6502_op_0xE3_5,&&_m6502_op_0xE3_6,&&_m6502_op_0xE3_7,
+        &&_m6502_op_0xE4_0,&&_m6502_op_0xE4_1,&&_m6502_op_0xE4_2,&&_m6502_op_0xE4_3,&&_m6502_op_0xE4_4,&&_m6502_op_0xE4_5,&&_m6502_op_0xE4_6,&&_m6502_op_0xE4_7,
+        &&_m6502_op_0xE5_0,&&_m6502_op_0xE5_1,&&_m6502_op_0xE5_2,&&_m6502_op_0xE5_3,&&_m6502_op_0xE5_4,&&_m6502_op_0xE5_5,&&_m6502_op_0xE5_6,&&_m6502_op_0xE5_7,
+        &&_m6502_op_0xE6_0,&&_m6502_op_0xE6_1,&&_m6502_op_0xE6_2,&&_m6502_op_0xE6_3,&&_m6502_op_0xE6_4,&&_m6502_op_0xE6_5,&&_m6502_op_0xE6_6,&&_m6502_op_0xE6_7,
+        &&_m6502_op_0xE7_0,&&_m6502_op_0xE7_1,&&_m6502_op_0xE7_2,&&_m6502_op_0xE7_3,&&_m6502_op_0xE7_4,&&_m6502_op_0xE7_5,&&_m6502_op_0xE7_6,&&_m6502_op_0xE7_7,
+        &&_m6502_op_0xE8_0,&&_m6502_op_0xE8_1,&&_m6502_op_0xE8_2,&&_m6502_op_0xE8_3,&&_m6502_op_0xE8_4,&&_m6502_op_0xE8_5,&&_m6502_op_0xE8_6,&&_m6502_op_0xE8_7,
+        &&_m6502_op_0xE9_0,&&_m6502_op_0xE9_1,&&_m6502_op_0xE9_2,&&_m6502_op_0xE9_3,&&_m6502_op_0xE9_4,&&_m6502_op_0xE9_5,&&_m6502_op_0xE9_6,&&_m6502_op_0xE9_7,
+        &&_m6502_op_0xEA_0,&&_m6502_op_0xEA_1,&&_m6502_op_0xEA_2,&&_m6502_op_0xEA_3,&&_m6502_op_0xEA_4,&&_m6502_op_0xEA_5,&&_m6502_op_0xEA_6,&&_m6502_op_0xEA_7,
+        &&_m6502_op_0xEB_0,&&_m6502_op_0xEB_1,&&_m6502_op_0xEB_2,&&_m6502_op_0xEB_3,&&_m6502_op_0xEB_4,&&_m6502_op_0xEB_5,&&_m6502_op_0xEB_6,&&_m6502_op_0xEB_7,
+        &&_m6502_op_0xEC_0,&&_m6502_op_0xEC_1,&&_m6502_op_0xEC_2,&&_m6502_op_0xEC_3,&&_m6502_op_0xEC_4,&&_m6502_op_0xEC_5,&&_m6502_op_0xEC_6,&&_m6502_op_0xEC_7,
+        &&_m6502_op_0xED_0,&&_m6502_op_0xED_1,&&_m6502_op_0xED_2,&&_m6502_op_0xED_3,&&_m6502_op_0xED_4,&&_m6502_op_0xED_5,&&_m6502_op_0xED_6,&&_m6502_op_0xED_7,
+        &&_m6502_op_0xEE_0,&&_m6502_op_0xEE_1,&&_m6502_op_0xEE_2,&&_m6502_op_0xEE_3,&&_m6502_op_0xEE_4,&&_m6502_op_0xEE_5,&&_m6502_op_0xEE_6,&&_m6502_op_0xEE_7,
+        &&_m6502_op_0xEF_0,&&_m6502_op_0xEF_1,&&_m6502_op_0xEF_2,&&_m6502_op_0xEF_3,&&_m6502_op_0xEF_4,&&_m6502_op_0xEF_5,&&_m6502_op_0xEF_6,&&_m6502_op_0xEF_7,
+        &&_m6502_op_0xF0_0,&&_m6502_op_0xF0_1,&&_m6502_op_0xF0_2,&&_m6502_op_0xF0_3,&&_m6502_op_0xF0_4,&&_m6502_op_0xF0_5,&&_m6502_op_0xF0_6,&&_m6502_op_0xF0_7,
+        &&_m6502_op_0xF1_0,&&_m6502_op_0xF1_1,&&_m6502_op_0xF1_2,&&_m6502_op_0xF1_3,&&_m6502_op_0xF1_4,&&_m6502_op_0xF1_5,&&_m6502_op_0xF1_6,&&_m6502_op_0xF1_7,
+        &&_m6502_op_0xF2_0,&&_m6502_op_0xF2_1,&&_m6502_op_0xF2_2,&&_m6502_op_0xF2_3,&&_m6502_op_0xF2_4,&&_m6502_op_0xF2_5,&&_m6502_op_0xF2_6,&&_m6502_op_0xF2_7,
+        &&_m6502_op_0xF3_0,&&_m6502_op_0xF3_1,&&_m6502_op_0xF3_2,&&_m6502_op_0xF3_3,&&_m6502_op_0xF3_4,&&_m6502_op_0xF3_5,&&_m6502_op_0xF3_6,&&_m6502_op_0xF3_7,
+        &&_m6502_op_0xF4_0,&&_m6502_op_0xF4_1,&&_m6502_op_0xF4_2,&&_m6502_op_0xF4_3,&&_m6502_op_0xF4_4,&&_m6502_op_0xF4_5,&&_m6502_op_0xF4_6,&&_m6502_op_0xF4_7,
+        &&_m6502_op_0xF5_0,&&_m6502_op_0xF5_1,&&_m6502_op_0xF5_2,&&_m6502_op_0xF5_3,&&_m6502_op_0xF5_4,&&_m6502_op_0xF5_5,&&_m6502_op_0xF5_6,&&_m6502_op_0xF5_7,
+        &&_m6502_op_0xF6_0,&&_m6502_op_0xF6_1,&&_m6502_op_0xF6_2,&&_m6502_op_0xF6_3,&&_m6502_op_0xF6_4,&&_m6502_op_0xF6_5,&&_m6502_op_0xF6_6,&&_m6502_op_0xF6_7,
+        &&_m6502_op_0xF7_0,&&_m6502_op_0xF7_1,&&_m6502_op_0xF7_2,&&_m6502_op_0xF7_3,&&_m6502_op_0xF7_4,&&_m6502_op_0xF7_5,&&_m6502_op_0xF7_6,&&_m6502_op_0xF7_7,
+        &&_m6502_op_0xF8_0,&&_m6502_op_0xF8_1,&&_m6502_op_0xF8_2,&&_m6502_op_0xF8_3,&&_m6502_op_0xF8_4,&&_m6502_op_0xF8_5,&&_m6502_op_0xF8_6,&&_m6502_op_0xF8_7,
+        &&_m6502_op_0xF9_0,&&_m6502_op_0xF9_1,&&_m6502_op_0xF9_2,&&_m6502_op_0xF9_3,&&_m6502_op_0xF9_4,&&_m6502_op_0xF9_5,&&_m6502_op_0xF9_6,&&_m6502_op_0xF9_7,
+        &&_m6502_op_0xFA_0,&&_m6502_op_0xFA_1,&&_m6502_op_0xFA_2,&&_m6502_op_0xFA_3,&&_m6502_op_0xFA_4,&&_m6502_op_0xFA_5,&&_m6502_op_0xFA_6,&&_m6502_op_0xFA_7,
+        &&_m6502_op_0xFB_0,&&_m6502_op_0xFB_1,&&_m6502_op_0xFB_2,&&_m6502_op_0xFB_3,&&_m6502_op_0xFB_4,&&_m6502_op_0xFB_5,&&_m6502_op_0xFB_6,&&_m6502_op_0xFB_7,
+        &&_m6502_op_0xFC_0,&&_m6502_op_0xFC_1,&&_m6502_op_0xFC_2,&&_m6502_op_0xFC_3,&&_m6502_op_0xFC_4,&&_m6502_op_0xFC_5,&&_m6502_op_0xFC_6,&&_m6502_op_0xFC_7,
+        &&_m6502_op_0xFD_0,&&_m6502_op_0xFD_1,&&_m6502_op_0xFD_2,&&_m6502_op_0xFD_3,&&_m6502_op_0xFD_4,&&_m6502_op_0xFD_5,&&_m6502_op_0xFD_6,&&_m6502_op_0xFD_7,
+        &&_m6502_op_0xFE_0,&&_m6502_op_0xFE_1,&&_m6502_op_0xFE_2,&&_m6502_op_0xFE_3,&&_m6502_op_0xFE_4,&&_m6502_op_0xFE_5,&&_m6502_op_0xFE_6,&&_m6502_op_0xFE_7,
+        &&_m6502_op_0xFF_0,&&_m6502_op_0xFF_1,&&_m6502_op_0xFF_2,&&_m6502_op_0xFF_3,&&_m6502_op_0xFF_4,&&_m6502_op_0xFF_5,&&_m6502_op_0xFF_6,&&_m6502_op_0xFF_7,
+    };
+    #endif
+    _DISPATCH(_m6502_op_table)
+    /* BRK  */
+        _OP(0x00,0): _SA(c->PC);_NEXT()
+        _OP(0x00,1): if(0==(c->brk_flags&(M6502_BRK_IRQ|M6502_BRK_NMI))){c->PC++;}_SAD(0x0100|c->S--,c->PC>>8);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}_NEXT()
+        _OP(0x00,2): _SAD(0x0100|c->S--,c->PC);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}_NEXT()
+        _OP(0x00,3): _SAD(0x0100|c->S--,c->P|M6502_XF);if(c->brk_flags&M6502_BRK_RESET){c->AD=0xFFFC;}else{_WR();if(c->brk_flags&M6502_BRK_NMI){c->AD=0xFFFA;}else{c->AD=0xFFFE;}}_NEXT()
+        _OP(0x00,4): _SA(c->AD++);c->P|=(M6502_IF|M6502_BF);c->P&=~M6502_DF;c->brk_flags=0; /* RES/NMI hijacking */_NEXT()
+        _OP(0x00,5): _SA(c->AD);c->AD=_GD(); /* NMI "half-hijacking" not possible */_NEXT()
+        _OP(0x00,6): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x00,7): assert(false);_NEXT()
+    /* ORA (zp,X) */
+        _OP(0x01,0): _SA(c->PC++);_NEXT()
+        _OP(0x01,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x01,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x01,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x01,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x01,5): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x01,6): assert(false);_NEXT()
+        _OP(0x01,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x02,0): _SA(c->PC++);_NEXT()
+        _OP(0x02,1): _FETCH();_NEXT()
+        _OP(0x02,2): assert(false);_NEXT()
+        _OP(0x02,3): assert(false);_NEXT()
+        _OP(0x02,4): assert(false);_NEXT()
+        _OP(0x02,5): assert(false);_NEXT()
+        _OP(0x02,6): assert(false);_NEXT()
+        _OP(0x02,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x03,0): _FETCH();_NEXT()
+        _OP(0x03,1): assert(false);_NEXT()
+        _OP(0x03,2): assert(false);_NEXT()
+        _OP(0x03,3): assert(false);_NEXT()
+        _OP(0x03,4): assert(false);_NEXT()
+        _OP(0x03,5): assert(false);_NEXT()
+        _OP(0x03,6): assert(false);_NEXT()
+        _OP(0x03,7): assert(false);_NEXT()
+    /* TSB zp */
+        _OP(0x04,0): _SA(c->PC++);_NEXT()
+        _OP(0x04,1): _SA(_GD());_NEXT()
+        _OP(0x04,2): c->AD=_GD();_NEXT()
+        _OP(0x04,3): if(c->A&c->AD){c->P&=~M6502_ZF;}else{c->P|=M6502_ZF;}c->AD|=c->A;_SD(c->AD);_WR();_NEXT()
+        _OP(0x04,4): _FETCH();_NEXT()
+        _OP(0x04,5): assert(false);_NEXT()
+        _OP(0x04,6): assert(false);_NEXT()
+        _OP(0x04,7): assert(false);_NEXT()
+    /* ORA zp */
+        _OP(0x05,0): _SA(c->PC++);_NEXT()
+        _OP(0x05,1): _SA(_GD());_NEXT()
+        _OP(0x05,2): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x05,3): assert(false);_NEXT()
+        _OP(0x05,4): assert(false);_NEXT()
+        _OP(0x05,5): assert(false);_NEXT()
+        _OP(0x05,6): assert(false);_NEXT()
+        _OP(0x05,7): assert(false);_NEXT()
+    /* ASL zp */
+        _OP(0x06,0): _SA(c->PC++);_NEXT()
+        _OP(0x06,1): _SA(_GD());_NEXT()
+        _OP(0x06,2): c->AD=_GD();_NEXT()
+        _OP(0x06,3): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x06,4): _FETCH();_NEXT()
+        _OP(0x06,5): assert(false);_NEXT()
+        _OP(0x06,6): assert(false);_NEXT()
+        _OP(0x06,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x07,0): _FETCH();_NEXT()
+        _OP(0x07,1): assert(false);_NEXT()
+        _OP(0x07,2): assert(false);_NEXT()
+        _OP(0x07,3): assert(false);_NEXT()
+        _OP(0x07,4): assert(false);_NEXT()
+        _OP(0x07,5): assert(false);_NEXT()
+        _OP(0x07,6): assert(false);_NEXT()
+        _OP(0x07,7): assert(false);_NEXT()
+    /* PHP  */
+        _OP(0x08,0): _SA(c->PC);_NEXT()
+        _OP(0x08,1): _SAD(0x0100|c->S--,c->P|M6502_XF);_WR();_NEXT()
+        _OP(0x08,2): _FETCH();_NEXT()
+        _OP(0x08,3): assert(false);_NEXT()
+        _OP(0x08,4): assert(false);_NEXT()
+        _OP(0x08,5): assert(false);_NEXT()
+        _OP(0x08,6): assert(false);_NEXT()
+        _OP(0x08,7): assert(false);_NEXT()
+    /* ORA # */
+        _OP(0x09,0): _SA(c->PC++);_NEXT()
+        _OP(0x09,1): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x09,2): assert(false);_NEXT()
+        _OP(0x09,3): assert(false);_NEXT()
+        _OP(0x09,4): assert(false);_NEXT()
+        _OP(0x09,5): assert(false);_NEXT()
+        _OP(0x09,6): assert(false);_NEXT()
+        _OP(0x09,7): assert(false);_NEXT()
+    /* ASLA  */
+        _OP(0x0A,0): _SA(c->PC);_NEXT()
+        _OP(0x0A,1): c->A=_m6502_asl(c,c->A);_FETCH();_NEXT()
+        _OP(0x0A,2): assert(false);_NEXT()
+        _OP(0x0A,3): assert(false);_NEXT()
+        _OP(0x0A,4): assert(false);_NEXT()
+        _OP(0x0A,5): assert(false);_NEXT()
+        _OP(0x0A,6): assert(false);_NEXT()
+        _OP(0x0A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x0B,0): _FETCH();_NEXT()
+        _OP(0x0B,1): assert(false);_NEXT()
+        _OP(0x0B,2): assert(false);_NEXT()
+        _OP(0x0B,3): assert(false);_NEXT()
+        _OP(0x0B,4): assert(false);_NEXT()
+        _OP(0x0B,5): assert(false);_NEXT()
+        _OP(0x0B,6): assert(false);_NEXT()
+        _OP(0x0B,7): assert(false);_NEXT()
+    /* TSB abs */
+        _OP(0x0C,0): _SA(c->PC++);_NEXT()
+        _OP(0x0C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0C,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0C,3): c->AD=_GD();_NEXT()
+        _OP(0x0C,4): if(c->A&c->AD){c->P&=~M6502_ZF;}else{c->P|=M6502_ZF;}c->AD|=c->A;_SD(c->AD);_WR();_NEXT()
+        _OP(0x0C,5): _FETCH();_NEXT()
+        _OP(0x0C,6): assert(false);_NEXT()
+        _OP(0x0C,7): assert(false);_NEXT()
+    /* ORA abs */
+        _OP(0x0D,0): _SA(c->PC++);_NEXT()
+        _OP(0x0D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0D,3): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x0D,4): assert(false);_NEXT()
+        _OP(0x0D,5): assert(false);_NEXT()
+        _OP(0x0D,6): assert(false);_NEXT()
+        _OP(0x0D,7): assert(false);_NEXT()
+    /* ASL abs */
+        _OP(0x0E,0): _SA(c->PC++);_NEXT()
+        _OP(0x0E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x0E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x0E,3): c->AD=_GD();_NEXT()
+        _OP(0x0E,4): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x0E,5): _FETCH();_NEXT()
+        _OP(0x0E,6): assert(false);_NEXT()
+        _OP(0x0E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x0F,0): _FETCH();_NEXT()
+        _OP(0x0F,1): assert(false);_NEXT()
+        _OP(0x0F,2): assert(false);_NEXT()
+        _OP(0x0F,3): assert(false);_NEXT()
+        _OP(0x0F,4): assert(false);_NEXT()
+        _OP(0x0F,5): assert(false);_NEXT()
+        _OP(0x0F,6): assert(false);_NEXT()
+        _OP(0x0F,7): assert(false);_NEXT()
+    /* BPL # */
+        _OP(0x10,0): _SA(c->PC++);_NEXT()
+        _OP(0x10,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x80)!=0x0){_FETCH();};_NEXT()
+        _OP(0x10,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x10,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x10,4): assert(false);_NEXT()
+        _OP(0x10,5): assert(false);_NEXT()
+        _OP(0x10,6): assert(false);_NEXT()
+        _OP(0x10,7): assert(false);_NEXT()
+    /* ORA (zp),Y */
+        _OP(0x11,0): _SA(c->PC++);_NEXT()
+        _OP(0x11,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x11,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x11,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x11,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x11,5): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x11,6): assert(false);_NEXT()
+        _OP(0x11,7): assert(false);_NEXT()
+    /* ORA (zp) */
+        _OP(0x12,0): _SA(c->PC++);_NEXT()
+        _OP(0x12,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x12,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x12,3): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x12,4): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x12,5): assert(false);_NEXT()
+        _OP(0x12,6): assert(false);_NEXT()
+        _OP(0x12,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x13,0): _FETCH();_NEXT()
+        _OP(0x13,1): assert(false);_NEXT()
+        _OP(0x13,2): assert(false);_NEXT()
+        _OP(0x13,3): assert(false);_NEXT()
+        _OP(0x13,4): assert(false);_NEXT()
+        _OP(0x13,5): assert(false);_NEXT()
+        _OP(0x13,6): assert(false);_NEXT()
+        _OP(0x13,7): assert(false);_NEXT()
+    /* TRB zp */
+        _OP(0x14,0): _SA(c->PC++);_NEXT()
+        _OP(0x14,1): _SA(_GD());_NEXT()
+        _OP(0x14,2): c->AD=_GD();_NEXT()
+        _OP(0x14,3): if(c->A&c->AD){c->P&=~M6502_ZF;}else{c->P|=M6502_ZF;}c->AD&=~c->A;_SD(c->AD);_WR();_NEXT()
+        _OP(0x14,4): _FETCH();_NEXT()
+        _OP(0x14,5): assert(false);_NEXT()
+        _OP(0x14,6): assert(false);_NEXT()
+        _OP(0x14,7): assert(false);_NEXT()
+    /* ORA zp,X */
+        _OP(0x15,0): _SA(c->PC++);_NEXT()
+        _OP(0x15,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x15,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x15,3): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x15,4): assert(false);_NEXT()
+        _OP(0x15,5): assert(false);_NEXT()
+        _OP(0x15,6): assert(false);_NEXT()
+        _OP(0x15,7): assert(false);_NEXT()
+    /* ASL zp,X */
+        _OP(0x16,0): _SA(c->PC++);_NEXT()
+        _OP(0x16,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x16,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x16,3): c->AD=_GD();_NEXT()
+        _OP(0x16,4): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x16,5): _FETCH();_NEXT()
+        _OP(0x16,6): assert(false);_NEXT()
+        _OP(0x16,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x17,0): _FETCH();_NEXT()
+        _OP(0x17,1): assert(false);_NEXT()
+        _OP(0x17,2): assert(false);_NEXT()
+        _OP(0x17,3): assert(false);_NEXT()
+        _OP(0x17,4): assert(false);_NEXT()
+        _OP(0x17,5): assert(false);_NEXT()
+        _OP(0x17,6): assert(false);_NEXT()
+        _OP(0x17,7): assert(false);_NEXT()
+    /* CLC  */
+        _OP(0x18,0): _SA(c->PC);_NEXT()
+        _OP(0x18,1): c->P&=~0x1;_FETCH();_NEXT()
+        _OP(0x18,2): assert(false);_NEXT()
+        _OP(0x18,3): assert(false);_NEXT()
+        _OP(0x18,4): assert(false);_NEXT()
+        _OP(0x18,5): assert(false);_NEXT()
+        _OP(0x18,6): assert(false);_NEXT()
+        _OP(0x18,7): assert(false);_NEXT()
+    /* ORA abs,Y */
+        _OP(0x19,0): _SA(c->PC++);_NEXT()
+        _OP(0x19,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x19,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x19,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x19,4): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x19,5): assert(false);_NEXT()
+        _OP(0x19,6): assert(false);_NEXT()
+        _OP(0x19,7): assert(false);_NEXT()
+    /* INCA  */
+        _OP(0x1A,0): _SA(c->PC);_NEXT()
+        _OP(0x1A,1): c->A++;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x1A,2): assert(false);_NEXT()
+        _OP(0x1A,3): assert(false);_NEXT()
+        _OP(0x1A,4): assert(false);_NEXT()
+        _OP(0x1A,5): assert(false);_NEXT()
+        _OP(0x1A,6): assert(false);_NEXT()
+        _OP(0x1A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x1B,0): _FETCH();_NEXT()
+        _OP(0x1B,1): assert(false);_NEXT()
+        _OP(0x1B,2): assert(false);_NEXT()
+        _OP(0x1B,3): assert(false);_NEXT()
+        _OP(0x1B,4): assert(false);_NEXT()
+        _OP(0x1B,5): assert(false);_NEXT()
+        _OP(0x1B,6): assert(false);_NEXT()
+        _OP(0x1B,7): assert(false);_NEXT()
+    /* TRB abs */
+        _OP(0x1C,0): _SA(c->PC++);_NEXT()
+        _OP(0x1C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1C,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x1C,3): c->AD=_GD();_NEXT()
+        _OP(0x1C,4): if(c->A&c->AD){c->P&=~M6502_ZF;}else{c->P|=M6502_ZF;}c->AD&=~c->A;_SD(c->AD);_WR();_NEXT()
+        _OP(0x1C,5): _FETCH();_NEXT()
+        _OP(0x1C,6): assert(false);_NEXT()
+        _OP(0x1C,7): assert(false);_NEXT()
+    /* ORA abs,X */
+        _OP(0x1D,0): _SA(c->PC++);_NEXT()
+        _OP(0x1D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x1D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1D,4): c->A|=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x1D,5): assert(false);_NEXT()
+        _OP(0x1D,6): assert(false);_NEXT()
+        _OP(0x1D,7): assert(false);_NEXT()
+    /* ASL abs,X */
+        _OP(0x1E,0): _SA(c->PC++);_NEXT()
+        _OP(0x1E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x1E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x1E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x1E,4): c->AD=_GD();_NEXT()
+        _OP(0x1E,5): _SD(_m6502_asl(c,c->AD));_WR();_NEXT()
+        _OP(0x1E,6): _FETCH();_NEXT()
+        _OP(0x1E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x1F,0): _FETCH();_NEXT()
+        _OP(0x1F,1): assert(false);_NEXT()
+        _OP(0x1F,2): assert(false);_NEXT()
+        _OP(0x1F,3): assert(false);_NEXT()
+        _OP(0x1F,4): assert(false);_NEXT()
+        _OP(0x1F,5): assert(false);_NEXT()
+        _OP(0x1F,6): assert(false);_NEXT()
+        _OP(0x1F,7): assert(false);_NEXT()
+    /* JSR  */
+        _OP(0x20,0): _SA(c->PC++);_NEXT()
+        _OP(0x20,1): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x20,2): _SAD(0x0100|c->S--,c->PC>>8);_WR();_NEXT()
+        _OP(0x20,3): _SAD(0x0100|c->S--,c->PC);_WR();_NEXT()
+        _OP(0x20,4): _SA(c->PC);_NEXT()
+        _OP(0x20,5): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x20,6): assert(false);_NEXT()
+        _OP(0x20,7): assert(false);_NEXT()
+    /* AND (zp,X) */
+        _OP(0x21,0): _SA(c->PC++);_NEXT()
+        _OP(0x21,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x21,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x21,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x21,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x21,5): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x21,6): assert(false);_NEXT()
+        _OP(0x21,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x22,0): _SA(c->PC++);_NEXT()
+        _OP(0x22,1): _FETCH();_NEXT()
+        _OP(0x22,2): assert(false);_NEXT()
+        _OP(0x22,3): assert(false);_NEXT()
+        _OP(0x22,4): assert(false);_NEXT()
+        _OP(0x22,5): assert(false);_NEXT()
+        _OP(0x22,6): assert(false);_NEXT()
+        _OP(0x22,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x23,0): _FETCH();_NEXT()
+        _OP(0x23,1): assert(false);_NEXT()
+        _OP(0x23,2): assert(false);_NEXT()
+        _OP(0x23,3): assert(false);_NEXT()
+        _OP(0x23,4): assert(false);_NEXT()
+        _OP(0x23,5): assert(false);_NEXT()
+        _OP(0x23,6): assert(false);_NEXT()
+        _OP(0x23,7): assert(false);_NEXT()
+    /* BIT zp */
+        _OP(0x24,0): _SA(c->PC++);_NEXT()
+        _OP(0x24,1): _SA(_GD());_NEXT()
+        _OP(0x24,2): _m6502_bit(c,_GD());_FETCH();_NEXT()
+        _OP(0x24,3): assert(false);_NEXT()
+        _OP(0x24,4): assert(false);_NEXT()
+        _OP(0x24,5): assert(false);_NEXT()
+        _OP(0x24,6): assert(false);_NEXT()
+        _OP(0x24,7): assert(false);_NEXT()
+    /* AND zp */
+        _OP(0x25,0): _SA(c->PC++);_NEXT()
+        _OP(0x25,1): _SA(_GD());_NEXT()
+        _OP(0x25,2): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x25,3): assert(false);_NEXT()
+        _OP(0x25,4): assert(false);_NEXT()
+        _OP(0x25,5): assert(false);_NEXT()
+        _OP(0x25,6): assert(false);_NEXT()
+        _OP(0x25,7): assert(false);_NEXT()
+    /* ROL zp */
+        _OP(0x26,0): _SA(c->PC++);_NEXT()
+        _OP(0x26,1): _SA(_GD());_NEXT()
+        _OP(0x26,2): c->AD=_GD();_NEXT()
+        _OP(0x26,3): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x26,4): _FETCH();_NEXT()
+        _OP(0x26,5): assert(false);_NEXT()
+        _OP(0x26,6): assert(false);_NEXT()
+        _OP(0x26,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x27,0): _FETCH();_NEXT()
+        _OP(0x27,1): assert(false);_NEXT()
+        _OP(0x27,2): assert(false);_NEXT()
+        _OP(0x27,3): assert(false);_NEXT()
+        _OP(0x27,4): assert(false);_NEXT()
+        _OP(0x27,5): assert(false);_NEXT()
+        _OP(0x27,6): assert(false);_NEXT()
+        _OP(0x27,7): assert(false);_NEXT()
+    /* PLP  */
+        _OP(0x28,0): _SA(c->PC);_NEXT()
+        _OP(0x28,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x28,2): _SA(0x0100|c->S);_NEXT()
+        _OP(0x28,3): c->P=(_GD()|M6502_BF)&~M6502_XF;_FETCH();_NEXT()
+        _OP(0x28,4): assert(false);_NEXT()
+        _OP(0x28,5): assert(false);_NEXT()
+        _OP(0x28,6): assert(false);_NEXT()
+        _OP(0x28,7): assert(false);_NEXT()
+    /* AND # */
+        _OP(0x29,0): _SA(c->PC++);_NEXT()
+        _OP(0x29,1): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x29,2): assert(false);_NEXT()
+        _OP(0x29,3): assert(false);_NEXT()
+        _OP(0x29,4): assert(false);_NEXT()
+        _OP(0x29,5): assert(false);_NEXT()
+        _OP(0x29,6): assert(false);_NEXT()
+        _OP(0x29,7): assert(false);_NEXT()
+    /* ROLA  */
+        _OP(0x2A,0): _SA(c->PC);_NEXT()
+        _OP(0x2A,1): c->A=_m6502_rol(c,c->A);_FETCH();_NEXT()
+        _OP(0x2A,2): assert(false);_NEXT()
+        _OP(0x2A,3): assert(false);_NEXT()
+        _OP(0x2A,4): assert(false);_NEXT()
+        _OP(0x2A,5): assert(false);_NEXT()
+        _OP(0x2A,6): assert(false);_NEXT()
+        _OP(0x2A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x2B,0): _FETCH();_NEXT()
+        _OP(0x2B,1): assert(false);_NEXT()
+        _OP(0x2B,2): assert(false);_NEXT()
+        _OP(0x2B,3): assert(false);_NEXT()
+        _OP(0x2B,4): assert(false);_NEXT()
+        _OP(0x2B,5): assert(false);_NEXT()
+        _OP(0x2B,6): assert(false);_NEXT()
+        _OP(0x2B,7): assert(false);_NEXT()
+    /* BIT abs */
+        _OP(0x2C,0): _SA(c->PC++);_NEXT()
+        _OP(0x2C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2C,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2C,3): _m6502_bit(c,_GD());_FETCH();_NEXT()
+        _OP(0x2C,4): assert(false);_NEXT()
+        _OP(0x2C,5): assert(false);_NEXT()
+        _OP(0x2C,6): assert(false);_NEXT()
+        _OP(0x2C,7): assert(false);_NEXT()
+    /* AND abs */
+        _OP(0x2D,0): _SA(c->PC++);_NEXT()
+        _OP(0x2D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2D,3): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x2D,4): assert(false);_NEXT()
+        _OP(0x2D,5): assert(false);_NEXT()
+        _OP(0x2D,6): assert(false);_NEXT()
+        _OP(0x2D,7): assert(false);_NEXT()
+    /* ROL abs */
+        _OP(0x2E,0): _SA(c->PC++);_NEXT()
+        _OP(0x2E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x2E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x2E,3): c->AD=_GD();_NEXT()
+        _OP(0x2E,4): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x2E,5): _FETCH();_NEXT()
+        _OP(0x2E,6): assert(false);_NEXT()
+        _OP(0x2E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x2F,0): _FETCH();_NEXT()
+        _OP(0x2F,1): assert(false);_NEXT()
+        _OP(0x2F,2): assert(false);_NEXT()
+        _OP(0x2F,3): assert(false);_NEXT()
+        _OP(0x2F,4): assert(false);_NEXT()
+        _OP(0x2F,5): assert(false);_NEXT()
+        _OP(0x2F,6): assert(false);_NEXT()
+        _OP(0x2F,7): assert(false);_NEXT()
+    /* BMI # */
+        _OP(0x30,0): _SA(c->PC++);_NEXT()
+        _OP(0x30,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x80)!=0x80){_FETCH();};_NEXT()
+        _OP(0x30,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x30,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x30,4): assert(false);_NEXT()
+        _OP(0x30,5): assert(false);_NEXT()
+        _OP(0x30,6): assert(false);_NEXT()
+        _OP(0x30,7): assert(false);_NEXT()
+    /* AND (zp),Y */
+        _OP(0x31,0): _SA(c->PC++);_NEXT()
+        _OP(0x31,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x31,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x31,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x31,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x31,5): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x31,6): assert(false);_NEXT()
+        _OP(0x31,7): assert(false);_NEXT()
+    /* AND (zp) */
+        _OP(0x32,0): _SA(c->PC++);_NEXT()
+        _OP(0x32,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x32,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x32,3): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x32,4): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x32,5): assert(false);_NEXT()
+        _OP(0x32,6): assert(false);_NEXT()
+        _OP(0x32,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x33,0): _FETCH();_NEXT()
+        _OP(0x33,1): assert(false);_NEXT()
+        _OP(0x33,2): assert(false);_NEXT()
+        _OP(0x33,3): assert(false);_NEXT()
+        _OP(0x33,4): assert(false);_NEXT()
+        _OP(0x33,5): assert(false);_NEXT()
+        _OP(0x33,6): assert(false);_NEXT()
+        _OP(0x33,7): assert(false);_NEXT()
+    /* BIT zp,X */
+        _OP(0x34,0): _SA(c->PC++);_NEXT()
+        _OP(0x34,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x34,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x34,3): _m6502_bit(c,_GD());_FETCH();_NEXT()
+        _OP(0x34,4): assert(false);_NEXT()
+        _OP(0x34,5): assert(false);_NEXT()
+        _OP(0x34,6): assert(false);_NEXT()
+        _OP(0x34,7): assert(false);_NEXT()
+    /* AND zp,X */
+        _OP(0x35,0): _SA(c->PC++);_NEXT()
+        _OP(0x35,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x35,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x35,3): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x35,4): assert(false);_NEXT()
+        _OP(0x35,5): assert(false);_NEXT()
+        _OP(0x35,6): assert(false);_NEXT()
+        _OP(0x35,7): assert(false);_NEXT()
+    /* ROL zp,X */
+        _OP(0x36,0): _SA(c->PC++);_NEXT()
+        _OP(0x36,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x36,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x36,3): c->AD=_GD();_NEXT()
+        _OP(0x36,4): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x36,5): _FETCH();_NEXT()
+        _OP(0x36,6): assert(false);_NEXT()
+        _OP(0x36,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x37,0): _FETCH();_NEXT()
+        _OP(0x37,1): assert(false);_NEXT()
+        _OP(0x37,2): assert(false);_NEXT()
+        _OP(0x37,3): assert(false);_NEXT()
+        _OP(0x37,4): assert(false);_NEXT()
+        _OP(0x37,5): assert(false);_NEXT()
+        _OP(0x37,6): assert(false);_NEXT()
+        _OP(0x37,7): assert(false);_NEXT()
+    /* SEC  */
+        _OP(0x38,0): _SA(c->PC);_NEXT()
+        _OP(0x38,1): c->P|=0x1;_FETCH();_NEXT()
+        _OP(0x38,2): assert(false);_NEXT()
+        _OP(0x38,3): assert(false);_NEXT()
+        _OP(0x38,4): assert(false);_NEXT()
+        _OP(0x38,5): assert(false);_NEXT()
+        _OP(0x38,6): assert(false);_NEXT()
+        _OP(0x38,7): assert(false);_NEXT()
+    /* AND abs,Y */
+        _OP(0x39,0): _SA(c->PC++);_NEXT()
+        _OP(0x39,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x39,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x39,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x39,4): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x39,5): assert(false);_NEXT()
+        _OP(0x39,6): assert(false);_NEXT()
+        _OP(0x39,7): assert(false);_NEXT()
+    /* DECA  */
+        _OP(0x3A,0): _SA(c->PC);_NEXT()
+        _OP(0x3A,1): c->A--;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x3A,2): assert(false);_NEXT()
+        _OP(0x3A,3): assert(false);_NEXT()
+        _OP(0x3A,4): assert(false);_NEXT()
+        _OP(0x3A,5): assert(false);_NEXT()
+        _OP(0x3A,6): assert(false);_NEXT()
+        _OP(0x3A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x3B,0): _FETCH();_NEXT()
+        _OP(0x3B,1): assert(false);_NEXT()
+        _OP(0x3B,2): assert(false);_NEXT()
+        _OP(0x3B,3): assert(false);_NEXT()
+        _OP(0x3B,4): assert(false);_NEXT()
+        _OP(0x3B,5): assert(false);_NEXT()
+        _OP(0x3B,6): assert(false);_NEXT()
+        _OP(0x3B,7): assert(false);_NEXT()
+    /* BIT abs,X */
+        _OP(0x3C,0): _SA(c->PC++);_NEXT()
+        _OP(0x3C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3C,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x3C,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3C,4): _m6502_bit(c,_GD());_FETCH();_NEXT()
+        _OP(0x3C,5): assert(false);_NEXT()
+        _OP(0x3C,6): assert(false);_NEXT()
+        _OP(0x3C,7): assert(false);_NEXT()
+    /* AND abs,X */
+        _OP(0x3D,0): _SA(c->PC++);_NEXT()
+        _OP(0x3D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x3D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3D,4): c->A&=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x3D,5): assert(false);_NEXT()
+        _OP(0x3D,6): assert(false);_NEXT()
+        _OP(0x3D,7): assert(false);_NEXT()
+    /* ROL abs,X */
+        _OP(0x3E,0): _SA(c->PC++);_NEXT()
+        _OP(0x3E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x3E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x3E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x3E,4): c->AD=_GD();_NEXT()
+        _OP(0x3E,5): _SD(_m6502_rol(c,c->AD));_WR();_NEXT()
+        _OP(0x3E,6): _FETCH();_NEXT()
+        _OP(0x3E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x3F,0): _FETCH();_NEXT()
+        _OP(0x3F,1): assert(false);_NEXT()
+        _OP(0x3F,2): assert(false);_NEXT()
+        _OP(0x3F,3): assert(false);_NEXT()
+        _OP(0x3F,4): assert(false);_NEXT()
+        _OP(0x3F,5): assert(false);_NEXT()
+        _OP(0x3F,6): assert(false);_NEXT()
+        _OP(0x3F,7): assert(false);_NEXT()
+    /* RTI  */
+        _OP(0x40,0): _SA(c->PC);_NEXT()
+        _OP(0x40,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x40,2): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x40,3): _SA(0x0100|c->S++);c->P=(_GD()|M6502_BF)&~M6502_XF;_NEXT()
+        _OP(0x40,4): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x40,5): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x40,6): assert(false);_NEXT()
+        _OP(0x40,7): assert(false);_NEXT()
+    /* EOR (zp,X) */
+        _OP(0x41,0): _SA(c->PC++);_NEXT()
+        _OP(0x41,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x41,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x41,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x41,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x41,5): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x41,6): assert(false);_NEXT()
+        _OP(0x41,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x42,0): _SA(c->PC++);_NEXT()
+        _OP(0x42,1): _FETCH();_NEXT()
+        _OP(0x42,2): assert(false);_NEXT()
+        _OP(0x42,3): assert(false);_NEXT()
+        _OP(0x42,4): assert(false);_NEXT()
+        _OP(0x42,5): assert(false);_NEXT()
+        _OP(0x42,6): assert(false);_NEXT()
+        _OP(0x42,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x43,0): _FETCH();_NEXT()
+        _OP(0x43,1): assert(false);_NEXT()
+        _OP(0x43,2): assert(false);_NEXT()
+        _OP(0x43,3): assert(false);_NEXT()
+        _OP(0x43,4): assert(false);_NEXT()
+        _OP(0x43,5): assert(false);_NEXT()
+        _OP(0x43,6): assert(false);_NEXT()
+        _OP(0x43,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x44,0): _SA(c->PC++);_NEXT()
+        _OP(0x44,1): _SA(c->PC);_NEXT()
+        _OP(0x44,2): _FETCH();_NEXT()
+        _OP(0x44,3): assert(false);_NEXT()
+        _OP(0x44,4): assert(false);_NEXT()
+        _OP(0x44,5): assert(false);_NEXT()
+        _OP(0x44,6): assert(false);_NEXT()
+        _OP(0x44,7): assert(false);_NEXT()
+    /* EOR zp */
+        _OP(0x45,0): _SA(c->PC++);_NEXT()
+        _OP(0x45,1): _SA(_GD());_NEXT()
+        _OP(0x45,2): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x45,3): assert(false);_NEXT()
+        _OP(0x45,4): assert(false);_NEXT()
+        _OP(0x45,5): assert(false);_NEXT()
+        _OP(0x45,6): assert(false);_NEXT()
+        _OP(0x45,7): assert(false);_NEXT()
+    /* LSR zp */
+        _OP(0x46,0): _SA(c->PC++);_NEXT()
+        _OP(0x46,1): _SA(_GD());_NEXT()
+        _OP(0x46,2): c->AD=_GD();_NEXT()
+        _OP(0x46,3): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x46,4): _FETCH();_NEXT()
+        _OP(0x46,5): assert(false);_NEXT()
+        _OP(0x46,6): assert(false);_NEXT()
+        _OP(0x46,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x47,0): _FETCH();_NEXT()
+        _OP(0x47,1): assert(false);_NEXT()
+        _OP(0x47,2): assert(false);_NEXT()
+        _OP(0x47,3): assert(false);_NEXT()
+        _OP(0x47,4): assert(false);_NEXT()
+        _OP(0x47,5): assert(false);_NEXT()
+        _OP(0x47,6): assert(false);_NEXT()
+        _OP(0x47,7): assert(false);_NEXT()
+    /* PHA  */
+        _OP(0x48,0): _SA(c->PC);_NEXT()
+        _OP(0x48,1): _SAD(0x0100|c->S--,c->A);_WR();_NEXT()
+        _OP(0x48,2): _FETCH();_NEXT()
+        _OP(0x48,3): assert(false);_NEXT()
+        _OP(0x48,4): assert(false);_NEXT()
+        _OP(0x48,5): assert(false);_NEXT()
+        _OP(0x48,6): assert(false);_NEXT()
+        _OP(0x48,7): assert(false);_NEXT()
+    /* EOR # */
+        _OP(0x49,0): _SA(c->PC++);_NEXT()
+        _OP(0x49,1): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x49,2): assert(false);_NEXT()
+        _OP(0x49,3): assert(false);_NEXT()
+        _OP(0x49,4): assert(false);_NEXT()
+        _OP(0x49,5): assert(false);_NEXT()
+        _OP(0x49,6): assert(false);_NEXT()
+        _OP(0x49,7): assert(false);_NEXT()
+    /* LSRA  */
+        _OP(0x4A,0): _SA(c->PC);_NEXT()
+        _OP(0x4A,1): c->A=_m6502_lsr(c,c->A);_FETCH();_NEXT()
+        _OP(0x4A,2): assert(false);_NEXT()
+        _OP(0x4A,3): assert(false);_NEXT()
+        _OP(0x4A,4): assert(false);_NEXT()
+        _OP(0x4A,5): assert(false);_NEXT()
+        _OP(0x4A,6): assert(false);_NEXT()
+        _OP(0x4A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x4B,0): _FETCH();_NEXT()
+        _OP(0x4B,1): assert(false);_NEXT()
+        _OP(0x4B,2): assert(false);_NEXT()
+        _OP(0x4B,3): assert(false);_NEXT()
+        _OP(0x4B,4): assert(false);_NEXT()
+        _OP(0x4B,5): assert(false);_NEXT()
+        _OP(0x4B,6): assert(false);_NEXT()
+        _OP(0x4B,7): assert(false);_NEXT()
+    /* JMP  */
+        _OP(0x4C,0): _SA(c->PC++);_NEXT()
+        _OP(0x4C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4C,2): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x4C,3): assert(false);_NEXT()
+        _OP(0x4C,4): assert(false);_NEXT()
+        _OP(0x4C,5): assert(false);_NEXT()
+        _OP(0x4C,6): assert(false);_NEXT()
+        _OP(0x4C,7): assert(false);_NEXT()
+    /* EOR abs */
+        _OP(0x4D,0): _SA(c->PC++);_NEXT()
+        _OP(0x4D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x4D,3): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x4D,4): assert(false);_NEXT()
+        _OP(0x4D,5): assert(false);_NEXT()
+        _OP(0x4D,6): assert(false);_NEXT()
+        _OP(0x4D,7): assert(false);_NEXT()
+    /* LSR abs */
+        _OP(0x4E,0): _SA(c->PC++);_NEXT()
+        _OP(0x4E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x4E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x4E,3): c->AD=_GD();_NEXT()
+        _OP(0x4E,4): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x4E,5): _FETCH();_NEXT()
+        _OP(0x4E,6): assert(false);_NEXT()
+        _OP(0x4E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x4F,0): _FETCH();_NEXT()
+        _OP(0x4F,1): assert(false);_NEXT()
+        _OP(0x4F,2): assert(false);_NEXT()
+        _OP(0x4F,3): assert(false);_NEXT()
+        _OP(0x4F,4): assert(false);_NEXT()
+        _OP(0x4F,5): assert(false);_NEXT()
+        _OP(0x4F,6): assert(false);_NEXT()
+        _OP(0x4F,7): assert(false);_NEXT()
+    /* BVC # */
+        _OP(0x50,0): _SA(c->PC++);_NEXT()
+        _OP(0x50,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x40)!=0x0){_FETCH();};_NEXT()
+        _OP(0x50,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x50,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x50,4): assert(false);_NEXT()
+        _OP(0x50,5): assert(false);_NEXT()
+        _OP(0x50,6): assert(false);_NEXT()
+        _OP(0x50,7): assert(false);_NEXT()
+    /* EOR (zp),Y */
+        _OP(0x51,0): _SA(c->PC++);_NEXT()
+        _OP(0x51,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x51,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x51,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x51,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x51,5): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x51,6): assert(false);_NEXT()
+        _OP(0x51,7): assert(false);_NEXT()
+    /* EOR (zp) */
+        _OP(0x52,0): _SA(c->PC++);_NEXT()
+        _OP(0x52,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x52,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x52,3): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x52,4): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x52,5): assert(false);_NEXT()
+        _OP(0x52,6): assert(false);_NEXT()
+        _OP(0x52,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x53,0): _FETCH();_NEXT()
+        _OP(0x53,1): assert(false);_NEXT()
+        _OP(0x53,2): assert(false);_NEXT()
+        _OP(0x53,3): assert(false);_NEXT()
+        _OP(0x53,4): assert(false);_NEXT()
+        _OP(0x53,5): assert(false);_NEXT()
+        _OP(0x53,6): assert(false);_NEXT()
+        _OP(0x53,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x54,0): _SA(c->PC++);_NEXT()
+        _OP(0x54,1): _SA(c->PC);_NEXT()
+        _OP(0x54,2): _SA(c->PC);_NEXT()
+        _OP(0x54,3): _FETCH();_NEXT()
+        _OP(0x54,4): assert(false);_NEXT()
+        _OP(0x54,5): assert(false);_NEXT()
+        _OP(0x54,6): assert(false);_NEXT()
+        _OP(0x54,7): assert(false);_NEXT()
+    /* EOR zp,X */
+        _OP(0x55,0): _SA(c->PC++);_NEXT()
+        _OP(0x55,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x55,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x55,3): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x55,4): assert(false);_NEXT()
+        _OP(0x55,5): assert(false);_NEXT()
+        _OP(0x55,6): assert(false);_NEXT()
+        _OP(0x55,7): assert(false);_NEXT()
+    /* LSR zp,X */
+        _OP(0x56,0): _SA(c->PC++);_NEXT()
+        _OP(0x56,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x56,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x56,3): c->AD=_GD();_NEXT()
+        _OP(0x56,4): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x56,5): _FETCH();_NEXT()
+        _OP(0x56,6): assert(false);_NEXT()
+        _OP(0x56,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x57,0): _FETCH();_NEXT()
+        _OP(0x57,1): assert(false);_NEXT()
+        _OP(0x57,2): assert(false);_NEXT()
+        _OP(0x57,3): assert(false);_NEXT()
+        _OP(0x57,4): assert(false);_NEXT()
+        _OP(0x57,5): assert(false);_NEXT()
+        _OP(0x57,6): assert(false);_NEXT()
+        _OP(0x57,7): assert(false);_NEXT()
+    /* CLI  */
+        _OP(0x58,0): _SA(c->PC);_NEXT()
+        _OP(0x58,1): c->P&=~0x4;_FETCH();_NEXT()
+        _OP(0x58,2): assert(false);_NEXT()
+        _OP(0x58,3): assert(false);_NEXT()
+        _OP(0x58,4): assert(false);_NEXT()
+        _OP(0x58,5): assert(false);_NEXT()
+        _OP(0x58,6): assert(false);_NEXT()
+        _OP(0x58,7): assert(false);_NEXT()
+    /* EOR abs,Y */
+        _OP(0x59,0): _SA(c->PC++);_NEXT()
+        _OP(0x59,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x59,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x59,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x59,4): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x59,5): assert(false);_NEXT()
+        _OP(0x59,6): assert(false);_NEXT()
+        _OP(0x59,7): assert(false);_NEXT()
+    /* PHY  */
+        _OP(0x5A,0): _SA(c->PC);_NEXT()
+        _OP(0x5A,1): _SAD(0x0100|c->S--,c->Y);_WR();_NEXT()
+        _OP(0x5A,2): _FETCH();_NEXT()
+        _OP(0x5A,3): assert(false);_NEXT()
+        _OP(0x5A,4): assert(false);_NEXT()
+        _OP(0x5A,5): assert(false);_NEXT()
+        _OP(0x5A,6): assert(false);_NEXT()
+        _OP(0x5A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x5B,0): _FETCH();_NEXT()
+        _OP(0x5B,1): assert(false);_NEXT()
+        _OP(0x5B,2): assert(false);_NEXT()
+        _OP(0x5B,3): assert(false);_NEXT()
+        _OP(0x5B,4): assert(false);_NEXT()
+        _OP(0x5B,5): assert(false);_NEXT()
+        _OP(0x5B,6): assert(false);_NEXT()
+        _OP(0x5B,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x5C,0): _SA(c->PC++);_NEXT()
+        _OP(0x5C,1): _SA(c->PC++);_NEXT()
+        _OP(0x5C,2): _SA(c->PC);_NEXT()
+        _OP(0x5C,3): _SA(c->PC);_NEXT()
+        _OP(0x5C,4): _SA(c->PC);_NEXT()
+        _OP(0x5C,5): _SA(c->PC);_NEXT()
+        _OP(0x5C,6): _SA(c->PC);_NEXT()
+        _OP(0x5C,7): _FETCH();_NEXT()
+    /* EOR abs,X */
+        _OP(0x5D,0): _SA(c->PC++);_NEXT()
+        _OP(0x5D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x5D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5D,4): c->A^=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x5D,5): assert(false);_NEXT()
+        _OP(0x5D,6): assert(false);_NEXT()
+        _OP(0x5D,7): assert(false);_NEXT()
+    /* LSR abs,X */
+        _OP(0x5E,0): _SA(c->PC++);_NEXT()
+        _OP(0x5E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x5E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x5E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x5E,4): c->AD=_GD();_NEXT()
+        _OP(0x5E,5): _SD(_m6502_lsr(c,c->AD));_WR();_NEXT()
+        _OP(0x5E,6): _FETCH();_NEXT()
+        _OP(0x5E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x5F,0): _FETCH();_NEXT()
+        _OP(0x5F,1): assert(false);_NEXT()
+        _OP(0x5F,2): assert(false);_NEXT()
+        _OP(0x5F,3): assert(false);_NEXT()
+        _OP(0x5F,4): assert(false);_NEXT()
+        _OP(0x5F,5): assert(false);_NEXT()
+        _OP(0x5F,6): assert(false);_NEXT()
+        _OP(0x5F,7): assert(false);_NEXT()
+    /* RTS  */
+        _OP(0x60,0): _SA(c->PC);_NEXT()
+        _OP(0x60,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x60,2): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x60,3): _SA(0x0100|c->S);c->AD=_GD();_NEXT()
+        _OP(0x60,4): c->PC=(_GD()<<8)|c->AD;_SA(c->PC++);_NEXT()
+        _OP(0x60,5): _FETCH();_NEXT()
+        _OP(0x60,6): assert(false);_NEXT()
+        _OP(0x60,7): assert(false);_NEXT()
+    /* ADC (zp,X) */
+        _OP(0x61,0): _SA(c->PC++);_NEXT()
+        _OP(0x61,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x61,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x61,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x61,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x61,5): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x61,6): _FETCH();_NEXT()
+        _OP(0x61,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x62,0): _SA(c->PC++);_NEXT()
+        _OP(0x62,1): _FETCH();_NEXT()
+        _OP(0x62,2): assert(false);_NEXT()
+        _OP(0x62,3): assert(false);_NEXT()
+        _OP(0x62,4): assert(false);_NEXT()
+        _OP(0x62,5): assert(false);_NEXT()
+        _OP(0x62,6): assert(false);_NEXT()
+        _OP(0x62,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x63,0): _FETCH();_NEXT()
+        _OP(0x63,1): assert(false);_NEXT()
+        _OP(0x63,2): assert(false);_NEXT()
+        _OP(0x63,3): assert(false);_NEXT()
+        _OP(0x63,4): assert(false);_NEXT()
+        _OP(0x63,5): assert(false);_NEXT()
+        _OP(0x63,6): assert(false);_NEXT()
+        _OP(0x63,7): assert(false);_NEXT()
+    /* STZ zp */
+        _OP(0x64,0): _SA(c->PC++);_NEXT()
+        _OP(0x64,1): _SA(_GD());_SD(0);_WR();_NEXT()
+        _OP(0x64,2): _FETCH();_NEXT()
+        _OP(0x64,3): assert(false);_NEXT()
+        _OP(0x64,4): assert(false);_NEXT()
+        _OP(0x64,5): assert(false);_NEXT()
+        _OP(0x64,6): assert(false);_NEXT()
+        _OP(0x64,7): assert(false);_NEXT()
+    /* ADC zp */
+        _OP(0x65,0): _SA(c->PC++);_NEXT()
+        _OP(0x65,1): _SA(_GD());_NEXT()
+        _OP(0x65,2): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x65,3): _FETCH();_NEXT()
+        _OP(0x65,4): assert(false);_NEXT()
+        _OP(0x65,5): assert(false);_NEXT()
+        _OP(0x65,6): assert(false);_NEXT()
+        _OP(0x65,7): assert(false);_NEXT()
+    /* ROR zp */
+        _OP(0x66,0): _SA(c->PC++);_NEXT()
+        _OP(0x66,1): _SA(_GD());_NEXT()
+        _OP(0x66,2): c->AD=_GD();_NEXT()
+        _OP(0x66,3): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x66,4): _FETCH();_NEXT()
+        _OP(0x66,5): assert(false);_NEXT()
+        _OP(0x66,6): assert(false);_NEXT()
+        _OP(0x66,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x67,0): _FETCH();_NEXT()
+        _OP(0x67,1): assert(false);_NEXT()
+        _OP(0x67,2): assert(false);_NEXT()
+        _OP(0x67,3): assert(false);_NEXT()
+        _OP(0x67,4): assert(false);_NEXT()
+        _OP(0x67,5): assert(false);_NEXT()
+        _OP(0x67,6): assert(false);_NEXT()
+        _OP(0x67,7): assert(false);_NEXT()
+    /* PLA  */
+        _OP(0x68,0): _SA(c->PC);_NEXT()
+        _OP(0x68,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x68,2): _SA(0x0100|c->S);_NEXT()
+        _OP(0x68,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x68,4): assert(false);_NEXT()
+        _OP(0x68,5): assert(false);_NEXT()
+        _OP(0x68,6): assert(false);_NEXT()
+        _OP(0x68,7): assert(false);_NEXT()
+    /* ADC # */
+        _OP(0x69,0): _SA(c->PC++);_NEXT()
+        _OP(0x69,1): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x69,2): _FETCH();_NEXT()
+        _OP(0x69,3): assert(false);_NEXT()
+        _OP(0x69,4): assert(false);_NEXT()
+        _OP(0x69,5): assert(false);_NEXT()
+        _OP(0x69,6): assert(false);_NEXT()
+        _OP(0x69,7): assert(false);_NEXT()
+    /* RORA  */
+        _OP(0x6A,0): _SA(c->PC);_NEXT()
+        _OP(0x6A,1): c->A=_m6502_ror(c,c->A);_FETCH();_NEXT()
+        _OP(0x6A,2): assert(false);_NEXT()
+        _OP(0x6A,3): assert(false);_NEXT()
+        _OP(0x6A,4): assert(false);_NEXT()
+        _OP(0x6A,5): assert(false);_NEXT()
+        _OP(0x6A,6): assert(false);_NEXT()
+        _OP(0x6A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x6B,0): _FETCH();_NEXT()
+        _OP(0x6B,1): assert(false);_NEXT()
+        _OP(0x6B,2): assert(false);_NEXT()
+        _OP(0x6B,3): assert(false);_NEXT()
+        _OP(0x6B,4): assert(false);_NEXT()
+        _OP(0x6B,5): assert(false);_NEXT()
+        _OP(0x6B,6): assert(false);_NEXT()
+        _OP(0x6B,7): assert(false);_NEXT()
+    /* JMPI  */
+        _OP(0x6C,0): _SA(c->PC++);_NEXT()
+        _OP(0x6C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6C,2): c->AD|=_GD()<<8;_SA(c->PC-1);_NEXT()
+        _OP(0x6C,3): _SA(c->AD);_NEXT()
+        _OP(0x6C,4): _SA(c->AD+1);c->AD=_GD();_NEXT()
+        _OP(0x6C,5): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x6C,6): assert(false);_NEXT()
+        _OP(0x6C,7): assert(false);_NEXT()
+    /* ADC abs */
+        _OP(0x6D,0): _SA(c->PC++);_NEXT()
+        _OP(0x6D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6D,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x6D,3): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x6D,4): _FETCH();_NEXT()
+        _OP(0x6D,5): assert(false);_NEXT()
+        _OP(0x6D,6): assert(false);_NEXT()
+        _OP(0x6D,7): assert(false);_NEXT()
+    /* ROR abs */
+        _OP(0x6E,0): _SA(c->PC++);_NEXT()
+        _OP(0x6E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x6E,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x6E,3): c->AD=_GD();_NEXT()
+        _OP(0x6E,4): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x6E,5): _FETCH();_NEXT()
+        _OP(0x6E,6): assert(false);_NEXT()
+        _OP(0x6E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x6F,0): _FETCH();_NEXT()
+        _OP(0x6F,1): assert(false);_NEXT()
+        _OP(0x6F,2): assert(false);_NEXT()
+        _OP(0x6F,3): assert(false);_NEXT()
+        _OP(0x6F,4): assert(false);_NEXT()
+        _OP(0x6F,5): assert(false);_NEXT()
+        _OP(0x6F,6): assert(false);_NEXT()
+        _OP(0x6F,7): assert(false);_NEXT()
+    /* BVS # */
+        _OP(0x70,0): _SA(c->PC++);_NEXT()
+        _OP(0x70,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x40)!=0x40){_FETCH();};_NEXT()
+        _OP(0x70,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x70,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x70,4): assert(false);_NEXT()
+        _OP(0x70,5): assert(false);_NEXT()
+        _OP(0x70,6): assert(false);_NEXT()
+        _OP(0x70,7): assert(false);_NEXT()
+    /* ADC (zp),Y */
+        _OP(0x71,0): _SA(c->PC++);_NEXT()
+        _OP(0x71,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x71,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x71,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x71,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x71,5): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x71,6): _FETCH();_NEXT()
+        _OP(0x71,7): assert(false);_NEXT()
+    /* ADC (zp) */
+        _OP(0x72,0): _SA(c->PC++);_NEXT()
+        _OP(0x72,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x72,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x72,3): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0x72,4): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x72,5): _FETCH();_NEXT()
+        _OP(0x72,6): assert(false);_NEXT()
+        _OP(0x72,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x73,0): _FETCH();_NEXT()
+        _OP(0x73,1): assert(false);_NEXT()
+        _OP(0x73,2): assert(false);_NEXT()
+        _OP(0x73,3): assert(false);_NEXT()
+        _OP(0x73,4): assert(false);_NEXT()
+        _OP(0x73,5): assert(false);_NEXT()
+        _OP(0x73,6): assert(false);_NEXT()
+        _OP(0x73,7): assert(false);_NEXT()
+    /* STZ zp,X */
+        _OP(0x74,0): _SA(c->PC++);_NEXT()
+        _OP(0x74,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x74,2): _SA((c->AD+c->X)&0x00FF);_SD(0);_WR();_NEXT()
+        _OP(0x74,3): _FETCH();_NEXT()
+        _OP(0x74,4): assert(false);_NEXT()
+        _OP(0x74,5): assert(false);_NEXT()
+        _OP(0x74,6): assert(false);_NEXT()
+        _OP(0x74,7): assert(false);_NEXT()
+    /* ADC zp,X */
+        _OP(0x75,0): _SA(c->PC++);_NEXT()
+        _OP(0x75,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x75,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x75,3): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x75,4): _FETCH();_NEXT()
+        _OP(0x75,5): assert(false);_NEXT()
+        _OP(0x75,6): assert(false);_NEXT()
+        _OP(0x75,7): assert(false);_NEXT()
+    /* ROR zp,X */
+        _OP(0x76,0): _SA(c->PC++);_NEXT()
+        _OP(0x76,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x76,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0x76,3): c->AD=_GD();_NEXT()
+        _OP(0x76,4): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x76,5): _FETCH();_NEXT()
+        _OP(0x76,6): assert(false);_NEXT()
+        _OP(0x76,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x77,0): _FETCH();_NEXT()
+        _OP(0x77,1): assert(false);_NEXT()
+        _OP(0x77,2): assert(false);_NEXT()
+        _OP(0x77,3): assert(false);_NEXT()
+        _OP(0x77,4): assert(false);_NEXT()
+        _OP(0x77,5): assert(false);_NEXT()
+        _OP(0x77,6): assert(false);_NEXT()
+        _OP(0x77,7): assert(false);_NEXT()
+    /* SEI  */
+        _OP(0x78,0): _SA(c->PC);_NEXT()
+        _OP(0x78,1): c->P|=0x4;_FETCH();_NEXT()
+        _OP(0x78,2): assert(false);_NEXT()
+        _OP(0x78,3): assert(false);_NEXT()
+        _OP(0x78,4): assert(false);_NEXT()
+        _OP(0x78,5): assert(false);_NEXT()
+        _OP(0x78,6): assert(false);_NEXT()
+        _OP(0x78,7): assert(false);_NEXT()
+    /* ADC abs,Y */
+        _OP(0x79,0): _SA(c->PC++);_NEXT()
+        _OP(0x79,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x79,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0x79,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0x79,4): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x79,5): _FETCH();_NEXT()
+        _OP(0x79,6): assert(false);_NEXT()
+        _OP(0x79,7): assert(false);_NEXT()
+    /* PLY  */
+        _OP(0x7A,0): _SA(c->PC);_NEXT()
+        _OP(0x7A,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0x7A,2): _SA(0x0100|c->S);_NEXT()
+        _OP(0x7A,3): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0x7A,4): assert(false);_NEXT()
+        _OP(0x7A,5): assert(false);_NEXT()
+        _OP(0x7A,6): assert(false);_NEXT()
+        _OP(0x7A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x7B,0): _FETCH();_NEXT()
+        _OP(0x7B,1): assert(false);_NEXT()
+        _OP(0x7B,2): assert(false);_NEXT()
+        _OP(0x7B,3): assert(false);_NEXT()
+        _OP(0x7B,4): assert(false);_NEXT()
+        _OP(0x7B,5): assert(false);_NEXT()
+        _OP(0x7B,6): assert(false);_NEXT()
+        _OP(0x7B,7): assert(false);_NEXT()
+    /* JMPIX  */
+        _OP(0x7C,0): _SA(c->PC++);_NEXT()
+        _OP(0x7C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7C,2): c->AD=((_GD()<<8)|c->AD)+c->X;_SA(c->PC-1);_NEXT()
+        _OP(0x7C,3): _SA(c->AD);_NEXT()
+        _OP(0x7C,4): _SA(c->AD+1);c->AD=_GD();_NEXT()
+        _OP(0x7C,5): c->PC=(_GD()<<8)|c->AD;_FETCH();_NEXT()
+        _OP(0x7C,6): assert(false);_NEXT()
+        _OP(0x7C,7): assert(false);_NEXT()
+    /* ADC abs,X */
+        _OP(0x7D,0): _SA(c->PC++);_NEXT()
+        _OP(0x7D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x7D,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7D,4): _m65c02_adc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0x7D,5): _FETCH();_NEXT()
+        _OP(0x7D,6): assert(false);_NEXT()
+        _OP(0x7D,7): assert(false);_NEXT()
+    /* ROR abs,X */
+        _OP(0x7E,0): _SA(c->PC++);_NEXT()
+        _OP(0x7E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x7E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0x7E,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0x7E,4): c->AD=_GD();_NEXT()
+        _OP(0x7E,5): _SD(_m6502_ror(c,c->AD));_WR();_NEXT()
+        _OP(0x7E,6): _FETCH();_NEXT()
+        _OP(0x7E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x7F,0): _FETCH();_NEXT()
+        _OP(0x7F,1): assert(false);_NEXT()
+        _OP(0x7F,2): assert(false);_NEXT()
+        _OP(0x7F,3): assert(false);_NEXT()
+        _OP(0x7F,4): assert(false);_NEXT()
+        _OP(0x7F,5): assert(false);_NEXT()
+        _OP(0x7F,6): assert(false);_NEXT()
+        _OP(0x7F,7): assert(false);_NEXT()
+    /* BRA # */
+        _OP(0x80,0): _SA(c->PC++);_NEXT()
+        _OP(0x80,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();_NEXT()
+        _OP(0x80,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x80,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x80,4): assert(false);_NEXT()
+        _OP(0x80,5): assert(false);_NEXT()
+        _OP(0x80,6): assert(false);_NEXT()
+        _OP(0x80,7): assert(false);_NEXT()
+    /* STA (zp,X) */
+        _OP(0x81,0): _SA(c->PC++);_NEXT()
+        _OP(0x81,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x81,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0x81,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x81,4): _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();_NEXT()
+        _OP(0x81,5): _FETCH();_NEXT()
+        _OP(0x81,6): assert(false);_NEXT()
+        _OP(0x81,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x82,0): _SA(c->PC++);_NEXT()
+        _OP(0x82,1): _FETCH();_NEXT()
+        _OP(0x82,2): assert(false);_NEXT()
+        _OP(0x82,3): assert(false);_NEXT()
+        _OP(0x82,4): assert(false);_NEXT()
+        _OP(0x82,5): assert(false);_NEXT()
+        _OP(0x82,6): assert(false);_NEXT()
+        _OP(0x82,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x83,0): _FETCH();_NEXT()
+        _OP(0x83,1): assert(false);_NEXT()
+        _OP(0x83,2): assert(false);_NEXT()
+        _OP(0x83,3): assert(false);_NEXT()
+        _OP(0x83,4): assert(false);_NEXT()
+        _OP(0x83,5): assert(false);_NEXT()
+        _OP(0x83,6): assert(false);_NEXT()
+        _OP(0x83,7): assert(false);_NEXT()
+    /* STY zp */
+        _OP(0x84,0): _SA(c->PC++);_NEXT()
+        _OP(0x84,1): _SA(_GD());_SD(c->Y);_WR();_NEXT()
+        _OP(0x84,2): _FETCH();_NEXT()
+        _OP(0x84,3): assert(false);_NEXT()
+        _OP(0x84,4): assert(false);_NEXT()
+        _OP(0x84,5): assert(false);_NEXT()
+        _OP(0x84,6): assert(false);_NEXT()
+        _OP(0x84,7): assert(false);_NEXT()
+    /* STA zp */
+        _OP(0x85,0): _SA(c->PC++);_NEXT()
+        _OP(0x85,1): _SA(_GD());_SD(c->A);_WR();_NEXT()
+        _OP(0x85,2): _FETCH();_NEXT()
+        _OP(0x85,3): assert(false);_NEXT()
+        _OP(0x85,4): assert(false);_NEXT()
+        _OP(0x85,5): assert(false);_NEXT()
+        _OP(0x85,6): assert(false);_NEXT()
+        _OP(0x85,7): assert(false);_NEXT()
+    /* STX zp */
+        _OP(0x86,0): _SA(c->PC++);_NEXT()
+        _OP(0x86,1): _SA(_GD());_SD(c->X);_WR();_NEXT()
+        _OP(0x86,2): _FETCH();_NEXT()
+        _OP(0x86,3): assert(false);_NEXT()
+        _OP(0x86,4): assert(false);_NEXT()
+        _OP(0x86,5): assert(false);_NEXT()
+        _OP(0x86,6): assert(false);_NEXT()
+        _OP(0x86,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x87,0): _FETCH();_NEXT()
+        _OP(0x87,1): assert(false);_NEXT()
+        _OP(0x87,2): assert(false);_NEXT()
+        _OP(0x87,3): assert(false);_NEXT()
+        _OP(0x87,4): assert(false);_NEXT()
+        _OP(0x87,5): assert(false);_NEXT()
+        _OP(0x87,6): assert(false);_NEXT()
+        _OP(0x87,7): assert(false);_NEXT()
+    /* DEY  */
+        _OP(0x88,0): _SA(c->PC);_NEXT()
+        _OP(0x88,1): c->Y--;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0x88,2): assert(false);_NEXT()
+        _OP(0x88,3): assert(false);_NEXT()
+        _OP(0x88,4): assert(false);_NEXT()
+        _OP(0x88,5): assert(false);_NEXT()
+        _OP(0x88,6): assert(false);_NEXT()
+        _OP(0x88,7): assert(false);_NEXT()
+    /* BIT # */
+        _OP(0x89,0): _SA(c->PC++);_NEXT()
+        _OP(0x89,1): if(c->A&_GD()){c->P&=~M6502_ZF;}else{c->P|=M6502_ZF;}_FETCH();_NEXT()
+        _OP(0x89,2): assert(false);_NEXT()
+        _OP(0x89,3): assert(false);_NEXT()
+        _OP(0x89,4): assert(false);_NEXT()
+        _OP(0x89,5): assert(false);_NEXT()
+        _OP(0x89,6): assert(false);_NEXT()
+        _OP(0x89,7): assert(false);_NEXT()
+    /* TXA  */
+        _OP(0x8A,0): _SA(c->PC);_NEXT()
+        _OP(0x8A,1): c->A=c->X;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x8A,2): assert(false);_NEXT()
+        _OP(0x8A,3): assert(false);_NEXT()
+        _OP(0x8A,4): assert(false);_NEXT()
+        _OP(0x8A,5): assert(false);_NEXT()
+        _OP(0x8A,6): assert(false);_NEXT()
+        _OP(0x8A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x8B,0): _FETCH();_NEXT()
+        _OP(0x8B,1): assert(false);_NEXT()
+        _OP(0x8B,2): assert(false);_NEXT()
+        _OP(0x8B,3): assert(false);_NEXT()
+        _OP(0x8B,4): assert(false);_NEXT()
+        _OP(0x8B,5): assert(false);_NEXT()
+        _OP(0x8B,6): assert(false);_NEXT()
+        _OP(0x8B,7): assert(false);_NEXT()
+    /* STY abs */
+        _OP(0x8C,0): _SA(c->PC++);_NEXT()
+        _OP(0x8C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8C,2): _SA((_GD()<<8)|c->AD);_SD(c->Y);_WR();_NEXT()
+        _OP(0x8C,3): _FETCH();_NEXT()
+        _OP(0x8C,4): assert(false);_NEXT()
+        _OP(0x8C,5): assert(false);_NEXT()
+        _OP(0x8C,6): assert(false);_NEXT()
+        _OP(0x8C,7): assert(false);_NEXT()
+    /* STA abs */
+        _OP(0x8D,0): _SA(c->PC++);_NEXT()
+        _OP(0x8D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8D,2): _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();_NEXT()
+        _OP(0x8D,3): _FETCH();_NEXT()
+        _OP(0x8D,4): assert(false);_NEXT()
+        _OP(0x8D,5): assert(false);_NEXT()
+        _OP(0x8D,6): assert(false);_NEXT()
+        _OP(0x8D,7): assert(false);_NEXT()
+    /* STX abs */
+        _OP(0x8E,0): _SA(c->PC++);_NEXT()
+        _OP(0x8E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x8E,2): _SA((_GD()<<8)|c->AD);_SD(c->X);_WR();_NEXT()
+        _OP(0x8E,3): _FETCH();_NEXT()
+        _OP(0x8E,4): assert(false);_NEXT()
+        _OP(0x8E,5): assert(false);_NEXT()
+        _OP(0x8E,6): assert(false);_NEXT()
+        _OP(0x8E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x8F,0): _FETCH();_NEXT()
+        _OP(0x8F,1): assert(false);_NEXT()
+        _OP(0x8F,2): assert(false);_NEXT()
+        _OP(0x8F,3): assert(false);_NEXT()
+        _OP(0x8F,4): assert(false);_NEXT()
+        _OP(0x8F,5): assert(false);_NEXT()
+        _OP(0x8F,6): assert(false);_NEXT()
+        _OP(0x8F,7): assert(false);_NEXT()
+    /* BCC # */
+        _OP(0x90,0): _SA(c->PC++);_NEXT()
+        _OP(0x90,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x1)!=0x0){_FETCH();};_NEXT()
+        _OP(0x90,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0x90,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0x90,4): assert(false);_NEXT()
+        _OP(0x90,5): assert(false);_NEXT()
+        _OP(0x90,6): assert(false);_NEXT()
+        _OP(0x90,7): assert(false);_NEXT()
+    /* STA (zp),Y */
+        _OP(0x91,0): _SA(c->PC++);_NEXT()
+        _OP(0x91,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x91,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x91,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x91,4): _SA(c->AD+c->Y);_SD(c->A);_WR();_NEXT()
+        _OP(0x91,5): _FETCH();_NEXT()
+        _OP(0x91,6): assert(false);_NEXT()
+        _OP(0x91,7): assert(false);_NEXT()
+    /* STA (zp) */
+        _OP(0x92,0): _SA(c->PC++);_NEXT()
+        _OP(0x92,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x92,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0x92,3): _SA((_GD()<<8)|c->AD);_SD(c->A);_WR();_NEXT()
+        _OP(0x92,4): _FETCH();_NEXT()
+        _OP(0x92,5): assert(false);_NEXT()
+        _OP(0x92,6): assert(false);_NEXT()
+        _OP(0x92,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x93,0): _FETCH();_NEXT()
+        _OP(0x93,1): assert(false);_NEXT()
+        _OP(0x93,2): assert(false);_NEXT()
+        _OP(0x93,3): assert(false);_NEXT()
+        _OP(0x93,4): assert(false);_NEXT()
+        _OP(0x93,5): assert(false);_NEXT()
+        _OP(0x93,6): assert(false);_NEXT()
+        _OP(0x93,7): assert(false);_NEXT()
+    /* STY zp,X */
+        _OP(0x94,0): _SA(c->PC++);_NEXT()
+        _OP(0x94,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x94,2): _SA((c->AD+c->X)&0x00FF);_SD(c->Y);_WR();_NEXT()
+        _OP(0x94,3): _FETCH();_NEXT()
+        _OP(0x94,4): assert(false);_NEXT()
+        _OP(0x94,5): assert(false);_NEXT()
+        _OP(0x94,6): assert(false);_NEXT()
+        _OP(0x94,7): assert(false);_NEXT()
+    /* STA zp,X */
+        _OP(0x95,0): _SA(c->PC++);_NEXT()
+        _OP(0x95,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x95,2): _SA((c->AD+c->X)&0x00FF);_SD(c->A);_WR();_NEXT()
+        _OP(0x95,3): _FETCH();_NEXT()
+        _OP(0x95,4): assert(false);_NEXT()
+        _OP(0x95,5): assert(false);_NEXT()
+        _OP(0x95,6): assert(false);_NEXT()
+        _OP(0x95,7): assert(false);_NEXT()
+    /* STX zp,Y */
+        _OP(0x96,0): _SA(c->PC++);_NEXT()
+        _OP(0x96,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0x96,2): _SA((c->AD+c->Y)&0x00FF);_SD(c->X);_WR();_NEXT()
+        _OP(0x96,3): _FETCH();_NEXT()
+        _OP(0x96,4): assert(false);_NEXT()
+        _OP(0x96,5): assert(false);_NEXT()
+        _OP(0x96,6): assert(false);_NEXT()
+        _OP(0x96,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x97,0): _FETCH();_NEXT()
+        _OP(0x97,1): assert(false);_NEXT()
+        _OP(0x97,2): assert(false);_NEXT()
+        _OP(0x97,3): assert(false);_NEXT()
+        _OP(0x97,4): assert(false);_NEXT()
+        _OP(0x97,5): assert(false);_NEXT()
+        _OP(0x97,6): assert(false);_NEXT()
+        _OP(0x97,7): assert(false);_NEXT()
+    /* TYA  */
+        _OP(0x98,0): _SA(c->PC);_NEXT()
+        _OP(0x98,1): c->A=c->Y;_NZ(c->A);_FETCH();_NEXT()
+        _OP(0x98,2): assert(false);_NEXT()
+        _OP(0x98,3): assert(false);_NEXT()
+        _OP(0x98,4): assert(false);_NEXT()
+        _OP(0x98,5): assert(false);_NEXT()
+        _OP(0x98,6): assert(false);_NEXT()
+        _OP(0x98,7): assert(false);_NEXT()
+    /* STA abs,Y */
+        _OP(0x99,0): _SA(c->PC++);_NEXT()
+        _OP(0x99,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x99,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));_NEXT()
+        _OP(0x99,3): _SA(c->AD+c->Y);_SD(c->A);_WR();_NEXT()
+        _OP(0x99,4): _FETCH();_NEXT()
+        _OP(0x99,5): assert(false);_NEXT()
+        _OP(0x99,6): assert(false);_NEXT()
+        _OP(0x99,7): assert(false);_NEXT()
+    /* TXS  */
+        _OP(0x9A,0): _SA(c->PC);_NEXT()
+        _OP(0x9A,1): c->S=c->X;_FETCH();_NEXT()
+        _OP(0x9A,2): assert(false);_NEXT()
+        _OP(0x9A,3): assert(false);_NEXT()
+        _OP(0x9A,4): assert(false);_NEXT()
+        _OP(0x9A,5): assert(false);_NEXT()
+        _OP(0x9A,6): assert(false);_NEXT()
+        _OP(0x9A,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x9B,0): _FETCH();_NEXT()
+        _OP(0x9B,1): assert(false);_NEXT()
+        _OP(0x9B,2): assert(false);_NEXT()
+        _OP(0x9B,3): assert(false);_NEXT()
+        _OP(0x9B,4): assert(false);_NEXT()
+        _OP(0x9B,5): assert(false);_NEXT()
+        _OP(0x9B,6): assert(false);_NEXT()
+        _OP(0x9B,7): assert(false);_NEXT()
+    /* STZ abs */
+        _OP(0x9C,0): _SA(c->PC++);_NEXT()
+        _OP(0x9C,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9C,2): _SA((_GD()<<8)|c->AD);_SD(0);_WR();_NEXT()
+        _OP(0x9C,3): _FETCH();_NEXT()
+        _OP(0x9C,4): assert(false);_NEXT()
+        _OP(0x9C,5): assert(false);_NEXT()
+        _OP(0x9C,6): assert(false);_NEXT()
+        _OP(0x9C,7): assert(false);_NEXT()
+    /* STA abs,X */
+        _OP(0x9D,0): _SA(c->PC++);_NEXT()
+        _OP(0x9D,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9D,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x9D,3): _SA(c->AD+c->X);_SD(c->A);_WR();_NEXT()
+        _OP(0x9D,4): _FETCH();_NEXT()
+        _OP(0x9D,5): assert(false);_NEXT()
+        _OP(0x9D,6): assert(false);_NEXT()
+        _OP(0x9D,7): assert(false);_NEXT()
+    /* STZ abs,X */
+        _OP(0x9E,0): _SA(c->PC++);_NEXT()
+        _OP(0x9E,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0x9E,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0x9E,3): _SA(c->AD+c->X);_SD(0);_WR();_NEXT()
+        _OP(0x9E,4): _FETCH();_NEXT()
+        _OP(0x9E,5): assert(false);_NEXT()
+        _OP(0x9E,6): assert(false);_NEXT()
+        _OP(0x9E,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0x9F,0): _FETCH();_NEXT()
+        _OP(0x9F,1): assert(false);_NEXT()
+        _OP(0x9F,2): assert(false);_NEXT()
+        _OP(0x9F,3): assert(false);_NEXT()
+        _OP(0x9F,4): assert(false);_NEXT()
+        _OP(0x9F,5): assert(false);_NEXT()
+        _OP(0x9F,6): assert(false);_NEXT()
+        _OP(0x9F,7): assert(false);_NEXT()
+    /* LDY # */
+        _OP(0xA0,0): _SA(c->PC++);_NEXT()
+        _OP(0xA0,1): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA0,2): assert(false);_NEXT()
+        _OP(0xA0,3): assert(false);_NEXT()
+        _OP(0xA0,4): assert(false);_NEXT()
+        _OP(0xA0,5): assert(false);_NEXT()
+        _OP(0xA0,6): assert(false);_NEXT()
+        _OP(0xA0,7): assert(false);_NEXT()
+    /* LDA (zp,X) */
+        _OP(0xA1,0): _SA(c->PC++);_NEXT()
+        _OP(0xA1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xA1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xA1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xA1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xA1,5): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA1,6): assert(false);_NEXT()
+        _OP(0xA1,7): assert(false);_NEXT()
+    /* LDX # */
+        _OP(0xA2,0): _SA(c->PC++);_NEXT()
+        _OP(0xA2,1): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xA2,2): assert(false);_NEXT()
+        _OP(0xA2,3): assert(false);_NEXT()
+        _OP(0xA2,4): assert(false);_NEXT()
+        _OP(0xA2,5): assert(false);_NEXT()
+        _OP(0xA2,6): assert(false);_NEXT()
+        _OP(0xA2,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xA3,0): _FETCH();_NEXT()
+        _OP(0xA3,1): assert(false);_NEXT()
+        _OP(0xA3,2): assert(false);_NEXT()
+        _OP(0xA3,3): assert(false);_NEXT()
+        _OP(0xA3,4): assert(false);_NEXT()
+        _OP(0xA3,5): assert(false);_NEXT()
+        _OP(0xA3,6): assert(false);_NEXT()
+        _OP(0xA3,7): assert(false);_NEXT()
+    /* LDY zp */
+        _OP(0xA4,0): _SA(c->PC++);_NEXT()
+        _OP(0xA4,1): _SA(_GD());_NEXT()
+        _OP(0xA4,2): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA4,3): assert(false);_NEXT()
+        _OP(0xA4,4): assert(false);_NEXT()
+        _OP(0xA4,5): assert(false);_NEXT()
+        _OP(0xA4,6): assert(false);_NEXT()
+        _OP(0xA4,7): assert(false);_NEXT()
+    /* LDA zp */
+        _OP(0xA5,0): _SA(c->PC++);_NEXT()
+        _OP(0xA5,1): _SA(_GD());_NEXT()
+        _OP(0xA5,2): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA5,3): assert(false);_NEXT()
+        _OP(0xA5,4): assert(false);_NEXT()
+        _OP(0xA5,5): assert(false);_NEXT()
+        _OP(0xA5,6): assert(false);_NEXT()
+        _OP(0xA5,7): assert(false);_NEXT()
+    /* LDX zp */
+        _OP(0xA6,0): _SA(c->PC++);_NEXT()
+        _OP(0xA6,1): _SA(_GD());_NEXT()
+        _OP(0xA6,2): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xA6,3): assert(false);_NEXT()
+        _OP(0xA6,4): assert(false);_NEXT()
+        _OP(0xA6,5): assert(false);_NEXT()
+        _OP(0xA6,6): assert(false);_NEXT()
+        _OP(0xA6,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xA7,0): _FETCH();_NEXT()
+        _OP(0xA7,1): assert(false);_NEXT()
+        _OP(0xA7,2): assert(false);_NEXT()
+        _OP(0xA7,3): assert(false);_NEXT()
+        _OP(0xA7,4): assert(false);_NEXT()
+        _OP(0xA7,5): assert(false);_NEXT()
+        _OP(0xA7,6): assert(false);_NEXT()
+        _OP(0xA7,7): assert(false);_NEXT()
+    /* TAY  */
+        _OP(0xA8,0): _SA(c->PC);_NEXT()
+        _OP(0xA8,1): c->Y=c->A;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xA8,2): assert(false);_NEXT()
+        _OP(0xA8,3): assert(false);_NEXT()
+        _OP(0xA8,4): assert(false);_NEXT()
+        _OP(0xA8,5): assert(false);_NEXT()
+        _OP(0xA8,6): assert(false);_NEXT()
+        _OP(0xA8,7): assert(false);_NEXT()
+    /* LDA # */
+        _OP(0xA9,0): _SA(c->PC++);_NEXT()
+        _OP(0xA9,1): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xA9,2): assert(false);_NEXT()
+        _OP(0xA9,3): assert(false);_NEXT()
+        _OP(0xA9,4): assert(false);_NEXT()
+        _OP(0xA9,5): assert(false);_NEXT()
+        _OP(0xA9,6): assert(false);_NEXT()
+        _OP(0xA9,7): assert(false);_NEXT()
+    /* TAX  */
+        _OP(0xAA,0): _SA(c->PC);_NEXT()
+        _OP(0xAA,1): c->X=c->A;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xAA,2): assert(false);_NEXT()
+        _OP(0xAA,3): assert(false);_NEXT()
+        _OP(0xAA,4): assert(false);_NEXT()
+        _OP(0xAA,5): assert(false);_NEXT()
+        _OP(0xAA,6): assert(false);_NEXT()
+        _OP(0xAA,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xAB,0): _FETCH();_NEXT()
+        _OP(0xAB,1): assert(false);_NEXT()
+        _OP(0xAB,2): assert(false);_NEXT()
+        _OP(0xAB,3): assert(false);_NEXT()
+        _OP(0xAB,4): assert(false);_NEXT()
+        _OP(0xAB,5): assert(false);_NEXT()
+        _OP(0xAB,6): assert(false);_NEXT()
+        _OP(0xAB,7): assert(false);_NEXT()
+    /* LDY abs */
+        _OP(0xAC,0): _SA(c->PC++);_NEXT()
+        _OP(0xAC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAC,3): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xAC,4): assert(false);_NEXT()
+        _OP(0xAC,5): assert(false);_NEXT()
+        _OP(0xAC,6): assert(false);_NEXT()
+        _OP(0xAC,7): assert(false);_NEXT()
+    /* LDA abs */
+        _OP(0xAD,0): _SA(c->PC++);_NEXT()
+        _OP(0xAD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAD,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAD,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xAD,4): assert(false);_NEXT()
+        _OP(0xAD,5): assert(false);_NEXT()
+        _OP(0xAD,6): assert(false);_NEXT()
+        _OP(0xAD,7): assert(false);_NEXT()
+    /* LDX abs */
+        _OP(0xAE,0): _SA(c->PC++);_NEXT()
+        _OP(0xAE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xAE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xAE,3): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xAE,4): assert(false);_NEXT()
+        _OP(0xAE,5): assert(false);_NEXT()
+        _OP(0xAE,6): assert(false);_NEXT()
+        _OP(0xAE,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xAF,0): _FETCH();_NEXT()
+        _OP(0xAF,1): assert(false);_NEXT()
+        _OP(0xAF,2): assert(false);_NEXT()
+        _OP(0xAF,3): assert(false);_NEXT()
+        _OP(0xAF,4): assert(false);_NEXT()
+        _OP(0xAF,5): assert(false);_NEXT()
+        _OP(0xAF,6): assert(false);_NEXT()
+        _OP(0xAF,7): assert(false);_NEXT()
+    /* BCS # */
+        _OP(0xB0,0): _SA(c->PC++);_NEXT()
+        _OP(0xB0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x1)!=0x1){_FETCH();};_NEXT()
+        _OP(0xB0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xB0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xB0,4): assert(false);_NEXT()
+        _OP(0xB0,5): assert(false);_NEXT()
+        _OP(0xB0,6): assert(false);_NEXT()
+        _OP(0xB0,7): assert(false);_NEXT()
+    /* LDA (zp),Y */
+        _OP(0xB1,0): _SA(c->PC++);_NEXT()
+        _OP(0xB1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xB1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xB1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xB1,5): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB1,6): assert(false);_NEXT()
+        _OP(0xB1,7): assert(false);_NEXT()
+    /* LDA (zp) */
+        _OP(0xB2,0): _SA(c->PC++);_NEXT()
+        _OP(0xB2,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB2,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xB2,3): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xB2,4): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB2,5): assert(false);_NEXT()
+        _OP(0xB2,6): assert(false);_NEXT()
+        _OP(0xB2,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xB3,0): _FETCH();_NEXT()
+        _OP(0xB3,1): assert(false);_NEXT()
+        _OP(0xB3,2): assert(false);_NEXT()
+        _OP(0xB3,3): assert(false);_NEXT()
+        _OP(0xB3,4): assert(false);_NEXT()
+        _OP(0xB3,5): assert(false);_NEXT()
+        _OP(0xB3,6): assert(false);_NEXT()
+        _OP(0xB3,7): assert(false);_NEXT()
+    /* LDY zp,X */
+        _OP(0xB4,0): _SA(c->PC++);_NEXT()
+        _OP(0xB4,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB4,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xB4,3): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xB4,4): assert(false);_NEXT()
+        _OP(0xB4,5): assert(false);_NEXT()
+        _OP(0xB4,6): assert(false);_NEXT()
+        _OP(0xB4,7): assert(false);_NEXT()
+    /* LDA zp,X */
+        _OP(0xB5,0): _SA(c->PC++);_NEXT()
+        _OP(0xB5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xB5,3): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB5,4): assert(false);_NEXT()
+        _OP(0xB5,5): assert(false);_NEXT()
+        _OP(0xB5,6): assert(false);_NEXT()
+        _OP(0xB5,7): assert(false);_NEXT()
+    /* LDX zp,Y */
+        _OP(0xB6,0): _SA(c->PC++);_NEXT()
+        _OP(0xB6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xB6,2): _SA((c->AD+c->Y)&0x00FF);_NEXT()
+        _OP(0xB6,3): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xB6,4): assert(false);_NEXT()
+        _OP(0xB6,5): assert(false);_NEXT()
+        _OP(0xB6,6): assert(false);_NEXT()
+        _OP(0xB6,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xB7,0): _FETCH();_NEXT()
+        _OP(0xB7,1): assert(false);_NEXT()
+        _OP(0xB7,2): assert(false);_NEXT()
+        _OP(0xB7,3): assert(false);_NEXT()
+        _OP(0xB7,4): assert(false);_NEXT()
+        _OP(0xB7,5): assert(false);_NEXT()
+        _OP(0xB7,6): assert(false);_NEXT()
+        _OP(0xB7,7): assert(false);_NEXT()
+    /* CLV  */
+        _OP(0xB8,0): _SA(c->PC);_NEXT()
+        _OP(0xB8,1): c->P&=~0x40;_FETCH();_NEXT()
+        _OP(0xB8,2): assert(false);_NEXT()
+        _OP(0xB8,3): assert(false);_NEXT()
+        _OP(0xB8,4): assert(false);_NEXT()
+        _OP(0xB8,5): assert(false);_NEXT()
+        _OP(0xB8,6): assert(false);_NEXT()
+        _OP(0xB8,7): assert(false);_NEXT()
+    /* LDA abs,Y */
+        _OP(0xB9,0): _SA(c->PC++);_NEXT()
+        _OP(0xB9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xB9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xB9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xB9,4): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xB9,5): assert(false);_NEXT()
+        _OP(0xB9,6): assert(false);_NEXT()
+        _OP(0xB9,7): assert(false);_NEXT()
+    /* TSX  */
+        _OP(0xBA,0): _SA(c->PC);_NEXT()
+        _OP(0xBA,1): c->X=c->S;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xBA,2): assert(false);_NEXT()
+        _OP(0xBA,3): assert(false);_NEXT()
+        _OP(0xBA,4): assert(false);_NEXT()
+        _OP(0xBA,5): assert(false);_NEXT()
+        _OP(0xBA,6): assert(false);_NEXT()
+        _OP(0xBA,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xBB,0): _FETCH();_NEXT()
+        _OP(0xBB,1): assert(false);_NEXT()
+        _OP(0xBB,2): assert(false);_NEXT()
+        _OP(0xBB,3): assert(false);_NEXT()
+        _OP(0xBB,4): assert(false);_NEXT()
+        _OP(0xBB,5): assert(false);_NEXT()
+        _OP(0xBB,6): assert(false);_NEXT()
+        _OP(0xBB,7): assert(false);_NEXT()
+    /* LDY abs,X */
+        _OP(0xBC,0): _SA(c->PC++);_NEXT()
+        _OP(0xBC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBC,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xBC,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xBC,4): c->Y=_GD();_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xBC,5): assert(false);_NEXT()
+        _OP(0xBC,6): assert(false);_NEXT()
+        _OP(0xBC,7): assert(false);_NEXT()
+    /* LDA abs,X */
+        _OP(0xBD,0): _SA(c->PC++);_NEXT()
+        _OP(0xBD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xBD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xBD,4): c->A=_GD();_NZ(c->A);_FETCH();_NEXT()
+        _OP(0xBD,5): assert(false);_NEXT()
+        _OP(0xBD,6): assert(false);_NEXT()
+        _OP(0xBD,7): assert(false);_NEXT()
+    /* LDX abs,Y */
+        _OP(0xBE,0): _SA(c->PC++);_NEXT()
+        _OP(0xBE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xBE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xBE,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xBE,4): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xBE,5): assert(false);_NEXT()
+        _OP(0xBE,6): assert(false);_NEXT()
+        _OP(0xBE,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xBF,0): _FETCH();_NEXT()
+        _OP(0xBF,1): assert(false);_NEXT()
+        _OP(0xBF,2): assert(false);_NEXT()
+        _OP(0xBF,3): assert(false);_NEXT()
+        _OP(0xBF,4): assert(false);_NEXT()
+        _OP(0xBF,5): assert(false);_NEXT()
+        _OP(0xBF,6): assert(false);_NEXT()
+        _OP(0xBF,7): assert(false);_NEXT()
+    /* CPY # */
+        _OP(0xC0,0): _SA(c->PC++);_NEXT()
+        _OP(0xC0,1): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xC0,2): assert(false);_NEXT()
+        _OP(0xC0,3): assert(false);_NEXT()
+        _OP(0xC0,4): assert(false);_NEXT()
+        _OP(0xC0,5): assert(false);_NEXT()
+        _OP(0xC0,6): assert(false);_NEXT()
+        _OP(0xC0,7): assert(false);_NEXT()
+    /* CMP (zp,X) */
+        _OP(0xC1,0): _SA(c->PC++);_NEXT()
+        _OP(0xC1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xC1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xC1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xC1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xC1,5): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC1,6): assert(false);_NEXT()
+        _OP(0xC1,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xC2,0): _SA(c->PC++);_NEXT()
+        _OP(0xC2,1): _FETCH();_NEXT()
+        _OP(0xC2,2): assert(false);_NEXT()
+        _OP(0xC2,3): assert(false);_NEXT()
+        _OP(0xC2,4): assert(false);_NEXT()
+        _OP(0xC2,5): assert(false);_NEXT()
+        _OP(0xC2,6): assert(false);_NEXT()
+        _OP(0xC2,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xC3,0): _FETCH();_NEXT()
+        _OP(0xC3,1): assert(false);_NEXT()
+        _OP(0xC3,2): assert(false);_NEXT()
+        _OP(0xC3,3): assert(false);_NEXT()
+        _OP(0xC3,4): assert(false);_NEXT()
+        _OP(0xC3,5): assert(false);_NEXT()
+        _OP(0xC3,6): assert(false);_NEXT()
+        _OP(0xC3,7): assert(false);_NEXT()
+    /* CPY zp */
+        _OP(0xC4,0): _SA(c->PC++);_NEXT()
+        _OP(0xC4,1): _SA(_GD());_NEXT()
+        _OP(0xC4,2): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xC4,3): assert(false);_NEXT()
+        _OP(0xC4,4): assert(false);_NEXT()
+        _OP(0xC4,5): assert(false);_NEXT()
+        _OP(0xC4,6): assert(false);_NEXT()
+        _OP(0xC4,7): assert(false);_NEXT()
+    /* CMP zp */
+        _OP(0xC5,0): _SA(c->PC++);_NEXT()
+        _OP(0xC5,1): _SA(_GD());_NEXT()
+        _OP(0xC5,2): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC5,3): assert(false);_NEXT()
+        _OP(0xC5,4): assert(false);_NEXT()
+        _OP(0xC5,5): assert(false);_NEXT()
+        _OP(0xC5,6): assert(false);_NEXT()
+        _OP(0xC5,7): assert(false);_NEXT()
+    /* DEC zp */
+        _OP(0xC6,0): _SA(c->PC++);_NEXT()
+        _OP(0xC6,1): _SA(_GD());_NEXT()
+        _OP(0xC6,2): c->AD=_GD();_NEXT()
+        _OP(0xC6,3): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xC6,4): _FETCH();_NEXT()
+        _OP(0xC6,5): assert(false);_NEXT()
+        _OP(0xC6,6): assert(false);_NEXT()
+        _OP(0xC6,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xC7,0): _FETCH();_NEXT()
+        _OP(0xC7,1): assert(false);_NEXT()
+        _OP(0xC7,2): assert(false);_NEXT()
+        _OP(0xC7,3): assert(false);_NEXT()
+        _OP(0xC7,4): assert(false);_NEXT()
+        _OP(0xC7,5): assert(false);_NEXT()
+        _OP(0xC7,6): assert(false);_NEXT()
+        _OP(0xC7,7): assert(false);_NEXT()
+    /* INY  */
+        _OP(0xC8,0): _SA(c->PC);_NEXT()
+        _OP(0xC8,1): c->Y++;_NZ(c->Y);_FETCH();_NEXT()
+        _OP(0xC8,2): assert(false);_NEXT()
+        _OP(0xC8,3): assert(false);_NEXT()
+        _OP(0xC8,4): assert(false);_NEXT()
+        _OP(0xC8,5): assert(false);_NEXT()
+        _OP(0xC8,6): assert(false);_NEXT()
+        _OP(0xC8,7): assert(false);_NEXT()
+    /* CMP # */
+        _OP(0xC9,0): _SA(c->PC++);_NEXT()
+        _OP(0xC9,1): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xC9,2): assert(false);_NEXT()
+        _OP(0xC9,3): assert(false);_NEXT()
+        _OP(0xC9,4): assert(false);_NEXT()
+        _OP(0xC9,5): assert(false);_NEXT()
+        _OP(0xC9,6): assert(false);_NEXT()
+        _OP(0xC9,7): assert(false);_NEXT()
+    /* DEX  */
+        _OP(0xCA,0): _SA(c->PC);_NEXT()
+        _OP(0xCA,1): c->X--;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xCA,2): assert(false);_NEXT()
+        _OP(0xCA,3): assert(false);_NEXT()
+        _OP(0xCA,4): assert(false);_NEXT()
+        _OP(0xCA,5): assert(false);_NEXT()
+        _OP(0xCA,6): assert(false);_NEXT()
+        _OP(0xCA,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xCB,0): _FETCH();_NEXT()
+        _OP(0xCB,1): assert(false);_NEXT()
+        _OP(0xCB,2): assert(false);_NEXT()
+        _OP(0xCB,3): assert(false);_NEXT()
+        _OP(0xCB,4): assert(false);_NEXT()
+        _OP(0xCB,5): assert(false);_NEXT()
+        _OP(0xCB,6): assert(false);_NEXT()
+        _OP(0xCB,7): assert(false);_NEXT()
+    /* CPY abs */
+        _OP(0xCC,0): _SA(c->PC++);_NEXT()
+        _OP(0xCC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCC,3): _m6502_cmp(c, c->Y, _GD());_FETCH();_NEXT()
+        _OP(0xCC,4): assert(false);_NEXT()
+        _OP(0xCC,5): assert(false);_NEXT()
+        _OP(0xCC,6): assert(false);_NEXT()
+        _OP(0xCC,7): assert(false);_NEXT()
+    /* CMP abs */
+        _OP(0xCD,0): _SA(c->PC++);_NEXT()
+        _OP(0xCD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCD,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCD,3): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xCD,4): assert(false);_NEXT()
+        _OP(0xCD,5): assert(false);_NEXT()
+        _OP(0xCD,6): assert(false);_NEXT()
+        _OP(0xCD,7): assert(false);_NEXT()
+    /* DEC abs */
+        _OP(0xCE,0): _SA(c->PC++);_NEXT()
+        _OP(0xCE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xCE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xCE,3): c->AD=_GD();_NEXT()
+        _OP(0xCE,4): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xCE,5): _FETCH();_NEXT()
+        _OP(0xCE,6): assert(false);_NEXT()
+        _OP(0xCE,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xCF,0): _FETCH();_NEXT()
+        _OP(0xCF,1): assert(false);_NEXT()
+        _OP(0xCF,2): assert(false);_NEXT()
+        _OP(0xCF,3): assert(false);_NEXT()
+        _OP(0xCF,4): assert(false);_NEXT()
+        _OP(0xCF,5): assert(false);_NEXT()
+        _OP(0xCF,6): assert(false);_NEXT()
+        _OP(0xCF,7): assert(false);_NEXT()
+    /* BNE # */
+        _OP(0xD0,0): _SA(c->PC++);_NEXT()
+        _OP(0xD0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x2)!=0x0){_FETCH();};_NEXT()
+        _OP(0xD0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xD0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xD0,4): assert(false);_NEXT()
+        _OP(0xD0,5): assert(false);_NEXT()
+        _OP(0xD0,6): assert(false);_NEXT()
+        _OP(0xD0,7): assert(false);_NEXT()
+    /* CMP (zp),Y */
+        _OP(0xD1,0): _SA(c->PC++);_NEXT()
+        _OP(0xD1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xD1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xD1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xD1,5): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD1,6): assert(false);_NEXT()
+        _OP(0xD1,7): assert(false);_NEXT()
+    /* CMP (zp) */
+        _OP(0xD2,0): _SA(c->PC++);_NEXT()
+        _OP(0xD2,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD2,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xD2,3): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xD2,4): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD2,5): assert(false);_NEXT()
+        _OP(0xD2,6): assert(false);_NEXT()
+        _OP(0xD2,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xD3,0): _FETCH();_NEXT()
+        _OP(0xD3,1): assert(false);_NEXT()
+        _OP(0xD3,2): assert(false);_NEXT()
+        _OP(0xD3,3): assert(false);_NEXT()
+        _OP(0xD3,4): assert(false);_NEXT()
+        _OP(0xD3,5): assert(false);_NEXT()
+        _OP(0xD3,6): assert(false);_NEXT()
+        _OP(0xD3,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xD4,0): _SA(c->PC++);_NEXT()
+        _OP(0xD4,1): _SA(c->PC);_NEXT()
+        _OP(0xD4,2): _SA(c->PC);_NEXT()
+        _OP(0xD4,3): _FETCH();_NEXT()
+        _OP(0xD4,4): assert(false);_NEXT()
+        _OP(0xD4,5): assert(false);_NEXT()
+        _OP(0xD4,6): assert(false);_NEXT()
+        _OP(0xD4,7): assert(false);_NEXT()
+    /* CMP zp,X */
+        _OP(0xD5,0): _SA(c->PC++);_NEXT()
+        _OP(0xD5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD5,3): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD5,4): assert(false);_NEXT()
+        _OP(0xD5,5): assert(false);_NEXT()
+        _OP(0xD5,6): assert(false);_NEXT()
+        _OP(0xD5,7): assert(false);_NEXT()
+    /* DEC zp,X */
+        _OP(0xD6,0): _SA(c->PC++);_NEXT()
+        _OP(0xD6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xD6,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xD6,3): c->AD=_GD();_NEXT()
+        _OP(0xD6,4): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xD6,5): _FETCH();_NEXT()
+        _OP(0xD6,6): assert(false);_NEXT()
+        _OP(0xD6,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xD7,0): _FETCH();_NEXT()
+        _OP(0xD7,1): assert(false);_NEXT()
+        _OP(0xD7,2): assert(false);_NEXT()
+        _OP(0xD7,3): assert(false);_NEXT()
+        _OP(0xD7,4): assert(false);_NEXT()
+        _OP(0xD7,5): assert(false);_NEXT()
+        _OP(0xD7,6): assert(false);_NEXT()
+        _OP(0xD7,7): assert(false);_NEXT()
+    /* CLD  */
+        _OP(0xD8,0): _SA(c->PC);_NEXT()
+        _OP(0xD8,1): c->P&=~0x8;_FETCH();_NEXT()
+        _OP(0xD8,2): assert(false);_NEXT()
+        _OP(0xD8,3): assert(false);_NEXT()
+        _OP(0xD8,4): assert(false);_NEXT()
+        _OP(0xD8,5): assert(false);_NEXT()
+        _OP(0xD8,6): assert(false);_NEXT()
+        _OP(0xD8,7): assert(false);_NEXT()
+    /* CMP abs,Y */
+        _OP(0xD9,0): _SA(c->PC++);_NEXT()
+        _OP(0xD9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xD9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xD9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xD9,4): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xD9,5): assert(false);_NEXT()
+        _OP(0xD9,6): assert(false);_NEXT()
+        _OP(0xD9,7): assert(false);_NEXT()
+    /* PHX  */
+        _OP(0xDA,0): _SA(c->PC);_NEXT()
+        _OP(0xDA,1): _SAD(0x0100|c->S--,c->X);_WR();_NEXT()
+        _OP(0xDA,2): _FETCH();_NEXT()
+        _OP(0xDA,3): assert(false);_NEXT()
+        _OP(0xDA,4): assert(false);_NEXT()
+        _OP(0xDA,5): assert(false);_NEXT()
+        _OP(0xDA,6): assert(false);_NEXT()
+        _OP(0xDA,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xDB,0): _FETCH();_NEXT()
+        _OP(0xDB,1): assert(false);_NEXT()
+        _OP(0xDB,2): assert(false);_NEXT()
+        _OP(0xDB,3): assert(false);_NEXT()
+        _OP(0xDB,4): assert(false);_NEXT()
+        _OP(0xDB,5): assert(false);_NEXT()
+        _OP(0xDB,6): assert(false);_NEXT()
+        _OP(0xDB,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xDC,0): _SA(c->PC++);_NEXT()
+        _OP(0xDC,1): _SA(c->PC++);_NEXT()
+        _OP(0xDC,2): _SA(c->PC);_NEXT()
+        _OP(0xDC,3): _FETCH();_NEXT()
+        _OP(0xDC,4): assert(false);_NEXT()
+        _OP(0xDC,5): assert(false);_NEXT()
+        _OP(0xDC,6): assert(false);_NEXT()
+        _OP(0xDC,7): assert(false);_NEXT()
+    /* CMP abs,X */
+        _OP(0xDD,0): _SA(c->PC++);_NEXT()
+        _OP(0xDD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xDD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDD,4): _m6502_cmp(c, c->A, _GD());_FETCH();_NEXT()
+        _OP(0xDD,5): assert(false);_NEXT()
+        _OP(0xDD,6): assert(false);_NEXT()
+        _OP(0xDD,7): assert(false);_NEXT()
+    /* DEC abs,X */
+        _OP(0xDE,0): _SA(c->PC++);_NEXT()
+        _OP(0xDE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xDE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xDE,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xDE,4): c->AD=_GD();_NEXT()
+        _OP(0xDE,5): c->AD--;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xDE,6): _FETCH();_NEXT()
+        _OP(0xDE,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xDF,0): _FETCH();_NEXT()
+        _OP(0xDF,1): assert(false);_NEXT()
+        _OP(0xDF,2): assert(false);_NEXT()
+        _OP(0xDF,3): assert(false);_NEXT()
+        _OP(0xDF,4): assert(false);_NEXT()
+        _OP(0xDF,5): assert(false);_NEXT()
+        _OP(0xDF,6): assert(false);_NEXT()
+        _OP(0xDF,7): assert(false);_NEXT()
+    /* CPX # */
+        _OP(0xE0,0): _SA(c->PC++);_NEXT()
+        _OP(0xE0,1): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xE0,2): assert(false);_NEXT()
+        _OP(0xE0,3): assert(false);_NEXT()
+        _OP(0xE0,4): assert(false);_NEXT()
+        _OP(0xE0,5): assert(false);_NEXT()
+        _OP(0xE0,6): assert(false);_NEXT()
+        _OP(0xE0,7): assert(false);_NEXT()
+    /* SBC (zp,X) */
+        _OP(0xE1,0): _SA(c->PC++);_NEXT()
+        _OP(0xE1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xE1,2): c->AD=(c->AD+c->X)&0xFF;_SA(c->AD);_NEXT()
+        _OP(0xE1,3): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xE1,4): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xE1,5): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xE1,6): _FETCH();_NEXT()
+        _OP(0xE1,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xE2,0): _SA(c->PC++);_NEXT()
+        _OP(0xE2,1): _FETCH();_NEXT()
+        _OP(0xE2,2): assert(false);_NEXT()
+        _OP(0xE2,3): assert(false);_NEXT()
+        _OP(0xE2,4): assert(false);_NEXT()
+        _OP(0xE2,5): assert(false);_NEXT()
+        _OP(0xE2,6): assert(false);_NEXT()
+        _OP(0xE2,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xE3,0): _FETCH();_NEXT()
+        _OP(0xE3,1): assert(false);_NEXT()
+        _OP(0xE3,2): assert(false);_NEXT()
+        _OP(0xE3,3): assert(false);_NEXT()
+        _OP(0xE3,4): assert(false);_NEXT()
+        _OP(0xE3,5): assert(false);_NEXT()
+        _OP(0xE3,6): assert(false);_NEXT()
+        _OP(0xE3,7): assert(false);_NEXT()
+    /* CPX zp */
+        _OP(0xE4,0): _SA(c->PC++);_NEXT()
+        _OP(0xE4,1): _SA(_GD());_NEXT()
+        _OP(0xE4,2): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xE4,3): assert(false);_NEXT()
+        _OP(0xE4,4): assert(false);_NEXT()
+        _OP(0xE4,5): assert(false);_NEXT()
+        _OP(0xE4,6): assert(false);_NEXT()
+        _OP(0xE4,7): assert(false);_NEXT()
+    /* SBC zp */
+        _OP(0xE5,0): _SA(c->PC++);_NEXT()
+        _OP(0xE5,1): _SA(_GD());_NEXT()
+        _OP(0xE5,2): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xE5,3): _FETCH();_NEXT()
+        _OP(0xE5,4): assert(false);_NEXT()
+        _OP(0xE5,5): assert(false);_NEXT()
+        _OP(0xE5,6): assert(false);_NEXT()
+        _OP(0xE5,7): assert(false);_NEXT()
+    /* INC zp */
+        _OP(0xE6,0): _SA(c->PC++);_NEXT()
+        _OP(0xE6,1): _SA(_GD());_NEXT()
+        _OP(0xE6,2): c->AD=_GD();_NEXT()
+        _OP(0xE6,3): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xE6,4): _FETCH();_NEXT()
+        _OP(0xE6,5): assert(false);_NEXT()
+        _OP(0xE6,6): assert(false);_NEXT()
+        _OP(0xE6,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xE7,0): _FETCH();_NEXT()
+        _OP(0xE7,1): assert(false);_NEXT()
+        _OP(0xE7,2): assert(false);_NEXT()
+        _OP(0xE7,3): assert(false);_NEXT()
+        _OP(0xE7,4): assert(false);_NEXT()
+        _OP(0xE7,5): assert(false);_NEXT()
+        _OP(0xE7,6): assert(false);_NEXT()
+        _OP(0xE7,7): assert(false);_NEXT()
+    /* INX  */
+        _OP(0xE8,0): _SA(c->PC);_NEXT()
+        _OP(0xE8,1): c->X++;_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xE8,2): assert(false);_NEXT()
+        _OP(0xE8,3): assert(false);_NEXT()
+        _OP(0xE8,4): assert(false);_NEXT()
+        _OP(0xE8,5): assert(false);_NEXT()
+        _OP(0xE8,6): assert(false);_NEXT()
+        _OP(0xE8,7): assert(false);_NEXT()
+    /* SBC # */
+        _OP(0xE9,0): _SA(c->PC++);_NEXT()
+        _OP(0xE9,1): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xE9,2): _FETCH();_NEXT()
+        _OP(0xE9,3): assert(false);_NEXT()
+        _OP(0xE9,4): assert(false);_NEXT()
+        _OP(0xE9,5): assert(false);_NEXT()
+        _OP(0xE9,6): assert(false);_NEXT()
+        _OP(0xE9,7): assert(false);_NEXT()
+    /* NOP  */
+        _OP(0xEA,0): _SA(c->PC);_NEXT()
+        _OP(0xEA,1): _FETCH();_NEXT()
+        _OP(0xEA,2): assert(false);_NEXT()
+        _OP(0xEA,3): assert(false);_NEXT()
+        _OP(0xEA,4): assert(false);_NEXT()
+        _OP(0xEA,5): assert(false);_NEXT()
+        _OP(0xEA,6): assert(false);_NEXT()
+        _OP(0xEA,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xEB,0): _FETCH();_NEXT()
+        _OP(0xEB,1): assert(false);_NEXT()
+        _OP(0xEB,2): assert(false);_NEXT()
+        _OP(0xEB,3): assert(false);_NEXT()
+        _OP(0xEB,4): assert(false);_NEXT()
+        _OP(0xEB,5): assert(false);_NEXT()
+        _OP(0xEB,6): assert(false);_NEXT()
+        _OP(0xEB,7): assert(false);_NEXT()
+    /* CPX abs */
+        _OP(0xEC,0): _SA(c->PC++);_NEXT()
+        _OP(0xEC,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xEC,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xEC,3): _m6502_cmp(c, c->X, _GD());_FETCH();_NEXT()
+        _OP(0xEC,4): assert(false);_NEXT()
+        _OP(0xEC,5): assert(false);_NEXT()
+        _OP(0xEC,6): assert(false);_NEXT()
+        _OP(0xEC,7): assert(false);_NEXT()
+    /* SBC abs */
+        _OP(0xED,0): _SA(c->PC++);_NEXT()
+        _OP(0xED,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xED,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xED,3): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xED,4): _FETCH();_NEXT()
+        _OP(0xED,5): assert(false);_NEXT()
+        _OP(0xED,6): assert(false);_NEXT()
+        _OP(0xED,7): assert(false);_NEXT()
+    /* INC abs */
+        _OP(0xEE,0): _SA(c->PC++);_NEXT()
+        _OP(0xEE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xEE,2): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xEE,3): c->AD=_GD();_NEXT()
+        _OP(0xEE,4): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xEE,5): _FETCH();_NEXT()
+        _OP(0xEE,6): assert(false);_NEXT()
+        _OP(0xEE,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xEF,0): _FETCH();_NEXT()
+        _OP(0xEF,1): assert(false);_NEXT()
+        _OP(0xEF,2): assert(false);_NEXT()
+        _OP(0xEF,3): assert(false);_NEXT()
+        _OP(0xEF,4): assert(false);_NEXT()
+        _OP(0xEF,5): assert(false);_NEXT()
+        _OP(0xEF,6): assert(false);_NEXT()
+        _OP(0xEF,7): assert(false);_NEXT()
+    /* BEQ # */
+        _OP(0xF0,0): _SA(c->PC++);_NEXT()
+        _OP(0xF0,1): _SA(c->PC);c->AD=c->PC+(int8_t)_GD();if((c->P&0x2)!=0x2){_FETCH();};_NEXT()
+        _OP(0xF0,2): _SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};_NEXT()
+        _OP(0xF0,3): c->PC=c->AD;_FETCH();_NEXT()
+        _OP(0xF0,4): assert(false);_NEXT()
+        _OP(0xF0,5): assert(false);_NEXT()
+        _OP(0xF0,6): assert(false);_NEXT()
+        _OP(0xF0,7): assert(false);_NEXT()
+    /* SBC (zp),Y */
+        _OP(0xF1,0): _SA(c->PC++);_NEXT()
+        _OP(0xF1,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF1,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xF1,3): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xF1,4): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xF1,5): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xF1,6): _FETCH();_NEXT()
+        _OP(0xF1,7): assert(false);_NEXT()
+    /* SBC (zp) */
+        _OP(0xF2,0): _SA(c->PC++);_NEXT()
+        _OP(0xF2,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF2,2): _SA((c->AD+1)&0xFF);c->AD=_GD();_NEXT()
+        _OP(0xF2,3): _SA((_GD()<<8)|c->AD);_NEXT()
+        _OP(0xF2,4): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xF2,5): _FETCH();_NEXT()
+        _OP(0xF2,6): assert(false);_NEXT()
+        _OP(0xF2,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xF3,0): _FETCH();_NEXT()
+        _OP(0xF3,1): assert(false);_NEXT()
+        _OP(0xF3,2): assert(false);_NEXT()
+        _OP(0xF3,3): assert(false);_NEXT()
+        _OP(0xF3,4): assert(false);_NEXT()
+        _OP(0xF3,5): assert(false);_NEXT()
+        _OP(0xF3,6): assert(false);_NEXT()
+        _OP(0xF3,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xF4,0): _SA(c->PC++);_NEXT()
+        _OP(0xF4,1): _SA(c->PC);_NEXT()
+        _OP(0xF4,2): _SA(c->PC);_NEXT()
+        _OP(0xF4,3): _FETCH();_NEXT()
+        _OP(0xF4,4): assert(false);_NEXT()
+        _OP(0xF4,5): assert(false);_NEXT()
+        _OP(0xF4,6): assert(false);_NEXT()
+        _OP(0xF4,7): assert(false);_NEXT()
+    /* SBC zp,X */
+        _OP(0xF5,0): _SA(c->PC++);_NEXT()
+        _OP(0xF5,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF5,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF5,3): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xF5,4): _FETCH();_NEXT()
+        _OP(0xF5,5): assert(false);_NEXT()
+        _OP(0xF5,6): assert(false);_NEXT()
+        _OP(0xF5,7): assert(false);_NEXT()
+    /* INC zp,X */
+        _OP(0xF6,0): _SA(c->PC++);_NEXT()
+        _OP(0xF6,1): c->AD=_GD();_SA(c->AD);_NEXT()
+        _OP(0xF6,2): _SA((c->AD+c->X)&0x00FF);_NEXT()
+        _OP(0xF6,3): c->AD=_GD();_NEXT()
+        _OP(0xF6,4): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xF6,5): _FETCH();_NEXT()
+        _OP(0xF6,6): assert(false);_NEXT()
+        _OP(0xF6,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xF7,0): _FETCH();_NEXT()
+        _OP(0xF7,1): assert(false);_NEXT()
+        _OP(0xF7,2): assert(false);_NEXT()
+        _OP(0xF7,3): assert(false);_NEXT()
+        _OP(0xF7,4): assert(false);_NEXT()
+        _OP(0xF7,5): assert(false);_NEXT()
+        _OP(0xF7,6): assert(false);_NEXT()
+        _OP(0xF7,7): assert(false);_NEXT()
+    /* SED  */
+        _OP(0xF8,0): _SA(c->PC);_NEXT()
+        _OP(0xF8,1): c->P|=0x8;_FETCH();_NEXT()
+        _OP(0xF8,2): assert(false);_NEXT()
+        _OP(0xF8,3): assert(false);_NEXT()
+        _OP(0xF8,4): assert(false);_NEXT()
+        _OP(0xF8,5): assert(false);_NEXT()
+        _OP(0xF8,6): assert(false);_NEXT()
+        _OP(0xF8,7): assert(false);_NEXT()
+    /* SBC abs,Y */
+        _OP(0xF9,0): _SA(c->PC++);_NEXT()
+        _OP(0xF9,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xF9,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->Y)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->Y)>>8)))&1;_NEXT()
+        _OP(0xF9,3): _SA(c->AD+c->Y);_NEXT()
+        _OP(0xF9,4): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xF9,5): _FETCH();_NEXT()
+        _OP(0xF9,6): assert(false);_NEXT()
+        _OP(0xF9,7): assert(false);_NEXT()
+    /* PLX  */
+        _OP(0xFA,0): _SA(c->PC);_NEXT()
+        _OP(0xFA,1): _SA(0x0100|c->S++);_NEXT()
+        _OP(0xFA,2): _SA(0x0100|c->S);_NEXT()
+        _OP(0xFA,3): c->X=_GD();_NZ(c->X);_FETCH();_NEXT()
+        _OP(0xFA,4): assert(false);_NEXT()
+        _OP(0xFA,5): assert(false);_NEXT()
+        _OP(0xFA,6): assert(false);_NEXT()
+        _OP(0xFA,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xFB,0): _FETCH();_NEXT()
+        _OP(0xFB,1): assert(false);_NEXT()
+        _OP(0xFB,2): assert(false);_NEXT()
+        _OP(0xFB,3): assert(false);_NEXT()
+        _OP(0xFB,4): assert(false);_NEXT()
+        _OP(0xFB,5): assert(false);_NEXT()
+        _OP(0xFB,6): assert(false);_NEXT()
+        _OP(0xFB,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xFC,0): _SA(c->PC++);_NEXT()
+        _OP(0xFC,1): _SA(c->PC++);_NEXT()
+        _OP(0xFC,2): _SA(c->PC);_NEXT()
+        _OP(0xFC,3): _FETCH();_NEXT()
+        _OP(0xFC,4): assert(false);_NEXT()
+        _OP(0xFC,5): assert(false);_NEXT()
+        _OP(0xFC,6): assert(false);_NEXT()
+        _OP(0xFC,7): assert(false);_NEXT()
+    /* SBC abs,X */
+        _OP(0xFD,0): _SA(c->PC++);_NEXT()
+        _OP(0xFD,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFD,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));c->IR+=(~((c->AD>>8)-((c->AD+c->X)>>8)))&1;_NEXT()
+        _OP(0xFD,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFD,4): _m65c02_sbc(c,_GD());if(0==(c->P&M6502_DF)){_FETCH();}_NEXT()
+        _OP(0xFD,5): _FETCH();_NEXT()
+        _OP(0xFD,6): assert(false);_NEXT()
+        _OP(0xFD,7): assert(false);_NEXT()
+    /* INC abs,X */
+        _OP(0xFE,0): _SA(c->PC++);_NEXT()
+        _OP(0xFE,1): _SA(c->PC++);c->AD=_GD();_NEXT()
+        _OP(0xFE,2): c->AD|=_GD()<<8;_SA((c->AD&0xFF00)|((c->AD+c->X)&0xFF));_NEXT()
+        _OP(0xFE,3): _SA(c->AD+c->X);_NEXT()
+        _OP(0xFE,4): c->AD=_GD();_NEXT()
+        _OP(0xFE,5): c->AD++;_NZ(c->AD);_SD(c->AD);_WR();_NEXT()
+        _OP(0xFE,6): _FETCH();_NEXT()
+        _OP(0xFE,7): assert(false);_NEXT()
+    /* NOP (undoc) */
+        _OP(0xFF,0): _FETCH();_NEXT()
+        _OP(0xFF,1): assert(false);_NEXT()
+        _OP(0xFF,2): assert(false);_NEXT()
+        _OP(0xFF,3): assert(false);_NEXT()
+        _OP(0xFF,4): assert(false);_NEXT()
+        _OP(0xFF,5): assert(false);_NEXT()
+        _OP(0xFF,6): assert(false);_NEXT()
+        _OP(0xFF,7): assert(false);_NEXT()
+
+    }
+    _M6502_TICK_END();
+    return pins;
+}
+
 #if defined(_MSC_VER)
 #pragma warning(pop)
 #endif
@@ -3037,4 +8581,38 @@ uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
 #undef _RD
 #undef _WR
 #undef _NZ
+#undef _M6502_TICK_END
+#undef _OP
+#undef _NEXT
+#undef _DISPATCH
+#undef _M6502_COMPUTED_GOTO
+
+static const chips_state_field_t _m6502_state_fields[] = {
+    CHIPS_FIELD_U16(m6502_t, IR),
+    CHIPS_FIELD_U16(m6502_t, PC),
+    CHIPS_FIELD_U16(m6502_t, AD),
+    CHIPS_FIELD_U8(m6502_t, A),
+    CHIPS_FIELD_U8(m6502_t, X),
+    CHIPS_FIELD_U8(m6502_t, Y),
+    CHIPS_FIELD_U8(m6502_t, S),
+    CHIPS_FIELD_U8(m6502_t, P),
+    CHIPS_FIELD_U64(m6502_t, PINS),
+    CHIPS_FIELD_U16(m6502_t, irq_pip),
+    CHIPS_FIELD_U16(m6502_t, nmi_pip),
+    CHIPS_FIELD_U8(m6502_t, brk_flags),
+    CHIPS_FIELD_U8(m6502_t, io_ddr),
+    CHIPS_FIELD_U8(m6502_t, io_inp),
+    CHIPS_FIELD_U8(m6502_t, io_out),
+    CHIPS_FIELD_U8(m6502_t, io_pins),
+    CHIPS_FIELD_U8(m6502_t, io_pullup),
+    CHIPS_FIELD_U8(m6502_t, io_floating),
+    CHIPS_FIELD_U8(m6502_t, io_drive),
+};
+
+static const chips_state_desc_t _m6502_state_desc = CHIPS_STATE_DESC("m6502", m6502_t, _m6502_state_fields);
+
+const chips_state_desc_t* m6502_state_desc(void) {
+    return &_m6502_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
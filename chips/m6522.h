@@ -18,6 +18,10 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    You need to include the following headers before including m6522.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
     *************************************
     *           +-----------+           *
@@ -314,6 +318,8 @@ void m6522_init(m6522_t* m6522);
 void m6522_reset(m6522_t* m6522);
 /* tick the m6522 */
 uint64_t m6522_tick(m6522_t* m6522, uint64_t pins);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* m6522_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -857,4 +863,48 @@ uint64_t m6522_tick(m6522_t* c, uint64_t pins) {
     return pins;
 }
 
+static const chips_state_field_t _m6522_port_state_fields[] = {
+    CHIPS_FIELD_U8(m6522_port_t, inpr),
+    CHIPS_FIELD_U8(m6522_port_t, outr),
+    CHIPS_FIELD_U8(m6522_port_t, ddr),
+    CHIPS_FIELD_U8(m6522_port_t, pins),
+    CHIPS_FIELD_BOOL(m6522_port_t, c1_in),
+    CHIPS_FIELD_BOOL(m6522_port_t, c1_out),
+    CHIPS_FIELD_BOOL(m6522_port_t, c1_triggered),
+    CHIPS_FIELD_BOOL(m6522_port_t, c2_in),
+    CHIPS_FIELD_BOOL(m6522_port_t, c2_out),
+    CHIPS_FIELD_BOOL(m6522_port_t, c2_triggered),
+};
+
+static const chips_state_field_t _m6522_timer_state_fields[] = {
+    CHIPS_FIELD_U16(m6522_timer_t, latch),
+    CHIPS_FIELD_U16(m6522_timer_t, counter),
+    CHIPS_FIELD_BOOL(m6522_timer_t, t_bit),
+    CHIPS_FIELD_BOOL(m6522_timer_t, t_out),
+    CHIPS_FIELD_U16(m6522_timer_t, pip),
+};
+
+static const chips_state_field_t _m6522_int_state_fields[] = {
+    CHIPS_FIELD_U8(m6522_int_t, ier),
+    CHIPS_FIELD_U8(m6522_int_t, ifr),
+    CHIPS_FIELD_U16(m6522_int_t, pip),
+};
+
+static const chips_state_field_t _m6522_state_fields[] = {
+    CHIPS_FIELD_STRUCT(m6522_t, pa, m6522_port_t, _m6522_port_state_fields),
+    CHIPS_FIELD_STRUCT(m6522_t, pb, m6522_port_t, _m6522_port_state_fields),
+    CHIPS_FIELD_STRUCT(m6522_t, t1, m6522_timer_t, _m6522_timer_state_fields),
+    CHIPS_FIELD_STRUCT(m6522_t, t2, m6522_timer_t, _m6522_timer_state_fields),
+    CHIPS_FIELD_STRUCT(m6522_t, intr, m6522_int_t, _m6522_int_state_fields),
+    CHIPS_FIELD_U8(m6522_t, acr),
+    CHIPS_FIELD_U8(m6522_t, pcr),
+    CHIPS_FIELD_U64(m6522_t, pins),
+};
+
+static const chips_state_desc_t _m6522_state_desc = CHIPS_STATE_DESC("m6522", m6522_t, _m6522_state_fields);
+
+const chips_state_desc_t* m6522_state_desc(void) {
+    return &_m6522_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
@@ -15,6 +15,10 @@
     ~~~C    
     CHIPS_ASSERT(c)
     ~~~
+
+    You need to include the following headers before including m6526.h:
+
+    - chips/chips_state.h
     
     ## Emulated Pins
 
@@ -234,6 +238,8 @@ void m6526_init(m6526_t* c);
 void m6526_reset(m6526_t* c);
 /* tick the m6526_t instance */
 uint64_t m6526_tick(m6526_t* c, uint64_t pins);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* m6526_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -645,4 +651,43 @@ uint64_t m6526_tick(m6526_t* c, uint64_t pins) {
     return pins;
 }
 
+static const chips_state_field_t _m6526_port_state_fields[] = {
+    CHIPS_FIELD_U8(m6526_port_t, reg),
+    CHIPS_FIELD_U8(m6526_port_t, ddr),
+    CHIPS_FIELD_U8(m6526_port_t, inp),
+    CHIPS_FIELD_U8(m6526_port_t, pins),
+};
+
+static const chips_state_field_t _m6526_timer_state_fields[] = {
+    CHIPS_FIELD_U16(m6526_timer_t, latch),
+    CHIPS_FIELD_U16(m6526_timer_t, counter),
+    CHIPS_FIELD_U8(m6526_timer_t, cr),
+    CHIPS_FIELD_BOOL(m6526_timer_t, t_bit),
+    CHIPS_FIELD_BOOL(m6526_timer_t, t_out),
+    CHIPS_FIELD_U32(m6526_timer_t, pip),
+};
+
+static const chips_state_field_t _m6526_int_state_fields[] = {
+    CHIPS_FIELD_U8(m6526_int_t, imr),
+    CHIPS_FIELD_U8(m6526_int_t, imr1),
+    CHIPS_FIELD_U8(m6526_int_t, icr),
+    CHIPS_FIELD_U32(m6526_int_t, pip),
+    CHIPS_FIELD_BOOL(m6526_int_t, flag),
+};
+
+static const chips_state_field_t _m6526_state_fields[] = {
+    CHIPS_FIELD_STRUCT(m6526_t, pa, m6526_port_t, _m6526_port_state_fields),
+    CHIPS_FIELD_STRUCT(m6526_t, pb, m6526_port_t, _m6526_port_state_fields),
+    CHIPS_FIELD_STRUCT(m6526_t, ta, m6526_timer_t, _m6526_timer_state_fields),
+    CHIPS_FIELD_STRUCT(m6526_t, tb, m6526_timer_t, _m6526_timer_state_fields),
+    CHIPS_FIELD_STRUCT(m6526_t, intr, m6526_int_t, _m6526_int_state_fields),
+    CHIPS_FIELD_U64(m6526_t, pins),
+};
+
+static const chips_state_desc_t _m6526_state_desc = CHIPS_STATE_DESC("m6526", m6526_t, _m6526_state_fields);
+
+const chips_state_desc_t* m6526_state_desc(void) {
+    return &_m6526_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
@@ -16,6 +16,10 @@
     CHIPS_ASSERT(c)
     ~~~
 
+    You need to include the following headers before including m6561.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
     TODO
 
@@ -118,6 +122,8 @@ extern "C" {
 
 /* memory fetch callback, used to feed pixel- and color-data into the m6561 */
 typedef uint16_t (*m6561_fetch_t)(uint16_t addr, void* user_data);
+/* optional callback at the start of the vertical retrace (the frame in rgba8_buffer is complete) */
+typedef void (*m6561_vsync_t)(void* user_data);
 
 /* setup parameters for m6561_init() function */
 typedef struct {
@@ -129,7 +135,9 @@ typedef struct {
     uint16_t vis_x, vis_y, vis_w, vis_h;
     /* the memory-fetch callback */
     m6561_fetch_t fetch_cb;
-    /* optional user-data for fetch callback */
+    /* optional callback at the start of the vertical retrace (e.g. for frame capture) */
+    m6561_vsync_t vsync_cb;
+    /* optional user-data for callbacks */
     void* user_data;
     /* frequency at which the tick function is called (for audio generation) */
     int tick_hz;
@@ -181,6 +189,7 @@ typedef struct {
     uint16_t vis_x0, vis_y0, vis_x1, vis_y1;  /* the visible area */
     uint16_t vis_w, vis_h;      /* width of visible area */
     uint32_t* rgba8_buffer;
+    m6561_vsync_t vsync_cb;
 } m6561_crt_t;
 
 /* sound generator state */
@@ -241,6 +250,8 @@ int m6561_display_width(m6561_t* vic);
 int m6561_display_height(m6561_t* vic);
 /* get 32-bit RGBA8 value from color index (0..15) */
 uint32_t m6561_color(int i);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* m6561_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -295,6 +306,7 @@ static void _m6561_init_crt(m6561_crt_t* crt, const m6561_desc_t* desc) {
     CHIPS_ASSERT((desc->vis_x & 7) == 0);
     CHIPS_ASSERT((desc->vis_w & 7) == 0);
     crt->rgba8_buffer = desc->rgba8_buffer;
+    crt->vsync_cb = desc->vsync_cb;
     crt->vis_x0 = desc->vis_x/_M6561_PIXELS_PER_TICK;
     crt->vis_y0 = desc->vis_y;
     crt->vis_w = desc->vis_w/_M6561_PIXELS_PER_TICK;
@@ -529,6 +541,9 @@ static void _m6561_tick_video(m6561_t* vic) {
         }
         if (vic->rs.v_count == _M6561_VRETRACEPOS) {
             vic->crt.y = 0;
+            if (vic->crt.vsync_cb) {
+                vic->crt.vsync_cb(vic->user_data);
+            }
         }
         else {
             vic->crt.y++;
@@ -657,5 +672,97 @@ uint64_t m6561_tick(m6561_t* vic, uint64_t pins) {
     return pins;
 }
 
+static const chips_state_field_t _m6561_raster_unit_state_fields[] = {
+    CHIPS_FIELD_U8(m6561_raster_unit_t, h_count),
+    CHIPS_FIELD_U16(m6561_raster_unit_t, v_count),
+    CHIPS_FIELD_U16(m6561_raster_unit_t, vc),
+    CHIPS_FIELD_U16(m6561_raster_unit_t, vc_base),
+    CHIPS_FIELD_U8(m6561_raster_unit_t, vc_disabled),
+    CHIPS_FIELD_U8(m6561_raster_unit_t, rc),
+    CHIPS_FIELD_U8(m6561_raster_unit_t, row_height),
+    CHIPS_FIELD_U8(m6561_raster_unit_t, row_count),
+};
+
+static const chips_state_field_t _m6561_memory_unit_state_fields[] = {
+    CHIPS_FIELD_U16(m6561_memory_unit_t, c_addr_base),
+    CHIPS_FIELD_U16(m6561_memory_unit_t, g_addr_base),
+    CHIPS_FIELD_U16(m6561_memory_unit_t, c_value),
+};
+
+static const chips_state_field_t _m6561_border_unit_state_fields[] = {
+    CHIPS_FIELD_U8(m6561_border_unit_t, left),
+    CHIPS_FIELD_U8(m6561_border_unit_t, right),
+    CHIPS_FIELD_U16(m6561_border_unit_t, top),
+    CHIPS_FIELD_U16(m6561_border_unit_t, bottom),
+    CHIPS_FIELD_U8(m6561_border_unit_t, enabled),
+};
+
+static const chips_state_field_t _m6561_graphics_unit_state_fields[] = {
+    CHIPS_FIELD_U8(m6561_graphics_unit_t, shift),
+    CHIPS_FIELD_U8(m6561_graphics_unit_t, color),
+    CHIPS_FIELD_BOOL(m6561_graphics_unit_t, inv_color),
+    CHIPS_FIELD_U32(m6561_graphics_unit_t, bg_color),
+    CHIPS_FIELD_U32(m6561_graphics_unit_t, brd_color),
+    CHIPS_FIELD_U32(m6561_graphics_unit_t, aux_color),
+};
+
+static const chips_state_field_t _m6561_crt_state_fields[] = {
+    CHIPS_FIELD_U16(m6561_crt_t, x),
+    CHIPS_FIELD_U16(m6561_crt_t, y),
+    CHIPS_FIELD_U16(m6561_crt_t, vis_x0),
+    CHIPS_FIELD_U16(m6561_crt_t, vis_y0),
+    CHIPS_FIELD_U16(m6561_crt_t, vis_x1),
+    CHIPS_FIELD_U16(m6561_crt_t, vis_y1),
+    CHIPS_FIELD_U16(m6561_crt_t, vis_w),
+    CHIPS_FIELD_U16(m6561_crt_t, vis_h),
+};
+
+static const chips_state_field_t _m6561_voice_state_fields[] = {
+    CHIPS_FIELD_U16(m6561_voice_t, count),
+    CHIPS_FIELD_U16(m6561_voice_t, period),
+    CHIPS_FIELD_U8(m6561_voice_t, bit),
+    CHIPS_FIELD_U8(m6561_voice_t, enabled),
+};
+
+static const chips_state_field_t _m6561_noise_state_fields[] = {
+    CHIPS_FIELD_U16(m6561_noise_t, count),
+    CHIPS_FIELD_U16(m6561_noise_t, period),
+    CHIPS_FIELD_U32(m6561_noise_t, shift),
+    CHIPS_FIELD_U8(m6561_noise_t, bit),
+    CHIPS_FIELD_U8(m6561_noise_t, enabled),
+};
+
+static const chips_state_field_t _m6561_sound_state_fields[] = {
+    CHIPS_FIELD_STRUCT(m6561_sound_t, voice, m6561_voice_t, _m6561_voice_state_fields),
+    CHIPS_FIELD_STRUCT(m6561_sound_t, noise, m6561_noise_t, _m6561_noise_state_fields),
+    CHIPS_FIELD_U8(m6561_sound_t, volume),
+    CHIPS_FIELD_INT(m6561_sound_t, sample_period),
+    CHIPS_FIELD_INT(m6561_sound_t, sample_counter),
+    CHIPS_FIELD_FLOAT(m6561_sound_t, sample_accum),
+    CHIPS_FIELD_FLOAT(m6561_sound_t, sample_accum_count),
+    CHIPS_FIELD_FLOAT(m6561_sound_t, sample_mag),
+    CHIPS_FIELD_FLOAT(m6561_sound_t, sample),
+    CHIPS_FIELD_FLOAT(m6561_sound_t, dcadj_sum),
+    CHIPS_FIELD_U32(m6561_sound_t, dcadj_pos),
+    CHIPS_FIELD_FLOAT(m6561_sound_t, dcadj_buf),
+};
+
+static const chips_state_field_t _m6561_state_fields[] = {
+    CHIPS_FIELD_U64(m6561_t, pins),
+    CHIPS_FIELD_BOOL(m6561_t, debug_vis),
+    CHIPS_FIELD_U8(m6561_t, regs),
+    CHIPS_FIELD_STRUCT(m6561_t, rs, m6561_raster_unit_t, _m6561_raster_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6561_t, mem, m6561_memory_unit_t, _m6561_memory_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6561_t, border, m6561_border_unit_t, _m6561_border_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6561_t, gunit, m6561_graphics_unit_t, _m6561_graphics_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6561_t, crt, m6561_crt_t, _m6561_crt_state_fields),
+    CHIPS_FIELD_STRUCT(m6561_t, sound, m6561_sound_t, _m6561_sound_state_fields),
+};
+
+static const chips_state_desc_t _m6561_state_desc = CHIPS_STATE_DESC("m6561", m6561_t, _m6561_state_fields);
+
+const chips_state_desc_t* m6561_state_desc(void) {
+    return &_m6561_state_desc;
+}
 
 #endif
@@ -16,6 +16,10 @@
     CHIPS_ASSERT(c)
     ~~~
 
+    You need to include the following headers before including m6569.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
 
     ***********************************
@@ -113,6 +117,10 @@ extern "C" {
 
 /* memory fetch callback, used to feed pixel- and color-data into the m6569 */
 typedef uint16_t (*m6569_fetch_t)(uint16_t addr, void* user_data);
+/* optional callback when a line of the visible area has been decoded (y is the framebuffer line) */
+typedef void (*m6569_crtline_t)(int y, void* user_data);
+/* optional callback at the start of the vertical retrace (the frame in rgba8_buffer is complete) */
+typedef void (*m6569_vsync_t)(void* user_data);
 
 /* setup parameters for m6569_init() function */
 typedef struct {
@@ -124,7 +132,11 @@ typedef struct {
     uint16_t vis_x, vis_y, vis_w, vis_h;
     /* the memory-fetch callback */
     m6569_fetch_t fetch_cb;
-    /* optional user-data for fetch callback */
+    /* optional callback when a visible line has been decoded (e.g. for beam racing) */
+    m6569_crtline_t crtline_cb;
+    /* optional callback at the start of the vertical retrace (e.g. for frame capture) */
+    m6569_vsync_t vsync_cb;
+    /* optional user-data for callbacks */
     void* user_data;
 } m6569_desc_t;
 
@@ -225,6 +237,8 @@ typedef struct {
     uint16_t vis_x0, vis_y0, vis_x1, vis_y1;  /* the visible area */
     uint16_t vis_w, vis_h;      /* width of visible area */
     uint32_t* rgba8_buffer;
+    m6569_crtline_t crtline_cb;
+    m6569_vsync_t vsync_cb;
 } m6569_crt_t;
 
 /* graphics sequencer state */
@@ -290,6 +304,8 @@ int m6569_display_width(m6569_t* vic);
 int m6569_display_height(m6569_t* vic);
 /* get 32-bit RGBA8 value from color index (0..15) */
 uint32_t m6569_color(int i);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* m6569_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -389,6 +405,8 @@ static void _m6569_init_crt(m6569_crt_t* crt, const m6569_desc_t* desc) {
     CHIPS_ASSERT((desc->vis_x & 7) == 0);
     CHIPS_ASSERT((desc->vis_w & 7) == 0);
     crt->rgba8_buffer = desc->rgba8_buffer;
+    crt->crtline_cb = desc->crtline_cb;
+    crt->vsync_cb = desc->vsync_cb;
     crt->vis_x0 = desc->vis_x/8;
     crt->vis_y0 = desc->vis_y;
     crt->vis_w = desc->vis_w/8;
@@ -1276,9 +1294,19 @@ static inline void _m6569_rs_rewind_vc_vmli_rc(m6569_t* vic) {
 }
 
 static inline void _m6569_crt_next_crtline(m6569_t* vic) {
+    /* report the finished framebuffer line (not in debug visualization mode) */
+    if (vic->crt.crtline_cb && vic->crt.rgba8_buffer && !vic->debug_vis) {
+        const int y = vic->crt.y - vic->crt.vis_y0;
+        if ((y >= 0) && (y < vic->crt.vis_h)) {
+            vic->crt.crtline_cb(y, vic->mem.user_data);
+        }
+    }
     vic->crt.x = 0;
     if (vic->rs.v_count == _M6569_VRETRACEPOS) {
         vic->crt.y = 0;
+        if (vic->crt.vsync_cb) {
+            vic->crt.vsync_cb(vic->mem.user_data);
+        }
     }
     else {
         vic->crt.y++;
@@ -1674,4 +1702,107 @@ uint32_t m6569_color(int i) {
     CHIPS_ASSERT((i >= 0) && (i < 16));
     return _m6569_colors[i];
 }
+
+static const chips_state_field_t _m6569_registers_state_fields[] = {
+    CHIPS_FIELD_U8(m6569_registers_t, regs),
+};
+
+static const chips_state_field_t _m6569_crt_state_fields[] = {
+    CHIPS_FIELD_U16(m6569_crt_t, x),
+    CHIPS_FIELD_U16(m6569_crt_t, y),
+    CHIPS_FIELD_U16(m6569_crt_t, vis_x0),
+    CHIPS_FIELD_U16(m6569_crt_t, vis_y0),
+    CHIPS_FIELD_U16(m6569_crt_t, vis_x1),
+    CHIPS_FIELD_U16(m6569_crt_t, vis_y1),
+    CHIPS_FIELD_U16(m6569_crt_t, vis_w),
+    CHIPS_FIELD_U16(m6569_crt_t, vis_h),
+};
+
+static const chips_state_field_t _m6569_border_unit_state_fields[] = {
+    CHIPS_FIELD_U16(m6569_border_unit_t, left),
+    CHIPS_FIELD_U16(m6569_border_unit_t, right),
+    CHIPS_FIELD_U16(m6569_border_unit_t, top),
+    CHIPS_FIELD_U16(m6569_border_unit_t, bottom),
+    CHIPS_FIELD_BOOL(m6569_border_unit_t, main),
+    CHIPS_FIELD_BOOL(m6569_border_unit_t, vert),
+    CHIPS_FIELD_U8(m6569_border_unit_t, bc_index),
+    CHIPS_FIELD_U32(m6569_border_unit_t, bc_rgba8),
+};
+
+static const chips_state_field_t _m6569_raster_unit_state_fields[] = {
+    CHIPS_FIELD_U8(m6569_raster_unit_t, h_count),
+    CHIPS_FIELD_U16(m6569_raster_unit_t, v_count),
+    CHIPS_FIELD_U16(m6569_raster_unit_t, v_irqline),
+    CHIPS_FIELD_U16(m6569_raster_unit_t, vc),
+    CHIPS_FIELD_U16(m6569_raster_unit_t, vc_base),
+    CHIPS_FIELD_U8(m6569_raster_unit_t, rc),
+    CHIPS_FIELD_BOOL(m6569_raster_unit_t, display_state),
+    CHIPS_FIELD_BOOL(m6569_raster_unit_t, badline),
+    CHIPS_FIELD_BOOL(m6569_raster_unit_t, frame_badlines_enabled),
+};
+
+static const chips_state_field_t _m6569_memory_unit_state_fields[] = {
+    CHIPS_FIELD_U16(m6569_memory_unit_t, c_addr_or),
+    CHIPS_FIELD_U16(m6569_memory_unit_t, g_addr_and),
+    CHIPS_FIELD_U16(m6569_memory_unit_t, g_addr_or),
+    CHIPS_FIELD_U16(m6569_memory_unit_t, i_addr),
+    CHIPS_FIELD_U16(m6569_memory_unit_t, p_addr_or),
+};
+
+static const chips_state_field_t _m6569_graphics_unit_state_fields[] = {
+    CHIPS_FIELD_BOOL(m6569_graphics_unit_t, enabled),
+    CHIPS_FIELD_U8(m6569_graphics_unit_t, mode),
+    CHIPS_FIELD_U8(m6569_graphics_unit_t, count),
+    CHIPS_FIELD_U8(m6569_graphics_unit_t, shift),
+    CHIPS_FIELD_U8(m6569_graphics_unit_t, outp),
+    CHIPS_FIELD_U8(m6569_graphics_unit_t, outp2),
+    CHIPS_FIELD_U16(m6569_graphics_unit_t, c_data),
+    CHIPS_FIELD_U8(m6569_graphics_unit_t, bg_index),
+    CHIPS_FIELD_U32(m6569_graphics_unit_t, bg_rgba8),
+};
+
+static const chips_state_field_t _m6569_sprite_unit_state_fields[] = {
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, h_first),
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, h_last),
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, h_offset),
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, p_data),
+    CHIPS_FIELD_BOOL(m6569_sprite_unit_t, dma_enabled),
+    CHIPS_FIELD_BOOL(m6569_sprite_unit_t, disp_enabled),
+    CHIPS_FIELD_BOOL(m6569_sprite_unit_t, expand),
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, mc),
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, mc_base),
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, delay_count),
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, outp2_count),
+    CHIPS_FIELD_U8(m6569_sprite_unit_t, xexp_count),
+    CHIPS_FIELD_U32(m6569_sprite_unit_t, shift),
+    CHIPS_FIELD_U32(m6569_sprite_unit_t, outp),
+    CHIPS_FIELD_U32(m6569_sprite_unit_t, outp2),
+    CHIPS_FIELD_U32(m6569_sprite_unit_t, colors),
+};
+
+static const chips_state_field_t _m6569_video_matrix_state_fields[] = {
+    CHIPS_FIELD_U8(m6569_video_matrix_t, vmli),
+    CHIPS_FIELD_U8(m6569_video_matrix_t, next_vmli),
+    CHIPS_FIELD_U16(m6569_video_matrix_t, line),
+};
+
+static const chips_state_field_t _m6569_state_fields[] = {
+    CHIPS_FIELD_BOOL(m6569_t, debug_vis),
+    CHIPS_FIELD_STRUCT(m6569_t, reg, m6569_registers_t, _m6569_registers_state_fields),
+    CHIPS_FIELD_STRUCT(m6569_t, crt, m6569_crt_t, _m6569_crt_state_fields),
+    CHIPS_FIELD_STRUCT(m6569_t, brd, m6569_border_unit_t, _m6569_border_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6569_t, rs, m6569_raster_unit_t, _m6569_raster_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6569_t, mem, m6569_memory_unit_t, _m6569_memory_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6569_t, gunit, m6569_graphics_unit_t, _m6569_graphics_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6569_t, sunit, m6569_sprite_unit_t, _m6569_sprite_unit_state_fields),
+    CHIPS_FIELD_STRUCT(m6569_t, vm, m6569_video_matrix_t, _m6569_video_matrix_state_fields),
+    CHIPS_FIELD_U64(m6569_t, pins),
+};
+
+static const chips_state_desc_t _m6569_state_desc = CHIPS_STATE_DESC("m6569", m6569_t, _m6569_state_fields);
+
+const chips_state_desc_t* m6569_state_desc(void) {
+    return &_m6569_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
@@ -18,6 +18,10 @@
     CHIPS_ASSERT(c)
     ~~~
 
+    You need to include the following headers before including m6581.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
 
     ***********************************
@@ -36,6 +40,23 @@
     The emulation has an additional "virtual pin" which is set to active
     whenever a new sample is ready (M6581_SAMPLE).
 
+    ## Chip Revisions
+
+    The chip revision is selected with the m6581_desc_t.model item:
+
+    - **M6581_MODEL_6581**: the original 6581 (default)
+    - **M6581_MODEL_8580**: the later 8580 revision
+
+    The revisions differ in the combined waveforms (triangle+sawtooth,
+    triangle+pulse, sawtooth+pulse and triangle+sawtooth+pulse), and in
+    the filter cutoff curve. Combined waveforms are looked up in 4096-entry
+    tables per revision, which are created from a model fitted to waveforms
+    sampled from real chips (the model parameters are from reSIDfp). The
+    tables are shared by all m6581 instances and are built exactly once by
+    the first m6581_init() call, other threads calling m6581_init() at the
+    same time wait until the tables are complete, so separate m6581 instances
+    may be created and run on different threads.
+
     ## Links
 
     - http://blog.kevtris.org/?p=13
@@ -147,11 +168,19 @@ extern "C" {
 #define M6581_FILTER_HP     (1<<2)
 #define M6581_FILTER_3OFF   (1<<3)
 
+/* SID chip revisions */
+typedef enum {
+    M6581_MODEL_6581,   /* the original 6581 (default) */
+    M6581_MODEL_8580,   /* the later 8580 revision */
+    M6581_NUM_MODELS,
+} m6581_model_t;
+
 /* setup parameters for m6581_init() */
 typedef struct {
     int tick_hz;        /* frequency at which m6581_tick() will be called in Hz */
     int sound_hz;       /* sound sample frequency */
     float magnitude;    /* output sample magnitude (0=silence to 1=max volume) */
+    m6581_model_t model;    /* chip revision, default is M6581_MODEL_6581 */
 } m6581_desc_t;
 
 /* envelope generator state */
@@ -204,6 +233,7 @@ typedef struct {
 /* m6581 instance state */
 typedef struct {
     int sound_hz;
+    m6581_model_t model;
     /* reading a write-only register returns the last value
        written to *any* register for about 0x2000 ticks
     */
@@ -230,6 +260,8 @@ void m6581_init(m6581_t* sid, const m6581_desc_t* desc);
 void m6581_reset(m6581_t* sid);
 /* tick a m6581_t instance */
 uint64_t m6581_tick(m6581_t* sid, uint64_t pins);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* m6581_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -284,7 +316,59 @@ static const uint8_t _m6581_env_gen_dr_divisors[256] = {
     1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1    
 };
 
-static float _m6581_cutoff_freq[2048];
+/* 8580 cutoff curve control points (cutoff register value, frequency in Hz) from reSID */
+static const int _m6581_cutoff_points_8580[][2] = {
+    { 0, 0 }, { 128, 800 }, { 256, 1600 }, { 384, 2500 }, { 512, 3300 }, { 640, 4100 },
+    { 768, 4800 }, { 896, 5600 }, { 1024, 6300 }, { 1152, 7200 }, { 1280, 8000 },
+    { 1408, 8700 }, { 1536, 9500 }, { 1664, 10400 }, { 1792, 11200 }, { 1920, 12000 },
+    { 2047, 12800 }
+};
+
+/* combined waveforms per chip revision, waveform (TS, PT, PS, PTS) and
+   upper 12 accumulator bits, the pulse waveforms assume an active pulse
+*/
+static uint16_t _m6581_combined_waves[M6581_NUM_MODELS][4][4096];
+/* one-time init state of the combined waveform tables (0: empty, 1: building, 2: valid) */
+static long _m6581_combined_waves_state;
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static long _m6581_waves_state(void) { return _InterlockedCompareExchange(&_m6581_combined_waves_state, 0, 0); }
+static bool _m6581_waves_claim(void) { return 0 == _InterlockedCompareExchange(&_m6581_combined_waves_state, 1, 0); }
+static void _m6581_waves_publish(void) { _InterlockedExchange(&_m6581_combined_waves_state, 2); }
+#else
+static long _m6581_waves_state(void) { return __atomic_load_n(&_m6581_combined_waves_state, __ATOMIC_ACQUIRE); }
+static bool _m6581_waves_claim(void) {
+    long expected = 0;
+    return __atomic_compare_exchange_n(&_m6581_combined_waves_state, &expected, 1, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+static void _m6581_waves_publish(void) { __atomic_store_n(&_m6581_combined_waves_state, 2, __ATOMIC_RELEASE); }
+#endif
+
+/* parameters for the combined waveform model */
+typedef struct {
+    float bias;
+    float pulsestrength;
+    float topbit;
+    float distance;
+    float stmix;
+} _m6581_wave_config_t;
+
+/* fitted against samples from real chips, taken from reSIDfp */
+static const _m6581_wave_config_t _m6581_wave_config[M6581_NUM_MODELS][4] = {
+    {   /* 6581 R2 */
+        { 0.880815f,  0.0f,      0.0f,      0.3279614f,  0.5999545f },    /* TS */
+        { 0.8924618f, 2.014781f, 1.003332f, 0.02992322f, 0.0f },          /* PT */
+        { 0.8646501f, 1.712586f, 1.137704f, 0.02845423f, 0.0f },          /* PS */
+        { 0.9527834f, 1.794777f, 0.0f,      0.09806272f, 0.7752482f },    /* PTS */
+    },
+    {   /* 8580 R5 */
+        { 0.9781665f, 0.0f,      0.9899469f, 8.087667f,  0.8226412f },    /* TS */
+        { 0.9097769f, 2.039997f, 0.9584096f, 0.1765447f, 0.0f },          /* PT */
+        { 0.9231212f, 2.084788f, 0.9493895f, 0.1712518f, 0.0f },          /* PS */
+        { 0.9845552f, 1.415612f, 0.9703883f, 3.68829f,   0.8265008f },    /* PTS */
+    }
+};
 
 static void _m6581_init_voice(m6581_voice_t* v) {
     memset(v, 0, sizeof(*v));
@@ -293,21 +377,112 @@ static void _m6581_init_voice(m6581_voice_t* v) {
     v->env_counter = 0x7FFF;
 }
 
-static void _m6581_init_cutoff_table() {
-    for (int i = 0; i < 2048; i++) {
-        float x = i / 8.0f;
+/* filter cutoff frequency in Hz for an 11-bit cutoff register value */
+static float _m6581_cutoff_freq(m6581_model_t model, int cutoff) {
+    if (model == M6581_MODEL_8580) {
+        /* the 8580 curve is nearly linear, interpolate between control points */
+        int p = 0;
+        while ((p < 15) && (cutoff > _m6581_cutoff_points_8580[p+1][0])) {
+            p++;
+        }
+        const float x0 = (float) _m6581_cutoff_points_8580[p][0];
+        const float x1 = (float) _m6581_cutoff_points_8580[p+1][0];
+        const float y0 = (float) _m6581_cutoff_points_8580[p][1];
+        const float y1 = (float) _m6581_cutoff_points_8580[p+1][1];
+        return y0 + (y1 - y0) * ((float)cutoff - x0) / (x1 - x0);
+    }
+    else {
+        float x = cutoff / 8.0f;
         float cf = -0.0156f * x * x + 48.473f * x - 45.074f;
-        _m6581_cutoff_freq[i] = cf <= 0 ? 0 : cf;
+        return cf <= 0 ? 0 : cf;
     }
 }
 
-static void _m6581_set_filter_cutoff(m6581_filter_t*);
+/* compute a combined waveform output for waveform bits (3, 5, 6 or 7) and 12-bit accumulator */
+static uint16_t _m6581_combined_wave(const _m6581_wave_config_t* cfg, int waveform, int accum) {
+    float o[12];
+    /* sawtooth */
+    for (int i = 0; i < 12; i++) {
+        o[i] = (accum & (1<<i)) ? 1.0f : 0.0f;
+    }
+    if ((waveform & 3) == 1) {
+        /* convert to triangle */
+        const bool top = 0 != (accum & 0x800);
+        for (int i = 11; i > 0; i--) {
+            o[i] = top ? (1.0f - o[i-1]) : o[i-1];
+        }
+        o[0] = 0.0f;
+    }
+    else if ((waveform & 3) == 3) {
+        /* triangle+sawtooth: the sawtooth pulls down the triangle's XOR circuit,
+           so the result is a mix of two sawtooths, one at double speed
+        */
+        o[0] *= cfg->stmix;
+        for (int i = 1; i < 12; i++) {
+            o[i] = o[i-1] * (1.0f - cfg->stmix) + o[i] * cfg->stmix;
+        }
+    }
+    if ((waveform & 2) == 2) {
+        o[11] *= cfg->topbit;
+    }
+    /* neighbouring bits influence each other when waveforms are combined */
+    float dist[12*2+1];
+    for (int i = 0; i <= 12; i++) {
+        dist[12+i] = dist[12-i] = 1.0f / (1.0f + i * i * cfg->distance);
+    }
+    float tmp[12];
+    for (int i = 0; i < 12; i++) {
+        float avg = 0.0f;
+        float n = 0.0f;
+        for (int j = 0; j < 12; j++) {
+            const float weight = dist[i - j + 12];
+            avg += o[j] * weight;
+            n += weight;
+        }
+        if (waveform > 4) {
+            /* pulse control bit */
+            const float weight = dist[i];
+            avg += cfg->pulsestrength * weight;
+            n += weight;
+        }
+        tmp[i] = (o[i] + avg / n) * 0.5f;
+    }
+    uint16_t val = 0;
+    for (int i = 0; i < 12; i++) {
+        if (tmp[i] > cfg->bias) {
+            val |= (1<<i);
+        }
+    }
+    return val;
+}
+
+static void _m6581_init_combined_waves(void) {
+    if (_m6581_waves_state() == 2) {
+        return;
+    }
+    if (!_m6581_waves_claim()) {
+        /* another thread is building the tables, wait until it is done */
+        while (_m6581_waves_state() != 2) { }
+        return;
+    }
+    static const int waveforms[4] = { 3, 5, 6, 7 };
+    for (int model = 0; model < M6581_NUM_MODELS; model++) {
+        for (int w = 0; w < 4; w++) {
+            for (int accum = 0; accum < 4096; accum++) {
+                _m6581_combined_waves[model][w][accum] = _m6581_combined_wave(&_m6581_wave_config[model][w], waveforms[w], accum);
+            }
+        }
+    }
+    _m6581_waves_publish();
+}
+
+static void _m6581_set_filter_cutoff(m6581_filter_t*, m6581_model_t);
 static void _m6581_set_resonance(m6581_filter_t*);
 
-static void _m6581_init_filter(m6581_filter_t* f, int sound_hz) {
+static void _m6581_init_filter(m6581_filter_t* f, int sound_hz, m6581_model_t model) {
     memset(f, 0, sizeof(*f));
     f->nyquist_freq = sound_hz / 2;
-    _m6581_set_filter_cutoff(f);
+    _m6581_set_filter_cutoff(f, model);
     _m6581_set_resonance(f);
 }
 
@@ -315,8 +490,10 @@ void m6581_init(m6581_t* sid, const m6581_desc_t* desc) {
     CHIPS_ASSERT(sid && desc);
     CHIPS_ASSERT(desc->tick_hz > 0);
     CHIPS_ASSERT(desc->sound_hz > 0);
+    CHIPS_ASSERT((desc->model >= 0) && (desc->model < M6581_NUM_MODELS));
     memset(sid, 0, sizeof(*sid));
     sid->sound_hz = desc->sound_hz;
+    sid->model = desc->model;
     sid->sample_period = (desc->tick_hz * M6581_FIXEDPOINT_SCALE) / desc->sound_hz;
     sid->sample_counter = sid->sample_period;
     sid->sample_mag = desc->magnitude;
@@ -324,8 +501,8 @@ void m6581_init(m6581_t* sid, const m6581_desc_t* desc) {
     for (int i = 0; i < 3; i++) {
         _m6581_init_voice(&sid->voice[i]);
     }
-    _m6581_init_cutoff_table();
-    _m6581_init_filter(&sid->filter, sid->sound_hz);
+    _m6581_init_combined_waves();
+    _m6581_init_filter(&sid->filter, sid->sound_hz, sid->model);
 }
 
 void m6581_reset(m6581_t* sid) {
@@ -335,7 +512,7 @@ void m6581_reset(m6581_t* sid) {
     for (int i = 0; i < 3; i++) {
         _m6581_init_voice(&sid->voice[i]);
     }
-    _m6581_init_filter(&sid->filter, sid->sound_hz);
+    _m6581_init_filter(&sid->filter, sid->sound_hz, sid->model);
     sid->sample_counter = sid->sample_period;
     sid->sample = 0.0f;
     sid->sample_accum = 0.0f;
@@ -448,24 +625,15 @@ static inline uint32_t _m6581_pulse(m6581_voice_t* v) {
     }
 }
 
-static inline uint32_t _m6581_trisaw(m6581_voice_t* v, m6581_voice_t* v_sync) {
-    uint32_t sm = _m6581_triangle(v, v_sync) & _m6581_sawtooth(v);
-    return (sm >> 1) & (sm << 1);
+/* ring modulation flips the triangle's top bit in the triangle+sawtooth and triangle+pulse
+   combinations, the combinations with both sawtooth and pulse ignore it */
+static inline uint32_t _m6581_ring_msb(m6581_voice_t* v, m6581_voice_t* v_sync) {
+    return (v->ctrl & M6581_CTRL_RINGMOD) ? (v_sync->wav_accum & 0x00800000) : 0;
 }
 
-static inline uint32_t _m6581_tripulse(m6581_voice_t* v, m6581_voice_t* v_sync) {
-    uint32_t sm = _m6581_triangle(v, v_sync) & _m6581_pulse(v);
-    return (sm >> 1) & (sm << 1);
-}
-
-static inline uint32_t _m6581_sawpulse(m6581_voice_t* v) {
-    uint32_t sm = _m6581_sawtooth(v) & _m6581_pulse(v);
-    return (sm >> 1) & (sm << 1);
-}
-
-static inline uint32_t _m6581_trisawpulse(m6581_voice_t* v, m6581_voice_t* v_sync) {
-    uint32_t sm = _m6581_triangle(v, v_sync) & _m6581_sawtooth(v) & _m6581_pulse(v);
-    return (sm >> 1) && (sm << 1);
+/* combined waveform table lookup */
+static inline uint32_t _m6581_combined(const uint16_t* table, uint32_t accum) {
+    return table[accum >> 12];
 }
 
 static inline uint16_t _m6581_noise(m6581_voice_t* v) {
@@ -498,16 +666,17 @@ static inline void _m6581_voice_tick(m6581_t* sid, int voice_index) {
         v->sync = (v->wav_accum & 0x00800000) && !(prev_accum & 0x00800000);
     }
     m6581_voice_t* v_sync = &sid->voice[(voice_index+2)%3];
+    const uint16_t (*waves)[4096] = _m6581_combined_waves[sid->model];
     uint32_t sm;
     switch ((v->ctrl>>4) & 0x0F) {
         case 0: sm = _m6581_wavnone(v); break;
         case 1: sm = _m6581_triangle(v, v_sync); break;
         case 2: sm = _m6581_sawtooth(v); break;
-        case 3: sm = _m6581_trisaw(v, v_sync); break;
+        case 3: sm = _m6581_combined(waves[0], v->wav_accum ^ _m6581_ring_msb(v, v_sync)); break;
         case 4: sm = _m6581_pulse(v); break;
-        case 5: sm = _m6581_tripulse(v, v_sync); break;
-        case 6: sm = _m6581_sawpulse(v); break;
-        case 7: sm = _m6581_trisawpulse(v, v_sync); break;
+        case 5: sm = _m6581_combined(waves[1], v->wav_accum ^ _m6581_ring_msb(v, v_sync)) & _m6581_pulse(v); break;
+        case 6: sm = _m6581_combined(waves[2], v->wav_accum) & _m6581_pulse(v); break;
+        case 7: sm = _m6581_combined(waves[3], v->wav_accum) & _m6581_pulse(v); break;
         case 8: sm = _m6581_noise(v); break;
         default: sm = 0; break;
     }
@@ -564,9 +733,9 @@ static inline void _m6581_voice_sync(m6581_t* sid, int voice_index) {
 }
 
 /*--- FILTER IMPLEMENTATION ---------------------------------------------------*/
-static void _m6581_set_filter_cutoff(m6581_filter_t* f) {
+static void _m6581_set_filter_cutoff(m6581_filter_t* f, m6581_model_t model) {
     const float freq_domain_div_coeff = 2.0f * ((float)M_PI) * 1.048576f;
-    f->w0 = (int) (_m6581_cutoff_freq[f->cutoff] * freq_domain_div_coeff);
+    f->w0 = (int) (_m6581_cutoff_freq(model, f->cutoff) * freq_domain_div_coeff);
     const float nyquist_freq = (float) f->nyquist_freq;
     const float max_cutoff = nyquist_freq > 16000.0f ? 16000.0f : nyquist_freq;
     const int w0_max_dt = (int)(max_cutoff * freq_domain_div_coeff);
@@ -579,16 +748,18 @@ static void _m6581_set_resonance(m6581_filter_t* f) {
     f->resonance_coeff_div_1024 = (int) (1024.0f/(0.707f + 1.9f * ((float)f->resonance) / 15.0f) + 0.5f);
 }
 
-static void _m6581_set_cutoff_lo(m6581_filter_t* f, uint8_t data) {
+static void _m6581_set_cutoff_lo(m6581_t* sid, uint8_t data) {
+    m6581_filter_t* f = &sid->filter;
     if ((data ^ f->cutoff) & 7) {
         f->cutoff = (f->cutoff & 0x7F8) | (data & 7);
-        _m6581_set_filter_cutoff(f);
+        _m6581_set_filter_cutoff(f, sid->model);
     }
 }
 
-static void _m6581_set_cutoff_hi(m6581_filter_t* f, uint8_t data) {
+static void _m6581_set_cutoff_hi(m6581_t* sid, uint8_t data) {
+    m6581_filter_t* f = &sid->filter;
     f->cutoff = (data<< 3) | (f->cutoff & 7);
-    _m6581_set_filter_cutoff(f);
+    _m6581_set_filter_cutoff(f, sid->model);
 }
 
 static void _m6581_set_resfilt(m6581_filter_t* f, uint8_t data) {
@@ -782,10 +953,10 @@ static void _m6581_write(m6581_t* sid, uint64_t pins) {
             _m6581_set_susrel(&sid->voice[2], data);
             break;
         case M6581_FC_LO:
-            _m6581_set_cutoff_lo(&sid->filter, data);
+            _m6581_set_cutoff_lo(sid, data);
             break;
         case M6581_FC_HI:
-            _m6581_set_cutoff_hi(&sid->filter, data);
+            _m6581_set_cutoff_hi(sid, data);
             break;
         case M6581_RES_FILT:
             _m6581_set_resfilt(&sid->filter, data);
@@ -816,4 +987,60 @@ uint64_t m6581_tick(m6581_t* sid, uint64_t pins) {
     return pins;
 }
 
+static const chips_state_field_t _m6581_voice_state_fields[] = {
+    CHIPS_FIELD_BOOL(m6581_voice_t, muted),
+    CHIPS_FIELD_U16(m6581_voice_t, freq),
+    CHIPS_FIELD_U16(m6581_voice_t, pulse_width),
+    CHIPS_FIELD_U8(m6581_voice_t, ctrl),
+    CHIPS_FIELD_BOOL(m6581_voice_t, sync),
+    CHIPS_FIELD_U32(m6581_voice_t, noise_shift),
+    CHIPS_FIELD_U32(m6581_voice_t, wav_accum),
+    CHIPS_FIELD_U32(m6581_voice_t, wav_output),
+    CHIPS_FIELD_ENUM(m6581_voice_t, env_state),
+    CHIPS_FIELD_U32(m6581_voice_t, env_attack_add),
+    CHIPS_FIELD_U32(m6581_voice_t, env_decay_sub),
+    CHIPS_FIELD_U32(m6581_voice_t, env_sustain_level),
+    CHIPS_FIELD_U32(m6581_voice_t, env_release_sub),
+    CHIPS_FIELD_U32(m6581_voice_t, env_cur_level),
+    CHIPS_FIELD_U32(m6581_voice_t, env_counter),
+    CHIPS_FIELD_U32(m6581_voice_t, env_exp_counter),
+    CHIPS_FIELD_U32(m6581_voice_t, env_counter_compare),
+};
+
+static const chips_state_field_t _m6581_filter_state_fields[] = {
+    CHIPS_FIELD_U16(m6581_filter_t, cutoff),
+    CHIPS_FIELD_U8(m6581_filter_t, resonance),
+    CHIPS_FIELD_U8(m6581_filter_t, voices),
+    CHIPS_FIELD_U8(m6581_filter_t, mode),
+    CHIPS_FIELD_U8(m6581_filter_t, volume),
+    CHIPS_FIELD_INT(m6581_filter_t, nyquist_freq),
+    CHIPS_FIELD_INT(m6581_filter_t, resonance_coeff_div_1024),
+    CHIPS_FIELD_INT(m6581_filter_t, w0),
+    CHIPS_FIELD_INT(m6581_filter_t, v_hp),
+    CHIPS_FIELD_INT(m6581_filter_t, v_bp),
+    CHIPS_FIELD_INT(m6581_filter_t, v_lp),
+};
+
+static const chips_state_field_t _m6581_state_fields[] = {
+    CHIPS_FIELD_INT(m6581_t, sound_hz),
+    CHIPS_FIELD_ENUM(m6581_t, model),
+    CHIPS_FIELD_U8(m6581_t, bus_value),
+    CHIPS_FIELD_U16(m6581_t, bus_decay),
+    CHIPS_FIELD_STRUCT(m6581_t, voice, m6581_voice_t, _m6581_voice_state_fields),
+    CHIPS_FIELD_STRUCT(m6581_t, filter, m6581_filter_t, _m6581_filter_state_fields),
+    CHIPS_FIELD_INT(m6581_t, sample_period),
+    CHIPS_FIELD_INT(m6581_t, sample_counter),
+    CHIPS_FIELD_FLOAT(m6581_t, sample_accum),
+    CHIPS_FIELD_FLOAT(m6581_t, sample_accum_count),
+    CHIPS_FIELD_FLOAT(m6581_t, sample_mag),
+    CHIPS_FIELD_FLOAT(m6581_t, sample),
+    CHIPS_FIELD_U64(m6581_t, pins),
+};
+
+static const chips_state_desc_t _m6581_state_desc = CHIPS_STATE_DESC("m6581", m6581_t, _m6581_state_fields);
+
+const chips_state_desc_t* m6581_state_desc(void) {
+    return &_m6581_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
@@ -21,6 +21,10 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    You need to include the following headers before including mc6845.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
     **********************************
     *           +----------+         *
@@ -253,6 +257,8 @@ void mc6845_reset(mc6845_t* mc6845);
 uint64_t mc6845_iorq(mc6845_t* mc6845, uint64_t pins);
 /* tick the mc6845, the returned pin mask overwrittes addr bus pins with MA0..MA13! */
 uint64_t mc6845_tick(mc6845_t* mc6845);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* mc6845_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -627,4 +633,38 @@ uint64_t mc6845_tick(mc6845_t* c) {
     return _mc6845_pins(c);
 }
 
+static const chips_state_field_t _mc6845_state_fields[] = {
+    CHIPS_FIELD_ENUM(mc6845_t, type),
+    CHIPS_FIELD_U8(mc6845_t, sel),
+    CHIPS_FIELD_U8(mc6845_t, reg),
+    CHIPS_FIELD_BOOL(mc6845_t, co_htotal),
+    CHIPS_FIELD_BOOL(mc6845_t, co_hdisp),
+    CHIPS_FIELD_BOOL(mc6845_t, co_hspos),
+    CHIPS_FIELD_BOOL(mc6845_t, co_hswidth),
+    CHIPS_FIELD_BOOL(mc6845_t, co_vtotal),
+    CHIPS_FIELD_BOOL(mc6845_t, co_vdisp),
+    CHIPS_FIELD_BOOL(mc6845_t, co_vspos),
+    CHIPS_FIELD_BOOL(mc6845_t, co_vswidth),
+    CHIPS_FIELD_BOOL(mc6845_t, co_raster),
+    CHIPS_FIELD_U8(mc6845_t, h_ctr),
+    CHIPS_FIELD_U8(mc6845_t, hsync_ctr),
+    CHIPS_FIELD_U16(mc6845_t, ma),
+    CHIPS_FIELD_U16(mc6845_t, ma_row_start),
+    CHIPS_FIELD_U16(mc6845_t, ma_store),
+    CHIPS_FIELD_U8(mc6845_t, v_ctr),
+    CHIPS_FIELD_U8(mc6845_t, r_ctr),
+    CHIPS_FIELD_U8(mc6845_t, vsync_ctr),
+    CHIPS_FIELD_BOOL(mc6845_t, hs),
+    CHIPS_FIELD_BOOL(mc6845_t, vs),
+    CHIPS_FIELD_BOOL(mc6845_t, h_de),
+    CHIPS_FIELD_BOOL(mc6845_t, v_de),
+    CHIPS_FIELD_U64(mc6845_t, pins),
+};
+
+static const chips_state_desc_t _mc6845_state_desc = CHIPS_STATE_DESC("mc6845", mc6845_t, _mc6845_state_fields);
+
+const chips_state_desc_t* mc6845_state_desc(void) {
+    return &_mc6845_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
@@ -11,6 +11,10 @@
     
         CHIPS_ASSERT(c)     -- your own assert macro (default: assert(c))
 
+    You need to include the following headers before including mc6847.h:
+
+    - chips/chips_state.h
+
     EMULATED PINS:
 
                   +-----------+
@@ -247,6 +251,8 @@ void mc6847_init(mc6847_t* vdg, const mc6847_desc_t* desc);
 void mc6847_reset(mc6847_t* vdg);
 /* tick the mc6847_t instance, this will call the fetch_cb and generate the image */
 uint64_t mc6847_tick(mc6847_t* vdg, uint64_t pins);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* mc6847_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -625,4 +631,26 @@ uint64_t mc6847_tick(mc6847_t* vdg, uint64_t pins) {
     return pins;
 }
 
+static const chips_state_field_t _mc6847_state_fields[] = {
+    CHIPS_FIELD_U64(mc6847_t, pins),
+    CHIPS_FIELD_U32(mc6847_t, palette),
+    CHIPS_FIELD_U32(mc6847_t, black),
+    CHIPS_FIELD_U32(mc6847_t, alnum_green),
+    CHIPS_FIELD_U32(mc6847_t, alnum_dark_green),
+    CHIPS_FIELD_U32(mc6847_t, alnum_orange),
+    CHIPS_FIELD_U32(mc6847_t, alnum_dark_orange),
+    CHIPS_FIELD_INT(mc6847_t, h_count),
+    CHIPS_FIELD_INT(mc6847_t, h_sync_start),
+    CHIPS_FIELD_INT(mc6847_t, h_sync_end),
+    CHIPS_FIELD_INT(mc6847_t, h_period),
+    CHIPS_FIELD_INT(mc6847_t, l_count),
+    CHIPS_FIELD_BOOL(mc6847_t, fs),
+};
+
+static const chips_state_desc_t _mc6847_state_desc = CHIPS_STATE_DESC("mc6847", mc6847_t, _mc6847_state_fields);
+
+const chips_state_desc_t* mc6847_state_desc(void) {
+    return &_mc6847_state_desc;
+}
+
 # endif /* CHIPS_IMPL */
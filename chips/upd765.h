@@ -18,6 +18,10 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    You need to include the following headers before including upd765.h:
+
+    - chips/chips_state.h
+
     ## NOT IMPLEMENTED
 
         Initially, only the features required by Amstrad CPC are implemented,
@@ -243,6 +247,8 @@ void upd765_init(upd765_t* upd, const upd765_desc_t* desc);
 void upd765_reset(upd765_t* upd);
 /* perform an IO request on the upd765 */
 uint64_t upd765_iorq(upd765_t* upd, uint64_t pins);
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* upd765_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -670,4 +676,43 @@ uint64_t upd765_iorq(upd765_t* upd, uint64_t pins) {
     }
     return pins;
 }
+
+static const chips_state_field_t _upd765_sectorinfo_state_fields[] = {
+    CHIPS_FIELD_INT(upd765_sectorinfo_t, physical_track),
+    CHIPS_FIELD_U8(upd765_sectorinfo_t, c),
+    CHIPS_FIELD_U8(upd765_sectorinfo_t, h),
+    CHIPS_FIELD_U8(upd765_sectorinfo_t, r),
+    CHIPS_FIELD_U8(upd765_sectorinfo_t, n),
+    CHIPS_FIELD_U8(upd765_sectorinfo_t, st1),
+    CHIPS_FIELD_U8(upd765_sectorinfo_t, st2),
+};
+
+static const chips_state_field_t _upd765_driveinfo_state_fields[] = {
+    CHIPS_FIELD_INT(upd765_driveinfo_t, physical_track),
+    CHIPS_FIELD_INT(upd765_driveinfo_t, sides),
+    CHIPS_FIELD_INT(upd765_driveinfo_t, head),
+    CHIPS_FIELD_BOOL(upd765_driveinfo_t, ready),
+    CHIPS_FIELD_BOOL(upd765_driveinfo_t, write_protected),
+    CHIPS_FIELD_BOOL(upd765_driveinfo_t, fault),
+};
+
+static const chips_state_field_t _upd765_state_fields[] = {
+    CHIPS_FIELD_INT(upd765_t, phase),
+    CHIPS_FIELD_INT(upd765_t, cmd),
+    CHIPS_FIELD_INT(upd765_t, fifo_pos),
+    CHIPS_FIELD_INT(upd765_t, fifo_num),
+    CHIPS_FIELD_U8(upd765_t, fifo),
+    CHIPS_FIELD_STRUCT(upd765_t, sector_info, upd765_sectorinfo_t, _upd765_sectorinfo_state_fields),
+    CHIPS_FIELD_STRUCT(upd765_t, drive_info, upd765_driveinfo_t, _upd765_driveinfo_state_fields),
+    CHIPS_FIELD_U8(upd765_t, st),
+    CHIPS_FIELD_U64(upd765_t, pins),
+    CHIPS_FIELD_U8(upd765_t, status),
+};
+
+static const chips_state_desc_t _upd765_state_desc = CHIPS_STATE_DESC("upd765", upd765_t, _upd765_state_fields);
+
+const chips_state_desc_t* upd765_state_desc(void) {
+    return &_upd765_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
@@ -23,6 +23,22 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_Z80_COMPUTED_GOTO
+    ~~~
+        if defined, and the compiler is GCC or Clang, the instruction
+        decoder dispatches through a table of label addresses (the
+        'labels as values' extension) instead of a switch-case statement,
+        and each instruction handler directly fetches and jumps to the next
+        instruction if no interrupt or other special handling is pending.
+        This gives the branch predictor one indirect jump site per
+        instruction instead of a single shared one. On other compilers
+        the define is ignored and the regular switch-case decoder is used.
+
+    You need to include the following headers before including z80.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
     ***********************************
     *           +-----------+         *
@@ -140,6 +156,24 @@
     ~~~
         used in tick function at end of interrupt daisy-chain block
 
+    ~~~C
+    Z80_DAISYCHAIN_BEGIN_IF(pins, active)
+    Z80_DAISYCHAIN_END_IF(pins)
+    ~~~
+        same as Z80_DAISYCHAIN_BEGIN/END, but the daisy-chain block
+        is only executed when the 'active' expression is true, typically
+        this is the combined int_active bitmask of all devices in
+        the daisy chain (the RETI pin is cleared in any case):
+
+        ~~~C
+        Z80_DAISYCHAIN_BEGIN_IF(pins, sys->ctc.int_active|sys->pio.int_active)
+        {
+            pins = z80ctc_int(&sys->ctc, pins);
+            pins = z80pio_int(&sys->pio, pins);
+        }
+        Z80_DAISYCHAIN_END_IF(pins);
+        ~~~
+
     ## The Tick Callback 
 
     The tick function is called for one or multiple time cycles
@@ -478,6 +512,10 @@ bool z80_ei_pending(z80_t* cpu);
 #define Z80_DAISYCHAIN_BEGIN(pins) if (pins&Z80_M1) { pins|=Z80_IEIO;
 /* helper macro to end interrupt handling in tick callback */
 #define Z80_DAISYCHAIN_END(pins) pins&=~Z80_RETI; }
+/* same as Z80_DAISYCHAIN_BEGIN, but skip the daisy chain if no device has interrupt activity */
+#define Z80_DAISYCHAIN_BEGIN_IF(pins,active) if (pins&Z80_M1) { pins|=Z80_IEIO; if (active) {
+/* helper macro to end a Z80_DAISYCHAIN_BEGIN_IF block */
+#define Z80_DAISYCHAIN_END_IF(pins) } pins&=~Z80_RETI; }
 /* return a pin mask with control-pins, address and data bus */
 #define Z80_MAKE_PINS(ctrl, addr, data) ((ctrl)|(((data)<<16)&0xFF0000ULL)|((addr)&0xFFFFULL))
 /* extract 16-bit address bus from 64-bit pins */
@@ -492,6 +530,8 @@ bool z80_ei_pending(z80_t* cpu);
 #define Z80_GET_WAIT(p) ((p&Z80_WAIT_MASK)>>Z80_WAIT_SHIFT)
 /* set up to 7 wait states in pin mask */
 #define Z80_SET_WAIT(p,w) {p=((p&~Z80_WAIT_MASK)|((((uint64_t)w)<<Z80_WAIT_SHIFT)&Z80_WAIT_MASK));}
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* z80_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -629,6 +669,22 @@ bool z80_ei_pending(z80_t* cpu);
 #else
 #define _FETCH(op) {_SA(pc++);_TWM(4,Z80_M1|Z80_MREQ|Z80_RD);op=_GD();_BUMPR();}
 #endif
+/* instruction dispatch: either switch-case, or computed goto with a
+   replicated fetch-and-dispatch at the end of each instruction handler,
+   this takes the fast path only if no interrupt, EI delay, trap callback
+   or end-of-time-slice needs to be handled, after an indexed instruction
+   the HL <=> IX/IY mapping is undone inline so that IX/IY-heavy code
+   stays on the fast path
+*/
+#if defined(CHIPS_Z80_COMPUTED_GOTO) && (defined(__GNUC__) || defined(__clang__))
+#define _Z80_COMPUTED_GOTO (1)
+#define _OP(op) _z80_op_##op
+#define _UNMAP() if(r2&_BITS_USE_IXIY){r0=_z80_flush_r0(ws,r0,r2);r1=_z80_flush_r1(ws,r1,r2);r2&=~_BITS_USE_IXIY;map_bits=0;ws=r0;}
+#define _NEXT() if ((ticks<num_ticks)&&!trap&&(0==((pins&(Z80_INT|Z80_NMI))|(r2&_BIT_EI)))){_UNMAP();pre_pins=pins;_FETCH(op);goto *_z80_op_table[op];}goto _z80_op_end;
+#else
+#define _OP(op) case op
+#define _NEXT() break;
+#endif
 /* special opcode fetch for CB prefix, only bump R if not a DD/FD+CB 'double prefix' op */
 #define _FETCH_CB(op) {_SA(pc++);_TWM(4,Z80_M1|Z80_MREQ|Z80_RD);op=_GD();if(!_IDX()){_BUMPR();}}
 /* evaluate S+Z flags */
@@ -863,211 +919,250 @@ uint32_t z80_exec(z80_t* cpu, uint32_t num_ticks) {
             ws = _z80_map_regs(r0, r1, r2);
         }
         /* decode instruction */
+        #if defined(_Z80_COMPUTED_GOTO)
+        static const void* _z80_op_table[256] = {
+            &&_z80_op_0x0,&&_z80_op_0x1,&&_z80_op_0x2,&&_z80_op_0x3,&&_z80_op_0x4,&&_z80_op_0x5,&&_z80_op_0x6,&&_z80_op_0x7,
+            &&_z80_op_0x8,&&_z80_op_0x9,&&_z80_op_0xa,&&_z80_op_0xb,&&_z80_op_0xc,&&_z80_op_0xd,&&_z80_op_0xe,&&_z80_op_0xf,
+            &&_z80_op_0x10,&&_z80_op_0x11,&&_z80_op_0x12,&&_z80_op_0x13,&&_z80_op_0x14,&&_z80_op_0x15,&&_z80_op_0x16,&&_z80_op_0x17,
+            &&_z80_op_0x18,&&_z80_op_0x19,&&_z80_op_0x1a,&&_z80_op_0x1b,&&_z80_op_0x1c,&&_z80_op_0x1d,&&_z80_op_0x1e,&&_z80_op_0x1f,
+            &&_z80_op_0x20,&&_z80_op_0x21,&&_z80_op_0x22,&&_z80_op_0x23,&&_z80_op_0x24,&&_z80_op_0x25,&&_z80_op_0x26,&&_z80_op_0x27,
+            &&_z80_op_0x28,&&_z80_op_0x29,&&_z80_op_0x2a,&&_z80_op_0x2b,&&_z80_op_0x2c,&&_z80_op_0x2d,&&_z80_op_0x2e,&&_z80_op_0x2f,
+            &&_z80_op_0x30,&&_z80_op_0x31,&&_z80_op_0x32,&&_z80_op_0x33,&&_z80_op_0x34,&&_z80_op_0x35,&&_z80_op_0x36,&&_z80_op_0x37,
+            &&_z80_op_0x38,&&_z80_op_0x39,&&_z80_op_0x3a,&&_z80_op_0x3b,&&_z80_op_0x3c,&&_z80_op_0x3d,&&_z80_op_0x3e,&&_z80_op_0x3f,
+            &&_z80_op_0x40,&&_z80_op_0x41,&&_z80_op_0x42,&&_z80_op_0x43,&&_z80_op_0x44,&&_z80_op_0x45,&&_z80_op_0x46,&&_z80_op_0x47,
+            &&_z80_op_0x48,&&_z80_op_0x49,&&_z80_op_0x4a,&&_z80_op_0x4b,&&_z80_op_0x4c,&&_z80_op_0x4d,&&_z80_op_0x4e,&&_z80_op_0x4f,
+            &&_z80_op_0x50,&&_z80_op_0x51,&&_z80_op_0x52,&&_z80_op_0x53,&&_z80_op_0x54,&&_z80_op_0x55,&&_z80_op_0x56,&&_z80_op_0x57,
+            &&_z80_op_0x58,&&_z80_op_0x59,&&_z80_op_0x5a,&&_z80_op_0x5b,&&_z80_op_0x5c,&&_z80_op_0x5d,&&_z80_op_0x5e,&&_z80_op_0x5f,
+            &&_z80_op_0x60,&&_z80_op_0x61,&&_z80_op_0x62,&&_z80_op_0x63,&&_z80_op_0x64,&&_z80_op_0x65,&&_z80_op_0x66,&&_z80_op_0x67,
+            &&_z80_op_0x68,&&_z80_op_0x69,&&_z80_op_0x6a,&&_z80_op_0x6b,&&_z80_op_0x6c,&&_z80_op_0x6d,&&_z80_op_0x6e,&&_z80_op_0x6f,
+            &&_z80_op_0x70,&&_z80_op_0x71,&&_z80_op_0x72,&&_z80_op_0x73,&&_z80_op_0x74,&&_z80_op_0x75,&&_z80_op_0x76,&&_z80_op_0x77,
+            &&_z80_op_0x78,&&_z80_op_0x79,&&_z80_op_0x7a,&&_z80_op_0x7b,&&_z80_op_0x7c,&&_z80_op_0x7d,&&_z80_op_0x7e,&&_z80_op_0x7f,
+            &&_z80_op_0x80,&&_z80_op_0x81,&&_z80_op_0x82,&&_z80_op_0x83,&&_z80_op_0x84,&&_z80_op_0x85,&&_z80_op_0x86,&&_z80_op_0x87,
+            &&_z80_op_0x88,&&_z80_op_0x89,&&_z80_op_0x8a,&&_z80_op_0x8b,&&_z80_op_0x8c,&&_z80_op_0x8d,&&_z80_op_0x8e,&&_z80_op_0x8f,
+            &&_z80_op_0x90,&&_z80_op_0x91,&&_z80_op_0x92,&&_z80_op_0x93,&&_z80_op_0x94,&&_z80_op_0x95,&&_z80_op_0x96,&&_z80_op_0x97,
+            &&_z80_op_0x98,&&_z80_op_0x99,&&_z80_op_0x9a,&&_z80_op_0x9b,&&_z80_op_0x9c,&&_z80_op_0x9d,&&_z80_op_0x9e,&&_z80_op_0x9f,
+            &&_z80_op_0xa0,&&_z80_op_0xa1,&&_z80_op_0xa2,&&_z80_op_0xa3,&&_z80_op_0xa4,&&_z80_op_0xa5,&&_z80_op_0xa6,&&_z80_op_0xa7,
+            &&_z80_op_0xa8,&&_z80_op_0xa9,&&_z80_op_0xaa,&&_z80_op_0xab,&&_z80_op_0xac,&&_z80_op_0xad,&&_z80_op_0xae,&&_z80_op_0xaf,
+            &&_z80_op_0xb0,&&_z80_op_0xb1,&&_z80_op_0xb2,&&_z80_op_0xb3,&&_z80_op_0xb4,&&_z80_op_0xb5,&&_z80_op_0xb6,&&_z80_op_0xb7,
+            &&_z80_op_0xb8,&&_z80_op_0xb9,&&_z80_op_0xba,&&_z80_op_0xbb,&&_z80_op_0xbc,&&_z80_op_0xbd,&&_z80_op_0xbe,&&_z80_op_0xbf,
+            &&_z80_op_0xc0,&&_z80_op_0xc1,&&_z80_op_0xc2,&&_z80_op_0xc3,&&_z80_op_0xc4,&&_z80_op_0xc5,&&_z80_op_0xc6,&&_z80_op_0xc7,
+            &&_z80_op_0xc8,&&_z80_op_0xc9,&&_z80_op_0xca,&&_z80_op_0xcb,&&_z80_op_0xcc,&&_z80_op_0xcd,&&_z80_op_0xce,&&_z80_op_0xcf,
+            &&_z80_op_0xd0,&&_z80_op_0xd1,&&_z80_op_0xd2,&&_z80_op_0xd3,&&_z80_op_0xd4,&&_z80_op_0xd5,&&_z80_op_0xd6,&&_z80_op_0xd7,
+            &&_z80_op_0xd8,&&_z80_op_0xd9,&&_z80_op_0xda,&&_z80_op_0xdb,&&_z80_op_0xdc,&&_z80_op_0xdd,&&_z80_op_0xde,&&_z80_op_0xdf,
+            &&_z80_op_0xe0,&&_z80_op_0xe1,&&_z80_op_0xe2,&&_z80_op_0xe3,&&_z80_op_0xe4,&&_z80_op_0xe5,&&_z80_op_0xe6,&&_z80_op_0xe7,
+            &&_z80_op_0xe8,&&_z80_op_0xe9,&&_z80_op_0xea,&&_z80_op_0xeb,&&_z80_op_0xec,&&_z80_op_0xed,&&_z80_op_0xee,&&_z80_op_0xef,
+            &&_z80_op_0xf0,&&_z80_op_0xf1,&&_z80_op_0xf2,&&_z80_op_0xf3,&&_z80_op_0xf4,&&_z80_op_0xf5,&&_z80_op_0xf6,&&_z80_op_0xf7,
+            &&_z80_op_0xf8,&&_z80_op_0xf9,&&_z80_op_0xfa,&&_z80_op_0xfb,&&_z80_op_0xfc,&&_z80_op_0xfd,&&_z80_op_0xfe,&&_z80_op_0xff,
+        };
+        goto *_z80_op_table[op];
+        {
+        #else
         switch (op) {
-            case 0x0:/*NOP*/ break;
-            case 0x1:/*LD BC,nn*/_IMM16(d16);_S_BC(d16);break;
-            case 0x2:/*LD (BC),A*/addr=_G_BC();d8=_G_A();_MW(addr++,d8);_S_WZ((d8<<8)|(addr&0x00FF));break;
-            case 0x3:/*INC BC*/_T(2);_S_BC(_G_BC()+1);break;
-            case 0x4:/*INC B*/d8=_G_B();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_B(d8);break;
-            case 0x5:/*DEC B*/d8=_G_B();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_B(d8);break;
-            case 0x6:/*LD B,n*/_IMM8(d8);_S_B(d8);break;
-            case 0x7:/*RLCA*/{uint8_t a=_G_A();uint8_t f=_G_F();uint8_t r=(a<<1)|(a>>7);f=((a>>7)&Z80_CF)|(f&(Z80_SF|Z80_ZF|Z80_PF))|(r&(Z80_YF|Z80_XF));_S_A(r);_S_F(f);}break;
-            case 0x8:/*EX AF,AF'*/{r0=_z80_flush_r0(ws,r0,r2);uint16_t fa=_G16(r0,_FA);uint16_t fa_=_G16(r3,_FA);_S16(r0,_FA,fa_);_S16(r3,_FA,fa);ws=_z80_map_regs(r0,r1,r2);}break;
-            case 0x9:/*ADD HL,BC*/{uint16_t acc=_G_HL();_S_WZ(acc+1);d16=_G_BC();uint32_t r=acc+d16;_S_HL(r);uint8_t f=_G_F()&(Z80_SF|Z80_ZF|Z80_VF);f|=((acc^r^d16)>>8)&Z80_HF;f|=((r>>16)&Z80_CF)|((r>>8)&(Z80_YF|Z80_XF));_S_F(f);_T(7);}break;
-            case 0xa:/*LD A,(BC)*/addr=_G_BC();_MR(addr++,d8);_S_A(d8);_S_WZ(addr);break;
-            case 0xb:/*DEC BC*/_T(2);_S_BC(_G_BC()-1);break;
-            case 0xc:/*INC C*/d8=_G_C();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_C(d8);break;
-            case 0xd:/*DEC C*/d8=_G_C();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_C(d8);break;
-            case 0xe:/*LD C,n*/_IMM8(d8);_S_C(d8);break;
-            case 0xf:/*RRCA*/{uint8_t a=_G_A();uint8_t f=_G_F();uint8_t r=(a>>1)|(a<<7);f=(a&Z80_CF)|(f&(Z80_SF|Z80_ZF|Z80_PF))|(r&(Z80_YF|Z80_XF));_S_A(r);_S_F(f);}break;
-            case 0x10:/*DJNZ*/{_T(1);int8_t d;_IMM8(d);d8=_G_B()-1;_S_B(d8);if(d8>0){pc+=d;_S_WZ(pc);_T(5);}}break;
-            case 0x11:/*LD DE,nn*/_IMM16(d16);_S_DE(d16);break;
-            case 0x12:/*LD (DE),A*/addr=_G_DE();d8=_G_A();_MW(addr++,d8);_S_WZ((d8<<8)|(addr&0x00FF));break;
-            case 0x13:/*INC DE*/_T(2);_S_DE(_G_DE()+1);break;
-            case 0x14:/*INC D*/d8=_G_D();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_D(d8);break;
-            case 0x15:/*DEC D*/d8=_G_D();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_D(d8);break;
-            case 0x16:/*LD D,n*/_IMM8(d8);_S_D(d8);break;
-            case 0x17:/*RLA*/{uint8_t a=_G_A();uint8_t f=_G_F();uint8_t r=(a<<1)|(f&Z80_CF);f=((a>>7)&Z80_CF)|(f&(Z80_SF|Z80_ZF|Z80_PF))|(r&(Z80_YF|Z80_XF));_S_A(r);_S_F(f);}break;
-            case 0x18:/*JR d*/{int8_t d;_IMM8(d);pc+=d;_S_WZ(pc);_T(5);}break;
-            case 0x19:/*ADD HL,DE*/{uint16_t acc=_G_HL();_S_WZ(acc+1);d16=_G_DE();uint32_t r=acc+d16;_S_HL(r);uint8_t f=_G_F()&(Z80_SF|Z80_ZF|Z80_VF);f|=((acc^r^d16)>>8)&Z80_HF;f|=((r>>16)&Z80_CF)|((r>>8)&(Z80_YF|Z80_XF));_S_F(f);_T(7);}break;
-            case 0x1a:/*LD A,(DE)*/addr=_G_DE();_MR(addr++,d8);_S_A(d8);_S_WZ(addr);break;
-            case 0x1b:/*DEC DE*/_T(2);_S_DE(_G_DE()-1);break;
-            case 0x1c:/*INC E*/d8=_G_E();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_E(d8);break;
-            case 0x1d:/*DEC E*/d8=_G_E();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_E(d8);break;
-            case 0x1e:/*LD E,n*/_IMM8(d8);_S_E(d8);break;
-            case 0x1f:/*RRA*/{uint8_t a=_G_A();uint8_t f=_G_F();uint8_t r=(a>>1)|((f&Z80_CF)<<7);f=(a&Z80_CF)|(f&(Z80_SF|Z80_ZF|Z80_PF))|(r&(Z80_YF|Z80_XF));_S_A(r);_S_F(f);}break;
-            case 0x20:/*JR NZ,d*/{int8_t d;_IMM8(d);if(!(_G_F()&Z80_ZF)){pc+=d;_S_WZ(pc);_T(5);}}break;
-            case 0x21:/*LD HL,nn*/_IMM16(d16);_S_HL(d16);break;
-            case 0x22:/*LD (nn),HL*/_IMM16(addr);_MW(addr++,_G_L());_MW(addr,_G_H());_S_WZ(addr);break;
-            case 0x23:/*INC HL*/_T(2);_S_HL(_G_HL()+1);break;
-            case 0x24:/*INC H*/d8=_G_H();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_H(d8);break;
-            case 0x25:/*DEC H*/d8=_G_H();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_H(d8);break;
-            case 0x26:/*LD H,n*/_IMM8(d8);_S_H(d8);break;
-            case 0x27:/*DAA*/ws=_z80_daa(ws);break;
-            case 0x28:/*JR Z,d*/{int8_t d;_IMM8(d);if((_G_F()&Z80_ZF)){pc+=d;_S_WZ(pc);_T(5);}}break;
-            case 0x29:/*ADD HL,HL*/{uint16_t acc=_G_HL();_S_WZ(acc+1);d16=_G_HL();uint32_t r=acc+d16;_S_HL(r);uint8_t f=_G_F()&(Z80_SF|Z80_ZF|Z80_VF);f|=((acc^r^d16)>>8)&Z80_HF;f|=((r>>16)&Z80_CF)|((r>>8)&(Z80_YF|Z80_XF));_S_F(f);_T(7);}break;
-            case 0x2a:/*LD HL,(nn)*/_IMM16(addr);_MR(addr++,d8);_S_L(d8);_MR(addr,d8);_S_H(d8);_S_WZ(addr);break;
-            case 0x2b:/*DEC HL*/_T(2);_S_HL(_G_HL()-1);break;
-            case 0x2c:/*INC L*/d8=_G_L();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_L(d8);break;
-            case 0x2d:/*DEC L*/d8=_G_L();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_L(d8);break;
-            case 0x2e:/*LD L,n*/_IMM8(d8);_S_L(d8);break;
-            case 0x2f:/*CPL*/{uint8_t a=_G_A()^0xFF;_S_A(a);uint8_t f=_G_F();f=(f&(Z80_SF|Z80_ZF|Z80_PF|Z80_CF))|Z80_HF|Z80_NF|(a&(Z80_YF|Z80_XF));_S_F(f);}break;
-            case 0x30:/*JR NC,d*/{int8_t d;_IMM8(d);if(!(_G_F()&Z80_CF)){pc+=d;_S_WZ(pc);_T(5);}}break;
-            case 0x31:/*LD SP,nn*/_IMM16(d16);_S_SP(d16);break;
-            case 0x32:/*LD (nn),A*/_IMM16(addr);d8=_G_A();_MW(addr++,d8);_S_WZ((d8<<8)|(addr&0x00FF));break;
-            case 0x33:/*INC SP*/_T(2);_S_SP(_G_SP()+1);break;
-            case 0x34:/*INC (HL/IX+d/IY+d)*/_ADDR(addr,5);_T(1);_MR(addr,d8);{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_MW(addr,d8);break;
-            case 0x35:/*DEC (HL/IX+d/IY+d)*/_ADDR(addr,5);_T(1);_MR(addr,d8);{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_MW(addr,d8);break;
-            case 0x36:/*LD (HL/IX+d/IY+d),n*/_ADDR(addr,2);_IMM8(d8);_MW(addr,d8);break;
-            case 0x37:/*SCF*/{uint8_t a=_G_A();uint8_t f=_G_F();f=(f&(Z80_SF|Z80_ZF|Z80_PF|Z80_CF))|Z80_CF|(a&(Z80_YF|Z80_XF));_S_F(f);}break;
-            case 0x38:/*JR C,d*/{int8_t d;_IMM8(d);if((_G_F()&Z80_CF)){pc+=d;_S_WZ(pc);_T(5);}}break;
-            case 0x39:/*ADD HL,SP*/{uint16_t acc=_G_HL();_S_WZ(acc+1);d16=_G_SP();uint32_t r=acc+d16;_S_HL(r);uint8_t f=_G_F()&(Z80_SF|Z80_ZF|Z80_VF);f|=((acc^r^d16)>>8)&Z80_HF;f|=((r>>16)&Z80_CF)|((r>>8)&(Z80_YF|Z80_XF));_S_F(f);_T(7);}break;
-            case 0x3a:/*LD A,(nn)*/_IMM16(addr);_MR(addr++,d8);_S_A(d8);_S_WZ(addr);break;
-            case 0x3b:/*DEC SP*/_T(2);_S_SP(_G_SP()-1);break;
-            case 0x3c:/*INC A*/d8=_G_A();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_A(d8);break;
-            case 0x3d:/*DEC A*/d8=_G_A();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_A(d8);break;
-            case 0x3e:/*LD A,n*/_IMM8(d8);_S_A(d8);break;
-            case 0x3f:/*CCF*/{uint8_t a=_G_A();uint8_t f=_G_F();f=((f&(Z80_SF|Z80_ZF|Z80_PF|Z80_CF))|((f&Z80_CF)<<4)|(a&(Z80_YF|Z80_XF)))^Z80_CF;_S_F(f);}break;
-            case 0x40:/*LD B,B*/_S_B(_G_B());break;
-            case 0x41:/*LD B,C*/_S_B(_G_C());break;
-            case 0x42:/*LD B,D*/_S_B(_G_D());break;
-            case 0x43:/*LD B,E*/_S_B(_G_E());break;
-            case 0x44:/*LD B,H*/_S_B(_G_H());break;
-            case 0x45:/*LD B,L*/_S_B(_G_L());break;
-            case 0x46:/*LD B,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_B(d8);break;
-            case 0x47:/*LD B,A*/_S_B(_G_A());break;
-            case 0x48:/*LD C,B*/_S_C(_G_B());break;
-            case 0x49:/*LD C,C*/_S_C(_G_C());break;
-            case 0x4a:/*LD C,D*/_S_C(_G_D());break;
-            case 0x4b:/*LD C,E*/_S_C(_G_E());break;
-            case 0x4c:/*LD C,H*/_S_C(_G_H());break;
-            case 0x4d:/*LD C,L*/_S_C(_G_L());break;
-            case 0x4e:/*LD C,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_C(d8);break;
-            case 0x4f:/*LD C,A*/_S_C(_G_A());break;
-            case 0x50:/*LD D,B*/_S_D(_G_B());break;
-            case 0x51:/*LD D,C*/_S_D(_G_C());break;
-            case 0x52:/*LD D,D*/_S_D(_G_D());break;
-            case 0x53:/*LD D,E*/_S_D(_G_E());break;
-            case 0x54:/*LD D,H*/_S_D(_G_H());break;
-            case 0x55:/*LD D,L*/_S_D(_G_L());break;
-            case 0x56:/*LD D,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_D(d8);break;
-            case 0x57:/*LD D,A*/_S_D(_G_A());break;
-            case 0x58:/*LD E,B*/_S_E(_G_B());break;
-            case 0x59:/*LD E,C*/_S_E(_G_C());break;
-            case 0x5a:/*LD E,D*/_S_E(_G_D());break;
-            case 0x5b:/*LD E,E*/_S_E(_G_E());break;
-            case 0x5c:/*LD E,H*/_S_E(_G_H());break;
-            case 0x5d:/*LD E,L*/_S_E(_G_L());break;
-            case 0x5e:/*LD E,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_E(d8);break;
-            case 0x5f:/*LD E,A*/_S_E(_G_A());break;
-            case 0x60:/*LD H,B*/_S_H(_G_B());break;
-            case 0x61:/*LD H,C*/_S_H(_G_C());break;
-            case 0x62:/*LD H,D*/_S_H(_G_D());break;
-            case 0x63:/*LD H,E*/_S_H(_G_E());break;
-            case 0x64:/*LD H,H*/_S_H(_G_H());break;
-            case 0x65:/*LD H,L*/_S_H(_G_L());break;
-            case 0x66:/*LD H,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);if(_IDX()){_S8(r0,_H,d8);}else{_S_H(d8);}break;
-            case 0x67:/*LD H,A*/_S_H(_G_A());break;
-            case 0x68:/*LD L,B*/_S_L(_G_B());break;
-            case 0x69:/*LD L,C*/_S_L(_G_C());break;
-            case 0x6a:/*LD L,D*/_S_L(_G_D());break;
-            case 0x6b:/*LD L,E*/_S_L(_G_E());break;
-            case 0x6c:/*LD L,H*/_S_L(_G_H());break;
-            case 0x6d:/*LD L,L*/_S_L(_G_L());break;
-            case 0x6e:/*LD L,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);if(_IDX()){_S8(r0,_L,d8);}else{_S_L(d8);}break;
-            case 0x6f:/*LD L,A*/_S_L(_G_A());break;
-            case 0x70:/*LD (HL/IX+d/IY+d),B*/d8=_G_B();_ADDR(addr,5);_MW(addr,d8);break;
-            case 0x71:/*LD (HL/IX+d/IY+d),C*/d8=_G_C();_ADDR(addr,5);_MW(addr,d8);break;
-            case 0x72:/*LD (HL/IX+d/IY+d),D*/d8=_G_D();_ADDR(addr,5);_MW(addr,d8);break;
-            case 0x73:/*LD (HL/IX+d/IY+d),E*/d8=_G_E();_ADDR(addr,5);_MW(addr,d8);break;
-            case 0x74:/*LD (HL/IX+d/IY+d),H*/d8=_IDX()?_G8(r0,_H):_G_H();_ADDR(addr,5);_MW(addr,d8);break;
-            case 0x75:/*LD (HL/IX+d/IY+d),L*/d8=_IDX()?_G8(r0,_L):_G_L();_ADDR(addr,5);_MW(addr,d8);break;
-            case 0x76:/*HALT*/pins|=Z80_HALT;pc--;break;
-            case 0x77:/*LD (HL/IX+d/IY+d),A*/d8=_G_A();_ADDR(addr,5);_MW(addr,d8);break;
-            case 0x78:/*LD A,B*/_S_A(_G_B());break;
-            case 0x79:/*LD A,C*/_S_A(_G_C());break;
-            case 0x7a:/*LD A,D*/_S_A(_G_D());break;
-            case 0x7b:/*LD A,E*/_S_A(_G_E());break;
-            case 0x7c:/*LD A,H*/_S_A(_G_H());break;
-            case 0x7d:/*LD A,L*/_S_A(_G_L());break;
-            case 0x7e:/*LD A,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_A(d8);break;
-            case 0x7f:/*LD A,A*/_S_A(_G_A());break;
-            case 0x80:/*ADD B*/d8=_G_B();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x81:/*ADD C*/d8=_G_C();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x82:/*ADD D*/d8=_G_D();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x83:/*ADD E*/d8=_G_E();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x84:/*ADD H*/d8=_G_H();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x85:/*ADD L*/d8=_G_L();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x86:/*ADD,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x87:/*ADD A*/d8=_G_A();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x88:/*ADC B*/d8=_G_B();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x89:/*ADC C*/d8=_G_C();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x8a:/*ADC D*/d8=_G_D();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x8b:/*ADC E*/d8=_G_E();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x8c:/*ADC H*/d8=_G_H();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x8d:/*ADC L*/d8=_G_L();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x8e:/*ADC,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x8f:/*ADC A*/d8=_G_A();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x90:/*SUB B*/d8=_G_B();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x91:/*SUB C*/d8=_G_C();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x92:/*SUB D*/d8=_G_D();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x93:/*SUB E*/d8=_G_E();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x94:/*SUB H*/d8=_G_H();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x95:/*SUB L*/d8=_G_L();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x96:/*SUB,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x97:/*SUB A*/d8=_G_A();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x98:/*SBC B*/d8=_G_B();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x99:/*SBC C*/d8=_G_C();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x9a:/*SBC D*/d8=_G_D();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x9b:/*SBC E*/d8=_G_E();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x9c:/*SBC H*/d8=_G_H();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x9d:/*SBC L*/d8=_G_L();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x9e:/*SBC,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0x9f:/*SBC A*/d8=_G_A();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0xa0:/*AND B*/d8=_G_B();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xa1:/*AND C*/d8=_G_C();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xa2:/*AND D*/d8=_G_D();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xa3:/*AND E*/d8=_G_E();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xa4:/*AND H*/d8=_G_H();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xa5:/*AND L*/d8=_G_L();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xa6:/*AND,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xa7:/*AND A*/d8=_G_A();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xa8:/*XOR B*/d8=_G_B();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xa9:/*XOR C*/d8=_G_C();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xaa:/*XOR D*/d8=_G_D();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xab:/*XOR E*/d8=_G_E();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xac:/*XOR H*/d8=_G_H();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xad:/*XOR L*/d8=_G_L();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xae:/*XOR,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xaf:/*XOR A*/d8=_G_A();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb0:/*OR B*/d8=_G_B();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb1:/*OR C*/d8=_G_C();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb2:/*OR D*/d8=_G_D();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb3:/*OR E*/d8=_G_E();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb4:/*OR H*/d8=_G_H();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb5:/*OR L*/d8=_G_L();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb6:/*OR,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb7:/*OR A*/d8=_G_A();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xb8:/*CP B*/d8=_G_B();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xb9:/*CP C*/d8=_G_C();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xba:/*CP D*/d8=_G_D();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xbb:/*CP E*/d8=_G_E();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xbc:/*CP H*/d8=_G_H();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xbd:/*CP L*/d8=_G_L();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xbe:/*CP,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xbf:/*CP A*/d8=_G_A();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xc0:/*RET NZ*/_T(1);if (!(_G_F()&Z80_ZF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}break;
-            case 0xc1:/*POP BC*/addr=_G_SP();_MR(addr++,d8);d16=d8;_MR(addr++,d8);d16|=d8<<8;_S_BC(d16);_S_SP(addr);break;
-            case 0xc2:/*JP NZ,nn*/_IMM16(addr);if(!(_G_F()&Z80_ZF)){pc=addr;}break;
-            case 0xc3:/*JP nn*/_IMM16(pc);break;
-            case 0xc4:/*CALL NZ,nn*/_IMM16(addr);if(!(_G_F()&Z80_ZF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}break;
-            case 0xc5:/*PUSH BC*/_T(1);addr=_G_SP();d16=_G_BC();_MW(--addr,d16>>8);_MW(--addr,d16);_S_SP(addr);break;
-            case 0xc6:/*ADD n*/_IMM8(d8);{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0xc7:/*RST 0x0*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x0;_S_WZ(pc);break;
-            case 0xc8:/*RET Z*/_T(1);if ((_G_F()&Z80_ZF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}break;
-            case 0xc9:/*RET*/d16=_G_SP();_MR(d16++,d8);pc=d8;_MR(d16++,d8);pc|=d8<<8;_S_SP(d16);_S_WZ(pc);break;
-            case 0xca:/*JP Z,nn*/_IMM16(addr);if((_G_F()&Z80_ZF)){pc=addr;}break;
-            case 0xCB: {
+        #endif
+            _OP(0x0):/*NOP*/ _NEXT()
+            _OP(0x1):/*LD BC,nn*/_IMM16(d16);_S_BC(d16);_NEXT()
+            _OP(0x2):/*LD (BC),A*/addr=_G_BC();d8=_G_A();_MW(addr++,d8);_S_WZ((d8<<8)|(addr&0x00FF));_NEXT()
+            _OP(0x3):/*INC BC*/_T(2);_S_BC(_G_BC()+1);_NEXT()
+            _OP(0x4):/*INC B*/d8=_G_B();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_B(d8);_NEXT()
+            _OP(0x5):/*DEC B*/d8=_G_B();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_B(d8);_NEXT()
+            _OP(0x6):/*LD B,n*/_IMM8(d8);_S_B(d8);_NEXT()
+            _OP(0x7):/*RLCA*/{uint8_t a=_G_A();uint8_t f=_G_F();uint8_t r=(a<<1)|(a>>7);f=((a>>7)&Z80_CF)|(f&(Z80_SF|Z80_ZF|Z80_PF))|(r&(Z80_YF|Z80_XF));_S_A(r);_S_F(f);}_NEXT()
+            _OP(0x8):/*EX AF,AF'*/{r0=_z80_flush_r0(ws,r0,r2);uint16_t fa=_G16(r0,_FA);uint16_t fa_=_G16(r3,_FA);_S16(r0,_FA,fa_);_S16(r3,_FA,fa);ws=_z80_map_regs(r0,r1,r2);}_NEXT()
+            _OP(0x9):/*ADD HL,BC*/{uint16_t acc=_G_HL();_S_WZ(acc+1);d16=_G_BC();uint32_t r=acc+d16;_S_HL(r);uint8_t f=_G_F()&(Z80_SF|Z80_ZF|Z80_VF);f|=((acc^r^d16)>>8)&Z80_HF;f|=((r>>16)&Z80_CF)|((r>>8)&(Z80_YF|Z80_XF));_S_F(f);_T(7);}_NEXT()
+            _OP(0xa):/*LD A,(BC)*/addr=_G_BC();_MR(addr++,d8);_S_A(d8);_S_WZ(addr);_NEXT()
+            _OP(0xb):/*DEC BC*/_T(2);_S_BC(_G_BC()-1);_NEXT()
+            _OP(0xc):/*INC C*/d8=_G_C();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_C(d8);_NEXT()
+            _OP(0xd):/*DEC C*/d8=_G_C();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_C(d8);_NEXT()
+            _OP(0xe):/*LD C,n*/_IMM8(d8);_S_C(d8);_NEXT()
+            _OP(0xf):/*RRCA*/{uint8_t a=_G_A();uint8_t f=_G_F();uint8_t r=(a>>1)|(a<<7);f=(a&Z80_CF)|(f&(Z80_SF|Z80_ZF|Z80_PF))|(r&(Z80_YF|Z80_XF));_S_A(r);_S_F(f);}_NEXT()
+            _OP(0x10):/*DJNZ*/{_T(1);int8_t d;_IMM8(d);d8=_G_B()-1;_S_B(d8);if(d8>0){pc+=d;_S_WZ(pc);_T(5);}}_NEXT()
+            _OP(0x11):/*LD DE,nn*/_IMM16(d16);_S_DE(d16);_NEXT()
+            _OP(0x12):/*LD (DE),A*/addr=_G_DE();d8=_G_A();_MW(addr++,d8);_S_WZ((d8<<8)|(addr&0x00FF));_NEXT()
+            _OP(0x13):/*INC DE*/_T(2);_S_DE(_G_DE()+1);_NEXT()
+            _OP(0x14):/*INC D*/d8=_G_D();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_D(d8);_NEXT()
+            _OP(0x15):/*DEC D*/d8=_G_D();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_D(d8);_NEXT()
+            _OP(0x16):/*LD D,n*/_IMM8(d8);_S_D(d8);_NEXT()
+            _OP(0x17):/*RLA*/{uint8_t a=_G_A();uint8_t f=_G_F();uint8_t r=(a<<1)|(f&Z80_CF);f=((a>>7)&Z80_CF)|(f&(Z80_SF|Z80_ZF|Z80_PF))|(r&(Z80_YF|Z80_XF));_S_A(r);_S_F(f);}_NEXT()
+            _OP(0x18):/*JR d*/{int8_t d;_IMM8(d);pc+=d;_S_WZ(pc);_T(5);}_NEXT()
+            _OP(0x19):/*ADD HL,DE*/{uint16_t acc=_G_HL();_S_WZ(acc+1);d16=_G_DE();uint32_t r=acc+d16;_S_HL(r);uint8_t f=_G_F()&(Z80_SF|Z80_ZF|Z80_VF);f|=((acc^r^d16)>>8)&Z80_HF;f|=((r>>16)&Z80_CF)|((r>>8)&(Z80_YF|Z80_XF));_S_F(f);_T(7);}_NEXT()
+            _OP(0x1a):/*LD A,(DE)*/addr=_G_DE();_MR(addr++,d8);_S_A(d8);_S_WZ(addr);_NEXT()
+            _OP(0x1b):/*DEC DE*/_T(2);_S_DE(_G_DE()-1);_NEXT()
+            _OP(0x1c):/*INC E*/d8=_G_E();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_E(d8);_NEXT()
+            _OP(0x1d):/*DEC E*/d8=_G_E();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_E(d8);_NEXT()
+            _OP(0x1e):/*LD E,n*/_IMM8(d8);_S_E(d8);_NEXT()
+            _OP(0x1f):/*RRA*/{uint8_t a=_G_A();uint8_t f=_G_F();uint8_t r=(a>>1)|((f&Z80_CF)<<7);f=(a&Z80_CF)|(f&(Z80_SF|Z80_ZF|Z80_PF))|(r&(Z80_YF|Z80_XF));_S_A(r);_S_F(f);}_NEXT()
+            _OP(0x20):/*JR NZ,d*/{int8_t d;_IMM8(d);if(!(_G_F()&Z80_ZF)){pc+=d;_S_WZ(pc);_T(5);}}_NEXT()
+            _OP(0x21):/*LD HL,nn*/_IMM16(d16);_S_HL(d16);_NEXT()
+            _OP(0x22):/*LD (nn),HL*/_IMM16(addr);_MW(addr++,_G_L());_MW(addr,_G_H());_S_WZ(addr);_NEXT()
+            _OP(0x23):/*INC HL*/_T(2);_S_HL(_G_HL()+1);_NEXT()
+            _OP(0x24):/*INC H*/d8=_G_H();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_H(d8);_NEXT()
+            _OP(0x25):/*DEC H*/d8=_G_H();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_H(d8);_NEXT()
+            _OP(0x26):/*LD H,n*/_IMM8(d8);_S_H(d8);_NEXT()
+            _OP(0x27):/*DAA*/ws=_z80_daa(ws);_NEXT()
+            _OP(0x28):/*JR Z,d*/{int8_t d;_IMM8(d);if((_G_F()&Z80_ZF)){pc+=d;_S_WZ(pc);_T(5);}}_NEXT()
+            _OP(0x29):/*ADD HL,HL*/{uint16_t acc=_G_HL();_S_WZ(acc+1);d16=_G_HL();uint32_t r=acc+d16;_S_HL(r);uint8_t f=_G_F()&(Z80_SF|Z80_ZF|Z80_VF);f|=((acc^r^d16)>>8)&Z80_HF;f|=((r>>16)&Z80_CF)|((r>>8)&(Z80_YF|Z80_XF));_S_F(f);_T(7);}_NEXT()
+            _OP(0x2a):/*LD HL,(nn)*/_IMM16(addr);_MR(addr++,d8);_S_L(d8);_MR(addr,d8);_S_H(d8);_S_WZ(addr);_NEXT()
+            _OP(0x2b):/*DEC HL*/_T(2);_S_HL(_G_HL()-1);_NEXT()
+            _OP(0x2c):/*INC L*/d8=_G_L();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_L(d8);_NEXT()
+            _OP(0x2d):/*DEC L*/d8=_G_L();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_L(d8);_NEXT()
+            _OP(0x2e):/*LD L,n*/_IMM8(d8);_S_L(d8);_NEXT()
+            _OP(0x2f):/*CPL*/{uint8_t a=_G_A()^0xFF;_S_A(a);uint8_t f=_G_F();f=(f&(Z80_SF|Z80_ZF|Z80_PF|Z80_CF))|Z80_HF|Z80_NF|(a&(Z80_YF|Z80_XF));_S_F(f);}_NEXT()
+            _OP(0x30):/*JR NC,d*/{int8_t d;_IMM8(d);if(!(_G_F()&Z80_CF)){pc+=d;_S_WZ(pc);_T(5);}}_NEXT()
+            _OP(0x31):/*LD SP,nn*/_IMM16(d16);_S_SP(d16);_NEXT()
+            _OP(0x32):/*LD (nn),A*/_IMM16(addr);d8=_G_A();_MW(addr++,d8);_S_WZ((d8<<8)|(addr&0x00FF));_NEXT()
+            _OP(0x33):/*INC SP*/_T(2);_S_SP(_G_SP()+1);_NEXT()
+            _OP(0x34):/*INC (HL/IX+d/IY+d)*/_ADDR(addr,5);_T(1);_MR(addr,d8);{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_MW(addr,d8);_NEXT()
+            _OP(0x35):/*DEC (HL/IX+d/IY+d)*/_ADDR(addr,5);_T(1);_MR(addr,d8);{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_MW(addr,d8);_NEXT()
+            _OP(0x36):/*LD (HL/IX+d/IY+d),n*/_ADDR(addr,2);_IMM8(d8);_MW(addr,d8);_NEXT()
+            _OP(0x37):/*SCF*/{uint8_t a=_G_A();uint8_t f=_G_F();f=(f&(Z80_SF|Z80_ZF|Z80_PF|Z80_CF))|Z80_CF|(a&(Z80_YF|Z80_XF));_S_F(f);}_NEXT()
+            _OP(0x38):/*JR C,d*/{int8_t d;_IMM8(d);if((_G_F()&Z80_CF)){pc+=d;_S_WZ(pc);_T(5);}}_NEXT()
+            _OP(0x39):/*ADD HL,SP*/{uint16_t acc=_G_HL();_S_WZ(acc+1);d16=_G_SP();uint32_t r=acc+d16;_S_HL(r);uint8_t f=_G_F()&(Z80_SF|Z80_ZF|Z80_VF);f|=((acc^r^d16)>>8)&Z80_HF;f|=((r>>16)&Z80_CF)|((r>>8)&(Z80_YF|Z80_XF));_S_F(f);_T(7);}_NEXT()
+            _OP(0x3a):/*LD A,(nn)*/_IMM16(addr);_MR(addr++,d8);_S_A(d8);_S_WZ(addr);_NEXT()
+            _OP(0x3b):/*DEC SP*/_T(2);_S_SP(_G_SP()-1);_NEXT()
+            _OP(0x3c):/*INC A*/d8=_G_A();{uint8_t r=d8+1;uint8_t f=_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x80){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_A(d8);_NEXT()
+            _OP(0x3d):/*DEC A*/d8=_G_A();{uint8_t r=d8-1;uint8_t f=Z80_NF|_SZ(r)|(r&(Z80_XF|Z80_YF))|((r^d8)&Z80_HF);if(r==0x7F){f|=Z80_VF;}_S_F(f|(_G_F()&Z80_CF));d8=r;}_S_A(d8);_NEXT()
+            _OP(0x3e):/*LD A,n*/_IMM8(d8);_S_A(d8);_NEXT()
+            _OP(0x3f):/*CCF*/{uint8_t a=_G_A();uint8_t f=_G_F();f=((f&(Z80_SF|Z80_ZF|Z80_PF|Z80_CF))|((f&Z80_CF)<<4)|(a&(Z80_YF|Z80_XF)))^Z80_CF;_S_F(f);}_NEXT()
+            _OP(0x40):/*LD B,B*/_S_B(_G_B());_NEXT()
+            _OP(0x41):/*LD B,C*/_S_B(_G_C());_NEXT()
+            _OP(0x42):/*LD B,D*/_S_B(_G_D());_NEXT()
+            _OP(0x43):/*LD B,E*/_S_B(_G_E());_NEXT()
+            _OP(0x44):/*LD B,H*/_S_B(_G_H());_NEXT()
+            _OP(0x45):/*LD B,L*/_S_B(_G_L());_NEXT()
+            _OP(0x46):/*LD B,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_B(d8);_NEXT()
+            _OP(0x47):/*LD B,A*/_S_B(_G_A());_NEXT()
+            _OP(0x48):/*LD C,B*/_S_C(_G_B());_NEXT()
+            _OP(0x49):/*LD C,C*/_S_C(_G_C());_NEXT()
+            _OP(0x4a):/*LD C,D*/_S_C(_G_D());_NEXT()
+            _OP(0x4b):/*LD C,E*/_S_C(_G_E());_NEXT()
+            _OP(0x4c):/*LD C,H*/_S_C(_G_H());_NEXT()
+            _OP(0x4d):/*LD C,L*/_S_C(_G_L());_NEXT()
+            _OP(0x4e):/*LD C,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_C(d8);_NEXT()
+            _OP(0x4f):/*LD C,A*/_S_C(_G_A());_NEXT()
+            _OP(0x50):/*LD D,B*/_S_D(_G_B());_NEXT()
+            _OP(0x51):/*LD D,C*/_S_D(_G_C());_NEXT()
+            _OP(0x52):/*LD D,D*/_S_D(_G_D());_NEXT()
+            _OP(0x53):/*LD D,E*/_S_D(_G_E());_NEXT()
+            _OP(0x54):/*LD D,H*/_S_D(_G_H());_NEXT()
+            _OP(0x55):/*LD D,L*/_S_D(_G_L());_NEXT()
+            _OP(0x56):/*LD D,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_D(d8);_NEXT()
+            _OP(0x57):/*LD D,A*/_S_D(_G_A());_NEXT()
+            _OP(0x58):/*LD E,B*/_S_E(_G_B());_NEXT()
+            _OP(0x59):/*LD E,C*/_S_E(_G_C());_NEXT()
+            _OP(0x5a):/*LD E,D*/_S_E(_G_D());_NEXT()
+            _OP(0x5b):/*LD E,E*/_S_E(_G_E());_NEXT()
+            _OP(0x5c):/*LD E,H*/_S_E(_G_H());_NEXT()
+            _OP(0x5d):/*LD E,L*/_S_E(_G_L());_NEXT()
+            _OP(0x5e):/*LD E,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_E(d8);_NEXT()
+            _OP(0x5f):/*LD E,A*/_S_E(_G_A());_NEXT()
+            _OP(0x60):/*LD H,B*/_S_H(_G_B());_NEXT()
+            _OP(0x61):/*LD H,C*/_S_H(_G_C());_NEXT()
+            _OP(0x62):/*LD H,D*/_S_H(_G_D());_NEXT()
+            _OP(0x63):/*LD H,E*/_S_H(_G_E());_NEXT()
+            _OP(0x64):/*LD H,H*/_S_H(_G_H());_NEXT()
+            _OP(0x65):/*LD H,L*/_S_H(_G_L());_NEXT()
+            _OP(0x66):/*LD H,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);if(_IDX()){_S8(r0,_H,d8);}else{_S_H(d8);}_NEXT()
+            _OP(0x67):/*LD H,A*/_S_H(_G_A());_NEXT()
+            _OP(0x68):/*LD L,B*/_S_L(_G_B());_NEXT()
+            _OP(0x69):/*LD L,C*/_S_L(_G_C());_NEXT()
+            _OP(0x6a):/*LD L,D*/_S_L(_G_D());_NEXT()
+            _OP(0x6b):/*LD L,E*/_S_L(_G_E());_NEXT()
+            _OP(0x6c):/*LD L,H*/_S_L(_G_H());_NEXT()
+            _OP(0x6d):/*LD L,L*/_S_L(_G_L());_NEXT()
+            _OP(0x6e):/*LD L,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);if(_IDX()){_S8(r0,_L,d8);}else{_S_L(d8);}_NEXT()
+            _OP(0x6f):/*LD L,A*/_S_L(_G_A());_NEXT()
+            _OP(0x70):/*LD (HL/IX+d/IY+d),B*/d8=_G_B();_ADDR(addr,5);_MW(addr,d8);_NEXT()
+            _OP(0x71):/*LD (HL/IX+d/IY+d),C*/d8=_G_C();_ADDR(addr,5);_MW(addr,d8);_NEXT()
+            _OP(0x72):/*LD (HL/IX+d/IY+d),D*/d8=_G_D();_ADDR(addr,5);_MW(addr,d8);_NEXT()
+            _OP(0x73):/*LD (HL/IX+d/IY+d),E*/d8=_G_E();_ADDR(addr,5);_MW(addr,d8);_NEXT()
+            _OP(0x74):/*LD (HL/IX+d/IY+d),H*/d8=_IDX()?_G8(r0,_H):_G_H();_ADDR(addr,5);_MW(addr,d8);_NEXT()
+            _OP(0x75):/*LD (HL/IX+d/IY+d),L*/d8=_IDX()?_G8(r0,_L):_G_L();_ADDR(addr,5);_MW(addr,d8);_NEXT()
+            _OP(0x76):/*HALT*/pins|=Z80_HALT;pc--;_NEXT()
+            _OP(0x77):/*LD (HL/IX+d/IY+d),A*/d8=_G_A();_ADDR(addr,5);_MW(addr,d8);_NEXT()
+            _OP(0x78):/*LD A,B*/_S_A(_G_B());_NEXT()
+            _OP(0x79):/*LD A,C*/_S_A(_G_C());_NEXT()
+            _OP(0x7a):/*LD A,D*/_S_A(_G_D());_NEXT()
+            _OP(0x7b):/*LD A,E*/_S_A(_G_E());_NEXT()
+            _OP(0x7c):/*LD A,H*/_S_A(_G_H());_NEXT()
+            _OP(0x7d):/*LD A,L*/_S_A(_G_L());_NEXT()
+            _OP(0x7e):/*LD A,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);_S_A(d8);_NEXT()
+            _OP(0x7f):/*LD A,A*/_S_A(_G_A());_NEXT()
+            _OP(0x80):/*ADD B*/d8=_G_B();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x81):/*ADD C*/d8=_G_C();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x82):/*ADD D*/d8=_G_D();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x83):/*ADD E*/d8=_G_E();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x84):/*ADD H*/d8=_G_H();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x85):/*ADD L*/d8=_G_L();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x86):/*ADD,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x87):/*ADD A*/d8=_G_A();{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x88):/*ADC B*/d8=_G_B();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x89):/*ADC C*/d8=_G_C();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x8a):/*ADC D*/d8=_G_D();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x8b):/*ADC E*/d8=_G_E();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x8c):/*ADC H*/d8=_G_H();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x8d):/*ADC L*/d8=_G_L();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x8e):/*ADC,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x8f):/*ADC A*/d8=_G_A();{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x90):/*SUB B*/d8=_G_B();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x91):/*SUB C*/d8=_G_C();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x92):/*SUB D*/d8=_G_D();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x93):/*SUB E*/d8=_G_E();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x94):/*SUB H*/d8=_G_H();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x95):/*SUB L*/d8=_G_L();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x96):/*SUB,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x97):/*SUB A*/d8=_G_A();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x98):/*SBC B*/d8=_G_B();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x99):/*SBC C*/d8=_G_C();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x9a):/*SBC D*/d8=_G_D();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x9b):/*SBC E*/d8=_G_E();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x9c):/*SBC H*/d8=_G_H();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x9d):/*SBC L*/d8=_G_L();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x9e):/*SBC,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0x9f):/*SBC A*/d8=_G_A();{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0xa0):/*AND B*/d8=_G_B();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xa1):/*AND C*/d8=_G_C();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xa2):/*AND D*/d8=_G_D();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xa3):/*AND E*/d8=_G_E();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xa4):/*AND H*/d8=_G_H();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xa5):/*AND L*/d8=_G_L();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xa6):/*AND,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xa7):/*AND A*/d8=_G_A();{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xa8):/*XOR B*/d8=_G_B();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xa9):/*XOR C*/d8=_G_C();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xaa):/*XOR D*/d8=_G_D();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xab):/*XOR E*/d8=_G_E();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xac):/*XOR H*/d8=_G_H();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xad):/*XOR L*/d8=_G_L();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xae):/*XOR,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xaf):/*XOR A*/d8=_G_A();{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb0):/*OR B*/d8=_G_B();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb1):/*OR C*/d8=_G_C();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb2):/*OR D*/d8=_G_D();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb3):/*OR E*/d8=_G_E();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb4):/*OR H*/d8=_G_H();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb5):/*OR L*/d8=_G_L();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb6):/*OR,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb7):/*OR A*/d8=_G_A();{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xb8):/*CP B*/d8=_G_B();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xb9):/*CP C*/d8=_G_C();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xba):/*CP D*/d8=_G_D();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xbb):/*CP E*/d8=_G_E();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xbc):/*CP H*/d8=_G_H();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xbd):/*CP L*/d8=_G_L();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xbe):/*CP,(HL/IX+d/IY+d)*/_ADDR(addr,5);_MR(addr,d8);{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xbf):/*CP A*/d8=_G_A();{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xc0):/*RET NZ*/_T(1);if (!(_G_F()&Z80_ZF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}_NEXT()
+            _OP(0xc1):/*POP BC*/addr=_G_SP();_MR(addr++,d8);d16=d8;_MR(addr++,d8);d16|=d8<<8;_S_BC(d16);_S_SP(addr);_NEXT()
+            _OP(0xc2):/*JP NZ,nn*/_IMM16(addr);if(!(_G_F()&Z80_ZF)){pc=addr;}_NEXT()
+            _OP(0xc3):/*JP nn*/_IMM16(pc);_NEXT()
+            _OP(0xc4):/*CALL NZ,nn*/_IMM16(addr);if(!(_G_F()&Z80_ZF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}_NEXT()
+            _OP(0xc5):/*PUSH BC*/_T(1);addr=_G_SP();d16=_G_BC();_MW(--addr,d16>>8);_MW(--addr,d16);_S_SP(addr);_NEXT()
+            _OP(0xc6):/*ADD n*/_IMM8(d8);{uint8_t acc=_G_A();uint32_t res=acc+d8;_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0xc7):/*RST 0x0*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x0;_S_WZ(pc);_NEXT()
+            _OP(0xc8):/*RET Z*/_T(1);if ((_G_F()&Z80_ZF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}_NEXT()
+            _OP(0xc9):/*RET*/d16=_G_SP();_MR(d16++,d8);pc=d8;_MR(d16++,d8);pc|=d8<<8;_S_SP(d16);_S_WZ(pc);_NEXT()
+            _OP(0xca):/*JP Z,nn*/_IMM16(addr);if((_G_F()&Z80_ZF)){pc=addr;}_NEXT()
+            _OP(0xcb): {
                 /* special handling for undocumented DD/FD+CB double prefix instructions,
                  these always load the value from memory (IX+d),
                  and write the value back, even for normal
@@ -1154,41 +1249,41 @@ uint32_t z80_exec(z80_t* cpu, uint32_t num_ticks) {
                 }
                 _S_F(f);
             }
-            break;
-            case 0xcc:/*CALL Z,nn*/_IMM16(addr);if((_G_F()&Z80_ZF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}break;
-            case 0xcd:/*CALL nn*/_IMM16(addr);_T(1);d16=_G_SP();_MW(--d16,pc>>8);_MW(--d16,pc);_S_SP(d16);pc=addr;break;
-            case 0xce:/*ADC n*/_IMM8(d8);{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0xcf:/*RST 0x8*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x8;_S_WZ(pc);break;
-            case 0xd0:/*RET NC*/_T(1);if (!(_G_F()&Z80_CF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}break;
-            case 0xd1:/*POP DE*/addr=_G_SP();_MR(addr++,d8);d16=d8;_MR(addr++,d8);d16|=d8<<8;_S_DE(d16);_S_SP(addr);break;
-            case 0xd2:/*JP NC,nn*/_IMM16(addr);if(!(_G_F()&Z80_CF)){pc=addr;}break;
-            case 0xd3:/*OUT (n),A*/{_IMM8(d8);uint8_t a=_G_A();addr=(a<<8)|d8;_OUT(addr,a);_S_WZ((addr&0xFF00)|((addr+1)&0x00FF));}break;
-            case 0xd4:/*CALL NC,nn*/_IMM16(addr);if(!(_G_F()&Z80_CF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}break;
-            case 0xd5:/*PUSH DE*/_T(1);addr=_G_SP();d16=_G_DE();_MW(--addr,d16>>8);_MW(--addr,d16);_S_SP(addr);break;
-            case 0xd6:/*SUB n*/_IMM8(d8);{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0xd7:/*RST 0x10*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x10;_S_WZ(pc);break;
-            case 0xd8:/*RET C*/_T(1);if ((_G_F()&Z80_CF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}break;
-            case 0xd9:/*EXX*/{r0=_z80_flush_r0(ws,r0,r2);const uint64_t rx=r3;r3=(r3&0xffff)|(r0&0xffffffffffff0000);r0=(r0&0xffff)|(rx&0xffffffffffff0000);ws=_z80_map_regs(r0, r1, r2);}break;
-            case 0xda:/*JP C,nn*/_IMM16(addr);if((_G_F()&Z80_CF)){pc=addr;}break;
-            case 0xdb:/*IN A,(n)*/{_IMM8(d8);uint8_t a=_G_A();addr=(a<<8)|d8;_IN(addr++,a);_S_A(a);_S_WZ(addr);}break;
-            case 0xdc:/*CALL C,nn*/_IMM16(addr);if((_G_F()&Z80_CF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}break;
-            case 0xdd:/*DD prefix*/map_bits|=_BIT_USE_IX;continue;break;
-            case 0xde:/*SBC n*/_IMM8(d8);{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}break;
-            case 0xdf:/*RST 0x18*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x18;_S_WZ(pc);break;
-            case 0xe0:/*RET PO*/_T(1);if (!(_G_F()&Z80_PF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}break;
-            case 0xe1:/*POP HL*/addr=_G_SP();_MR(addr++,d8);d16=d8;_MR(addr++,d8);d16|=d8<<8;_S_HL(d16);_S_SP(addr);break;
-            case 0xe2:/*JP PO,nn*/_IMM16(addr);if(!(_G_F()&Z80_PF)){pc=addr;}break;
-            case 0xe3:/*EX (SP),HL*/{_T(3);addr=_G_SP();d16=_G_HL();uint8_t l,h;_MR(addr,l);_MR(addr+1,h);_MW(addr,d16);_MW(addr+1,d16>>8);d16=(h<<8)|l;_S_HL(d16);_S_WZ(d16);}break;
-            case 0xe4:/*CALL PO,nn*/_IMM16(addr);if(!(_G_F()&Z80_PF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}break;
-            case 0xe5:/*PUSH HL*/_T(1);addr=_G_SP();d16=_G_HL();_MW(--addr,d16>>8);_MW(--addr,d16);_S_SP(addr);break;
-            case 0xe6:/*AND n*/_IMM8(d8);{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}break;
-            case 0xe7:/*RST 0x20*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x20;_S_WZ(pc);break;
-            case 0xe8:/*RET PE*/_T(1);if ((_G_F()&Z80_PF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}break;
-            case 0xe9:/*JP HL*/pc=_G_HL();break;
-            case 0xea:/*JP PE,nn*/_IMM16(addr);if((_G_F()&Z80_PF)){pc=addr;}break;
-            case 0xeb:/*EX DE,HL*/{r0=_z80_flush_r0(ws,r0,r2);uint16_t de=_G16(r0,_DE);uint16_t hl=_G16(r0,_HL);_S16(r0,_DE,hl);_S16(r0,_HL,de);ws=_z80_map_regs(r0,r1,r2);}break;
-            case 0xec:/*CALL PE,nn*/_IMM16(addr);if((_G_F()&Z80_PF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}break;
-            case 0xED: {
+            _NEXT()
+            _OP(0xcc):/*CALL Z,nn*/_IMM16(addr);if((_G_F()&Z80_ZF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}_NEXT()
+            _OP(0xcd):/*CALL nn*/_IMM16(addr);_T(1);d16=_G_SP();_MW(--d16,pc>>8);_MW(--d16,pc);_S_SP(d16);pc=addr;_NEXT()
+            _OP(0xce):/*ADC n*/_IMM8(d8);{uint8_t acc=_G_A();uint32_t res=acc+d8+(_G_F()&Z80_CF);_S_F(_ADD_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0xcf):/*RST 0x8*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x8;_S_WZ(pc);_NEXT()
+            _OP(0xd0):/*RET NC*/_T(1);if (!(_G_F()&Z80_CF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}_NEXT()
+            _OP(0xd1):/*POP DE*/addr=_G_SP();_MR(addr++,d8);d16=d8;_MR(addr++,d8);d16|=d8<<8;_S_DE(d16);_S_SP(addr);_NEXT()
+            _OP(0xd2):/*JP NC,nn*/_IMM16(addr);if(!(_G_F()&Z80_CF)){pc=addr;}_NEXT()
+            _OP(0xd3):/*OUT (n),A*/{_IMM8(d8);uint8_t a=_G_A();addr=(a<<8)|d8;_OUT(addr,a);_S_WZ((addr&0xFF00)|((addr+1)&0x00FF));}_NEXT()
+            _OP(0xd4):/*CALL NC,nn*/_IMM16(addr);if(!(_G_F()&Z80_CF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}_NEXT()
+            _OP(0xd5):/*PUSH DE*/_T(1);addr=_G_SP();d16=_G_DE();_MW(--addr,d16>>8);_MW(--addr,d16);_S_SP(addr);_NEXT()
+            _OP(0xd6):/*SUB n*/_IMM8(d8);{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0xd7):/*RST 0x10*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x10;_S_WZ(pc);_NEXT()
+            _OP(0xd8):/*RET C*/_T(1);if ((_G_F()&Z80_CF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}_NEXT()
+            _OP(0xd9):/*EXX*/{r0=_z80_flush_r0(ws,r0,r2);const uint64_t rx=r3;r3=(r3&0xffff)|(r0&0xffffffffffff0000);r0=(r0&0xffff)|(rx&0xffffffffffff0000);ws=_z80_map_regs(r0, r1, r2);}_NEXT()
+            _OP(0xda):/*JP C,nn*/_IMM16(addr);if((_G_F()&Z80_CF)){pc=addr;}_NEXT()
+            _OP(0xdb):/*IN A,(n)*/{_IMM8(d8);uint8_t a=_G_A();addr=(a<<8)|d8;_IN(addr++,a);_S_A(a);_S_WZ(addr);}_NEXT()
+            _OP(0xdc):/*CALL C,nn*/_IMM16(addr);if((_G_F()&Z80_CF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}_NEXT()
+            _OP(0xdd):/*DD prefix*/map_bits|=_BIT_USE_IX;continue;_NEXT()
+            _OP(0xde):/*SBC n*/_IMM8(d8);{uint8_t acc=_G_A();uint32_t res=(uint32_t)((int)acc-(int)d8-(_G_F()&Z80_CF));_S_F(_SUB_FLAGS(acc,d8,res));_S_A(res);}_NEXT()
+            _OP(0xdf):/*RST 0x18*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x18;_S_WZ(pc);_NEXT()
+            _OP(0xe0):/*RET PO*/_T(1);if (!(_G_F()&Z80_PF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}_NEXT()
+            _OP(0xe1):/*POP HL*/addr=_G_SP();_MR(addr++,d8);d16=d8;_MR(addr++,d8);d16|=d8<<8;_S_HL(d16);_S_SP(addr);_NEXT()
+            _OP(0xe2):/*JP PO,nn*/_IMM16(addr);if(!(_G_F()&Z80_PF)){pc=addr;}_NEXT()
+            _OP(0xe3):/*EX (SP),HL*/{_T(3);addr=_G_SP();d16=_G_HL();uint8_t l,h;_MR(addr,l);_MR(addr+1,h);_MW(addr,d16);_MW(addr+1,d16>>8);d16=(h<<8)|l;_S_HL(d16);_S_WZ(d16);}_NEXT()
+            _OP(0xe4):/*CALL PO,nn*/_IMM16(addr);if(!(_G_F()&Z80_PF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}_NEXT()
+            _OP(0xe5):/*PUSH HL*/_T(1);addr=_G_SP();d16=_G_HL();_MW(--addr,d16>>8);_MW(--addr,d16);_S_SP(addr);_NEXT()
+            _OP(0xe6):/*AND n*/_IMM8(d8);{d8&=_G_A();_S_F(_z80_szp[d8]|Z80_HF);_S_A(d8);}_NEXT()
+            _OP(0xe7):/*RST 0x20*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x20;_S_WZ(pc);_NEXT()
+            _OP(0xe8):/*RET PE*/_T(1);if ((_G_F()&Z80_PF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}_NEXT()
+            _OP(0xe9):/*JP HL*/pc=_G_HL();_NEXT()
+            _OP(0xea):/*JP PE,nn*/_IMM16(addr);if((_G_F()&Z80_PF)){pc=addr;}_NEXT()
+            _OP(0xeb):/*EX DE,HL*/{r0=_z80_flush_r0(ws,r0,r2);uint16_t de=_G16(r0,_DE);uint16_t hl=_G16(r0,_HL);_S16(r0,_DE,hl);_S16(r0,_HL,de);ws=_z80_map_regs(r0,r1,r2);}_NEXT()
+            _OP(0xec):/*CALL PE,nn*/_IMM16(addr);if((_G_F()&Z80_PF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}_NEXT()
+            _OP(0xed): {
                 _FETCH(op);
                 switch(op) {
                     case 0x40:/*IN B,(C)*/{addr=_G_BC();_IN(addr++,d8);_S_WZ(addr);uint8_t f=(_G_F()&Z80_CF)|_z80_szp[d8];_S8(ws,_F,f);_S_B(d8);}break;
@@ -1274,27 +1369,30 @@ uint32_t z80_exec(z80_t* cpu, uint32_t num_ticks) {
                     default: break;
                 }
             }
-            break;
-            case 0xee:/*XOR n*/_IMM8(d8);{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xef:/*RST 0x28*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x28;_S_WZ(pc);break;
-            case 0xf0:/*RET P*/_T(1);if (!(_G_F()&Z80_SF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}break;
-            case 0xf1:/*POP FA*/addr=_G_SP();_MR(addr++,d8);d16=d8<<8;_MR(addr++,d8);d16|=d8;_S_FA(d16);_S_SP(addr);break;
-            case 0xf2:/*JP P,nn*/_IMM16(addr);if(!(_G_F()&Z80_SF)){pc=addr;}break;
-            case 0xf3:/*DI*/r2&=~(_BIT_IFF1|_BIT_IFF2);break;
-            case 0xf4:/*CALL P,nn*/_IMM16(addr);if(!(_G_F()&Z80_SF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}break;
-            case 0xf5:/*PUSH FA*/_T(1);addr=_G_SP();d16=_G_FA();_MW(--addr,d16);_MW(--addr,d16>>8);_S_SP(addr);break;
-            case 0xf6:/*OR n*/_IMM8(d8);{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}break;
-            case 0xf7:/*RST 0x30*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x30;_S_WZ(pc);break;
-            case 0xf8:/*RET M*/_T(1);if ((_G_F()&Z80_SF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}break;
-            case 0xf9:/*LD SP,HL*/_T(2);_S_SP(_G_HL());break;
-            case 0xfa:/*JP M,nn*/_IMM16(addr);if((_G_F()&Z80_SF)){pc=addr;}break;
-            case 0xfb:/*EI*/r2=(r2&~(_BIT_IFF1|_BIT_IFF2))|_BIT_EI;break;
-            case 0xfc:/*CALL M,nn*/_IMM16(addr);if((_G_F()&Z80_SF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}break;
-            case 0xfd:/*FD prefix*/map_bits|=_BIT_USE_IY;continue;break;
-            case 0xfe:/*CP n*/_IMM8(d8);{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}break;
-            case 0xff:/*RST 0x38*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x38;_S_WZ(pc);break;
+            _NEXT()
+            _OP(0xee):/*XOR n*/_IMM8(d8);{d8^=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xef):/*RST 0x28*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x28;_S_WZ(pc);_NEXT()
+            _OP(0xf0):/*RET P*/_T(1);if (!(_G_F()&Z80_SF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}_NEXT()
+            _OP(0xf1):/*POP FA*/addr=_G_SP();_MR(addr++,d8);d16=d8<<8;_MR(addr++,d8);d16|=d8;_S_FA(d16);_S_SP(addr);_NEXT()
+            _OP(0xf2):/*JP P,nn*/_IMM16(addr);if(!(_G_F()&Z80_SF)){pc=addr;}_NEXT()
+            _OP(0xf3):/*DI*/r2&=~(_BIT_IFF1|_BIT_IFF2);_NEXT()
+            _OP(0xf4):/*CALL P,nn*/_IMM16(addr);if(!(_G_F()&Z80_SF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}_NEXT()
+            _OP(0xf5):/*PUSH FA*/_T(1);addr=_G_SP();d16=_G_FA();_MW(--addr,d16);_MW(--addr,d16>>8);_S_SP(addr);_NEXT()
+            _OP(0xf6):/*OR n*/_IMM8(d8);{d8|=_G_A();_S_F(_z80_szp[d8]);_S_A(d8);}_NEXT()
+            _OP(0xf7):/*RST 0x30*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x30;_S_WZ(pc);_NEXT()
+            _OP(0xf8):/*RET M*/_T(1);if ((_G_F()&Z80_SF)){uint8_t w,z;d16=_G_SP();_MR(d16++,z);_MR(d16++,w);_S_SP(d16);pc=(w<<8)|z;_S_WZ(pc);}_NEXT()
+            _OP(0xf9):/*LD SP,HL*/_T(2);_S_SP(_G_HL());_NEXT()
+            _OP(0xfa):/*JP M,nn*/_IMM16(addr);if((_G_F()&Z80_SF)){pc=addr;}_NEXT()
+            _OP(0xfb):/*EI*/r2=(r2&~(_BIT_IFF1|_BIT_IFF2))|_BIT_EI;_NEXT()
+            _OP(0xfc):/*CALL M,nn*/_IMM16(addr);if((_G_F()&Z80_SF)){_T(1);uint16_t sp=_G_SP();_MW(--sp,pc>>8);_MW(--sp,pc);_S_SP(sp);pc=addr;}_NEXT()
+            _OP(0xfd):/*FD prefix*/map_bits|=_BIT_USE_IY;continue;_NEXT()
+            _OP(0xfe):/*CP n*/_IMM8(d8);{uint8_t acc=_G_A();int32_t res=(uint32_t)((int)acc-(int)d8);_S_F(_CP_FLAGS(acc,d8,res));}_NEXT()
+            _OP(0xff):/*RST 0x38*/_T(1);d16= _G_SP();_MW(--d16, pc>>8);_MW(--d16, pc);_S_SP(d16);pc=0x38;_S_WZ(pc);_NEXT()
 
         }
+        #if defined(_Z80_COMPUTED_GOTO)
+        _z80_op_end:;
+        #endif
         /* check for interrupt request */
         bool nmi = 0 != ((pins & (pre_pins ^ pins)) & Z80_NMI);
         bool irq = (pins & Z80_INT) && (r2 & _BIT_IFF1);
@@ -1463,6 +1561,10 @@ uint32_t z80_exec(z80_t* cpu, uint32_t num_ticks) {
 #undef _ADDR
 #undef _BUMPR
 #undef _FETCH
+#undef _OP
+#undef _UNMAP
+#undef _NEXT
+#undef _Z80_COMPUTED_GOTO
 #undef _FETCH_CB
 #undef _SZ
 #undef _SZYXCH
@@ -1510,4 +1612,19 @@ uint32_t z80_exec(z80_t* cpu, uint32_t num_ticks) {
 #undef _G_IR 
 #undef _G_PC 
 
+static const chips_state_field_t _z80_state_fields[] = {
+    CHIPS_FIELD_U64(z80_t, bc_de_hl_fa),
+    CHIPS_FIELD_U64(z80_t, bc_de_hl_fa_),
+    CHIPS_FIELD_U64(z80_t, wz_ix_iy_sp),
+    CHIPS_FIELD_U64(z80_t, im_ir_pc_bits),
+    CHIPS_FIELD_U64(z80_t, pins),
+    CHIPS_FIELD_INT(z80_t, trap_id),
+};
+
+static const chips_state_desc_t _z80_state_desc = CHIPS_STATE_DESC("z80", z80_t, _z80_state_fields);
+
+const chips_state_desc_t* z80_state_desc(void) {
+    return &_z80_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
@@ -18,6 +18,10 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    You need to include the following headers before including z80ctc.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins:
 
     ***************************************
@@ -95,11 +99,57 @@
         - **ZCTO0..ZCTO2**: set when the channels 0..2 are in counter
           mode and the countdown reaches 0
 
+    ~~~C
+    int z80ctc_ticks_to_event(const z80ctc_t* ctc)
+    ~~~
+        Returns the number of ticks until the next timer-mode channel
+        reaches zero (which sets a ZCTO pin and possibly requests an
+        interrupt). Counter-mode channels and timers waiting for a
+        trigger are only driven by CLKTRG edges and are ignored. If no
+        channel is currently timing, Z80CTC_NO_EVENT is returned.
+
+    ~~~C
+    uint64_t z80ctc_tick_n(z80ctc_t* ctc, int num_ticks, uint64_t pins)
+    ~~~
+        Perform num_ticks ticks on the CTC at once, this has the same
+        effect as calling z80ctc_tick() num_ticks times with the same
+        input pin mask, but the timer channels are advanced in one step
+        instead of per tick. The CLKTRG pins are checked for edges once
+        at the start of the tick range, so the tick range must not span
+        CLKTRG changes or CTC register writes (those must be handled
+        by splitting the range, e.g. one range per CPU machine cycle).
+
+        The ZCTO pins in the returned pin mask are set if a timer-mode
+        channel reached zero on the *last* tick of the range, or a
+        counter-mode channel reached zero through a CLKTRG edge. Zero
+        crossings in the middle of the range still reload the counter
+        and request interrupts, but don't show up in the pin mask. If
+        the ZCTO pins are needed, use z80ctc_ticks_to_event() to split
+        the tick range at the next zero crossing:
+
+        ~~~C
+        while (num_ticks > 0) {
+            int n = z80ctc_ticks_to_event(&ctc);
+            if (n > num_ticks) {
+                n = num_ticks;
+            }
+            pins = z80ctc_tick_n(&ctc, n, pins);
+            if (pins & Z80CTC_ZCTO0) {
+                ...
+            }
+            num_ticks -= n;
+        }
+        ~~~
+
     ~~~C
     uint64_t z80ctc_int(z80ctc_t* ctc, uint64_t pins)
     ~~~
         Handle the daisychain interrupt protocol. See the z80.h
-        header for details.
+        header for details. The function returns immediately if no
+        channel has a pending or in-service interrupt (tracked in
+        the z80ctc_t.int_active bitmask, which can also be used with
+        the Z80_DAISYCHAIN_BEGIN_IF() macro to skip the entire daisy
+        chain).
 
     ## Macros
 
@@ -213,11 +263,15 @@ typedef struct {
 
 #define Z80CTC_NUM_CHANNELS (4)
 
+/* returned by z80ctc_ticks_to_event() if no channel is timing */
+#define Z80CTC_NO_EVENT (0x7FFFFFFF)
+
 /*
     Z80 CTC state 
 */
 typedef struct {
     z80ctc_channel_t chn[Z80CTC_NUM_CHANNELS];
+    uint8_t int_active;     /* bit n is set while channel n has a pending or in-service interrupt */
     uint64_t pins;
 } z80ctc_t;
 
@@ -244,6 +298,7 @@ static inline uint64_t _z80ctc_counter_zero(z80ctc_t* ctc, z80ctc_channel_t* chn
     if (chn->control & Z80CTC_CTRL_EI) {
         /* interrupt enabled, request an interrupt */
         chn->int_state |= Z80CTC_INT_NEEDED;
+        ctc->int_active |= (1<<chn_id);
     }
     /* last channel doesn't have a ZCTO pin */
     if (chn_id < 3) {
@@ -312,8 +367,103 @@ static inline uint64_t z80ctc_tick(z80ctc_t* ctc, uint64_t pins) {
     return pins;
 }
 
+/*
+    Internal inline function!
+
+    returns true if the channel is counting down in timer mode
+*/
+static inline bool _z80ctc_timer_running(const z80ctc_channel_t* chn) {
+    return !chn->waiting_for_trigger &&
+           ((chn->control & (Z80CTC_CTRL_MODE|Z80CTC_CTRL_RESET|Z80CTC_CTRL_CONST_FOLLOWS)) == Z80CTC_CTRL_MODE_TIMER);
+}
+
+/*
+    Internal inline function!
+
+    returns the number of ticks until a timer-mode channel reaches zero,
+    a prescaler or down counter value of 0 means a full wraparound
+*/
+static inline int _z80ctc_timer_ticks_to_zero(const z80ctc_channel_t* chn) {
+    const int period = chn->prescaler_mask + 1;
+    const int pre = chn->prescaler & chn->prescaler_mask;
+    const int first = pre ? pre : period;
+    const int cnt = chn->down_counter ? chn->down_counter : 256;
+    return first + (cnt - 1) * period;
+}
+
+/* number of ticks until the next timer zero crossing, or Z80CTC_NO_EVENT */
+static inline int z80ctc_ticks_to_event(const z80ctc_t* ctc) {
+    int ticks = Z80CTC_NO_EVENT;
+    for (int chn_id = 0; chn_id < Z80CTC_NUM_CHANNELS; chn_id++) {
+        const z80ctc_channel_t* chn = &ctc->chn[chn_id];
+        if (_z80ctc_timer_running(chn)) {
+            const int t = _z80ctc_timer_ticks_to_zero(chn);
+            if (t < ticks) {
+                ticks = t;
+            }
+        }
+    }
+    return ticks;
+}
+
+/* perform num_ticks ticks on the CTC, timers are advanced in one step */
+static inline uint64_t z80ctc_tick_n(z80ctc_t* ctc, int num_ticks, uint64_t pins) {
+    pins &= ~(Z80CTC_ZCTO0|Z80CTC_ZCTO1|Z80CTC_ZCTO2);
+    if (num_ticks <= 0) {
+        return pins;
+    }
+    for (int chn_id = 0; chn_id < Z80CTC_NUM_CHANNELS; chn_id++) {
+        z80ctc_channel_t* chn = &ctc->chn[chn_id];
+
+        /* external triggers are only checked once for the whole tick range */
+        if (chn->waiting_for_trigger || (chn->control & Z80CTC_CTRL_MODE) == Z80CTC_CTRL_MODE_COUNTER) {
+            bool trg = 0 != (pins & (Z80CTC_CLKTRG0<<chn_id));
+            if (trg != chn->ext_trigger) {
+                chn->ext_trigger = trg;
+                if (chn->trigger_edge == trg) {
+                    pins = _z80ctc_active_edge(ctc, chn, pins, chn_id);
+                }
+            }
+        }
+        else if ((chn->control & (Z80CTC_CTRL_MODE|Z80CTC_CTRL_RESET|Z80CTC_CTRL_CONST_FOLLOWS)) == Z80CTC_CTRL_MODE_TIMER) {
+            const int ticks_to_zero = _z80ctc_timer_ticks_to_zero(chn);
+            const int period = chn->prescaler_mask + 1;
+            const int pre = chn->prescaler & chn->prescaler_mask;
+            const int first = pre ? pre : period;
+            /* number of down counter decrements in the tick range */
+            int num_dec = (num_ticks >= first) ? (1 + (num_ticks - first) / period) : 0;
+            chn->prescaler -= (uint8_t)num_ticks;
+            if (num_ticks < ticks_to_zero) {
+                chn->down_counter -= (uint8_t)num_dec;
+            }
+            else {
+                /* at least one zero crossing, handle the first like a regular tick,
+                   and compute the down counter state after any further reloads
+                */
+                const int cnt = chn->down_counter ? chn->down_counter : 256;
+                const int reload = chn->constant ? chn->constant : 256;
+                num_dec -= cnt;
+                const bool zero_on_last_tick = 0 == ((num_ticks - ticks_to_zero) % (reload * period));
+                uint64_t zero_pins = _z80ctc_counter_zero(ctc, chn, pins, chn_id);
+                chn->down_counter = (uint8_t)(reload - (num_dec % reload));
+                if (zero_on_last_tick) {
+                    pins = zero_pins;
+                }
+                else if (chn_id < 3) {
+                    ctc->pins = pins;
+                }
+            }
+        }
+    }
+    return pins;
+}
+
 /* call this once per machine cycle to handle the interrupt daisy chain */
 static inline uint64_t z80ctc_int(z80ctc_t* ctc, uint64_t pins) {
+    /* early out if no channel has any interrupt activity */
+    if (0 == ctc->int_active) {
+        return pins;
+    }
     for (int i = 0; i < Z80CTC_NUM_CHANNELS; i++) {
         z80ctc_channel_t* chn = &ctc->chn[i];
         /*
@@ -347,6 +497,7 @@ static inline uint64_t z80ctc_int(z80ctc_t* ctc, uint64_t pins) {
                 */
                 if (chn->int_state & Z80CTC_INT_SERVICING) {
                     chn->int_state = 0;
+                    ctc->int_active &= ~(1<<i);
                 }
                 /* if we are *NOT* the device currently under service, this
                    means we have an interrupt request pending but the CPU
@@ -380,6 +531,8 @@ static inline uint64_t z80ctc_int(z80ctc_t* ctc, uint64_t pins) {
     }
     return pins;
 }
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* z80ctc_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -422,6 +575,7 @@ void z80ctc_reset(z80ctc_t* ctc) {
         chn->prescaler_mask = 0x0F;
         chn->int_state = 0;
     }
+    ctc->int_active = 0;
 }
 
 /* write to CTC channel */
@@ -499,4 +653,29 @@ uint64_t z80ctc_iorq(z80ctc_t* ctc, uint64_t pins) {
     return pins;
 }
 
+static const chips_state_field_t _z80ctc_channel_state_fields[] = {
+    CHIPS_FIELD_U8(z80ctc_channel_t, control),
+    CHIPS_FIELD_U8(z80ctc_channel_t, constant),
+    CHIPS_FIELD_U8(z80ctc_channel_t, down_counter),
+    CHIPS_FIELD_U8(z80ctc_channel_t, prescaler),
+    CHIPS_FIELD_U8(z80ctc_channel_t, int_vector),
+    CHIPS_FIELD_BOOL(z80ctc_channel_t, trigger_edge),
+    CHIPS_FIELD_BOOL(z80ctc_channel_t, waiting_for_trigger),
+    CHIPS_FIELD_BOOL(z80ctc_channel_t, ext_trigger),
+    CHIPS_FIELD_U8(z80ctc_channel_t, prescaler_mask),
+    CHIPS_FIELD_U8(z80ctc_channel_t, int_state),
+};
+
+static const chips_state_field_t _z80ctc_state_fields[] = {
+    CHIPS_FIELD_STRUCT(z80ctc_t, chn, z80ctc_channel_t, _z80ctc_channel_state_fields),
+    CHIPS_FIELD_U8(z80ctc_t, int_active),
+    CHIPS_FIELD_U64(z80ctc_t, pins),
+};
+
+static const chips_state_desc_t _z80ctc_state_desc = CHIPS_STATE_DESC("z80ctc", z80ctc_t, _z80ctc_state_fields);
+
+const chips_state_desc_t* z80ctc_state_desc(void) {
+    return &_z80ctc_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
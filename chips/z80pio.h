@@ -18,6 +18,10 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    You need to include the following headers before including z80pio.h:
+
+    - chips/chips_state.h
+
     ## Emulated pins:
 
     *************************************
@@ -117,7 +121,10 @@
     uint64_t z80pio_int(z80pio_t* pio, uint64_t pins)
     ~~~
         Handle the daisy-chain interrupt protocol. See the z80.h header
-        for details.
+        for details. The function returns immediately if no port has
+        a pending or in-service interrupt (tracked in the
+        z80pio_t.int_active bitmask, which can also be used with the
+        Z80_DAISYCHAIN_BEGIN_IF() macro to skip the entire daisy chain).
 
     ## Macros
 
@@ -305,6 +312,7 @@ typedef struct {
 /* Z80 PIO state. */
 typedef struct {
     z80pio_port_t port[Z80PIO_NUM_PORTS];
+    uint8_t int_active; /* bit n is set while port n has a pending or in-service interrupt */
     bool reset_active;  /* currently in reset state? (until a control word is received) */
     z80pio_in_t in_cb;
     z80pio_out_t out_cb;
@@ -331,6 +339,10 @@ uint64_t z80pio_iorq(z80pio_t* pio, uint64_t pins);
 void z80pio_write_port(z80pio_t* pio, int port_id, uint8_t data);
 /* call this once per machine cycle to handle the interrupt daisy chain */
 static inline uint64_t z80pio_int(z80pio_t* pio, uint64_t pins) {
+    /* early out if no port has any interrupt activity */
+    if (0 == pio->int_active) {
+        return pins;
+    }
     for (int i = 0; i < Z80PIO_NUM_PORTS; i++) {
         z80pio_port_t* p = &pio->port[i];
         /*
@@ -364,6 +376,7 @@ static inline uint64_t z80pio_int(z80pio_t* pio, uint64_t pins) {
                 */
                 if (p->int_state & Z80PIO_INT_SERVICING) {
                     p->int_state = 0;
+                    pio->int_active &= ~(1<<i);
                 }
                 /* if we are *NOT* the device currently under service, this
                    means we have an interrupt request pending but the CPU
@@ -397,6 +410,8 @@ static inline uint64_t z80pio_int(z80pio_t* pio, uint64_t pins) {
     }
     return pins;
 }
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* z80pio_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -433,6 +448,7 @@ void z80pio_reset(z80pio_t* pio) {
         pio->port[p].bctrl_match = false;
         pio->port[p].int_state = 0;
     }
+    pio->int_active = 0;
     pio->reset_active = true;
 }
 
@@ -491,6 +507,7 @@ void _z80pio_write_ctrl(z80pio_t* pio, int port_id, uint8_t data) {
                 p->int_enabled = false;
                 /* reset pending interrupt */
                 p->int_state = 0;
+                pio->int_active &= ~(1<<port_id);
                 p->bctrl_match = false;
             }
             else {
@@ -617,9 +634,39 @@ void z80pio_write_port(z80pio_t* pio, int port_id, uint8_t data) {
         else if ((ictrl == 0x60) && (val == mask)) match = true;
         if (!p->bctrl_match && match && (p->int_control & 0x80)) {
             p->int_state |= Z80PIO_INT_NEEDED;
+            pio->int_active |= (1<<port_id);
         }
         p->bctrl_match = match;
     }
 }
 
+static const chips_state_field_t _z80pio_port_state_fields[] = {
+    CHIPS_FIELD_U8(z80pio_port_t, input),
+    CHIPS_FIELD_U8(z80pio_port_t, output),
+    CHIPS_FIELD_U8(z80pio_port_t, port),
+    CHIPS_FIELD_U8(z80pio_port_t, mode),
+    CHIPS_FIELD_U8(z80pio_port_t, io_select),
+    CHIPS_FIELD_U8(z80pio_port_t, int_vector),
+    CHIPS_FIELD_U8(z80pio_port_t, int_control),
+    CHIPS_FIELD_U8(z80pio_port_t, int_mask),
+    CHIPS_FIELD_U8(z80pio_port_t, int_state),
+    CHIPS_FIELD_BOOL(z80pio_port_t, int_enabled),
+    CHIPS_FIELD_BOOL(z80pio_port_t, expect_io_select),
+    CHIPS_FIELD_BOOL(z80pio_port_t, expect_int_mask),
+    CHIPS_FIELD_BOOL(z80pio_port_t, bctrl_match),
+};
+
+static const chips_state_field_t _z80pio_state_fields[] = {
+    CHIPS_FIELD_STRUCT(z80pio_t, port, z80pio_port_t, _z80pio_port_state_fields),
+    CHIPS_FIELD_U8(z80pio_t, int_active),
+    CHIPS_FIELD_BOOL(z80pio_t, reset_active),
+    CHIPS_FIELD_U64(z80pio_t, pins),
+};
+
+static const chips_state_desc_t _z80pio_state_desc = CHIPS_STATE_DESC("z80pio", z80pio_t, _z80pio_state_fields);
+
+const chips_state_desc_t* z80pio_state_desc(void) {
+    return &_z80pio_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
@@ -2,7 +2,7 @@
 /*#
     # m6502.h
 
-    MOS Technology 6502 / 6510 CPU emulator.
+    MOS Technology 6502 / 6510, Ricoh 2A03 and CMOS 65C02 CPU emulator.
 
     Project repo: https://github.com/floooh/chips/
     
@@ -21,6 +21,21 @@
     CHIPS_ASSERT(c)
     ~~~
 
+    ~~~C
+    CHIPS_M6502_COMPUTED_GOTO
+    ~~~
+        if defined, and the compiler is GCC or Clang, the tick functions
+        dispatch through a table of label addresses (the 'labels as values'
+        extension) instead of a switch-case statement, and each instruction
+        step has its own copy of the tick epilogue. This removes the jump
+        table bounds check and gives the branch predictor one jump site
+        per instruction step. On other compilers the define is ignored
+        and the regular switch-case decoder is used.
+
+    You need to include the following headers before including m6502.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
 
     ***********************************
@@ -40,6 +55,39 @@
 
     The input/output P0..P5 pins only exist on the m6510.
 
+    ## CPU Variants
+
+    Each supported CPU variant has its own code-generated instruction
+    decoder in a separate tick function, so that variant-specific behaviour
+    (like the decimal mode) is resolved when the decoder is generated
+    instead of being checked at runtime. Pick the tick function which
+    matches the emulated CPU, the m6502_t struct and m6502_init()
+    are shared between all variants:
+
+    - **m6502_tick()**: the NMOS 6502 including decimal mode and
+      the undocumented instructions
+    - **m6510_tick()**: same as m6502_tick(), but also updates the
+      M6510_P0..P5 IO port pins (see m6510_iorq())
+    - **m2a03_tick()**: the Ricoh 2A03 used in NES-class machines, this is an
+      NMOS 6502 without decimal mode (the D flag can be set and cleared,
+      but doesn't affect ADC and SBC)
+    - **m65c02_tick()**: the CMOS 65C02 (without the Rockwell/WDC
+      bit manipulation instructions). Differences to the NMOS 6502:
+        - the new instructions BRA, PHX, PHY, PLX, PLY, STZ, TRB, TSB,
+          INC A, DEC A, the (zp) addressing mode, BIT #/zp,X/abs,X and
+          JMP (abs,X)
+        - JMP (abs) doesn't have the page-wrap bug and takes 6 cycles
+        - the N and Z flags are valid in decimal mode, and ADC/SBC take
+          an additional cycle in decimal mode
+        - BRK and interrupts clear the D flag
+        - read-modify-write instructions perform a dummy read instead
+          of a dummy write, and ASL/LSR/ROL/ROR abs,X take 6 cycles
+          if no page boundary is crossed
+        - all undocumented NMOS instructions are NOPs of different
+          length and duration
+      The dummy read addresses of indexed addressing modes are not
+      emulated exactly.
+
     If the RDY pin is active (1) the CPU will loop on the next read
     access until the pin goes inactive.
 
@@ -54,7 +102,6 @@
 
         ~~~C
         typedef struct {
-            bool bcd_disabled;          // set to true if BCD mode is disabled
             m6510_in_t in_cb;           // only m6510: port IO input callback
             m6510_out_t out_cb;         // only m6510: port IO output callback
             uint8_t m6510_io_pullup;    // only m6510: IO port bits that are 1 when reading
@@ -71,7 +118,8 @@
     m6502_init() will return a 64-bit pin mask which must be the input argument
     to the first call of m6502_tick().
 
-    To execute instructions, call m6502_tick() in a loop. m6502_tick() takes
+    To execute instructions, call m6502_tick() (or one of the other
+    variant tick functions) in a loop. m6502_tick() takes
     a 64-bit pin mask as input, executes one clock tick, and returns
     a modified pin mask.
 
@@ -145,7 +193,6 @@
         initialization attributes:
             ~~~C
             typedef struct {
-                bool bcd_disabled;              // set to true if BCD mode is disabled
                 m6510_in_t m6510_in_cb;         // m6510 only: optional port IO input callback
                 m6510_out_t m6510_out_cb;       // m6510 only: optional port IO output callback
                 void* m6510_user_data;          // m6510 only: optional callback user data
@@ -166,10 +213,18 @@
         is the current state of the CPU pins used to communicate with the
         outside world (see the Overview section above for details).
 
+    ~~~C
+    uint64_t m6510_tick(m6502_t* cpu, uint64_t pins)
+    uint64_t m2a03_tick(m6502_t* cpu, uint64_t pins)
+    uint64_t m65c02_tick(m6502_t* cpu, uint64_t pins)
+    ~~~
+        Same as m6502_tick() for the other CPU variants (see the section
+        CPU Variants above).
+
     ~~~C
     uint64_t m6510_iorq(m6502_t* cpu, uint64_t pins)
     ~~~
-        For the 6510, call this function after the tick callback when memory
+        For the 6510, call this function after m6510_tick() when memory
         access to the special addresses 0 and 1 are requested. m6510_iorq()
         may call the input/output callback functions provided in m6502_desc_t.
 
@@ -277,7 +332,6 @@ typedef uint8_t (*m6510_in_t)(void* user_data);
 
 /* the desc structure provided to m6502_init() */
 typedef struct {
-    bool bcd_disabled;              /* set to true if BCD mode is disabled */
     m6510_in_t m6510_in_cb;         /* optional port IO input callback (only on m6510) */
     m6510_out_t m6510_out_cb;       /* optional port IO output callback (only on m6510) */
     void* m6510_user_data;          /* optional callback user data */
@@ -295,7 +349,6 @@ typedef struct {
     uint16_t irq_pip;
     uint16_t nmi_pip;
     uint8_t brk_flags;  /* M6502_BRK_* */
-    uint8_t bcd_enabled;
     /* 6510 IO port state */
     void* user_data;
     m6510_in_t in_cb;
@@ -311,8 +364,14 @@ typedef struct {
 
 /* initialize a new m6502 instance and return initial pin mask */
 uint64_t m6502_init(m6502_t* cpu, const m6502_desc_t* desc);
-/* execute one tick */
+/* execute one tick (NMOS 6502) */
 uint64_t m6502_tick(m6502_t* cpu, uint64_t pins);
+/* execute one tick (NMOS 6510 with IO port) */
+uint64_t m6510_tick(m6502_t* cpu, uint64_t pins);
+/* execute one tick (Ricoh 2A03, no decimal mode) */
+uint64_t m2a03_tick(m6502_t* cpu, uint64_t pins);
+/* execute one tick (CMOS 65C02) */
+uint64_t m65c02_tick(m6502_t* cpu, uint64_t pins);
 /* perform m6510 port IO (only call this if M6510_CHECK_IO(pins) is true) */
 uint64_t m6510_iorq(m6502_t* cpu, uint64_t pins);
 
@@ -346,6 +405,8 @@ uint16_t m6502_pc(m6502_t* cpu);
 #define M6510_SET_PORT(p,d) {p=(((p)&~M6510_PORT_BITS)|((((uint64_t)d)<<32)&M6510_PORT_BITS));}
 /* M6510: check for IO port access to address 0 or 1 */
 #define M6510_CHECK_IO(p) ((p&0xFFFEULL)==0)
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* m6502_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -376,8 +437,23 @@ uint16_t m6502_pc(m6502_t* cpu) { return cpu->PC; }
 /* helper macros and functions for code-generated instruction decoder */
 #define _M6502_NZ(p,v) ((p&~(M6502_NF|M6502_ZF))|((v&0xFF)?(v&M6502_NF):M6502_ZF))
 
+/* ADC without decimal mode */
+static inline void _m6502_adc_bin(m6502_t* cpu, uint8_t val) {
+    uint16_t sum = cpu->A + val + (cpu->P & M6502_CF ? 1:0);
+    cpu->P &= ~(M6502_VF|M6502_CF);
+    cpu->P = _M6502_NZ(cpu->P,sum);
+    if (~(cpu->A^val) & (cpu->A^sum) & 0x80) {
+        cpu->P |= M6502_VF;
+    }
+    if (sum & 0xFF00) {
+        cpu->P |= M6502_CF;
+    }
+    cpu->A = sum & 0xFF;
+}
+
+/* ADC with NMOS decimal mode */
 static inline void _m6502_adc(m6502_t* cpu, uint8_t val) {
-    if (cpu->bcd_enabled && (cpu->P & M6502_DF)) {
+    if (cpu->P & M6502_DF) {
         /* decimal mode (credit goes to MAME) */
         uint8_t c = cpu->P & M6502_CF ? 1 : 0;
         cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
@@ -404,22 +480,35 @@ static inline void _m6502_adc(m6502_t* cpu, uint8_t val) {
         cpu->A = (ah<<4) | (al & 0x0F);
     }
     else {
-        /* default mode */
-        uint16_t sum = cpu->A + val + (cpu->P & M6502_CF ? 1:0);
-        cpu->P &= ~(M6502_VF|M6502_CF);
-        cpu->P = _M6502_NZ(cpu->P,sum);
-        if (~(cpu->A^val) & (cpu->A^sum) & 0x80) {
-            cpu->P |= M6502_VF;
-        }
-        if (sum & 0xFF00) {
-            cpu->P |= M6502_CF;
-        }
-        cpu->A = sum & 0xFF;
-    }    
+        _m6502_adc_bin(cpu, val);
+    }
 }
 
+/* ADC with CMOS decimal mode (N and Z flags are valid) */
+static inline void _m65c02_adc(m6502_t* cpu, uint8_t val) {
+    _m6502_adc(cpu, val);
+    if (cpu->P & M6502_DF) {
+        cpu->P = _M6502_NZ(cpu->P, cpu->A);
+    }
+}
+
+/* SBC without decimal mode */
+static inline void _m6502_sbc_bin(m6502_t* cpu, uint8_t val) {
+    uint16_t diff = cpu->A - val - (cpu->P & M6502_CF ? 0 : 1);
+    cpu->P &= ~(M6502_VF|M6502_CF);
+    cpu->P = _M6502_NZ(cpu->P, (uint8_t)diff);
+    if ((cpu->A^val) & (cpu->A^diff) & 0x80) {
+        cpu->P |= M6502_VF;
+    }
+    if (!(diff & 0xFF00)) {
+        cpu->P |= M6502_CF;
+    }
+    cpu->A = diff & 0xFF;
+}
+
+/* SBC with NMOS decimal mode */
 static inline void _m6502_sbc(m6502_t* cpu, uint8_t val) {
-    if (cpu->bcd_enabled && (cpu->P & M6502_DF)) {
+    if (cpu->P & M6502_DF) {
         /* decimal mode (credit goes to MAME) */
         uint8_t c = cpu->P & M6502_CF ? 0 : 1;
         cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
@@ -447,17 +536,15 @@ static inline void _m6502_sbc(m6502_t* cpu, uint8_t val) {
         cpu->A = (ah<<4) | (al & 0x0F);
     }
     else {
-        /* default mode */
-        uint16_t diff = cpu->A - val - (cpu->P & M6502_CF ? 0 : 1);
-        cpu->P &= ~(M6502_VF|M6502_CF);
-        cpu->P = _M6502_NZ(cpu->P, (uint8_t)diff);
-        if ((cpu->A^val) & (cpu->A^diff) & 0x80) {
-            cpu->P |= M6502_VF;
-        }
-        if (!(diff & 0xFF00)) {
-            cpu->P |= M6502_CF;
-        }
-        cpu->A = diff & 0xFF;
+        _m6502_sbc_bin(cpu, val);
+    }
+}
+
+/* SBC with CMOS decimal mode (N and Z flags are valid) */
+static inline void _m65c02_sbc(m6502_t* cpu, uint8_t val) {
+    _m6502_sbc(cpu, val);
+    if (cpu->P & M6502_DF) {
+        cpu->P = _M6502_NZ(cpu->P, cpu->A);
     }
 }
 
@@ -513,12 +600,29 @@ static inline void _m6502_bit(m6502_t* cpu, uint8_t v) {
     cpu->P |= v & (M6502_NF|M6502_VF);
 }
 
+/* undocumented ARR instruction without decimal mode */
+static inline void _m6502_arr_bin(m6502_t* cpu) {
+    bool c = cpu->P & M6502_CF;
+    cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
+    cpu->A >>= 1;
+    if (c) {
+        cpu->A |= 0x80;
+    }
+    cpu->P = _M6502_NZ(cpu->P,cpu->A);
+    if (cpu->A & 0x40) {
+        cpu->P |= M6502_VF|M6502_CF;
+    }
+    if (cpu->A & 0x20) {
+        cpu->P ^= M6502_VF;
+    }
+}
+
 static inline void _m6502_arr(m6502_t* cpu) {
     /* undocumented, unreliable ARR instruction, but this is tested
        by the Wolfgang Lorenz C64 test suite
        implementation taken from MAME
     */
-    if (cpu->bcd_enabled && (cpu->P & M6502_DF)) {
+    if (cpu->P & M6502_DF) {
         bool c = cpu->P & M6502_CF;
         cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
         uint8_t a = cpu->A>>1;
@@ -539,19 +643,7 @@ static inline void _m6502_arr(m6502_t* cpu) {
         cpu->A = a;
     }
     else {
-        bool c = cpu->P & M6502_CF;
-        cpu->P &= ~(M6502_NF|M6502_VF|M6502_ZF|M6502_CF);
-        cpu->A >>= 1;
-        if (c) {
-            cpu->A |= 0x80;
-        }
-        cpu->P = _M6502_NZ(cpu->P,cpu->A);
-        if (cpu->A & 0x40) {
-            cpu->P |= M6502_VF|M6502_CF;
-        }
-        if (cpu->A & 0x20) {
-            cpu->P ^= M6502_VF;
-        }
+        _m6502_arr_bin(cpu);
     }
 }
 
@@ -574,7 +666,6 @@ uint64_t m6502_init(m6502_t* c, const m6502_desc_t* desc) {
     CHIPS_ASSERT(c && desc);
     memset(c, 0, sizeof(*c));
     c->P = M6502_ZF;
-    c->bcd_enabled = !desc->bcd_disabled;
     c->PINS = M6502_RW | M6502_SYNC | M6502_RES;
     c->in_cb = desc->m6510_in_cb;
     c->out_cb = desc->m6510_out_cb;
@@ -648,7 +739,12 @@ uint64_t m6510_iorq(m6502_t* c, uint64_t pins) {
 #pragma warning(disable:4244)   /* conversion from 'uint16_t' to 'uint8_t', possible loss of data */
 #endif
 
-uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
+/* common tick prologue, handles interrupt detection, the RDY pin and
+   the start of a new instruction, returns true if the CPU is stalled
+   by the RDY pin
+*/
+static inline bool _m6502_tick_begin(m6502_t* c, uint64_t* pins_ptr) {
+    uint64_t pins = *pins_ptr;
     if (pins & (M6502_SYNC|M6502_IRQ|M6502_NMI|M6502_RDY|M6502_RES)) {
         // interrupt detection also works in RDY phases, but only NMI is "sticky"
         
@@ -663,10 +759,10 @@ uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
         
         // RDY pin is only checked during read cycles
         if ((pins & (M6502_RW|M6502_RDY)) == (M6502_RW|M6502_RDY)) {
-            M6510_SET_PORT(pins, c->io_pins);
             c->PINS = pins;
             c->irq_pip <<= 1;
-            return pins;
+            *pins_ptr = pins;
+            return true;
         }
         if (pins & M6502_SYNC) {
             // load new instruction into 'instruction register' and restart tick counter
@@ -708,17 +804,92 @@ uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
             }
         }
     }
+    *pins_ptr = pins;
+    return false;
+}
+
+/* common tick epilogue */
+#define _M6502_TICK_END() c->PINS=pins;c->irq_pip<<=1;c->nmi_pip<<=1;
+
+/* instruction step dispatch, either switch-case, or computed goto with
+   the tick epilogue replicated into each instruction step
+*/
+#if defined(CHIPS_M6502_COMPUTED_GOTO) && (defined(__GNUC__) || defined(__clang__))
+#define _M6502_COMPUTED_GOTO (1)
+#define _OP(op,t) _m6502_op_##op##_##t
+#define _NEXT() _M6502_TICK_END();return pins;
+#define _DISPATCH(table) goto *table[c->IR++]; {
+#else
+#define _OP(op,t) case (op<<3)|t
+#define _NEXT() break;
+#define _DISPATCH(table) switch (c->IR++) {
+#endif
+
+/* NMOS 6502 instruction decoder */
+uint64_t m6502_tick(m6502_t* c, uint64_t pins) {
+    if (_m6502_tick_begin(c, &pins)) {
+        return pins;
+    }
     // reads are default, writes are special
     _RD();
-    switch (c->IR++) {
+    #if defined(_M6502_COMPUTED_GOTO)
+    static const void* _m6502_op_table[2048] = {
+$dispatch_table
+    };
+    #endif
+    _DISPATCH(_m6502_op_table)
 $decode_block
     }
+    _M6502_TICK_END();
+    return pins;
+}
+
+/* NMOS 6510, same as the 6502 but also updates the IO port pins */
+uint64_t m6510_tick(m6502_t* c, uint64_t pins) {
+    pins = m6502_tick(c, pins);
     M6510_SET_PORT(pins, c->io_pins);
     c->PINS = pins;
-    c->irq_pip <<= 1;
-    c->nmi_pip <<= 1;
     return pins;
 }
+
+/* Ricoh 2A03 instruction decoder (NMOS 6502 without decimal mode) */
+uint64_t m2a03_tick(m6502_t* c, uint64_t pins) {
+    if (_m6502_tick_begin(c, &pins)) {
+        return pins;
+    }
+    // reads are default, writes are special
+    _RD();
+    #if defined(_M6502_COMPUTED_GOTO)
+    static const void* _m6502_op_table[2048] = {
+$dispatch_table
+    };
+    #endif
+    _DISPATCH(_m6502_op_table)
+$decode_block_2a03
+    }
+    _M6502_TICK_END();
+    return pins;
+}
+
+/* CMOS 65C02 instruction decoder */
+uint64_t m65c02_tick(m6502_t* c, uint64_t pins) {
+    if (_m6502_tick_begin(c, &pins)) {
+        return pins;
+    }
+    // reads are default, writes are special
+    _RD();
+    #if defined(_M6502_COMPUTED_GOTO)
+    static const void* _m6502_op_table[2048] = {
+$dispatch_table
+    };
+    #endif
+    _DISPATCH(_m6502_op_table)
+$decode_block_65c02
+    }
+    _M6502_TICK_END();
+    return pins;
+}
+
 #if defined(_MSC_VER)
 #pragma warning(pop)
 #endif
@@ -733,4 +904,38 @@ $decode_block
 #undef _RD
 #undef _WR
 #undef _NZ
+#undef _M6502_TICK_END
+#undef _OP
+#undef _NEXT
+#undef _DISPATCH
+#undef _M6502_COMPUTED_GOTO
+
+static const chips_state_field_t _m6502_state_fields[] = {
+    CHIPS_FIELD_U16(m6502_t, IR),
+    CHIPS_FIELD_U16(m6502_t, PC),
+    CHIPS_FIELD_U16(m6502_t, AD),
+    CHIPS_FIELD_U8(m6502_t, A),
+    CHIPS_FIELD_U8(m6502_t, X),
+    CHIPS_FIELD_U8(m6502_t, Y),
+    CHIPS_FIELD_U8(m6502_t, S),
+    CHIPS_FIELD_U8(m6502_t, P),
+    CHIPS_FIELD_U64(m6502_t, PINS),
+    CHIPS_FIELD_U16(m6502_t, irq_pip),
+    CHIPS_FIELD_U16(m6502_t, nmi_pip),
+    CHIPS_FIELD_U8(m6502_t, brk_flags),
+    CHIPS_FIELD_U8(m6502_t, io_ddr),
+    CHIPS_FIELD_U8(m6502_t, io_inp),
+    CHIPS_FIELD_U8(m6502_t, io_out),
+    CHIPS_FIELD_U8(m6502_t, io_pins),
+    CHIPS_FIELD_U8(m6502_t, io_pullup),
+    CHIPS_FIELD_U8(m6502_t, io_floating),
+    CHIPS_FIELD_U8(m6502_t, io_drive),
+};
+
+static const chips_state_desc_t _m6502_state_desc = CHIPS_STATE_DESC("m6502", m6502_t, _m6502_state_fields);
+
+const chips_state_desc_t* m6502_state_desc(void) {
+    return &_m6502_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
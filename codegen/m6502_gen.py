@@ -8,6 +8,14 @@ from string import Template
 InpPath = 'm6502.template.h'
 OutPath = '../chips/m6502.h'
 
+# CPU variants, each gets its own decoder block in the template
+V_NMOS  = 'nmos'    # NMOS 6502/6510 with decimal mode
+V_2A03  = '2a03'    # Ricoh 2A03, NMOS 6502 without decimal mode
+V_65C02 = '65c02'   # CMOS 65C02
+
+# the CPU variant currently generated
+variant = V_NMOS
+
 # flag bits
 CF = (1<<0)
 ZF = (1<<1)
@@ -52,9 +60,10 @@ A_IDY = 9       # (zp),Y
 A_JMP = 10      # special JMP abs
 A_JSR = 11      # special JSR abs
 A_INV = 12      # an invalid instruction
+A_ZPI = 13      # (zp) (65C02 only)
 
 # addressing mode strings
-addr_mode_str = ['', '#', 'zp', 'zp,X', 'zp,Y', 'abs', 'abs,X', 'abs,Y', '(zp,X)', '(zp),Y', '', '', 'INVALID']
+addr_mode_str = ['', '#', 'zp', 'zp,X', 'zp,Y', 'abs', 'abs,X', 'abs,Y', '(zp,X)', '(zp),Y', '', '', 'INVALID', '(zp)']
 
 # memory access modes
 M___ = 0        # no memory access
@@ -117,6 +126,8 @@ class opcode:
     def __init__(self, op):
         self.code = op
         self.cmt = None
+        self.addr_mode = None
+        self.fetched = False
         self.i = 0
         self.src = [None] * 8
     def t(self, src):
@@ -140,16 +151,26 @@ def write_op(op):
     l('    /* {} */'.format(op.cmt if op.cmt else '???'))
     for t in range(0, 8):
         if t < op.i:
-            l('        case (0x{:02X}<<3)|{}: {}break;'.format(op.code, t, op.src[t]))
+            l('        _OP(0x{:02X},{}): {}_NEXT()'.format(op.code, t, op.src[t]))
         else:
-            l('        case (0x{:02X}<<3)|{}: assert(false);break;'.format(op.code, t))
+            l('        _OP(0x{:02X},{}): assert(false);_NEXT()'.format(op.code, t))
+
+#-------------------------------------------------------------------------------
+# write the label address table for computed-goto dispatch, this must
+# match the _OP() labels written by write_op()
+#
+def write_dispatch_table():
+    lines = []
+    for op in range(0, 256):
+        lines.append(' '*8 + ','.join('&&_m6502_op_0x{:02X}_{}'.format(op, t) for t in range(0, 8)) + ',')
+    return '\n'.join(lines)
 
 #-------------------------------------------------------------------------------
 def cmt(o,cmd):
     cc = o.code & 3
     bbb = (o.code>>2) & 7
     aaa = (o.code>>5) & 7
-    addr_mode = ops[cc][bbb][aaa][0]
+    addr_mode = ops[cc][bbb][aaa][0] if o.addr_mode is None else o.addr_mode
     o.cmt = cmd;
     if addr_mode != '':
         o.cmt += ' '+addr_mode_str[addr_mode]
@@ -241,6 +262,12 @@ def enc_addr(op, addr_mode, mem_access):
     elif addr_mode == A_JSR:
         # jsr is completely handled in instruction decoding 
         pass
+    elif addr_mode == A_ZPI:
+        # (zp), 65C02 only
+        op.t('_SA(c->PC++);')
+        op.t('c->AD=_GD();_SA(c->AD);')
+        op.t('_SA((c->AD+1)&0xFF);c->AD=_GD();')
+        op.t('_SA((_GD()<<8)|c->AD);')
     else:
         # invalid instruction
         pass
@@ -251,7 +278,10 @@ def i_brk(o):
     o.t('if(0==(c->brk_flags&(M6502_BRK_IRQ|M6502_BRK_NMI))){c->PC++;}_SAD(0x0100|c->S--,c->PC>>8);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}')
     o.t('_SAD(0x0100|c->S--,c->PC);if(0==(c->brk_flags&M6502_BRK_RESET)){_WR();}')
     o.t('_SAD(0x0100|c->S--,c->P|M6502_XF);if(c->brk_flags&M6502_BRK_RESET){c->AD=0xFFFC;}else{_WR();if(c->brk_flags&M6502_BRK_NMI){c->AD=0xFFFA;}else{c->AD=0xFFFE;}}')
-    o.t('_SA(c->AD++);c->P|=(M6502_IF|M6502_BF);c->brk_flags=0; /* RES/NMI hijacking */')
+    if variant == V_65C02:
+        o.t('_SA(c->AD++);c->P|=(M6502_IF|M6502_BF);c->P&=~M6502_DF;c->brk_flags=0; /* RES/NMI hijacking */')
+    else:
+        o.t('_SA(c->AD++);c->P|=(M6502_IF|M6502_BF);c->brk_flags=0; /* RES/NMI hijacking */')
     o.t('_SA(c->AD);c->AD=_GD(); /* NMI "half-hijacking" not possible */')
     o.t('c->PC=(_GD()<<8)|c->AD;')
 
@@ -461,20 +491,41 @@ def i_eor(o):
     cmt(o,'EOR')
     o.t('c->A^=_GD();_NZ(c->A);')
 
+#-------------------------------------------------------------------------------
+def adc_func():
+    if variant == V_2A03:    return '_m6502_adc_bin'
+    elif variant == V_65C02: return '_m65c02_adc'
+    else:                    return '_m6502_adc'
+
+def sbc_func():
+    if variant == V_2A03:    return '_m6502_sbc_bin'
+    elif variant == V_65C02: return '_m65c02_sbc'
+    else:                    return '_m6502_sbc'
+
+#-------------------------------------------------------------------------------
+def decimal_extra_cycle(o):
+    # on the 65C02, ADC and SBC take an extra cycle in decimal mode
+    if variant == V_65C02:
+        o.ta('if(0==(c->P&M6502_DF)){_FETCH();}')
+        o.t('_FETCH();')
+        o.fetched = True
+
 #-------------------------------------------------------------------------------
 def i_adc(o):
     cmt(o,'ADC')
-    o.t('_m6502_adc(c,_GD());')
+    o.t(adc_func()+'(c,_GD());')
+    decimal_extra_cycle(o)
 
 #-------------------------------------------------------------------------------
 def i_sbc(o):
     cmt(o,'SBC')
-    o.t('_m6502_sbc(c,_GD());')
+    o.t(sbc_func()+'(c,_GD());')
+    decimal_extra_cycle(o)
 
 #-------------------------------------------------------------------------------
 def u_sbc(o):
     u_cmt(o,'SBC')
-    o.t('_m6502_sbc(c,_GD());')
+    o.t(sbc_func()+'(c,_GD());')
 
 #-------------------------------------------------------------------------------
 def i_cmp(o):
@@ -503,16 +554,22 @@ def x_sbx(o):
     u_cmt(o,'SBX')
     o.t('_m6502_sbx(c, _GD());')
 
+#-------------------------------------------------------------------------------
+def rmw_dummy():
+    # the NMOS 6502 writes the unmodified value back in the dummy cycle
+    # of read-modify-write instructions, the 65C02 performs a dummy read
+    return '' if variant == V_65C02 else '_WR();'
+
 #-------------------------------------------------------------------------------
 def i_dec(o):
     cmt(o,'DEC')
-    o.t('c->AD=_GD();_WR();')
+    o.t('c->AD=_GD();'+rmw_dummy())
     o.t('c->AD--;_NZ(c->AD);_SD(c->AD);_WR();')
 
 #-------------------------------------------------------------------------------
 def i_inc(o):
     cmt(o,'INC')
-    o.t('c->AD=_GD();_WR();')
+    o.t('c->AD=_GD();'+rmw_dummy())
     o.t('c->AD++;_NZ(c->AD);_SD(c->AD);_WR();')
 
 #-------------------------------------------------------------------------------
@@ -540,12 +597,12 @@ def u_isb(o):
     # undocumented INC+SBC instruction
     u_cmt(o,'ISB')
     o.t('c->AD=_GD();_WR();')
-    o.t('c->AD++;_SD(c->AD);_m6502_sbc(c,c->AD);_WR();')
+    o.t('c->AD++;_SD(c->AD);'+sbc_func()+'(c,c->AD);_WR();')
 
 #-------------------------------------------------------------------------------
 def i_asl(o):
     cmt(o,'ASL')
-    o.t('c->AD=_GD();_WR();')
+    o.t('c->AD=_GD();'+rmw_dummy())
     o.t('_SD(_m6502_asl(c,c->AD));_WR();')
 
 #-------------------------------------------------------------------------------
@@ -556,7 +613,7 @@ def i_asla(o):
 #-------------------------------------------------------------------------------
 def i_lsr(o):
     cmt(o,'LSR')
-    o.t('c->AD=_GD();_WR();')
+    o.t('c->AD=_GD();'+rmw_dummy())
     o.t('_SD(_m6502_lsr(c,c->AD));_WR();')
 
 #-------------------------------------------------------------------------------
@@ -587,7 +644,7 @@ def u_sre(o):
 #-------------------------------------------------------------------------------
 def i_rol(o):
     cmt(o,'ROL')
-    o.t('c->AD=_GD();_WR();')
+    o.t('c->AD=_GD();'+rmw_dummy())
     o.t('_SD(_m6502_rol(c,c->AD));_WR();')
 
 #-------------------------------------------------------------------------------
@@ -605,7 +662,7 @@ def u_rla(o):
 #-------------------------------------------------------------------------------
 def i_ror(o):
     cmt(o,'ROR')
-    o.t('c->AD=_GD();_WR();')
+    o.t('c->AD=_GD();'+rmw_dummy())
     o.t('_SD(_m6502_ror(c,c->AD));_WR();')
 
 #-------------------------------------------------------------------------------
@@ -618,13 +675,16 @@ def u_rra(o):
     # undocumented ROR+ADC
     u_cmt(o,'RRA')
     o.t('c->AD=_GD();_WR();')
-    o.t('c->AD=_m6502_ror(c,c->AD);_SD(c->AD);_m6502_adc(c,c->AD);_WR();')
+    o.t('c->AD=_m6502_ror(c,c->AD);_SD(c->AD);'+adc_func()+'(c,c->AD);_WR();')
 
 #-------------------------------------------------------------------------------
 def x_arr(o):
     # undocumented AND+ROR
     u_cmt(o,'ARR')
-    o.t('c->A&=_GD();_m6502_arr(c);')
+    if variant == V_2A03:
+        o.t('c->A&=_GD();_m6502_arr_bin(c);')
+    else:
+        o.t('c->A&=_GD();_m6502_arr(c);')
 
 #-------------------------------------------------------------------------------
 def x_ane(o):
@@ -698,6 +758,159 @@ def i_bit(o):
     cmt(o,'BIT')
     o.t('_m6502_bit(c,_GD());')
 
+#-------------------------------------------------------------------------------
+#   65C02 specific instructions
+#
+def c_bra(o):
+    cmt(o,'BRA')
+    o.t('_SA(c->PC);c->AD=c->PC+(int8_t)_GD();')
+    o.t('_SA((c->PC&0xFF00)|(c->AD&0x00FF));if((c->AD&0xFF00)==(c->PC&0xFF00)){c->PC=c->AD;c->irq_pip>>=1;c->nmi_pip>>=1;_FETCH();};')
+    o.t('c->PC=c->AD;')
+
+#-------------------------------------------------------------------------------
+def c_phr(o, r):
+    cmt(o,'PH'+r)
+    o.t('_SAD(0x0100|c->S--,c->'+r+');_WR();')
+
+#-------------------------------------------------------------------------------
+def c_plr(o, r):
+    cmt(o,'PL'+r)
+    o.t('_SA(0x0100|c->S++);')
+    o.t('_SA(0x0100|c->S);')
+    o.t('c->'+r+'=_GD();_NZ(c->'+r+');')
+
+#-------------------------------------------------------------------------------
+def c_stz(o):
+    cmt(o,'STZ')
+    o.ta('_SD(0);_WR();')
+
+#-------------------------------------------------------------------------------
+def c_tsb(o):
+    cmt(o,'TSB')
+    o.t('c->AD=_GD();')
+    o.t('if(c->A&c->AD){c->P&=~M6502_ZF;}else{c->P|=M6502_ZF;}c->AD|=c->A;_SD(c->AD);_WR();')
+
+#-------------------------------------------------------------------------------
+def c_trb(o):
+    cmt(o,'TRB')
+    o.t('c->AD=_GD();')
+    o.t('if(c->A&c->AD){c->P&=~M6502_ZF;}else{c->P|=M6502_ZF;}c->AD&=~c->A;_SD(c->AD);_WR();')
+
+#-------------------------------------------------------------------------------
+def c_inca(o):
+    cmt(o,'INCA')
+    o.t('c->A++;_NZ(c->A);')
+
+#-------------------------------------------------------------------------------
+def c_deca(o):
+    cmt(o,'DECA')
+    o.t('c->A--;_NZ(c->A);')
+
+#-------------------------------------------------------------------------------
+def c_biti(o):
+    # BIT immediate only affects the Z flag
+    cmt(o,'BIT')
+    o.t('if(c->A&_GD()){c->P&=~M6502_ZF;}else{c->P|=M6502_ZF;}')
+
+#-------------------------------------------------------------------------------
+def c_jmpi(o):
+    # JMP (abs) without the page-wrap bug
+    cmt(o,'JMPI')
+    o.t('_SA(c->PC++);')
+    o.t('_SA(c->PC++);c->AD=_GD();')
+    o.t('c->AD|=_GD()<<8;_SA(c->PC-1);')
+    o.t('_SA(c->AD);')
+    o.t('_SA(c->AD+1);c->AD=_GD();')
+    o.t('c->PC=(_GD()<<8)|c->AD;')
+
+#-------------------------------------------------------------------------------
+def c_jmpix(o):
+    # JMP (abs,X)
+    cmt(o,'JMPIX')
+    o.t('_SA(c->PC++);')
+    o.t('_SA(c->PC++);c->AD=_GD();')
+    o.t('c->AD=((_GD()<<8)|c->AD)+c->X;_SA(c->PC-1);')
+    o.t('_SA(c->AD);')
+    o.t('_SA(c->AD+1);c->AD=_GD();')
+    o.t('c->PC=(_GD()<<8)|c->AD;')
+
+#-------------------------------------------------------------------------------
+def c_nop(o, num_bytes, num_cycles):
+    # the undocumented NMOS instructions are NOPs on the 65C02
+    o.cmt = 'NOP (undoc)'
+    if num_bytes == 1:
+        for i in range(1, num_cycles):
+            o.t('_SA(c->PC);')
+    else:
+        o.t('_SA(c->PC++);')
+        if num_bytes == 3:
+            o.t('_SA(c->PC++);')
+        for i in range(num_bytes, num_cycles):
+            o.t('_SA(c->PC);')
+    o.t('_FETCH();')
+    o.fetched = True
+
+#-------------------------------------------------------------------------------
+def enc_op_65c02(op):
+    # 65C02 instructions which differ from the NMOS 6502
+    o = opcode(op)
+    cc = op & 3
+    if cc == 3:
+        # no Rockwell/WDC bit manipulation instructions, all 1-byte/1-cycle NOPs
+        c_nop(o, 1, 1)
+        return o
+    # new or changed instructions: [addressing mode, memory access, encoder]
+    c_ops = {
+        0x04: [A_ZER, M_RW, c_tsb],  0x0C: [A_ABS, M_RW, c_tsb],
+        0x14: [A_ZER, M_RW, c_trb],  0x1C: [A_ABS, M_RW, c_trb],
+        0x12: [A_ZPI, M_R_, i_ora],  0x32: [A_ZPI, M_R_, i_and],
+        0x52: [A_ZPI, M_R_, i_eor],  0x72: [A_ZPI, M_R_, i_adc],
+        0x92: [A_ZPI, M__W, i_sta],  0xB2: [A_ZPI, M_R_, i_lda],
+        0xD2: [A_ZPI, M_R_, i_cmp],  0xF2: [A_ZPI, M_R_, i_sbc],
+        0x1A: [A____, M___, c_inca], 0x3A: [A____, M___, c_deca],
+        0x34: [A_ZPX, M_R_, i_bit],  0x3C: [A_ABX, M_R_, i_bit],
+        0x89: [A_IMM, M_R_, c_biti],
+        0x5A: [A____, M__W, lambda o: c_phr(o,'Y')],
+        0xDA: [A____, M__W, lambda o: c_phr(o,'X')],
+        0x7A: [A____, M___, lambda o: c_plr(o,'Y')],
+        0xFA: [A____, M___, lambda o: c_plr(o,'X')],
+        0x64: [A_ZER, M__W, c_stz],  0x74: [A_ZPX, M__W, c_stz],
+        0x9C: [A_ABS, M__W, c_stz],  0x9E: [A_ABX, M__W, c_stz],
+        0x80: [A_IMM, M_R_, c_bra],
+        0x6C: [A_JMP, M_R_, c_jmpi], 0x7C: [A_JMP, M_R_, c_jmpix],
+        # ASL/ROL/LSR/ROR abs,X only take an extra cycle when crossing a page
+        0x1E: [A_ABX, M_R_, i_asl],  0x3E: [A_ABX, M_R_, i_rol],
+        0x5E: [A_ABX, M_R_, i_lsr],  0x7E: [A_ABX, M_R_, i_ror],
+    }
+    # remaining undocumented NMOS instructions: [bytes, cycles]
+    c_nops = {
+        0x02: [2,2], 0x22: [2,2], 0x42: [2,2], 0x62: [2,2], 0x82: [2,2], 0xC2: [2,2], 0xE2: [2,2],
+        0x44: [2,3], 0x54: [2,4], 0xD4: [2,4], 0xF4: [2,4],
+        0xDC: [3,4], 0xFC: [3,4], 0x5C: [3,8],
+    }
+    if op in c_ops:
+        addr_mode, mem_access, enc = c_ops[op]
+        o.addr_mode = addr_mode
+        enc_addr(o, addr_mode, mem_access)
+        enc(o)
+        if op in [0x1E, 0x3E, 0x5E, 0x7E]:
+            mem_access = M_RW
+    elif op in c_nops:
+        c_nop(o, c_nops[op][0], c_nops[op][1])
+        return o
+    else:
+        # same as NMOS 6502
+        o = enc_op(op)
+        if o.cmt.endswith('(undoc)'):
+            sys.exit('65C02: unhandled undocumented opcode 0x{:02X}'.format(op))
+        return o
+    if not o.fetched:
+        if mem_access in [M_R_,M___]:
+            o.ta('_FETCH();')
+        else:
+            o.t('_FETCH();')
+    return o
+
 #-------------------------------------------------------------------------------
 def enc_op(op):
     o = opcode(op)
@@ -842,20 +1055,33 @@ def enc_op(op):
             if bbb == 2:    u_sbc(o)
             else:           u_isb(o)
     # fetch next opcode byte
-    if mem_access in [M_R_,M___]:
-        o.ta('_FETCH();')
-    else:
-        o.t('_FETCH();')
+    if not o.fetched:
+        if mem_access in [M_R_,M___]:
+            o.ta('_FETCH();')
+        else:
+            o.t('_FETCH();')
     return o
 
 #-------------------------------------------------------------------------------
 #   execution starts here
 #
-for op in range(0, 256):
-    write_op(enc_op(op))
+decode_blocks = {}
+for v in [V_NMOS, V_2A03, V_65C02]:
+    variant = v
+    out_lines = ''
+    for op in range(0, 256):
+        if variant == V_65C02:
+            write_op(enc_op_65c02(op))
+        else:
+            write_op(enc_op(op))
+    decode_blocks[v] = out_lines
 
 with open(InpPath, 'r') as inf:
     templ = Template(inf.read())
-    c_src = templ.safe_substitute(decode_block=out_lines)
+    c_src = templ.safe_substitute(
+        decode_block=decode_blocks[V_NMOS],
+        decode_block_2a03=decode_blocks[V_2A03],
+        decode_block_65c02=decode_blocks[V_65C02],
+        dispatch_table=write_dispatch_table())
     with open(OutPath, 'w') as outf:
         outf.write(c_src)
@@ -23,6 +23,22 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_Z80_COMPUTED_GOTO
+    ~~~
+        if defined, and the compiler is GCC or Clang, the instruction
+        decoder dispatches through a table of label addresses (the
+        'labels as values' extension) instead of a switch-case statement,
+        and each instruction handler directly fetches and jumps to the next
+        instruction if no interrupt or other special handling is pending.
+        This gives the branch predictor one indirect jump site per
+        instruction instead of a single shared one. On other compilers
+        the define is ignored and the regular switch-case decoder is used.
+
+    You need to include the following headers before including z80.h:
+
+    - chips/chips_state.h
+
     ## Emulated Pins
     ***********************************
     *           +-----------+         *
@@ -140,6 +156,24 @@
     ~~~
         used in tick function at end of interrupt daisy-chain block
 
+    ~~~C
+    Z80_DAISYCHAIN_BEGIN_IF(pins, active)
+    Z80_DAISYCHAIN_END_IF(pins)
+    ~~~
+        same as Z80_DAISYCHAIN_BEGIN/END, but the daisy-chain block
+        is only executed when the 'active' expression is true, typically
+        this is the combined int_active bitmask of all devices in
+        the daisy chain (the RETI pin is cleared in any case):
+
+        ~~~C
+        Z80_DAISYCHAIN_BEGIN_IF(pins, sys->ctc.int_active|sys->pio.int_active)
+        {
+            pins = z80ctc_int(&sys->ctc, pins);
+            pins = z80pio_int(&sys->pio, pins);
+        }
+        Z80_DAISYCHAIN_END_IF(pins);
+        ~~~
+
     ## The Tick Callback 
 
     The tick function is called for one or multiple time cycles
@@ -478,6 +512,10 @@ bool z80_ei_pending(z80_t* cpu);
 #define Z80_DAISYCHAIN_BEGIN(pins) if (pins&Z80_M1) { pins|=Z80_IEIO;
 /* helper macro to end interrupt handling in tick callback */
 #define Z80_DAISYCHAIN_END(pins) pins&=~Z80_RETI; }
+/* same as Z80_DAISYCHAIN_BEGIN, but skip the daisy chain if no device has interrupt activity */
+#define Z80_DAISYCHAIN_BEGIN_IF(pins,active) if (pins&Z80_M1) { pins|=Z80_IEIO; if (active) {
+/* helper macro to end a Z80_DAISYCHAIN_BEGIN_IF block */
+#define Z80_DAISYCHAIN_END_IF(pins) } pins&=~Z80_RETI; }
 /* return a pin mask with control-pins, address and data bus */
 #define Z80_MAKE_PINS(ctrl, addr, data) ((ctrl)|(((data)<<16)&0xFF0000ULL)|((addr)&0xFFFFULL))
 /* extract 16-bit address bus from 64-bit pins */
@@ -492,6 +530,8 @@ bool z80_ei_pending(z80_t* cpu);
 #define Z80_GET_WAIT(p) ((p&Z80_WAIT_MASK)>>Z80_WAIT_SHIFT)
 /* set up to 7 wait states in pin mask */
 #define Z80_SET_WAIT(p,w) {p=((p&~Z80_WAIT_MASK)|((((uint64_t)w)<<Z80_WAIT_SHIFT)&Z80_WAIT_MASK));}
+/* get the chip state field descriptor table (see util/chipstate.h) */
+const chips_state_desc_t* z80_state_desc(void);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -629,6 +669,22 @@ bool z80_ei_pending(z80_t* cpu);
 #else
 #define _FETCH(op) {_SA(pc++);_TWM(4,Z80_M1|Z80_MREQ|Z80_RD);op=_GD();_BUMPR();}
 #endif
+/* instruction dispatch: either switch-case, or computed goto with a
+   replicated fetch-and-dispatch at the end of each instruction handler,
+   this takes the fast path only if no interrupt, EI delay, trap callback
+   or end-of-time-slice needs to be handled, after an indexed instruction
+   the HL <=> IX/IY mapping is undone inline so that IX/IY-heavy code
+   stays on the fast path
+*/
+#if defined(CHIPS_Z80_COMPUTED_GOTO) && (defined(__GNUC__) || defined(__clang__))
+#define _Z80_COMPUTED_GOTO (1)
+#define _OP(op) _z80_op_##op
+#define _UNMAP() if(r2&_BITS_USE_IXIY){r0=_z80_flush_r0(ws,r0,r2);r1=_z80_flush_r1(ws,r1,r2);r2&=~_BITS_USE_IXIY;map_bits=0;ws=r0;}
+#define _NEXT() if ((ticks<num_ticks)&&!trap&&(0==((pins&(Z80_INT|Z80_NMI))|(r2&_BIT_EI)))){_UNMAP();pre_pins=pins;_FETCH(op);goto *_z80_op_table[op];}goto _z80_op_end;
+#else
+#define _OP(op) case op
+#define _NEXT() break;
+#endif
 /* special opcode fetch for CB prefix, only bump R if not a DD/FD+CB 'double prefix' op */
 #define _FETCH_CB(op) {_SA(pc++);_TWM(4,Z80_M1|Z80_MREQ|Z80_RD);op=_GD();if(!_IDX()){_BUMPR();}}
 /* evaluate S+Z flags */
@@ -863,9 +919,20 @@ uint32_t z80_exec(z80_t* cpu, uint32_t num_ticks) {
             ws = _z80_map_regs(r0, r1, r2);
         }
         /* decode instruction */
+        #if defined(_Z80_COMPUTED_GOTO)
+        static const void* _z80_op_table[256] = {
+$dispatch_table
+        };
+        goto *_z80_op_table[op];
+        {
+        #else
         switch (op) {
+        #endif
 $decode_block
         }
+        #if defined(_Z80_COMPUTED_GOTO)
+        _z80_op_end:;
+        #endif
         /* check for interrupt request */
         bool nmi = 0 != ((pins & (pre_pins ^ pins)) & Z80_NMI);
         bool irq = (pins & Z80_INT) && (r2 & _BIT_IFF1);
@@ -1034,6 +1101,10 @@ $decode_block
 #undef _ADDR
 #undef _BUMPR
 #undef _FETCH
+#undef _OP
+#undef _UNMAP
+#undef _NEXT
+#undef _Z80_COMPUTED_GOTO
 #undef _FETCH_CB
 #undef _SZ
 #undef _SZYXCH
@@ -1081,4 +1152,19 @@ $decode_block
 #undef _G_IR 
 #undef _G_PC 
 
+static const chips_state_field_t _z80_state_fields[] = {
+    CHIPS_FIELD_U64(z80_t, bc_de_hl_fa),
+    CHIPS_FIELD_U64(z80_t, bc_de_hl_fa_),
+    CHIPS_FIELD_U64(z80_t, wz_ix_iy_sp),
+    CHIPS_FIELD_U64(z80_t, im_ir_pc_bits),
+    CHIPS_FIELD_U64(z80_t, pins),
+    CHIPS_FIELD_INT(z80_t, trap_id),
+};
+
+static const chips_state_desc_t _z80_state_desc = CHIPS_STATE_DESC("z80", z80_t, _z80_state_fields);
+
+const chips_state_desc_t* z80_state_desc(void) {
+    return &_z80_state_desc;
+}
+
 #endif /* CHIPS_IMPL */
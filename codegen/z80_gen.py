@@ -1,6 +1,6 @@
 #-------------------------------------------------------------------------------
 #   z80_gen.py
-#   Generate huge switch/case Z80 instruction decoder.
+#   Generate huge switch/case (or computed goto) Z80 instruction decoder.
 #   See: 
 #       http://www.z80.info/decoding.htm
 #       http://www.righto.com/2014/10/how-z80s-registers-are-implemented-down.html
@@ -83,25 +83,25 @@ def addr(ext_ticks) :
 # Write the ED extended instruction block.
 #
 def write_ed_ops():
-    l('case 0xED: {')
+    l('_OP(0xed): {')
     inc_indent()
     l('_FETCH(op);')
     l('switch(op) {')
     inc_indent()
     for i in range(0, 256):
-        write_op(enc_ed_op(i))
+        write_op(enc_ed_op(i), False)
     l('default: break;');
     dec_indent()
     l('}')
     dec_indent()
     l('}')
-    l('break;')
+    l('_NEXT()')
 
 #-------------------------------------------------------------------------------
 # Write the CB extended instruction block as 'hand-decoded' ops
 #
 def write_cb_ops():
-    l('case 0xCB: {')
+    l('_OP(0xcb): {')
     inc_indent()
     l('/* special handling for undocumented DD/FD+CB double prefix instructions,')
     l(' these always load the value from memory (IX+d),')
@@ -190,7 +190,7 @@ def write_cb_ops():
     l('_S_F(f);')
     dec_indent()
     l('}')
-    l('break;')
+    l('_NEXT()')
 
 #-------------------------------------------------------------------------------
 #   out_n_a
@@ -1281,11 +1281,24 @@ def enc_cb_op(op) :
 #-------------------------------------------------------------------------------
 # write a single (writes a case inside the current switch)
 #
-def write_op(op) :
+def write_op(op, top_level=True) :
     if op.src :
         if not op.cmt:
             op.cmt='???'
-        l('case '+hex(op.byte)+':/*'+op.cmt+'*/'+op.src+'break;')
+        if top_level:
+            l('_OP('+hex(op.byte)+'):/*'+op.cmt+'*/'+op.src+'_NEXT()')
+        else:
+            l('case '+hex(op.byte)+':/*'+op.cmt+'*/'+op.src+'break;')
+
+#-------------------------------------------------------------------------------
+# write the label address table for computed-goto dispatch, this must
+# match the _OP() labels of the top-level instruction handlers
+#
+def write_dispatch_table():
+    lines = []
+    for i in range(0, 256, 8):
+        lines.append(' '*TabWidth*3 + ','.join('&&_z80_op_'+hex(j) for j in range(i, i+8)) + ',')
+    return '\n'.join(lines)
 
 #-------------------------------------------------------------------------------
 # main encoder function, this populates all the opcode tables and
@@ -1306,6 +1319,6 @@ indent = 0
 
 with open(InpPath, 'r') as inf:
     templ = Template(inf.read())
-    c_src = templ.safe_substitute(decode_block=out_lines)
+    c_src = templ.safe_substitute(decode_block=out_lines, dispatch_table=write_dispatch_table())
     with open(OutPath, 'w') as outf:
         outf.write(c_src)
\ No newline at end of file
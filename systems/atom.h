@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into atom_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until atom_discard() is called, and the
+        macro must be defined in all source files which include atom.h)
+
     You need to include the following headers before including atom.h:
 
+    - chips/chips_state.h
     - chips/m6502.h
     - chips/mc6847.h
     - chips/i8255.h
@@ -127,6 +137,7 @@ typedef struct {
     uint8_t joy_joymask;        /* joystick mask from calls to atom_joystick() */
     uint8_t mmc_cmd;
     uint8_t mmc_latch;
+    clk_t clk;
     mem_t mem;
     kbd_t kbd;
     void* user_data;
@@ -135,9 +146,15 @@ typedef struct {
     int sample_pos;
     float sample_buffer[ATOM_MAX_AUDIO_SAMPLES];
     uint8_t ram[0xA000];
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom_abasic;
+    const uint8_t* rom_afloat;
+    const uint8_t* rom_dosrom;
+#else
     uint8_t rom_abasic[0x2000];
     uint8_t rom_afloat[0x1000];
     uint8_t rom_dosrom[0x1000];
+#endif
     /* tape loading */
     int tape_size;  /* tape_size is > 0 if a tape is inserted */
     int tape_pos;
@@ -199,6 +216,11 @@ static uint64_t _atom_osload(atom_t* sys, uint64_t pins);
 
 #define _ATOM_DEFAULT(val,def) (((val) != 0) ? (val) : (def))
 #define _ATOM_CLEAR(val) memset(&val, 0, sizeof(val))
+#if defined(CHIPS_SHARED_ROMS)
+#define _ATOM_ROM(dst,src,size) dst = (const uint8_t*)(src)
+#else
+#define _ATOM_ROM(dst,src,size) memcpy(dst, src, size)
+#endif
 
 void atom_init(atom_t* sys, const atom_desc_t* desc) {
     CHIPS_ASSERT(sys && desc);
@@ -211,12 +233,12 @@ void atom_init(atom_t* sys, const atom_desc_t* desc) {
     sys->audio_cb = desc->audio_cb;
     sys->num_samples = _ATOM_DEFAULT(desc->audio_num_samples, ATOM_DEFAULT_AUDIO_SAMPLES);
     CHIPS_ASSERT(sys->num_samples <= ATOM_MAX_AUDIO_SAMPLES);
-    CHIPS_ASSERT(desc->rom_abasic && (desc->rom_abasic_size == sizeof(sys->rom_abasic)));
-    memcpy(sys->rom_abasic, desc->rom_abasic, sizeof(sys->rom_abasic));
-    CHIPS_ASSERT(desc->rom_afloat && (desc->rom_afloat_size == sizeof(sys->rom_afloat)));
-    memcpy(&sys->rom_afloat, desc->rom_afloat, sizeof(sys->rom_afloat));
-    CHIPS_ASSERT(desc->rom_dosrom && (desc->rom_dosrom_size == sizeof(sys->rom_dosrom)));
-    memcpy(&sys->rom_dosrom, desc->rom_dosrom, sizeof(sys->rom_dosrom));
+    CHIPS_ASSERT(desc->rom_abasic && (desc->rom_abasic_size == 0x2000));
+    _ATOM_ROM(sys->rom_abasic, desc->rom_abasic, 0x2000);
+    CHIPS_ASSERT(desc->rom_afloat && (desc->rom_afloat_size == 0x1000));
+    _ATOM_ROM(sys->rom_afloat, desc->rom_afloat, 0x1000);
+    CHIPS_ASSERT(desc->rom_dosrom && (desc->rom_dosrom_size == 0x1000));
+    _ATOM_ROM(sys->rom_dosrom, desc->rom_dosrom, 0x1000);
 
     /* initialize the hardware */
     sys->period_2_4khz = ATOM_FREQUENCY / 4800;
@@ -224,6 +246,7 @@ void atom_init(atom_t* sys, const atom_desc_t* desc) {
     m6502_desc_t cpu_desc;
     _ATOM_CLEAR(cpu_desc);
     sys->pins = m6502_init(&sys->cpu, &cpu_desc);
+    clk_init(&sys->clk, ATOM_FREQUENCY);
 
     mc6847_desc_t vdg_desc;
     _ATOM_CLEAR(vdg_desc);
@@ -291,10 +314,11 @@ void atom_tick(atom_t* sys) {
 
 void atom_exec(atom_t* sys, uint32_t micro_seconds) {
     CHIPS_ASSERT(sys && sys->valid);
-    uint32_t num_ticks = clk_us_to_ticks(ATOM_FREQUENCY, micro_seconds);
+    uint32_t num_ticks = clk_ticks_to_run(&sys->clk, micro_seconds);
     for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
         sys->pins = _atom_tick(sys, sys->pins);
     }
+    clk_ticks_executed(&sys->clk, num_ticks);
     kbd_update(&sys->kbd, micro_seconds);
 }
 
@@ -0,0 +1,1073 @@
+#pragma once
+/*#
+    # ayplayer.h
+
+    A player for AY-3-8910/YM2149 register dump files (YM, PSG and VTX)
+    in a C header.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    ayplayer_render_batch() runs on the worker threads of util/batch.h
+    (Win32 threads on Windows, pthreads everywhere else, link with -pthread).
+
+    You need to include the following headers before including ayplayer.h:
+
+    - chips/chips_state.h
+    - chips/ay38910.h
+    - chips/clk.h
+    - util/batch.h
+
+    ## Overview
+
+    The AY player only runs the ay38910 sound chip emulation, and writes
+    the register values from a register dump file into the chip once per
+    player frame. There's no CPU and no video emulation, so rendering
+    audio is many times faster than realtime.
+
+    Player frames are distributed over the chip clock without accumulating
+    rounding errors (frame n starts at chip tick n * clock_hz / frame_rate).
+
+    The following file formats are supported:
+
+    - **YM3!**, **YM3b**, **YM5!** and **YM6!**: the YM formats of StSound,
+      usually packed into an LHA archive with the -lh5- method, packed and
+      unpacked files are both accepted
+    - **PSG**: the register stream format of the ZX Spectrum and MSX emulators
+    - **VTX**: the Vortex Tracker format, the register data is always
+      packed with the -lh5- method
+
+    ## Usage
+
+    Packed files are unpacked into a work buffer provided by the caller,
+    this must be big enough for the unpacked register data (a few hundred
+    KBytes are enough for most files). Unpacked files are played directly
+    from the file data, so the file data must remain valid until another
+    file is loaded.
+
+    ~~~C
+    static uint8_t work_buffer[1<<20];
+    ayplayer_t player;
+    ayplayer_init(&player, &(ayplayer_desc_t){
+        .audio_sample_rate = 44100,
+        .work_buffer = work_buffer,
+        .work_buffer_size = sizeof(work_buffer)
+    });
+    if (ayplayer_load(&player, data, num_bytes)) {
+        while (!ayplayer_finished(&player)) {
+            ayplayer_render(&player, samples, 4096);
+            ...
+        }
+    }
+    ~~~
+
+    ## Batch rendering
+
+    ayplayer_render_batch() renders a list of files into caller-provided
+    sample buffers on several threads. The caller also provides the
+    ayplayer_t instances and one ayplayer_desc_t per instance, each desc
+    must have its own work buffer. The first instance runs on the calling
+    thread. Each thread picks the next unrendered job from the list until
+    all jobs are done, so long and short files are balanced automatically:
+
+    ~~~C
+    static ayplayer_t players[4];
+    static uint8_t work_buffers[4][1<<20];
+    ayplayer_desc_t descs[4];
+    for (int i = 0; i < 4; i++) {
+        descs[i] = (ayplayer_desc_t){
+            .audio_sample_rate = 44100,
+            .work_buffer = work_buffers[i],
+            .work_buffer_size = sizeof(work_buffers[i])
+        };
+    }
+    ayplayer_job_t jobs[NUM_FILES] = { ... };  // data, num_bytes, buffer, num_samples
+    int num_ok = ayplayer_render_batch(players, descs, 4, jobs, NUM_FILES);
+    ~~~
+
+    An ayplayer_t instance contains the entire player state and doesn't use
+    any global state, so separate ayplayer_t instances (each with its own
+    work buffer) may also be driven from your own threads without calling
+    ayplayer_render_batch().
+
+    ## Limitations
+
+    - the special effects of the YM5 and YM6 formats (digidrums, SID voice,
+      sync buzzer) are ignored, the 'future data' header extension is skipped
+    - YM2!, YM4! and the MIX/YMT formats are not supported
+    - output is mono, the VTX stereo mode is ignored
+    - YM2149 specifics (like the finer envelope steps) are not emulated
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AYPLAYER_MAX_AUDIO_SAMPLES (1024)       /* max number of audio samples in internal sample buffer */
+#define AYPLAYER_DEFAULT_AUDIO_SAMPLES (128)    /* default number of samples in internal sample buffer */
+#define AYPLAYER_DEFAULT_CLOCK_HZ (1773400)     /* default chip clock for PSG files (ZX Spectrum 128) */
+#define AYPLAYER_DEFAULT_FRAME_RATE (50)        /* default player frame rate for PSG files */
+#define AYPLAYER_MAX_STRING (64)                /* max length of info strings (including zero) */
+
+/* register dump file formats */
+typedef enum {
+    AYPLAYER_FORMAT_NONE = 0,
+    AYPLAYER_FORMAT_YM,
+    AYPLAYER_FORMAT_PSG,
+    AYPLAYER_FORMAT_VTX,
+} ayplayer_format_t;
+
+/* audio sample data callback */
+typedef void (*ayplayer_audio_callback_t)(const float* samples, int num_samples, void* user_data);
+
+/* config parameters for ayplayer_init() */
+typedef struct {
+    /* optional user-data for callback functions */
+    void* user_data;
+
+    /* audio output config (if you don't want audio, set audio_cb to zero) */
+    ayplayer_audio_callback_t audio_cb; /* called when audio_num_samples are ready */
+    int audio_num_samples;          /* default is AYPLAYER_DEFAULT_AUDIO_SAMPLES */
+    int audio_sample_rate;          /* playback sample rate in Hz, default is 44100 */
+    float audio_volume;             /* audio volume (0.0 .. 1.0), default is 1.0 */
+
+    /* chip clock and frame rate for formats which don't define them (PSG) */
+    int clock_hz;                   /* default is AYPLAYER_DEFAULT_CLOCK_HZ */
+    int frame_rate;                 /* default is AYPLAYER_DEFAULT_FRAME_RATE */
+    bool loop;                      /* true to restart at the loop frame at the end */
+
+    /* work buffer for unpacking LHA-compressed data */
+    void* work_buffer;
+    int work_buffer_size;
+} ayplayer_desc_t;
+
+/* a file to render with ayplayer_render_batch() */
+typedef struct {
+    const uint8_t* data;        /* YM, PSG or VTX file content */
+    int num_bytes;              /* size of the file content in bytes */
+    float* buffer;              /* destination buffer for num_samples samples */
+    int num_samples;            /* number of samples to render */
+    bool ok;                    /* set to false if the file couldn't be loaded (buffer is cleared) */
+} ayplayer_job_t;
+
+/* AY player state */
+typedef struct {
+    ay38910_t ay;
+
+    bool valid;
+    bool finished;              /* true when the end of the register data was reached */
+    bool loop;
+    ayplayer_format_t format;
+    int clock_hz;               /* chip clock of the current file */
+    clk_t clk;
+    int frame_rate;             /* player frame rate of the current file */
+    int default_clock_hz;
+    int default_frame_rate;
+    int sound_hz;
+    float volume;
+    char name[AYPLAYER_MAX_STRING];
+    char author[AYPLAYER_MAX_STRING];
+    char comment[AYPLAYER_MAX_STRING];
+
+    /* YM and VTX register data (one value per frame and register) */
+    const uint8_t* regs;
+    int num_regs;               /* number of registers per frame (14 or 16) */
+    bool interleaved;           /* true: all frames of register 0 first, then register 1, ... */
+    int num_frames;
+    int loop_frame;
+    /* PSG register stream */
+    const uint8_t* stream;
+    int stream_size;
+    int stream_pos;
+    int wait_frames;            /* PSG: number of frames to skip */
+
+    /* frame timing */
+    int frame;                  /* index of the next frame */
+    uint64_t tick_count;        /* chip ticks since start of playback */
+    uint64_t next_frame_tick;   /* chip tick of the next frame */
+
+    uint8_t* work_buffer;
+    int work_buffer_size;
+
+    void* user_data;
+    ayplayer_audio_callback_t audio_cb;
+    int num_samples;
+    int sample_pos;
+    float sample_buffer[AYPLAYER_MAX_AUDIO_SAMPLES];
+    float* render_buf;          /* target buffer of ayplayer_render() */
+    int render_pos;
+    int render_num;
+} ayplayer_t;
+
+/* initialize a new AY player instance */
+void ayplayer_init(ayplayer_t* sys, const ayplayer_desc_t* desc);
+/* discard AY player instance */
+void ayplayer_discard(ayplayer_t* sys);
+/* load a YM, PSG or VTX file and start playback */
+bool ayplayer_load(ayplayer_t* sys, const uint8_t* ptr, int num_bytes);
+/* restart playback from the first frame */
+void ayplayer_reset(ayplayer_t* sys);
+/* tick the AY player for a given number of microseconds */
+void ayplayer_exec(ayplayer_t* sys, uint32_t micro_seconds);
+/* render a number of samples into a buffer (the audio callback isn't called) */
+void ayplayer_render(ayplayer_t* sys, float* buffer, int num_samples);
+/* render a list of files on num_players threads, returns the number of successfully rendered files */
+int ayplayer_render_batch(ayplayer_t* players, const ayplayer_desc_t* descs, int num_players, ayplayer_job_t* jobs, int num_jobs);
+/* return true when the end of a non-looping file was reached */
+bool ayplayer_finished(ayplayer_t* sys);
+/* get the playback duration of the loaded file in player frames (-1 if unknown) */
+int ayplayer_num_frames(ayplayer_t* sys);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h> /* memcpy, memset */
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+#define _AYPLAYER_DEFAULT(val,def) (((val) != 0) ? (val) : (def));
+#define _AYPLAYER_CLEAR(val) memset(&val, 0, sizeof(val))
+
+/* YM format defaults */
+#define _AYPLAYER_YM_CLOCK_HZ (2000000)
+#define _AYPLAYER_YM_FRAME_RATE (50)
+#define _AYPLAYER_YM_INTERLEAVED (1<<0)
+
+/* PSG stream commands */
+#define _AYPLAYER_PSG_END_FRAME (0xFF)
+#define _AYPLAYER_PSG_WAIT (0xFE)
+#define _AYPLAYER_PSG_END (0xFD)
+
+static uint32_t _ayplayer_be32(const uint8_t* ptr) {
+    return ((uint32_t)ptr[0]<<24) | ((uint32_t)ptr[1]<<16) | ((uint32_t)ptr[2]<<8) | ptr[3];
+}
+
+static uint16_t _ayplayer_be16(const uint8_t* ptr) {
+    return (uint16_t) ((ptr[0]<<8) | ptr[1]);
+}
+
+static uint32_t _ayplayer_le32(const uint8_t* ptr) {
+    return ((uint32_t)ptr[3]<<24) | ((uint32_t)ptr[2]<<16) | ((uint32_t)ptr[1]<<8) | ptr[0];
+}
+
+static uint16_t _ayplayer_le16(const uint8_t* ptr) {
+    return (uint16_t) ((ptr[1]<<8) | ptr[0]);
+}
+
+/*  copy a zero-terminated string (truncated to AYPLAYER_MAX_STRING),
+    returns the number of bytes of the source string including the
+    terminating zero, or 0 if the string isn't terminated
+*/
+static int _ayplayer_copy_str(char* dst, const uint8_t* src, int max_bytes) {
+    int i = 0;
+    for (; (i < max_bytes) && src[i]; i++) {
+        if (i < (AYPLAYER_MAX_STRING-1)) {
+            dst[i] = (char) src[i];
+        }
+    }
+    dst[(i < (AYPLAYER_MAX_STRING-1)) ? i : (AYPLAYER_MAX_STRING-1)] = 0;
+    return (i < max_bytes) ? (i + 1) : 0;
+}
+
+/*-- LH5 decompression (LHA -lh5- method) ------------------------------------*/
+
+/*  This is a compact version of the -lh5- decoder from Haruhiko Okumura's
+    public domain 'ar002' archiver. Since the entire output is kept in
+    memory, no separate sliding window is needed.
+*/
+#define _AYPLAYER_LH5_NC (510)      /* number of literal/length codes */
+#define _AYPLAYER_LH5_NP (14)       /* number of distance codes */
+#define _AYPLAYER_LH5_NT (19)       /* number of code length codes */
+#define _AYPLAYER_LH5_NPT (0x80)
+#define _AYPLAYER_LH5_CBIT (9)
+#define _AYPLAYER_LH5_PBIT (4)
+#define _AYPLAYER_LH5_TBIT (5)
+
+typedef struct {
+    const uint8_t* src;
+    int src_size;
+    int src_pos;
+    uint16_t bitbuf;
+    uint8_t subbitbuf;
+    int bitcount;
+    uint16_t blocksize;
+    bool error;
+    uint16_t left[2*_AYPLAYER_LH5_NC-1];
+    uint16_t right[2*_AYPLAYER_LH5_NC-1];
+    uint8_t c_len[_AYPLAYER_LH5_NC];
+    uint8_t pt_len[_AYPLAYER_LH5_NPT];
+    uint16_t c_table[4096];
+    uint16_t pt_table[256];
+} _ayplayer_lh5_t;
+
+static void _ayplayer_lh5_fillbuf(_ayplayer_lh5_t* lh, int n) {
+    lh->bitbuf = (uint16_t)(lh->bitbuf << n);
+    while (n > lh->bitcount) {
+        n -= lh->bitcount;
+        lh->bitbuf |= (uint16_t)(lh->subbitbuf << n);
+        lh->subbitbuf = (lh->src_pos < lh->src_size) ? lh->src[lh->src_pos++] : 0;
+        lh->bitcount = 8;
+    }
+    lh->bitcount -= n;
+    lh->bitbuf |= (uint16_t)(lh->subbitbuf >> lh->bitcount);
+}
+
+static uint16_t _ayplayer_lh5_getbits(_ayplayer_lh5_t* lh, int n) {
+    if (n == 0) {
+        return 0;
+    }
+    const uint16_t x = (uint16_t)(lh->bitbuf >> (16 - n));
+    _ayplayer_lh5_fillbuf(lh, n);
+    return x;
+}
+
+/* build a lookup table and tree for canonical Huffman codes */
+static void _ayplayer_lh5_make_table(_ayplayer_lh5_t* lh, int nchar, const uint8_t* bitlen, int tablebits, uint16_t* table) {
+    uint32_t count[17], weight[17], start[18];
+    memset(count, 0, sizeof(count));
+    for (int i = 0; i < nchar; i++) {
+        if (bitlen[i] > 16) {
+            lh->error = true;
+            return;
+        }
+        count[bitlen[i]]++;
+    }
+    /* the code lengths must form a complete prefix code, the sum is
+       computed in 32 bits so that an over-subscribed set can't wrap around
+    */
+    start[1] = 0;
+    for (int i = 1; i <= 16; i++) {
+        start[i+1] = start[i] + (count[i] << (16 - i));
+    }
+    if (start[17] != (1U << 16)) {
+        lh->error = true;
+        return;
+    }
+    const int jutbits = 16 - tablebits;
+    const uint32_t table_size = 1U << tablebits;
+    const int num_nodes = 2*_AYPLAYER_LH5_NC-1;
+    for (int i = 1; i <= tablebits; i++) {
+        start[i] >>= jutbits;
+        weight[i] = 1U << (tablebits - i);
+    }
+    for (int i = tablebits + 1; i <= 16; i++) {
+        weight[i] = 1U << (16 - i);
+    }
+    uint32_t i = start[tablebits+1] >> jutbits;
+    while (i < table_size) {
+        table[i++] = 0;
+    }
+    int avail = nchar;
+    const uint32_t mask = 1U << (15 - tablebits);
+    for (int ch = 0; ch < nchar; ch++) {
+        const int len = bitlen[ch];
+        if (len == 0) {
+            continue;
+        }
+        const uint32_t nextcode = start[len] + weight[len];
+        if (len <= tablebits) {
+            if (nextcode > table_size) {
+                lh->error = true;
+                return;
+            }
+            for (uint32_t j = start[len]; j < nextcode; j++) {
+                table[j] = (uint16_t)ch;
+            }
+        }
+        else {
+            uint32_t k = start[len];
+            if ((k >> jutbits) >= table_size) {
+                lh->error = true;
+                return;
+            }
+            uint16_t* p = &table[k >> jutbits];
+            for (int n = len - tablebits; n > 0; n--) {
+                if (*p == 0) {
+                    if (avail >= num_nodes) {
+                        lh->error = true;
+                        return;
+                    }
+                    lh->right[avail] = lh->left[avail] = 0;
+                    *p = (uint16_t)avail++;
+                }
+                else if ((*p < nchar) || (*p >= num_nodes)) {
+                    /* an existing leaf or a bogus node index */
+                    lh->error = true;
+                    return;
+                }
+                p = (k & mask) ? &lh->right[*p] : &lh->left[*p];
+                k = (k << 1) & 0xFFFF;
+            }
+            *p = (uint16_t)ch;
+        }
+        start[len] = nextcode;
+    }
+}
+
+static void _ayplayer_lh5_read_pt_len(_ayplayer_lh5_t* lh, int nn, int nbit, int i_special) {
+    const int n = _ayplayer_lh5_getbits(lh, nbit);
+    if (n == 0) {
+        const uint16_t c = _ayplayer_lh5_getbits(lh, nbit);
+        memset(lh->pt_len, 0, (size_t)nn);
+        for (int i = 0; i < 256; i++) {
+            lh->pt_table[i] = c;
+        }
+        return;
+    }
+    if (n > nn) {
+        lh->error = true;
+        return;
+    }
+    int i = 0;
+    while (i < n) {
+        int c = lh->bitbuf >> 13;
+        if (c == 7) {
+            uint16_t mask = 1 << 12;
+            while (mask & lh->bitbuf) {
+                mask >>= 1;
+                c++;
+            }
+            if (c > 16) {
+                lh->error = true;
+                return;
+            }
+        }
+        _ayplayer_lh5_fillbuf(lh, (c < 7) ? 3 : (c - 3));
+        lh->pt_len[i++] = (uint8_t)c;
+        if (i == i_special) {
+            int z = _ayplayer_lh5_getbits(lh, 2);
+            while ((z-- > 0) && (i < nn)) {
+                lh->pt_len[i++] = 0;
+            }
+        }
+    }
+    while (i < nn) {
+        lh->pt_len[i++] = 0;
+    }
+    _ayplayer_lh5_make_table(lh, nn, lh->pt_len, 8, lh->pt_table);
+}
+
+static void _ayplayer_lh5_read_c_len(_ayplayer_lh5_t* lh) {
+    const int n = _ayplayer_lh5_getbits(lh, _AYPLAYER_LH5_CBIT);
+    if (n == 0) {
+        const uint16_t c = _ayplayer_lh5_getbits(lh, _AYPLAYER_LH5_CBIT);
+        memset(lh->c_len, 0, sizeof(lh->c_len));
+        for (int i = 0; i < 4096; i++) {
+            lh->c_table[i] = c;
+        }
+        return;
+    }
+    if (n > _AYPLAYER_LH5_NC) {
+        lh->error = true;
+        return;
+    }
+    int i = 0;
+    while (i < n) {
+        int c = lh->pt_table[lh->bitbuf >> 8];
+        if (c >= _AYPLAYER_LH5_NT) {
+            uint16_t mask = 1 << 7;
+            do {
+                c = (lh->bitbuf & mask) ? lh->right[c] : lh->left[c];
+                mask >>= 1;
+            } while ((c >= _AYPLAYER_LH5_NT) && mask);
+            if (c >= _AYPLAYER_LH5_NT) {
+                lh->error = true;
+                return;
+            }
+        }
+        _ayplayer_lh5_fillbuf(lh, lh->pt_len[c]);
+        if (c <= 2) {
+            int z;
+            if (c == 0) {
+                z = 1;
+            }
+            else if (c == 1) {
+                z = _ayplayer_lh5_getbits(lh, 4) + 3;
+            }
+            else {
+                z = _ayplayer_lh5_getbits(lh, _AYPLAYER_LH5_CBIT) + 20;
+            }
+            while ((z-- > 0) && (i < _AYPLAYER_LH5_NC)) {
+                lh->c_len[i++] = 0;
+            }
+        }
+        else {
+            lh->c_len[i++] = (uint8_t)(c - 2);
+        }
+    }
+    while (i < _AYPLAYER_LH5_NC) {
+        lh->c_len[i++] = 0;
+    }
+    _ayplayer_lh5_make_table(lh, _AYPLAYER_LH5_NC, lh->c_len, 12, lh->c_table);
+}
+
+static int _ayplayer_lh5_decode_c(_ayplayer_lh5_t* lh) {
+    if (lh->blocksize == 0) {
+        lh->blocksize = _ayplayer_lh5_getbits(lh, 16);
+        _ayplayer_lh5_read_pt_len(lh, _AYPLAYER_LH5_NT, _AYPLAYER_LH5_TBIT, 3);
+        if (!lh->error) {
+            _ayplayer_lh5_read_c_len(lh);
+        }
+        if (!lh->error) {
+            _ayplayer_lh5_read_pt_len(lh, _AYPLAYER_LH5_NP, _AYPLAYER_LH5_PBIT, -1);
+        }
+        if (lh->error) {
+            return 0;
+        }
+    }
+    lh->blocksize--;
+    int j = lh->c_table[lh->bitbuf >> 4];
+    if (j >= _AYPLAYER_LH5_NC) {
+        uint16_t mask = 1 << 3;
+        do {
+            j = (lh->bitbuf & mask) ? lh->right[j] : lh->left[j];
+            mask >>= 1;
+        } while ((j >= _AYPLAYER_LH5_NC) && mask);
+        if (j >= _AYPLAYER_LH5_NC) {
+            lh->error = true;
+            return 0;
+        }
+    }
+    _ayplayer_lh5_fillbuf(lh, lh->c_len[j]);
+    return j;
+}
+
+static int _ayplayer_lh5_decode_p(_ayplayer_lh5_t* lh) {
+    int j = lh->pt_table[lh->bitbuf >> 8];
+    if (j >= _AYPLAYER_LH5_NP) {
+        uint16_t mask = 1 << 7;
+        do {
+            j = (lh->bitbuf & mask) ? lh->right[j] : lh->left[j];
+            mask >>= 1;
+        } while ((j >= _AYPLAYER_LH5_NP) && mask);
+        if (j >= _AYPLAYER_LH5_NP) {
+            lh->error = true;
+            return 0;
+        }
+    }
+    _ayplayer_lh5_fillbuf(lh, lh->pt_len[j]);
+    if (j != 0) {
+        j = (1 << (j - 1)) + _ayplayer_lh5_getbits(lh, j - 1);
+    }
+    return j;
+}
+
+/* decompress -lh5- data, returns false on corrupt data */
+static bool _ayplayer_lh5_decode(const uint8_t* src, int src_size, uint8_t* dst, int dst_size) {
+    _ayplayer_lh5_t lh;
+    _AYPLAYER_CLEAR(lh);
+    lh.src = src;
+    lh.src_size = src_size;
+    _ayplayer_lh5_fillbuf(&lh, 16);
+    int pos = 0;
+    while (pos < dst_size) {
+        const int c = _ayplayer_lh5_decode_c(&lh);
+        if (lh.error) {
+            return false;
+        }
+        if (c < 256) {
+            dst[pos++] = (uint8_t)c;
+        }
+        else {
+            int len = c - (256 - 3);
+            const int dist = _ayplayer_lh5_decode_p(&lh) + 1;
+            if (lh.error || (dist > pos)) {
+                return false;
+            }
+            for (; (len > 0) && (pos < dst_size); len--, pos++) {
+                dst[pos] = dst[pos - dist];
+            }
+        }
+    }
+    return true;
+}
+
+/*  unpack a file from an LHA archive into the work buffer (only the first
+    file is considered), returns the unpacked size, 0 if this isn't an
+    LHA archive, or -1 on error
+*/
+static int _ayplayer_unpack_lha(ayplayer_t* sys, const uint8_t* ptr, int num_bytes) {
+    if ((num_bytes < 22) || (ptr[2] != '-') || (ptr[3] != 'l') || (ptr[4] != 'h') || (ptr[6] != '-')) {
+        return 0;
+    }
+    const int method = ptr[5];
+    if ((method != '0') && (method != '5')) {
+        return -1;
+    }
+    int packed_size = (int)_ayplayer_le32(ptr + 7);
+    const int unpacked_size = (int)_ayplayer_le32(ptr + 11);
+    const int level = ptr[20];
+    int pos;
+    if (level == 2) {
+        pos = _ayplayer_le16(ptr);
+        if (pos > num_bytes) {
+            return -1;
+        }
+    }
+    else {
+        pos = ptr[0] + 2;
+        if (level == 1) {
+            /* skip extended headers, their size is included in the packed size */
+            int next = (pos <= num_bytes) ? _ayplayer_le16(ptr + pos - 2) : 0;
+            while ((next > 0) && ((pos + next) <= num_bytes)) {
+                packed_size -= next;
+                pos += next;
+                next = _ayplayer_le16(ptr + pos - 2);
+            }
+        }
+        else if (level != 0) {
+            return -1;
+        }
+    }
+    if ((unpacked_size <= 0) || (packed_size < 0) || (packed_size > (num_bytes - pos))) {
+        return -1;
+    }
+    if (!sys->work_buffer || (unpacked_size > sys->work_buffer_size)) {
+        return -1;
+    }
+    if (method == '0') {
+        if (packed_size != unpacked_size) {
+            return -1;
+        }
+        memcpy(sys->work_buffer, ptr + pos, (size_t)unpacked_size);
+    }
+    else if (!_ayplayer_lh5_decode(ptr + pos, packed_size, sys->work_buffer, unpacked_size)) {
+        return -1;
+    }
+    return unpacked_size;
+}
+
+/*-- file format parsers -----------------------------------------------------*/
+
+static bool _ayplayer_parse_ym(ayplayer_t* sys, const uint8_t* ptr, int num_bytes) {
+    if ((num_bytes < 4) || (ptr[0] != 'Y') || (ptr[1] != 'M')) {
+        return false;
+    }
+    sys->format = AYPLAYER_FORMAT_YM;
+    sys->clock_hz = _AYPLAYER_YM_CLOCK_HZ;
+    sys->frame_rate = _AYPLAYER_YM_FRAME_RATE;
+    if ((ptr[2] == '3') && ((ptr[3] == '!') || (ptr[3] == 'b'))) {
+        /* YM3!: 14 interleaved registers per frame, YM3b: followed by the loop frame */
+        const int tail = (ptr[3] == 'b') ? 4 : 0;
+        sys->regs = ptr + 4;
+        sys->num_regs = 14;
+        sys->interleaved = true;
+        if (num_bytes < (4 + tail)) {
+            return false;
+        }
+        sys->num_frames = (num_bytes - 4 - tail) / 14;
+        sys->loop_frame = tail ? (int)_ayplayer_le32(ptr + num_bytes - 4) : 0;
+    }
+    else if (((ptr[2] == '5') || (ptr[2] == '6')) && (ptr[3] == '!')) {
+        if ((num_bytes < 34) || (0 != memcmp(ptr + 4, "LeOnArD!", 8))) {
+            return false;
+        }
+        sys->num_frames = (int)_ayplayer_be32(ptr + 12);
+        const uint32_t attrs = _ayplayer_be32(ptr + 16);
+        const int num_drums = _ayplayer_be16(ptr + 20);
+        sys->clock_hz = (int)_ayplayer_be32(ptr + 22);
+        sys->frame_rate = _ayplayer_be16(ptr + 26);
+        sys->loop_frame = (int)_ayplayer_be32(ptr + 28);
+        int pos = 34 + _ayplayer_be16(ptr + 32);
+        if (pos > num_bytes) {
+            return false;
+        }
+        /* skip the digidrum samples */
+        for (int i = 0; i < num_drums; i++) {
+            if ((pos + 4) > num_bytes) {
+                return false;
+            }
+            const uint32_t drum_size = _ayplayer_be32(ptr + pos);
+            if (drum_size > (uint32_t)(num_bytes - pos - 4)) {
+                return false;
+            }
+            pos += 4 + (int)drum_size;
+        }
+        char* strings[3] = { sys->name, sys->author, sys->comment };
+        for (int i = 0; i < 3; i++) {
+            const int len = (pos < num_bytes) ? _ayplayer_copy_str(strings[i], ptr + pos, num_bytes - pos) : 0;
+            if (len == 0) {
+                return false;
+            }
+            pos += len;
+        }
+        sys->regs = ptr + pos;
+        sys->num_regs = 16;
+        sys->interleaved = 0 != (attrs & _AYPLAYER_YM_INTERLEAVED);
+        if ((sys->num_frames < 0) || ((num_bytes - pos) / 16) < sys->num_frames) {
+            return false;
+        }
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+static bool _ayplayer_parse_psg(ayplayer_t* sys, const uint8_t* ptr, int num_bytes) {
+    if ((num_bytes < 16) || (0 != memcmp(ptr, "PSG\x1A", 4))) {
+        return false;
+    }
+    sys->format = AYPLAYER_FORMAT_PSG;
+    sys->clock_hz = sys->default_clock_hz;
+    sys->frame_rate = sys->default_frame_rate;
+    /* version 10 and later store the frame rate */
+    if ((ptr[4] >= 10) && (ptr[5] != 0)) {
+        sys->frame_rate = ptr[5];
+    }
+    sys->stream = ptr + 16;
+    sys->stream_size = num_bytes - 16;
+    sys->num_frames = -1;
+    return true;
+}
+
+static bool _ayplayer_parse_vtx(ayplayer_t* sys, const uint8_t* ptr, int num_bytes) {
+    if (num_bytes < 16) {
+        return false;
+    }
+    const bool ay = (ptr[0] == 'a') && (ptr[1] == 'y');
+    const bool ym = (ptr[0] == 'y') && (ptr[1] == 'm');
+    if (!(ay || ym)) {
+        return false;
+    }
+    sys->format = AYPLAYER_FORMAT_VTX;
+    sys->loop_frame = _ayplayer_le16(ptr + 3);
+    sys->clock_hz = (int)_ayplayer_le32(ptr + 5);
+    sys->frame_rate = ptr[9];
+    const int unpacked_size = (int)_ayplayer_le32(ptr + 12);
+    /* title, author, program, tracker and comment strings */
+    char dummy[AYPLAYER_MAX_STRING];
+    char* strings[5] = { sys->name, sys->author, dummy, dummy, sys->comment };
+    int pos = 16;
+    for (int i = 0; i < 5; i++) {
+        const int len = (pos < num_bytes) ? _ayplayer_copy_str(strings[i], ptr + pos, num_bytes - pos) : 0;
+        if (len == 0) {
+            return false;
+        }
+        pos += len;
+    }
+    if ((unpacked_size <= 0) || !sys->work_buffer || (unpacked_size > sys->work_buffer_size)) {
+        return false;
+    }
+    if (!_ayplayer_lh5_decode(ptr + pos, num_bytes - pos, sys->work_buffer, unpacked_size)) {
+        return false;
+    }
+    sys->regs = sys->work_buffer;
+    sys->num_regs = 14;
+    sys->interleaved = true;
+    sys->num_frames = unpacked_size / 14;
+    return true;
+}
+
+/*-- playback ----------------------------------------------------------------*/
+
+/* write a chip register through the chip's bus interface */
+static void _ayplayer_write(ayplayer_t* sys, uint8_t reg, uint8_t val) {
+    uint64_t pins = AY38910_BDIR|AY38910_BC1;
+    AY38910_SET_DATA(pins, reg);
+    ay38910_iorq(&sys->ay, pins);
+    pins = AY38910_BDIR;
+    AY38910_SET_DATA(pins, val);
+    ay38910_iorq(&sys->ay, pins);
+}
+
+/* write the registers of a YM or VTX frame */
+static void _ayplayer_write_frame(ayplayer_t* sys, int frame) {
+    for (int r = 0; r < 14; r++) {
+        const int i = sys->interleaved ? (r * sys->num_frames + frame) : (frame * sys->num_regs + r);
+        const uint8_t val = sys->regs[i];
+        /* a value of 0xFF in the envelope shape register means 'unchanged' */
+        if ((r != AY38910_REG_ENV_SHAPE_CYCLE) || (val != 0xFF)) {
+            _ayplayer_write(sys, (uint8_t)r, val);
+        }
+    }
+}
+
+/* process the PSG register stream up to the end of the next frame */
+static void _ayplayer_psg_frame(ayplayer_t* sys) {
+    if (sys->wait_frames > 0) {
+        sys->wait_frames--;
+        return;
+    }
+    while (sys->stream_pos < sys->stream_size) {
+        const uint8_t cmd = sys->stream[sys->stream_pos++];
+        if (cmd == _AYPLAYER_PSG_END_FRAME) {
+            return;
+        }
+        else if (cmd == _AYPLAYER_PSG_WAIT) {
+            if (sys->stream_pos < sys->stream_size) {
+                sys->wait_frames = sys->stream[sys->stream_pos++] * 4 - 1;
+            }
+            return;
+        }
+        else if ((cmd < AY38910_NUM_REGISTERS) && (sys->stream_pos < sys->stream_size)) {
+            const uint8_t val = sys->stream[sys->stream_pos++];
+            /* the IO port registers are ignored */
+            if (cmd < AY38910_REG_IO_PORT_A) {
+                _ayplayer_write(sys, cmd, val);
+            }
+        }
+        else {
+            break;
+        }
+    }
+    /* end of stream (or an unknown command) */
+    sys->finished = true;
+    ay38910_reset(&sys->ay);
+}
+
+/* start the next player frame */
+static void _ayplayer_next_frame(ayplayer_t* sys) {
+    if (sys->finished) {
+        return;
+    }
+    if (sys->format == AYPLAYER_FORMAT_PSG) {
+        _ayplayer_psg_frame(sys);
+    }
+    else if (sys->format != AYPLAYER_FORMAT_NONE) {
+        if (sys->frame >= sys->num_frames) {
+            if (sys->loop && (sys->loop_frame < sys->num_frames)) {
+                sys->frame = sys->loop_frame;
+            }
+            else {
+                sys->finished = true;
+                ay38910_reset(&sys->ay);
+                return;
+            }
+        }
+        _ayplayer_write_frame(sys, sys->frame);
+    }
+    sys->frame++;
+    sys->next_frame_tick = ((uint64_t)sys->frame * (uint64_t)sys->clock_hz) / (uint64_t)sys->frame_rate;
+}
+
+static void _ayplayer_start(ayplayer_t* sys) {
+    ay38910_desc_t ay_desc;
+    _AYPLAYER_CLEAR(ay_desc);
+    ay_desc.type = AY38910_TYPE_8912;
+    ay_desc.tick_hz = sys->clock_hz;
+    ay_desc.sound_hz = sys->sound_hz;
+    ay_desc.magnitude = sys->volume;
+    ay38910_init(&sys->ay, &ay_desc);
+    clk_init(&sys->clk, (uint32_t)sys->clock_hz);
+    sys->finished = false;
+    sys->frame = 0;
+    sys->stream_pos = 0;
+    sys->wait_frames = 0;
+    sys->tick_count = 0;
+    sys->sample_pos = 0;
+    _ayplayer_next_frame(sys);
+}
+
+void ayplayer_init(ayplayer_t* sys, const ayplayer_desc_t* desc) {
+    CHIPS_ASSERT(sys && desc);
+    CHIPS_ASSERT(!desc->work_buffer || (desc->work_buffer_size > 0));
+
+    memset(sys, 0, sizeof(ayplayer_t));
+    sys->valid = true;
+    sys->loop = desc->loop;
+    sys->user_data = desc->user_data;
+    sys->audio_cb = desc->audio_cb;
+    sys->num_samples = _AYPLAYER_DEFAULT(desc->audio_num_samples, AYPLAYER_DEFAULT_AUDIO_SAMPLES);
+    CHIPS_ASSERT(sys->num_samples <= AYPLAYER_MAX_AUDIO_SAMPLES);
+    sys->sound_hz = _AYPLAYER_DEFAULT(desc->audio_sample_rate, 44100);
+    sys->volume = _AYPLAYER_DEFAULT(desc->audio_volume, 1.0f);
+    sys->default_clock_hz = _AYPLAYER_DEFAULT(desc->clock_hz, AYPLAYER_DEFAULT_CLOCK_HZ);
+    sys->default_frame_rate = _AYPLAYER_DEFAULT(desc->frame_rate, AYPLAYER_DEFAULT_FRAME_RATE);
+    sys->work_buffer = (uint8_t*) desc->work_buffer;
+    sys->work_buffer_size = desc->work_buffer_size;
+
+    /* without a file, the chip just produces silence */
+    sys->clock_hz = sys->default_clock_hz;
+    sys->frame_rate = sys->default_frame_rate;
+    _ayplayer_start(sys);
+}
+
+void ayplayer_discard(ayplayer_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    sys->valid = false;
+}
+
+bool ayplayer_load(ayplayer_t* sys, const uint8_t* ptr, int num_bytes) {
+    CHIPS_ASSERT(sys && sys->valid && ptr);
+    sys->format = AYPLAYER_FORMAT_NONE;
+    sys->regs = 0;
+    sys->stream = 0;
+    sys->stream_size = 0;
+    sys->num_frames = 0;
+    sys->loop_frame = 0;
+    sys->name[0] = sys->author[0] = sys->comment[0] = 0;
+
+    /* YM files are usually packed into an LHA archive */
+    const int unpacked_size = _ayplayer_unpack_lha(sys, ptr, num_bytes);
+    if (unpacked_size < 0) {
+        return false;
+    }
+    else if (unpacked_size > 0) {
+        ptr = sys->work_buffer;
+        num_bytes = unpacked_size;
+    }
+    bool ok = _ayplayer_parse_ym(sys, ptr, num_bytes) ||
+              _ayplayer_parse_psg(sys, ptr, num_bytes) ||
+              _ayplayer_parse_vtx(sys, ptr, num_bytes);
+    if (ok && ((sys->clock_hz <= 1) || (sys->frame_rate <= 0))) {
+        ok = false;
+    }
+    /* an out-of-range loop frame restarts at the first frame */
+    if (ok && ((sys->loop_frame < 0) || ((sys->num_frames >= 0) && (sys->loop_frame >= sys->num_frames)))) {
+        sys->loop_frame = 0;
+    }
+    if (!ok) {
+        sys->format = AYPLAYER_FORMAT_NONE;
+        sys->clock_hz = sys->default_clock_hz;
+        sys->frame_rate = sys->default_frame_rate;
+    }
+    _ayplayer_start(sys);
+    return ok;
+}
+
+void ayplayer_reset(ayplayer_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    _ayplayer_start(sys);
+}
+
+bool ayplayer_finished(ayplayer_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    return sys->finished;
+}
+
+int ayplayer_num_frames(ayplayer_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    return sys->num_frames;
+}
+
+static inline void _ayplayer_tick(ayplayer_t* sys) {
+    if (ay38910_tick(&sys->ay)) {
+        /* new audio sample ready */
+        if (sys->render_buf) {
+            if (sys->render_pos < sys->render_num) {
+                sys->render_buf[sys->render_pos++] = sys->ay.sample;
+            }
+        }
+        else {
+            sys->sample_buffer[sys->sample_pos++] = sys->ay.sample;
+            if (sys->sample_pos == sys->num_samples) {
+                if (sys->audio_cb) {
+                    sys->audio_cb(sys->sample_buffer, sys->num_samples, sys->user_data);
+                }
+                sys->sample_pos = 0;
+            }
+        }
+    }
+    if (++sys->tick_count == sys->next_frame_tick) {
+        _ayplayer_next_frame(sys);
+    }
+}
+
+void ayplayer_exec(ayplayer_t* sys, uint32_t micro_seconds) {
+    CHIPS_ASSERT(sys && sys->valid);
+    uint32_t num_ticks = clk_ticks_to_run(&sys->clk, micro_seconds);
+    for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
+        _ayplayer_tick(sys);
+    }
+    clk_ticks_executed(&sys->clk, num_ticks);
+}
+
+void ayplayer_render(ayplayer_t* sys, float* buffer, int num_samples) {
+    CHIPS_ASSERT(sys && sys->valid && buffer && (num_samples >= 0));
+    sys->render_buf = buffer;
+    sys->render_pos = 0;
+    sys->render_num = num_samples;
+    while (sys->render_pos < num_samples) {
+        _ayplayer_tick(sys);
+    }
+    sys->render_buf = 0;
+}
+
+/*=== batch rendering ========================================================*/
+typedef struct {
+    ayplayer_t* players;
+    ayplayer_job_t* jobs;
+} _ayplayer_batch_t;
+
+static bool _ayplayer_batch_job(int worker_index, int job_index, void* user_data) {
+    _ayplayer_batch_t* batch = (_ayplayer_batch_t*) user_data;
+    ayplayer_t* player = &batch->players[worker_index];
+    ayplayer_job_t* job = &batch->jobs[job_index];
+    job->ok = ayplayer_load(player, job->data, job->num_bytes);
+    if (job->ok) {
+        ayplayer_render(player, job->buffer, job->num_samples);
+    }
+    else {
+        memset(job->buffer, 0, (size_t)job->num_samples * sizeof(float));
+    }
+    return job->ok;
+}
+
+int ayplayer_render_batch(ayplayer_t* players, const ayplayer_desc_t* descs, int num_players, ayplayer_job_t* jobs, int num_jobs) {
+    CHIPS_ASSERT(players && descs && (num_players > 0) && (num_players <= BATCH_MAX_WORKERS));
+    CHIPS_ASSERT((jobs || (num_jobs == 0)) && (num_jobs >= 0));
+    /* the players unpack into their work buffers, so these can't be shared */
+    for (int i = 0; i < num_players; i++) {
+        for (int j = i + 1; j < num_players; j++) {
+            CHIPS_ASSERT(!descs[i].work_buffer || (descs[i].work_buffer != descs[j].work_buffer));
+        }
+    }
+    for (int i = 0; i < num_jobs; i++) {
+        CHIPS_ASSERT(jobs[i].data && jobs[i].buffer && (jobs[i].num_samples >= 0));
+    }
+    for (int i = 0; i < num_players; i++) {
+        ayplayer_init(&players[i], &descs[i]);
+    }
+    _ayplayer_batch_t batch;
+    batch.players = players;
+    batch.jobs = jobs;
+    batch_desc_t batch_desc;
+    memset(&batch_desc, 0, sizeof(batch_desc));
+    batch_desc.num_workers = num_players;
+    batch_desc.num_jobs = num_jobs;
+    batch_desc.job_cb = _ayplayer_batch_job;
+    batch_desc.user_data = &batch;
+    int num_ok = batch_run(&batch_desc);
+    for (int i = 0; i < num_players; i++) {
+        ayplayer_discard(&players[i]);
+    }
+    return num_ok;
+}
+#endif /* CHIPS_IMPL */
@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into bombjack_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until bombjack_discard() is called, and the
+        macro must be defined in all source files which include bombjack.h)
+
     You need to include the following headers before including bombjack.h:
 
+    - chips/chips_state.h
     - chips/z80.h
     - chips/ay38910.h
     - chips/clk.h
@@ -32,6 +42,79 @@
         - https://floooh.github.io/2018/10/06/bombjack.html
         - https://github.com/floooh/emu-info/blob/master/misc/bombjack-schematics.pdf
         
+    ## Batched Execution
+
+    For workloads which run many machines side by side (for instance
+    reinforcement learning agents), bombjack_exec_batch() runs an array of
+    bombjack_t instances for the same amount of emulated time in one call.
+
+    The instances are executed one after another by the regular Z80
+    emulator, so they may freely diverge in RAM contents, inputs and
+    control flow. Instances without an audio callback are run 'headless':
+    the entire sound board (sound CPU and the 3 AY-3-8910 chips) is skipped,
+    the main board only writes to the sound latch and never reads anything
+    back from the sound board, so the game logic is unaffected.
+
+    While running headless the sound board is paused: its CPU and sound
+    chips keep their state, and its clock is advanced together with the
+    main board's clock, so an instance can switch back to bombjack_exec()
+    at any time without the sound board running behind. Sound commands
+    written during headless frames are not played, except that the last
+    command is still in the sound latch when the sound board resumes.
+
+    ## Reinforcement Learning Environment
+
+    bombjack_step() replaces the joystick and system input bits with an
+    action, runs the machine for an exact number of frames, and optionally
+    renders a low-resolution observation directly from the background
+    map ROM, video/color RAM and sprite RAM:
+
+    ~~~C
+    uint8_t obs[BOMBJACK_OBS_SIZE];
+    bombjack_step_t step = {
+        .p1 = BOMBJACK_JOYSTICK_LEFT|BOMBJACK_JOYSTICK_BUTTON,
+        .num_frames = 4,
+        .obs = obs,
+    };
+    bombjack_step(&sys, &step);
+    ~~~
+
+    The observation is the 256x256 display downscaled by 4 in each
+    direction (BOMBJACK_OBS_WIDTH x BOMBJACK_OBS_HEIGHT bytes), each byte
+    is a palette index (0..127). Each 4x4 pixel block gets the most frequent
+    non-zero pen of the underlying tile, char or sprite, the reduced
+    images are precomputed in bombjack_init().
+
+    The score and lives counters are read from main board RAM addresses
+    declared in bombjack_desc_t (score_addr, score_size, score_msb_first
+    and lives_addr). The score is expected in BCD format.
+
+    Like bombjack_exec_batch(), bombjack_step() skips the sound board
+    if no audio callback has been provided.
+
+    ## Run-Ahead
+
+    bombjack_exec_runahead() is called instead of bombjack_exec() and
+    bombjack_decode_video() once per frame, and reduces the perceived
+    input latency by presenting a frame from the near future:
+
+    ~~~C
+    static bombjack_snapshot_t snapshot;
+    ...
+    // once per host frame, after applying the input
+    bombjack_exec_runahead(&sys, &snapshot, frame_time_us, 2);
+    ~~~
+
+    After running the real frame (both boards), the state is saved to
+    the snapshot, the main board alone is run ahead for the given number
+    of frames, the last of those frames is decoded into the pixel buffer,
+    and the state is rolled back by loading the snapshot.
+
+    bombjack_save_snapshot() and bombjack_load_snapshot() copy the
+    bombjack_t struct with memcpy() (which is smaller with CHIPS_SHARED_ROMS).
+    Since snapshots can only be loaded into the instance they were saved
+    from, no internal pointers need to be fixed up.
+
     ## zlib/libpng license
 
     Copyright (c) 2018 Andre Weissflog
@@ -60,6 +143,11 @@ extern "C" {
 #define BOMBJACK_MAX_AUDIO_SAMPLES (1024)
 #define BOMBJACK_DEFAULT_AUDIO_SAMPLES (128)
 
+/* size of the downscaled observation rendered by bombjack_step() */
+#define BOMBJACK_OBS_WIDTH (64)
+#define BOMBJACK_OBS_HEIGHT (64)
+#define BOMBJACK_OBS_SIZE (BOMBJACK_OBS_WIDTH*BOMBJACK_OBS_HEIGHT)
+
 /* joystick mask bits */
 #define BOMBJACK_JOYSTICK_RIGHT (1<<0)
 #define BOMBJACK_JOYSTICK_LEFT (1<<1)
@@ -172,8 +260,30 @@ typedef struct {
     int rom_sprites_2000_3FFF_size;
     int rom_sprites_4000_5FFF_size;
     int rom_maps_0000_0FFF_size;
+
+    /* optional main board RAM locations of score and lives for bombjack_step() */
+    uint16_t score_addr;        /* address of the score in BCD format */
+    int score_size;             /* number of score bytes (0 if no score) */
+    bool score_msb_first;       /* true if the highest score byte comes first */
+    uint16_t lives_addr;        /* address of the lives counter (0 if none) */
 } bombjack_desc_t;
 
+/* in/out parameters for bombjack_step() */
+typedef struct {
+    /* in: joystick 1 bits (BOMBJACK_JOYSTICK_*) held down during the step */
+    uint8_t p1;
+    /* in: system bits (BOMBJACK_SYS_*) held down during the step */
+    uint8_t sys;
+    /* in: number of frames to run (default: 1) */
+    int num_frames;
+    /* in: optional BOMBJACK_OBS_SIZE bytes buffer for the observation */
+    uint8_t* obs;
+    /* out: current score (0 if no score address declared) */
+    uint32_t score;
+    /* out: current lives counter (0 if no lives address declared) */
+    int lives;
+} bombjack_step_t;
+
 /* the whole Bomb Jack arcade machine state */
 typedef struct {
     bool valid;
@@ -203,12 +313,21 @@ typedef struct {
     uint8_t sound_latch;            /* shared latch, written by main board, read by sound board */
     uint8_t main_ram[0x1C00];
     uint8_t sound_ram[0x0400];
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom_main[5];
+    const uint8_t* rom_sound[1];
+    const uint8_t* rom_chars[3];
+    const uint8_t* rom_tiles[3];
+    const uint8_t* rom_sprites[3];
+    const uint8_t* rom_maps[1];
+#else
     uint8_t rom_main[5][0x2000];
     uint8_t rom_sound[1][0x2000];
     uint8_t rom_chars[3][0x1000];
     uint8_t rom_tiles[3][0x2000];
     uint8_t rom_sprites[3][0x2000];
     uint8_t rom_maps[1][0x1000];
+#endif
     void* user_data;
     /* audio and video 'rendering' */
     struct {
@@ -219,6 +338,17 @@ typedef struct {
         float sample_buffer[BOMBJACK_MAX_AUDIO_SAMPLES];
     } audio;
     uint32_t* pixel_buffer;
+    /* downscaled images for bombjack_step(), 4x4 pixel blocks a 4 bits */
+    struct {
+        uint8_t tiles[256][8];      /* 16x16 background tiles */
+        uint8_t chars[512][2];      /* 8x8 foreground chars */
+        uint8_t sprites[128][8];    /* 16x16 sprites */
+        uint8_t large[64][32];      /* 32x32 sprites */
+        uint16_t score_addr;
+        int score_size;
+        bool score_msb_first;
+        uint16_t lives_addr;
+    } obs;
     struct {
         bool draw_background_layer;
         bool draw_foreground_layer;
@@ -227,6 +357,11 @@ typedef struct {
     } dbg;
 } bombjack_t;
 
+/* a snapshot of the bombjack_t state for run-ahead, see bombjack_save_snapshot() */
+typedef struct {
+    bombjack_t sys;
+} bombjack_snapshot_t;
+
 /* initialize a new bombjack instance */
 void bombjack_init(bombjack_t* sys, const bombjack_desc_t* desc);
 /* discard a bombjack instance */
@@ -235,8 +370,18 @@ void bombjack_discard(bombjack_t* sys);
 void bombjack_reset(bombjack_t* sys);
 /* run bombjack instance for given amount of microseconds */
 void bombjack_exec(bombjack_t* sys, uint32_t micro_seconds);
+/* run an array of bombjack instances for given amount of microseconds */
+void bombjack_exec_batch(bombjack_t* sys, int num_instances, uint32_t micro_seconds);
+/* apply input, run a number of frames and render a low-res observation */
+void bombjack_step(bombjack_t* sys, bombjack_step_t* step);
 /* decode video to pixel buffer, must be called once per frame */
 void bombjack_decode_video(bombjack_t* sys);
+/* run the real frame, run ahead a number of frames, decode video and roll back */
+void bombjack_exec_runahead(bombjack_t* sys, bombjack_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames);
+/* save the system state into a snapshot (only for loading into the same instance) */
+void bombjack_save_snapshot(const bombjack_t* sys, bombjack_snapshot_t* dst);
+/* load the system state from a snapshot saved from the same instance */
+void bombjack_load_snapshot(bombjack_t* sys, const bombjack_snapshot_t* src);
 /* get the standard framebuffer width and height in pixels */
 int bombjack_std_display_width(void);
 int bombjack_std_display_height(void);
@@ -266,9 +411,15 @@ int bombjack_display_height(bombjack_t* sys);
 #define _BOMBJACK_DISPLAY_WIDTH (256)
 #define _BOMBJACK_DISPLAY_HEIGHT (256)
 #define _BOMBJACK_DISPLAY_SIZE (_BOMBJACK_DISPLAY_WIDTH*_BOMBJACK_DISPLAY_HEIGHT*4)
+#if defined(CHIPS_SHARED_ROMS)
+#define _BOMBJACK_ROM(dst,src,size) dst = (const uint8_t*)(src)
+#else
+#define _BOMBJACK_ROM(dst,src,size) memcpy(dst, src, size)
+#endif
 
 static uint64_t _bombjack_tick_mainboard(int num, uint64_t pins, void* user_data);
 static uint64_t _bombjack_tick_soundboard(int num, uint64_t pins, void* user_data);
+static void _bombjack_obs_init(bombjack_t* sys);
 
 #define _bombjack_def(val, def) (val == 0 ? def : val)
 
@@ -283,38 +434,38 @@ void bombjack_init(bombjack_t* sys, const bombjack_desc_t* desc) {
     sys->dbg.clear_background_layer = true;
 
     /* copy over ROM images */
-    CHIPS_ASSERT(desc->rom_main_0000_1FFF && (desc->rom_main_0000_1FFF_size == sizeof(sys->rom_main[0])));
-    CHIPS_ASSERT(desc->rom_main_2000_3FFF && (desc->rom_main_2000_3FFF_size == sizeof(sys->rom_main[1])));
-    CHIPS_ASSERT(desc->rom_main_4000_5FFF && (desc->rom_main_4000_5FFF_size == sizeof(sys->rom_main[2])));
-    CHIPS_ASSERT(desc->rom_main_6000_7FFF && (desc->rom_main_6000_7FFF_size == sizeof(sys->rom_main[3])));
-    CHIPS_ASSERT(desc->rom_main_C000_DFFF && (desc->rom_main_C000_DFFF_size == sizeof(sys->rom_main[4])));
-    CHIPS_ASSERT(desc->rom_sound_0000_1FFF && (desc->rom_sound_0000_1FFF_size == sizeof(sys->rom_sound[0])));
-    CHIPS_ASSERT(desc->rom_chars_0000_0FFF && (desc->rom_chars_0000_0FFF_size == sizeof(sys->rom_chars[0])));
-    CHIPS_ASSERT(desc->rom_chars_1000_1FFF && (desc->rom_chars_1000_1FFF_size == sizeof(sys->rom_chars[1])));
-    CHIPS_ASSERT(desc->rom_chars_2000_2FFF && (desc->rom_chars_2000_2FFF_size == sizeof(sys->rom_chars[2])));
-    CHIPS_ASSERT(desc->rom_tiles_0000_1FFF && (desc->rom_tiles_0000_1FFF_size == sizeof(sys->rom_tiles[0])));
-    CHIPS_ASSERT(desc->rom_tiles_2000_3FFF && (desc->rom_tiles_2000_3FFF_size == sizeof(sys->rom_tiles[1])));
-    CHIPS_ASSERT(desc->rom_tiles_4000_5FFF && (desc->rom_tiles_4000_5FFF_size == sizeof(sys->rom_tiles[2])));
-    CHIPS_ASSERT(desc->rom_sprites_0000_1FFF && (desc->rom_sprites_0000_1FFF_size == sizeof(sys->rom_sprites[0])));
-    CHIPS_ASSERT(desc->rom_sprites_2000_3FFF && (desc->rom_sprites_2000_3FFF_size == sizeof(sys->rom_sprites[1])));
-    CHIPS_ASSERT(desc->rom_sprites_4000_5FFF && (desc->rom_sprites_4000_5FFF_size == sizeof(sys->rom_sprites[2])));
-    CHIPS_ASSERT(desc->rom_maps_0000_0FFF && (desc->rom_maps_0000_0FFF_size == sizeof(sys->rom_maps[0])));
-    memcpy(sys->rom_main[0], desc->rom_main_0000_1FFF, sizeof(sys->rom_main[0]));
-    memcpy(sys->rom_main[1], desc->rom_main_2000_3FFF, sizeof(sys->rom_main[1]));
-    memcpy(sys->rom_main[2], desc->rom_main_4000_5FFF, sizeof(sys->rom_main[2]));
-    memcpy(sys->rom_main[3], desc->rom_main_6000_7FFF, sizeof(sys->rom_main[3]));
-    memcpy(sys->rom_main[4], desc->rom_main_C000_DFFF, sizeof(sys->rom_main[4]));
-    memcpy(sys->rom_sound[0], desc->rom_sound_0000_1FFF, sizeof(sys->rom_sound[0]));
-    memcpy(sys->rom_chars[0], desc->rom_chars_0000_0FFF, sizeof(sys->rom_chars[0]));
-    memcpy(sys->rom_chars[1], desc->rom_chars_1000_1FFF, sizeof(sys->rom_chars[1]));
-    memcpy(sys->rom_chars[2], desc->rom_chars_2000_2FFF, sizeof(sys->rom_chars[2]));
-    memcpy(sys->rom_tiles[0], desc->rom_tiles_0000_1FFF, sizeof(sys->rom_tiles[0]));
-    memcpy(sys->rom_tiles[1], desc->rom_tiles_2000_3FFF, sizeof(sys->rom_tiles[1]));
-    memcpy(sys->rom_tiles[2], desc->rom_tiles_4000_5FFF, sizeof(sys->rom_tiles[2]));
-    memcpy(sys->rom_sprites[0], desc->rom_sprites_0000_1FFF, sizeof(sys->rom_sprites[0]));
-    memcpy(sys->rom_sprites[1], desc->rom_sprites_2000_3FFF, sizeof(sys->rom_sprites[1]));
-    memcpy(sys->rom_sprites[2], desc->rom_sprites_4000_5FFF, sizeof(sys->rom_sprites[2]));
-    memcpy(sys->rom_maps[0], desc->rom_maps_0000_0FFF, sizeof(sys->rom_maps[0]));
+    CHIPS_ASSERT(desc->rom_main_0000_1FFF && (desc->rom_main_0000_1FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_main_2000_3FFF && (desc->rom_main_2000_3FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_main_4000_5FFF && (desc->rom_main_4000_5FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_main_6000_7FFF && (desc->rom_main_6000_7FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_main_C000_DFFF && (desc->rom_main_C000_DFFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_sound_0000_1FFF && (desc->rom_sound_0000_1FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_chars_0000_0FFF && (desc->rom_chars_0000_0FFF_size == 0x1000));
+    CHIPS_ASSERT(desc->rom_chars_1000_1FFF && (desc->rom_chars_1000_1FFF_size == 0x1000));
+    CHIPS_ASSERT(desc->rom_chars_2000_2FFF && (desc->rom_chars_2000_2FFF_size == 0x1000));
+    CHIPS_ASSERT(desc->rom_tiles_0000_1FFF && (desc->rom_tiles_0000_1FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_tiles_2000_3FFF && (desc->rom_tiles_2000_3FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_tiles_4000_5FFF && (desc->rom_tiles_4000_5FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_sprites_0000_1FFF && (desc->rom_sprites_0000_1FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_sprites_2000_3FFF && (desc->rom_sprites_2000_3FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_sprites_4000_5FFF && (desc->rom_sprites_4000_5FFF_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_maps_0000_0FFF && (desc->rom_maps_0000_0FFF_size == 0x1000));
+    _BOMBJACK_ROM(sys->rom_main[0], desc->rom_main_0000_1FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_main[1], desc->rom_main_2000_3FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_main[2], desc->rom_main_4000_5FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_main[3], desc->rom_main_6000_7FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_main[4], desc->rom_main_C000_DFFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_sound[0], desc->rom_sound_0000_1FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_chars[0], desc->rom_chars_0000_0FFF, 0x1000);
+    _BOMBJACK_ROM(sys->rom_chars[1], desc->rom_chars_1000_1FFF, 0x1000);
+    _BOMBJACK_ROM(sys->rom_chars[2], desc->rom_chars_2000_2FFF, 0x1000);
+    _BOMBJACK_ROM(sys->rom_tiles[0], desc->rom_tiles_0000_1FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_tiles[1], desc->rom_tiles_2000_3FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_tiles[2], desc->rom_tiles_4000_5FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_sprites[0], desc->rom_sprites_0000_1FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_sprites[1], desc->rom_sprites_2000_3FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_sprites[2], desc->rom_sprites_4000_5FFF, 0x2000);
+    _BOMBJACK_ROM(sys->rom_maps[0], desc->rom_maps_0000_0FFF, 0x1000);
 
     /* The VSYNC/VBLANK mainly controls the interrupts (Bombjack generally
         uses NMIs for simplicity. The mainboard's NMI is connected to the
@@ -404,6 +555,14 @@ void bombjack_init(bombjack_t* sys, const bombjack_desc_t* desc) {
     sys->user_data = desc->user_data;
     CHIPS_ASSERT((0 == desc->pixel_buffer) || (desc->pixel_buffer && (desc->pixel_buffer_size >= _BOMBJACK_DISPLAY_SIZE)));
     sys->pixel_buffer = (uint32_t*) desc->pixel_buffer;
+
+    /* RAM locations and precomputed images for bombjack_step() */
+    CHIPS_ASSERT((desc->score_size >= 0) && (desc->score_size <= 4));
+    sys->obs.score_addr = desc->score_addr;
+    sys->obs.score_size = desc->score_size;
+    sys->obs.score_msb_first = desc->score_msb_first;
+    sys->obs.lives_addr = desc->lives_addr;
+    _bombjack_obs_init(sys);
 }
 
 void bombjack_discard(bombjack_t* sys) {
@@ -474,6 +633,59 @@ void bombjack_exec(bombjack_t* sys, uint32_t micro_seconds) {
     }
 }
 
+/* headless: only the main board, the sound latch is write-only for the main board;
+   the sound board is paused, but its clock still consumes the elapsed time so
+   that both boards stay in step when switching back to bombjack_exec()
+*/
+static void _bombjack_exec_headless(bombjack_t* sys, uint32_t micro_seconds) {
+    uint32_t ticks_to_run = clk_ticks_to_run(&sys->mainboard.clk, micro_seconds);
+    uint32_t ticks_executed = z80_exec(&sys->mainboard.cpu, ticks_to_run);
+    clk_ticks_executed(&sys->mainboard.clk, ticks_executed);
+    clk_ticks_executed(&sys->soundboard.clk, clk_ticks_to_run(&sys->soundboard.clk, micro_seconds));
+}
+
+void bombjack_exec_batch(bombjack_t* sys, int num_instances, uint32_t micro_seconds) {
+    CHIPS_ASSERT(sys && (num_instances >= 0));
+    for (int i = 0; i < num_instances; i++) {
+        bombjack_t* inst = &sys[i];
+        if (inst->audio.callback) {
+            bombjack_exec(inst, micro_seconds);
+        }
+        else {
+            CHIPS_ASSERT(inst->valid);
+            _bombjack_exec_headless(inst, micro_seconds);
+        }
+    }
+}
+
+void bombjack_save_snapshot(const bombjack_t* sys, bombjack_snapshot_t* dst) {
+    CHIPS_ASSERT(sys && sys->valid && dst);
+    memcpy(&dst->sys, sys, sizeof(bombjack_t));
+}
+
+void bombjack_load_snapshot(bombjack_t* sys, const bombjack_snapshot_t* src) {
+    CHIPS_ASSERT(sys && sys->valid && src && src->sys.valid);
+    /* the snapshot must have been saved from this instance */
+    CHIPS_ASSERT(src->sys.mainboard.cpu.user_data == sys);
+    memcpy(sys, &src->sys, sizeof(bombjack_t));
+}
+
+void bombjack_exec_runahead(bombjack_t* sys, bombjack_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames) {
+    CHIPS_ASSERT(sys && sys->valid && snapshot && (num_frames >= 0));
+    bombjack_exec(sys, micro_seconds);
+    if (num_frames > 0) {
+        bombjack_save_snapshot(sys, snapshot);
+        for (int i = 0; i < num_frames; i++) {
+            _bombjack_exec_headless(sys, micro_seconds);
+        }
+        bombjack_decode_video(sys);
+        bombjack_load_snapshot(sys, snapshot);
+    }
+    else {
+        bombjack_decode_video(sys);
+    }
+}
+
 /* Maintain a color palette cache with 32-bit colors, this is called for
     CPU writes to the palette RAM area. The hardware palette is 128
     entries of 16-bit colors (xxxxBBBBGGGGRRRR), the function keeps
@@ -1046,4 +1258,214 @@ void bombjack_decode_video(bombjack_t* sys) {
     }
 }
 
+/* decode a 16x16 (or 32x32 if large) bitmap from 3 bitplane ROMs into pens, with a row pitch of 32 */
+static void _bombjack_obs_decode(uint8_t* dst, const uint8_t* rom0, const uint8_t* rom1, const uint8_t* rom2, int off, bool large) {
+    const int size = large ? 32 : 16;
+    for (int y = 0; y < size; y++) {
+        uint32_t bm0, bm1, bm2;
+        if (large) {
+            bm0 = BOMBJACK_GATHER32(rom0, off);
+            bm1 = BOMBJACK_GATHER32(rom1, off);
+            bm2 = BOMBJACK_GATHER32(rom2, off);
+            if ((y & 7) == 7) {
+                off += 8;
+            }
+            if ((y & 15) == 15) {
+                off += 32;
+            }
+        }
+        else {
+            bm0 = BOMBJACK_GATHER16(rom0, off);
+            bm1 = BOMBJACK_GATHER16(rom1, off);
+            bm2 = BOMBJACK_GATHER16(rom2, off);
+            if (y == 7) {
+                off += 8;
+            }
+        }
+        off++;
+        for (int x = 0; x < size; x++) {
+            const int bit = size - 1 - x;
+            dst[y*32 + x] = ((bm2>>bit)&1) | (((bm1>>bit)&1)<<1) | (((bm0>>bit)&1)<<2);
+        }
+    }
+}
+
+/* reduce a 4x4 block of pens to its most frequent non-zero pen */
+static uint8_t _bombjack_obs_block(const uint8_t* src) {
+    int count[8] = { 0 };
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            count[src[y*32 + x]]++;
+        }
+    }
+    uint8_t pen = 0;
+    int max_count = 0;
+    for (uint8_t i = 1; i < 8; i++) {
+        if (count[i] > max_count) {
+            max_count = count[i];
+            pen = i;
+        }
+    }
+    return pen;
+}
+
+/* reduce a decoded bitmap to 4x4 blocks, packed as 2 blocks per byte */
+static void _bombjack_obs_reduce(uint8_t* dst, const uint8_t* pixels, int blocks_per_row) {
+    for (int i = 0; i < blocks_per_row*blocks_per_row; i++) {
+        const int bx = i % blocks_per_row;
+        const int by = i / blocks_per_row;
+        dst[i>>1] |= _bombjack_obs_block(&pixels[by*4*32 + bx*4]) << ((i & 1) * 4);
+    }
+}
+
+static inline uint8_t _bombjack_obs_pen(const uint8_t* blocks, int i) {
+    return (blocks[i>>1] >> ((i & 1) * 4)) & 7;
+}
+
+static void _bombjack_obs_init(bombjack_t* sys) {
+    uint8_t pixels[32*32];
+    for (int code = 0; code < 256; code++) {
+        _bombjack_obs_decode(pixels, sys->rom_tiles[0], sys->rom_tiles[1], sys->rom_tiles[2], code * 32, false);
+        _bombjack_obs_reduce(sys->obs.tiles[code], pixels, 4);
+    }
+    for (int code = 0; code < 512; code++) {
+        const int off = code * 8;
+        for (int y = 0; y < 8; y++) {
+            const uint8_t bm0 = sys->rom_chars[0][off + y];
+            const uint8_t bm1 = sys->rom_chars[1][off + y];
+            const uint8_t bm2 = sys->rom_chars[2][off + y];
+            for (int x = 0; x < 8; x++) {
+                const int bit = 7 - x;
+                pixels[y*32 + x] = ((bm2>>bit)&1) | (((bm1>>bit)&1)<<1) | (((bm0>>bit)&1)<<2);
+            }
+        }
+        _bombjack_obs_reduce(sys->obs.chars[code], pixels, 2);
+    }
+    for (int code = 0; code < 128; code++) {
+        _bombjack_obs_decode(pixels, sys->rom_sprites[0], sys->rom_sprites[1], sys->rom_sprites[2], code * 32, false);
+        _bombjack_obs_reduce(sys->obs.sprites[code], pixels, 4);
+    }
+    for (int code = 0; code < 64; code++) {
+        _bombjack_obs_decode(pixels, sys->rom_sprites[0], sys->rom_sprites[1], sys->rom_sprites[2], code * 128, true);
+        _bombjack_obs_reduce(sys->obs.large[code], pixels, 8);
+    }
+}
+
+/* render the observation, same layers and layout as bombjack_decode_video() */
+static void _bombjack_obs_render(bombjack_t* sys, uint8_t* obs) {
+    /* background: 16x16 tiles, 4x4 observation pixels each */
+    const int img_base_addr = (sys->mainboard.bg_image & 7) * 0x0200;
+    const bool img_valid = (sys->mainboard.bg_image & 0x10) != 0;
+    for (int y = 0; y < 16; y++) {
+        for (int x = 0; x < 16; x++) {
+            const int addr = img_base_addr + (y * 16 + x);
+            const uint8_t tile_code = img_valid ? sys->rom_maps[0][addr] : 0;
+            const uint8_t attr = sys->rom_maps[0][addr + 0x0100];
+            const uint8_t color_block = (attr & 0x0F)<<3;
+            const int xor_y = (attr & 0x80) ? 3 : 0;
+            for (int i = 0; i < 16; i++) {
+                const int ox = x*4 + (i & 3);
+                const int oy = y*4 + ((i >> 2) ^ xor_y);
+                obs[oy*BOMBJACK_OBS_WIDTH + ox] = color_block | _bombjack_obs_pen(sys->obs.tiles[tile_code], i);
+            }
+        }
+    }
+    /* foreground: 8x8 chars, 2x2 observation pixels each, pen 0 is transparent */
+    for (int y = 0; y < 32; y++) {
+        for (int x = 0; x < 32; x++) {
+            const int addr = y * 32 + x;
+            const uint8_t chr = sys->main_ram[(0x9000-0x8000) + addr];
+            const uint8_t clr = sys->main_ram[(0x9400-0x8000) + addr];
+            const int tile_code = chr | ((clr & 0x10)<<4);
+            const uint8_t color_block = (clr & 0x0F)<<3;
+            for (int i = 0; i < 4; i++) {
+                const uint8_t pen = _bombjack_obs_pen(sys->obs.chars[tile_code], i);
+                if (pen) {
+                    obs[(y*2 + (i>>1))*BOMBJACK_OBS_WIDTH + x*2 + (i&1)] = color_block | pen;
+                }
+            }
+        }
+    }
+    /* sprites: 24 hardware sprites, sprite 0 has highest priority */
+    for (int sprite_nr = 23; sprite_nr >= 0; sprite_nr--) {
+        const int addr = (0x9820 - 0x8000) + sprite_nr*4;
+        const uint8_t b0 = sys->main_ram[addr + 0];
+        const uint8_t b1 = sys->main_ram[addr + 1];
+        const uint8_t b2 = sys->main_ram[addr + 2];
+        const uint8_t b3 = sys->main_ram[addr + 3];
+        const uint8_t color_block = (b1 & 0x0F)<<3;
+        const int px = b3 >> 2;
+        const uint8_t* blocks;
+        int size, py, xor_x, xor_y;
+        if (b0 & 0x80) {
+            blocks = sys->obs.large[b0 & 0x3F];
+            size = 8;
+            py = (225 - b2) >> 2;
+            xor_x = 0;
+            xor_y = 0;
+        }
+        else {
+            blocks = sys->obs.sprites[b0 & 0x7F];
+            size = 4;
+            py = (241 - b2) >> 2;
+            xor_x = (b1 & 0x40) ? 3 : 0;
+            xor_y = (b1 & 0x80) ? 3 : 0;
+        }
+        for (int i = 0; i < size*size; i++) {
+            const uint8_t pen = _bombjack_obs_pen(blocks, i);
+            if (0 == pen) {
+                continue;
+            }
+            const int ox = px + ((i % size) ^ xor_x);
+            const int oy = py + ((i / size) ^ xor_y);
+            if ((ox >= 0) && (ox < BOMBJACK_OBS_WIDTH) && (oy >= 0) && (oy < BOMBJACK_OBS_HEIGHT)) {
+                obs[oy*BOMBJACK_OBS_WIDTH + ox] = color_block | pen;
+            }
+        }
+    }
+}
+
+/* run a CPU for an exact number of ticks, carrying over the overrun ticks */
+static void _bombjack_exec_ticks(z80_t* cpu, clk_t* clk, int ticks) {
+    clk->ticks_to_run = ticks - clk->overrun_ticks;
+    if (clk->ticks_to_run < 1) {
+        clk->ticks_to_run = 1;
+    }
+    clk_ticks_executed(clk, z80_exec(cpu, (uint32_t)clk->ticks_to_run));
+}
+
+void bombjack_step(bombjack_t* sys, bombjack_step_t* step) {
+    CHIPS_ASSERT(sys && sys->valid && step);
+    CHIPS_ASSERT(step->num_frames >= 0);
+
+    /* replace the input state with the action */
+    sys->mainboard.p1 = step->p1;
+    sys->mainboard.sys = step->sys;
+
+    /* run main and sound board interleaved for half frames, like bombjack_exec() */
+    const int num_frames = _bombjack_def(step->num_frames, 1);
+    for (int i = 0; i < num_frames*2; i++) {
+        _bombjack_exec_ticks(&sys->mainboard.cpu, &sys->mainboard.clk, _BOMBJACK_VSYNC_PERIOD_4MHZ/2);
+        if (sys->audio.callback) {
+            _bombjack_exec_ticks(&sys->soundboard.cpu, &sys->soundboard.clk, _BOMBJACK_VSYNC_PERIOD_3MHZ/2);
+        }
+        else {
+            /* sound board paused, drop its overrun like _bombjack_exec_headless() */
+            sys->soundboard.clk.overrun_ticks = 0;
+        }
+    }
+
+    if (step->obs) {
+        _bombjack_obs_render(sys, step->obs);
+    }
+
+    /* score (BCD) and lives from main board RAM */
+    step->score = 0;
+    for (int i = 0; i < sys->obs.score_size; i++) {
+        int byte_index = sys->obs.score_msb_first ? i : (sys->obs.score_size - 1 - i);
+        uint8_t bcd = mem_rd(&sys->mainboard.mem, (uint16_t)(sys->obs.score_addr + byte_index));
+        step->score = step->score * 100 + (bcd>>4) * 10 + (bcd & 0xF);
+    }
+    step->lives = sys->obs.lives_addr ? mem_rd(&sys->mainboard.mem, sys->obs.lives_addr) : 0;
+}
 #endif /* CHIPS_IMPL */
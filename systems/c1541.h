@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into c1541_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until c1541_discard() is called, and the
+        macro must be defined in all source files which include c1541.h)
+
     You need to include the following headers before including c64.h:
 
+    - chips/chips_state.h
     - chips/m6502.h
     - chips/m6522.h
     - chips/mem.h
@@ -79,7 +89,11 @@ typedef struct {
     bool valid;
     mem_t mem;
     uint8_t ram[0x0800];
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom[2];      /* ROM images at C000 and E000 */
+#else
     uint8_t rom[0x4000];
+#endif
 } c1541_t;
 
 /* initialize a new c1541_t instance */
@@ -116,8 +130,13 @@ void c1541_init(c1541_t* sys, const c1541_desc_t* desc) {
     /* copy ROM images */
     CHIPS_ASSERT(desc->rom_c000_dfff && (0x2000 == desc->rom_c000_dfff_size));
     CHIPS_ASSERT(desc->rom_e000_ffff && (0x2000 == desc->rom_e000_ffff_size));
+    #if defined(CHIPS_SHARED_ROMS)
+    sys->rom[0] = (const uint8_t*) desc->rom_c000_dfff;
+    sys->rom[1] = (const uint8_t*) desc->rom_e000_ffff;
+    #else
     memcpy(&sys->rom[0x0000], desc->rom_c000_dfff, 0x2000);
     memcpy(&sys->rom[0x2000], desc->rom_e000_ffff, 0x2000);
+    #endif
 
     /* initialize the hardware */
     m6502_desc_t cpu_desc;
@@ -129,7 +148,12 @@ void c1541_init(c1541_t* sys, const c1541_desc_t* desc) {
     /* setup memory map */
     mem_init(&sys->mem);
     mem_map_ram(&sys->mem, 0, 0x0000, 0x0800, sys->ram);
+    #if defined(CHIPS_SHARED_ROMS)
+    mem_map_rom(&sys->mem, 0, 0xC000, 0x2000, sys->rom[0]);
+    mem_map_rom(&sys->mem, 0, 0xE000, 0x2000, sys->rom[1]);
+    #else
     mem_map_rom(&sys->mem, 0, 0xC000, 0x4000, sys->rom);
+    #endif
 }
 
 void c1541_discard(c1541_t* sys) {
@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into c64_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until c64_discard() is called, and the
+        macro must be defined in all source files which include c64.h)
+
     You need to include the following headers before including c64.h:
 
+    - chips/chips_state.h
     - chips/m6502.h
     - chips/m6526.h
     - chips/m6569.h
@@ -35,9 +45,109 @@
 
     TODO!
 
+    ## Virtual Disc Drive
+
+    Since the C1541 floppy drive emulation isn't complete yet, a
+    'virtual disc drive' on device 8 provides access to .d64 disc images
+    by trapping the KERNAL serial bus routines (so this only works with
+    the original KERNAL ROM):
+
+    ~~~C
+    c64_insert_disc(&sys, d64_data, d64_size);
+    ~~~
+
+    After inserting a disc, LOAD"$",8 lists the directory, and
+    LOAD"NAME",8,1 loads a file instantly. Files can also be read
+    through OPEN/GET#/INPUT#, and the status message can be read from
+    the command channel 15. The disc image data isn't copied, so it
+    must remain valid until c64_remove_disc() is called. The virtual
+    drive is read-only, writing files and disc commands are not supported.
+
+    ## VICE Snapshots
+
+    c64_quickload() also accepts VICE .vsf snapshot files, the CPU, memory
+    configuration, CIA, VIC-II and SID register state is restored from the
+    MAINCPU, C64MEM, CIA1, CIA2, VIC-II and SID modules, other modules
+    (for instance drives and cartridges) are ignored. The internal state
+    of the chips which isn't visible through registers (like SID envelope
+    and filter state) isn't restored.
+
+    ## Beam Racing
+
+    Normally the host uploads the whole pixel buffer after c64_exec()
+    returns, which adds up to one frame of display latency. For 'beam
+    racing', provide a scanline callback, it is called from inside
+    c64_exec() each time scanline_chunk lines of the visible area have
+    been decoded by the VIC-II:
+
+    ~~~C
+    static void scanline_cb(int y0, int y1, void* user_data) {
+        // upload the pixel buffer lines y0 to y1-1 to the GPU
+    }
+    ...
+    c64_init(&sys, &(c64_desc_t){
+        ...
+        .scanline_cb = scanline_cb,
+        .scanline_chunk = 16,   // default is 16 lines
+    });
+    ~~~
+
+    The last chunk of a frame may be smaller. To keep up with the host
+    display's beam, call c64_exec() in slices of a fraction of a frame.
+    In the debug visualization mode, the callback isn't called.
+
+    ## Frame Callback
+
+    The optional frame callback is called from inside c64_exec() when
+    the VIC-II starts a new frame, at that point the pixel buffer contains
+    a complete frame. To render the next frame into a different pixel
+    buffer (for instance for video capture with util/capture.h), call
+    c64_set_pixel_buffer() from inside the callback. The callback also gets
+    the number of emulated CPU ticks since c64_init(), for instance as
+    frame timestamp:
+
+    ~~~C
+    static void frame_cb(uint64_t tick_count, void* user_data) {
+        c64_set_pixel_buffer(&sys, capture_submit_frame(&cap, tick_count));
+    }
+    ~~~
+
+    The frame callback isn't called while c64_exec_runahead() runs
+    with one or more run-ahead frames.
+
+    ## Run-Ahead
+
+    Many games read the joystick a frame or two before the result becomes
+    visible. c64_exec_runahead() hides this latency by running the
+    emulation ahead of the 'real' state, presenting the video output of
+    the last run-ahead frame, and rolling the state back:
+
+    ~~~C
+    static c64_snapshot_t snapshot;
+    ...
+    // once per host frame, after applying the input
+    c64_exec_runahead(&sys, &snapshot, frame_time_us, 1);
+    ~~~
+
+    The real frame is run with audio output, then a snapshot is saved, the
+    given number of frames is run ahead without audio output, and the
+    snapshot is loaded again. With zero run-ahead frames,
+    c64_exec_runahead() is identical to c64_exec(). Only the lines of the
+    last run-ahead frame are reported to the scanline callback.
+
+    Unlike on the other systems, video decoding isn't skipped in the
+    real and intermediate frames, because the VIC-II detects sprite-data
+    collisions in its pixel pipeline.
+
+    c64_save_snapshot() and c64_load_snapshot() copy the c64_t struct
+    with memcpy(), except for the datasette tape buffer (which is never
+    written by the emulation). Snapshots can only be loaded into the
+    instance they were saved from, so no internal pointers need to be
+    fixed up, but inserting a tape invalidates existing snapshots.
+
     ## TODO:
 
-    - floppy disc support
+    - C1541 floppy disc support
 
     ## Tests Status
     
@@ -251,6 +361,8 @@ extern "C" {
 #define C64_FREQUENCY (985248)              /* clock frequency in Hz */
 #define C64_MAX_AUDIO_SAMPLES (1024)        /* max number of audio samples in internal sample buffer */
 #define C64_DEFAULT_AUDIO_SAMPLES (128)     /* default number of samples in internal sample buffer */ 
+#define C64_VDRIVE_MAX_NAME (64)            /* max length of file names and commands sent to the virtual drive */
+#define C64_VDRIVE_DIR_SIZE (8192)          /* size of the directory listing buffer of the virtual drive */
 
 /* C64 joystick types */
 typedef enum {
@@ -315,6 +427,12 @@ typedef enum {
 
 /* audio sample data callback */
 typedef void (*c64_audio_callback_t)(const float* samples, int num_samples, void* user_data);
+/* beam racing callback, called with a range of decoded pixel buffer lines [y0, y1) */
+typedef void (*c64_scanline_callback_t)(int y0, int y1, void* user_data);
+/* frame callback, called at vsync when a complete frame is in the pixel buffer,
+   with the number of emulated CPU ticks since c64_init()
+*/
+typedef void (*c64_frame_callback_t)(uint64_t tick_count, void* user_data);
 
 /* config parameters for c64_init() */
 typedef struct {
@@ -326,6 +444,9 @@ typedef struct {
     void* pixel_buffer;         /* pointer to a linear RGBA8 pixel buffer, 
                                    at least 512*312*4 bytes, or ask via c64_max_display_size() */
     int pixel_buffer_size;      /* size of the pixel buffer in bytes */
+    c64_scanline_callback_t scanline_cb;    /* optional beam racing callback */
+    int scanline_chunk;         /* number of lines per scanline_cb call, default is 16 */
+    c64_frame_callback_t frame_cb;  /* optional callback at vsync */
 
     /* optional user-data for callback functions */
     void* user_data;
@@ -335,6 +456,7 @@ typedef struct {
     int audio_num_samples;          /* default is C64_AUDIO_NUM_SAMPLES */
     int audio_sample_rate;          /* playback sample rate in Hz, default is 44100 */
     float audio_sid_volume;         /* audio volume of the SID chip (0.0 .. 1.0), default is 1.0 */
+    m6581_model_t sid_model;        /* SID chip revision, default is M6581_MODEL_6581 */
 
     /* ROM images */
     const void* rom_char;           /* 4 KByte character ROM dump */
@@ -351,6 +473,34 @@ typedef struct {
     int c1541_rom_e000_ffff_size;
 } c64_desc_t;
 
+/* virtual disc drive channel */
+typedef struct {
+    bool open;
+    bool dir;                   /* true: reading the directory listing */
+    uint8_t track;              /* current track of a file's block chain */
+    uint8_t sector;             /* current sector of a file's block chain */
+    int num_blocks;             /* number of sectors visited in the block chain */
+    int pos;                    /* read position in current sector or directory listing */
+    int end;                    /* end of valid data in current sector or directory listing */
+} c64_vdrive_channel_t;
+
+/* virtual disc drive state (KERNAL IEC traps for device 8) */
+typedef struct {
+    const uint8_t* disc;        /* the inserted .d64 image (not copied) */
+    int disc_size;
+    bool listening;             /* the KERNAL has sent LISTEN to device 8 */
+    bool talking;               /* the KERNAL has sent TALK to device 8 */
+    bool opening;               /* receiving a file name after OPEN */
+    uint8_t channel;            /* current secondary address */
+    uint8_t status;             /* DOS status code (0: OK, 62: FILE NOT FOUND, 66: ILLEGAL TRACK OR SECTOR) */
+    int status_pos;             /* read position in status message */
+    int name_len;
+    uint8_t name[C64_VDRIVE_MAX_NAME];
+    c64_vdrive_channel_t channels[16];
+    int dir_len;
+    uint8_t dir[C64_VDRIVE_DIR_SIZE];   /* directory listing as BASIC program */
+} c64_vdrive_t;
+
 /* C64 emulator state */
 typedef struct {
     uint64_t pins;
@@ -371,7 +521,9 @@ typedef struct {
     uint8_t joy_joy1_mask;      /* current joystick-1 state from c64_joystick() */
     uint8_t joy_joy2_mask;      /* current joystick-2 state from c64_joystick() */
     uint16_t vic_bank_select;   /* upper 4 address bits from CIA-2 port A */
+    uint64_t tick_count;        /* emulated CPU ticks since c64_init() */
 
+    clk_t clk;                  /* converts micro-seconds to ticks */
     kbd_t kbd;                  /* keyboard matrix state */
     mem_t mem_cpu;              /* CPU-visible memory mapping */
     mem_t mem_vic;              /* VIC-visible memory mapping */
@@ -381,18 +533,34 @@ typedef struct {
     c64_audio_callback_t audio_cb;
     int num_samples;
     int sample_pos;
+    c64_scanline_callback_t scanline_cb;
+    int scanline_chunk;
+    int scanline_y0, scanline_y1;   /* range of decoded lines not yet reported */
+    c64_frame_callback_t frame_cb;
     float sample_buffer[C64_MAX_AUDIO_SAMPLES];
 
     uint8_t color_ram[1024];        /* special static color ram */
     uint8_t ram[1<<16];             /* general ram */
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom_char;        /* 4 KB character ROM image */
+    const uint8_t* rom_basic;       /* 8 KB BASIC ROM image */
+    const uint8_t* rom_kernal;      /* 8 KB KERNAL V3 ROM image */
+#else
     uint8_t rom_char[0x1000];       /* 4 KB character ROM image */
     uint8_t rom_basic[0x2000];      /* 8 KB BASIC ROM image */
     uint8_t rom_kernal[0x2000];     /* 8 KB KERNAL V3 ROM image */
+#endif
 
     c1530_t c1530;      /* optional datassette */
     c1541_t c1541;      /* optional floppy drive */
+    c64_vdrive_t vdrive;    /* virtual disc drive */
 } c64_t;
 
+/* a snapshot of the c64_t state for run-ahead, see c64_save_snapshot() */
+typedef struct {
+    c64_t sys;
+} c64_snapshot_t;
+
 /* initialize a new C64 instance */
 void c64_init(c64_t* sys, const c64_desc_t* desc);
 /* discard C64 instance */
@@ -409,6 +577,14 @@ int c64_display_height(c64_t* sys);
 void c64_reset(c64_t* sys);
 /* tick C64 instance for a given number of microseconds, also updates keyboard state */
 void c64_exec(c64_t* sys, uint32_t micro_seconds);
+/* run the real frame, then run ahead a number of frames and roll back */
+void c64_exec_runahead(c64_t* sys, c64_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames);
+/* save the system state into a snapshot (only for loading into the same instance) */
+void c64_save_snapshot(const c64_t* sys, c64_snapshot_t* dst);
+/* load the system state from a snapshot saved from the same instance */
+void c64_load_snapshot(c64_t* sys, const c64_snapshot_t* src);
+/* switch to another pixel buffer (at least as big as the one passed to c64_init()) */
+void c64_set_pixel_buffer(c64_t* sys, void* pixel_buffer);
 /* ...or optionally: tick the C64 instance once, does not update keyboard state! */
 void c64_tick(c64_t* sys);
 /* send a key-down event to the C64 */
@@ -421,7 +597,7 @@ void c64_set_joystick_type(c64_t* sys, c64_joystick_type_t type);
 c64_joystick_type_t c64_joystick_type(c64_t* sys);
 /* set joystick mask (combination of C64_JOYSTICK_*) */
 void c64_joystick(c64_t* sys, uint8_t joy1_mask, uint8_t joy2_mask);
-/* quickload a .bin/.prg file */
+/* quickload a .bin/.prg file or a VICE .vsf snapshot */
 bool c64_quickload(c64_t* sys, const uint8_t* ptr, int num_bytes);
 /* insert tape as .TAP file (c1530 must be enabled) */
 bool c64_insert_tape(c64_t* sys, const uint8_t* ptr, int num_bytes);
@@ -435,6 +611,12 @@ void c64_tape_play(c64_t* sys);
 void c64_tape_stop(c64_t* sys);
 /* return true if tape motor is on */
 bool c64_is_tape_motor_on(c64_t* sys);
+/* insert a .d64 disc image into the virtual drive 8 (data must remain valid) */
+bool c64_insert_disc(c64_t* sys, const uint8_t* ptr, int num_bytes);
+/* remove the disc from the virtual drive */
+void c64_remove_disc(c64_t* sys);
+/* return true if a disc is inserted in the virtual drive */
+bool c64_disc_inserted(c64_t* sys);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -443,6 +625,7 @@ bool c64_is_tape_motor_on(c64_t* sys);
 /*-- IMPLEMENTATION ----------------------------------------------------------*/
 #ifdef CHIPS_IMPL
 #include <string.h> /* memcpy, memset */
+#include <stddef.h> /* offsetof */
 #ifndef CHIPS_ASSERT
     #include <assert.h>
     #define CHIPS_ASSERT(c) assert(c)
@@ -460,9 +643,13 @@ static uint64_t _c64_tick(c64_t* sys, uint64_t pins);
 static uint8_t _c64_cpu_port_in(void* user_data);
 static void _c64_cpu_port_out(uint8_t data, void* user_data);
 static uint16_t _c64_vic_fetch(uint16_t addr, void* user_data);
+static void _c64_vic_crtline(int y, void* user_data);
+static void _c64_vic_vsync(void* user_data);
 static void _c64_update_memory_map(c64_t* sys);
 static void _c64_init_key_map(c64_t* sys);
 static void _c64_init_memory_map(c64_t* sys);
+static uint64_t _c64_vdrive_trap(c64_t* sys, uint64_t pins, uint16_t pc);
+static void _c64_vdrive_reset(c64_t* sys);
 
 #define _C64_DEFAULT(val,def) (((val) != 0) ? (val) : (def));
 #define _C64_CLEAR(val) memset(&val, 0, sizeof(val))
@@ -474,15 +661,24 @@ void c64_init(c64_t* sys, const c64_desc_t* desc) {
     memset(sys, 0, sizeof(c64_t));
     sys->valid = true;
     sys->joystick_type = desc->joystick_type;
-    CHIPS_ASSERT(desc->rom_char && (desc->rom_char_size == sizeof(sys->rom_char)));
-    CHIPS_ASSERT(desc->rom_basic && (desc->rom_basic_size == sizeof(sys->rom_basic)));
-    CHIPS_ASSERT(desc->rom_kernal && (desc->rom_kernal_size == sizeof(sys->rom_kernal)));
+    CHIPS_ASSERT(desc->rom_char && (desc->rom_char_size == 0x1000));
+    CHIPS_ASSERT(desc->rom_basic && (desc->rom_basic_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_kernal && (desc->rom_kernal_size == 0x2000));
+    #if defined(CHIPS_SHARED_ROMS)
+    sys->rom_char = (const uint8_t*) desc->rom_char;
+    sys->rom_basic = (const uint8_t*) desc->rom_basic;
+    sys->rom_kernal = (const uint8_t*) desc->rom_kernal;
+    #else
     memcpy(sys->rom_char, desc->rom_char, sizeof(sys->rom_char));
     memcpy(sys->rom_basic, desc->rom_basic, sizeof(sys->rom_basic));
     memcpy(sys->rom_kernal, desc->rom_kernal, sizeof(sys->rom_kernal));
+    #endif
     sys->user_data = desc->user_data;
     sys->audio_cb = desc->audio_cb;
     sys->num_samples = _C64_DEFAULT(desc->audio_num_samples, C64_DEFAULT_AUDIO_SAMPLES);
+    sys->scanline_cb = desc->scanline_cb;
+    sys->scanline_chunk = _C64_DEFAULT(desc->scanline_chunk, 16);
+    sys->frame_cb = desc->frame_cb;
     CHIPS_ASSERT(sys->num_samples <= C64_MAX_AUDIO_SAMPLES);
 
     /* initialize the hardware */
@@ -498,6 +694,7 @@ void c64_init(c64_t* sys, const c64_desc_t* desc) {
     cpu_desc.m6510_io_floating = 0xC8;
     cpu_desc.m6510_user_data = sys;
     sys->pins = m6502_init(&sys->cpu, &cpu_desc);
+    clk_init(&sys->clk, C64_FREQUENCY);
 
     m6526_init(&sys->cia_1);
     m6526_init(&sys->cia_2);
@@ -505,6 +702,8 @@ void c64_init(c64_t* sys, const c64_desc_t* desc) {
     m6569_desc_t vic_desc;
     _C64_CLEAR(vic_desc);
     vic_desc.fetch_cb = _c64_vic_fetch;
+    vic_desc.crtline_cb = desc->scanline_cb ? _c64_vic_crtline : 0;
+    vic_desc.vsync_cb = desc->frame_cb ? _c64_vic_vsync : 0;
     vic_desc.rgba8_buffer = (uint32_t*) desc->pixel_buffer;
     vic_desc.rgba8_buffer_size = desc->pixel_buffer_size;
     vic_desc.vis_x = _C64_DISPLAY_X;
@@ -521,6 +720,7 @@ void c64_init(c64_t* sys, const c64_desc_t* desc) {
     sid_desc.tick_hz = C64_FREQUENCY;
     sid_desc.sound_hz = sound_hz;
     sid_desc.magnitude = sid_volume;
+    sid_desc.model = desc->sid_model;
     m6581_init(&sys->sid, &sid_desc);
 
     _c64_init_key_map(sys);
@@ -590,6 +790,7 @@ void c64_reset(c64_t* sys) {
     m6526_reset(&sys->cia_2);
     m6569_reset(&sys->vic);
     m6581_reset(&sys->sid);
+    _c64_vdrive_reset(sys);
 }
 
 void c64_tick(c64_t* sys) {
@@ -598,15 +799,66 @@ void c64_tick(c64_t* sys) {
 
 void c64_exec(c64_t* sys, uint32_t micro_seconds) {
     CHIPS_ASSERT(sys && sys->valid);
-    uint32_t num_ticks = clk_us_to_ticks(C64_FREQUENCY, micro_seconds);
+    uint32_t num_ticks = clk_ticks_to_run(&sys->clk, micro_seconds);
     uint64_t pins = sys->pins;
     for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
         pins = _c64_tick(sys, pins);
     }
     sys->pins = pins;
+    clk_ticks_executed(&sys->clk, num_ticks);
     kbd_update(&sys->kbd, micro_seconds);
 }
 
+/* copy the system state, except for the read-only tape buffer */
+static void _c64_copy_state(c64_t* dst, const c64_t* src) {
+    const size_t buf_start = offsetof(c64_t, c1530.buf);
+    const size_t buf_end = buf_start + sizeof(src->c1530.buf);
+    memcpy(dst, src, buf_start);
+    memcpy((uint8_t*)dst + buf_end, (const uint8_t*)src + buf_end, sizeof(c64_t) - buf_end);
+}
+
+void c64_save_snapshot(const c64_t* sys, c64_snapshot_t* dst) {
+    CHIPS_ASSERT(sys && sys->valid && dst);
+    _c64_copy_state(&dst->sys, sys);
+}
+
+void c64_load_snapshot(c64_t* sys, const c64_snapshot_t* src) {
+    CHIPS_ASSERT(sys && sys->valid && src && src->sys.valid);
+    /* the snapshot must have been saved from this instance */
+    CHIPS_ASSERT(src->sys.vic.mem.user_data == sys);
+    _c64_copy_state(sys, &src->sys);
+}
+
+void c64_exec_runahead(c64_t* sys, c64_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames) {
+    CHIPS_ASSERT(sys && sys->valid && snapshot && (num_frames >= 0));
+    if (0 == num_frames) {
+        c64_exec(sys, micro_seconds);
+        return;
+    }
+    /* only the presented frame is reported to the scanline callback, the frame callback is off */
+    c64_scanline_callback_t scanline_cb = sys->scanline_cb;
+    c64_frame_callback_t frame_cb = sys->frame_cb;
+    sys->scanline_cb = 0;
+    sys->frame_cb = 0;
+    c64_exec(sys, micro_seconds);
+    sys->scanline_cb = scanline_cb;
+    c64_save_snapshot(sys, snapshot);
+    /* run ahead without audio output, loading the snapshot restores the callbacks */
+    sys->audio_cb = 0;
+    for (int i = 0; i < num_frames; i++) {
+        sys->scanline_cb = (i == (num_frames - 1)) ? scanline_cb : 0;
+        c64_exec(sys, micro_seconds);
+    }
+    c64_load_snapshot(sys, snapshot);
+    sys->frame_cb = frame_cb;
+}
+
+void c64_set_pixel_buffer(c64_t* sys, void* pixel_buffer) {
+    CHIPS_ASSERT(sys && sys->valid);
+    sys->pixel_buffer = (uint32_t*) pixel_buffer;
+    sys->vic.crt.rgba8_buffer = (uint32_t*) pixel_buffer;
+}
+
 void c64_key_down(c64_t* sys, int key_code) {
     CHIPS_ASSERT(sys && sys->valid);
     if (sys->joystick_type == C64_JOYSTICKTYPE_NONE) {
@@ -690,6 +942,7 @@ void c64_joystick(c64_t* sys, uint8_t joy1_mask, uint8_t joy2_mask) {
 }
 
 static uint64_t _c64_tick(c64_t* sys, uint64_t pins) {
+    sys->tick_count++;
 
     /* FIXME: move datasette and floppy tick to end */
     if (sys->c1530.valid) {
@@ -700,7 +953,7 @@ static uint64_t _c64_tick(c64_t* sys, uint64_t pins) {
     }
 
     /* tick the CPU */
-    pins = m6502_tick(&sys->cpu, pins);
+    pins = m6510_tick(&sys->cpu, pins);
     const uint16_t addr = M6502_GET_ADDR(pins);
 
     /* those pins are set each tick by the CIAs and VIC */
@@ -880,6 +1133,13 @@ static uint64_t _c64_tick(c64_t* sys, uint64_t pins) {
             mem_wr(&sys->mem_cpu, addr, M6502_GET_DATA(pins));
         }
     }
+
+    /* check if one of the trapped KERNAL IEC routines was hit to
+       implement the virtual disc drive
+    */
+    if (sys->vdrive.disc && (pins & M6502_SYNC) && (sys->cpu_port & C64_CPUPORT_HIRAM) && (addr >= 0xE000)) {
+        pins = _c64_vdrive_trap(sys, pins, addr);
+    }
     return pins;
 }
 
@@ -923,6 +1183,33 @@ static void _c64_cpu_port_out(uint8_t data, void* user_data) {
     }
 }
 
+/* collect the lines decoded by the VIC-II and report them in chunks to the scanline callback */
+static void _c64_vic_crtline(int y, void* user_data) {
+    c64_t* sys = (c64_t*) user_data;
+    if (0 == sys->scanline_cb) {
+        return;
+    }
+    if (y != sys->scanline_y1) {
+        /* a new frame has started, report any lines left over from the last frame */
+        if (sys->scanline_y0 < sys->scanline_y1) {
+            sys->scanline_cb(sys->scanline_y0, sys->scanline_y1, sys->user_data);
+        }
+        sys->scanline_y0 = y;
+    }
+    sys->scanline_y1 = y + 1;
+    if (((sys->scanline_y1 - sys->scanline_y0) >= sys->scanline_chunk) || (sys->scanline_y1 == sys->vic.crt.vis_h)) {
+        sys->scanline_cb(sys->scanline_y0, sys->scanline_y1, sys->user_data);
+        sys->scanline_y0 = sys->scanline_y1;
+    }
+}
+
+static void _c64_vic_vsync(void* user_data) {
+    c64_t* sys = (c64_t*) user_data;
+    if (sys->frame_cb) {
+        sys->frame_cb(sys->tick_count, sys->user_data);
+    }
+}
+
 static uint16_t _c64_vic_fetch(uint16_t addr, void* user_data) {
     c64_t* sys = (c64_t*) user_data;
     /*
@@ -946,7 +1233,7 @@ static uint16_t _c64_vic_fetch(uint16_t addr, void* user_data) {
 
 static void _c64_update_memory_map(c64_t* sys) {
     sys->io_mapped = false;
-    uint8_t* read_ptr;
+    const uint8_t* read_ptr;
     /* shortcut if HIRAM and LORAM is 0, everything is RAM */
     if ((sys->cpu_port & (C64_CPUPORT_HIRAM|C64_CPUPORT_LORAM)) == 0) {
         mem_map_ram(&sys->mem_cpu, 0, 0xA000, 0x6000, sys->ram+0xA000);
@@ -1089,8 +1376,232 @@ static void _c64_init_key_map(c64_t* sys) {
     kbd_register_key(&sys->kbd, C64_KEY_F8      , 3, 0, 1);    /* F8 */
 }
 
+/*  VICE .vsf snapshot files consist of a file header followed by a list
+    of modules, each with its own module header. Only the modules which
+    map to emulator state are evaluated, all other modules are skipped.
+*/
+#define _C64_VSF_MAGIC "VICE Snapshot File\032"
+#define _C64_VSF_VERSION_MAGIC "VICE Version\032"
+#define _C64_VSF_MODULE_HEADER_SIZE (22)
+
+typedef struct {
+    uint8_t magic[19];          /* "VICE Snapshot File\032" */
+    uint8_t major;
+    uint8_t minor;
+    uint8_t machine[16];        /* "C64" or "C64SC", zero-padded */
+} _c64_vsf_header;
+
+typedef struct {
+    uint8_t name[16];
+    uint8_t major;
+    uint8_t minor;
+    uint8_t size[4];            /* module size including the module header */
+} _c64_vsf_module_header;
+
+/* 'MAINCPU' module */
+typedef struct {
+    uint8_t clk[4];
+    uint8_t A, X, Y, SP;
+    uint8_t PC_l, PC_h;
+    uint8_t P;
+    uint8_t last_opcode_info[4];
+} _c64_vsf_cpu;
+
+/* 'C64MEM' module */
+typedef struct {
+    uint8_t cpu_port_data;
+    uint8_t cpu_port_dir;
+    uint8_t exrom;
+    uint8_t game;
+    uint8_t ram[1<<16];
+} _c64_vsf_mem;
+
+/* 'CIA1' and 'CIA2' module */
+typedef struct {
+    uint8_t ora, orb, ddra, ddrb;
+    uint8_t ta_l, ta_h;         /* current timer counter */
+    uint8_t tb_l, tb_h;
+    uint8_t tod_ten, tod_sec, tod_min, tod_hr;
+    uint8_t sdr;
+    uint8_t ier;                /* interrupt mask */
+    uint8_t cra, crb;
+    uint8_t tal_l, tal_h;       /* timer latches */
+    uint8_t tbl_l, tbl_h;
+    uint8_t ifr;                /* interrupt flags */
+} _c64_vsf_cia;
+
+/* 'VIC-II' module (only the part up to the register bank) */
+typedef struct {
+    uint8_t allow_bad_lines;
+    uint8_t bad_line;
+    uint8_t blank;
+    uint8_t color_buf[40];
+    uint8_t color_ram[1024];
+    uint8_t idle_state;
+    uint8_t lp_trigger;
+    uint8_t lp_x, lp_y;
+    uint8_t matrix_buf[40];
+    uint8_t new_sprite_dma_mask;
+    uint8_t ram_base[4];
+    uint8_t raster_cycle;
+    uint8_t raster_line_l, raster_line_h;
+    uint8_t regs[64];
+} _c64_vsf_vic;
+
+/* compare a zero-padded 16-byte name field */
+static bool _c64_vsf_name(const uint8_t* field, const char* name) {
+    const size_t len = strlen(name);
+    return (0 == memcmp(field, name, len)) && ((len == 16) || (field[len] == 0));
+}
+
+static bool _c64_is_vsf(const uint8_t* ptr, int num_bytes) {
+    return (num_bytes >= (int)sizeof(_c64_vsf_header)) && (0 == memcmp(ptr, _C64_VSF_MAGIC, 19));
+}
+
+/* write a chip register pin mask (this ticks the chip once) */
+static uint64_t _c64_vsf_wr(uint16_t reg, uint8_t data) {
+    uint64_t pins = 0;
+    M6502_SET_ADDR(pins, reg);
+    M6502_SET_DATA(pins, data);
+    return pins;
+}
+
+static void _c64_vsf_load_cia(m6526_t* cia, const _c64_vsf_cia* src) {
+    m6526_reset(cia);
+    uint64_t pins;
+    const uint8_t regs[] = {
+        0x00, src->ora, 0x01, src->orb, 0x02, src->ddra, 0x03, src->ddrb,
+        0x04, src->tal_l, 0x05, src->tal_h, 0x06, src->tbl_l, 0x07, src->tbl_h,
+        0x0C, src->sdr, 0x0D, (uint8_t)(0x80 | (src->ier & 0x1F)),
+        /* don't trigger the force-load strobe */
+        0x0E, (uint8_t)(src->cra & ~0x10), 0x0F, (uint8_t)(src->crb & ~0x10),
+    };
+    for (int i = 0; i < (int)sizeof(regs); i += 2) {
+        pins = _c64_vsf_wr(regs[i], regs[i+1]) | M6526_CS;
+        M6526_SET_PAB(pins, 0xFF, 0xFF);
+        pins = m6526_tick(cia, pins);
+    }
+    cia->ta.counter = src->ta_h<<8 | src->ta_l;
+    cia->tb.counter = src->tb_h<<8 | src->tb_l;
+    cia->intr.icr = src->ifr;
+}
+
+static bool _c64_load_vsf(c64_t* sys, const uint8_t* ptr, int num_bytes) {
+    const uint8_t* end_ptr = ptr + num_bytes;
+    const _c64_vsf_header* hdr = (const _c64_vsf_header*) ptr;
+    if (!_c64_vsf_name(hdr->machine, "C64") && !_c64_vsf_name(hdr->machine, "C64SC")) {
+        return false;
+    }
+    ptr += sizeof(_c64_vsf_header);
+    /* snapshots written by VICE 3.x have an additional version block */
+    const int ver_len = (int)strlen(_C64_VSF_VERSION_MAGIC);
+    if (((ptr + ver_len) <= end_ptr) && (0 == memcmp(ptr, _C64_VSF_VERSION_MAGIC, (size_t)ver_len))) {
+        ptr += ver_len + 4 + 4;
+    }
+    const _c64_vsf_cpu* cpu = 0;
+    const _c64_vsf_mem* mem = 0;
+    const _c64_vsf_cia* cia[2] = { 0, 0 };
+    const _c64_vsf_vic* vic = 0;
+    const uint8_t* sid_regs = 0;
+    while ((ptr + _C64_VSF_MODULE_HEADER_SIZE) <= end_ptr) {
+        const _c64_vsf_module_header* mod = (const _c64_vsf_module_header*) ptr;
+        const uint32_t size = mod->size[0] | (mod->size[1]<<8) | (mod->size[2]<<16) | ((uint32_t)mod->size[3]<<24);
+        if ((size < _C64_VSF_MODULE_HEADER_SIZE) || (size > (uint32_t)(end_ptr - ptr))) {
+            return false;
+        }
+        const uint8_t* data = ptr + _C64_VSF_MODULE_HEADER_SIZE;
+        const uint32_t data_size = size - _C64_VSF_MODULE_HEADER_SIZE;
+        if (_c64_vsf_name(mod->name, "MAINCPU") && (data_size >= sizeof(_c64_vsf_cpu))) {
+            cpu = (const _c64_vsf_cpu*) data;
+        }
+        else if (_c64_vsf_name(mod->name, "C64MEM") && (data_size >= sizeof(_c64_vsf_mem))) {
+            mem = (const _c64_vsf_mem*) data;
+        }
+        else if (_c64_vsf_name(mod->name, "CIA1") && (data_size >= sizeof(_c64_vsf_cia))) {
+            cia[0] = (const _c64_vsf_cia*) data;
+        }
+        else if (_c64_vsf_name(mod->name, "CIA2") && (data_size >= sizeof(_c64_vsf_cia))) {
+            cia[1] = (const _c64_vsf_cia*) data;
+        }
+        else if (_c64_vsf_name(mod->name, "VIC-II") && (data_size >= sizeof(_c64_vsf_vic))) {
+            vic = (const _c64_vsf_vic*) data;
+        }
+        else if (_c64_vsf_name(mod->name, "SID") && (data_size >= 32)) {
+            /* the register bank is at the end of the simple SID module */
+            sid_regs = data + data_size - 32;
+        }
+        ptr += size;
+    }
+    if (!cpu || !mem) {
+        return false;
+    }
+
+    /* memory and CPU port (which also updates the memory mapping) */
+    memcpy(sys->ram, mem->ram, sizeof(sys->ram));
+    uint64_t pins = _c64_vsf_wr(0x0000, mem->cpu_port_dir);
+    m6510_iorq(&sys->cpu, pins);
+    pins = _c64_vsf_wr(0x0001, mem->cpu_port_data);
+    m6510_iorq(&sys->cpu, pins);
+
+    /* the CIAs, CIA-2 port A selects the VIC-II bank */
+    if (cia[0]) {
+        _c64_vsf_load_cia(&sys->cia_1, cia[0]);
+    }
+    if (cia[1]) {
+        _c64_vsf_load_cia(&sys->cia_2, cia[1]);
+        pins = 0;
+        M6526_SET_PAB(pins, 0xFF, 0xFF);
+        pins = m6526_tick(&sys->cia_2, pins);
+        sys->vic_bank_select = ((~M6526_GET_PA(pins))&3)<<14;
+    }
+
+    /* VIC-II registers and color RAM */
+    if (vic) {
+        m6569_reset(&sys->vic);
+        for (int i = 0; i < 0x2F; i++) {
+            /* skip the interrupt latch and the read-only collision registers */
+            if ((i != 0x19) && (i != 0x1E) && (i != 0x1F)) {
+                m6569_tick(&sys->vic, _c64_vsf_wr((uint16_t)i, vic->regs[i]) | M6569_CS);
+            }
+        }
+        sys->vic.reg.int_latch = vic->regs[0x19] & 0x8F;
+        sys->vic.reg.mcm = vic->regs[0x1E];
+        sys->vic.reg.mcd = vic->regs[0x1F];
+        sys->vic.rs.v_count = (vic->raster_line_h<<8 | vic->raster_line_l) % 312;
+        sys->vic.rs.h_count = vic->raster_cycle % 63;
+        for (int i = 0; i < 1024; i++) {
+            sys->color_ram[i] = vic->color_ram[i] & 0x0F;
+        }
+    }
+
+    /* SID registers (the filter and envelope state isn't restored) */
+    if (sid_regs) {
+        m6581_reset(&sys->sid);
+        for (int i = 0; i < 25; i++) {
+            m6581_tick(&sys->sid, _c64_vsf_wr((uint16_t)i, sid_regs[i]) | M6581_CS);
+        }
+    }
+
+    /* start the CPU at the snapshot PC */
+    const uint16_t pc = cpu->PC_h<<8 | cpu->PC_l;
+    m6502_set_a(&sys->cpu, cpu->A);
+    m6502_set_x(&sys->cpu, cpu->X);
+    m6502_set_y(&sys->cpu, cpu->Y);
+    m6502_set_s(&sys->cpu, cpu->SP);
+    m6502_set_p(&sys->cpu, cpu->P);
+    m6502_set_pc(&sys->cpu, pc);
+    pins = M6502_SYNC|M6502_RW;
+    M6502_SET_ADDR(pins, pc);
+    M6502_SET_DATA(pins, mem_rd(&sys->mem_cpu, pc));
+    sys->pins = pins;
+    return true;
+}
+
 bool c64_quickload(c64_t* sys, const uint8_t* ptr, int num_bytes) {
     CHIPS_ASSERT(sys && sys->valid);
+    if (_c64_is_vsf(ptr, num_bytes)) {
+        return _c64_load_vsf(sys, ptr, num_bytes);
+    }
     if (num_bytes < 2) {
         return false;
     }
@@ -1142,4 +1653,553 @@ bool c64_is_tape_motor_on(c64_t* sys) {
     return c1530_is_motor_on(&sys->c1530);
 }
 
+/*  The virtual disc drive
+
+    Instead of emulating the serial bus and the 1541 drive hardware, the
+    KERNAL's serial bus routines (LISTEN, TALK, SECOND, TKSA, CIOUT,
+    ACPTR, UNTLK, UNLSN) are trapped for device 8 and implemented natively,
+    files are served directly from the block chains of the inserted
+    .d64 image. This makes OPEN, CHKIN, CHRIN, GETIN and CLOSE work
+    through the normal KERNAL code paths. The KERNAL LOAD routine is
+    trapped as a whole so that files load instantly. The directory
+    listing ("$") is generated as a BASIC program.
+
+    Writing files isn't supported, and commands sent to the command
+    channel are ignored.
+*/
+#define _C64_KERNAL_TALK   (0xED09)
+#define _C64_KERNAL_LISTEN (0xED0C)
+#define _C64_KERNAL_SECOND (0xEDB9)
+#define _C64_KERNAL_TKSA   (0xEDC7)
+#define _C64_KERNAL_CIOUT  (0xEDDD)
+#define _C64_KERNAL_UNTLK  (0xEDEF)
+#define _C64_KERNAL_UNLSN  (0xEDFE)
+#define _C64_KERNAL_ACPTR  (0xEE13)
+#define _C64_KERNAL_LOAD   (0xF4A5)     /* default ILOAD vector target */
+#define _C64_VDRIVE_DEVICE (8)
+#define _C64_VDRIVE_DIR_TRACK (18)
+#define _C64_D64_SIZE (174848)          /* 35 tracks without error info */
+#define _C64_D64_SIZE_40 (196608)       /* 40 tracks without error info */
+#define _C64_D64_BLOCKS (683)           /* number of sectors on a 35-track disc */
+#define _C64_D64_BLOCKS_40 (768)        /* number of sectors on a 40-track disc */
+#define _C64_ST_EOI (0x40)              /* status byte bit: end of file */
+#define _C64_ST_TIMEOUT_READ (0x02)     /* status byte bit: read timeout */
+#define _C64_ST_VERIFY (0x10)           /* status byte bit: verify error */
+
+/* byte offset of a disc sector in the .d64 image, or -1 if not on disc */
+static int _c64_d64_offset(c64_t* sys, int track, int sector) {
+    if ((track < 1) || (track > 40)) {
+        return -1;
+    }
+    int offset = 0;
+    int num_sectors = 21;
+    for (int t = 1; t <= track; t++) {
+        num_sectors = (t <= 17) ? 21 : ((t <= 24) ? 19 : ((t <= 30) ? 18 : 17));
+        if (t < track) {
+            offset += num_sectors * 256;
+        }
+    }
+    if ((sector < 0) || (sector >= num_sectors) || ((offset + (sector+1) * 256) > sys->vdrive.disc_size)) {
+        return -1;
+    }
+    return offset + sector * 256;
+}
+
+static void _c64_vdrive_reset(c64_t* sys) {
+    c64_vdrive_t* vd = &sys->vdrive;
+    vd->listening = false;
+    vd->talking = false;
+    vd->opening = false;
+    vd->channel = 0;
+    vd->status = 73;    /* power-up message */
+    vd->status_pos = 0;
+    vd->name_len = 0;
+    memset(vd->channels, 0, sizeof(vd->channels));
+}
+
+bool c64_insert_disc(c64_t* sys, const uint8_t* ptr, int num_bytes) {
+    CHIPS_ASSERT(sys && sys->valid && ptr);
+    if (num_bytes < _C64_D64_SIZE) {
+        return false;
+    }
+    sys->vdrive.disc = ptr;
+    sys->vdrive.disc_size = num_bytes;
+    _c64_vdrive_reset(sys);
+    return true;
+}
+
+void c64_remove_disc(c64_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    sys->vdrive.disc = 0;
+    sys->vdrive.disc_size = 0;
+    _c64_vdrive_reset(sys);
+}
+
+bool c64_disc_inserted(c64_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    return 0 != sys->vdrive.disc;
+}
+
+/* match a file name pattern with '*' and '?' wildcards against a directory entry name */
+static bool _c64_vdrive_match(const uint8_t* pattern, int pattern_len, const uint8_t* name) {
+    int i = 0;
+    for (; i < pattern_len; i++) {
+        if (pattern[i] == '*') {
+            return true;
+        }
+        if ((i >= 16) || (name[i] == 0xA0)) {
+            return false;
+        }
+        if ((pattern[i] != '?') && (pattern[i] != name[i])) {
+            return false;
+        }
+    }
+    return (i == 16) || (name[i] == 0xA0);
+}
+
+/*  find a directory entry by file name pattern, returns the byte offset of the
+    32-byte directory entry in the disc image, or -1 if not found
+*/
+static int _c64_vdrive_find(c64_t* sys, const uint8_t* pattern, int pattern_len) {
+    const uint8_t* disc = sys->vdrive.disc;
+    int bam = _c64_d64_offset(sys, _C64_VDRIVE_DIR_TRACK, 0);
+    int track = disc[bam];
+    int sector = disc[bam+1];
+    /* the directory has at most 18 sectors, this also catches loops */
+    for (int n = 0; (n < 18) && (track != 0); n++) {
+        const int offset = _c64_d64_offset(sys, track, sector);
+        if (offset < 0) {
+            break;
+        }
+        for (int i = 0; i < 8; i++) {
+            const int entry = offset + i * 32;
+            const uint8_t type = disc[entry + 2];
+            /* only closed PRG, SEQ and USR files can be opened */
+            if ((type & 0x80) && ((type & 7) >= 1) && ((type & 7) <= 3)) {
+                if (_c64_vdrive_match(pattern, pattern_len, &disc[entry + 5])) {
+                    return entry;
+                }
+            }
+        }
+        track = disc[offset];
+        sector = disc[offset + 1];
+    }
+    return -1;
+}
+
+static void _c64_vdrive_dir_put(c64_vdrive_t* vd, uint8_t c) {
+    if (vd->dir_len < C64_VDRIVE_DIR_SIZE) {
+        vd->dir[vd->dir_len++] = c;
+    }
+}
+
+/* start a new BASIC line in the directory listing */
+static int _c64_vdrive_dir_line(c64_vdrive_t* vd, uint16_t line_number) {
+    const int line_start = vd->dir_len;
+    _c64_vdrive_dir_put(vd, 0);     /* line link, patched at end of line */
+    _c64_vdrive_dir_put(vd, 0);
+    _c64_vdrive_dir_put(vd, (uint8_t)line_number);
+    _c64_vdrive_dir_put(vd, (uint8_t)(line_number>>8));
+    return line_start;
+}
+
+/* finish a BASIC line, the link points to the next line in memory (program starts at 0x0401) */
+static void _c64_vdrive_dir_end_line(c64_vdrive_t* vd, int line_start) {
+    _c64_vdrive_dir_put(vd, 0);
+    if ((line_start + 1) < C64_VDRIVE_DIR_SIZE) {
+        const uint16_t next = (uint16_t)(0x0401 + vd->dir_len - 2);
+        vd->dir[line_start] = (uint8_t)next;
+        vd->dir[line_start + 1] = (uint8_t)(next>>8);
+    }
+}
+
+/* build the directory listing as BASIC program (including the 2-byte load address) */
+static void _c64_vdrive_build_dir(c64_t* sys) {
+    c64_vdrive_t* vd = &sys->vdrive;
+    const uint8_t* disc = vd->disc;
+    const int bam = _c64_d64_offset(sys, _C64_VDRIVE_DIR_TRACK, 0);
+    vd->dir_len = 0;
+    _c64_vdrive_dir_put(vd, 0x01);
+    _c64_vdrive_dir_put(vd, 0x04);
+
+    /* header line: 0 "DISC NAME" ID 2A (in reverse) */
+    int line = _c64_vdrive_dir_line(vd, 0);
+    _c64_vdrive_dir_put(vd, 0x12);
+    _c64_vdrive_dir_put(vd, '"');
+    for (int i = 0; i < 16; i++) {
+        const uint8_t c = disc[bam + 0x90 + i];
+        _c64_vdrive_dir_put(vd, (c == 0xA0) ? ' ' : c);
+    }
+    _c64_vdrive_dir_put(vd, '"');
+    _c64_vdrive_dir_put(vd, ' ');
+    _c64_vdrive_dir_put(vd, disc[bam + 0xA2]);
+    _c64_vdrive_dir_put(vd, disc[bam + 0xA3]);
+    _c64_vdrive_dir_put(vd, ' ');
+    _c64_vdrive_dir_put(vd, disc[bam + 0xA5]);
+    _c64_vdrive_dir_put(vd, disc[bam + 0xA6]);
+    _c64_vdrive_dir_end_line(vd, line);
+
+    /* one line per file: blocks "NAME" PRG */
+    static const char* types[8] = { "DEL", "SEQ", "PRG", "USR", "REL", "???", "???", "???" };
+    int track = disc[bam];
+    int sector = disc[bam + 1];
+    for (int n = 0; (n < 18) && (track != 0); n++) {
+        const int offset = _c64_d64_offset(sys, track, sector);
+        if (offset < 0) {
+            break;
+        }
+        for (int i = 0; i < 8; i++) {
+            const uint8_t* entry = &disc[offset + i * 32];
+            const uint8_t type = entry[2];
+            if (type == 0) {
+                /* scratched or unused entry */
+                continue;
+            }
+            const uint16_t blocks = (uint16_t)(entry[30] | (entry[31]<<8));
+            line = _c64_vdrive_dir_line(vd, blocks);
+            for (int pad = (blocks < 10) ? 3 : ((blocks < 100) ? 2 : 1); pad > 0; pad--) {
+                _c64_vdrive_dir_put(vd, ' ');
+            }
+            _c64_vdrive_dir_put(vd, '"');
+            int name_len = 0;
+            while ((name_len < 16) && (entry[5 + name_len] != 0xA0)) {
+                _c64_vdrive_dir_put(vd, entry[5 + name_len++]);
+            }
+            _c64_vdrive_dir_put(vd, '"');
+            for (; name_len < 16; name_len++) {
+                _c64_vdrive_dir_put(vd, ' ');
+            }
+            _c64_vdrive_dir_put(vd, (type & 0x80) ? ' ' : '*');
+            for (const char* t = types[type & 7]; *t; t++) {
+                _c64_vdrive_dir_put(vd, (uint8_t)*t);
+            }
+            _c64_vdrive_dir_put(vd, (type & 0x40) ? '<' : ' ');
+            _c64_vdrive_dir_end_line(vd, line);
+        }
+        track = disc[offset];
+        sector = disc[offset + 1];
+    }
+
+    /* last line: blocks free (the directory track isn't counted) */
+    uint16_t blocks_free = 0;
+    for (int t = 1; t <= 35; t++) {
+        if (t != _C64_VDRIVE_DIR_TRACK) {
+            blocks_free += disc[bam + 4 * t];
+        }
+    }
+    line = _c64_vdrive_dir_line(vd, blocks_free);
+    for (const char* t = "BLOCKS FREE.             "; *t; t++) {
+        _c64_vdrive_dir_put(vd, (uint8_t)*t);
+    }
+    _c64_vdrive_dir_end_line(vd, line);
+    _c64_vdrive_dir_put(vd, 0);
+    _c64_vdrive_dir_put(vd, 0);
+}
+
+/*  position a file channel at the start of a sector of the block chain, a
+    block chain can't be longer than the number of sectors on the disc, so
+    a longer chain must contain a loop and is treated like a bad sector link
+*/
+static bool _c64_vdrive_seek(c64_t* sys, c64_vdrive_channel_t* ch, int track, int sector) {
+    const int max_blocks = (sys->vdrive.disc_size >= _C64_D64_SIZE_40) ? _C64_D64_BLOCKS_40 : _C64_D64_BLOCKS;
+    const int offset = _c64_d64_offset(sys, track, sector);
+    if ((offset < 0) || (ch->num_blocks >= max_blocks)) {
+        ch->open = false;
+        sys->vdrive.status = 66;
+        sys->vdrive.status_pos = 0;
+        return false;
+    }
+    ch->num_blocks++;
+    ch->track = (uint8_t)track;
+    ch->sector = (uint8_t)sector;
+    ch->pos = 2;
+    /* in the last sector of a chain, the sector link is the index of the last byte */
+    ch->end = (sys->vdrive.disc[offset] == 0) ? (sys->vdrive.disc[offset + 1] + 1) : 256;
+    return true;
+}
+
+/* open a channel with the received file name */
+static void _c64_vdrive_open(c64_t* sys, int channel) {
+    c64_vdrive_t* vd = &sys->vdrive;
+    c64_vdrive_channel_t* ch = &vd->channels[channel];
+    memset(ch, 0, sizeof(*ch));
+    vd->status_pos = 0;
+    if (channel == 15) {
+        /* a command sent along with OPEN, ignored */
+        vd->status = 0;
+        return;
+    }
+    /* strip the drive prefix ("0:") and the file type and mode (",P,R") */
+    const uint8_t* name = vd->name;
+    int len = vd->name_len;
+    for (int i = 0; i < len; i++) {
+        if (name[i] == ':') {
+            name += i + 1;
+            len -= i + 1;
+            break;
+        }
+    }
+    for (int i = 0; i < len; i++) {
+        if (name[i] == ',') {
+            len = i;
+            break;
+        }
+    }
+    if ((vd->name_len > 0) && (vd->name[0] == '$')) {
+        _c64_vdrive_build_dir(sys);
+        ch->open = true;
+        ch->dir = true;
+        ch->pos = 0;
+        ch->end = vd->dir_len;
+        vd->status = 0;
+        return;
+    }
+    const int entry = (len > 0) ? _c64_vdrive_find(sys, name, len) : -1;
+    if (entry < 0) {
+        ch->open = false;
+        vd->status = 62;
+    }
+    else if (_c64_vdrive_seek(sys, ch, vd->disc[entry + 3], vd->disc[entry + 4])) {
+        ch->open = true;
+        vd->status = 0;
+    }
+}
+
+/* read the next byte from a channel, returns false if no byte was available */
+static bool _c64_vdrive_read(c64_t* sys, int channel, uint8_t* out_byte, bool* out_last) {
+    c64_vdrive_t* vd = &sys->vdrive;
+    if (channel == 15) {
+        /* the command channel returns the DOS status message */
+        static const char* msg_ok = "00, OK,00,00\r";
+        static const char* msg_not_found = "62,FILE NOT FOUND,00,00\r";
+        static const char* msg_illegal_ts = "66,ILLEGAL TRACK OR SECTOR,00,00\r";
+        static const char* msg_dos = "73,CBM DOS V2.6 1541,00,00\r";
+        const char* msg;
+        switch (vd->status) {
+            case 62: msg = msg_not_found; break;
+            case 66: msg = msg_illegal_ts; break;
+            case 73: msg = msg_dos; break;
+            default: msg = msg_ok; break;
+        }
+        const int len = (int)strlen(msg);
+        *out_byte = (uint8_t)msg[vd->status_pos++];
+        *out_last = (vd->status_pos >= len);
+        if (*out_last) {
+            vd->status_pos = 0;
+            vd->status = 0;
+        }
+        return true;
+    }
+    c64_vdrive_channel_t* ch = &vd->channels[channel];
+    if (!ch->open || (ch->pos >= ch->end)) {
+        return false;
+    }
+    if (ch->dir) {
+        *out_byte = vd->dir[ch->pos++];
+        *out_last = (ch->pos >= ch->end);
+        return true;
+    }
+    const int offset = _c64_d64_offset(sys, ch->track, ch->sector);
+    *out_byte = vd->disc[offset + ch->pos++];
+    *out_last = false;
+    if (ch->pos >= ch->end) {
+        const uint8_t next_track = vd->disc[offset];
+        if (next_track == 0) {
+            *out_last = true;
+        }
+        else if (!_c64_vdrive_seek(sys, ch, next_track, vd->disc[offset + 1])) {
+            /* broken or looping block chain, the DOS status is 66 now */
+            *out_last = true;
+        }
+    }
+    return true;
+}
+
+/* return from a trapped KERNAL subroutine (perform an RTS) */
+static uint64_t _c64_vdrive_rts(c64_t* sys, uint64_t pins, bool carry) {
+    uint8_t s = m6502_s(&sys->cpu);
+    const uint8_t l = mem_rd(&sys->mem_cpu, 0x0100 | ++s);
+    const uint8_t h = mem_rd(&sys->mem_cpu, 0x0100 | ++s);
+    m6502_set_s(&sys->cpu, s);
+    const uint16_t ret_addr = (uint16_t)(((h<<8) | l) + 1);
+    uint8_t p = m6502_p(&sys->cpu) & ~M6502_CF;
+    if (carry) {
+        p |= M6502_CF;
+    }
+    m6502_set_p(&sys->cpu, p);
+    M6502_SET_ADDR(pins, ret_addr);
+    M6502_SET_DATA(pins, mem_rd(&sys->mem_cpu, ret_addr));
+    m6502_set_pc(&sys->cpu, ret_addr);
+    return pins;
+}
+
+/*  the trapped KERNAL LOAD routine, entry:
+        A:      0 = load, 1 = verify
+        B7:     file name length
+        B9:     secondary address (0: load to address in C3/C4)
+        BA:     device number
+        BB/BC:  file name address
+        C3/C4:  load address
+    exit:
+        carry:  set on error, with error code in A (4: file not found)
+        X/Y:    end address (also in AE/AF)
+*/
+static uint64_t _c64_vdrive_load(c64_t* sys, uint64_t pins) {
+    c64_vdrive_t* vd = &sys->vdrive;
+    mem_t* mem = &sys->mem_cpu;
+    const bool verify = 0 != m6502_a(&sys->cpu);
+    vd->name_len = mem_rd(mem, 0xB7);
+    if (vd->name_len > C64_VDRIVE_MAX_NAME) {
+        vd->name_len = C64_VDRIVE_MAX_NAME;
+    }
+    const uint16_t name_addr = mem_rd16(mem, 0xBB);
+    for (int i = 0; i < vd->name_len; i++) {
+        vd->name[i] = mem_rd(mem, (uint16_t)(name_addr + i));
+    }
+    mem_wr(mem, 0x93, verify ? 1 : 0);
+    mem_wr(mem, 0x90, 0);
+    _c64_vdrive_open(sys, 0);
+    uint8_t lo, hi;
+    bool last = false;
+    if (!_c64_vdrive_read(sys, 0, &lo, &last) || last || !_c64_vdrive_read(sys, 0, &hi, &last)) {
+        vd->channels[0].open = false;
+        m6502_set_a(&sys->cpu, 4);
+        return _c64_vdrive_rts(sys, pins, true);
+    }
+    uint16_t addr = (mem_rd(mem, 0xB9) == 0) ? mem_rd16(mem, 0xC3) : (uint16_t)((hi<<8) | lo);
+    mem_wr16(mem, 0xC1, addr);
+    uint8_t st = _C64_ST_EOI;
+    while (!last) {
+        uint8_t data;
+        if (!_c64_vdrive_read(sys, 0, &data, &last)) {
+            break;
+        }
+        if (verify) {
+            if (mem_rd(mem, addr) != data) {
+                st |= _C64_ST_VERIFY;
+            }
+        }
+        else {
+            mem_wr(mem, addr, data);
+        }
+        addr++;
+    }
+    if (vd->status == 66) {
+        /* the block chain is broken, the error is in the DOS status */
+        st |= _C64_ST_TIMEOUT_READ;
+    }
+    vd->channels[0].open = false;
+    mem_wr(mem, 0x90, st);
+    mem_wr16(mem, 0xAE, addr);
+    m6502_set_x(&sys->cpu, (uint8_t)addr);
+    m6502_set_y(&sys->cpu, (uint8_t)(addr>>8));
+    return _c64_vdrive_rts(sys, pins, false);
+}
+
+static uint64_t _c64_vdrive_trap(c64_t* sys, uint64_t pins, uint16_t pc) {
+    c64_vdrive_t* vd = &sys->vdrive;
+    const uint8_t a = m6502_a(&sys->cpu);
+    switch (pc) {
+        case _C64_KERNAL_LOAD:
+            if (mem_rd(&sys->mem_cpu, 0xBA) == _C64_VDRIVE_DEVICE) {
+                pins = _c64_vdrive_load(sys, pins);
+            }
+            break;
+        case _C64_KERNAL_TALK:
+        case _C64_KERNAL_LISTEN:
+            /* A: device number, other devices go to the (empty) serial bus */
+            if (a == _C64_VDRIVE_DEVICE) {
+                vd->talking = (pc == _C64_KERNAL_TALK);
+                vd->listening = (pc == _C64_KERNAL_LISTEN);
+                pins = _c64_vdrive_rts(sys, pins, false);
+            }
+            else {
+                vd->talking = vd->listening = false;
+            }
+            break;
+        case _C64_KERNAL_SECOND:
+            /* A: secondary address after LISTEN (0x60: data, 0xE0: close, 0xF0: open) */
+            if (vd->listening) {
+                vd->channel = a & 0x0F;
+                vd->opening = false;
+                switch (a & 0xF0) {
+                    case 0xF0:
+                        vd->opening = true;
+                        vd->name_len = 0;
+                        break;
+                    case 0xE0:
+                        vd->channels[vd->channel].open = false;
+                        break;
+                    default:
+                        if (vd->channel == 15) {
+                            /* start of a command */
+                            vd->name_len = 0;
+                        }
+                        break;
+                }
+                pins = _c64_vdrive_rts(sys, pins, false);
+            }
+            break;
+        case _C64_KERNAL_TKSA:
+            /* A: secondary address after TALK */
+            if (vd->talking) {
+                vd->channel = a & 0x0F;
+                pins = _c64_vdrive_rts(sys, pins, false);
+            }
+            break;
+        case _C64_KERNAL_CIOUT:
+            /* A: byte to send, file names and commands are recorded, file data is ignored */
+            if (vd->listening) {
+                if ((vd->opening || (vd->channel == 15)) && (vd->name_len < C64_VDRIVE_MAX_NAME)) {
+                    vd->name[vd->name_len++] = a;
+                }
+                pins = _c64_vdrive_rts(sys, pins, false);
+            }
+            break;
+        case _C64_KERNAL_UNLSN:
+            if (vd->listening) {
+                if (vd->opening) {
+                    _c64_vdrive_open(sys, vd->channel);
+                }
+                else if ((vd->channel == 15) && (vd->name_len > 0)) {
+                    /* commands are ignored */
+                    vd->status = 0;
+                    vd->status_pos = 0;
+                }
+                vd->opening = false;
+                vd->listening = false;
+                pins = _c64_vdrive_rts(sys, pins, false);
+            }
+            break;
+        case _C64_KERNAL_UNTLK:
+            if (vd->talking) {
+                vd->talking = false;
+                pins = _c64_vdrive_rts(sys, pins, false);
+            }
+            break;
+        case _C64_KERNAL_ACPTR:
+            /* return the next byte in A, set EOI in the status byte on the last byte */
+            if (vd->talking) {
+                uint8_t data = 0x0D;
+                bool last = false;
+                uint8_t st = mem_rd(&sys->mem_cpu, 0x90);
+                if (_c64_vdrive_read(sys, vd->channel, &data, &last)) {
+                    if (last) {
+                        st |= _C64_ST_EOI;
+                    }
+                }
+                else {
+                    st |= _C64_ST_EOI|_C64_ST_TIMEOUT_READ;
+                }
+                mem_wr(&sys->mem_cpu, 0x90, st);
+                m6502_set_a(&sys->cpu, data);
+                pins = _c64_vdrive_rts(sys, pins, false);
+            }
+            break;
+        default:
+            break;
+    }
+    return pins;
+}
+
 #endif /* CHIPS_IMPL */
@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into cpc_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until cpc_discard() is called, and the
+        macro must be defined in all source files which include cpc.h)
+
     You need to include the following headers before including cpc.h:
 
+    - chips/chips_state.h
     - chips/z80.h
     - chips/ay38910.h
     - chips/i8255.h
@@ -44,6 +54,73 @@
 
     FIXME!
 
+    ## Beam Racing
+
+    The gate array writes pixels into the pixel buffer while the
+    emulated CRT beam moves across the screen. A scanline callback
+    can be used to upload completed lines early instead of waiting
+    for the end of the frame:
+
+    ~~~C
+    static void scanline_cb(int y0, int y1, void* user_data) {
+        // pixel buffer lines y0 to y1-1 are complete
+    }
+    ...
+    cpc_init(&sys, &(cpc_desc_t){
+        ...
+        .scanline_cb = scanline_cb,
+        .scanline_chunk = 8,    // default is 16 lines
+    });
+    ~~~
+
+    The callback receives the completed lines in chunks of scanline_chunk
+    lines (the last chunk before the bottom of the visible area may be
+    smaller), it is not called in debug visualization mode.
+
+    ## Frame Callback
+
+    The optional frame callback is called from inside cpc_exec() when
+    the gate array starts a new frame, at that point the pixel buffer contains
+    a complete frame. To render the next frame into a different pixel
+    buffer (for instance for video capture with util/capture.h), call
+    cpc_set_pixel_buffer() from inside the callback. The callback also gets
+    the number of emulated CPU ticks since cpc_init(), for instance as
+    frame timestamp:
+
+    ~~~C
+    static void frame_cb(uint64_t tick_count, void* user_data) {
+        cpc_set_pixel_buffer(&sys, capture_submit_frame(&cap, tick_count));
+    }
+    ~~~
+
+    The frame callback isn't called while cpc_exec_runahead() runs
+    with one or more run-ahead frames.
+
+    ## Run-Ahead
+
+    cpc_exec_runahead() reduces the input latency by running the emulation
+    a number of frames ahead, presenting the last of those frames, and
+    rolling the state back to the end of the 'real' frame:
+
+    ~~~C
+    static cpc_snapshot_t snapshot;
+    ...
+    // once per host frame, after applying the input
+    cpc_exec_runahead(&sys, &snapshot, frame_time_us, 2);
+    ~~~
+
+    Only the real frame produces audio output, and only the last run-ahead
+    frame is decoded into the pixel buffer (the gate array skips video
+    decoding while its rgba8_buffer pointer is null, this also suppresses
+    the scanline callback). With zero run-ahead frames, cpc_exec_runahead()
+    is identical to cpc_exec().
+
+    cpc_save_snapshot() and cpc_load_snapshot() are plain memory copies
+    of the cpc_t struct without the tape and floppy disc image buffers
+    (which are only read by the emulation). A snapshot can only be loaded
+    into the instance it was saved from, this way no internal pointers need
+    to be fixed up. Inserting a tape or disc invalidates existing snapshots.
+
     ## TODO
 
     - improve CRTC emulation, some graphics demos don't work yet
@@ -102,6 +179,12 @@ typedef enum {
 
 /* audio sample data callback */
 typedef void (*cpc_audio_callback_t)(const float* samples, int num_samples, void* user_data);
+/* beam racing callback, called with a range of completed pixel buffer lines [y0, y1) */
+typedef void (*cpc_scanline_callback_t)(int y0, int y1, void* user_data);
+/* frame callback, called at vsync when a complete frame is in the pixel buffer,
+   with the number of emulated CPU ticks since cpc_init()
+*/
+typedef void (*cpc_frame_callback_t)(uint64_t tick_count, void* user_data);
 
 /* configuration parameters for cpc_init() */
 typedef struct {
@@ -111,6 +194,9 @@ typedef struct {
     /* video output config */
     void* pixel_buffer;         /* pointer to a linear RGBA8 pixel buffer, at least 1024*312*4 bytes */
     int pixel_buffer_size;      /* size of the pixel buffer in bytes */
+    cpc_scanline_callback_t scanline_cb;    /* optional beam racing callback */
+    int scanline_chunk;         /* number of lines per scanline_cb call, default is 16 */
+    cpc_frame_callback_t frame_cb;  /* optional callback at vsync */
 
     /* optional user-data for audio- and video-debugging callbacks */
     void* user_data;
@@ -154,6 +240,7 @@ typedef struct {
     uint8_t joy_joymask;
     uint16_t casread_trap;
     uint16_t casread_ret;
+    uint64_t tick_count;        /* emulated CPU ticks since cpc_init() */
 
     clk_t clk;
     kbd_t kbd;
@@ -162,11 +249,21 @@ typedef struct {
     cpc_audio_callback_t audio_cb;
     int num_samples;
     int sample_pos;
+    cpc_scanline_callback_t scanline_cb;
+    int scanline_chunk;
+    int scanline_y0, scanline_y1;   /* range of completed lines not yet reported */
+    cpc_frame_callback_t frame_cb;
     float sample_buffer[CPC_MAX_AUDIO_SAMPLES];
     uint8_t ram[8][0x4000];
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom_os;
+    const uint8_t* rom_basic;
+    const uint8_t* rom_amsdos;
+#else
     uint8_t rom_os[0x4000];
     uint8_t rom_basic[0x4000];
     uint8_t rom_amsdos[0x4000];
+#endif
     /* tape loading */
     int tape_size;      /* tape_size is > 0 if a tape is inserted */
     int tape_pos;
@@ -175,6 +272,11 @@ typedef struct {
     fdd_t fdd;
 } cpc_t;
 
+/* a snapshot of the cpc_t state for run-ahead, see cpc_save_snapshot() */
+typedef struct {
+    cpc_t sys;
+} cpc_snapshot_t;
+
 /* initialize a new CPC instance */
 void cpc_init(cpc_t* cpc, const cpc_desc_t* desc);
 /* discard a CPC instance */
@@ -191,6 +293,14 @@ int cpc_display_height(cpc_t* sys);
 void cpc_reset(cpc_t* cpc);
 /* run CPC instance for given amount of micro_seconds */
 void cpc_exec(cpc_t* cpc, uint32_t micro_seconds);
+/* run the real frame, then run ahead a number of frames and roll back */
+void cpc_exec_runahead(cpc_t* sys, cpc_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames);
+/* save the system state into a snapshot (only for loading into the same instance) */
+void cpc_save_snapshot(const cpc_t* sys, cpc_snapshot_t* dst);
+/* load the system state from a snapshot saved from the same instance */
+void cpc_load_snapshot(cpc_t* sys, const cpc_snapshot_t* src);
+/* switch to another pixel buffer (at least as big as the one passed to cpc_init()) */
+void cpc_set_pixel_buffer(cpc_t* sys, void* pixel_buffer);
 /* send a key down event */
 void cpc_key_down(cpc_t* cpc, int key_code);
 /* send a key up event */
@@ -223,6 +333,7 @@ bool cpc_video_debugging_enabled(cpc_t* cpc);
 /*-- IMPLEMENTATION ----------------------------------------------------------*/
 #ifdef CHIPS_IMPL
 #include <string.h>
+#include <stddef.h> /* offsetof */
 #ifndef CHIPS_ASSERT
     #include <assert.h>
     #define CHIPS_ASSERT(c) assert(c)
@@ -232,6 +343,8 @@ bool cpc_video_debugging_enabled(cpc_t* cpc);
 
 static uint64_t _cpc_tick(int num, uint64_t pins, void* user_data);
 static uint64_t _cpc_cclk(void* user_data);
+static void _cpc_ga_crtline(int y, void* user_data);
+static void _cpc_ga_vsync(void* user_data);
 static void _cpc_psg_out(int port_id, uint8_t data, void* user_data);
 static uint8_t _cpc_psg_in(int port_id, void* user_data);
 static void _cpc_init_keymap(cpc_t* sys);
@@ -245,6 +358,11 @@ static void _cpc_fdc_driveinfo(int drive, void* user_data, upd765_driveinfo_t* o
 
 #define _CPC_DEFAULT(val,def) (((val) != 0) ? (val) : (def));
 #define _CPC_CLEAR(val) memset(&val, 0, sizeof(val))
+#if defined(CHIPS_SHARED_ROMS)
+#define _CPC_ROM(dst,src,size) dst = (const uint8_t*)(src)
+#else
+#define _CPC_ROM(dst,src,size) memcpy(dst, src, size)
+#endif
 
 void cpc_init(cpc_t* sys, const cpc_desc_t* desc) {
     CHIPS_ASSERT(sys && desc);
@@ -257,25 +375,28 @@ void cpc_init(cpc_t* sys, const cpc_desc_t* desc) {
     if (CPC_TYPE_464 == desc->type) {
         CHIPS_ASSERT(desc->rom_464_os && (desc->rom_464_os_size == 0x4000));
         CHIPS_ASSERT(desc->rom_464_basic && (desc->rom_464_basic_size == 0x4000));
-        memcpy(sys->rom_os, desc->rom_464_os, 0x4000);
-        memcpy(sys->rom_basic, desc->rom_464_basic, 0x4000);
+        _CPC_ROM(sys->rom_os, desc->rom_464_os, 0x4000);
+        _CPC_ROM(sys->rom_basic, desc->rom_464_basic, 0x4000);
     }
     else if (CPC_TYPE_6128 == desc->type) {
         CHIPS_ASSERT(desc->rom_6128_os && (desc->rom_6128_os_size == 0x4000));
         CHIPS_ASSERT(desc->rom_6128_basic && (desc->rom_6128_basic_size == 0x4000));
         CHIPS_ASSERT(desc->rom_6128_amsdos && (desc->rom_6128_amsdos_size == 0x4000));
-        memcpy(sys->rom_os, desc->rom_6128_os, 0x4000);
-        memcpy(sys->rom_basic, desc->rom_6128_basic, 0x4000);
-        memcpy(sys->rom_amsdos, desc->rom_6128_amsdos, 0x4000);
+        _CPC_ROM(sys->rom_os, desc->rom_6128_os, 0x4000);
+        _CPC_ROM(sys->rom_basic, desc->rom_6128_basic, 0x4000);
+        _CPC_ROM(sys->rom_amsdos, desc->rom_6128_amsdos, 0x4000);
     }
     else { /* KC Compact */
         CHIPS_ASSERT(desc->rom_kcc_os && (desc->rom_kcc_os_size == 0x4000));
         CHIPS_ASSERT(desc->rom_kcc_basic && (desc->rom_kcc_basic_size == 0x4000));
-        memcpy(sys->rom_os, desc->rom_kcc_os, 0x4000);
-        memcpy(sys->rom_basic, desc->rom_kcc_basic, 0x4000);
+        _CPC_ROM(sys->rom_os, desc->rom_kcc_os, 0x4000);
+        _CPC_ROM(sys->rom_basic, desc->rom_kcc_basic, 0x4000);
     }
     sys->user_data = desc->user_data;
     sys->audio_cb = desc->audio_cb;
+    sys->scanline_cb = desc->scanline_cb;
+    sys->scanline_chunk = _CPC_DEFAULT(desc->scanline_chunk, 16);
+    sys->frame_cb = desc->frame_cb;
     sys->num_samples = _CPC_DEFAULT(desc->audio_num_samples, CPC_DEFAULT_AUDIO_SAMPLES);
     CHIPS_ASSERT(sys->num_samples <= CPC_MAX_AUDIO_SAMPLES);
 
@@ -309,6 +430,8 @@ void cpc_init(cpc_t* sys, const cpc_desc_t* desc) {
     ga_desc.cpc_type = (am40010_cpc_type_t) sys->type;
     ga_desc.bankswitch_cb = _cpc_bankswitch;
     ga_desc.cclk_cb = _cpc_cclk;
+    ga_desc.crtline_cb = desc->scanline_cb ? _cpc_ga_crtline : 0;
+    ga_desc.vsync_cb = desc->frame_cb ? _cpc_ga_vsync : 0;
     ga_desc.ram = &sys->ram[0][0];
     ga_desc.ram_size = sizeof(sys->ram);
     ga_desc.rgba8_buffer = (uint32_t*) desc->pixel_buffer;
@@ -411,6 +534,59 @@ void cpc_exec(cpc_t* sys, uint32_t micro_seconds) {
     kbd_update(&sys->kbd, micro_seconds);
 }
 
+/* copy the system state, except for the read-only tape and disc image data */
+static void _cpc_copy_state(cpc_t* dst, const cpc_t* src) {
+    const size_t tape_start = offsetof(cpc_t, tape_buf);
+    const size_t tape_end = tape_start + sizeof(src->tape_buf);
+    const size_t disc_start = offsetof(cpc_t, fdd.data);
+    memcpy(dst, src, tape_start);
+    memcpy((uint8_t*)dst + tape_end, (const uint8_t*)src + tape_end, disc_start - tape_end);
+    memcpy((uint8_t*)dst + disc_start + sizeof(src->fdd.data),
+           (const uint8_t*)src + disc_start + sizeof(src->fdd.data),
+           sizeof(cpc_t) - (disc_start + sizeof(src->fdd.data)));
+}
+
+void cpc_save_snapshot(const cpc_t* sys, cpc_snapshot_t* dst) {
+    CHIPS_ASSERT(sys && sys->valid && dst);
+    _cpc_copy_state(&dst->sys, sys);
+}
+
+void cpc_load_snapshot(cpc_t* sys, const cpc_snapshot_t* src) {
+    CHIPS_ASSERT(sys && sys->valid && src && src->sys.valid);
+    /* the snapshot must have been saved from this instance */
+    CHIPS_ASSERT(src->sys.cpu.user_data == sys);
+    _cpc_copy_state(sys, &src->sys);
+}
+
+void cpc_exec_runahead(cpc_t* sys, cpc_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames) {
+    CHIPS_ASSERT(sys && sys->valid && snapshot && (num_frames >= 0));
+    if (0 == num_frames) {
+        cpc_exec(sys, micro_seconds);
+        return;
+    }
+    /* the real frame, the displayed frame comes from the last run-ahead frame */
+    uint32_t* rgba8_buffer = sys->ga.rgba8_buffer;
+    cpc_frame_callback_t frame_cb = sys->frame_cb;
+    sys->ga.rgba8_buffer = 0;
+    sys->frame_cb = 0;
+    cpc_exec(sys, micro_seconds);
+    sys->ga.rgba8_buffer = rgba8_buffer;
+    cpc_save_snapshot(sys, snapshot);
+    /* run ahead without audio output, loading the snapshot restores the pointers */
+    sys->audio_cb = 0;
+    for (int i = 0; i < num_frames; i++) {
+        sys->ga.rgba8_buffer = (i == (num_frames - 1)) ? rgba8_buffer : 0;
+        cpc_exec(sys, micro_seconds);
+    }
+    cpc_load_snapshot(sys, snapshot);
+    sys->frame_cb = frame_cb;
+}
+
+void cpc_set_pixel_buffer(cpc_t* sys, void* pixel_buffer) {
+    CHIPS_ASSERT(sys && sys->valid && pixel_buffer);
+    sys->ga.rgba8_buffer = (uint32_t*) pixel_buffer;
+}
+
 void cpc_key_down(cpc_t* sys, int key_code) {
     CHIPS_ASSERT(sys && sys->valid);
     if (sys->joystick_type == CPC_JOYSTICK_DIGITAL) {
@@ -473,6 +649,7 @@ bool cpc_video_debugging_enabled(cpc_t* sys) {
 /* the CPU tick callback */
 static uint64_t _cpc_tick(int num_ticks, uint64_t cpu_pins, void* user_data) {
     cpc_t* sys = (cpc_t*) user_data;
+    sys->tick_count += num_ticks;
 
     /* memory and IO requests */
     if (cpu_pins & Z80_MREQ) {
@@ -645,6 +822,36 @@ static uint64_t _cpc_cclk(void* user_data) {
     return crtc_pins;
 }
 
+/* called by the gate array when a visible CRT line has been completed,
+   the lines are collected and reported in chunks to the scanline callback
+*/
+static void _cpc_ga_crtline(int y, void* user_data) {
+    cpc_t* sys = (cpc_t*) user_data;
+    if (!sys->scanline_cb) {
+        return;
+    }
+    if (y != sys->scanline_y1) {
+        /* the beam jumped to a new frame, report any leftover lines */
+        if (sys->scanline_y0 < sys->scanline_y1) {
+            sys->scanline_cb(sys->scanline_y0, sys->scanline_y1, sys->user_data);
+        }
+        sys->scanline_y0 = y;
+    }
+    sys->scanline_y1 = y + 1;
+    if (((sys->scanline_y1 - sys->scanline_y0) >= sys->scanline_chunk) || (sys->scanline_y1 == AM40010_DISPLAY_HEIGHT)) {
+        sys->scanline_cb(sys->scanline_y0, sys->scanline_y1, sys->user_data);
+        sys->scanline_y0 = sys->scanline_y1;
+    }
+}
+
+/* called by the gate array when the CRT beam starts a new frame */
+static void _cpc_ga_vsync(void* user_data) {
+    cpc_t* sys = (cpc_t*) user_data;
+    if (sys->frame_cb) {
+        sys->frame_cb(sys->tick_count, sys->user_data);
+    }
+}
+
 /* PSG OUT callback (nothing to do here) */
 static void _cpc_psg_out(int port_id, uint8_t data, void* user_data) {
     /* this shouldn't be called */
@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into kc85_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until kc85_discard() is called, and the
+        macro must be defined in all source files which include kc85.h)
+
     You need to include the following headers before including kc85.h:
 
+    - chips/chips_state.h
     - chips/z80.h
     - chips/z80ctc.h
     - chips/z80pio.h
@@ -225,6 +235,27 @@
         - bits 2..6:    unused
         - bit 7:        enable the 4 KByte CAOS ROM bank at C000
 
+    ## Beam Racing
+
+    The video RAM is decoded into the pixel buffer in lock-step with the
+    emulated video timing, so completed lines can be presented before
+    the frame is finished. Set a scanline callback in kc85_desc_t
+    to get notified about completed lines:
+
+    ~~~C
+    static void scanline_cb(int y0, int y1, void* user_data) {
+        // lines y0 to y1-1 of the pixel buffer have been decoded
+    }
+    ...
+    kc85_init(&sys, &(kc85_desc_t){
+        ...
+        .scanline_cb = scanline_cb,
+        .scanline_chunk = 64,   // default is 16 lines
+    });
+    ~~~
+
+    The callback is only called when a pixel buffer is provided.
+
     ## TODO:
 
     - optionally proper keyboard emulation (the current implementation
@@ -297,6 +328,8 @@ typedef enum {
 
 /* audio sample callback */
 typedef void (*kc85_audio_callback_t)(const float* samples, int num_samples, void* user_data);
+/* beam racing callback, called with a range of decoded pixel buffer lines [y0, y1) */
+typedef void (*kc85_scanline_callback_t)(int y0, int y1, void* user_data);
 /* callback to apply patches after a snapshot is loaded */
 typedef void (*kc85_patch_callback_t)(const char* snapshot_name, void* user_data);
 
@@ -307,6 +340,8 @@ typedef struct {
     /* video output config (if you don't need display decoding, set pixel_buffer to 0) */
     void* pixel_buffer;         /* pointer to a linear RGBA8 pixel buffer, at least 320*256*4 bytes */
     int pixel_buffer_size;      /* size of the pixel buffer in bytes */
+    kc85_scanline_callback_t scanline_cb;   /* optional beam racing callback */
+    int scanline_chunk;         /* number of lines per scanline_cb call, default is 16 */
 
     /* optional user-data for callback functions */
     void* user_data;
@@ -397,6 +432,9 @@ typedef struct {
     kc85_exp_t exp;         /* expansion module system */
 
     uint32_t* pixel_buffer;
+    kc85_scanline_callback_t scanline_cb;
+    int scanline_chunk;
+    int scanline_y0;        /* first decoded line not yet reported */
     void* user_data;
     kc85_audio_callback_t audio_cb;
     int num_samples;
@@ -405,9 +443,15 @@ typedef struct {
     kc85_patch_callback_t patch_cb;
 
     uint8_t ram[8][0x4000];             /* up to 8 16-KByte RAM banks */
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom_basic;           /* 8 KByte BASIC ROM (KC85/3 and /4 only) */
+    const uint8_t* rom_caos_c;          /* 4 KByte CAOS ROM at 0xC000 (KC85/4 only) */
+    const uint8_t* rom_caos_e;          /* 8 KByte CAOS ROM at 0xE000 */
+#else
     uint8_t rom_basic[0x2000];          /* 8 KByte BASIC ROM (KC85/3 and /4 only) */
     uint8_t rom_caos_c[0x1000];         /* 4 KByte CAOS ROM at 0xC000 (KC85/4 only) */
     uint8_t rom_caos_e[0x2000];         /* 8 KByte CAOS ROM at 0xE000 */
+#endif
     uint8_t exp_buf[KC85_EXP_BUFSIZE];  /* expansion system RAM/ROM */
 } kc85_t;
 
@@ -500,6 +544,11 @@ static inline uint32_t _kc85_xorshift32(uint32_t x) {
 
 #define _KC85_DEFAULT(val,def) (((val) != 0) ? (val) : (def));
 #define _KC85_CLEAR(val) memset(&val, 0, sizeof(val))
+#if defined(CHIPS_SHARED_ROMS)
+#define _KC85_ROM(dst,src,size) dst = (const uint8_t*)(src)
+#else
+#define _KC85_ROM(dst,src,size) memcpy(dst, src, size)
+#endif
 
 void kc85_init(kc85_t* sys, const kc85_desc_t* desc) {
     CHIPS_ASSERT(sys && desc);
@@ -508,27 +557,27 @@ void kc85_init(kc85_t* sys, const kc85_desc_t* desc) {
     sys->valid = true;
     sys->type = desc->type;
 
-    /* copy ROM images */
+    /* copy or reference ROM images */
     if (desc->type == KC85_TYPE_2) {
         /* KC85/2 only has an 8 KByte OS ROM */
-        CHIPS_ASSERT(desc->rom_caos22 && (desc->rom_caos22_size == sizeof(sys->rom_caos_e)));
-        memcpy(sys->rom_caos_e, desc->rom_caos22, sizeof(sys->rom_caos_e));
+        CHIPS_ASSERT(desc->rom_caos22 && (desc->rom_caos22_size == 0x2000));
+        _KC85_ROM(sys->rom_caos_e, desc->rom_caos22, 0x2000);
     }
     else if (desc->type == KC85_TYPE_3) {
         /* KC85/3 has 8 KByte BASIC ROM and 8 KByte OS ROM */
-        CHIPS_ASSERT(desc->rom_kcbasic && (desc->rom_kcbasic_size == sizeof(sys->rom_basic)));
-        memcpy(sys->rom_basic, desc->rom_kcbasic, sizeof(sys->rom_basic));
-        CHIPS_ASSERT(desc->rom_caos31 && (desc->rom_caos31_size == sizeof(sys->rom_caos_e)));
-        memcpy(sys->rom_caos_e, desc->rom_caos31, sizeof(sys->rom_caos_e));
+        CHIPS_ASSERT(desc->rom_kcbasic && (desc->rom_kcbasic_size == 0x2000));
+        _KC85_ROM(sys->rom_basic, desc->rom_kcbasic, 0x2000);
+        CHIPS_ASSERT(desc->rom_caos31 && (desc->rom_caos31_size == 0x2000));
+        _KC85_ROM(sys->rom_caos_e, desc->rom_caos31, 0x2000);
     }
     else {
         /* KC85/4 has 8 KByte BASIC ROM, and 2 OS ROMs (4 KB and 8 KB) */
-        CHIPS_ASSERT(desc->rom_kcbasic && (desc->rom_kcbasic_size == sizeof(sys->rom_basic)));
-        memcpy(sys->rom_basic, desc->rom_kcbasic, sizeof(sys->rom_basic));
-        CHIPS_ASSERT(desc->rom_caos42c && (desc->rom_caos42c_size == sizeof(sys->rom_caos_c)));
-        memcpy(sys->rom_caos_c, desc->rom_caos42c, sizeof(sys->rom_caos_c));
-        CHIPS_ASSERT(desc->rom_caos42e && (desc->rom_caos42e_size == sizeof(sys->rom_caos_e)));
-        memcpy(sys->rom_caos_e, desc->rom_caos42e, sizeof(sys->rom_caos_e));
+        CHIPS_ASSERT(desc->rom_kcbasic && (desc->rom_kcbasic_size == 0x2000));
+        _KC85_ROM(sys->rom_basic, desc->rom_kcbasic, 0x2000);
+        CHIPS_ASSERT(desc->rom_caos42c && (desc->rom_caos42c_size == 0x1000));
+        _KC85_ROM(sys->rom_caos_c, desc->rom_caos42c, 0x1000);
+        CHIPS_ASSERT(desc->rom_caos42e && (desc->rom_caos42e_size == 0x2000));
+        _KC85_ROM(sys->rom_caos_e, desc->rom_caos42e, 0x2000);
     }
 
     /* fill RAM with noise (only KC85/2 and /3) */
@@ -547,6 +596,8 @@ void kc85_init(kc85_t* sys, const kc85_desc_t* desc) {
     /* video- and audio-output */
     CHIPS_ASSERT((0 == desc->pixel_buffer) || (desc->pixel_buffer && (desc->pixel_buffer_size >= _KC85_DISPLAY_SIZE)));
     sys->pixel_buffer = (uint32_t*) desc->pixel_buffer;
+    sys->scanline_cb = desc->scanline_cb;
+    sys->scanline_chunk = _KC85_DEFAULT(desc->scanline_chunk, 16);
     sys->audio_cb = desc->audio_cb;
     sys->patch_cb = desc->patch_cb;
     sys->user_data = desc->user_data;
@@ -720,7 +771,22 @@ static inline void _kc85_decode_8pixels(uint32_t* ptr, uint8_t pixels, uint8_t c
     ptr[4] = pixels & 0x08 ? fg : bg;
     ptr[5] = pixels & 0x04 ? fg : bg;
     ptr[6] = pixels & 0x02 ? fg : bg;
-    ptr[7] = pixels & 0x01 ? fg : bg;   
+    ptr[7] = pixels & 0x01 ? fg : bg;
+}
+
+/* called after a visible line has been decoded, lines are reported
+   in chunks to the scanline callback (the video timing always
+   decodes lines 0..255 in order)
+*/
+static void _kc85_scanline_done(kc85_t* sys, uint32_t y) {
+    const int y1 = (int)y + 1;
+    if ((y == 0) || (sys->scanline_y0 > (int)y)) {
+        sys->scanline_y0 = (int)y;
+    }
+    if (((y1 - sys->scanline_y0) >= sys->scanline_chunk) || (y1 == _KC85_DISPLAY_HEIGHT)) {
+        sys->scanline_cb(sys->scanline_y0, y1, sys->user_data);
+        sys->scanline_y0 = y1;
+    }
 }
 
 static uint64_t _kc85_video_kc85_2_3(kc85_t* sys, int num_cpu_ticks, uint64_t cpu_pins) {
@@ -770,6 +836,9 @@ static uint64_t _kc85_video_kc85_2_3(kc85_t* sys, int num_cpu_ticks, uint64_t cp
         sys->h_tick++;
         if (sys->h_tick >= 112) {
             sys->h_tick = 0;
+            if (sys->scanline_cb && sys->pixel_buffer && (sys->v_count < 256)) {
+                _kc85_scanline_done(sys, sys->v_count);
+            }
             sys->v_count++;
             if (sys->v_count == 312) {
                 sys->v_count = 0;
@@ -812,6 +881,9 @@ static uint64_t _kc85_video_kc85_4_hicolor(kc85_t* sys, int num_cpu_ticks, uint6
         sys->h_tick++;
         if (sys->h_tick >= 113) {
             sys->h_tick = 0;
+            if (sys->scanline_cb && sys->pixel_buffer && (sys->v_count < 256)) {
+                _kc85_scanline_done(sys, sys->v_count);
+            }
             sys->v_count++;
             if (sys->v_count == 312) {
                 sys->v_count = 0;
@@ -843,6 +915,9 @@ static uint64_t _kc85_video_kc85_4_std(kc85_t* sys, int num_cpu_ticks, uint64_t
         sys->h_tick++;
         if (sys->h_tick >= 113) {
             sys->h_tick = 0;
+            if (sys->scanline_cb && sys->pixel_buffer && (sys->v_count < 256)) {
+                _kc85_scanline_done(sys, sys->v_count);
+            }
             sys->v_count++;
             if (sys->v_count == 312) {
                 sys->v_count = 0;
@@ -867,6 +942,20 @@ static uint64_t _kc85_tick_video(kc85_t* sys, int num_cpu_ticks, uint64_t cpu_pi
     }
 }
 
+/* tick the beepers for one clock cycle, and push a new audio sample if ready */
+static inline void _kc85_tick_beepers(kc85_t* sys) {
+    beeper_tick(&sys->beeper_1);
+    if (beeper_tick(&sys->beeper_2)) {
+        sys->sample_buffer[sys->sample_pos++] = sys->beeper_1.sample + sys->beeper_2.sample;
+        if (sys->sample_pos == sys->num_samples) {
+            if (sys->audio_cb) {
+                sys->audio_cb(sys->sample_buffer, sys->num_samples, sys->user_data);
+            }
+            sys->sample_pos = 0;
+        }
+    }
+}
+
 static uint64_t _kc85_tick(int num_ticks, uint64_t pins, void* user_data) {
     kc85_t* sys = (kc85_t*) user_data;
 
@@ -974,9 +1063,20 @@ static uint64_t _kc85_tick(int num_ticks, uint64_t pins, void* user_data) {
     /* tick the video system, this may return Z80CTC_CLKTRG2 on VSYNC */
     pins = _kc85_tick_video(sys, num_ticks, pins);
 
-    /* tick the CTC and beepers */
-    for (int i = 0; i < num_ticks; i++) {
-        pins = z80ctc_tick(&sys->ctc, pins);
+    /* tick the CTC and beepers, the CTC is ticked in bulk up to its next
+       zero crossing, the beepers need to be ticked on each clock cycle
+    */
+    int ticks = num_ticks;
+    while (ticks > 0) {
+        int n = z80ctc_ticks_to_event(&sys->ctc);
+        if (n > ticks) {
+            n = ticks;
+        }
+        ticks -= n;
+        pins = z80ctc_tick_n(&sys->ctc, n, pins);
+        for (int i = 1; i < n; i++) {
+            _kc85_tick_beepers(sys);
+        }
         /* CTC channels 0 and 1 triggers control audio frequencies */
         if (pins & Z80CTC_ZCTO0) {
             beeper_toggle(&sys->beeper_1);
@@ -989,26 +1089,18 @@ static uint64_t _kc85_tick(int num_ticks, uint64_t pins, void* user_data) {
             sys->blink_flag = !sys->blink_flag;
         }
         pins &= Z80_PIN_MASK;
-        beeper_tick(&sys->beeper_1);
-        if (beeper_tick(&sys->beeper_2)) {
-            /* new audio sample ready */
-            sys->sample_buffer[sys->sample_pos++] = sys->beeper_1.sample + sys->beeper_2.sample;
-            if (sys->sample_pos == sys->num_samples) {
-                if (sys->audio_cb) {
-                    sys->audio_cb(sys->sample_buffer, sys->num_samples, sys->user_data);
-                }
-                sys->sample_pos = 0;
-            }
-        }
-    }    
-    
-    /* interrupt daisy chain, CTC is higher priority then PIO */
-    Z80_DAISYCHAIN_BEGIN(pins)
+        _kc85_tick_beepers(sys);
+    }
+
+    /* interrupt daisy chain, CTC is higher priority then PIO, the
+       daisy chain is skipped when no interrupt is pending or under service
+    */
+    Z80_DAISYCHAIN_BEGIN_IF(pins, sys->ctc.int_active|sys->pio.int_active)
     {
         pins = z80ctc_int(&sys->ctc, pins);
         pins = z80pio_int(&sys->pio, pins);
     }
-    Z80_DAISYCHAIN_END(pins);
+    Z80_DAISYCHAIN_END_IF(pins);
     
     return (pins & Z80_PIN_MASK);    
 }
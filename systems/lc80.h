@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into lc80_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until lc80_discard() is called, and the
+        macro must be defined in all source files which include lc80.h)
+
     You need to include the following headers before including lc80.h:
 
+    - chips/chips_state.h
     - chips/z80.h
     - chips/z80ctc.h
     - chips/z80pio.h
@@ -226,7 +236,11 @@ typedef struct {
     float sample_buffer[LC80_MAX_AUDIO_SAMPLES];
 
     uint8_t ram[0x0400];
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom;
+#else
     uint8_t rom[0x0800];
+#endif
 } lc80_t;
 
 void lc80_init(lc80_t* sys, const lc80_desc_t* desc);
@@ -264,8 +278,12 @@ void lc80_init(lc80_t* sys, const lc80_desc_t* desc) {
     sys->valid = true;
     sys->user_data = desc->user_data;
     
-    CHIPS_ASSERT(desc->rom_ptr && (desc->rom_size == sizeof(sys->rom)));
+    CHIPS_ASSERT(desc->rom_ptr && (desc->rom_size == 0x0800));
+    #if defined(CHIPS_SHARED_ROMS)
+    sys->rom = (const uint8_t*) desc->rom_ptr;
+    #else
     memcpy(sys->rom, desc->rom_ptr, sizeof(sys->rom));
+    #endif
 
     /* system clock is 900 kHz */
     const uint32_t freq_hz = 900000;
@@ -509,9 +527,9 @@ uint64_t _lc80_tick(int num_ticks, uint64_t pins, void* user_data) {
     if (pins & Z80_A1) { ctc_pins |= Z80CTC_CS1; }
     pins = z80ctc_iorq(&sys->ctc, ctc_pins) & Z80_PIN_MASK;
 
-    /* tick CTC and handle beeper */
+    /* tick CTC in bulk (the ZCTO pins are not connected), and handle beeper */
+    pins = z80ctc_tick_n(&sys->ctc, num_ticks, pins) & Z80_PIN_MASK;
     for (int i = 0; i < num_ticks; i++) {
-        pins = z80ctc_tick(&sys->ctc, pins);
         if (beeper_tick(&sys->beeper)) {
             /* new audio sample ready */
             sys->sample_buffer[sys->sample_pos++] = sys->beeper.sample;
@@ -524,14 +542,16 @@ uint64_t _lc80_tick(int num_ticks, uint64_t pins, void* user_data) {
         }
     }
 
-    /* interrupt daisychain priority is: CTC => User PIO => System PIO */
-    Z80_DAISYCHAIN_BEGIN(pins)
+    /* interrupt daisychain priority is: CTC => User PIO => System PIO,
+       skipped when no interrupt is pending or under service
+    */
+    Z80_DAISYCHAIN_BEGIN_IF(pins, sys->ctc.int_active|sys->pio_usr.int_active|sys->pio_sys.int_active)
     {
         pins = z80ctc_int(&sys->ctc, pins);
         pins = z80pio_int(&sys->pio_usr, pins);
         pins = z80pio_int(&sys->pio_sys, pins);
     }
-    Z80_DAISYCHAIN_END(pins);
+    Z80_DAISYCHAIN_END_IF(pins);
 
     /* NMI? */
     if (sys->nmi) {
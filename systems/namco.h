@@ -22,6 +22,15 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into namco_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until namco_discard() is called, and the
+        macro must be defined in all source files which include namco.h)
+
     Before including the implementation, select the hardware configuration
     through a define:
 
@@ -30,10 +39,101 @@
 
     You need to include the following headers before including namco.h:
 
+    - chips/chips_state.h
     - chips/z80.h
     - chips/clk.h
     - chips/mem.h
 
+    ## Batched Execution
+
+    For workloads which run many machines side by side (for instance
+    reinforcement learning agents), namco_exec_batch() runs an array of
+    namco_t instances for the same amount of emulated time in one call:
+
+    ~~~C
+    namco_t sys[256];
+    ...
+    namco_exec_batch(sys, 256, 16667);
+    ~~~
+
+    The instances are executed one after another, each by the regular
+    Z80 emulator, so instances may freely diverge (different RAM contents,
+    inputs and control flow). Running them back to back keeps the emulator
+    code and (with CHIPS_SHARED_ROMS) the ROM images hot in the host CPU
+    caches. Instances without an audio callback are run 'headless', the
+    sound chip isn't emulated at all (the CPU can't read back any sound
+    chip state, so this doesn't change the game logic). The headless
+    mode only lasts for the duration of the call and isn't part of the
+    machine state, so an instance can freely alternate between
+    namco_exec(), namco_exec_batch() and namco_step().
+
+    ## Reinforcement Learning Environment
+
+    namco_step() is a compact 'environment step' function: it replaces
+    the input state with an action (a mask of NAMCO_INPUT_* bits), runs
+    the machine for an exact number of frames (frame skipping), and
+    optionally renders a low-resolution observation directly from
+    video RAM, color RAM and the sprite registers, without going through
+    the RGBA8 pixel buffer:
+
+    ~~~C
+    uint8_t obs[NAMCO_OBS_SIZE];
+    namco_step_t step = {
+        .input = NAMCO_INPUT_P1_LEFT,
+        .num_frames = 4,
+        .obs = obs,
+    };
+    namco_step(&sys, &step);
+    // step.score and step.lives now contain the current score and lives
+    ~~~
+
+    The observation is the display area downscaled by 4 in each
+    direction (NAMCO_OBS_WIDTH x NAMCO_OBS_HEIGHT bytes), each byte is a
+    hardware color index (0..15 on Pacman, 0..31 on Pengo). Each 4x4
+    pixel block gets the most frequent non-background pixel color of the
+    underlying tile or sprite, so that thin details like dots and maze
+    walls survive the downscaling. The reduced tile and sprite images are
+    precomputed in namco_init().
+
+    The score and lives counters are read from RAM addresses declared
+    in namco_desc_t (e.g. on Pacman the score is stored as 3 BCD bytes
+    at 4E80, lowest byte first, and the remaining lives at 4E14):
+
+    ~~~C
+    namco_init(&sys, &(namco_desc_t){
+        ...
+        .score_addr = 0x4E80,
+        .score_size = 3,
+        .lives_addr = 0x4E14,
+    });
+    ~~~
+
+    Like namco_exec_batch(), namco_step() skips the sound emulation if
+    no audio callback has been provided.
+
+    ## Run-Ahead
+
+    namco_exec_runahead() replaces the namco_exec() and namco_decode_video()
+    calls of a frame and hides input latency by showing a frame from
+    the near future:
+
+    ~~~C
+    static namco_snapshot_t snapshot;
+    ...
+    // once per host frame, after applying the input
+    namco_exec_runahead(&sys, &snapshot, frame_time_us, 2);
+    ~~~
+
+    The real frame is run with sound, then a snapshot is saved, the
+    given number of frames is run ahead 'headless' (without sound
+    emulation), the video of the last run-ahead frame is decoded into
+    the pixel buffer, and the snapshot is loaded again.
+
+    namco_save_snapshot() and namco_load_snapshot() copy the namco_t struct
+    with a single memcpy(). Snapshots can only be loaded into the
+    instance they were saved from, so the internal pointers (memory
+    map, CPU callback user data) are always valid without fixups.
+
     For an example implementation, see:
 
     https://github.com/floooh/chips-test/blob/master/examples/sokol/pacman.c
@@ -67,6 +167,11 @@ extern "C" {
 #define NAMCO_MAX_AUDIO_SAMPLES (1024)
 #define NAMCO_DEFAULT_AUDIO_SAMPLES (128)
 
+/* size of the downscaled observation rendered by namco_step() */
+#define NAMCO_OBS_WIDTH (72)
+#define NAMCO_OBS_HEIGHT (56)
+#define NAMCO_OBS_SIZE (NAMCO_OBS_WIDTH*NAMCO_OBS_HEIGHT)
+
 /* input bits (use with namco_input_set() and namco_input_clear()) */
 #define NAMCO_INPUT_P1_UP       (1<<0)
 #define NAMCO_INPUT_P1_LEFT     (1<<1)
@@ -136,8 +241,28 @@ typedef struct {
     int rom_prom_0020_041F_size;
     int rom_sound_0000_00FF_size;
     int rom_sound_0100_01FF_size;
+
+    /* optional RAM locations of score and lives for namco_step() */
+    uint16_t score_addr;        /* address of the score in BCD format */
+    int score_size;             /* number of score bytes (0 if no score) */
+    bool score_msb_first;       /* true if the highest score byte comes first */
+    uint16_t lives_addr;        /* address of the lives counter (0 if none) */
 } namco_desc_t;
 
+/* in/out parameters for namco_step() */
+typedef struct {
+    /* in: input bits (NAMCO_INPUT_*) held down during the step */
+    uint32_t input;
+    /* in: number of frames to run (default: 1) */
+    int num_frames;
+    /* in: optional NAMCO_OBS_SIZE bytes buffer for the observation */
+    uint8_t* obs;
+    /* out: current score (0 if no score address declared) */
+    uint32_t score;
+    /* out: current lives counter (0 if no lives address declared) */
+    int lives;
+} namco_step_t;
+
 /* audio state */
 typedef struct {
     int tick_counter;
@@ -152,7 +277,11 @@ typedef struct {
         float sample;       /* accumulated sample value */
         float sample_div  ; /* oversampling divider */
     } voice[3];
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom[2];  /* wave table ROM */
+#else
     uint8_t rom[2][0x0100]; /* wave table ROM */
+#endif
     int num_samples;
     int sample_pos;
     namco_audio_callback_t callback;
@@ -180,16 +309,33 @@ typedef struct {
     mem_t mem;
     uint32_t* pixel_buffer;
     uint32_t palette_cache[512];    /* precomputed RGBA values, Pacman: 256 entries , Pengo: 512 entries*/
+    uint8_t obs_tiles[2][256];      /* downscaled tiles for namco_step(), 4 blocks a 2 bits */
+    uint32_t obs_sprites[2][64];    /* downscaled sprites for namco_step(), 16 blocks a 2 bits */
+    uint16_t score_addr;
+    int score_size;
+    bool score_msb_first;
+    uint16_t lives_addr;
     void* user_data;
     namco_sound_t sound;
     uint8_t video_ram[0x0400];
     uint8_t color_ram[0x0400];
     uint8_t main_ram[0x0800];       /* Pacman: 1 KB, Pengo: 2 KB */
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom_cpu[8];      /* program ROM in 4 KB chunks */
+    const uint8_t* rom_gfx[4];      /* tile and sprite ROM in 4 KB chunks */
+    const uint8_t* rom_prom[2];     /* palette and color lookup ROM */
+#else
     uint8_t rom_cpu[0x8000];        /* program ROM: Pacman: 16 KB, Pengo: 32 KB */
     uint8_t rom_gfx[0x4000];        /* tile ROM: Pacman: 8 KB, Pengo: 16 KB*/
     uint8_t rom_prom[0x0420];       /* palette and color lookup ROM */
+#endif
 } namco_t;
 
+/* a snapshot of the namco_t state for run-ahead, see namco_save_snapshot() */
+typedef struct {
+    namco_t sys;
+} namco_snapshot_t;
+
 /* initialize a new namco_t instance */
 void namco_init(namco_t* sys, const namco_desc_t* desc);
 /* discard a namco_t instance */
@@ -198,12 +344,22 @@ void namco_discard(namco_t* sys);
 void namco_reset(namco_t* sys);
 /* run namco_t instance for given amount of microseconds */
 void namco_exec(namco_t* sys, uint32_t micro_seconds);
+/* run an array of namco_t instances for given amount of microseconds */
+void namco_exec_batch(namco_t* sys, int num_instances, uint32_t micro_seconds);
 /* decode video to pixel buffer, must be called once per frame */
 void namco_decode_video(namco_t* sys);
+/* run the real frame, run ahead a number of frames, decode video and roll back */
+void namco_exec_runahead(namco_t* sys, namco_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames);
+/* save the system state into a snapshot (only for loading into the same instance) */
+void namco_save_snapshot(const namco_t* sys, namco_snapshot_t* dst);
+/* load the system state from a snapshot saved from the same instance */
+void namco_load_snapshot(namco_t* sys, const namco_snapshot_t* src);
 /* set input bits */
 void namco_input_set(namco_t* sys, uint32_t mask);
 /* clear input bits */
 void namco_input_clear(namco_t* sys, uint32_t mask);
+/* apply input, run a number of frames and render a low-res observation */
+void namco_step(namco_t* sys, namco_step_t* step);
 /* get the standard framebuffer width and height in pixels */
 int namco_std_display_width(void);
 int namco_std_display_height(void);
@@ -396,12 +552,41 @@ int namco_display_height(namco_t* sys);
 #define NAMCO_DISPLAY_SIZE      (NAMCO_DISPLAY_WIDTH*NAMCO_DISPLAY_HEIGHT*4)
 
 static uint64_t _namco_tick(int num, uint64_t pins, void* user_data);
+static uint64_t _namco_tick_headless(int num, uint64_t pins, void* user_data);
 static void _namco_sound_init(namco_t* sys, const namco_desc_t* desc);
 static void _namco_sound_wr(namco_t* sys, uint16_t addr, uint8_t data);
 static void _namco_sound_tick(namco_t* sys, int num_ticks);
+static void _namco_obs_init(namco_t* sys);
 
 #define _namco_def(val, def) (val == 0 ? def : val)
 
+/* get a 4 KB chunk of the program ROM */
+static inline const uint8_t* _namco_cpu_rom(const namco_t* sys, int chunk) {
+    #if defined(CHIPS_SHARED_ROMS)
+    return sys->rom_cpu[chunk];
+    #else
+    return &sys->rom_cpu[chunk * 0x1000];
+    #endif
+}
+
+/* get a 4 KB chunk of the tile and sprite ROM */
+static inline const uint8_t* _namco_gfx_rom(const namco_t* sys, int chunk) {
+    #if defined(CHIPS_SHARED_ROMS)
+    return sys->rom_gfx[chunk];
+    #else
+    return &sys->rom_gfx[chunk * 0x1000];
+    #endif
+}
+
+/* read a byte from the palette (0x00..0x1F) or color lookup ROM (0x20..) */
+static inline uint8_t _namco_prom(const namco_t* sys, int index) {
+    #if defined(CHIPS_SHARED_ROMS)
+    return (index < 0x20) ? sys->rom_prom[0][index] : sys->rom_prom[1][index - 0x20];
+    #else
+    return sys->rom_prom[index];
+    #endif
+}
+
 void namco_init(namco_t* sys, const namco_desc_t* desc) {
     CHIPS_ASSERT(sys && desc);
     CHIPS_ASSERT(desc->audio_sample_rate > 0);
@@ -441,6 +626,35 @@ void namco_init(namco_t* sys, const namco_desc_t* desc) {
     #endif
     CHIPS_ASSERT(desc->rom_sound_0000_00FF && (desc->rom_sound_0000_00FF_size == 0x0100));
     CHIPS_ASSERT(desc->rom_sound_0100_01FF && (desc->rom_sound_0100_01FF_size == 0x0100));
+    #if defined(CHIPS_SHARED_ROMS)
+    sys->rom_cpu[0] = (const uint8_t*) desc->rom_cpu_0000_0FFF;
+    sys->rom_cpu[1] = (const uint8_t*) desc->rom_cpu_1000_1FFF;
+    sys->rom_cpu[2] = (const uint8_t*) desc->rom_cpu_2000_2FFF;
+    sys->rom_cpu[3] = (const uint8_t*) desc->rom_cpu_3000_3FFF;
+    #if defined(NAMCO_PENGO)
+    sys->rom_cpu[4] = (const uint8_t*) desc->rom_cpu_4000_4FFF;
+    sys->rom_cpu[5] = (const uint8_t*) desc->rom_cpu_5000_5FFF;
+    sys->rom_cpu[6] = (const uint8_t*) desc->rom_cpu_6000_6FFF;
+    sys->rom_cpu[7] = (const uint8_t*) desc->rom_cpu_7000_7FFF;
+    #endif
+    #if defined(NAMCO_PACMAN)
+    sys->rom_gfx[0] = (const uint8_t*) desc->rom_gfx_0000_0FFF;
+    sys->rom_gfx[1] = (const uint8_t*) desc->rom_gfx_1000_1FFF;
+    #else
+    sys->rom_gfx[0] = (const uint8_t*) desc->rom_gfx_0000_1FFF;
+    sys->rom_gfx[1] = (const uint8_t*) desc->rom_gfx_0000_1FFF + 0x1000;
+    sys->rom_gfx[2] = (const uint8_t*) desc->rom_gfx_2000_3FFF;
+    sys->rom_gfx[3] = (const uint8_t*) desc->rom_gfx_2000_3FFF + 0x1000;
+    #endif
+    sys->rom_prom[0] = (const uint8_t*) desc->rom_prom_0000_001F;
+    #if defined(NAMCO_PACMAN)
+    sys->rom_prom[1] = (const uint8_t*) desc->rom_prom_0020_011F;
+    #else
+    sys->rom_prom[1] = (const uint8_t*) desc->rom_prom_0020_041F;
+    #endif
+    sys->sound.rom[0] = (const uint8_t*) desc->rom_sound_0000_00FF;
+    sys->sound.rom[1] = (const uint8_t*) desc->rom_sound_0100_01FF;
+    #else
     memcpy(&sys->rom_cpu[0x0000], desc->rom_cpu_0000_0FFF, 0x1000);
     memcpy(&sys->rom_cpu[0x1000], desc->rom_cpu_1000_1FFF, 0x1000);
     memcpy(&sys->rom_cpu[0x2000], desc->rom_cpu_2000_2FFF, 0x1000);
@@ -466,10 +680,18 @@ void namco_init(namco_t* sys, const namco_desc_t* desc) {
     #endif
     memcpy(sys->sound.rom[0], desc->rom_sound_0000_00FF, 0x0100);
     memcpy(sys->sound.rom[1], desc->rom_sound_0100_01FF, 0x0100);
+    #endif
 
     /* vsync/vblank counters */
     sys->vsync_count = NAMCO_VSYNC_PERIOD;
 
+    /* RAM locations for namco_step() */
+    CHIPS_ASSERT((desc->score_size >= 0) && (desc->score_size <= 4));
+    sys->score_addr = desc->score_addr;
+    sys->score_size = desc->score_size;
+    sys->score_msb_first = desc->score_msb_first;
+    sys->lives_addr = desc->lives_addr;
+
     /* system clock and CPU */
     clk_init(&sys->clk, NAMCO_CPU_CLOCK);
     z80_desc_t cpu_desc;
@@ -521,20 +743,20 @@ void namco_init(namco_t* sys, const namco_desc_t* desc) {
 
     */
     mem_init(&sys->mem);
-    mem_map_rom(&sys->mem, 0, 0x0000, 0x1000, &sys->rom_cpu[0x0000]);
-    mem_map_rom(&sys->mem, 0, 0x1000, 0x1000, &sys->rom_cpu[0x1000]);
-    mem_map_rom(&sys->mem, 0, 0x2000, 0x1000, &sys->rom_cpu[0x2000]);
-    mem_map_rom(&sys->mem, 0, 0x3000, 0x1000, &sys->rom_cpu[0x3000]);
+    mem_map_rom(&sys->mem, 0, 0x0000, 0x1000, _namco_cpu_rom(sys, 0));
+    mem_map_rom(&sys->mem, 0, 0x1000, 0x1000, _namco_cpu_rom(sys, 1));
+    mem_map_rom(&sys->mem, 0, 0x2000, 0x1000, _namco_cpu_rom(sys, 2));
+    mem_map_rom(&sys->mem, 0, 0x3000, 0x1000, _namco_cpu_rom(sys, 3));
     #if defined(NAMCO_PACMAN)
         mem_map_ram(&sys->mem, 0, 0x4000, 0x0400, sys->video_ram);
         mem_map_ram(&sys->mem, 0, 0x4400, 0x0400, sys->color_ram);
         mem_map_ram(&sys->mem, 0, 0x4C00, 0x0400, sys->main_ram);
     #endif
     #if defined(NAMCO_PENGO)
-        mem_map_rom(&sys->mem, 0, 0x4000, 0x1000, &sys->rom_cpu[0x4000]);
-        mem_map_rom(&sys->mem, 0, 0x5000, 0x1000, &sys->rom_cpu[0x5000]);
-        mem_map_rom(&sys->mem, 0, 0x6000, 0x1000, &sys->rom_cpu[0x6000]);
-        mem_map_rom(&sys->mem, 0, 0x7000, 0x1000, &sys->rom_cpu[0x7000]);
+        mem_map_rom(&sys->mem, 0, 0x4000, 0x1000, _namco_cpu_rom(sys, 4));
+        mem_map_rom(&sys->mem, 0, 0x5000, 0x1000, _namco_cpu_rom(sys, 5));
+        mem_map_rom(&sys->mem, 0, 0x6000, 0x1000, _namco_cpu_rom(sys, 6));
+        mem_map_rom(&sys->mem, 0, 0x7000, 0x1000, _namco_cpu_rom(sys, 7));
         mem_map_ram(&sys->mem, 0, 0x8000, 0x0400, sys->video_ram);
         mem_map_ram(&sys->mem, 0, 0x8400, 0x0400, sys->color_ram);
         mem_map_ram(&sys->mem, 0, 0x8800, 0x0800, sys->main_ram);
@@ -551,17 +773,20 @@ void namco_init(namco_t* sys, const namco_desc_t* desc) {
 
            Intensities are: 0x97 + 0x47 + 0x21
         */
-        uint8_t rgb = sys->rom_prom[i];
+        uint8_t rgb = _namco_prom(sys, i);
         uint8_t r = ((rgb>>0)&1) * 0x21 + ((rgb>>1)&1) * 0x47 + ((rgb>>2)&1) * 0x97;
         uint8_t g = ((rgb>>3)&1) * 0x21 + ((rgb>>4)&1) * 0x47 + ((rgb>>5)&1) * 0x97;
         uint8_t b = ((rgb>>6)&1) * 0x47 + ((rgb>>7)&1) * 0x97;
         hw_colors[i] = 0xFF000000 | (b<<16) | (g<<8) | r;
     }
     for (int i = 0; i < 256; i++) {
-        uint8_t pal_index = sys->rom_prom[i + 0x20] & 0xF;
+        uint8_t pal_index = _namco_prom(sys, i + 0x20) & 0xF;
         sys->palette_cache[i] = hw_colors[pal_index];
         sys->palette_cache[256 + i] = hw_colors[0x10 | pal_index];
     }
+
+    /* precompute downscaled tiles and sprites for namco_step() */
+    _namco_obs_init(sys);
 }
 
 void namco_discard(namco_t* sys) {
@@ -574,6 +799,19 @@ void namco_reset(namco_t* sys) {
     z80_reset(&sys->cpu);
 }
 
+/* run the CPU for a number of ticks, optionally without sound emulation;
+   the headless tick callback is only installed for the duration of the call
+*/
+static uint32_t _namco_exec_ticks(namco_t* sys, uint32_t ticks, bool sound) {
+    if (sound) {
+        return z80_exec(&sys->cpu, ticks);
+    }
+    sys->cpu.tick_cb = _namco_tick_headless;
+    uint32_t ticks_executed = z80_exec(&sys->cpu, ticks);
+    sys->cpu.tick_cb = _namco_tick;
+    return ticks_executed;
+}
+
 void namco_exec(namco_t* sys, uint32_t micro_seconds) {
     CHIPS_ASSERT(sys && sys->valid);
     uint32_t ticks_to_run = clk_ticks_to_run(&sys->clk, micro_seconds);
@@ -581,9 +819,48 @@ void namco_exec(namco_t* sys, uint32_t micro_seconds) {
     clk_ticks_executed(&sys->clk, ticks_executed);
 }
 
-static uint64_t _namco_tick(int num_ticks, uint64_t pins, void* user_data) {
-    namco_t* sys = (namco_t*) user_data;
+void namco_exec_batch(namco_t* sys, int num_instances, uint32_t micro_seconds) {
+    CHIPS_ASSERT(sys && (num_instances >= 0));
+    for (int i = 0; i < num_instances; i++) {
+        namco_t* inst = &sys[i];
+        CHIPS_ASSERT(inst->valid);
+        uint32_t ticks_to_run = clk_ticks_to_run(&inst->clk, micro_seconds);
+        uint32_t ticks_executed = _namco_exec_ticks(inst, ticks_to_run, 0 != inst->sound.callback);
+        clk_ticks_executed(&inst->clk, ticks_executed);
+    }
+}
+
+void namco_save_snapshot(const namco_t* sys, namco_snapshot_t* dst) {
+    CHIPS_ASSERT(sys && sys->valid && dst);
+    memcpy(&dst->sys, sys, sizeof(namco_t));
+}
+
+void namco_load_snapshot(namco_t* sys, const namco_snapshot_t* src) {
+    CHIPS_ASSERT(sys && sys->valid && src && src->sys.valid);
+    /* the snapshot must have been saved from this instance */
+    CHIPS_ASSERT(src->sys.cpu.user_data == sys);
+    memcpy(sys, &src->sys, sizeof(namco_t));
+}
 
+void namco_exec_runahead(namco_t* sys, namco_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames) {
+    CHIPS_ASSERT(sys && sys->valid && snapshot && (num_frames >= 0));
+    namco_exec(sys, micro_seconds);
+    if (num_frames > 0) {
+        namco_save_snapshot(sys, snapshot);
+        for (int i = 0; i < num_frames; i++) {
+            uint32_t ticks_to_run = clk_ticks_to_run(&sys->clk, micro_seconds);
+            uint32_t ticks_executed = _namco_exec_ticks(sys, ticks_to_run, false);
+            clk_ticks_executed(&sys->clk, ticks_executed);
+        }
+        namco_decode_video(sys);
+        namco_load_snapshot(sys, snapshot);
+    }
+    else {
+        namco_decode_video(sys);
+    }
+}
+
+static inline uint64_t _namco_tick_impl(int num_ticks, uint64_t pins, namco_t* sys, bool sound) {
     /* update the vsync counter and trigger VSYNC interrupt*/
     sys->vsync_count -= num_ticks;
     if (sys->vsync_count < 0) {
@@ -594,7 +871,9 @@ static uint64_t _namco_tick(int num_ticks, uint64_t pins, void* user_data) {
     }
 
     /* tick the sound chip */
-    _namco_sound_tick(sys, num_ticks);
+    if (sound) {
+        _namco_sound_tick(sys, num_ticks);
+    }
 
     /* memory requests */
     uint16_t addr = Z80_GET_ADDR(pins) & NAMCO_ADDR_MASK;
@@ -682,6 +961,15 @@ static uint64_t _namco_tick(int num_ticks, uint64_t pins, void* user_data) {
     return pins & Z80_PIN_MASK;
 }
 
+static uint64_t _namco_tick(int num_ticks, uint64_t pins, void* user_data) {
+    return _namco_tick_impl(num_ticks, pins, (namco_t*) user_data, true);
+}
+
+/* tick callback without sound emulation, see _namco_exec_ticks() */
+static uint64_t _namco_tick_headless(int num_ticks, uint64_t pins, void* user_data) {
+    return _namco_tick_impl(num_ticks, pins, (namco_t*) user_data, false);
+}
+
 /* get video memory offset from x/y coords:
     https://www.walkofmind.com/programming/pie/video_memory.htm
 */
@@ -701,7 +989,7 @@ static uint16_t _namco_video_offset(uint32_t x, uint32_t y) {
 /* 8x4 video tile decoder (used both for background tiles and sprites) */
 static inline void _namco_8x4(
     uint32_t* pixel_base,
-    uint8_t* tile_base,
+    const uint8_t* tile_base,
     uint32_t* palette_base,
     uint32_t tile_stride,
     uint32_t tile_offset,
@@ -742,7 +1030,7 @@ static inline void _namco_8x4(
 static void _namco_decode_chars(namco_t* sys) {
     uint32_t* pixel_base = sys->pixel_buffer;
     uint32_t* pal_base = &sys->palette_cache[(sys->pal_select<<8)|(sys->clut_select<<7)];
-    uint8_t* tile_base = &sys->rom_gfx[0x0000] + (sys->tile_select * 0x2000);
+    const uint8_t* tile_base = _namco_gfx_rom(sys, 0 + sys->tile_select * 2);
     for (uint32_t y = 0; y < 28; y++) {
         for (uint32_t x = 0; x < 36; x++) {
             uint16_t offset = _namco_video_offset(x, y);
@@ -757,7 +1045,7 @@ static void _namco_decode_chars(namco_t* sys) {
 static void _namco_decode_sprites(namco_t* sys) {
     uint32_t* pixel_base = sys->pixel_buffer;
     uint32_t* pal_base = &sys->palette_cache[(sys->pal_select<<8)|(sys->clut_select<<7)];
-    uint8_t* tile_base = &sys->rom_gfx[0x1000] + (sys->tile_select * 0x2000);
+    const uint8_t* tile_base = _namco_gfx_rom(sys, 1 + sys->tile_select * 2);
     #if defined(NAMCO_PACMAN)
     const int max_sprite = 6;
     const int min_sprite = 1;
@@ -920,6 +1208,153 @@ int namco_display_height(namco_t* sys) {
     return NAMCO_DISPLAY_HEIGHT;
 }
 
+/* decode an unflipped 8x4 pixel strip into 2-bit pixels with a row pitch of 16 */
+static void _namco_obs_strip(uint8_t* dst, const uint8_t* tile_base, uint32_t tile_index) {
+    for (uint32_t yy = 0; yy < 8; yy++) {
+        const uint8_t bits = tile_base[tile_index + yy];
+        for (uint32_t xx = 0; xx < 4; xx++) {
+            dst[yy*16 + xx] = (((bits>>(7-xx)) & 1)<<1) | ((bits>>(3-xx)) & 1);
+        }
+    }
+}
+
+/* reduce a 4x4 pixel block to its most frequent non-zero pixel value */
+static uint32_t _namco_obs_block(const uint8_t* src) {
+    int count[4] = { 0 };
+    for (int y = 0; y < 4; y++) {
+        for (int x = 0; x < 4; x++) {
+            count[src[y*16 + x]]++;
+        }
+    }
+    uint32_t val = 0;
+    int max_count = 0;
+    for (uint32_t i = 1; i < 4; i++) {
+        if (count[i] > max_count) {
+            max_count = count[i];
+            val = i;
+        }
+    }
+    return val;
+}
+
+/* precompute the 4x downscaled tile and sprite images (strip layout as in _namco_decode_chars/sprites) */
+static void _namco_obs_init(namco_t* sys) {
+    #if defined(NAMCO_PACMAN)
+    const int num_banks = 1;
+    #else
+    const int num_banks = 2;
+    #endif
+    uint8_t pixels[16*16];
+    for (int bank = 0; bank < num_banks; bank++) {
+        const uint8_t* tile_base = _namco_gfx_rom(sys, 0 + bank * 2);
+        for (uint32_t code = 0; code < 256; code++) {
+            _namco_obs_strip(&pixels[0], tile_base, code*16 + 8);
+            _namco_obs_strip(&pixels[4], tile_base, code*16 + 0);
+            uint8_t blocks = 0;
+            for (uint32_t i = 0; i < 4; i++) {
+                blocks |= _namco_obs_block(&pixels[(i>>1)*4*16 + (i&1)*4]) << (i*2);
+            }
+            sys->obs_tiles[bank][code] = blocks;
+        }
+        const uint8_t* sprite_base = _namco_gfx_rom(sys, 1 + bank * 2);
+        static const uint32_t strip_offsets[8] = { 8, 16, 24, 0, 40, 48, 56, 32 };
+        for (uint32_t code = 0; code < 64; code++) {
+            for (uint32_t i = 0; i < 8; i++) {
+                _namco_obs_strip(&pixels[(i>>2)*8*16 + (i&3)*4], sprite_base, code*64 + strip_offsets[i]);
+            }
+            uint32_t blocks = 0;
+            for (uint32_t i = 0; i < 16; i++) {
+                blocks |= _namco_obs_block(&pixels[(i>>2)*4*16 + (i&3)*4]) << (i*2);
+            }
+            sys->obs_sprites[bank][code] = blocks;
+        }
+    }
+}
+
+/* map a color code and 2-bit pixel value to a hardware color index */
+static inline uint8_t _namco_obs_color(const namco_t* sys, uint32_t color_code, uint32_t pixel) {
+    uint32_t index = (sys->clut_select<<7) | ((color_code & 0x1F)<<2) | pixel;
+    return (uint8_t) ((sys->pal_select<<4) | (_namco_prom(sys, 0x20 + index) & 0xF));
+}
+
+static void _namco_obs_render(namco_t* sys, uint8_t* obs) {
+    /* background tiles, each tile covers 2x2 observation pixels */
+    const uint8_t* tiles = sys->obs_tiles[sys->tile_select];
+    for (uint32_t y = 0; y < 28; y++) {
+        for (uint32_t x = 0; x < 36; x++) {
+            uint16_t offset = _namco_video_offset(x, y);
+            uint8_t blocks = tiles[sys->video_ram[offset]];
+            uint8_t color_code = sys->color_ram[offset];
+            uint8_t* dst = &obs[(y*2)*NAMCO_OBS_WIDTH + x*2];
+            dst[0] = _namco_obs_color(sys, color_code, (blocks>>0) & 3);
+            dst[1] = _namco_obs_color(sys, color_code, (blocks>>2) & 3);
+            dst[NAMCO_OBS_WIDTH + 0] = _namco_obs_color(sys, color_code, (blocks>>4) & 3);
+            dst[NAMCO_OBS_WIDTH + 1] = _namco_obs_color(sys, color_code, (blocks>>6) & 3);
+        }
+    }
+    /* sprites, each sprite covers 4x4 observation pixels, black is transparent */
+    const uint32_t* sprites = sys->obs_sprites[sys->tile_select];
+    #if defined(NAMCO_PACMAN)
+    const int max_sprite = 6;
+    const int min_sprite = 1;
+    #else
+    const int max_sprite = 7;
+    const int min_sprite = 0;
+    #endif
+    for (int sprite_index = max_sprite; sprite_index >= min_sprite; --sprite_index) {
+        int py = ((int)sys->sprite_coords[sprite_index*2 + 0] - 31) >> 2;
+        int px = (272 - (int)sys->sprite_coords[sprite_index*2 + 1]) >> 2;
+        uint8_t shape = sys->main_ram[NAMCO_ADDR_SPRITES_ATTR + sprite_index*2 + 0];
+        uint8_t color_code = sys->main_ram[NAMCO_ADDR_SPRITES_ATTR + sprite_index*2 + 1];
+        uint32_t blocks = sprites[shape>>2];
+        uint32_t xor_x = (shape & 1) ? 3 : 0;
+        uint32_t xor_y = (shape & 2) ? 3 : 0;
+        for (uint32_t i = 0; i < 16; i++) {
+            int x = px + (int)((i & 3) ^ xor_x);
+            int y = py + (int)((i >> 2) ^ xor_y);
+            if ((x < 0) || (x >= NAMCO_OBS_WIDTH) || (y < 0) || (y >= NAMCO_OBS_HEIGHT)) {
+                continue;
+            }
+            uint8_t color = _namco_obs_color(sys, color_code, (blocks >> (i*2)) & 3);
+            if (_namco_prom(sys, color) != 0) {
+                obs[y*NAMCO_OBS_WIDTH + x] = color;
+            }
+        }
+    }
+}
+
+void namco_step(namco_t* sys, namco_step_t* step) {
+    CHIPS_ASSERT(sys && sys->valid && step);
+    CHIPS_ASSERT(step->num_frames >= 0);
+
+    /* replace the input state with the action */
+    namco_input_clear(sys, 0xFFFFFFFF);
+    namco_input_set(sys, step->input);
+
+    /* run an exact number of frames, carrying over the overrun ticks */
+    const int num_frames = _namco_def(step->num_frames, 1);
+    int ticks_to_run = num_frames * NAMCO_VSYNC_PERIOD - sys->clk.overrun_ticks;
+    if (ticks_to_run < 1) {
+        ticks_to_run = 1;
+    }
+    sys->clk.ticks_to_run = ticks_to_run;
+    uint32_t ticks_executed = _namco_exec_ticks(sys, (uint32_t)ticks_to_run, 0 != sys->sound.callback);
+    clk_ticks_executed(&sys->clk, ticks_executed);
+
+    if (step->obs) {
+        _namco_obs_render(sys, step->obs);
+    }
+
+    /* score (BCD) and lives from RAM */
+    step->score = 0;
+    for (int i = 0; i < sys->score_size; i++) {
+        int byte_index = sys->score_msb_first ? i : (sys->score_size - 1 - i);
+        uint8_t bcd = mem_rd(&sys->mem, (uint16_t)(sys->score_addr + byte_index));
+        step->score = step->score * 100 + (bcd>>4) * 10 + (bcd & 0xF);
+    }
+    step->lives = sys->lives_addr ? mem_rd(&sys->mem, sys->lives_addr) : 0;
+}
+
 static void _namco_sound_init(namco_t* sys, const namco_desc_t* desc) {
     CHIPS_ASSERT(desc->audio_num_samples <= NAMCO_MAX_AUDIO_SAMPLES);
     /* assume zero-initialized */
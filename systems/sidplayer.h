@@ -0,0 +1,863 @@
+#pragma once
+/*#
+    # sidplayer.h
+
+    A standalone C64 PSID/RSID music player in a C header.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    sidplayer_render_batch() runs on the worker threads of util/batch.h
+    (Win32 threads on Windows, pthreads everywhere else, link with -pthread).
+
+    You need to include the following headers before including sidplayer.h:
+
+    - chips/chips_state.h
+    - chips/m6502.h
+    - chips/m6526.h
+    - chips/m6581.h
+    - chips/clk.h
+    - util/batch.h
+
+    ## Overview
+
+    The SID player only emulates the parts of a C64 which are needed to
+    play SID music files:
+
+    - a 6510 CPU (without the integrated IO port, addresses 0 and 1 are
+      plain RAM, but the value at address 1 selects whether the IO area
+      is visible at D000..DFFF)
+    - the SID at D400..D7FF
+    - both CIAs at DC00 and DD00 (CIA-1 is connected to IRQ, CIA-2 to NMI,
+      the CIA ports are not connected)
+    - a minimal VIC-II at D000..D3FF which only implements the raster
+      counter and the raster interrupt, there's no video output
+    - a flat 64 KByte RAM, there are no ROMs
+
+    Since there's no KERNAL ROM, a few small KERNAL stubs are installed in
+    RAM before the tune is loaded (IRQ and NMI entry at FF48 and FE43,
+    the IRQ exit routines at EA31 and EA81, and the RAM vectors at 0314..0319).
+    Those are overwritten by tunes which are loaded into those areas.
+
+    The init- and play-routines are called through a 3-byte trap location
+    (a JMP to itself) which is placed into a free memory page. The trap
+    location is where the CPU spins between calls, and where the init-
+    and play-routines return to. In PSID files with a play address, the
+    play routine is called from the player with interrupts disabled, either
+    once per video frame, or with the period of the CIA-1 timer A
+    (depending on the song's speed bit). PSID files without play address
+    and RSID files install their own interrupt handlers, for those the
+    interrupt flag is cleared after the init routine has returned.
+
+    ## Usage
+
+    Initialize a sidplayer_t instance, load a PSID or RSID file and
+    either call sidplayer_exec() once per host frame (the generated samples
+    are delivered through the audio callback like in the other systems),
+    or render a number of samples into your own buffer as fast as possible:
+
+    ~~~C
+    sidplayer_t player;
+    sidplayer_init(&player, &(sidplayer_desc_t){ .audio_sample_rate = 44100 });
+    if (sidplayer_load(&player, data, num_bytes)) {
+        sidplayer_start_song(&player, 2);
+        sidplayer_render(&player, samples, 44100 * 180);
+    }
+    ~~~
+
+    ## Batch rendering
+
+    sidplayer_render_batch() renders a list of songs into caller-provided
+    sample buffers on several threads. The caller also provides the
+    sidplayer_t instances, one per thread, the first instance runs on the
+    calling thread. Each thread picks the next unrendered job from the list
+    until all jobs are done, so long and short songs are balanced
+    automatically:
+
+    ~~~C
+    static sidplayer_t players[4];
+    sidplayer_job_t jobs[NUM_TUNES] = { ... };  // data, num_bytes, song, buffer, num_samples
+    int num_ok = sidplayer_render_batch(players, 4,
+        &(sidplayer_desc_t){ .audio_sample_rate = 44100 },
+        jobs, NUM_TUNES);
+    ~~~
+
+    The sidplayer_t struct contains the entire emulator state, the only
+    shared state are the SID's combined waveform tables, which are built
+    exactly once in a thread-safe way by the first m6581_init() call. So
+    separate sidplayer_t instances may also be driven from your own
+    threads without calling sidplayer_render_batch().
+
+    ## Limitations
+
+    - MUS files and RSID files with the 'C64 BASIC' flag are rejected
+    - the second and third SID addresses of v3/v4 files are ignored
+    - no bad lines or sprite DMA, the CPU is never stalled by the VIC-II
+    - no BASIC or KERNAL ROM routines except the stubs mentioned above
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SIDPLAYER_FREQUENCY_PAL (985248)        /* PAL clock frequency in Hz */
+#define SIDPLAYER_FREQUENCY_NTSC (1022727)      /* NTSC clock frequency in Hz */
+#define SIDPLAYER_MAX_AUDIO_SAMPLES (1024)      /* max number of audio samples in internal sample buffer */
+#define SIDPLAYER_DEFAULT_AUDIO_SAMPLES (128)   /* default number of samples in internal sample buffer */
+
+/* PSID/RSID header flags (version 2 and later) */
+#define SIDPLAYER_FLAG_MUS          (1<<0)
+#define SIDPLAYER_FLAG_BASIC        (1<<1)      /* RSID only: tune needs the C64 BASIC ROM */
+#define SIDPLAYER_FLAG_CLOCK_PAL    (1<<2)
+#define SIDPLAYER_FLAG_CLOCK_NTSC   (1<<3)
+#define SIDPLAYER_FLAG_SID_6581     (1<<4)
+#define SIDPLAYER_FLAG_SID_8580     (1<<5)
+
+/* audio sample data callback */
+typedef void (*sidplayer_audio_callback_t)(const float* samples, int num_samples, void* user_data);
+
+/* config parameters for sidplayer_init() */
+typedef struct {
+    /* optional user-data for callback functions */
+    void* user_data;
+
+    /* audio output config (if you don't want audio, set audio_cb to zero) */
+    sidplayer_audio_callback_t audio_cb;    /* called when audio_num_samples are ready */
+    int audio_num_samples;          /* default is SIDPLAYER_DEFAULT_AUDIO_SAMPLES */
+    int audio_sample_rate;          /* playback sample rate in Hz, default is 44100 */
+    float audio_sid_volume;         /* audio volume of the SID chip (0.0 .. 1.0), default is 1.0 */
+    m6581_model_t sid_model;        /* SID revision for tunes which don't require a specific one */
+} sidplayer_desc_t;
+
+/* information from the PSID/RSID header */
+typedef struct {
+    bool rsid;                  /* true if this is an RSID file */
+    int version;                /* header version (1..4) */
+    uint16_t load_addr;         /* first address of the tune data in memory */
+    uint16_t end_addr;          /* one past the last address of the tune data */
+    uint16_t init_addr;         /* address of the init routine */
+    uint16_t play_addr;         /* address of the play routine (0: interrupt driven) */
+    int num_songs;              /* number of songs in the file */
+    int start_song;             /* default song (1..num_songs) */
+    uint32_t speed;             /* speed bits, bit n set: song n+1 is CIA timer driven */
+    uint16_t flags;             /* SIDPLAYER_FLAG_* (version 2 and later) */
+    uint8_t start_page;         /* start of the free memory range (version 2 and later) */
+    uint8_t page_length;        /* length of the free memory range in pages */
+    char name[33];
+    char author[33];
+    char released[33];
+} sidplayer_tune_t;
+
+/* a song to render with sidplayer_render_batch() */
+typedef struct {
+    const uint8_t* data;        /* PSID/RSID file content */
+    int num_bytes;              /* size of the file content in bytes */
+    int song;                   /* song to render (1..num_songs), or 0 for the tune's default song */
+    float* buffer;              /* destination buffer for num_samples samples */
+    int num_samples;            /* number of samples to render */
+    bool ok;                    /* set to false if the song couldn't be loaded (buffer is cleared) */
+} sidplayer_job_t;
+
+/* SID player state */
+typedef struct {
+    uint64_t pins;
+    m6502_t cpu;
+    m6526_t cia_1;
+    m6526_t cia_2;
+    m6581_t sid;
+
+    bool valid;
+    bool tune_loaded;
+    sidplayer_tune_t tune;
+    int song;                   /* current song (1..num_songs) */
+    bool ntsc;                  /* true if running with NTSC clock and video timing */
+    uint32_t freq_hz;           /* current CPU clock frequency */
+    clk_t clk;
+    m6581_model_t sid_model;    /* SID revision of the current tune */
+    m6581_model_t default_sid_model;
+    int sound_hz;
+    float sid_volume;
+
+    /* init/play call state */
+    uint16_t trap_addr;         /* the CPU spins here between init/play calls */
+    bool init_called;
+    bool init_done;
+    bool play_pending;
+    uint32_t play_counter;      /* ticks until next play call */
+
+    /* minimal VIC-II raster unit */
+    uint8_t vic_regs[64];
+    uint16_t raster_line;
+    uint16_t raster_irq_line;
+    uint8_t raster_tick;
+    uint8_t vic_irq_latch;
+    uint8_t vic_irq_mask;
+    uint8_t ticks_per_line;
+    uint16_t lines_per_frame;
+
+    void* user_data;
+    sidplayer_audio_callback_t audio_cb;
+    int num_samples;
+    int sample_pos;
+    float sample_buffer[SIDPLAYER_MAX_AUDIO_SAMPLES];
+    float* render_buf;          /* target buffer of sidplayer_render() */
+    int render_pos;
+    int render_num;
+
+    uint8_t ram[1<<16];         /* the flat 64 KByte RAM */
+    uint8_t ram_image[1<<16];   /* RAM content after loading the tune */
+} sidplayer_t;
+
+/* initialize a new SID player instance */
+void sidplayer_init(sidplayer_t* sys, const sidplayer_desc_t* desc);
+/* discard SID player instance */
+void sidplayer_discard(sidplayer_t* sys);
+/* load a PSID or RSID file and start its default song */
+bool sidplayer_load(sidplayer_t* sys, const uint8_t* ptr, int num_bytes);
+/* start a song (1..num_songs) of the loaded tune */
+bool sidplayer_start_song(sidplayer_t* sys, int song);
+/* restart the current song */
+void sidplayer_reset(sidplayer_t* sys);
+/* tick the SID player for a given number of microseconds */
+void sidplayer_exec(sidplayer_t* sys, uint32_t micro_seconds);
+/* render a number of samples into a buffer (the audio callback isn't called) */
+void sidplayer_render(sidplayer_t* sys, float* buffer, int num_samples);
+/* render a list of songs on num_players threads, returns the number of successfully rendered songs */
+int sidplayer_render_batch(sidplayer_t* players, int num_players, const sidplayer_desc_t* desc, sidplayer_job_t* jobs, int num_jobs);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h> /* memcpy, memset */
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+#define _SIDPLAYER_HEADER_SIZE_V1 (0x76)
+#define _SIDPLAYER_HEADER_SIZE_V2 (0x7C)
+
+/* KERNAL entry points and vectors emulated by RAM stubs */
+#define _SIDPLAYER_IRQ_ENTRY    (0xFF48)
+#define _SIDPLAYER_NMI_ENTRY    (0xFE43)
+#define _SIDPLAYER_NMI_EXIT     (0xFE47)
+#define _SIDPLAYER_IRQ_EXIT     (0xEA31)
+#define _SIDPLAYER_IRQ_EXIT_NOACK (0xEA81)
+
+/* KERNAL default CIA-1 timer A values (60 Hz keyboard scan interrupt) */
+#define _SIDPLAYER_CIA_TIMER_PAL (0x4025)
+#define _SIDPLAYER_CIA_TIMER_NTSC (0x4295)
+
+static uint64_t _sidplayer_tick(sidplayer_t* sys, uint64_t pins);
+static void _sidplayer_start(sidplayer_t* sys);
+
+#define _SIDPLAYER_DEFAULT(val,def) (((val) != 0) ? (val) : (def));
+#define _SIDPLAYER_CLEAR(val) memset(&val, 0, sizeof(val))
+
+/* write a little endian 16-bit value into RAM */
+static void _sidplayer_wr16(uint8_t* ram, uint16_t addr, uint16_t val) {
+    ram[addr] = (uint8_t) val;
+    ram[(addr+1) & 0xFFFF] = (uint8_t) (val>>8);
+}
+
+/* read a big endian 16-bit value from the file header */
+static uint16_t _sidplayer_be16(const uint8_t* ptr) {
+    return (uint16_t) ((ptr[0]<<8) | ptr[1]);
+}
+
+static void _sidplayer_copy_str(char* dst, const uint8_t* src) {
+    memcpy(dst, src, 32);
+    dst[32] = 0;
+}
+
+/* install the KERNAL stubs and default zero page values into RAM */
+static void _sidplayer_init_ram(sidplayer_t* sys) {
+    uint8_t* ram = sys->ram;
+    memset(ram, 0, sizeof(sys->ram));
+    ram[0] = 0x2F;
+    ram[1] = 0x37;
+    /* FF48: PHA, TXA, PHA, TYA, PHA, JMP (0314) */
+    static const uint8_t irq_entry[] = { 0x48, 0x8A, 0x48, 0x98, 0x48, 0x6C, 0x14, 0x03 };
+    memcpy(&ram[_SIDPLAYER_IRQ_ENTRY], irq_entry, sizeof(irq_entry));
+    /* EA31: LDA DC0D, JMP EA81 */
+    static const uint8_t irq_exit[] = { 0xAD, 0x0D, 0xDC, 0x4C, 0x81, 0xEA };
+    memcpy(&ram[_SIDPLAYER_IRQ_EXIT], irq_exit, sizeof(irq_exit));
+    /* EA81: PLA, TAY, PLA, TAX, PLA, RTI */
+    static const uint8_t irq_exit_noack[] = { 0x68, 0xA8, 0x68, 0xAA, 0x68, 0x40 };
+    memcpy(&ram[_SIDPLAYER_IRQ_EXIT_NOACK], irq_exit_noack, sizeof(irq_exit_noack));
+    /* FE43: SEI, JMP (0318), FE47: RTI */
+    static const uint8_t nmi_entry[] = { 0x78, 0x6C, 0x18, 0x03, 0x40 };
+    memcpy(&ram[_SIDPLAYER_NMI_ENTRY], nmi_entry, sizeof(nmi_entry));
+    _sidplayer_wr16(ram, 0x0314, _SIDPLAYER_IRQ_EXIT);
+    _sidplayer_wr16(ram, 0x0316, _SIDPLAYER_IRQ_EXIT_NOACK);
+    _sidplayer_wr16(ram, 0x0318, _SIDPLAYER_NMI_EXIT);
+    _sidplayer_wr16(ram, 0xFFFA, _SIDPLAYER_NMI_ENTRY);
+    _sidplayer_wr16(ram, 0xFFFE, _SIDPLAYER_IRQ_ENTRY);
+}
+
+/* find a location for the trap which doesn't overlap the tune data */
+static uint16_t _sidplayer_find_trap_addr(const sidplayer_tune_t* tune) {
+    if ((tune->start_page != 0) && (tune->start_page != 0xFF) && (tune->page_length > 0)) {
+        return (uint16_t) (tune->start_page << 8);
+    }
+    /* unused area at 02A7, the tape buffer, and the end of the BASIC ROM area */
+    static const uint16_t candidates[] = { 0x02A7, 0x0334, 0xBFF0 };
+    for (int i = 0; i < (int)(sizeof(candidates)/sizeof(candidates[0])); i++) {
+        const uint32_t addr = candidates[i];
+        if (((addr + 3) <= tune->load_addr) || (addr >= tune->end_addr)) {
+            return (uint16_t) addr;
+        }
+    }
+    return candidates[0];
+}
+
+/* the PSID memory bank configuration for calling a routine at addr */
+static uint8_t _sidplayer_bank(uint16_t addr) {
+    if (addr < 0xA000) {
+        return 0x37;
+    }
+    else if (addr < 0xD000) {
+        return 0x36;
+    }
+    else if (addr < 0xE000) {
+        return 0x34;
+    }
+    else {
+        return 0x35;
+    }
+}
+
+/* the IO area is only visible if the CHAREN bit and one of the LORAM/HIRAM bits are set */
+static inline bool _sidplayer_io_mapped(const sidplayer_t* sys) {
+    const uint8_t bank = sys->ram[1];
+    return (bank & 4) && (bank & 3);
+}
+
+/* ticks between two play calls */
+static uint32_t _sidplayer_play_period(sidplayer_t* sys) {
+    const int song_index = sys->song - 1;
+    const uint32_t speed_bit = 1U << ((song_index < 32) ? song_index : 31);
+    if (!sys->tune.rsid && (sys->tune.speed & speed_bit) && (sys->cia_1.ta.latch != 0)) {
+        return (uint32_t)sys->cia_1.ta.latch + 1;
+    }
+    else {
+        return (uint32_t)sys->ticks_per_line * sys->lines_per_frame;
+    }
+}
+
+/* write a CIA register from 'outside' (this also ticks the CIA once) */
+static void _sidplayer_cia_write(m6526_t* cia, uint8_t reg, uint8_t data) {
+    m6526_tick(cia, M6502_MAKE_PINS(M6526_CS, reg, data));
+}
+
+/*  call a subroutine with the given A register value, the subroutine
+    returns to the trap location, this is only called when the CPU is
+    about to fetch the opcode at the trap location
+*/
+static uint64_t _sidplayer_call(sidplayer_t* sys, uint64_t pins, uint16_t addr, uint8_t a) {
+    const uint16_t ret_addr = sys->trap_addr - 1;
+    uint8_t s = m6502_s(&sys->cpu);
+    sys->ram[0x0100 | s--] = (uint8_t) (ret_addr>>8);
+    sys->ram[0x0100 | s--] = (uint8_t) ret_addr;
+    m6502_set_s(&sys->cpu, s);
+    m6502_set_a(&sys->cpu, a);
+    m6502_set_x(&sys->cpu, 0);
+    m6502_set_y(&sys->cpu, 0);
+    /* keep the interrupt pins, so that the NMI edge detection doesn't trigger */
+    pins = (pins & (M6502_IRQ|M6502_NMI)) | M6502_SYNC | M6502_RW;
+    M6502_SET_ADDR(pins, addr);
+    M6502_SET_DATA(pins, sys->ram[addr]);
+    m6502_set_pc(&sys->cpu, addr);
+    return pins;
+}
+
+/* the CPU has arrived at the trap location, start the next init or play call */
+static uint64_t _sidplayer_trap(sidplayer_t* sys, uint64_t pins) {
+    if (!sys->init_called) {
+        sys->init_called = true;
+        if (sys->tune.init_addr != 0) {
+            if (!sys->tune.rsid) {
+                sys->ram[1] = _sidplayer_bank(sys->tune.init_addr);
+            }
+            return _sidplayer_call(sys, pins, sys->tune.init_addr, (uint8_t)(sys->song - 1));
+        }
+    }
+    if (!sys->init_done) {
+        sys->init_done = true;
+        if (sys->tune.play_addr == 0) {
+            /* interrupt driven tune, enable interrupts and spin at the trap */
+            m6502_set_p(&sys->cpu, m6502_p(&sys->cpu) & ~M6502_IF);
+        }
+        else {
+            sys->play_counter = _sidplayer_play_period(sys);
+        }
+    }
+    if (sys->play_pending) {
+        sys->play_pending = false;
+        sys->ram[1] = _sidplayer_bank(sys->tune.play_addr);
+        return _sidplayer_call(sys, pins, sys->tune.play_addr, 0);
+    }
+    return pins;
+}
+
+void sidplayer_init(sidplayer_t* sys, const sidplayer_desc_t* desc) {
+    CHIPS_ASSERT(sys && desc);
+    CHIPS_ASSERT((desc->sid_model >= 0) && (desc->sid_model < M6581_NUM_MODELS));
+
+    memset(sys, 0, sizeof(sidplayer_t));
+    sys->valid = true;
+    sys->user_data = desc->user_data;
+    sys->audio_cb = desc->audio_cb;
+    sys->num_samples = _SIDPLAYER_DEFAULT(desc->audio_num_samples, SIDPLAYER_DEFAULT_AUDIO_SAMPLES);
+    CHIPS_ASSERT(sys->num_samples <= SIDPLAYER_MAX_AUDIO_SAMPLES);
+    sys->sound_hz = _SIDPLAYER_DEFAULT(desc->audio_sample_rate, 44100);
+    sys->sid_volume = _SIDPLAYER_DEFAULT(desc->audio_sid_volume, 1.0f);
+    sys->default_sid_model = desc->sid_model;
+    sys->sid_model = desc->sid_model;
+
+    /* without a tune, the CPU just spins at the trap location */
+    _sidplayer_init_ram(sys);
+    sys->trap_addr = _sidplayer_find_trap_addr(&sys->tune);
+    sys->ram[sys->trap_addr] = 0x4C;
+    _sidplayer_wr16(sys->ram, sys->trap_addr + 1, sys->trap_addr);
+    memcpy(sys->ram_image, sys->ram, sizeof(sys->ram_image));
+    sys->song = 1;
+    _sidplayer_start(sys);
+}
+
+void sidplayer_discard(sidplayer_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    sys->valid = false;
+}
+
+bool sidplayer_load(sidplayer_t* sys, const uint8_t* ptr, int num_bytes) {
+    CHIPS_ASSERT(sys && sys->valid && ptr);
+    if (num_bytes < _SIDPLAYER_HEADER_SIZE_V1) {
+        return false;
+    }
+    sidplayer_tune_t tune;
+    _SIDPLAYER_CLEAR(tune);
+    if ((ptr[0] == 'R') && (ptr[1] == 'S') && (ptr[2] == 'I') && (ptr[3] == 'D')) {
+        tune.rsid = true;
+    }
+    else if ((ptr[0] != 'P') || (ptr[1] != 'S') || (ptr[2] != 'I') || (ptr[3] != 'D')) {
+        return false;
+    }
+    tune.version = _sidplayer_be16(ptr + 0x04);
+    const int data_offset = _sidplayer_be16(ptr + 0x06);
+    if ((tune.version < 1) || (tune.version > 4) || (tune.rsid && (tune.version < 2))) {
+        return false;
+    }
+    if ((data_offset != _SIDPLAYER_HEADER_SIZE_V1) && (data_offset != _SIDPLAYER_HEADER_SIZE_V2)) {
+        return false;
+    }
+    if (num_bytes < data_offset) {
+        return false;
+    }
+    tune.load_addr = _sidplayer_be16(ptr + 0x08);
+    tune.init_addr = _sidplayer_be16(ptr + 0x0A);
+    tune.play_addr = _sidplayer_be16(ptr + 0x0C);
+    tune.num_songs = _sidplayer_be16(ptr + 0x0E);
+    tune.start_song = _sidplayer_be16(ptr + 0x10);
+    tune.speed = ((uint32_t)ptr[0x12]<<24) | ((uint32_t)ptr[0x13]<<16) | ((uint32_t)ptr[0x14]<<8) | ptr[0x15];
+    _sidplayer_copy_str(tune.name, ptr + 0x16);
+    _sidplayer_copy_str(tune.author, ptr + 0x36);
+    _sidplayer_copy_str(tune.released, ptr + 0x56);
+    if (data_offset >= _SIDPLAYER_HEADER_SIZE_V2) {
+        tune.flags = _sidplayer_be16(ptr + 0x76);
+        tune.start_page = ptr[0x78];
+        tune.page_length = ptr[0x79];
+    }
+    if (tune.rsid && (tune.flags & SIDPLAYER_FLAG_BASIC)) {
+        return false;
+    }
+    if (!tune.rsid && (tune.flags & SIDPLAYER_FLAG_MUS)) {
+        return false;
+    }
+    if ((tune.num_songs < 1) || (tune.num_songs > 256)) {
+        return false;
+    }
+    if ((tune.start_song < 1) || (tune.start_song > tune.num_songs)) {
+        tune.start_song = 1;
+    }
+
+    /* the load address may be stored in the first 2 bytes of the data */
+    const uint8_t* data = ptr + data_offset;
+    int data_size = num_bytes - data_offset;
+    if (tune.load_addr == 0) {
+        if (data_size < 2) {
+            return false;
+        }
+        tune.load_addr = (uint16_t) (data[0] | (data[1]<<8));
+        data += 2;
+        data_size -= 2;
+    }
+    if ((data_size <= 0) || ((tune.load_addr + data_size) > 0x10000)) {
+        return false;
+    }
+    tune.end_addr = (uint16_t) (tune.load_addr + data_size);
+    if (tune.init_addr == 0) {
+        tune.init_addr = tune.load_addr;
+    }
+
+    /* pick the clock and SID revision the tune was written for */
+    const uint16_t clock_flags = tune.flags & (SIDPLAYER_FLAG_CLOCK_PAL|SIDPLAYER_FLAG_CLOCK_NTSC);
+    sys->ntsc = (clock_flags == SIDPLAYER_FLAG_CLOCK_NTSC);
+    switch (tune.flags & (SIDPLAYER_FLAG_SID_6581|SIDPLAYER_FLAG_SID_8580)) {
+        case SIDPLAYER_FLAG_SID_6581: sys->sid_model = M6581_MODEL_6581; break;
+        case SIDPLAYER_FLAG_SID_8580: sys->sid_model = M6581_MODEL_8580; break;
+        default: sys->sid_model = sys->default_sid_model; break;
+    }
+
+    /* build the initial RAM image */
+    sys->tune = tune;
+    _sidplayer_init_ram(sys);
+    memcpy(&sys->ram[tune.load_addr], data, (size_t)data_size);
+    sys->trap_addr = _sidplayer_find_trap_addr(&tune);
+    sys->ram[sys->trap_addr] = 0x4C;
+    _sidplayer_wr16(sys->ram, sys->trap_addr + 1, sys->trap_addr);
+    memcpy(sys->ram_image, sys->ram, sizeof(sys->ram_image));
+    sys->tune_loaded = true;
+    return sidplayer_start_song(sys, tune.start_song);
+}
+
+bool sidplayer_start_song(sidplayer_t* sys, int song) {
+    CHIPS_ASSERT(sys && sys->valid);
+    if (!sys->tune_loaded || (song < 1) || (song > sys->tune.num_songs)) {
+        return false;
+    }
+    sys->song = song;
+    _sidplayer_start(sys);
+    return true;
+}
+
+void sidplayer_reset(sidplayer_t* sys) {
+    CHIPS_ASSERT(sys && sys->valid);
+    _sidplayer_start(sys);
+}
+
+/* restore the initial RAM image, reset the hardware and prepare the init call */
+static void _sidplayer_start(sidplayer_t* sys) {
+    memcpy(sys->ram, sys->ram_image, sizeof(sys->ram));
+    sys->freq_hz = sys->ntsc ? SIDPLAYER_FREQUENCY_NTSC : SIDPLAYER_FREQUENCY_PAL;
+    clk_init(&sys->clk, sys->freq_hz);
+    sys->ticks_per_line = sys->ntsc ? 65 : 63;
+    sys->lines_per_frame = sys->ntsc ? 263 : 312;
+    sys->init_called = false;
+    sys->init_done = false;
+    sys->play_pending = false;
+    sys->play_counter = 0;
+    sys->sample_pos = 0;
+
+    memset(sys->vic_regs, 0, sizeof(sys->vic_regs));
+    sys->raster_line = 0;
+    sys->raster_irq_line = 0;
+    sys->raster_tick = 0;
+    sys->vic_irq_latch = 0;
+    sys->vic_irq_mask = 0;
+
+    m6581_desc_t sid_desc;
+    _SIDPLAYER_CLEAR(sid_desc);
+    sid_desc.tick_hz = (int) sys->freq_hz;
+    sid_desc.sound_hz = sys->sound_hz;
+    sid_desc.magnitude = sys->sid_volume;
+    sid_desc.model = sys->sid_model;
+    m6581_init(&sys->sid, &sid_desc);
+
+    /* the KERNAL starts CIA-1 timer A with interrupts enabled */
+    m6526_init(&sys->cia_1);
+    m6526_init(&sys->cia_2);
+    const uint16_t cia_timer = sys->ntsc ? _SIDPLAYER_CIA_TIMER_NTSC : _SIDPLAYER_CIA_TIMER_PAL;
+    _sidplayer_cia_write(&sys->cia_1, 0x04, (uint8_t)cia_timer);
+    _sidplayer_cia_write(&sys->cia_1, 0x05, (uint8_t)(cia_timer>>8));
+    _sidplayer_cia_write(&sys->cia_1, 0x0D, 0x81);
+    _sidplayer_cia_write(&sys->cia_1, 0x0E, 0x11);
+
+    /* PSID init routines are called with interrupts disabled */
+    m6502_desc_t cpu_desc;
+    _SIDPLAYER_CLEAR(cpu_desc);
+    m6502_init(&sys->cpu, &cpu_desc);
+    m6502_set_s(&sys->cpu, 0xFF);
+    m6502_set_p(&sys->cpu, sys->tune.rsid ? M6502_XF : (M6502_XF|M6502_IF));
+    sys->pins = M6502_SYNC | M6502_RW;
+    M6502_SET_ADDR(sys->pins, sys->trap_addr);
+    M6502_SET_DATA(sys->pins, sys->ram[sys->trap_addr]);
+    m6502_set_pc(&sys->cpu, sys->trap_addr);
+}
+
+void sidplayer_exec(sidplayer_t* sys, uint32_t micro_seconds) {
+    CHIPS_ASSERT(sys && sys->valid);
+    uint32_t num_ticks = clk_ticks_to_run(&sys->clk, micro_seconds);
+    uint64_t pins = sys->pins;
+    for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
+        pins = _sidplayer_tick(sys, pins);
+    }
+    sys->pins = pins;
+    clk_ticks_executed(&sys->clk, num_ticks);
+}
+
+void sidplayer_render(sidplayer_t* sys, float* buffer, int num_samples) {
+    CHIPS_ASSERT(sys && sys->valid && buffer && (num_samples >= 0));
+    sys->render_buf = buffer;
+    sys->render_pos = 0;
+    sys->render_num = num_samples;
+    uint64_t pins = sys->pins;
+    while (sys->render_pos < num_samples) {
+        pins = _sidplayer_tick(sys, pins);
+    }
+    sys->pins = pins;
+    sys->render_buf = 0;
+}
+
+/*=== batch rendering ========================================================*/
+typedef struct {
+    sidplayer_t* players;
+    sidplayer_job_t* jobs;
+} _sidplayer_batch_t;
+
+static bool _sidplayer_batch_job(int worker_index, int job_index, void* user_data) {
+    _sidplayer_batch_t* batch = (_sidplayer_batch_t*) user_data;
+    sidplayer_t* player = &batch->players[worker_index];
+    sidplayer_job_t* job = &batch->jobs[job_index];
+    job->ok = sidplayer_load(player, job->data, job->num_bytes);
+    if (job->ok && (job->song != 0)) {
+        job->ok = sidplayer_start_song(player, job->song);
+    }
+    if (job->ok) {
+        sidplayer_render(player, job->buffer, job->num_samples);
+    }
+    else {
+        memset(job->buffer, 0, (size_t)job->num_samples * sizeof(float));
+    }
+    return job->ok;
+}
+
+int sidplayer_render_batch(sidplayer_t* players, int num_players, const sidplayer_desc_t* desc, sidplayer_job_t* jobs, int num_jobs) {
+    CHIPS_ASSERT(players && desc && (num_players > 0) && (num_players <= BATCH_MAX_WORKERS));
+    CHIPS_ASSERT((jobs || (num_jobs == 0)) && (num_jobs >= 0));
+    for (int i = 0; i < num_jobs; i++) {
+        CHIPS_ASSERT(jobs[i].data && jobs[i].buffer && (jobs[i].num_samples >= 0));
+    }
+    for (int i = 0; i < num_players; i++) {
+        sidplayer_init(&players[i], desc);
+    }
+    _sidplayer_batch_t batch;
+    batch.players = players;
+    batch.jobs = jobs;
+    batch_desc_t batch_desc;
+    memset(&batch_desc, 0, sizeof(batch_desc));
+    batch_desc.num_workers = num_players;
+    batch_desc.num_jobs = num_jobs;
+    batch_desc.job_cb = _sidplayer_batch_job;
+    batch_desc.user_data = &batch;
+    int num_ok = batch_run(&batch_desc);
+    for (int i = 0; i < num_players; i++) {
+        sidplayer_discard(&players[i]);
+    }
+    return num_ok;
+}
+
+/* minimal VIC-II register access, only the raster registers do something */
+static uint8_t _sidplayer_vic_read(sidplayer_t* sys, uint8_t reg) {
+    switch (reg) {
+        case 0x11:
+            return (sys->vic_regs[0x11] & 0x7F) | ((sys->raster_line & 0x100)>>1);
+        case 0x12:
+            return (uint8_t) sys->raster_line;
+        case 0x19:
+            return sys->vic_irq_latch | 0x70 | ((sys->vic_irq_latch & sys->vic_irq_mask) ? 0x80 : 0x00);
+        case 0x1A:
+            return sys->vic_irq_mask | 0xF0;
+        default:
+            return (reg < 0x2F) ? sys->vic_regs[reg] : 0xFF;
+    }
+}
+
+static void _sidplayer_vic_write(sidplayer_t* sys, uint8_t reg, uint8_t data) {
+    switch (reg) {
+        case 0x11:
+            sys->raster_irq_line = (sys->raster_irq_line & 0x00FF) | ((data & 0x80)<<1);
+            break;
+        case 0x12:
+            sys->raster_irq_line = (sys->raster_irq_line & 0x0100) | data;
+            break;
+        case 0x19:
+            sys->vic_irq_latch &= ~data & 0x0F;
+            break;
+        case 0x1A:
+            sys->vic_irq_mask = data & 0x0F;
+            break;
+        default:
+            break;
+    }
+    sys->vic_regs[reg] = data;
+}
+
+static uint64_t _sidplayer_tick(sidplayer_t* sys, uint64_t pins) {
+
+    /* tick the CPU */
+    pins = m6502_tick(&sys->cpu, pins);
+    const uint16_t addr = M6502_GET_ADDR(pins);
+
+    /* those pins are set each tick by the CIAs and VIC */
+    pins &= ~(M6502_IRQ|M6502_NMI);
+
+    /* address decoding */
+    bool vic_access = false;
+    uint64_t cia1_pins = pins & M6502_PIN_MASK;
+    uint64_t cia2_pins = pins & M6502_PIN_MASK;
+    uint64_t sid_pins = pins & M6502_PIN_MASK;
+    bool mem_access = false;
+    if (((addr & 0xF000) == 0xD000) && _sidplayer_io_mapped(sys)) {
+        if (addr < 0xD400) {
+            vic_access = true;
+        }
+        else if (addr < 0xD800) {
+            sid_pins |= M6581_CS;
+        }
+        else if ((addr >= 0xDC00) && (addr < 0xDD00)) {
+            cia1_pins |= M6526_CS;
+        }
+        else if ((addr >= 0xDD00) && (addr < 0xDE00)) {
+            cia2_pins |= M6526_CS;
+        }
+        else {
+            /* color RAM and expansion port area */
+            mem_access = true;
+        }
+    }
+    else {
+        mem_access = true;
+    }
+
+    /* tick the SID */
+    {
+        sid_pins = m6581_tick(&sys->sid, sid_pins);
+        if (sid_pins & M6581_SAMPLE) {
+            /* new audio sample ready */
+            if (sys->render_buf) {
+                if (sys->render_pos < sys->render_num) {
+                    sys->render_buf[sys->render_pos++] = sys->sid.sample;
+                }
+            }
+            else {
+                sys->sample_buffer[sys->sample_pos++] = sys->sid.sample;
+                if (sys->sample_pos == sys->num_samples) {
+                    if (sys->audio_cb) {
+                        sys->audio_cb(sys->sample_buffer, sys->num_samples, sys->user_data);
+                    }
+                    sys->sample_pos = 0;
+                }
+            }
+        }
+        if ((sid_pins & (M6581_CS|M6581_RW)) == (M6581_CS|M6581_RW)) {
+            pins = M6502_COPY_DATA(pins, sid_pins);
+        }
+    }
+
+    /* tick CIA-1 (IRQ pin connected to CPU IRQ) */
+    {
+        M6526_SET_PAB(cia1_pins, 0xFF, 0xFF);
+        cia1_pins = m6526_tick(&sys->cia_1, cia1_pins);
+        if (cia1_pins & M6502_IRQ) {
+            pins |= M6502_IRQ;
+        }
+        if ((cia1_pins & (M6526_CS|M6526_RW)) == (M6526_CS|M6526_RW)) {
+            pins = M6502_COPY_DATA(pins, cia1_pins);
+        }
+    }
+
+    /* tick CIA-2 (IRQ pin connected to CPU NMI) */
+    {
+        M6526_SET_PAB(cia2_pins, 0xFF, 0xFF);
+        cia2_pins = m6526_tick(&sys->cia_2, cia2_pins);
+        if (cia2_pins & M6502_IRQ) {
+            pins |= M6502_NMI;
+        }
+        if ((cia2_pins & (M6526_CS|M6526_RW)) == (M6526_CS|M6526_RW)) {
+            pins = M6502_COPY_DATA(pins, cia2_pins);
+        }
+    }
+
+    /* tick the VIC-II raster counter, the raster interrupt is connected to the CPU IRQ pin */
+    {
+        if (++sys->raster_tick == sys->ticks_per_line) {
+            sys->raster_tick = 0;
+            if (++sys->raster_line == sys->lines_per_frame) {
+                sys->raster_line = 0;
+            }
+            if (sys->raster_line == sys->raster_irq_line) {
+                sys->vic_irq_latch |= 1;
+            }
+        }
+        if (sys->vic_irq_latch & sys->vic_irq_mask) {
+            pins |= M6502_IRQ;
+        }
+    }
+
+    /* remaining VIC-II and memory accesses */
+    if (vic_access) {
+        const uint8_t reg = addr & 0x3F;
+        if (pins & M6502_RW) {
+            M6502_SET_DATA(pins, _sidplayer_vic_read(sys, reg));
+        }
+        else {
+            _sidplayer_vic_write(sys, reg, M6502_GET_DATA(pins));
+        }
+    }
+    else if (mem_access) {
+        if (pins & M6502_RW) {
+            M6502_SET_DATA(pins, sys->ram[addr]);
+        }
+        else {
+            sys->ram[addr] = M6502_GET_DATA(pins);
+        }
+    }
+
+    /* time the play calls, and start the next init or play call at the trap */
+    if (sys->init_done && (sys->tune.play_addr != 0)) {
+        if (--sys->play_counter == 0) {
+            sys->play_pending = true;
+            sys->play_counter = _sidplayer_play_period(sys);
+        }
+    }
+    if ((pins & M6502_SYNC) && (addr == sys->trap_addr)) {
+        pins = _sidplayer_trap(sys, pins);
+    }
+    return pins;
+}
+#endif /* CHIPS_IMPL */
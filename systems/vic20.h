@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into vic20_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until vic20_discard() is called, and the
+        macro must be defined in all source files which include vic20.h)
+
     You need to include the following headers before including vic20.h:
 
+    - chips/chips_state.h
     - chips/m6502.h
     - chips/m6522.h
     - chips/m6561.h
@@ -33,6 +43,22 @@
 
     TODO!
 
+    ## Frame Callback
+
+    The optional frame callback is called from inside vic20_exec() when
+    the VIC starts a new frame, at that point the pixel buffer contains
+    a complete frame. To render the next frame into a different pixel
+    buffer (for instance for video capture with util/capture.h), call
+    vic20_set_pixel_buffer() from inside the callback. The callback also gets
+    the number of emulated CPU ticks since vic20_init(), for instance as
+    frame timestamp:
+
+    ~~~C
+    static void frame_cb(uint64_t tick_count, void* user_data) {
+        vic20_set_pixel_buffer(&sys, capture_submit_frame(&cap, tick_count));
+    }
+    ~~~
+
     ## Links
 
     http://blog.tynemouthsoftware.co.uk/2019/09/how-the-vic20-works.html
@@ -104,6 +130,10 @@ typedef enum {
 
 /* audio sample data callback */
 typedef void (*vic20_audio_callback_t)(const float* samples, int num_samples, void* user_data);
+/* frame callback, called at vsync when a complete frame is in the pixel buffer,
+   with the number of emulated CPU ticks since vic20_init()
+*/
+typedef void (*vic20_frame_callback_t)(uint64_t tick_count, void* user_data);
 
 /* config parameters for vic20_init() */
 typedef struct {
@@ -115,6 +145,7 @@ typedef struct {
     void* pixel_buffer;         /* pointer to a linear RGBA8 pixel buffer,
                                    query required size via vic20_max_display_size() */
     int pixel_buffer_size;      /* size of the pixel buffer in bytes */
+    vic20_frame_callback_t frame_cb;    /* optional callback at vsync */
 
     /* optional user-data for callback functions */
     void* user_data;
@@ -151,13 +182,16 @@ typedef struct {
     uint8_t joy_joy_mask;       /* current joystick state from vic20_joystick() */
     uint64_t via1_joy_mask;     /* merged keyboard/joystick mask ready for or-ing with VIA1 input pins */
     uint64_t via2_joy_mask;     /* merged keyboard/joystick mask ready for or-ing with VIA2 input pins */
+    uint64_t tick_count;        /* emulated CPU ticks since vic20_init() */
 
+    clk_t clk;                  /* converts micro-seconds to ticks */
     kbd_t kbd;                  /* keyboard matrix state */
     mem_t mem_cpu;              /* CPU-visible memory mapping */
     mem_t mem_vic;              /* VIC-visible memory mapping */
 
     void* user_data;
     uint32_t* pixel_buffer;
+    vic20_frame_callback_t frame_cb;
     vic20_audio_callback_t audio_cb;
     int num_samples;
     int sample_pos;
@@ -167,9 +201,15 @@ typedef struct {
     uint8_t ram0[0x0400];           /* 1 KB zero page, stack, system work area */
     uint8_t ram_3k[0x0C00];         /* optional 3K exp RAM */
     uint8_t ram1[0x1000];           /* 4 KB main RAM */
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom_char;        /* 4 KB character ROM image */
+    const uint8_t* rom_basic;       /* 8 KB BASIC ROM image */
+    const uint8_t* rom_kernal;      /* 8 KB KERNAL V3 ROM image */
+#else
     uint8_t rom_char[0x1000];       /* 4 KB character ROM image */
     uint8_t rom_basic[0x2000];      /* 8 KB BASIC ROM image */
     uint8_t rom_kernal[0x2000];     /* 8 KB KERNAL V3 ROM image */
+#endif
     uint8_t ram_exp[4][0x2000];     /* optional expansion 8K RAM blocks */
 
     c1530_t c1530;                  /* c1530.valid = true if enabled */
@@ -195,6 +235,8 @@ void vic20_reset(vic20_t* sys);
 void vic20_exec(vic20_t* sys, uint32_t micro_seconds);
 /* ...or optionally: tick the VIC-20 instance once, does not update keyboard state! */
 void vic20_tick(vic20_t* sys);
+/* switch to another pixel buffer (at least as big as the one passed to vic20_init()) */
+void vic20_set_pixel_buffer(vic20_t* sys, void* pixel_buffer);
 /* send a key-down event to the VIC-20 */
 void vic20_key_down(vic20_t* sys, int key_code);
 /* send a key-up event to the VIC-20 */
@@ -245,6 +287,7 @@ bool vic20_is_tape_motor_on(vic20_t* sys);
 #define _VIC20_DISPLAY_Y (8)
 
 static uint16_t _vic20_vic_fetch(uint16_t addr, void* user_data);
+static void _vic20_vic_vsync(void* user_data);
 static void _vic20_init_key_map(vic20_t* sys);
 
 #define _VIC20_DEFAULT(val,def) (((val) != 0) ? (val) : (def));
@@ -261,14 +304,21 @@ void vic20_init(vic20_t* sys, const vic20_desc_t* desc) {
     sys->via1_joy_mask = M6522_PA2|M6522_PA3|M6522_PA4|M6522_PA5;
     sys->via2_joy_mask = M6522_PB7;
 
-    CHIPS_ASSERT(desc->rom_char && (desc->rom_char_size == sizeof(sys->rom_char)));
-    CHIPS_ASSERT(desc->rom_basic && (desc->rom_basic_size == sizeof(sys->rom_basic)));
-    CHIPS_ASSERT(desc->rom_kernal && (desc->rom_kernal_size == sizeof(sys->rom_kernal)));
+    CHIPS_ASSERT(desc->rom_char && (desc->rom_char_size == 0x1000));
+    CHIPS_ASSERT(desc->rom_basic && (desc->rom_basic_size == 0x2000));
+    CHIPS_ASSERT(desc->rom_kernal && (desc->rom_kernal_size == 0x2000));
+    #if defined(CHIPS_SHARED_ROMS)
+    sys->rom_char = (const uint8_t*) desc->rom_char;
+    sys->rom_basic = (const uint8_t*) desc->rom_basic;
+    sys->rom_kernal = (const uint8_t*) desc->rom_kernal;
+    #else
     memcpy(sys->rom_char, desc->rom_char, sizeof(sys->rom_char));
     memcpy(sys->rom_basic, desc->rom_basic, sizeof(sys->rom_basic));
     memcpy(sys->rom_kernal, desc->rom_kernal, sizeof(sys->rom_kernal));
+    #endif
     sys->user_data = desc->user_data;
     sys->audio_cb = desc->audio_cb;
+    sys->frame_cb = desc->frame_cb;
     sys->num_samples = _VIC20_DEFAULT(desc->audio_num_samples, VIC20_DEFAULT_AUDIO_SAMPLES);
     CHIPS_ASSERT(sys->num_samples <= VIC20_MAX_AUDIO_SAMPLES);
 
@@ -278,6 +328,7 @@ void vic20_init(vic20_t* sys, const vic20_desc_t* desc) {
     m6502_desc_t cpu_desc;
     _VIC20_CLEAR(cpu_desc);
     sys->pins = m6502_init(&sys->cpu, &cpu_desc);
+    clk_init(&sys->clk, VIC20_FREQUENCY);
 
     m6522_init(&sys->via_1);
     m6522_init(&sys->via_2);
@@ -285,6 +336,7 @@ void vic20_init(vic20_t* sys, const vic20_desc_t* desc) {
     m6561_desc_t vic_desc;
     _VIC20_CLEAR(vic_desc);
     vic_desc.fetch_cb = _vic20_vic_fetch;
+    vic_desc.vsync_cb = desc->frame_cb ? _vic20_vic_vsync : 0;
     vic_desc.rgba8_buffer = (uint32_t*) desc->pixel_buffer;
     vic_desc.rgba8_buffer_size = desc->pixel_buffer_size;
     vic_desc.vis_x = _VIC20_DISPLAY_X;
@@ -409,6 +461,7 @@ void vic20_reset(vic20_t* sys) {
 }
 
 static uint64_t _vic20_tick(vic20_t* sys, uint64_t pins) {
+    sys->tick_count++;
 
     /* tick the CPU */
     pins = m6502_tick(&sys->cpu, pins);
@@ -570,15 +623,29 @@ void vic20_tick(vic20_t* sys) {
 
 void vic20_exec(vic20_t* sys, uint32_t micro_seconds) {
     CHIPS_ASSERT(sys && sys->valid);
-    uint32_t num_ticks = clk_us_to_ticks(VIC20_FREQUENCY, micro_seconds);
+    uint32_t num_ticks = clk_ticks_to_run(&sys->clk, micro_seconds);
     uint64_t pins = sys->pins;
     for (uint32_t ticks = 0; ticks < num_ticks; ticks++) {
         pins = _vic20_tick(sys, pins);
     }
     sys->pins = pins;
+    clk_ticks_executed(&sys->clk, num_ticks);
     kbd_update(&sys->kbd, micro_seconds);
 }
 
+void vic20_set_pixel_buffer(vic20_t* sys, void* pixel_buffer) {
+    CHIPS_ASSERT(sys && sys->valid);
+    sys->pixel_buffer = (uint32_t*) pixel_buffer;
+    sys->vic.crt.rgba8_buffer = (uint32_t*) pixel_buffer;
+}
+
+static void _vic20_vic_vsync(void* user_data) {
+    vic20_t* sys = (vic20_t*) user_data;
+    if (sys->frame_cb) {
+        sys->frame_cb(sys->tick_count, sys->user_data);
+    }
+}
+
 static uint16_t _vic20_vic_fetch(uint16_t addr, void* user_data) {
     vic20_t* sys = (vic20_t*) user_data;
     uint16_t data = (sys->color_ram[addr & 0x03FF]<<8) | mem_rd(&sys->mem_vic, addr);
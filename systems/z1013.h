@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into z1013_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until z1013_discard() is called, and the
+        macro must be defined in all source files which include z1013.h)
+
     You need to include the following headers before including z1013.h:
 
+    - chips/chips_state.h
     - chips/z80.h
     - chips/z80pio.h
     - chips/mem.h
@@ -106,8 +116,13 @@ typedef struct {
     mem_t mem;
     kbd_t kbd;
     uint8_t ram[1<<16];
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom_os;
+    const uint8_t* rom_font;
+#else
     uint8_t rom_os[2048];
     uint8_t rom_font[2048];
+#endif
 } z1013_t;
 
 /* initialize a new Z1013 instance */
@@ -155,28 +170,33 @@ static void _z1013_pio_out(int port_id, uint8_t data, void* user_data);
 static void _z1013_decode_vidmem(z1013_t* sys);
 
 #define _Z1013_CLEAR(val) memset(&val, 0, sizeof(val))
+#if defined(CHIPS_SHARED_ROMS)
+#define _Z1013_ROM(dst,src,size) dst = (const uint8_t*)(src)
+#else
+#define _Z1013_ROM(dst,src,size) memcpy(dst, src, size)
+#endif
 
 void z1013_init(z1013_t* sys, const z1013_desc_t* desc) {
     CHIPS_ASSERT(sys && desc);
     CHIPS_ASSERT(desc->pixel_buffer && (desc->pixel_buffer_size >= _Z1013_DISPLAY_SIZE));
-    CHIPS_ASSERT(desc->rom_font && (desc->rom_font_size == sizeof(sys->rom_font)));
+    CHIPS_ASSERT(desc->rom_font && (desc->rom_font_size == 2048));
     if (desc->type == Z1013_TYPE_01) {
-        CHIPS_ASSERT(desc->rom_mon202 && (desc->rom_mon202_size == sizeof(sys->rom_os)));
+        CHIPS_ASSERT(desc->rom_mon202 && (desc->rom_mon202_size == 2048));
     }
     else {
-        CHIPS_ASSERT(desc->rom_mon_a2 && (desc->rom_mon_a2_size == sizeof(sys->rom_os)));
+        CHIPS_ASSERT(desc->rom_mon_a2 && (desc->rom_mon_a2_size == 2048));
     }
 
     memset(sys, 0, sizeof(z1013_t));
     sys->valid = true;
     sys->type = desc->type;
     sys->pixel_buffer = (uint32_t*) desc->pixel_buffer;
-    memcpy(sys->rom_font, desc->rom_font, sizeof(sys->rom_font));
+    _Z1013_ROM(sys->rom_font, desc->rom_font, 2048);
     if (desc->type == Z1013_TYPE_01) {
-        memcpy(sys->rom_os, desc->rom_mon202, sizeof(sys->rom_os));
+        _Z1013_ROM(sys->rom_os, desc->rom_mon202, 2048);
     }
     else {
-        memcpy(sys->rom_os, desc->rom_mon_a2, sizeof(sys->rom_os));
+        _Z1013_ROM(sys->rom_os, desc->rom_mon_a2, 2048);
     }
 
     /* initialize the hardware */
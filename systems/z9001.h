@@ -20,6 +20,7 @@
 
     You need to include the following headers before including z9001.h:
 
+    - chips/chips_state.h
     - chips/z80.h
     - chips/z80pio.h
     - chips/z80ctc.h
@@ -439,6 +440,19 @@ void z9001_key_up(z9001_t* sys, int key_code) {
     z80pio_write_port(&sys->pio2, Z80PIO_PORT_B, ~kbd_scan_lines(&sys->kbd));
 }
 
+/* tick the beeper for one clock cycle, and push a new audio sample if ready */
+static inline void _z9001_tick_beeper(z9001_t* sys) {
+    if (beeper_tick(&sys->beeper)) {
+        sys->sample_buffer[sys->sample_pos++] = sys->beeper.sample;
+        if (sys->sample_pos == sys->num_samples) {
+            if (sys->audio_cb) {
+                sys->audio_cb(sys->sample_buffer, sys->num_samples, sys->user_data);
+            }
+            sys->sample_pos = 0;
+        }
+    }
+}
+
 /* the CPU tick callback performs memory and I/O reads/writes */
 static uint64_t _z9001_tick(int num_ticks, uint64_t pins, void* user_data) {
     z9001_t* sys = (z9001_t*) user_data;
@@ -447,35 +461,47 @@ static uint64_t _z9001_tick(int num_ticks, uint64_t pins, void* user_data) {
        to CTC channel 3 input signal CLKTRG3 to form a timer cascade
        which drives the system clock, store the state of ZCTO2 for the
        next tick
+
+       the CTC is ticked in bulk up to the next zero crossing, a tick
+       following a ZCTO2 pulse must be ticked on its own since the
+       CLKTRG3 input changes again on the next tick
     */
     pins |= sys->ctc_zcto2;
-    for (int i = 0; i < num_ticks; i++) {
-        if (pins & Z80CTC_ZCTO2) { pins |= Z80CTC_CLKTRG3; }
-        else                     { pins &= ~Z80CTC_CLKTRG3; }
-        pins = z80ctc_tick(&sys->ctc, pins);
+    int ticks = num_ticks;
+    while (ticks > 0) {
+        int n = 1;
+        if (pins & Z80CTC_ZCTO2) {
+            pins |= Z80CTC_CLKTRG3;
+        }
+        else {
+            pins &= ~Z80CTC_CLKTRG3;
+            n = z80ctc_ticks_to_event(&sys->ctc);
+            if (n > ticks) {
+                n = ticks;
+            }
+        }
+        ticks -= n;
+        pins = z80ctc_tick_n(&sys->ctc, n, pins);
+        for (int i = 1; i < n; i++) {
+            _z9001_tick_beeper(sys);
+        }
         if (pins & Z80CTC_ZCTO0) {
             /* CTC channel 0 controls the beeper frequency */
             beeper_toggle(&sys->beeper);
         }
-        if (beeper_tick(&sys->beeper)) {
-            /* new audio sample ready */
-            sys->sample_buffer[sys->sample_pos++] = sys->beeper.sample;
-            if (sys->sample_pos == sys->num_samples) {
-                if (sys->audio_cb) {
-                    sys->audio_cb(sys->sample_buffer, sys->num_samples, sys->user_data);
-                }
-                sys->sample_pos = 0;
-            }
-        }
+        _z9001_tick_beeper(sys);
         /* the blink flip flop is controlled by a 'bisync' video signal
             (I guess that means it triggers at half PAL frequency: 25Hz),
             going into a binary counter, bit 4 of the counter is connected
             to the blink flip flop.
         */
-        if (0 >= sys->blink_counter--) {
+        uint32_t blink_ticks = (uint32_t) n;
+        while (blink_ticks > sys->blink_counter) {
+            blink_ticks -= sys->blink_counter + 1;
             sys->blink_counter = (_Z9001_FREQUENCY * 8) / 25;
             sys->blink_flip_flop = !sys->blink_flip_flop;
         }
+        sys->blink_counter -= blink_ticks;
     }
     sys->ctc_zcto2 = (pins & Z80CTC_ZCTO2);
     pins = pins & Z80_PIN_MASK;
@@ -530,15 +556,16 @@ static uint64_t _z9001_tick(int num_ticks, uint64_t pins, void* user_data) {
 
     /* handle interrupt requests by PIOs and CTCs, the interrupt priority
        is PIO1>PIO2>CTC, the interrupt handling functions must be called
-       in this order
+       in this order, the daisy chain is skipped when no interrupt
+       is pending or under service
     */
-    Z80_DAISYCHAIN_BEGIN(pins)
+    Z80_DAISYCHAIN_BEGIN_IF(pins, sys->pio1.int_active|sys->pio2.int_active|sys->ctc.int_active)
     {
         pins = z80pio_int(&sys->pio1, pins);
         pins = z80pio_int(&sys->pio2, pins);
         pins = z80ctc_int(&sys->ctc, pins);
     }
-    Z80_DAISYCHAIN_END(pins);
+    Z80_DAISYCHAIN_END_IF(pins);
     return (pins & Z80_PIN_MASK);
 }
 
@@ -18,8 +18,18 @@
     ~~~
         your own assert macro (default: assert(c))
 
+    ~~~C
+    CHIPS_SHARED_ROMS
+    ~~~
+        if defined, the ROM images passed into zx_init() are not copied
+        into the emulator state, but accessed directly, so that many
+        emulator instances can share the same ROM data (the ROM data
+        must then remain valid until zx_discard() is called, and the
+        macro must be defined in all source files which include zx.h)
+
     You need to include the following headers before including zx.h:
 
+    - chips/chips_state.h
     - chips/z80.h
     - chips/beeper.h
     - chips/ay38910.h
@@ -35,6 +45,83 @@
 
     TODO! 
 
+    ## Snapshot Files
+
+    zx_quickload() accepts .z80, .sna and .szx snapshot files. The
+    snapshot's machine type must match the emulated model. From .szx files,
+    the Z80R, SPCR, RAMP and AY blocks are evaluated, all other blocks are
+    ignored (compressed RAMP blocks are decompressed with a small builtin
+    zlib decoder).
+
+    ## Beam Racing
+
+    The video memory is decoded into the pixel buffer one scanline at a
+    time. To stream partial frames to the GPU instead of uploading the
+    whole frame after zx_exec() returns, provide a scanline callback
+    which is called each time scanline_chunk lines have been decoded:
+
+    ~~~C
+    static void scanline_cb(int y0, int y1, void* user_data) {
+        // pixel buffer lines y0 to y1-1 are ready
+    }
+    ...
+    zx_init(&sys, &(zx_desc_t){
+        ...
+        .scanline_cb = scanline_cb,
+        .scanline_chunk = 32,   // default is 16 lines
+    });
+    ~~~
+
+    Run zx_exec() in small time slices in step with the host display to
+    get a latency of less than a frame. The last chunk of a frame may be
+    smaller.
+
+    ## Frame Callback
+
+    The optional frame callback is called from inside zx_exec() when
+    the video decoder starts a new frame, at that point the pixel buffer contains
+    a complete frame. To render the next frame into a different pixel
+    buffer (for instance for video capture with util/capture.h), call
+    zx_set_pixel_buffer() from inside the callback. The callback also gets
+    the number of emulated CPU ticks since zx_init(), for instance as
+    frame timestamp:
+
+    ~~~C
+    static void frame_cb(uint64_t tick_count, void* user_data) {
+        zx_set_pixel_buffer(&sys, capture_submit_frame(&cap, tick_count));
+    }
+    ~~~
+
+    The frame callback isn't called while zx_exec_runahead() runs
+    with one or more run-ahead frames.
+
+    ## Run-Ahead
+
+    To hide the input lag of games which react to input one or two frames
+    late, zx_exec_runahead() runs the emulation ahead of the 'real' state
+    and then rolls it back:
+
+    ~~~C
+    static zx_snapshot_t snapshot;
+    ...
+    // once per host frame, after applying the input
+    zx_exec_runahead(&sys, &snapshot, frame_time_us, 2);
+    ~~~
+
+    This runs the real frame with audio output but without video decoding,
+    saves a snapshot, runs the given number of frames ahead without audio
+    output (only the last of those frames is decoded into the pixel buffer),
+    and loads the snapshot again. With zero run-ahead frames,
+    zx_exec_runahead() is identical to zx_exec(). The scanline callback
+    only sees the lines of the last run-ahead frame.
+
+    A snapshot is a plain copy of the zx_t struct. Since a snapshot can only
+    be loaded back into the instance it was saved from, the internal
+    pointers (memory map, CPU callback user data) don't need to be fixed up,
+    so zx_save_snapshot() and zx_load_snapshot() are a single memcpy().
+    Loading a snapshot also restores the callbacks and the pixel buffer
+    pointer which were active when the snapshot was saved.
+
     ## TODO:
     - wait states when CPU accesses 'contended memory' and IO ports
     - reads from port 0xFF must return 'current VRAM bytes
@@ -91,6 +178,12 @@ typedef enum {
 
 /* audio sample data callback */
 typedef void (*zx_audio_callback_t)(const float* samples, int num_samples, void* user_data);
+/* beam racing callback, called with a range of decoded pixel buffer lines [y0, y1) */
+typedef void (*zx_scanline_callback_t)(int y0, int y1, void* user_data);
+/* frame callback, called at vsync when a complete frame is in the pixel buffer,
+   with the number of emulated CPU ticks since zx_init()
+*/
+typedef void (*zx_frame_callback_t)(uint64_t tick_count, void* user_data);
 
 /* config parameters for zx_init() */
 typedef struct {
@@ -100,6 +193,9 @@ typedef struct {
     /* video output config */
     void* pixel_buffer;         /* pointer to a linear RGBA8 pixel buffer, at least 320*256*4 bytes */
     int pixel_buffer_size;      /* size of the pixel buffer in bytes */
+    zx_scanline_callback_t scanline_cb;     /* optional beam racing callback */
+    int scanline_chunk;         /* number of lines per scanline_cb call, default is 16 */
+    zx_frame_callback_t frame_cb;   /* optional callback at vsync */
 
     /* optional user-data for callback functions */
     void* user_data;
@@ -133,7 +229,7 @@ typedef struct {
     bool memory_paging_disabled;
     uint8_t kbd_joymask;        /* joystick mask from keyboard joystick emulation */
     uint8_t joy_joymask;        /* joystick mask from zx_joystick() */
-    uint32_t tick_count;
+    uint64_t tick_count;        /* emulated CPU ticks since zx_init() */
     uint8_t last_mem_config;        /* last out to 0x7FFD */
     uint8_t last_fe_out;            /* last out value to 0xFE port */
     uint8_t blink_counter;          /* incremented on each vblank */
@@ -148,16 +244,29 @@ typedef struct {
     kbd_t kbd;
     mem_t mem;
     uint32_t* pixel_buffer;
+    zx_scanline_callback_t scanline_cb;
+    int scanline_chunk;
+    int scanline_y0, scanline_y1;   /* range of decoded lines not yet reported */
+    zx_frame_callback_t frame_cb;
     void* user_data;
     zx_audio_callback_t audio_cb;
     int num_samples;
     int sample_pos;
     float sample_buffer[ZX_MAX_AUDIO_SAMPLES];
     uint8_t ram[8][0x4000];
+#if defined(CHIPS_SHARED_ROMS)
+    const uint8_t* rom[2];
+#else
     uint8_t rom[2][0x4000];
+#endif
     uint8_t junk[0x4000];
 } zx_t;
 
+/* a snapshot of the zx_t state for run-ahead, see zx_save_snapshot() */
+typedef struct {
+    zx_t sys;
+} zx_snapshot_t;
+
 /* initialize a new ZX Spectrum instance */
 void zx_init(zx_t* sys, const zx_desc_t* desc);
 /* discard a ZX Spectrum instance */
@@ -174,6 +283,14 @@ int zx_display_height(zx_t* sys);
 void zx_reset(zx_t* sys);
 /* run ZX Spectrum instance for a given number of microseconds */
 void zx_exec(zx_t* sys, uint32_t micro_seconds);
+/* run the real frame, then run ahead a number of frames and roll back */
+void zx_exec_runahead(zx_t* sys, zx_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames);
+/* save the system state into a snapshot (only for loading into the same instance) */
+void zx_save_snapshot(const zx_t* sys, zx_snapshot_t* dst);
+/* load the system state from a snapshot saved from the same instance */
+void zx_load_snapshot(zx_t* sys, const zx_snapshot_t* src);
+/* switch to another pixel buffer (at least as big as the one passed to zx_init()) */
+void zx_set_pixel_buffer(zx_t* sys, void* pixel_buffer);
 /* send a key-down event */
 void zx_key_down(zx_t* sys, int key_code);
 /* send a key-up event */
@@ -184,7 +301,7 @@ void zx_set_joystick_type(zx_t* sys, zx_joystick_type_t type);
 zx_joystick_type_t zx_joystick_type(zx_t* sys);
 /* set joystick mask (combination of ZX_JOYSTICK_*) */
 void zx_joystick(zx_t* sys, uint8_t mask);
-/* load a ZX Z80 file into the emulator */
+/* load a ZX .z80, .sna or .szx snapshot file into the emulator */
 bool zx_quickload(zx_t* sys, const uint8_t* ptr, int num_bytes); 
 
 #ifdef __cplusplus
@@ -222,6 +339,9 @@ void zx_init(zx_t* sys, const zx_desc_t* desc) {
     sys->type = desc->type;
     sys->joystick_type = desc->joystick_type;
     sys->pixel_buffer = (uint32_t*) desc->pixel_buffer;
+    sys->scanline_cb = desc->scanline_cb;
+    sys->scanline_chunk = _ZX_DEFAULT(desc->scanline_chunk, 16);
+    sys->frame_cb = desc->frame_cb;
     sys->user_data = desc->user_data;
     sys->audio_cb = desc->audio_cb;
     sys->num_samples = _ZX_DEFAULT(desc->audio_num_samples, ZX_DEFAULT_AUDIO_SAMPLES);
@@ -232,8 +352,13 @@ void zx_init(zx_t* sys, const zx_desc_t* desc) {
     if (ZX_TYPE_128 == sys->type) {
         CHIPS_ASSERT(desc->rom_zx128_0 && (desc->rom_zx128_0_size == 0x4000));
         CHIPS_ASSERT(desc->rom_zx128_1 && (desc->rom_zx128_1_size == 0x4000));
+        #if defined(CHIPS_SHARED_ROMS)
+        sys->rom[0] = (const uint8_t*) desc->rom_zx128_0;
+        sys->rom[1] = (const uint8_t*) desc->rom_zx128_1;
+        #else
         memcpy(sys->rom[0], desc->rom_zx128_0, 0x4000);
         memcpy(sys->rom[1], desc->rom_zx128_1, 0x4000);
+        #endif
         sys->display_ram_bank = 5;
         sys->frame_scan_lines = 311;
         sys->top_border_scanlines = 63;
@@ -241,7 +366,11 @@ void zx_init(zx_t* sys, const zx_desc_t* desc) {
     }
     else {
         CHIPS_ASSERT(desc->rom_zx48k && (desc->rom_zx48k_size == 0x4000));
+        #if defined(CHIPS_SHARED_ROMS)
+        sys->rom[0] = (const uint8_t*) desc->rom_zx48k;
+        #else
         memcpy(sys->rom[0], desc->rom_zx48k, 0x4000);
+        #endif
         sys->display_ram_bank = 0;
         sys->frame_scan_lines = 312;
         sys->top_border_scanlines = 64;
@@ -335,6 +464,47 @@ void zx_exec(zx_t* sys, uint32_t micro_seconds) {
     kbd_update(&sys->kbd, micro_seconds);
 }
 
+void zx_save_snapshot(const zx_t* sys, zx_snapshot_t* dst) {
+    CHIPS_ASSERT(sys && sys->valid && dst);
+    memcpy(&dst->sys, sys, sizeof(zx_t));
+}
+
+void zx_load_snapshot(zx_t* sys, const zx_snapshot_t* src) {
+    CHIPS_ASSERT(sys && sys->valid && src && src->sys.valid);
+    /* the snapshot must have been saved from this instance */
+    CHIPS_ASSERT(src->sys.cpu.user_data == sys);
+    memcpy(sys, &src->sys, sizeof(zx_t));
+}
+
+void zx_exec_runahead(zx_t* sys, zx_snapshot_t* snapshot, uint32_t micro_seconds, int num_frames) {
+    CHIPS_ASSERT(sys && sys->valid && snapshot && (num_frames >= 0));
+    if (0 == num_frames) {
+        zx_exec(sys, micro_seconds);
+        return;
+    }
+    /* the real frame, the displayed frame comes from the last run-ahead frame */
+    uint32_t* pixel_buffer = sys->pixel_buffer;
+    zx_frame_callback_t frame_cb = sys->frame_cb;
+    sys->pixel_buffer = 0;
+    sys->frame_cb = 0;
+    zx_exec(sys, micro_seconds);
+    sys->pixel_buffer = pixel_buffer;
+    zx_save_snapshot(sys, snapshot);
+    /* run ahead without audio output, loading the snapshot restores the pointers */
+    sys->audio_cb = 0;
+    for (int i = 0; i < num_frames; i++) {
+        sys->pixel_buffer = (i == (num_frames - 1)) ? pixel_buffer : 0;
+        zx_exec(sys, micro_seconds);
+    }
+    zx_load_snapshot(sys, snapshot);
+    sys->frame_cb = frame_cb;
+}
+
+void zx_set_pixel_buffer(zx_t* sys, void* pixel_buffer) {
+    CHIPS_ASSERT(sys && sys->valid && pixel_buffer);
+    sys->pixel_buffer = (uint32_t*) pixel_buffer;
+}
+
 void zx_key_down(zx_t* sys, int key_code) {
     CHIPS_ASSERT(sys && sys->valid);
     switch (sys->joystick_type) {
@@ -614,6 +784,22 @@ static uint64_t _zx_tick(int num_ticks, uint64_t pins, void* user_data) {
     return pins;
 }
 
+/* collect decoded lines and report them in chunks to the scanline callback */
+static void _zx_scanline_decoded(zx_t* sys, int y) {
+    if (y != sys->scanline_y1) {
+        /* a new frame has started, report any lines left over from the last frame */
+        if (sys->scanline_y0 < sys->scanline_y1) {
+            sys->scanline_cb(sys->scanline_y0, sys->scanline_y1, sys->user_data);
+        }
+        sys->scanline_y0 = y;
+    }
+    sys->scanline_y1 = y + 1;
+    if (((sys->scanline_y1 - sys->scanline_y0) >= sys->scanline_chunk) || (sys->scanline_y1 == _ZX_DISPLAY_HEIGHT)) {
+        sys->scanline_cb(sys->scanline_y0, sys->scanline_y1, sys->user_data);
+        sys->scanline_y0 = sys->scanline_y1;
+    }
+}
+
 static bool _zx_decode_scanline(zx_t* sys) {
     /* this is called by the timer callback for every PAL line, controlling
         the vidmem decoding and vblank interrupt
@@ -635,7 +821,8 @@ static bool _zx_decode_scanline(zx_t* sys) {
     */
     const int top_decode_line = sys->top_border_scanlines - 32;
     const int btm_decode_line = sys->top_border_scanlines + 192 + 32;
-    if ((sys->scanline_y >= top_decode_line) && (sys->scanline_y < btm_decode_line)) {
+    /* the pixel buffer is null while skipping video decoding in zx_exec_runahead() */
+    if (sys->pixel_buffer && (sys->scanline_y >= top_decode_line) && (sys->scanline_y < btm_decode_line)) {
         const uint16_t y = sys->scanline_y - top_decode_line;
         uint32_t* dst = &sys->pixel_buffer[y * _ZX_DISPLAY_WIDTH];
         const uint8_t* vidmem_bank = sys->ram[sys->display_ram_bank];
@@ -694,12 +881,18 @@ static bool _zx_decode_scanline(zx_t* sys) {
                 *dst++ = sys->border_color;
             }
         }
+        if (sys->scanline_cb) {
+            _zx_scanline_decoded(sys, y);
+        }
     }
 
     if (sys->scanline_y++ >= sys->frame_scan_lines) {
         /* start new frame, request vblank interrupt */
         sys->scanline_y = 0;
         sys->blink_counter++;
+        if (sys->frame_cb) {
+            sys->frame_cb(sys->tick_count, sys->user_data);
+        }
         return true;
     }
     else {
@@ -842,7 +1035,7 @@ static bool _zx_overflow(const uint8_t* ptr, intptr_t num_bytes, const uint8_t*
     return (ptr + num_bytes) > end_ptr;
 }
 
-bool zx_quickload(zx_t* sys, const uint8_t* ptr, int num_bytes) {
+static bool _zx_load_z80(zx_t* sys, const uint8_t* ptr, int num_bytes) {
     const uint8_t* end_ptr = ptr + num_bytes;
     if (_zx_overflow(ptr, sizeof(_zx_z80_header), end_ptr)) {
         return false;
@@ -1003,4 +1196,503 @@ bool zx_quickload(zx_t* sys, const uint8_t* ptr, int num_bytes) {
     sys->border_color = _zx_palette[(hdr->flags0>>1) & 7] & 0xFFD7D7D7;
     return true;
 }
+
+/* simulate an OUT instruction, used to restore the port state of snapshots */
+static void _zx_out(zx_t* sys, uint16_t port, uint8_t data) {
+    uint64_t pins = Z80_IORQ|Z80_WR;
+    Z80_SET_ADDR(pins, port);
+    Z80_SET_DATA(pins, data);
+    _zx_tick(4, pins, sys);
+}
+
+/* write all AY-3-8912 registers and the selected register */
+static void _zx_set_ay_regs(zx_t* sys, const uint8_t* regs, uint8_t cur_reg) {
+    for (int i = 0; i < 16; i++) {
+        _zx_out(sys, 0xFFFD, (uint8_t)i);
+        _zx_out(sys, 0xBFFD, regs[i]);
+    }
+    _zx_out(sys, 0xFFFD, cur_reg);
+}
+
+/* ZX SNA file format header (https://worldofspectrum.org/faq/reference/formats.htm) */
+typedef struct {
+    uint8_t I;
+    uint8_t L_, H_, E_, D_, C_, B_, F_, A_;
+    uint8_t L, H, E, D, C, B;
+    uint8_t IY_l, IY_h;
+    uint8_t IX_l, IX_h;
+    uint8_t IFF;        /* bit 2 contains IFF2 */
+    uint8_t R;
+    uint8_t F, A;
+    uint8_t SP_l, SP_h;
+    uint8_t IM;
+    uint8_t border;
+} _zx_sna_header;
+
+/* ZX 128 SNA file extension after the first 48 KBytes */
+typedef struct {
+    uint8_t PC_l, PC_h;
+    uint8_t out_7ffd;
+    uint8_t trdos_rom;
+} _zx_sna_ext_header;
+
+#define _ZX_SNA_48K_SIZE (27 + 0xC000)
+#define _ZX_SNA_128K_SIZE (27 + 0xC000 + 4 + 5*0x4000)
+#define _ZX_SNA_128K_SIZE_EXT (27 + 0xC000 + 4 + 6*0x4000)
+
+static bool _zx_is_sna(int num_bytes) {
+    return (num_bytes == _ZX_SNA_48K_SIZE) || (num_bytes == _ZX_SNA_128K_SIZE) || (num_bytes == _ZX_SNA_128K_SIZE_EXT);
+}
+
+static bool _zx_load_sna(zx_t* sys, const uint8_t* ptr, int num_bytes) {
+    const bool is_128 = num_bytes != _ZX_SNA_48K_SIZE;
+    if (is_128 != (sys->type == ZX_TYPE_128)) {
+        return false;
+    }
+    const _zx_sna_header* hdr = (const _zx_sna_header*) ptr;
+    const uint8_t* ram = ptr + sizeof(_zx_sna_header);
+    uint16_t sp = hdr->SP_h<<8 | hdr->SP_l;
+    uint16_t pc;
+    if (is_128) {
+        /* banks 5, 2 and the paged bank, followed by the remaining banks in ascending order */
+        const _zx_sna_ext_header* ext_hdr = (const _zx_sna_ext_header*) (ram + 0xC000);
+        const int paged_bank = ext_hdr->out_7ffd & 7;
+        /* if the paged bank is 2 or 5, 6 instead of 5 banks follow, check that they fit before copying anything */
+        int num_rem_banks = 0;
+        for (int bank = 0; bank < 8; bank++) {
+            if ((bank != 5) && (bank != 2) && (bank != paged_bank)) {
+                num_rem_banks++;
+            }
+        }
+        const int rem_bytes = num_bytes - (int)(sizeof(_zx_sna_header) + 0xC000 + sizeof(_zx_sna_ext_header));
+        if ((num_rem_banks * 0x4000) > rem_bytes) {
+            return false;
+        }
+        memcpy(sys->ram[5], ram, 0x4000);
+        memcpy(sys->ram[2], ram + 0x4000, 0x4000);
+        memcpy(sys->ram[paged_bank], ram + 0x8000, 0x4000);
+        const uint8_t* src = ram + 0xC000 + sizeof(_zx_sna_ext_header);
+        for (int bank = 0; bank < 8; bank++) {
+            if ((bank != 5) && (bank != 2) && (bank != paged_bank)) {
+                memcpy(sys->ram[bank], src, 0x4000);
+                src += 0x4000;
+            }
+        }
+        pc = ext_hdr->PC_h<<8 | ext_hdr->PC_l;
+        sys->memory_paging_disabled = false;
+        _zx_out(sys, 0x7FFD, ext_hdr->out_7ffd);
+    }
+    else {
+        memcpy(sys->ram[0], ram, 0x4000);
+        memcpy(sys->ram[1], ram + 0x4000, 0x4000);
+        memcpy(sys->ram[2], ram + 0x8000, 0x4000);
+        /* on the 48K, the PC is on the stack (as if an interrupt had happened) */
+        pc = mem_rd16(&sys->mem, sp);
+        sp += 2;
+    }
+
+    /* start loaded image */
+    z80_reset(&sys->cpu);
+    z80_set_a(&sys->cpu, hdr->A); z80_set_f(&sys->cpu, hdr->F);
+    z80_set_b(&sys->cpu, hdr->B); z80_set_c(&sys->cpu, hdr->C);
+    z80_set_d(&sys->cpu, hdr->D); z80_set_e(&sys->cpu, hdr->E);
+    z80_set_h(&sys->cpu, hdr->H); z80_set_l(&sys->cpu, hdr->L);
+    z80_set_ix(&sys->cpu, hdr->IX_h<<8|hdr->IX_l);
+    z80_set_iy(&sys->cpu, hdr->IY_h<<8|hdr->IY_l);
+    z80_set_af_(&sys->cpu, hdr->A_<<8|hdr->F_);
+    z80_set_bc_(&sys->cpu, hdr->B_<<8|hdr->C_);
+    z80_set_de_(&sys->cpu, hdr->D_<<8|hdr->E_);
+    z80_set_hl_(&sys->cpu, hdr->H_<<8|hdr->L_);
+    z80_set_sp(&sys->cpu, sp);
+    z80_set_i(&sys->cpu, hdr->I);
+    z80_set_r(&sys->cpu, hdr->R);
+    z80_set_iff1(&sys->cpu, 0 != (hdr->IFF & (1<<2)));
+    z80_set_iff2(&sys->cpu, 0 != (hdr->IFF & (1<<2)));
+    z80_set_im(&sys->cpu, hdr->IM & 3);
+    z80_set_pc(&sys->cpu, pc);
+    _zx_out(sys, 0x00FE, hdr->border & 7);
+    return true;
+}
+
+/*  Minimal zlib decompressor for compressed SZX memory blocks
+    (see RFC 1950 and RFC 1951, this follows the structure of zlib's 'puff.c')
+*/
+typedef struct {
+    const uint8_t* src;
+    const uint8_t* src_end;
+    uint32_t bit_buf;
+    int bit_cnt;
+    uint8_t* dst;
+    int dst_pos;
+    int dst_size;
+    bool error;
+} _zx_inflate_t;
+
+typedef struct {
+    uint16_t count[16];     /* number of codes of each length */
+    uint16_t symbol[288];   /* symbols ordered by code */
+} _zx_huffman_t;
+
+static int _zx_inflate_bits(_zx_inflate_t* s, int num) {
+    while (s->bit_cnt < num) {
+        if (s->src >= s->src_end) {
+            s->error = true;
+            return 0;
+        }
+        s->bit_buf |= ((uint32_t)*s->src++) << s->bit_cnt;
+        s->bit_cnt += 8;
+    }
+    const int val = (int)(s->bit_buf & ((1U<<num) - 1));
+    s->bit_buf >>= num;
+    s->bit_cnt -= num;
+    return val;
+}
+
+static void _zx_inflate_build(_zx_huffman_t* h, const uint8_t* lengths, int num) {
+    uint16_t offs[16];
+    memset(h->count, 0, sizeof(h->count));
+    for (int i = 0; i < num; i++) {
+        h->count[lengths[i]]++;
+    }
+    h->count[0] = 0;
+    offs[1] = 0;
+    for (int len = 1; len < 15; len++) {
+        offs[len + 1] = offs[len] + h->count[len];
+    }
+    for (int i = 0; i < num; i++) {
+        if (lengths[i] != 0) {
+            h->symbol[offs[lengths[i]]++] = (uint16_t)i;
+        }
+    }
+}
+
+static int _zx_inflate_decode(_zx_inflate_t* s, const _zx_huffman_t* h) {
+    int code = 0, first = 0, index = 0;
+    for (int len = 1; len < 16; len++) {
+        code |= _zx_inflate_bits(s, 1);
+        const int count = h->count[len];
+        if ((code - count) < first) {
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    s->error = true;
+    return 0;
+}
+
+static void _zx_inflate_codes(_zx_inflate_t* s, const _zx_huffman_t* lencode, const _zx_huffman_t* distcode) {
+    static const uint16_t len_base[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t len_extra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t dist_base[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t dist_extra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    while (!s->error) {
+        int sym = _zx_inflate_decode(s, lencode);
+        if (sym < 256) {
+            if (s->dst_pos >= s->dst_size) {
+                s->error = true;
+                return;
+            }
+            s->dst[s->dst_pos++] = (uint8_t)sym;
+        }
+        else if (sym == 256) {
+            /* end of block */
+            return;
+        }
+        else {
+            sym -= 257;
+            if (sym >= 29) {
+                s->error = true;
+                return;
+            }
+            const int len = len_base[sym] + _zx_inflate_bits(s, len_extra[sym]);
+            const int dsym = _zx_inflate_decode(s, distcode);
+            if (dsym >= 30) {
+                s->error = true;
+                return;
+            }
+            const int dist = dist_base[dsym] + _zx_inflate_bits(s, dist_extra[dsym]);
+            if ((dist > s->dst_pos) || ((s->dst_pos + len) > s->dst_size)) {
+                s->error = true;
+                return;
+            }
+            for (int i = 0; i < len; i++, s->dst_pos++) {
+                s->dst[s->dst_pos] = s->dst[s->dst_pos - dist];
+            }
+        }
+    }
+}
+
+/* decompress a zlib stream, returns number of decompressed bytes, or -1 on error */
+static int _zx_inflate(const uint8_t* src, int src_size, uint8_t* dst, int dst_size) {
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    /* check the zlib header (deflate compression, no preset dictionary) */
+    if ((src_size < 2) || ((src[0] & 0x0F) != 8) || ((((src[0]<<8) | src[1]) % 31) != 0) || (src[1] & 0x20)) {
+        return -1;
+    }
+    _zx_inflate_t s;
+    memset(&s, 0, sizeof(s));
+    s.src = src + 2;
+    s.src_end = src + src_size;
+    s.dst = dst;
+    s.dst_size = dst_size;
+    _zx_huffman_t lencode, distcode;
+    uint8_t lengths[288 + 32];
+    bool last = false;
+    while (!last && !s.error) {
+        last = 0 != _zx_inflate_bits(&s, 1);
+        const int type = _zx_inflate_bits(&s, 2);
+        if (type == 0) {
+            /* stored block */
+            s.bit_buf = 0;
+            s.bit_cnt = 0;
+            if ((s.src + 4) > s.src_end) {
+                return -1;
+            }
+            const int len = s.src[0] | (s.src[1]<<8);
+            if (((s.src[0] ^ s.src[2]) != 0xFF) || ((s.src[1] ^ s.src[3]) != 0xFF)) {
+                return -1;
+            }
+            s.src += 4;
+            if (((s.src + len) > s.src_end) || ((s.dst_pos + len) > s.dst_size)) {
+                return -1;
+            }
+            memcpy(s.dst + s.dst_pos, s.src, (size_t)len);
+            s.src += len;
+            s.dst_pos += len;
+        }
+        else if (type == 1) {
+            /* fixed Huffman codes */
+            int i = 0;
+            for (; i < 144; i++) { lengths[i] = 8; }
+            for (; i < 256; i++) { lengths[i] = 9; }
+            for (; i < 280; i++) { lengths[i] = 7; }
+            for (; i < 288; i++) { lengths[i] = 8; }
+            _zx_inflate_build(&lencode, lengths, 288);
+            for (i = 0; i < 30; i++) { lengths[i] = 5; }
+            _zx_inflate_build(&distcode, lengths, 30);
+            _zx_inflate_codes(&s, &lencode, &distcode);
+        }
+        else if (type == 2) {
+            /* dynamic Huffman codes */
+            const int num_len = _zx_inflate_bits(&s, 5) + 257;
+            const int num_dist = _zx_inflate_bits(&s, 5) + 1;
+            const int num_code = _zx_inflate_bits(&s, 4) + 4;
+            if ((num_len > 286) || (num_dist > 30)) {
+                return -1;
+            }
+            memset(lengths, 0, sizeof(lengths));
+            for (int i = 0; i < num_code; i++) {
+                lengths[order[i]] = (uint8_t)_zx_inflate_bits(&s, 3);
+            }
+            _zx_inflate_build(&lencode, lengths, 19);
+            int i = 0;
+            while ((i < (num_len + num_dist)) && !s.error) {
+                int sym = _zx_inflate_decode(&s, &lencode);
+                if (sym < 16) {
+                    lengths[i++] = (uint8_t)sym;
+                }
+                else {
+                    uint8_t len = 0;
+                    int rep;
+                    if (sym == 16) {
+                        if (i == 0) {
+                            return -1;
+                        }
+                        len = lengths[i - 1];
+                        rep = 3 + _zx_inflate_bits(&s, 2);
+                    }
+                    else if (sym == 17) {
+                        rep = 3 + _zx_inflate_bits(&s, 3);
+                    }
+                    else {
+                        rep = 11 + _zx_inflate_bits(&s, 7);
+                    }
+                    if ((i + rep) > (num_len + num_dist)) {
+                        return -1;
+                    }
+                    while (rep--) {
+                        lengths[i++] = len;
+                    }
+                }
+            }
+            _zx_inflate_build(&lencode, lengths, num_len);
+            _zx_inflate_build(&distcode, lengths + num_len, num_dist);
+            _zx_inflate_codes(&s, &lencode, &distcode);
+        }
+        else {
+            return -1;
+        }
+    }
+    return s.error ? -1 : s.dst_pos;
+}
+
+/* ZX SZX file format (https://www.spectaculator.com/docs/svn/zx-state/intro.shtml) */
+typedef struct {
+    uint8_t magic[4];       /* 'ZXST' */
+    uint8_t major;
+    uint8_t minor;
+    uint8_t machine_id;     /* 0: 16K, 1: 48K, 2: 128K, 3: +2, ... */
+    uint8_t flags;
+} _zx_szx_header;
+
+typedef struct {
+    uint8_t id[4];
+    uint8_t size[4];
+} _zx_szx_block;
+
+/* 'Z80R' block */
+typedef struct {
+    uint8_t F, A, C, B, E, D, L, H;
+    uint8_t F_, A_, C_, B_, E_, D_, L_, H_;
+    uint8_t IX_l, IX_h, IY_l, IY_h;
+    uint8_t SP_l, SP_h, PC_l, PC_h;
+    uint8_t I, R;
+    uint8_t IFF1, IFF2;
+    uint8_t IM;
+    uint8_t cycles_start[4];
+    uint8_t hold_int_req_cycles;
+    uint8_t flags;          /* bit 0: last instruction was EI */
+    uint8_t WZ_l, WZ_h;
+} _zx_szx_z80r;
+
+/* 'SPCR' block */
+typedef struct {
+    uint8_t border;
+    uint8_t out_7ffd;
+    uint8_t out_1ffd;
+    uint8_t out_fe;
+    uint8_t reserved[4];
+} _zx_szx_spcr;
+
+/* 'RAMP' block header, followed by the (compressed) page data */
+typedef struct {
+    uint8_t flags_l, flags_h;   /* bit 0: page data is zlib-compressed */
+    uint8_t page_nr;
+} _zx_szx_ramp;
+
+/* 'AY\0\0' block */
+typedef struct {
+    uint8_t flags;
+    uint8_t cur_reg;
+    uint8_t regs[16];
+} _zx_szx_ay;
+
+static bool _zx_szx_id(const _zx_szx_block* blk, const char* id) {
+    return 0 == memcmp(blk->id, id, 4);
+}
+
+static bool _zx_is_szx(const uint8_t* ptr, int num_bytes) {
+    return (num_bytes >= (int)sizeof(_zx_szx_header)) && (0 == memcmp(ptr, "ZXST", 4));
+}
+
+static bool _zx_load_szx(zx_t* sys, const uint8_t* ptr, int num_bytes) {
+    const uint8_t* end_ptr = ptr + num_bytes;
+    const _zx_szx_header* hdr = (const _zx_szx_header*) ptr;
+    /* only the 48K and the original 128K and +2 machines are supported */
+    if (hdr->machine_id > 3) {
+        return false;
+    }
+    if ((hdr->machine_id >= 2) != (sys->type == ZX_TYPE_128)) {
+        return false;
+    }
+    ptr += sizeof(_zx_szx_header);
+    const _zx_szx_z80r* z80r = 0;
+    const _zx_szx_spcr* spcr = 0;
+    const _zx_szx_ay* ay = 0;
+    while (!_zx_overflow(ptr, sizeof(_zx_szx_block), end_ptr)) {
+        const _zx_szx_block* blk = (const _zx_szx_block*) ptr;
+        const uint32_t size = blk->size[0] | (blk->size[1]<<8) | (blk->size[2]<<16) | ((uint32_t)blk->size[3]<<24);
+        ptr += sizeof(_zx_szx_block);
+        if ((size > (uint32_t)num_bytes) || _zx_overflow(ptr, (intptr_t)size, end_ptr)) {
+            return false;
+        }
+        if (_zx_szx_id(blk, "Z80R") && (size >= sizeof(_zx_szx_z80r))) {
+            z80r = (const _zx_szx_z80r*) ptr;
+        }
+        else if (_zx_szx_id(blk, "SPCR") && (size >= sizeof(_zx_szx_spcr))) {
+            spcr = (const _zx_szx_spcr*) ptr;
+        }
+        else if (_zx_szx_id(blk, "AY\0\0") && (size >= sizeof(_zx_szx_ay))) {
+            ay = (const _zx_szx_ay*) ptr;
+        }
+        else if (_zx_szx_id(blk, "RAMP") && (size >= sizeof(_zx_szx_ramp))) {
+            const _zx_szx_ramp* ramp = (const _zx_szx_ramp*) ptr;
+            const uint8_t* src = ptr + sizeof(_zx_szx_ramp);
+            const int src_size = (int)size - (int)sizeof(_zx_szx_ramp);
+            int page_index = ramp->page_nr;
+            if (sys->type == ZX_TYPE_48K) {
+                /* the 48K has pages 5, 2 and 0 at 4000, 8000 and C000 */
+                page_index = (page_index == 5) ? 0 : ((page_index == 2) ? 1 : ((page_index == 0) ? 2 : -1));
+            }
+            if ((page_index >= 0) && (page_index < 8)) {
+                if (ramp->flags_l & 1) {
+                    if (0x4000 != _zx_inflate(src, src_size, sys->ram[page_index], 0x4000)) {
+                        return false;
+                    }
+                }
+                else {
+                    if (src_size < 0x4000) {
+                        return false;
+                    }
+                    memcpy(sys->ram[page_index], src, 0x4000);
+                }
+            }
+        }
+        /* all other blocks are ignored */
+        ptr += size;
+    }
+    if (0 == z80r) {
+        return false;
+    }
+
+    /* start loaded image */
+    z80_reset(&sys->cpu);
+    z80_set_a(&sys->cpu, z80r->A); z80_set_f(&sys->cpu, z80r->F);
+    z80_set_b(&sys->cpu, z80r->B); z80_set_c(&sys->cpu, z80r->C);
+    z80_set_d(&sys->cpu, z80r->D); z80_set_e(&sys->cpu, z80r->E);
+    z80_set_h(&sys->cpu, z80r->H); z80_set_l(&sys->cpu, z80r->L);
+    z80_set_ix(&sys->cpu, z80r->IX_h<<8|z80r->IX_l);
+    z80_set_iy(&sys->cpu, z80r->IY_h<<8|z80r->IY_l);
+    z80_set_af_(&sys->cpu, z80r->A_<<8|z80r->F_);
+    z80_set_bc_(&sys->cpu, z80r->B_<<8|z80r->C_);
+    z80_set_de_(&sys->cpu, z80r->D_<<8|z80r->E_);
+    z80_set_hl_(&sys->cpu, z80r->H_<<8|z80r->L_);
+    z80_set_sp(&sys->cpu, z80r->SP_h<<8|z80r->SP_l);
+    z80_set_pc(&sys->cpu, z80r->PC_h<<8|z80r->PC_l);
+    z80_set_wz(&sys->cpu, z80r->WZ_h<<8|z80r->WZ_l);
+    z80_set_i(&sys->cpu, z80r->I);
+    z80_set_r(&sys->cpu, z80r->R);
+    z80_set_iff1(&sys->cpu, z80r->IFF1 != 0);
+    z80_set_iff2(&sys->cpu, z80r->IFF2 != 0);
+    z80_set_im(&sys->cpu, z80r->IM & 3);
+    z80_set_ei_pending(&sys->cpu, 0 != (z80r->flags & 1));
+    if (sys->type == ZX_TYPE_128) {
+        if (ay) {
+            _zx_set_ay_regs(sys, ay->regs, ay->cur_reg);
+        }
+        if (spcr) {
+            sys->memory_paging_disabled = false;
+            _zx_out(sys, 0x7FFD, spcr->out_7ffd);
+        }
+    }
+    if (spcr) {
+        _zx_out(sys, 0x00FE, (spcr->out_fe & 0x18) | (spcr->border & 7));
+    }
+    return true;
+}
+
+bool zx_quickload(zx_t* sys, const uint8_t* ptr, int num_bytes) {
+    CHIPS_ASSERT(sys && sys->valid && ptr);
+    if (_zx_is_szx(ptr, num_bytes)) {
+        return _zx_load_szx(sys, ptr, num_bytes);
+    }
+    else if (_zx_is_sna(num_bytes)) {
+        return _zx_load_sna(sys, ptr, num_bytes);
+    }
+    else {
+        return _zx_load_z80(sys, ptr, num_bytes);
+    }
+}
 #endif /* CHIPS_IMPL */
@@ -0,0 +1,63 @@
+/*
+    ayplayer-test.c
+
+    Regression tests for the ayplayer.h file parsers, build and run with:
+
+    cc -std=c99 -I.. -fsanitize=address,undefined ayplayer-test.c -o ayplayer-test -pthread && ./ayplayer-test
+*/
+#define CHIPS_IMPL
+#include "chips/chips_state.h"
+#include "chips/ay38910.h"
+#include "chips/clk.h"
+#include "util/batch.h"
+#include "systems/ayplayer.h"
+#include <stdio.h>
+
+static int num_failed;
+#define T(c) { if (!(c)) { printf("FAILED: %s (line %d)\n", #c, __LINE__); num_failed++; } }
+
+static uint8_t work_buffer[1<<16];
+
+/* append bits (MSB first) to a byte buffer */
+static int put_bits(uint8_t* buf, int bitpos, uint32_t val, int num_bits) {
+    for (int i = num_bits - 1; i >= 0; i--, bitpos++) {
+        if (val & (1U << i)) {
+            buf[bitpos >> 3] |= (uint8_t)(0x80 >> (bitpos & 7));
+        }
+    }
+    return bitpos;
+}
+
+/* a VTX file whose LH5 code length table has four 1-bit codes (over-subscribed prefix code) */
+static void test_lh5_oversubscribed(void) {
+    uint8_t vtx[64] = {
+        'a', 'y', 0,            /* chip type, stereo mode */
+        0, 0,                   /* loop frame */
+        0x58, 0x0F, 0x1B, 0,    /* chip clock 1773400 Hz */
+        50,                     /* frame rate */
+        0, 0,                   /* year */
+        0x78, 0x05, 0, 0,       /* unpacked size 1400 bytes */
+        0, 0, 0, 0, 0,          /* title, author, program, tracker, comment */
+    };
+    int bit = 21 * 8;
+    bit = put_bits(vtx, bit, 1, 16);    /* block size */
+    bit = put_bits(vtx, bit, 4, 5);     /* 4 code length codes */
+    bit = put_bits(vtx, bit, 1, 3);     /* 3x length 1 */
+    bit = put_bits(vtx, bit, 1, 3);
+    bit = put_bits(vtx, bit, 1, 3);
+    bit = put_bits(vtx, bit, 0, 2);     /* no zero-run after the 3rd code */
+    put_bits(vtx, bit, 1, 3);           /* 4th length 1 */
+
+    ayplayer_t player;
+    ayplayer_init(&player, &(ayplayer_desc_t){ .work_buffer = work_buffer, .work_buffer_size = sizeof(work_buffer) });
+    T(!ayplayer_load(&player, vtx, sizeof(vtx)));
+    ayplayer_discard(&player);
+}
+
+int main(void) {
+    test_lh5_oversubscribed();
+    if (num_failed == 0) {
+        printf("ayplayer-test: all tests passed\n");
+    }
+    return num_failed ? 1 : 0;
+}
@@ -0,0 +1,63 @@
+/*
+    romdasm-test.c
+
+    Regression tests for romdasm.h, build and run with:
+
+    cc -std=c99 -I.. -fsanitize=address,undefined romdasm-test.c -o romdasm-test && ./romdasm-test
+*/
+#define CHIPS_IMPL
+#define ROMDASM_USE_Z80
+#include "util/z80dasm.h"
+#include "util/romdasm.h"
+#include <stdio.h>
+#include <string.h>
+
+static int num_failed;
+#define T(c) { if (!(c)) { printf("FAILED: %s (line %d)\n", #c, __LINE__); num_failed++; } }
+
+static uint8_t mem[1<<16];
+static romdasm_t dasm;
+
+/* disassemble code at address 0 and return the zero-terminated listing */
+static const char* z80_listing(const uint8_t* code, int num_bytes) {
+    memset(mem, 0, sizeof(mem));
+    memcpy(mem, code, (size_t)num_bytes);
+    romdasm_init(&dasm, &(romdasm_desc_t){ .cpu = ROMDASM_CPU_Z80, .mem = mem, .num_bytes = num_bytes });
+    romdasm_run(&dasm);
+    static char listing[4096];
+    const int len = (dasm.listing_size < (int)sizeof(listing)) ? dasm.listing_size : (int)sizeof(listing) - 1;
+    memcpy(listing, dasm.listing, (size_t)len);
+    listing[len] = 0;
+    romdasm_discard(&dasm);
+    return listing;
+}
+
+/* the first of two DD/FD prefixes is a NOP, the second prefix belongs to the next instruction */
+static void test_z80_double_prefix(void) {
+    const uint8_t dd_dd[] = { 0xDD, 0xDD, 0x21, 0x34, 0x12, 0x76 };
+    const char* l = z80_listing(dd_dd, sizeof(dd_dd));
+    T(0 == strstr(l, "DBL PREFIX"));
+    T(0 != strstr(l, "DB 0DDh"));
+    T(0 != strstr(l, "LD IX,1234h"));
+    T(0 == strstr(l, "LD HL,1234h"));
+    T(dasm.map[1] & ROMDASM_FLAG_OPSTART);
+
+    const uint8_t fd_dd[] = { 0xFD, 0xDD, 0x21, 0x34, 0x12, 0x76 };
+    l = z80_listing(fd_dd, sizeof(fd_dd));
+    T(0 != strstr(l, "DB 0FDh"));
+    T(0 != strstr(l, "LD IX,1234h"));
+
+    const uint8_t dd_ed[] = { 0xDD, 0xED, 0xB0, 0x76 };
+    l = z80_listing(dd_ed, sizeof(dd_ed));
+    T(0 != strstr(l, "DB 0DDh"));
+    T(0 != strstr(l, "LDIR"));
+    T(dasm.map[1] & ROMDASM_FLAG_OPSTART);
+}
+
+int main(void) {
+    test_z80_double_prefix();
+    if (num_failed == 0) {
+        printf("romdasm-test: all tests passed\n");
+    }
+    return num_failed ? 1 : 0;
+}
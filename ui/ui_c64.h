@@ -284,6 +284,8 @@ static void _ui_c64_mem_write(int layer, uint16_t addr, uint8_t data, void* user
             c64->ram[addr] = data;
             break;
         case _UI_C64_MEMLAYER_ROM:
+            /* shared ROM images are read-only */
+            #if !defined(CHIPS_SHARED_ROMS)
             if ((addr >= 0xA000) && (addr < 0xC000)) {
                 /* BASIC ROM */
                 c64->rom_basic[addr - 0xA000] = data;
@@ -296,6 +298,7 @@ static void _ui_c64_mem_write(int layer, uint16_t addr, uint8_t data, void* user
                 /* Kernal ROM */
                 c64->rom_kernal[addr - 0xE000] = data;
             }
+            #endif
             break;
         case _UI_C64_MEMLAYER_1541:
             if (ui->c64->c1541.valid) {
@@ -754,12 +757,14 @@ void ui_c64_draw(ui_c64_t* ui, double time_ms) {
 
 void ui_c64_exec(ui_c64_t* ui, uint32_t frame_time_us) {
     CHIPS_ASSERT(ui && ui->c64);
-    uint32_t ticks_to_run = clk_us_to_ticks(C64_FREQUENCY, frame_time_us);
     c64_t* c64 = ui->c64;
-    for (uint32_t i = 0; (i < ticks_to_run) && (!ui->dbg.dbg.stopped); i++) {
+    uint32_t ticks_to_run = clk_ticks_to_run(&c64->clk, frame_time_us);
+    uint32_t i = 0;
+    for (; (i < ticks_to_run) && (!ui->dbg.dbg.stopped); i++) {
         c64_tick(c64);
         ui_dbg_tick(&ui->dbg, c64->pins);
     }
+    clk_ticks_executed(&c64->clk, i);
     kbd_update(&ui->c64->kbd, frame_time_us);
 }
 
@@ -266,7 +266,15 @@ static void _ui_cpc_update_memmap(ui_cpc_t* ui) {
     }
 }
 
-static uint8_t* _ui_cpc_memptr(cpc_t* cpc, int layer, uint16_t addr) {
+#if defined(CHIPS_SHARED_ROMS)
+/* shared ROM images are read-only */
+#define _UI_CPC_ROMPTR(ptr, wr) ((wr) ? 0 : (uint8_t*)(ptr))
+#else
+#define _UI_CPC_ROMPTR(ptr, wr) (ptr)
+#endif
+
+static uint8_t* _ui_cpc_memptr(cpc_t* cpc, int layer, uint16_t addr, bool wr) {
+    (void)wr;
     CHIPS_ASSERT((layer >= _UI_CPC_MEMLAYER_GA) && (layer < _UI_CPC_MEMLAYER_NUM));
     if (layer == _UI_CPC_MEMLAYER_GA) {
         uint8_t* ram = &cpc->ram[0][0];
@@ -274,10 +282,10 @@ static uint8_t* _ui_cpc_memptr(cpc_t* cpc, int layer, uint16_t addr) {
     }
     else if (layer == _UI_CPC_MEMLAYER_ROMS) {
         if (addr < 0x4000) {
-            return &cpc->rom_os[addr];
+            return _UI_CPC_ROMPTR(&cpc->rom_os[addr], wr);
         }
         else if (addr >= 0xC000) {
-            return &cpc->rom_basic[addr - 0xC000];
+            return _UI_CPC_ROMPTR(&cpc->rom_basic[addr - 0xC000], wr);
         }
         else {
             return 0;
@@ -285,7 +293,7 @@ static uint8_t* _ui_cpc_memptr(cpc_t* cpc, int layer, uint16_t addr) {
     }
     else if (layer == _UI_CPC_MEMLAYER_AMSDOS) {
         if ((CPC_TYPE_6128 == cpc->type) && (addr >= 0xC000)) {
-            return &cpc->rom_amsdos[addr - 0xC000];
+            return _UI_CPC_ROMPTR(&cpc->rom_amsdos[addr - 0xC000], wr);
         }
         else {
             return 0;
@@ -330,7 +338,7 @@ static uint8_t _ui_cpc_mem_read(int layer, uint16_t addr, void* user_data) {
         return mem_rd(&cpc->mem, addr);
     }
     else {
-        uint8_t* ptr = _ui_cpc_memptr(cpc, layer, addr);
+        uint8_t* ptr = _ui_cpc_memptr(cpc, layer, addr, false);
         if (ptr) {
             return *ptr;
         }
@@ -348,7 +356,7 @@ static void _ui_cpc_mem_write(int layer, uint16_t addr, uint8_t data, void* user
         mem_wr(&cpc->mem, addr, data);
     }
     else {
-        uint8_t* ptr = _ui_cpc_memptr(cpc, layer, addr);
+        uint8_t* ptr = _ui_cpc_memptr(cpc, layer, addr, true);
         if (ptr) {
             *ptr = data;
         }
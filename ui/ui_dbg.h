@@ -260,6 +260,7 @@ typedef struct ui_dbg_heatmap_t {
     bool popup_addr_valid;
     uint16_t popup_addr;
     ui_dbg_heatmapitem_t items[1<<16];     /* execution counter map */
+    uint8_t op_len[1<<16];     /* cached instruction lengths, 0 if unknown */
     uint32_t pixels[1<<16];    /* execution counters converted to pixel data */
 } ui_dbg_heatmap_t;
 
@@ -376,19 +377,18 @@ static inline uint16_t _ui_dbg_disasm(ui_dbg_t* win, uint16_t pc) {
     return win->dasm.cur_addr;
 }
 
-/* disassemble the an instruction, but only return the length of the instruction */
-static inline uint16_t _ui_dbg_disasm_len(ui_dbg_t* win, uint16_t pc) {
+/* get the length of an instruction from the opcode length tables (no disassembly) */
+static inline int _ui_dbg_disasm_len(ui_dbg_t* win, uint16_t pc) {
     win->dasm.cur_addr = pc;
     win->dasm.str_pos = 0;
     win->dasm.bin_pos = 0;
     #if defined(UI_DBG_USE_Z80)
-        uint16_t next_pc = z80dasm_op(pc, _ui_dbg_dasm_in_cb, 0, win);
+        return z80dasm_oplen(_ui_dbg_dasm_in_cb, win);
     #elif defined(UI_DBG_USE_M6502)
-        uint16_t next_pc = m6502dasm_op(pc, _ui_dbg_dasm_in_cb, 0, win);
+        return m6502dasm_oplen(_ui_dbg_dasm_in_cb, win);
     #else
     #error "CPU TYPE"
     #endif
-    return next_pc - pc;
 }
 
 /* check if the an instruction is a 'step over' op */
@@ -800,7 +800,15 @@ static int _ui_dbg_bp_eval(uint16_t pc, uint32_t ticks, uint64_t pins, void* use
         /* first byte of an instruction */
         win->heatmap.items[pc].op_count++;
         win->heatmap.items[pc].op_start = 0;
-        int op_len = _ui_dbg_disasm_len(win, pc);
+        /* the instruction length is only looked up once per address until
+           the instruction bytes are overwritten (NOTE: bank switching isn't
+           detected, but this only affects the heatmap display)
+        */
+        int op_len = win->heatmap.op_len[pc];
+        if (0 == op_len) {
+            op_len = _ui_dbg_disasm_len(win, pc);
+            win->heatmap.op_len[pc] = (uint8_t) op_len;
+        }
         for (int i = 1; i < op_len; i++) {
             win->heatmap.items[(pc + i) & 0xFFFF].op_start = pc;
         }
@@ -822,6 +830,10 @@ static int _ui_dbg_bp_eval(uint16_t pc, uint32_t ticks, uint64_t pins, void* use
         else if ((pins & Z80_CTRL_MASK) == (Z80_MREQ|Z80_WR)) {
             const uint16_t addr = Z80_GET_ADDR(pins);
             win->heatmap.items[addr].write_count++;
+            /* the length of a Z80 instruction depends on its first 3 bytes */
+            win->heatmap.op_len[addr] = 0;
+            win->heatmap.op_len[(addr - 1) & 0xFFFF] = 0;
+            win->heatmap.op_len[(addr - 2) & 0xFFFF] = 0;
         }
     #elif defined(UI_DBG_USE_M6502)
         /* every tick on 6502 is either a read or a write */
@@ -831,6 +843,7 @@ static int _ui_dbg_bp_eval(uint16_t pc, uint32_t ticks, uint64_t pins, void* use
         }
         else {
             win->heatmap.items[addr].write_count++;
+            win->heatmap.op_len[addr] = 0;
         }
     #else
     #error "CPU TYPE"
@@ -1156,6 +1169,7 @@ static void _ui_dbg_heatmap_reset(ui_dbg_t* win) {
     win->heatmap.popup_addr_valid = false;
     win->heatmap.popup_addr = 0;
     memset(win->heatmap.items, 0, sizeof(win->heatmap.items));
+    memset(win->heatmap.op_len, 0, sizeof(win->heatmap.op_len));
 }
 
 static void _ui_dbg_heatmap_reboot(ui_dbg_t* win) {
@@ -1164,6 +1178,7 @@ static void _ui_dbg_heatmap_reboot(ui_dbg_t* win) {
 
 static void _ui_dbg_heatmap_clear_all(ui_dbg_t* win) {
     memset(win->heatmap.items, 0, sizeof(win->heatmap.items));
+    memset(win->heatmap.op_len, 0, sizeof(win->heatmap.op_len));
 }
 
 static void _ui_dbg_heatmap_clear_rw(ui_dbg_t* win) {
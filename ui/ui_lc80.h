@@ -1038,7 +1038,10 @@ void _ui_lc80_mem_write(int layer, uint16_t addr, uint8_t data, void* user_data)
     CHIPS_ASSERT(user_data);
     lc80_t* sys = (lc80_t*) user_data;
     if (addr < 0x0800) {
+        /* shared ROM images are read-only */
+        #if !defined(CHIPS_SHARED_ROMS)
         sys->rom[addr & 0x07FF] = data;
+        #endif
     }
     else if ((addr >= 0x2000) && (addr < 0x2400)) {
         sys->ram[addr & 0x3FF] = data;
@@ -147,8 +147,6 @@ static void _ui_m6502_regs(ui_m6502_t* win) {
     ui_util_b8("  Float:  ", cpu->io_floating);
     ui_util_b8("  Pullup: ", cpu->io_pullup);
     ui_util_b8("  Pins:   ", cpu->io_pins);
-    ImGui::Separator();
-    ImGui::Text("BCD: %s", cpu->bcd_enabled ? "enabled":"disabled");
 }
 
 void ui_m6502_draw(ui_m6502_t* win) {
@@ -157,12 +157,28 @@ static uint8_t _ui_namco_mem_read(int layer, uint16_t addr, void* user_data) {
     switch (layer) {
         case _UI_NAMCO_MEMLAYER_MAIN:
             return mem_rd(&ui->sys->mem, addr);
+        #if defined(CHIPS_SHARED_ROMS)
+        case _UI_NAMCO_MEMLAYER_GFX:
+            return ((addr < 0x4000) && ui->sys->rom_gfx[addr>>12]) ? ui->sys->rom_gfx[addr>>12][addr&0x0FFF] : 0xFF;
+        case _UI_NAMCO_MEMLAYER_PROM:
+            if (addr < 0x0020) {
+                return ui->sys->rom_prom[0][addr];
+            }
+            #if defined(NAMCO_PACMAN)
+            return (addr < 0x0120) ? ui->sys->rom_prom[1][addr - 0x0020] : 0xFF;
+            #else
+            return (addr < 0x0420) ? ui->sys->rom_prom[1][addr - 0x0020] : 0xFF;
+            #endif
+        case _UI_NAMCO_MEMLAYER_SOUND:
+            return (addr < 0x0200) ? ui->sys->sound.rom[addr/0x0100][addr&0x00FF] : 0xFF;
+        #else
         case _UI_NAMCO_MEMLAYER_GFX:
             return (addr < sizeof(ui->sys->rom_gfx)) ? ui->sys->rom_gfx[addr] : 0xFF;
         case _UI_NAMCO_MEMLAYER_PROM:
             return (addr < sizeof(ui->sys->rom_prom)) ? ui->sys->rom_prom[addr] : 0xFF;
         case _UI_NAMCO_MEMLAYER_SOUND:
             return (addr < sizeof(ui->sys->sound.rom)) ? ui->sys->sound.rom[addr/0x0100][addr&0x00FF] : 0xFF;
+        #endif
         default:
             return 0xFF;
     }
@@ -175,6 +191,8 @@ static void _ui_namco_mem_write(int layer, uint16_t addr, uint8_t data, void* us
         case _UI_NAMCO_MEMLAYER_MAIN:
             mem_wr(&ui->sys->mem, addr, data);
             break;
+        /* shared ROM images are read-only */
+        #if !defined(CHIPS_SHARED_ROMS)
         case _UI_NAMCO_MEMLAYER_GFX:
             if (addr < sizeof(ui->sys->rom_gfx)) {
                 ui->sys->rom_gfx[addr] = data;
@@ -190,6 +208,7 @@ static void _ui_namco_mem_write(int layer, uint16_t addr, uint8_t data, void* us
                 ui->sys->sound.rom[addr/0x0100][addr&0x00FF] = data;
             }
             break;
+        #endif
         default:
             break;
     }
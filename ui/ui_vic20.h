@@ -605,12 +605,14 @@ void ui_vic20_draw(ui_vic20_t* ui, double time_ms) {
 
 void ui_vic20_exec(ui_vic20_t* ui, uint32_t frame_time_us) {
     CHIPS_ASSERT(ui && ui->vic20);
-    uint32_t ticks_to_run = clk_us_to_ticks(VIC20_FREQUENCY, frame_time_us);
     vic20_t* vic20 = ui->vic20;
-    for (uint32_t i = 0; (i < ticks_to_run) && (!ui->dbg.dbg.stopped); i++) {
+    uint32_t ticks_to_run = clk_ticks_to_run(&vic20->clk, frame_time_us);
+    uint32_t i = 0;
+    for (; (i < ticks_to_run) && (!ui->dbg.dbg.stopped); i++) {
         vic20_tick(vic20);
         ui_dbg_tick(&ui->dbg, vic20->pins);
     }
+    clk_ticks_executed(&vic20->clk, i);
     kbd_update(&ui->vic20->kbd, frame_time_us);
 }
 
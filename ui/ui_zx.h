@@ -215,11 +215,19 @@ static void _ui_zx_update_memmap(ui_zx_t* ui) {
     }
 }
 
-static uint8_t* _ui_zx_memptr(zx_t* zx, int layer, uint16_t addr) {
+#if defined(CHIPS_SHARED_ROMS)
+/* shared ROM images are read-only */
+#define _UI_ZX_ROMPTR(ptr, wr) ((wr) ? 0 : (uint8_t*)(ptr))
+#else
+#define _UI_ZX_ROMPTR(ptr, wr) (ptr)
+#endif
+
+static uint8_t* _ui_zx_memptr(zx_t* zx, int layer, uint16_t addr, bool wr) {
+    (void)wr;
     if (0 == layer) {
         /* ZX128 ROM, RAM 5, RAM 2, RAM 0 */
         if (addr < 0x4000) {
-            return &zx->rom[0][addr];
+            return _UI_ZX_ROMPTR(&zx->rom[0][addr], wr);
         }
         else if (addr < 0x8000) {
             return &zx->ram[5][addr - 0x4000];
@@ -234,7 +242,7 @@ static uint8_t* _ui_zx_memptr(zx_t* zx, int layer, uint16_t addr) {
     else if (1 == layer) {
         /* 48K ROM, RAM 1 */
         if (addr < 0x4000) {
-            return &zx->rom[1][addr];
+            return _UI_ZX_ROMPTR(&zx->rom[1][addr], wr);
         }
         else if (addr >= 0xC000) {
             return &zx->ram[1][addr - 0xC000];
@@ -257,7 +265,7 @@ static uint8_t _ui_zx_mem_read(int layer, uint16_t addr, void* user_data) {
         return mem_rd(&zx->mem, addr);
     }
     else {
-        uint8_t* ptr = _ui_zx_memptr(zx, layer-1, addr);
+        uint8_t* ptr = _ui_zx_memptr(zx, layer-1, addr, false);
         if (ptr) {
             return *ptr;
         }
@@ -274,7 +282,7 @@ static void _ui_zx_mem_write(int layer, uint16_t addr, uint8_t data, void* user_
         mem_wr(&zx->mem, addr, data);
     }
     else {
-        uint8_t* ptr = _ui_zx_memptr(zx, layer-1, addr);
+        uint8_t* ptr = _ui_zx_memptr(zx, layer-1, addr, true);
         if (ptr) {
             *ptr = data;
         }
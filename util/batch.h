@@ -0,0 +1,201 @@
+#pragma once
+/*#
+    # batch.h
+
+    Run a list of independent jobs on a small set of worker threads.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    batch_run() runs on Win32 threads on Windows and on pthreads everywhere
+    else (link with -pthread).
+
+    ## Overview
+
+    This is the shared thread pool behind the batch rendering functions
+    of the music players (sidplayer_render_batch() and
+    ayplayer_render_batch()). Each worker owns one emulator instance,
+    the first worker runs on the calling thread. Each worker picks the
+    next unprocessed job index from a shared atomic counter until all
+    jobs are done, so long and short jobs are balanced automatically:
+
+    ~~~C
+    static bool job_cb(int worker_index, int job_index, void* user_data) {
+        my_ctx_t* ctx = (my_ctx_t*) user_data;
+        // run job 'job_index' on the instance owned by 'worker_index'
+        return my_render(&ctx->instances[worker_index], &ctx->jobs[job_index]);
+    }
+    ...
+    int num_ok = batch_run(&(batch_desc_t){
+        .num_workers = 4,
+        .num_jobs = NUM_JOBS,
+        .job_cb = job_cb,
+        .user_data = &ctx,
+    });
+    ~~~
+
+    The job callback must only touch the state owned by its worker and
+    by its job. If a thread can't be started, the remaining workers pick
+    up its share of the jobs.
+
+    ## Functions
+
+    ~~~C
+    int batch_run(const batch_desc_t* desc)
+    ~~~
+        Run desc->num_jobs jobs on desc->num_workers workers (at most
+        BATCH_MAX_WORKERS) and wait until all jobs are done. Returns
+        the number of jobs for which the job callback returned true.
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* max number of worker threads per batch_run() call */
+#define BATCH_MAX_WORKERS (64)
+
+/* run one job on a worker, return true if the job succeeded */
+typedef bool (*batch_job_cb_t)(int worker_index, int job_index, void* user_data);
+
+/* batch_run() parameters */
+typedef struct {
+    int num_workers;            /* 1..BATCH_MAX_WORKERS, worker 0 runs on the calling thread */
+    int num_jobs;               /* number of jobs, may be 0 */
+    batch_job_cb_t job_cb;      /* called once per job */
+    void* user_data;            /* passed to job_cb */
+} batch_desc_t;
+
+/* run all jobs and wait for completion, returns the number of successful jobs */
+int batch_run(const batch_desc_t* desc);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <pthread.h>
+#endif
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+typedef struct {
+    const batch_desc_t* desc;
+    int index;
+    long* next_job;             /* shared job counter */
+    long num_ok;                /* number of successful jobs on this worker */
+} _batch_worker_t;
+
+#if defined(_WIN32)
+static long _batch_next_job(long* counter) { return InterlockedIncrement(counter) - 1; }
+#else
+static long _batch_next_job(long* counter) { return __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED); }
+#endif
+
+static void _batch_worker(_batch_worker_t* w) {
+    const batch_desc_t* desc = w->desc;
+    long i;
+    while ((i = _batch_next_job(w->next_job)) < desc->num_jobs) {
+        if (desc->job_cb(w->index, (int)i, desc->user_data)) {
+            w->num_ok++;
+        }
+    }
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _batch_thread_func(LPVOID arg) {
+    _batch_worker((_batch_worker_t*)arg);
+    return 0;
+}
+#else
+static void* _batch_thread_func(void* arg) {
+    _batch_worker((_batch_worker_t*)arg);
+    return 0;
+}
+#endif
+
+int batch_run(const batch_desc_t* desc) {
+    CHIPS_ASSERT(desc && desc->job_cb);
+    CHIPS_ASSERT((desc->num_workers > 0) && (desc->num_workers <= BATCH_MAX_WORKERS));
+    CHIPS_ASSERT(desc->num_jobs >= 0);
+    const int num_workers = desc->num_workers;
+    long next_job = 0;
+    _batch_worker_t workers[BATCH_MAX_WORKERS];
+    #if defined(_WIN32)
+    HANDLE threads[BATCH_MAX_WORKERS];
+    #else
+    pthread_t threads[BATCH_MAX_WORKERS];
+    #endif
+    bool started[BATCH_MAX_WORKERS];
+    for (int i = 0; i < num_workers; i++) {
+        workers[i].desc = desc;
+        workers[i].index = i;
+        workers[i].next_job = &next_job;
+        workers[i].num_ok = 0;
+        started[i] = false;
+    }
+    /* if a thread can't be started, the remaining threads pick up its share */
+    for (int i = 1; i < num_workers; i++) {
+        #if defined(_WIN32)
+        threads[i] = CreateThread(NULL, 0, _batch_thread_func, &workers[i], 0, NULL);
+        started[i] = (threads[i] != NULL);
+        #else
+        started[i] = (0 == pthread_create(&threads[i], 0, _batch_thread_func, &workers[i]));
+        #endif
+    }
+    _batch_worker(&workers[0]);
+    int num_ok = (int) workers[0].num_ok;
+    for (int i = 1; i < num_workers; i++) {
+        if (started[i]) {
+            #if defined(_WIN32)
+            WaitForSingleObject(threads[i], INFINITE);
+            CloseHandle(threads[i]);
+            #else
+            pthread_join(threads[i], 0);
+            #endif
+            num_ok += (int) workers[i].num_ok;
+        }
+    }
+    return num_ok;
+}
+#endif /* CHIPS_IMPL */
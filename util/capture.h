@@ -0,0 +1,664 @@
+#pragma once
+/*#
+    # capture.h
+
+    Lossless video and audio capture for the system emulators, with
+    the encoding happening on a background thread.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    On Windows the implementation uses Win32 threads, everywhere else
+    pthreads (link with -pthread).
+
+    ## Overview
+
+    The emulator renders directly into frame buffers owned by the capture
+    module, so finished frames are handed to the encoder thread without
+    copying pixel data. At the end of a frame, capture_submit_frame()
+    queues the current frame buffer for encoding and returns the next free
+    frame buffer, the system's pixel buffer pointer must be updated to
+    this new buffer before running the next frame. Audio samples
+    are copied into a ring buffer (audio data is tiny compared to video
+    data). Nothing is ever dropped: if the encoder can't keep up, the
+    emulator thread blocks in capture_submit_frame() or capture_audio()
+    until frame buffers or audio ring space become free.
+
+    The encoder thread produces two output streams which are handed to a
+    user-provided write callback together with a byte offset, so that
+    the application decides where the data goes (usually two files):
+
+    - **CAPTURE_STREAM_VIDEO**: a simple lossless video format (see below)
+    - **CAPTURE_STREAM_AUDIO**: a WAV file with 32-bit float mono samples
+
+    The write callback is called from the encoder thread, except for the
+    initial and final stream headers which are written from capture_init()
+    and capture_finish().
+
+    ## Usage
+
+    Provide at least 3 frame buffers (the emulator renders into one, the
+    encoder keeps the previous frame as delta-reference, and at least one
+    is queued), each big enough for the system's pixel buffer:
+
+    ~~~C
+    static uint32_t frames[8][320*256];
+
+    capture_desc_t desc = {
+        .width = 320,
+        .height = 256,
+        .num_frames = 8,
+        .tick_freq = ZX_FREQUENCY,
+        .audio_sample_rate = 44100,
+        .write_cb = my_write,
+        .user_data = ...
+    };
+    for (int i = 0; i < 8; i++) {
+        desc.frames[i] = frames[i];
+    }
+    capture_init(&cap, &desc);
+    ~~~
+
+    Pass the first frame buffer as pixel buffer to the system, and provide
+    a frame callback which submits the complete frame at vsync and switches
+    the system over to the next frame buffer. The systems with a frame
+    callback (zx, c64, vic20 and cpc) call it when their video chip starts
+    a new frame, and provide a xxx_set_pixel_buffer() function to switch
+    the pixel buffer. This is necessary because most systems copy the pixel
+    buffer pointer into their video chip at init time, so assigning the
+    system's pixel_buffer member has no effect.
+
+    The frame callback receives the system's emulated tick count, which
+    is simply passed through to capture_submit_frame(), the frame
+    timestamps are derived from it inside the capture module:
+
+    ~~~C
+    static void frame_cb(uint64_t tick_count, void* user_data) {
+        c64_set_pixel_buffer(&sys, capture_submit_frame(&cap, tick_count));
+    }
+    ...
+    c64_init(&sys, &(c64_desc_t){
+        .pixel_buffer = capture_frame_buffer(&cap),
+        .pixel_buffer_size = ...,
+        .frame_cb = frame_cb,
+        .audio_cb = audio_cb,
+        ...
+    });
+    ~~~
+
+    Forward the system's audio callback output to the capture module:
+
+    ~~~C
+    static void audio_cb(const float* samples, int num_samples, void* user_data) {
+        capture_audio(&cap, samples, num_samples);
+        ...
+    }
+    ~~~
+
+    Since the frames are submitted at vsync, each captured frame contains
+    exactly one complete video frame, independent of how the emulation is
+    sliced into xxx_exec() calls. Frame capture doesn't work together with
+    run-ahead (the frame callback isn't called in xxx_exec_runahead()).
+
+    capture_submit_frame() only blocks if all frame buffers are in flight
+    (which means the encoder can't keep up). The audio ring buffer is
+    sized to hold the audio of CAPTURE_MAX_FRAMES frames with up to
+    CAPTURE_MAX_FRAME_SAMPLES samples per frame, so capture_audio() only
+    blocks in the same situation.
+
+    Finally, to finish the recording and stop the encoder thread:
+
+    ~~~C
+    capture_finish(&cap);
+    ~~~
+
+    ## Functions
+
+    ~~~C
+    void capture_init(capture_t* cap, const capture_desc_t* desc)
+    ~~~
+        Initialize a capture instance and start the encoder thread.
+
+    ~~~C
+    uint32_t* capture_frame_buffer(capture_t* cap)
+    ~~~
+        Return the frame buffer the emulator should currently render into.
+
+    ~~~C
+    uint32_t* capture_submit_frame(capture_t* cap, uint64_t tick_count)
+    ~~~
+        Queue the current frame buffer for encoding and return the next
+        frame buffer to render into. tick_count is the emulated tick
+        count passed to the system's frame callback, the frame's timestamp
+        is the number of ticks since the first submitted frame.
+
+    ~~~C
+    void capture_audio(capture_t* cap, const float* samples, int num_samples)
+    ~~~
+        Copy audio samples into the audio ring buffer. If the ring buffer
+        is full, this waits until the encoder thread has taken the pending
+        samples, no samples are dropped.
+
+    ~~~C
+    void capture_finish(capture_t* cap)
+    ~~~
+        Encode all pending data, write the final stream headers, and
+        stop the encoder thread.
+
+    ## Video Stream Format
+
+    All values are little-endian.
+
+    The stream starts with a 24-byte header:
+
+        uint8_t magic[8]        - "CHIPSCAP"
+        uint32_t version        - 1
+        uint32_t width          - frame width in pixels
+        uint32_t height         - frame height in pixels
+        uint32_t tick_freq      - emulated clock frequency for timestamps
+
+    Followed by one record per frame:
+
+        uint64_t timestamp      - emulated clock ticks since the first frame
+        uint32_t num_bytes      - size of the compressed frame data in bytes
+        ...                     - the compressed frame data
+
+    Each frame's RGBA8 pixels are XOR'ed with the previous frame's pixels
+    (the first frame with zeros), and the resulting 32-bit values are
+    run-length encoded as a sequence of packets, each starting with a
+    32-bit token:
+
+        - bit 31 set: a run of (token & 0x7FFFFFFF) pixels with the same
+          value, followed by one 32-bit value
+        - bit 31 cleared: (token) literal 32-bit values follow
+
+    Unchanged areas between frames thus compress to a few bytes.
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+#if !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CAPTURE_MAX_FRAMES (16)
+#define CAPTURE_MAX_FRAME_SAMPLES (2048)    /* max audio samples per frame (e.g. 96 kHz at 50 Hz) */
+#define CAPTURE_AUDIO_RING_SIZE (CAPTURE_MAX_FRAMES*CAPTURE_MAX_FRAME_SAMPLES)  /* number of samples in audio ring buffer */
+#define CAPTURE_ENCODE_BUFFER_SIZE (1<<14)  /* encoder output staging buffer size in bytes */
+
+#define CAPTURE_STREAM_VIDEO (0)
+#define CAPTURE_STREAM_AUDIO (1)
+
+/* write callback, called from the encoder thread */
+typedef void (*capture_write_t)(int stream, uint64_t offset, const void* data, int num_bytes, void* user_data);
+
+/* setup parameters for capture_init() */
+typedef struct {
+    int width;                  /* frame width in pixels */
+    int height;                 /* frame height in pixels */
+    uint32_t* frames[CAPTURE_MAX_FRAMES];   /* frame buffers, each at least width*height pixels */
+    int num_frames;             /* number of frame buffers (at least 3) */
+    uint32_t tick_freq;         /* emulated clock frequency in Hz for frame timestamps */
+    int audio_sample_rate;      /* audio sample rate, or 0 for no audio */
+    capture_write_t write_cb;   /* callback to write stream data */
+    void* user_data;            /* user data for the write callback */
+} capture_desc_t;
+
+/* thread synchronization objects */
+typedef struct {
+    #if defined(_WIN32)
+    void* thread;               /* HANDLE */
+    void* lock;                 /* SRWLOCK */
+    void* cond_work;            /* CONDITION_VARIABLE */
+    void* cond_free;            /* CONDITION_VARIABLE */
+    void* cond_audio;           /* CONDITION_VARIABLE */
+    #else
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond_work;
+    pthread_cond_t cond_free;
+    pthread_cond_t cond_audio;
+    #endif
+} capture_sync_t;
+
+/* capture state */
+typedef struct {
+    bool valid;
+    int width;
+    int height;
+    uint32_t tick_freq;
+    int audio_sample_rate;
+    capture_write_t write_cb;
+    void* user_data;
+    capture_sync_t sync;
+    bool quit;
+    /* frame buffers */
+    int num_frames;
+    uint32_t* frames[CAPTURE_MAX_FRAMES];
+    int cur_frame;                          /* frame buffer the emulator renders into */
+    int num_free;
+    int free_frames[CAPTURE_MAX_FRAMES];
+    int queue_head;                         /* queued frames ring buffer */
+    int queue_count;
+    int queue[CAPTURE_MAX_FRAMES];
+    uint64_t queue_timestamps[CAPTURE_MAX_FRAMES];
+    uint64_t first_tick_count;              /* tick count of the first submitted frame */
+    uint32_t num_submitted_frames;
+    /* audio ring buffer */
+    int audio_head;
+    int audio_count;
+    float audio_ring[CAPTURE_AUDIO_RING_SIZE];
+    /* encoder thread state */
+    int ref_frame;                          /* previous frame for delta encoding, or -1 */
+    uint64_t video_offset;
+    uint64_t audio_offset;
+    int enc_pos;
+    uint8_t enc_buf[CAPTURE_ENCODE_BUFFER_SIZE];
+    float audio_out[CAPTURE_AUDIO_RING_SIZE];
+    /* statistics */
+    uint32_t num_encoded_frames;
+    uint64_t num_encoded_samples;
+} capture_t;
+
+/* initialize a capture instance and start the encoder thread */
+void capture_init(capture_t* cap, const capture_desc_t* desc);
+/* get the frame buffer to render into */
+uint32_t* capture_frame_buffer(capture_t* cap);
+/* submit the current frame with the system's emulated tick count, return the next frame buffer */
+uint32_t* capture_submit_frame(capture_t* cap, uint64_t tick_count);
+/* copy audio samples into the audio ring buffer, waits if the ring buffer is full */
+void capture_audio(capture_t* cap, const float* samples, int num_samples);
+/* encode all pending data, finalize the streams and stop the encoder thread */
+void capture_finish(capture_t* cap);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#endif
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+#define _CAPTURE_VIDEO_HEADER_SIZE (24)
+#define _CAPTURE_FRAME_HEADER_SIZE (12)
+#define _CAPTURE_WAV_HEADER_SIZE (44)
+
+/*=== thread wrappers ========================================================*/
+#if defined(_WIN32)
+static void _capture_lock(capture_t* cap)     { AcquireSRWLockExclusive((PSRWLOCK)&cap->sync.lock); }
+static void _capture_unlock(capture_t* cap)   { ReleaseSRWLockExclusive((PSRWLOCK)&cap->sync.lock); }
+static void _capture_wait_work(capture_t* cap) { SleepConditionVariableSRW((PCONDITION_VARIABLE)&cap->sync.cond_work, (PSRWLOCK)&cap->sync.lock, INFINITE, 0); }
+static void _capture_wait_free(capture_t* cap) { SleepConditionVariableSRW((PCONDITION_VARIABLE)&cap->sync.cond_free, (PSRWLOCK)&cap->sync.lock, INFINITE, 0); }
+static void _capture_signal_work(capture_t* cap) { WakeConditionVariable((PCONDITION_VARIABLE)&cap->sync.cond_work); }
+static void _capture_signal_free(capture_t* cap) { WakeConditionVariable((PCONDITION_VARIABLE)&cap->sync.cond_free); }
+static void _capture_wait_audio(capture_t* cap) { SleepConditionVariableSRW((PCONDITION_VARIABLE)&cap->sync.cond_audio, (PSRWLOCK)&cap->sync.lock, INFINITE, 0); }
+static void _capture_signal_audio(capture_t* cap) { WakeConditionVariable((PCONDITION_VARIABLE)&cap->sync.cond_audio); }
+#else
+static void _capture_lock(capture_t* cap)     { pthread_mutex_lock(&cap->sync.lock); }
+static void _capture_unlock(capture_t* cap)   { pthread_mutex_unlock(&cap->sync.lock); }
+static void _capture_wait_work(capture_t* cap) { pthread_cond_wait(&cap->sync.cond_work, &cap->sync.lock); }
+static void _capture_wait_free(capture_t* cap) { pthread_cond_wait(&cap->sync.cond_free, &cap->sync.lock); }
+static void _capture_signal_work(capture_t* cap) { pthread_cond_signal(&cap->sync.cond_work); }
+static void _capture_signal_free(capture_t* cap) { pthread_cond_signal(&cap->sync.cond_free); }
+static void _capture_wait_audio(capture_t* cap) { pthread_cond_wait(&cap->sync.cond_audio, &cap->sync.lock); }
+static void _capture_signal_audio(capture_t* cap) { pthread_cond_signal(&cap->sync.cond_audio); }
+#endif
+
+/*=== encoder ================================================================*/
+static void _capture_put32(uint8_t* dst, uint32_t val) {
+    dst[0] = (uint8_t)val;
+    dst[1] = (uint8_t)(val >> 8);
+    dst[2] = (uint8_t)(val >> 16);
+    dst[3] = (uint8_t)(val >> 24);
+}
+
+static void _capture_put64(uint8_t* dst, uint64_t val) {
+    _capture_put32(dst, (uint32_t)val);
+    _capture_put32(dst + 4, (uint32_t)(val >> 32));
+}
+
+/* flush the encoder staging buffer to the video stream */
+static void _capture_enc_flush(capture_t* cap) {
+    if (cap->enc_pos > 0) {
+        cap->write_cb(CAPTURE_STREAM_VIDEO, cap->video_offset, cap->enc_buf, cap->enc_pos, cap->user_data);
+        cap->video_offset += (uint64_t)cap->enc_pos;
+        cap->enc_pos = 0;
+    }
+}
+
+static void _capture_enc32(capture_t* cap, uint32_t val) {
+    if ((cap->enc_pos + 4) > CAPTURE_ENCODE_BUFFER_SIZE) {
+        _capture_enc_flush(cap);
+    }
+    _capture_put32(&cap->enc_buf[cap->enc_pos], val);
+    cap->enc_pos += 4;
+}
+
+/* the delta value of a pixel against the reference frame */
+static inline uint32_t _capture_delta(const uint32_t* src, const uint32_t* ref, int i) {
+    return ref ? (src[i] ^ ref[i]) : src[i];
+}
+
+/* delta- and run-length-encode a frame into the video stream */
+static void _capture_encode_frame(capture_t* cap, int frame_index, uint64_t timestamp) {
+    const uint32_t* src = cap->frames[frame_index];
+    const uint32_t* ref = (cap->ref_frame >= 0) ? cap->frames[cap->ref_frame] : 0;
+    const int num_pixels = cap->width * cap->height;
+
+    /* the frame header is written after the frame data once the size is known */
+    _capture_enc_flush(cap);
+    const uint64_t header_offset = cap->video_offset;
+    cap->video_offset += _CAPTURE_FRAME_HEADER_SIZE;
+
+    int i = 0;
+    int lit_start = 0;
+    while (i < num_pixels) {
+        /* find length of run of identical delta values */
+        const uint32_t val = _capture_delta(src, ref, i);
+        int run = 1;
+        while (((i + run) < num_pixels) && (_capture_delta(src, ref, i + run) == val)) {
+            run++;
+        }
+        if (run >= 3) {
+            /* flush pending literals, then write the run */
+            if (lit_start < i) {
+                _capture_enc32(cap, (uint32_t)(i - lit_start));
+                for (int j = lit_start; j < i; j++) {
+                    _capture_enc32(cap, _capture_delta(src, ref, j));
+                }
+            }
+            _capture_enc32(cap, 0x80000000 | (uint32_t)run);
+            _capture_enc32(cap, val);
+            i += run;
+            lit_start = i;
+        }
+        else {
+            i += run;
+        }
+    }
+    if (lit_start < num_pixels) {
+        _capture_enc32(cap, (uint32_t)(num_pixels - lit_start));
+        for (int j = lit_start; j < num_pixels; j++) {
+            _capture_enc32(cap, _capture_delta(src, ref, j));
+        }
+    }
+    _capture_enc_flush(cap);
+
+    uint8_t header[_CAPTURE_FRAME_HEADER_SIZE];
+    _capture_put64(header, timestamp);
+    _capture_put32(header + 8, (uint32_t)(cap->video_offset - header_offset - _CAPTURE_FRAME_HEADER_SIZE));
+    cap->write_cb(CAPTURE_STREAM_VIDEO, header_offset, header, _CAPTURE_FRAME_HEADER_SIZE, cap->user_data);
+    cap->num_encoded_frames++;
+}
+
+static void _capture_write_video_header(capture_t* cap) {
+    uint8_t header[_CAPTURE_VIDEO_HEADER_SIZE];
+    memcpy(header, "CHIPSCAP", 8);
+    _capture_put32(header + 8, 1);
+    _capture_put32(header + 12, (uint32_t)cap->width);
+    _capture_put32(header + 16, (uint32_t)cap->height);
+    _capture_put32(header + 20, cap->tick_freq);
+    cap->write_cb(CAPTURE_STREAM_VIDEO, 0, header, _CAPTURE_VIDEO_HEADER_SIZE, cap->user_data);
+    cap->video_offset = _CAPTURE_VIDEO_HEADER_SIZE;
+}
+
+/* write the WAV header (32-bit float, mono), called at start and again when finished */
+static void _capture_write_wav_header(capture_t* cap) {
+    const uint32_t data_size = (uint32_t)(cap->num_encoded_samples * 4);
+    uint8_t header[_CAPTURE_WAV_HEADER_SIZE];
+    memcpy(header, "RIFF", 4);
+    _capture_put32(header + 4, 36 + data_size);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    _capture_put32(header + 16, 16);                                /* fmt chunk size */
+    _capture_put32(header + 20, 3 | (1<<16));                       /* format: IEEE float, 1 channel */
+    _capture_put32(header + 24, (uint32_t)cap->audio_sample_rate);
+    _capture_put32(header + 28, (uint32_t)cap->audio_sample_rate * 4);  /* bytes per second */
+    _capture_put32(header + 32, 4 | (32<<16));                      /* block align, bits per sample */
+    memcpy(header + 36, "data", 4);
+    _capture_put32(header + 40, data_size);
+    cap->write_cb(CAPTURE_STREAM_AUDIO, 0, header, _CAPTURE_WAV_HEADER_SIZE, cap->user_data);
+}
+
+/* write audio samples, converted to little-endian */
+static void _capture_write_audio(capture_t* cap, int num_samples) {
+    uint8_t* dst = cap->enc_buf;
+    for (int i = 0; i < num_samples; i++) {
+        uint32_t bits;
+        memcpy(&bits, &cap->audio_out[i], 4);
+        _capture_put32(dst, bits);
+        dst += 4;
+        if ((dst == &cap->enc_buf[CAPTURE_ENCODE_BUFFER_SIZE]) || (i == (num_samples - 1))) {
+            const int num_bytes = (int)(dst - cap->enc_buf);
+            cap->write_cb(CAPTURE_STREAM_AUDIO, _CAPTURE_WAV_HEADER_SIZE + cap->audio_offset, cap->enc_buf, num_bytes, cap->user_data);
+            cap->audio_offset += (uint64_t)num_bytes;
+            dst = cap->enc_buf;
+        }
+    }
+    cap->num_encoded_samples += (uint64_t)num_samples;
+}
+
+/* the encoder thread function */
+static void _capture_encoder(capture_t* cap) {
+    _capture_lock(cap);
+    while (true) {
+        while (!cap->quit && (cap->queue_count == 0) && (cap->audio_count == 0)) {
+            _capture_wait_work(cap);
+        }
+        if (cap->quit && (cap->queue_count == 0) && (cap->audio_count == 0)) {
+            break;
+        }
+        /* take the next queued frame */
+        int frame_index = -1;
+        uint64_t timestamp = 0;
+        if (cap->queue_count > 0) {
+            frame_index = cap->queue[cap->queue_head];
+            timestamp = cap->queue_timestamps[cap->queue_head];
+            cap->queue_head = (cap->queue_head + 1) % CAPTURE_MAX_FRAMES;
+            cap->queue_count--;
+        }
+        /* take all pending audio samples */
+        const int num_samples = cap->audio_count;
+        const int tail = (cap->audio_head - num_samples) & (CAPTURE_AUDIO_RING_SIZE - 1);
+        for (int i = 0; i < num_samples; i++) {
+            cap->audio_out[i] = cap->audio_ring[(tail + i) & (CAPTURE_AUDIO_RING_SIZE - 1)];
+        }
+        cap->audio_count = 0;
+        if (num_samples > 0) {
+            _capture_signal_audio(cap);
+        }
+        _capture_unlock(cap);
+
+        /* encode without holding the lock */
+        if (frame_index >= 0) {
+            _capture_encode_frame(cap, frame_index, timestamp);
+        }
+        if (num_samples > 0) {
+            _capture_write_audio(cap, num_samples);
+        }
+
+        _capture_lock(cap);
+        if (frame_index >= 0) {
+            /* the previous reference frame is free now */
+            if (cap->ref_frame >= 0) {
+                cap->free_frames[cap->num_free++] = cap->ref_frame;
+                _capture_signal_free(cap);
+            }
+            cap->ref_frame = frame_index;
+        }
+    }
+    _capture_unlock(cap);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI _capture_thread_func(LPVOID arg) {
+    _capture_encoder((capture_t*)arg);
+    return 0;
+}
+#else
+static void* _capture_thread_func(void* arg) {
+    _capture_encoder((capture_t*)arg);
+    return 0;
+}
+#endif
+
+/*=== public functions =======================================================*/
+void capture_init(capture_t* cap, const capture_desc_t* desc) {
+    CHIPS_ASSERT(cap && desc);
+    CHIPS_ASSERT((desc->width > 0) && (desc->height > 0));
+    CHIPS_ASSERT((desc->num_frames >= 3) && (desc->num_frames <= CAPTURE_MAX_FRAMES));
+    CHIPS_ASSERT(desc->write_cb);
+    memset(cap, 0, sizeof(*cap));
+    cap->valid = true;
+    cap->width = desc->width;
+    cap->height = desc->height;
+    cap->tick_freq = desc->tick_freq;
+    cap->audio_sample_rate = desc->audio_sample_rate;
+    cap->write_cb = desc->write_cb;
+    cap->user_data = desc->user_data;
+    cap->num_frames = desc->num_frames;
+    for (int i = 0; i < cap->num_frames; i++) {
+        CHIPS_ASSERT(desc->frames[i]);
+        cap->frames[i] = desc->frames[i];
+    }
+    /* frame 0 is the current render target, all others are free */
+    cap->cur_frame = 0;
+    for (int i = cap->num_frames - 1; i > 0; i--) {
+        cap->free_frames[cap->num_free++] = i;
+    }
+    cap->ref_frame = -1;
+
+    _capture_write_video_header(cap);
+    if (cap->audio_sample_rate > 0) {
+        _capture_write_wav_header(cap);
+    }
+
+    #if defined(_WIN32)
+        InitializeSRWLock((PSRWLOCK)&cap->sync.lock);
+        InitializeConditionVariable((PCONDITION_VARIABLE)&cap->sync.cond_work);
+        InitializeConditionVariable((PCONDITION_VARIABLE)&cap->sync.cond_free);
+        InitializeConditionVariable((PCONDITION_VARIABLE)&cap->sync.cond_audio);
+        cap->sync.thread = (void*) CreateThread(0, 0, _capture_thread_func, cap, 0, 0);
+        CHIPS_ASSERT(cap->sync.thread);
+    #else
+        pthread_mutex_init(&cap->sync.lock, 0);
+        pthread_cond_init(&cap->sync.cond_work, 0);
+        pthread_cond_init(&cap->sync.cond_free, 0);
+        pthread_cond_init(&cap->sync.cond_audio, 0);
+        int res = pthread_create(&cap->sync.thread, 0, _capture_thread_func, cap);
+        CHIPS_ASSERT(0 == res); (void)res;
+    #endif
+}
+
+uint32_t* capture_frame_buffer(capture_t* cap) {
+    CHIPS_ASSERT(cap && cap->valid);
+    return cap->frames[cap->cur_frame];
+}
+
+uint32_t* capture_submit_frame(capture_t* cap, uint64_t tick_count) {
+    CHIPS_ASSERT(cap && cap->valid);
+    if (cap->num_submitted_frames++ == 0) {
+        cap->first_tick_count = tick_count;
+    }
+    CHIPS_ASSERT(tick_count >= cap->first_tick_count);
+    _capture_lock(cap);
+    const int tail = (cap->queue_head + cap->queue_count) % CAPTURE_MAX_FRAMES;
+    cap->queue[tail] = cap->cur_frame;
+    cap->queue_timestamps[tail] = tick_count - cap->first_tick_count;
+    cap->queue_count++;
+    _capture_signal_work(cap);
+    /* only blocks if the encoder can't keep up */
+    while (cap->num_free == 0) {
+        _capture_wait_free(cap);
+    }
+    cap->cur_frame = cap->free_frames[--cap->num_free];
+    _capture_unlock(cap);
+    return cap->frames[cap->cur_frame];
+}
+
+void capture_audio(capture_t* cap, const float* samples, int num_samples) {
+    CHIPS_ASSERT(cap && cap->valid && samples);
+    if (cap->audio_sample_rate == 0) {
+        return;
+    }
+    _capture_lock(cap);
+    for (int i = 0; i < num_samples; i++) {
+        if (cap->audio_count == CAPTURE_AUDIO_RING_SIZE) {
+            /* ring buffer full, wake the encoder and wait until it took the samples */
+            _capture_signal_work(cap);
+            while (cap->audio_count == CAPTURE_AUDIO_RING_SIZE) {
+                _capture_wait_audio(cap);
+            }
+        }
+        cap->audio_ring[cap->audio_head] = samples[i];
+        cap->audio_head = (cap->audio_head + 1) & (CAPTURE_AUDIO_RING_SIZE - 1);
+        cap->audio_count++;
+    }
+    _capture_signal_work(cap);
+    _capture_unlock(cap);
+}
+
+void capture_finish(capture_t* cap) {
+    CHIPS_ASSERT(cap && cap->valid);
+    _capture_lock(cap);
+    cap->quit = true;
+    _capture_signal_work(cap);
+    _capture_unlock(cap);
+    #if defined(_WIN32)
+        WaitForSingleObject((HANDLE)cap->sync.thread, INFINITE);
+        CloseHandle((HANDLE)cap->sync.thread);
+    #else
+        pthread_join(cap->sync.thread, 0);
+        pthread_cond_destroy(&cap->sync.cond_audio);
+        pthread_cond_destroy(&cap->sync.cond_free);
+        pthread_cond_destroy(&cap->sync.cond_work);
+        pthread_mutex_destroy(&cap->sync.lock);
+    #endif
+    /* rewrite the WAV header with the final data size */
+    if (cap->audio_sample_rate > 0) {
+        _capture_write_wav_header(cap);
+    }
+    cap->valid = false;
+}
+#endif /* CHIPS_IMPL */
@@ -0,0 +1,424 @@
+#pragma once
+/*#
+    # chipstate.h
+
+    Generic chip state introspection: visit, diff, save and load the
+    state of any chip emulator through the chip's field descriptor table,
+    without per-chip code and without memory allocations.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    You need to include the following headers before including chipstate.h:
+
+    - chips/chips_state.h
+    - at least one chip header with a field descriptor table (e.g. chips/z80.h)
+
+    ## Field Descriptor Tables
+
+    Each chip header exports a compile-time table which describes the
+    chip's state struct, the table is returned by a function named
+    after the chip:
+
+    ~~~C
+    const chips_state_desc_t* z80_state_desc(void);
+    const chips_state_desc_t* m6569_state_desc(void);
+    ...
+    ~~~
+
+    A chips_state_desc_t has the chip name, the size of the state struct,
+    and an array of chips_state_field_t items, each with:
+
+    - **name**: the field name in the state struct
+    - **kind**: CHIPS_STATE_BOOL, CHIPS_STATE_UINT, CHIPS_STATE_INT,
+      CHIPS_STATE_FLOAT or CHIPS_STATE_STRUCT
+    - **offset**: the byte offset in the (parent) struct
+    - **size**: the byte size of one element
+    - **count**: the number of array elements (1 for non-array fields)
+    - **fields, num_fields**: the nested fields of a CHIPS_STATE_STRUCT
+
+    The tables are built with the CHIPS_FIELD_xxx() macros from
+    chips/chips_state.h.
+
+    Callbacks, user data and other pointers are not described, so the
+    tables cover the emulation state which can be serialized, diffed or
+    displayed, but a chip instance must be initialized with the regular
+    init function before loading a saved state into it.
+
+    ## Functions
+
+    ~~~C
+    void chipstate_visit(const chips_state_desc_t* desc, const void* state, chipstate_visit_t cb, void* user_data)
+    ~~~
+        Call the visitor callback for each scalar (or scalar-array) field
+        in the chip state, nested structs are flattened into paths like
+        "voice[1].freq":
+
+        ~~~C
+        void visit_cb(const chipstate_item_t* item, void* user_data) {
+            for (uint32_t i = 0; i < item->field->count; i++) {
+                printf("%s: %f\n", item->path, chipstate_value(item->field, item->ptr, i));
+            }
+        }
+        ...
+        chipstate_visit(m6581_state_desc(), &sid, visit_cb, 0);
+        ~~~
+
+    ~~~C
+    uint64_t chipstate_bits(const chips_state_field_t* field, const void* ptr, uint32_t index)
+    ~~~
+        Get the raw bits of a field element as integer (for floats the
+        IEEE-754 bit pattern).
+
+    ~~~C
+    double chipstate_value(const chips_state_field_t* field, const void* ptr, uint32_t index)
+    ~~~
+        Get the numeric value of a field element (signed, unsigned or float).
+
+    ~~~C
+    int chipstate_diff(const chips_state_desc_t* desc, const void* a, const void* b, chipstate_diff_t cb, void* user_data)
+    ~~~
+        Compare two chip states and call the optional diff callback for
+        each differing field element, returns the number of differing
+        field elements.
+
+    ~~~C
+    int chipstate_size(const chips_state_desc_t* desc)
+    ~~~
+        Return the number of bytes needed by chipstate_save().
+
+    ~~~C
+    int chipstate_save(const chips_state_desc_t* desc, const void* state, void* dst, int dst_size)
+    ~~~
+        Serialize the chip state into a packed little-endian byte
+        stream, returns the number of bytes written, or 0 if dst_size is
+        too small.
+
+    ~~~C
+    int chipstate_load(const chips_state_desc_t* desc, void* state, const void* src, int src_size)
+    ~~~
+        Load the chip state from a byte stream written by chipstate_save(),
+        returns the number of bytes read, or 0 if src_size is too small.
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHIPSTATE_MAX_PATH (128)
+
+/* a visited field */
+typedef struct {
+    const char* path;                   /* full field path, e.g. "voice[1].freq" */
+    const chips_state_field_t* field;   /* the field descriptor */
+    const void* ptr;                    /* pointer to the first element in the chip state */
+} chipstate_item_t;
+
+/* visitor callback */
+typedef void (*chipstate_visit_t)(const chipstate_item_t* item, void* user_data);
+/* diff callback, a and b are the raw bits of the differing element */
+typedef void (*chipstate_diff_t)(const chipstate_item_t* item, uint32_t index, uint64_t a, uint64_t b, void* user_data);
+
+/* call visitor callback for each field in the chip state */
+void chipstate_visit(const chips_state_desc_t* desc, const void* state, chipstate_visit_t cb, void* user_data);
+/* get the raw bits of a field element */
+uint64_t chipstate_bits(const chips_state_field_t* field, const void* ptr, uint32_t index);
+/* get the numeric value of a field element */
+double chipstate_value(const chips_state_field_t* field, const void* ptr, uint32_t index);
+/* compare two chip states, return number of differing field elements */
+int chipstate_diff(const chips_state_desc_t* desc, const void* a, const void* b, chipstate_diff_t cb, void* user_data);
+/* return the serialized size of a chip state */
+int chipstate_size(const chips_state_desc_t* desc);
+/* serialize a chip state, return number of bytes written */
+int chipstate_save(const chips_state_desc_t* desc, const void* state, void* dst, int dst_size);
+/* load a serialized chip state, return number of bytes read */
+int chipstate_load(const chips_state_desc_t* desc, void* state, const void* src, int src_size);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+/* internal callback for walking the leaf fields */
+typedef void (*_chipstate_walk_t)(const chipstate_item_t* item, void* ctx);
+
+/* append a string to the path buffer, truncates if too long */
+static int _chipstate_append(char* path, int pos, const char* str) {
+    while (*str && (pos < (CHIPSTATE_MAX_PATH - 1))) {
+        path[pos++] = *str++;
+    }
+    path[pos] = 0;
+    return pos;
+}
+
+static int _chipstate_append_index(char* path, int pos, uint32_t index) {
+    char buf[16];
+    int i = (int)sizeof(buf) - 1;
+    buf[i] = 0;
+    do {
+        buf[--i] = (char)('0' + (index % 10));
+        index /= 10;
+    } while (index > 0);
+    pos = _chipstate_append(path, pos, "[");
+    pos = _chipstate_append(path, pos, &buf[i]);
+    return _chipstate_append(path, pos, "]");
+}
+
+static void _chipstate_walk(const chips_state_field_t* fields, int num_fields, const uint8_t* base, char* path, int path_pos, _chipstate_walk_t fn, void* ctx) {
+    for (int fi = 0; fi < num_fields; fi++) {
+        const chips_state_field_t* field = &fields[fi];
+        int pos = _chipstate_append(path, path_pos, field->name);
+        const uint8_t* ptr = base + field->offset;
+        if (field->kind == CHIPS_STATE_STRUCT) {
+            CHIPS_ASSERT(field->fields && (field->num_fields > 0));
+            for (uint32_t i = 0; i < field->count; i++) {
+                int sub_pos = pos;
+                if (field->count > 1) {
+                    sub_pos = _chipstate_append_index(path, sub_pos, i);
+                }
+                sub_pos = _chipstate_append(path, sub_pos, ".");
+                _chipstate_walk(field->fields, field->num_fields, ptr + i * field->size, path, sub_pos, fn, ctx);
+            }
+        }
+        else {
+            chipstate_item_t item;
+            item.path = path;
+            item.field = field;
+            item.ptr = ptr;
+            fn(&item, ctx);
+        }
+    }
+}
+
+static void _chipstate_walk_state(const chips_state_desc_t* desc, const void* state, _chipstate_walk_t fn, void* ctx) {
+    CHIPS_ASSERT(desc && desc->fields && state && fn);
+    char path[CHIPSTATE_MAX_PATH];
+    path[0] = 0;
+    _chipstate_walk(desc->fields, desc->num_fields, (const uint8_t*)state, path, 0, fn, ctx);
+}
+
+uint64_t chipstate_bits(const chips_state_field_t* field, const void* ptr, uint32_t index) {
+    CHIPS_ASSERT(field && ptr && (index < field->count));
+    const uint8_t* src = (const uint8_t*)ptr + index * field->size;
+    switch (field->size) {
+        case 1: { uint8_t v; memcpy(&v, src, 1); return v; }
+        case 2: { uint16_t v; memcpy(&v, src, 2); return v; }
+        case 4: { uint32_t v; memcpy(&v, src, 4); return v; }
+        case 8: { uint64_t v; memcpy(&v, src, 8); return v; }
+        default: CHIPS_ASSERT(false); return 0;
+    }
+}
+
+double chipstate_value(const chips_state_field_t* field, const void* ptr, uint32_t index) {
+    const uint64_t bits = chipstate_bits(field, ptr, index);
+    switch (field->kind) {
+        case CHIPS_STATE_BOOL:
+            return bits ? 1.0 : 0.0;
+        case CHIPS_STATE_INT:
+            switch (field->size) {
+                case 1: return (double)(int8_t)bits;
+                case 2: return (double)(int16_t)bits;
+                case 4: return (double)(int32_t)bits;
+                default: return (double)(int64_t)bits;
+            }
+        case CHIPS_STATE_FLOAT:
+            if (field->size == 4) {
+                const uint32_t bits32 = (uint32_t)bits;
+                float f;
+                memcpy(&f, &bits32, 4);
+                return (double)f;
+            }
+            else {
+                double d;
+                memcpy(&d, &bits, 8);
+                return d;
+            }
+        default:
+            return (double)bits;
+    }
+}
+
+typedef struct {
+    chipstate_visit_t cb;
+    void* user_data;
+} _chipstate_visit_ctx_t;
+
+static void _chipstate_visit_fn(const chipstate_item_t* item, void* ctx_ptr) {
+    _chipstate_visit_ctx_t* ctx = (_chipstate_visit_ctx_t*) ctx_ptr;
+    ctx->cb(item, ctx->user_data);
+}
+
+void chipstate_visit(const chips_state_desc_t* desc, const void* state, chipstate_visit_t cb, void* user_data) {
+    _chipstate_visit_ctx_t ctx;
+    ctx.cb = cb;
+    ctx.user_data = user_data;
+    _chipstate_walk_state(desc, state, _chipstate_visit_fn, &ctx);
+}
+
+typedef struct {
+    const uint8_t* a;
+    const uint8_t* b;
+    chipstate_diff_t cb;
+    void* user_data;
+    int num_diffs;
+} _chipstate_diff_ctx_t;
+
+static void _chipstate_diff_fn(const chipstate_item_t* item, void* ctx_ptr) {
+    _chipstate_diff_ctx_t* ctx = (_chipstate_diff_ctx_t*) ctx_ptr;
+    /* items are walked in state a, find the same field in state b */
+    const void* b_ptr = ctx->b + ((const uint8_t*)item->ptr - ctx->a);
+    for (uint32_t i = 0; i < item->field->count; i++) {
+        const uint64_t a_bits = chipstate_bits(item->field, item->ptr, i);
+        const uint64_t b_bits = chipstate_bits(item->field, b_ptr, i);
+        bool differs = (a_bits != b_bits);
+        if (differs && (item->field->kind == CHIPS_STATE_BOOL)) {
+            differs = ((a_bits != 0) != (b_bits != 0));
+        }
+        if (differs) {
+            ctx->num_diffs++;
+            if (ctx->cb) {
+                ctx->cb(item, i, a_bits, b_bits, ctx->user_data);
+            }
+        }
+    }
+}
+
+int chipstate_diff(const chips_state_desc_t* desc, const void* a, const void* b, chipstate_diff_t cb, void* user_data) {
+    CHIPS_ASSERT(a && b);
+    _chipstate_diff_ctx_t ctx;
+    ctx.a = (const uint8_t*) a;
+    ctx.b = (const uint8_t*) b;
+    ctx.cb = cb;
+    ctx.user_data = user_data;
+    ctx.num_diffs = 0;
+    _chipstate_walk_state(desc, a, _chipstate_diff_fn, &ctx);
+    return ctx.num_diffs;
+}
+
+static int _chipstate_fields_size(const chips_state_field_t* fields, int num_fields) {
+    int size = 0;
+    for (int i = 0; i < num_fields; i++) {
+        const chips_state_field_t* field = &fields[i];
+        if (field->kind == CHIPS_STATE_STRUCT) {
+            size += (int)field->count * _chipstate_fields_size(field->fields, field->num_fields);
+        }
+        else {
+            size += (int)(field->count * field->size);
+        }
+    }
+    return size;
+}
+
+int chipstate_size(const chips_state_desc_t* desc) {
+    CHIPS_ASSERT(desc && desc->fields);
+    return _chipstate_fields_size(desc->fields, desc->num_fields);
+}
+
+typedef struct {
+    const uint8_t* state;
+    uint8_t* state_rw;      /* only for load */
+    uint8_t* dst;
+    const uint8_t* src;
+    int pos;
+} _chipstate_io_ctx_t;
+
+static void _chipstate_save_fn(const chipstate_item_t* item, void* ctx_ptr) {
+    _chipstate_io_ctx_t* ctx = (_chipstate_io_ctx_t*) ctx_ptr;
+    for (uint32_t i = 0; i < item->field->count; i++) {
+        uint64_t bits = chipstate_bits(item->field, item->ptr, i);
+        for (uint32_t b = 0; b < item->field->size; b++) {
+            ctx->dst[ctx->pos++] = (uint8_t)bits;
+            bits >>= 8;
+        }
+    }
+}
+
+static void _chipstate_load_fn(const chipstate_item_t* item, void* ctx_ptr) {
+    _chipstate_io_ctx_t* ctx = (_chipstate_io_ctx_t*) ctx_ptr;
+    /* the walk happens on the const state, map back to the writable state */
+    uint8_t* dst = ctx->state_rw + ((const uint8_t*)item->ptr - ctx->state);
+    for (uint32_t i = 0; i < item->field->count; i++) {
+        uint64_t bits = 0;
+        for (uint32_t b = 0; b < item->field->size; b++) {
+            bits |= ((uint64_t)ctx->src[ctx->pos++]) << (b * 8);
+        }
+        uint8_t* elm = dst + i * item->field->size;
+        switch (item->field->size) {
+            case 1: { uint8_t v = (uint8_t)bits; memcpy(elm, &v, 1); } break;
+            case 2: { uint16_t v = (uint16_t)bits; memcpy(elm, &v, 2); } break;
+            case 4: { uint32_t v = (uint32_t)bits; memcpy(elm, &v, 4); } break;
+            case 8: memcpy(elm, &bits, 8); break;
+            default: CHIPS_ASSERT(false); break;
+        }
+    }
+}
+
+int chipstate_save(const chips_state_desc_t* desc, const void* state, void* dst, int dst_size) {
+    CHIPS_ASSERT(dst);
+    const int size = chipstate_size(desc);
+    if (dst_size < size) {
+        return 0;
+    }
+    _chipstate_io_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.state = (const uint8_t*) state;
+    ctx.dst = (uint8_t*) dst;
+    _chipstate_walk_state(desc, state, _chipstate_save_fn, &ctx);
+    CHIPS_ASSERT(ctx.pos == size);
+    return ctx.pos;
+}
+
+int chipstate_load(const chips_state_desc_t* desc, void* state, const void* src, int src_size) {
+    CHIPS_ASSERT(src);
+    const int size = chipstate_size(desc);
+    if (src_size < size) {
+        return 0;
+    }
+    _chipstate_io_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.state = (const uint8_t*) state;
+    ctx.state_rw = (uint8_t*) state;
+    ctx.src = (const uint8_t*) src;
+    _chipstate_walk_state(desc, state, _chipstate_load_fn, &ctx);
+    CHIPS_ASSERT(ctx.pos == size);
+    return ctx.pos;
+}
+#endif /* CHIPS_IMPL */
@@ -0,0 +1,277 @@
+#pragma once
+/*#
+    # cmdqueue.h
+
+    A lock-free single-producer/single-consumer command queue for running
+    an emulated system on its own thread.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    ## Overview
+
+    All system APIs (c64_key_down(), cpc_insert_disc(), zx_joystick(),
+    kc85_insert_ram_module(), ...) must be called on the thread which
+    runs the system's exec function. If the emulation runs on its own
+    thread, the UI thread instead pushes commands into a cmdqueue_t, and
+    the emulation thread pops the commands at well-defined points (for
+    instance between exec-slices) and calls the system API functions.
+
+    There is exactly one producer thread (usually the UI thread) and
+    exactly one consumer thread (the emulation thread) per queue, and
+    no locks are involved. If more than one thread needs to post commands,
+    use one queue per producer thread.
+
+    Each command has a timestamp in the emulation thread's time base
+    (for instance emulated microseconds since start). A command is only
+    popped once the emulation thread's time has reached the timestamp,
+    commands with a timestamp of zero are popped at the next opportunity.
+    Commands are always popped in the order they were pushed, so the
+    producer must push commands with non-decreasing timestamps.
+
+    Since the commands are applied at deterministic points in emulated
+    time, recording the popped commands together with the time they were
+    applied is enough to replay a session.
+
+    ## Usage
+
+    The UI thread pushes commands:
+
+    ~~~C
+    static cmdqueue_t queue;
+    cmdqueue_init(&queue);
+
+    // UI thread: key pressed
+    cmdqueue_push(&queue, &(cmdqueue_cmd_t){ .type = CMDQUEUE_KEY_DOWN, .arg = key_code });
+    ~~~
+
+    The emulation thread runs the system in slices and applies all due
+    commands between the slices:
+
+    ~~~C
+    static void emu_frame(c64_t* sys, cmdqueue_t* queue, uint64_t* time_us, uint32_t frame_us) {
+        const uint32_t slice_us = 1000;
+        for (uint32_t t = 0; t < frame_us; t += slice_us) {
+            cmdqueue_cmd_t cmd;
+            while (cmdqueue_pop(queue, *time_us, &cmd)) {
+                switch (cmd.type) {
+                    case CMDQUEUE_KEY_DOWN: c64_key_down(sys, (int)cmd.arg); break;
+                    case CMDQUEUE_KEY_UP:   c64_key_up(sys, (int)cmd.arg); break;
+                    case CMDQUEUE_JOYSTICK: c64_joystick(sys, (uint8_t)cmd.arg, 0); break;
+                    case CMDQUEUE_QUICKLOAD:
+                        c64_quickload(sys, cmd.ptr, cmd.size);
+                        free((void*)cmd.ptr);
+                        break;
+                    default: break;
+                }
+            }
+            c64_exec(sys, slice_us);
+            *time_us += slice_us;
+        }
+    }
+    ~~~
+
+    Smaller slices mean a lower input latency, larger slices a lower
+    overhead. For a finer granularity, pop commands from inside a
+    per-scanline or per-instruction callback instead.
+
+    ## Functions
+
+    ~~~C
+    void cmdqueue_init(cmdqueue_t* queue)
+    ~~~
+        Initialize a command queue, must be called before the producer
+        and consumer threads are started.
+
+    ~~~C
+    bool cmdqueue_push(cmdqueue_t* queue, const cmdqueue_cmd_t* cmd)
+    ~~~
+        Push a command, may only be called from the producer thread.
+        Returns false if the queue is full (the queue has room for
+        CMDQUEUE_NUM_CMDS commands).
+
+    ~~~C
+    bool cmdqueue_pop(cmdqueue_t* queue, uint64_t time_us, cmdqueue_cmd_t* out_cmd)
+    ~~~
+        Pop the next command if its timestamp is <= time_us, may only be
+        called from the consumer thread. Returns false if the queue is
+        empty or the next command isn't due yet.
+
+    ## Commands
+
+    A command is a small struct which is copied into the queue:
+
+        uint32_t type       - the command type (see below)
+        uint32_t arg        - an argument (key code, joystick mask, RAM module type, ...)
+        uint64_t time_us    - the timestamp when the command should be applied
+        const void* ptr     - optional data (media images)
+        int size            - size of the optional data in bytes
+
+    The predefined command types are:
+
+        CMDQUEUE_KEY_DOWN       - arg: key code
+        CMDQUEUE_KEY_UP         - arg: key code
+        CMDQUEUE_JOYSTICK       - arg: joystick mask
+        CMDQUEUE_RESET          - reset the system
+        CMDQUEUE_QUICKLOAD      - ptr/size: quickload file data
+        CMDQUEUE_INSERT_TAPE    - ptr/size: tape image
+        CMDQUEUE_REMOVE_TAPE    - eject the tape
+        CMDQUEUE_INSERT_DISC    - arg: drive, ptr/size: disc image
+        CMDQUEUE_REMOVE_DISC    - arg: drive
+        CMDQUEUE_INSERT_MODULE  - arg: system-specific module slot and type
+        CMDQUEUE_REMOVE_MODULE  - arg: system-specific module slot
+        CMDQUEUE_USER           - first user-defined command type
+
+    The queue doesn't copy the data behind ptr, the data must remain
+    valid until the emulation thread has applied the command. The easiest
+    way is to heap-allocate a copy on the UI thread, and free it on the
+    emulation thread after the command has been applied.
+
+    ## Memory Ordering
+
+    With GCC and Clang, the queue uses the __atomic builtins with
+    acquire/release semantics. With MSVC, the interlocked intrinsics
+    are used.
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* number of commands in a queue (must be a power of 2) */
+#define CMDQUEUE_NUM_CMDS (256)
+
+/* predefined command types */
+typedef enum {
+    CMDQUEUE_NONE = 0,
+    CMDQUEUE_KEY_DOWN,
+    CMDQUEUE_KEY_UP,
+    CMDQUEUE_JOYSTICK,
+    CMDQUEUE_RESET,
+    CMDQUEUE_QUICKLOAD,
+    CMDQUEUE_INSERT_TAPE,
+    CMDQUEUE_REMOVE_TAPE,
+    CMDQUEUE_INSERT_DISC,
+    CMDQUEUE_REMOVE_DISC,
+    CMDQUEUE_INSERT_MODULE,
+    CMDQUEUE_REMOVE_MODULE,
+    CMDQUEUE_USER = 0x100,      /* first user-defined command type */
+} cmdqueue_type_t;
+
+/* a command */
+typedef struct {
+    uint32_t type;          /* cmdqueue_type_t or user-defined */
+    uint32_t arg;           /* key code, joystick mask, ... */
+    uint64_t time_us;       /* when the command should be applied */
+    const void* ptr;        /* optional data, owned by the caller */
+    int size;               /* size of optional data */
+} cmdqueue_cmd_t;
+
+/* a single-producer/single-consumer queue */
+typedef struct {
+    uint32_t head;              /* only written by the producer */
+    uint8_t pad0[60];
+    uint32_t tail;              /* only written by the consumer */
+    uint8_t pad1[60];
+    cmdqueue_cmd_t cmds[CMDQUEUE_NUM_CMDS];
+} cmdqueue_t;
+
+/* initialize a command queue */
+void cmdqueue_init(cmdqueue_t* queue);
+/* push a command (producer thread only), returns false if queue is full */
+bool cmdqueue_push(cmdqueue_t* queue, const cmdqueue_cmd_t* cmd);
+/* pop the next due command (consumer thread only), returns false if none */
+bool cmdqueue_pop(cmdqueue_t* queue, uint64_t time_us, cmdqueue_cmd_t* out_cmd);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    #define _CMDQUEUE_LOAD_ACQUIRE(ptr) ((uint32_t)_InterlockedOr((volatile long*)(ptr), 0))
+    #define _CMDQUEUE_STORE_RELEASE(ptr, val) _InterlockedExchange((volatile long*)(ptr), (long)(val))
+#else
+    #define _CMDQUEUE_LOAD_ACQUIRE(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+    #define _CMDQUEUE_STORE_RELEASE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#endif
+
+#define _CMDQUEUE_MASK (CMDQUEUE_NUM_CMDS - 1)
+
+void cmdqueue_init(cmdqueue_t* queue) {
+    CHIPS_ASSERT(queue);
+    CHIPS_ASSERT((CMDQUEUE_NUM_CMDS & _CMDQUEUE_MASK) == 0);
+    memset(queue, 0, sizeof(cmdqueue_t));
+}
+
+bool cmdqueue_push(cmdqueue_t* queue, const cmdqueue_cmd_t* cmd) {
+    CHIPS_ASSERT(queue && cmd);
+    /* head is only written by this thread, tail is written by the consumer */
+    const uint32_t head = queue->head;
+    const uint32_t tail = _CMDQUEUE_LOAD_ACQUIRE(&queue->tail);
+    if ((head - tail) >= CMDQUEUE_NUM_CMDS) {
+        return false;
+    }
+    queue->cmds[head & _CMDQUEUE_MASK] = *cmd;
+    /* publish the command to the consumer */
+    _CMDQUEUE_STORE_RELEASE(&queue->head, head + 1);
+    return true;
+}
+
+bool cmdqueue_pop(cmdqueue_t* queue, uint64_t time_us, cmdqueue_cmd_t* out_cmd) {
+    CHIPS_ASSERT(queue && out_cmd);
+    /* tail is only written by this thread, head is written by the producer */
+    const uint32_t tail = queue->tail;
+    const uint32_t head = _CMDQUEUE_LOAD_ACQUIRE(&queue->head);
+    if (head == tail) {
+        return false;
+    }
+    const cmdqueue_cmd_t* cmd = &queue->cmds[tail & _CMDQUEUE_MASK];
+    if (cmd->time_us > time_us) {
+        return false;
+    }
+    *out_cmd = *cmd;
+    /* hand the slot back to the producer */
+    _CMDQUEUE_STORE_RELEASE(&queue->tail, tail + 1);
+    return true;
+}
+#endif /* CHIPS_IMPL */
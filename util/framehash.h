@@ -0,0 +1,286 @@
+#pragma once
+/*#
+    # framehash.h
+
+    Fast and stable hashes of emulator video frames and audio output
+    for automated regression tests against 'golden' hash values.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    ## Overview
+
+    Instead of storing and comparing complete frames, a test runner only
+    needs to store one 64-bit hash per frame and one per audio block, and
+    can compare thousands of runs against their golden values.
+
+    Frame hashes are computed over the visible display area as returned
+    by the system's display_width() and display_height() functions (for
+    the C64 this is the area defined by the VIC-II's vis_* CRT params).
+
+    The systems render RGBA8 pixels, but when a palette is provided, the
+    frame hash is computed over palette indices instead of RGBA8 values,
+    so that palette tweaks don't break the golden hashes. The
+    palette must be the one the system currently renders with. Pixels
+    which are not found in the palette are hashed by their RGB value. The
+    alpha channel is always ignored (some video chips use it to
+    resolve sprite priorities).
+
+    Audio is hashed as 16-bit integer samples, so that tiny floating point
+    differences below the 16-bit resolution don't change the hash.
+
+    The hash function is a simple 64-bit multiply-rotate hash over 32-bit
+    words, it is not cryptographically secure, but fast and good enough to
+    detect changed frames.
+
+    ## Usage
+
+    Hash the display area after each emulated frame:
+
+    ~~~C
+    // a palette from the video chip's color table (here the C64)
+    uint32_t palette[16];
+    for (int i = 0; i < 16; i++) {
+        palette[i] = m6569_color(i);
+    }
+
+    c64_exec(&c64, 20000);
+    uint64_t frame_hash = framehash_frame(&(framehash_frame_t){
+        .pixels = (const uint32_t*) pixel_buffer,
+        .width = c64_display_width(&c64),
+        .height = c64_display_height(&c64),
+        .palette = palette,
+        .num_colors = 16
+    });
+    ~~~
+
+    For systems with a dynamic palette, pass the current palette (for
+    instance on the CPC: cpc.ga.colors.hw_rgba8 with 32 colors).
+
+    Audio blocks are hashed incrementally, usually from inside the
+    system's audio callback:
+
+    ~~~C
+    static framehash_t audio_hash;
+
+    static void audio_cb(const float* samples, int num_samples, void* user_data) {
+        framehash_audio(&audio_hash, samples, num_samples);
+    }
+
+    // ...at the end of a test run, or per block:
+    uint64_t audio_hash_value = framehash_result(&audio_hash);
+    ~~~
+
+    ## Functions
+
+    ~~~C
+    uint64_t framehash_frame(const framehash_frame_t* frame)
+    ~~~
+        Compute the hash of a frame's visible display area.
+
+    ~~~C
+    void framehash_init(framehash_t* hash)
+    ~~~
+        Initialize (or reset) an incremental hash.
+
+    ~~~C
+    void framehash_update(framehash_t* hash, const uint32_t* data, int num_words)
+    ~~~
+        Add 32-bit words to an incremental hash.
+
+    ~~~C
+    void framehash_audio(framehash_t* hash, const float* samples, int num_samples)
+    ~~~
+        Add audio samples to an incremental hash (quantized to 16 bits).
+
+    ~~~C
+    uint64_t framehash_result(const framehash_t* hash)
+    ~~~
+        Get the final hash value of an incremental hash (the incremental
+        hash can be continued afterwards).
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* a frame to hash */
+typedef struct {
+    const uint32_t* pixels;     /* RGBA8 pixels */
+    int width;                  /* width of visible display area in pixels */
+    int height;                 /* height of visible display area in pixels */
+    int stride;                 /* optional row stride in pixels (default: width) */
+    const uint32_t* palette;    /* optional RGBA8 palette to hash palette indices */
+    int num_colors;             /* number of palette entries */
+} framehash_frame_t;
+
+/* incremental hash state */
+typedef struct {
+    uint64_t h;
+    uint64_t len;
+} framehash_t;
+
+/* compute the hash of a frame */
+uint64_t framehash_frame(const framehash_frame_t* frame);
+/* initialize an incremental hash */
+void framehash_init(framehash_t* hash);
+/* add 32-bit words to an incremental hash */
+void framehash_update(framehash_t* hash, const uint32_t* data, int num_words);
+/* add audio samples to an incremental hash */
+void framehash_audio(framehash_t* hash, const float* samples, int num_samples);
+/* get the hash value of an incremental hash */
+uint64_t framehash_result(const framehash_t* hash);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+#define _FRAMEHASH_SEED (0x9E3779B97F4A7C15ULL)
+#define _FRAMEHASH_PRIME0 (0xC2B2AE3D27D4EB4FULL)
+#define _FRAMEHASH_PRIME1 (0x165667B19E3779F9ULL)
+/* marks pixel values which were not found in the palette */
+#define _FRAMEHASH_NOT_IN_PALETTE (0x80000000)
+
+static inline uint64_t _framehash_mix(uint64_t h, uint32_t val) {
+    h ^= (uint64_t)val * _FRAMEHASH_PRIME0;
+    h = (h << 31) | (h >> 33);
+    return h * _FRAMEHASH_PRIME1;
+}
+
+void framehash_init(framehash_t* hash) {
+    CHIPS_ASSERT(hash);
+    hash->h = _FRAMEHASH_SEED;
+    hash->len = 0;
+}
+
+void framehash_update(framehash_t* hash, const uint32_t* data, int num_words) {
+    CHIPS_ASSERT(hash && data && (num_words >= 0));
+    uint64_t h = hash->h;
+    for (int i = 0; i < num_words; i++) {
+        h = _framehash_mix(h, data[i]);
+    }
+    hash->h = h;
+    hash->len += (uint64_t)num_words;
+}
+
+void framehash_audio(framehash_t* hash, const float* samples, int num_samples) {
+    CHIPS_ASSERT(hash && samples && (num_samples >= 0));
+    uint64_t h = hash->h;
+    for (int i = 0; i < num_samples; i++) {
+        float s = samples[i];
+        if (s > 1.0f) {
+            s = 1.0f;
+        }
+        else if (s < -1.0f) {
+            s = -1.0f;
+        }
+        /* round to nearest, the cast alone would truncate towards zero */
+        const int32_t q = (int32_t)(s * 32767.0f + ((s < 0.0f) ? -0.5f : 0.5f));
+        h = _framehash_mix(h, (uint32_t)q);
+    }
+    hash->h = h;
+    hash->len += (uint64_t)num_samples;
+}
+
+/* final avalanche, so that similar inputs produce very different hashes */
+uint64_t framehash_result(const framehash_t* hash) {
+    CHIPS_ASSERT(hash);
+    uint64_t h = hash->h ^ hash->len;
+    h ^= h >> 33;
+    h *= _FRAMEHASH_PRIME0;
+    h ^= h >> 29;
+    h *= _FRAMEHASH_PRIME1;
+    h ^= h >> 32;
+    return h;
+}
+
+/* map an RGB value to its palette index, remembers the last hit */
+static inline uint32_t _framehash_index(const framehash_frame_t* frame, uint32_t rgb, uint32_t* last_rgb, uint32_t* last_index) {
+    if (rgb == *last_rgb) {
+        return *last_index;
+    }
+    uint32_t index = rgb | _FRAMEHASH_NOT_IN_PALETTE;
+    for (int i = 0; i < frame->num_colors; i++) {
+        if ((frame->palette[i] & 0x00FFFFFF) == rgb) {
+            index = (uint32_t)i;
+            break;
+        }
+    }
+    *last_rgb = rgb;
+    *last_index = index;
+    return index;
+}
+
+uint64_t framehash_frame(const framehash_frame_t* frame) {
+    CHIPS_ASSERT(frame && frame->pixels);
+    CHIPS_ASSERT((frame->width > 0) && (frame->height > 0));
+    CHIPS_ASSERT((0 == frame->palette) || (frame->num_colors > 0));
+    const int stride = (frame->stride > 0) ? frame->stride : frame->width;
+    CHIPS_ASSERT(stride >= frame->width);
+    framehash_t hash;
+    framehash_init(&hash);
+    uint64_t h = hash.h;
+    h = _framehash_mix(h, (uint32_t)frame->width);
+    h = _framehash_mix(h, (uint32_t)frame->height);
+    if (frame->palette) {
+        /* impossible RGB value, so the first pixel is always looked up */
+        uint32_t last_rgb = 0xFFFFFFFF;
+        uint32_t last_index = 0;
+        for (int y = 0; y < frame->height; y++) {
+            const uint32_t* src = frame->pixels + y * stride;
+            for (int x = 0; x < frame->width; x++) {
+                h = _framehash_mix(h, _framehash_index(frame, src[x] & 0x00FFFFFF, &last_rgb, &last_index));
+            }
+        }
+    }
+    else {
+        for (int y = 0; y < frame->height; y++) {
+            const uint32_t* src = frame->pixels + y * stride;
+            for (int x = 0; x < frame->width; x++) {
+                h = _framehash_mix(h, src[x] & 0x00FFFFFF);
+            }
+        }
+    }
+    hash.h = h;
+    hash.len = (uint64_t)frame->width * (uint64_t)frame->height;
+    return framehash_result(&hash);
+}
+#endif /* CHIPS_IMPL */
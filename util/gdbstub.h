@@ -0,0 +1,1191 @@
+#pragma once
+/*#
+    # gdbstub.h
+
+    A headless debug server which speaks the GDB Remote Serial Protocol
+    over a local TCP socket, for emulated systems with a Z80 or 6502 CPU.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Select the supported CPU with the following macros (define one
+    or the other, but not both):
+
+    GDBSTUB_USE_Z80
+    GDBSTUB_USE_M6502
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    You need to include the following headers before including gdbstub.h:
+
+        - z80.h         (only if GDBSTUB_USE_Z80 is defined)
+        - m6502.h       (only if GDBSTUB_USE_M6502 is defined)
+
+    On Windows, the implementation needs to be linked with ws2_32.lib.
+
+    ## Usage
+
+    Setup a gdbstub_t instance with a pointer to the system's CPU and
+    callbacks to read and write the CPU-visible memory:
+
+    ~~~C
+    gdbstub_init(&stub, &(gdbstub_desc_t){
+        .z80 = &sys.cpu,
+        .port = 1234,
+        .read_cb = read_mem,
+        .write_cb = write_mem,
+        .user_data = &sys
+    });
+    ~~~
+
+    The stub listens on the loopback interface and accepts a single
+    client connection. All socket IO is non-blocking and happens
+    in gdbstub_before_exec(), so no threads are involved.
+
+    For a Z80 system, wrap the per-frame exec function like this:
+
+    ~~~C
+    if (gdbstub_before_exec(&stub)) {
+        zx_exec(&zx, frame_time_us);
+    }
+    gdbstub_after_exec(&stub);
+    ~~~
+
+    gdbstub_before_exec() installs a CPU trap callback with
+    z80_trap_cb() (chaining to an already installed trap callback) and
+    gdbstub_after_exec() removes it again. The trap callback is only
+    installed while a debugger is attached, so detached instances run
+    at full speed.
+
+    For a 6502 system, call gdbstub_before_exec() once per frame, and
+    run the system tick by tick, calling gdbstub_tick() after each tick
+    (breakpoints and single-stepping are evaluated on the SYNC pin):
+
+    ~~~C
+    if (gdbstub_before_exec(&stub)) {
+        for (uint32_t i = 0; i < num_ticks; i++) {
+            c64_tick(&c64);
+            if (gdbstub_tick(&stub, c64.pins)) {
+                break;
+            }
+        }
+    }
+    ~~~
+
+    On the GDB side, connect with:
+
+        (gdb) target remote localhost:1234
+
+    When a client connects, the CPU is stopped (on the 6502 at the
+    start of the next instruction). Supported are the
+    RSP packets for reading and writing registers and memory,
+    continue, single-step, execution breakpoints (Z0 and Z1),
+    write watchpoints (Z2) and, on the 6502 only, read and access
+    watchpoints (Z3 and Z4), interrupting with Ctrl-C, detach and kill.
+    On the Z80, write watchpoints trigger when the watched memory
+    changes, checked after each instruction. On the 6502 all watchpoints
+    check every bus cycle and trigger at the end of the instruction.
+
+    The register layout for the 'g' and 'p' packets is:
+
+    - Z80: AF, BC, DE, HL, SP, PC, IX, IY, AF', BC', DE', HL', IR as
+      16-bit little-endian values (this is the layout of the GDB Z80 target)
+    - 6502: A, X, Y, P, S as 8-bit values, followed by PC as 16-bit
+      little-endian value
+
+    On the 6502, the PC can't be written because the opcode at the
+    current PC has already been fetched when the CPU stops. Register
+    writes which would change the PC, and continue or step packets
+    with a resume address other than the current PC are answered
+    with an E01 error reply.
+
+    Packets with a malformed checksum are rejected with a NAK ('-') like
+    packets with a wrong checksum. Sending a reply blocks until the
+    socket accepts data, if the client doesn't read for 5 seconds the
+    connection is closed. A client closing the connection never raises
+    SIGPIPE.
+
+    ## Functions
+
+    ~~~C
+    void gdbstub_init(gdbstub_t* stub, const gdbstub_desc_t* desc)
+    ~~~
+        Initialize a gdbstub_t instance and start listening on the
+        TCP port in desc->port (default: GDBSTUB_DEFAULT_PORT).
+        If the socket can't be opened, stub->listening will be false,
+        and all other functions will do nothing.
+
+    ~~~C
+    void gdbstub_discard(gdbstub_t* stub)
+    ~~~
+        Close all sockets.
+
+    ~~~C
+    bool gdbstub_before_exec(gdbstub_t* stub)
+    ~~~
+        Call once per frame before running the emulation, this handles
+        all socket IO. Returns false if the CPU is stopped, in that case
+        the emulation must not run.
+
+    ~~~C
+    void gdbstub_after_exec(gdbstub_t* stub)
+    ~~~
+        Only Z80: call after running the emulation, this removes the trap
+        callback and checks if a breakpoint has been hit.
+
+    ~~~C
+    bool gdbstub_tick(gdbstub_t* stub, uint64_t pins)
+    ~~~
+        Only 6502: call after each system tick with the CPU pins, returns
+        true if the CPU has been stopped.
+
+    ~~~C
+    bool gdbstub_connected(const gdbstub_t* stub)
+    ~~~
+        Returns true if a debugger is attached.
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(GDBSTUB_USE_Z80) && defined(GDBSTUB_USE_M6502)
+#error "please define only one of GDBSTUB_USE_Z80 or GDBSTUB_USE_M6502"
+#endif
+
+#define GDBSTUB_DEFAULT_PORT (1234)
+#define GDBSTUB_MAX_BREAKPOINTS (32)
+#define GDBSTUB_MAX_WATCHPOINTS (8)
+#define GDBSTUB_MAX_WATCH_LEN (8)       /* max number of bytes covered by one watchpoint */
+#define GDBSTUB_MAX_PACKET (1024)       /* max size of a packet payload */
+#define GDBSTUB_TRAPID (1024)           /* Z80 trap id used by the debug stub */
+
+/* watchpoint types (same values as the GDB Z packet types) */
+#define GDBSTUB_WATCH_WRITE (2)
+#define GDBSTUB_WATCH_READ (3)
+#define GDBSTUB_WATCH_ACCESS (4)
+
+/* callback to read a byte from CPU-visible memory */
+typedef uint8_t (*gdbstub_read_t)(uint16_t addr, void* user_data);
+/* callback to write a byte to CPU-visible memory */
+typedef void (*gdbstub_write_t)(uint16_t addr, uint8_t data, void* user_data);
+
+/* setup parameters for gdbstub_init() */
+typedef struct {
+    #if defined(GDBSTUB_USE_Z80)
+    z80_t* z80;                 /* Z80 CPU to debug */
+    #elif defined(GDBSTUB_USE_M6502)
+    m6502_t* m6502;             /* 6502 CPU to debug */
+    #endif
+    uint16_t port;              /* TCP port on the loopback interface (default: 1234) */
+    gdbstub_read_t read_cb;     /* callback to read memory */
+    gdbstub_write_t write_cb;   /* callback to write memory */
+    void* user_data;            /* user data for callbacks */
+} gdbstub_desc_t;
+
+/* a watchpoint */
+typedef struct {
+    int type;
+    uint16_t addr;
+    uint16_t len;
+    uint8_t val[GDBSTUB_MAX_WATCH_LEN];     /* Z80 only: last seen memory content */
+} gdbstub_watchpoint_t;
+
+/* debug stub state */
+typedef struct {
+    bool valid;
+    bool listening;
+    #if defined(GDBSTUB_USE_Z80)
+    z80_t* z80;
+    z80_trap_t z80_trap_cb;     /* original trap callback */
+    void* z80_trap_ud;
+    #elif defined(GDBSTUB_USE_M6502)
+    m6502_t* m6502;
+    #endif
+    gdbstub_read_t read_cb;
+    gdbstub_write_t write_cb;
+    void* user_data;
+    intptr_t listen_sock;       /* -1 if not open */
+    intptr_t conn_sock;         /* -1 if no client attached */
+    bool stopped;               /* CPU is stopped */
+    bool stepping;              /* single-step requested */
+    bool no_ack;                /* client requested no-ack mode */
+    bool reply_pending;         /* client waits for a stop reply */
+    bool watch_hit;             /* a watchpoint has been hit */
+    uint16_t watch_addr;
+    int watch_type;
+    int num_breakpoints;
+    uint16_t breakpoints[GDBSTUB_MAX_BREAKPOINTS];
+    int num_watchpoints;
+    gdbstub_watchpoint_t watchpoints[GDBSTUB_MAX_WATCHPOINTS];
+    /* packet receive state */
+    int rx_state;
+    int rx_len;
+    uint8_t rx_csum;
+    uint8_t rx_csum_in;
+    bool rx_csum_err;           /* received checksum contains a non-hex character */
+    char rx_buf[GDBSTUB_MAX_PACKET];
+} gdbstub_t;
+
+/* initialize a new debug stub and start listening */
+void gdbstub_init(gdbstub_t* stub, const gdbstub_desc_t* desc);
+/* close all sockets */
+void gdbstub_discard(gdbstub_t* stub);
+/* call before running the emulation, returns false if the CPU is stopped */
+bool gdbstub_before_exec(gdbstub_t* stub);
+/* only Z80: call after running the emulation */
+void gdbstub_after_exec(gdbstub_t* stub);
+/* only 6502: call after each tick, returns true if the CPU has been stopped */
+bool gdbstub_tick(gdbstub_t* stub, uint64_t pins);
+/* return true if a debugger is attached */
+bool gdbstub_connected(const gdbstub_t* stub);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <winsock2.h>
+    #if defined(_MSC_VER)
+    #pragma comment(lib, "ws2_32")
+    #endif
+#else
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <errno.h>
+    #include <poll.h>
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <arpa/inet.h>
+#endif
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+#if !defined(GDBSTUB_USE_Z80) && !defined(GDBSTUB_USE_M6502)
+#error "please define GDBSTUB_USE_Z80 or GDBSTUB_USE_M6502"
+#endif
+
+/* packet receive states */
+#define _GDBSTUB_RX_IDLE (0)
+#define _GDBSTUB_RX_DATA (1)
+#define _GDBSTUB_RX_CSUM0 (2)
+#define _GDBSTUB_RX_CSUM1 (3)
+
+/* give up sending if the client doesn't read for this long */
+#define _GDBSTUB_SEND_TIMEOUT_MS (5000)
+
+/* don't raise SIGPIPE when sending to a closed connection */
+#if defined(MSG_NOSIGNAL)
+#define _GDBSTUB_SEND_FLAGS (MSG_NOSIGNAL)
+#else
+#define _GDBSTUB_SEND_FLAGS (0)
+#endif
+
+/*=== platform-specific socket wrappers ======================================*/
+static void _gdbstub_close(intptr_t sock) {
+    #if defined(_WIN32)
+        closesocket((SOCKET)sock);
+    #else
+        close((int)sock);
+    #endif
+}
+
+static bool _gdbstub_set_nonblocking(intptr_t sock) {
+    #if defined(_WIN32)
+        u_long mode = 1;
+        return 0 == ioctlsocket((SOCKET)sock, FIONBIO, &mode);
+    #else
+        const int flags = fcntl((int)sock, F_GETFL, 0);
+        return (flags >= 0) && (0 == fcntl((int)sock, F_SETFL, flags | O_NONBLOCK));
+    #endif
+}
+
+static bool _gdbstub_would_block(void) {
+    #if defined(_WIN32)
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+    #else
+        return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+    #endif
+}
+
+static intptr_t _gdbstub_listen(uint16_t port) {
+    #if defined(_WIN32)
+        WSADATA wsa_data;
+        if (0 != WSAStartup(MAKEWORD(2,2), &wsa_data)) {
+            return -1;
+        }
+        SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == INVALID_SOCKET) {
+            return -1;
+        }
+        intptr_t sock = (intptr_t)s;
+    #else
+        int s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s < 0) {
+            return -1;
+        }
+        intptr_t sock = (intptr_t)s;
+    #endif
+    int reuse = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((0 != bind(s, (struct sockaddr*)&addr, sizeof(addr))) ||
+        (0 != listen(s, 1)) ||
+        !_gdbstub_set_nonblocking(sock))
+    {
+        _gdbstub_close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+static intptr_t _gdbstub_accept(intptr_t listen_sock) {
+    #if defined(_WIN32)
+        SOCKET s = accept((SOCKET)listen_sock, 0, 0);
+        if (s == INVALID_SOCKET) {
+            return -1;
+        }
+        intptr_t sock = (intptr_t)s;
+    #else
+        int s = accept((int)listen_sock, 0, 0);
+        if (s < 0) {
+            return -1;
+        }
+        intptr_t sock = (intptr_t)s;
+    #endif
+    int nodelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+    #if defined(SO_NOSIGPIPE)
+    /* platforms without MSG_NOSIGNAL (macOS, BSD) */
+    int nosigpipe = 1;
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&nosigpipe, sizeof(nosigpipe));
+    #endif
+    if (!_gdbstub_set_nonblocking(sock)) {
+        _gdbstub_close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/* non-blocking receive, returns number of bytes, 0 if nothing available, -1 if connection closed */
+static int _gdbstub_recv(intptr_t sock, char* buf, int len) {
+    #if defined(_WIN32)
+        int res = recv((SOCKET)sock, buf, len, 0);
+    #else
+        int res = (int) recv((int)sock, buf, (size_t)len, 0);
+    #endif
+    if (res > 0) {
+        return res;
+    }
+    else if ((res < 0) && _gdbstub_would_block()) {
+        return 0;
+    }
+    return -1;
+}
+
+/* wait until the socket accepts more data, returns false on timeout or error */
+static bool _gdbstub_wait_writable(intptr_t sock) {
+    #if defined(_WIN32)
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET((SOCKET)sock, &fds);
+        struct timeval tv = { _GDBSTUB_SEND_TIMEOUT_MS / 1000, (_GDBSTUB_SEND_TIMEOUT_MS % 1000) * 1000 };
+        return 1 == select(0, 0, &fds, 0, &tv);
+    #else
+        struct pollfd pfd = { (int)sock, POLLOUT, 0 };
+        int res;
+        do {
+            res = poll(&pfd, 1, _GDBSTUB_SEND_TIMEOUT_MS);
+        } while ((res < 0) && (errno == EINTR));
+        return (res == 1) && (pfd.revents & POLLOUT);
+    #endif
+}
+
+/* send all bytes (waits if the socket buffer is full), returns false if connection closed */
+static bool _gdbstub_send(intptr_t sock, const char* buf, int len) {
+    while (len > 0) {
+        #if defined(_WIN32)
+            int res = send((SOCKET)sock, buf, len, 0);
+        #else
+            int res = (int) send((int)sock, buf, (size_t)len, _GDBSTUB_SEND_FLAGS);
+        #endif
+        if (res > 0) {
+            buf += res;
+            len -= res;
+        }
+        else if ((res < 0) && _gdbstub_would_block()) {
+            if (!_gdbstub_wait_writable(sock)) {
+                return false;
+            }
+        }
+        else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*=== protocol helpers =======================================================*/
+static const char* _gdbstub_hex_chars = "0123456789abcdef";
+
+static int _gdbstub_hex_val(char c) {
+    if ((c >= '0') && (c <= '9')) return c - '0';
+    if ((c >= 'a') && (c <= 'f')) return c - 'a' + 10;
+    if ((c >= 'A') && (c <= 'F')) return c - 'A' + 10;
+    return -1;
+}
+
+/* parse a hex number, advance string pointer */
+static uint32_t _gdbstub_parse_hex(const char** str) {
+    uint32_t val = 0;
+    int d;
+    while ((d = _gdbstub_hex_val(**str)) >= 0) {
+        val = (val << 4) | (uint32_t)d;
+        (*str)++;
+    }
+    return val;
+}
+
+/* parse a hex-encoded byte, returns -1 on error */
+static int _gdbstub_parse_byte(const char* str) {
+    const int h = _gdbstub_hex_val(str[0]);
+    const int l = (h >= 0) ? _gdbstub_hex_val(str[1]) : -1;
+    return (l >= 0) ? ((h << 4) | l) : -1;
+}
+
+static char* _gdbstub_put_byte(char* dst, uint8_t val) {
+    *dst++ = _gdbstub_hex_chars[val >> 4];
+    *dst++ = _gdbstub_hex_chars[val & 0xF];
+    return dst;
+}
+
+static void _gdbstub_disconnect(gdbstub_t* stub) {
+    if (stub->conn_sock >= 0) {
+        _gdbstub_close(stub->conn_sock);
+        stub->conn_sock = -1;
+    }
+    stub->stopped = false;
+    stub->stepping = false;
+    stub->no_ack = false;
+    stub->reply_pending = false;
+    stub->watch_hit = false;
+    stub->num_breakpoints = 0;
+    stub->num_watchpoints = 0;
+    stub->rx_state = _GDBSTUB_RX_IDLE;
+}
+
+/* send a packet with checksum */
+static void _gdbstub_put_packet(gdbstub_t* stub, const char* data) {
+    char buf[GDBSTUB_MAX_PACKET + 4];
+    int len = 0;
+    uint8_t csum = 0;
+    buf[len++] = '$';
+    while (*data && (len < GDBSTUB_MAX_PACKET)) {
+        csum += (uint8_t)*data;
+        buf[len++] = *data++;
+    }
+    buf[len++] = '#';
+    buf[len++] = _gdbstub_hex_chars[csum >> 4];
+    buf[len++] = _gdbstub_hex_chars[csum & 0xF];
+    if (!_gdbstub_send(stub->conn_sock, buf, len)) {
+        _gdbstub_disconnect(stub);
+    }
+}
+
+/* send the stop reply */
+static void _gdbstub_stop_reply(gdbstub_t* stub) {
+    if (stub->watch_hit) {
+        char buf[32];
+        char* p = buf;
+        const char* kind = (stub->watch_type == GDBSTUB_WATCH_WRITE) ? "watch" :
+                           (stub->watch_type == GDBSTUB_WATCH_READ) ? "rwatch" : "awatch";
+        *p++ = 'T'; *p++ = '0'; *p++ = '5';
+        while (*kind) {
+            *p++ = *kind++;
+        }
+        *p++ = ':';
+        p = _gdbstub_put_byte(p, stub->watch_addr >> 8);
+        p = _gdbstub_put_byte(p, stub->watch_addr & 0xFF);
+        *p++ = ';';
+        *p = 0;
+        _gdbstub_put_packet(stub, buf);
+        stub->watch_hit = false;
+    }
+    else {
+        _gdbstub_put_packet(stub, "S05");
+    }
+}
+
+/* request a stop at the next instruction boundary (the 6502 may be in
+   the middle of an instruction between frames)
+*/
+static void _gdbstub_request_stop(gdbstub_t* stub) {
+    #if defined(GDBSTUB_USE_Z80)
+        stub->stopped = true;
+    #else
+        stub->stepping = true;
+    #endif
+}
+
+/* stop the CPU and notify the debugger */
+static void _gdbstub_stop(gdbstub_t* stub) {
+    stub->stopped = true;
+    stub->stepping = false;
+    if ((stub->conn_sock >= 0) && stub->reply_pending) {
+        stub->reply_pending = false;
+        _gdbstub_stop_reply(stub);
+    }
+}
+
+/*=== register access ========================================================*/
+#if defined(GDBSTUB_USE_Z80)
+#define _GDBSTUB_NUM_REGS (13)
+static int _gdbstub_reg_size(int reg) {
+    (void)reg;
+    return 2;
+}
+
+static uint16_t _gdbstub_get_reg(gdbstub_t* stub, int reg) {
+    z80_t* cpu = stub->z80;
+    switch (reg) {
+        /* NOTE: the GDB Z80 target stores AF with F in the low byte */
+        case 0:  return z80_af(cpu);
+        case 1:  return z80_bc(cpu);
+        case 2:  return z80_de(cpu);
+        case 3:  return z80_hl(cpu);
+        case 4:  return z80_sp(cpu);
+        case 5:  return z80_pc(cpu);
+        case 6:  return z80_ix(cpu);
+        case 7:  return z80_iy(cpu);
+        case 8:  return z80_af_(cpu);
+        case 9:  return z80_bc_(cpu);
+        case 10: return z80_de_(cpu);
+        case 11: return z80_hl_(cpu);
+        case 12: return z80_ir(cpu);
+        default: return 0;
+    }
+}
+
+static bool _gdbstub_can_set_reg(gdbstub_t* stub, int reg, uint16_t val) {
+    (void)stub; (void)val;
+    return (reg >= 0) && (reg < _GDBSTUB_NUM_REGS);
+}
+
+static void _gdbstub_set_reg(gdbstub_t* stub, int reg, uint16_t val) {
+    z80_t* cpu = stub->z80;
+    switch (reg) {
+        case 0:  z80_set_af(cpu, val); break;
+        case 1:  z80_set_bc(cpu, val); break;
+        case 2:  z80_set_de(cpu, val); break;
+        case 3:  z80_set_hl(cpu, val); break;
+        case 4:  z80_set_sp(cpu, val); break;
+        case 5:  z80_set_pc(cpu, val); break;
+        case 6:  z80_set_ix(cpu, val); break;
+        case 7:  z80_set_iy(cpu, val); break;
+        case 8:  z80_set_af_(cpu, val); break;
+        case 9:  z80_set_bc_(cpu, val); break;
+        case 10: z80_set_de_(cpu, val); break;
+        case 11: z80_set_hl_(cpu, val); break;
+        case 12: z80_set_i(cpu, val >> 8); z80_set_r(cpu, val & 0xFF); break;
+        default: break;
+    }
+}
+#elif defined(GDBSTUB_USE_M6502)
+#define _GDBSTUB_NUM_REGS (6)
+static int _gdbstub_reg_size(int reg) {
+    return (reg == 5) ? 2 : 1;
+}
+
+static uint16_t _gdbstub_get_reg(gdbstub_t* stub, int reg) {
+    m6502_t* cpu = stub->m6502;
+    switch (reg) {
+        case 0: return cpu->A;
+        case 1: return cpu->X;
+        case 2: return cpu->Y;
+        case 3: return cpu->P;
+        case 4: return cpu->S;
+        case 5: return cpu->PC;
+        default: return 0;
+    }
+}
+
+static bool _gdbstub_can_set_reg(gdbstub_t* stub, int reg, uint16_t val) {
+    /* the opcode at PC has already been fetched, the PC can't be changed */
+    if (reg == 5) {
+        return val == stub->m6502->PC;
+    }
+    return (reg >= 0) && (reg < _GDBSTUB_NUM_REGS);
+}
+
+static void _gdbstub_set_reg(gdbstub_t* stub, int reg, uint16_t val) {
+    m6502_t* cpu = stub->m6502;
+    switch (reg) {
+        case 0: cpu->A = (uint8_t)val; break;
+        case 1: cpu->X = (uint8_t)val; break;
+        case 2: cpu->Y = (uint8_t)val; break;
+        case 3: cpu->P = (uint8_t)val; break;
+        case 4: cpu->S = (uint8_t)val; break;
+        default: break;
+    }
+}
+#endif
+
+/* write a register as little-endian hex string */
+static char* _gdbstub_put_reg(gdbstub_t* stub, char* dst, int reg) {
+    const uint16_t val = _gdbstub_get_reg(stub, reg);
+    dst = _gdbstub_put_byte(dst, val & 0xFF);
+    if (_gdbstub_reg_size(reg) == 2) {
+        dst = _gdbstub_put_byte(dst, val >> 8);
+    }
+    return dst;
+}
+
+/* parse a little-endian hex register value, returns number of chars consumed, or 0 on error */
+static int _gdbstub_parse_reg(const char* src, int reg, uint16_t* out_val) {
+    const int lo = _gdbstub_parse_byte(src);
+    if (lo < 0) {
+        return 0;
+    }
+    if (_gdbstub_reg_size(reg) == 2) {
+        const int hi = _gdbstub_parse_byte(src + 2);
+        if (hi < 0) {
+            return 0;
+        }
+        *out_val = (uint16_t)((hi << 8) | lo);
+        return 4;
+    }
+    *out_val = (uint16_t)lo;
+    return 2;
+}
+
+/*=== breakpoints and watchpoints ============================================*/
+static bool _gdbstub_add_breakpoint(gdbstub_t* stub, uint16_t addr) {
+    for (int i = 0; i < stub->num_breakpoints; i++) {
+        if (stub->breakpoints[i] == addr) {
+            return true;
+        }
+    }
+    if (stub->num_breakpoints < GDBSTUB_MAX_BREAKPOINTS) {
+        stub->breakpoints[stub->num_breakpoints++] = addr;
+        return true;
+    }
+    return false;
+}
+
+static void _gdbstub_remove_breakpoint(gdbstub_t* stub, uint16_t addr) {
+    for (int i = 0; i < stub->num_breakpoints; i++) {
+        if (stub->breakpoints[i] == addr) {
+            stub->breakpoints[i] = stub->breakpoints[--stub->num_breakpoints];
+            return;
+        }
+    }
+}
+
+static bool _gdbstub_is_breakpoint(const gdbstub_t* stub, uint16_t addr) {
+    for (int i = 0; i < stub->num_breakpoints; i++) {
+        if (stub->breakpoints[i] == addr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool _gdbstub_add_watchpoint(gdbstub_t* stub, int type, uint16_t addr, uint16_t len) {
+    #if defined(GDBSTUB_USE_Z80)
+    /* the Z80 trap callback doesn't see all memory accesses, only value changes can be detected */
+    if (type != GDBSTUB_WATCH_WRITE) {
+        return false;
+    }
+    #endif
+    if ((len == 0) || (len > GDBSTUB_MAX_WATCH_LEN) || (stub->num_watchpoints >= GDBSTUB_MAX_WATCHPOINTS)) {
+        return false;
+    }
+    gdbstub_watchpoint_t* wp = &stub->watchpoints[stub->num_watchpoints++];
+    wp->type = type;
+    wp->addr = addr;
+    wp->len = len;
+    for (int i = 0; i < len; i++) {
+        wp->val[i] = stub->read_cb((uint16_t)(addr + i), stub->user_data);
+    }
+    return true;
+}
+
+static void _gdbstub_remove_watchpoint(gdbstub_t* stub, int type, uint16_t addr, uint16_t len) {
+    for (int i = 0; i < stub->num_watchpoints; i++) {
+        const gdbstub_watchpoint_t* wp = &stub->watchpoints[i];
+        if ((wp->type == type) && (wp->addr == addr) && (wp->len == len)) {
+            stub->watchpoints[i] = stub->watchpoints[--stub->num_watchpoints];
+            return;
+        }
+    }
+}
+
+/*=== packet handling ========================================================*/
+static void _gdbstub_resume(gdbstub_t* stub, bool step) {
+    stub->stopped = false;
+    stub->stepping = step;
+    stub->reply_pending = true;
+}
+
+static void _gdbstub_handle_packet(gdbstub_t* stub) {
+    char out[GDBSTUB_MAX_PACKET];
+    const char* p = stub->rx_buf;
+    out[0] = 0;
+    switch (*p++) {
+        case '?':
+            /* if the CPU isn't stopped yet, the stop reply is sent when it stops */
+            if (stub->stopped) {
+                _gdbstub_stop_reply(stub);
+            }
+            else {
+                stub->reply_pending = true;
+            }
+            return;
+        case 'g':
+            {
+                char* dst = out;
+                for (int i = 0; i < _GDBSTUB_NUM_REGS; i++) {
+                    dst = _gdbstub_put_reg(stub, dst, i);
+                }
+                *dst = 0;
+            }
+            break;
+        case 'G':
+            {
+                /* parse and check all registers first, so a rejected packet changes nothing */
+                uint16_t vals[_GDBSTUB_NUM_REGS];
+                int num_vals = 0;
+                bool ok = true;
+                while ((num_vals < _GDBSTUB_NUM_REGS) && ok && *p) {
+                    const int n = _gdbstub_parse_reg(p, num_vals, &vals[num_vals]);
+                    ok = (n > 0) && _gdbstub_can_set_reg(stub, num_vals, vals[num_vals]);
+                    p += n;
+                    num_vals++;
+                }
+                if (ok) {
+                    for (int i = 0; i < num_vals; i++) {
+                        _gdbstub_set_reg(stub, i, vals[i]);
+                    }
+                }
+                strcpy(out, ok ? "OK" : "E01");
+            }
+            break;
+        case 'p':
+            {
+                const int reg = (int)_gdbstub_parse_hex(&p);
+                if (reg < _GDBSTUB_NUM_REGS) {
+                    char* dst = _gdbstub_put_reg(stub, out, reg);
+                    *dst = 0;
+                }
+                else {
+                    strcpy(out, "E01");
+                }
+            }
+            break;
+        case 'P':
+            {
+                const int reg = (int)_gdbstub_parse_hex(&p);
+                uint16_t val = 0;
+                bool ok = (*p++ == '=') && (reg < _GDBSTUB_NUM_REGS);
+                ok = ok && (_gdbstub_parse_reg(p, reg, &val) > 0) && _gdbstub_can_set_reg(stub, reg, val);
+                if (ok) {
+                    _gdbstub_set_reg(stub, reg, val);
+                }
+                strcpy(out, ok ? "OK" : "E01");
+            }
+            break;
+        case 'm':
+            {
+                uint16_t addr = (uint16_t)_gdbstub_parse_hex(&p);
+                uint32_t len = (*p++ == ',') ? _gdbstub_parse_hex(&p) : 0;
+                if (len > (GDBSTUB_MAX_PACKET / 2 - 1)) {
+                    len = GDBSTUB_MAX_PACKET / 2 - 1;
+                }
+                char* dst = out;
+                for (uint32_t i = 0; i < len; i++) {
+                    dst = _gdbstub_put_byte(dst, stub->read_cb(addr++, stub->user_data));
+                }
+                *dst = 0;
+            }
+            break;
+        case 'M':
+            {
+                uint16_t addr = (uint16_t)_gdbstub_parse_hex(&p);
+                uint32_t len = (*p++ == ',') ? _gdbstub_parse_hex(&p) : 0;
+                bool ok = (*p++ == ':');
+                for (uint32_t i = 0; (i < len) && ok; i++, p += 2) {
+                    const int val = _gdbstub_parse_byte(p);
+                    if (val >= 0) {
+                        stub->write_cb(addr++, (uint8_t)val, stub->user_data);
+                    }
+                    else {
+                        ok = false;
+                    }
+                }
+                strcpy(out, ok ? "OK" : "E01");
+            }
+            break;
+        case 'c':
+        case 's':
+            /* optional resume address (on the 6502 only the current PC) */
+            if (_gdbstub_hex_val(*p) >= 0) {
+                const uint16_t addr = (uint16_t)_gdbstub_parse_hex(&p);
+                if (!_gdbstub_can_set_reg(stub, 5, addr)) {
+                    strcpy(out, "E01");
+                    break;
+                }
+                _gdbstub_set_reg(stub, 5, addr);
+            }
+            _gdbstub_resume(stub, stub->rx_buf[0] == 's');
+            return;
+        case 'Z':
+        case 'z':
+            {
+                const bool insert = stub->rx_buf[0] == 'Z';
+                const int type = (int)_gdbstub_parse_hex(&p);
+                uint16_t addr = 0;
+                uint16_t len = 0;
+                if (*p++ == ',') {
+                    addr = (uint16_t)_gdbstub_parse_hex(&p);
+                    if (*p++ == ',') {
+                        len = (uint16_t)_gdbstub_parse_hex(&p);
+                    }
+                }
+                if ((type == 0) || (type == 1)) {
+                    if (insert) {
+                        strcpy(out, _gdbstub_add_breakpoint(stub, addr) ? "OK" : "E01");
+                    }
+                    else {
+                        _gdbstub_remove_breakpoint(stub, addr);
+                        strcpy(out, "OK");
+                    }
+                }
+                else if ((type >= GDBSTUB_WATCH_WRITE) && (type <= GDBSTUB_WATCH_ACCESS)) {
+                    if (insert) {
+                        /* empty reply means 'not supported' */
+                        if (_gdbstub_add_watchpoint(stub, type, addr, len)) {
+                            strcpy(out, "OK");
+                        }
+                    }
+                    else {
+                        _gdbstub_remove_watchpoint(stub, type, addr, len);
+                        strcpy(out, "OK");
+                    }
+                }
+            }
+            break;
+        case 'q':
+            if (0 == strncmp(p, "Supported", 9)) {
+                strcpy(out, "PacketSize=3f0;QStartNoAckMode+");
+            }
+            else if (0 == strcmp(p, "Attached")) {
+                strcpy(out, "1");
+            }
+            else if (0 == strcmp(p, "C")) {
+                strcpy(out, "QC1");
+            }
+            else if (0 == strcmp(p, "fThreadInfo")) {
+                strcpy(out, "m1");
+            }
+            else if (0 == strcmp(p, "sThreadInfo")) {
+                strcpy(out, "l");
+            }
+            break;
+        case 'Q':
+            if (0 == strcmp(p, "StartNoAckMode")) {
+                _gdbstub_put_packet(stub, "OK");
+                stub->no_ack = true;
+                return;
+            }
+            break;
+        case 'H':
+        case 'T':
+            strcpy(out, "OK");
+            break;
+        case 'D':
+            _gdbstub_put_packet(stub, "OK");
+            _gdbstub_disconnect(stub);
+            return;
+        case 'k':
+            _gdbstub_disconnect(stub);
+            return;
+        default:
+            /* unsupported packet, reply with empty packet */
+            break;
+    }
+    _gdbstub_put_packet(stub, out);
+}
+
+/* receive and handle all pending data from the client */
+static void _gdbstub_poll(gdbstub_t* stub) {
+    if (stub->conn_sock < 0) {
+        intptr_t sock = _gdbstub_accept(stub->listen_sock);
+        if (sock < 0) {
+            return;
+        }
+        /* a new client connection stops the CPU */
+        _gdbstub_disconnect(stub);
+        stub->conn_sock = sock;
+        _gdbstub_request_stop(stub);
+    }
+    char buf[256];
+    int num_bytes;
+    while ((stub->conn_sock >= 0) && ((num_bytes = _gdbstub_recv(stub->conn_sock, buf, sizeof(buf))) != 0)) {
+        if (num_bytes < 0) {
+            _gdbstub_disconnect(stub);
+            return;
+        }
+        for (int i = 0; (i < num_bytes) && (stub->conn_sock >= 0); i++) {
+            const char c = buf[i];
+            switch (stub->rx_state) {
+                case _GDBSTUB_RX_IDLE:
+                    if (c == '$') {
+                        stub->rx_state = _GDBSTUB_RX_DATA;
+                        stub->rx_len = 0;
+                        stub->rx_csum = 0;
+                    }
+                    else if (c == 0x03) {
+                        /* Ctrl-C: interrupt */
+                        if (!stub->stopped) {
+                            #if defined(GDBSTUB_USE_Z80)
+                                _gdbstub_stop(stub);
+                            #else
+                                _gdbstub_request_stop(stub);
+                            #endif
+                        }
+                    }
+                    /* ignore acks ('+' and '-') and everything else */
+                    break;
+                case _GDBSTUB_RX_DATA:
+                    if (c == '#') {
+                        stub->rx_state = _GDBSTUB_RX_CSUM0;
+                    }
+                    else {
+                        stub->rx_csum += (uint8_t)c;
+                        if (stub->rx_len < (GDBSTUB_MAX_PACKET - 1)) {
+                            stub->rx_buf[stub->rx_len++] = c;
+                        }
+                    }
+                    break;
+                case _GDBSTUB_RX_CSUM0:
+                case _GDBSTUB_RX_CSUM1:
+                    {
+                        const int val = _gdbstub_hex_val(c);
+                        if (stub->rx_state == _GDBSTUB_RX_CSUM0) {
+                            stub->rx_csum_err = (val < 0);
+                            stub->rx_csum_in = (uint8_t)((val & 0xF) << 4);
+                            stub->rx_state = _GDBSTUB_RX_CSUM1;
+                            break;
+                        }
+                        stub->rx_csum_err |= (val < 0);
+                        stub->rx_csum_in |= (uint8_t)(val & 0xF);
+                    }
+                    stub->rx_state = _GDBSTUB_RX_IDLE;
+                    stub->rx_buf[stub->rx_len] = 0;
+                    if (stub->rx_csum_err) {
+                        /* malformed checksum, reject the packet */
+                        if (!stub->no_ack && !_gdbstub_send(stub->conn_sock, "-", 1)) {
+                            _gdbstub_disconnect(stub);
+                        }
+                    }
+                    else if (stub->no_ack) {
+                        _gdbstub_handle_packet(stub);
+                    }
+                    else if (stub->rx_csum_in == stub->rx_csum) {
+                        if (_gdbstub_send(stub->conn_sock, "+", 1)) {
+                            _gdbstub_handle_packet(stub);
+                        }
+                        else {
+                            _gdbstub_disconnect(stub);
+                        }
+                    }
+                    else if (!_gdbstub_send(stub->conn_sock, "-", 1)) {
+                        _gdbstub_disconnect(stub);
+                    }
+                    break;
+            }
+        }
+    }
+}
+
+/*=== CPU hooks ==============================================================*/
+#if defined(GDBSTUB_USE_Z80)
+/* the trap callback, called after each instruction with the PC of the next instruction */
+static int _gdbstub_z80_trap(uint16_t pc, uint32_t ticks, uint64_t pins, void* user_data) {
+    gdbstub_t* stub = (gdbstub_t*) user_data;
+    if (stub->stepping || _gdbstub_is_breakpoint(stub, pc)) {
+        return GDBSTUB_TRAPID;
+    }
+    for (int i = 0; i < stub->num_watchpoints; i++) {
+        gdbstub_watchpoint_t* wp = &stub->watchpoints[i];
+        for (int j = 0; j < wp->len; j++) {
+            const uint16_t addr = (uint16_t)(wp->addr + j);
+            const uint8_t val = stub->read_cb(addr, stub->user_data);
+            if (val != wp->val[j]) {
+                wp->val[j] = val;
+                stub->watch_hit = true;
+                stub->watch_type = wp->type;
+                stub->watch_addr = addr;
+            }
+        }
+    }
+    if (stub->watch_hit) {
+        return GDBSTUB_TRAPID;
+    }
+    /* call original trap callback */
+    if (stub->z80_trap_cb) {
+        return stub->z80_trap_cb(pc, ticks, pins, stub->z80_trap_ud);
+    }
+    return 0;
+}
+#endif
+
+void gdbstub_init(gdbstub_t* stub, const gdbstub_desc_t* desc) {
+    CHIPS_ASSERT(stub && desc);
+    CHIPS_ASSERT(desc->read_cb && desc->write_cb);
+    memset(stub, 0, sizeof(*stub));
+    stub->valid = true;
+    #if defined(GDBSTUB_USE_Z80)
+        CHIPS_ASSERT(desc->z80);
+        stub->z80 = desc->z80;
+    #elif defined(GDBSTUB_USE_M6502)
+        CHIPS_ASSERT(desc->m6502);
+        stub->m6502 = desc->m6502;
+    #endif
+    stub->read_cb = desc->read_cb;
+    stub->write_cb = desc->write_cb;
+    stub->user_data = desc->user_data;
+    stub->conn_sock = -1;
+    stub->listen_sock = _gdbstub_listen(desc->port ? desc->port : GDBSTUB_DEFAULT_PORT);
+    stub->listening = stub->listen_sock >= 0;
+}
+
+void gdbstub_discard(gdbstub_t* stub) {
+    CHIPS_ASSERT(stub && stub->valid);
+    _gdbstub_disconnect(stub);
+    if (stub->listen_sock >= 0) {
+        _gdbstub_close(stub->listen_sock);
+        stub->listen_sock = -1;
+        #if defined(_WIN32)
+        WSACleanup();
+        #endif
+    }
+    stub->listening = false;
+    stub->valid = false;
+}
+
+bool gdbstub_connected(const gdbstub_t* stub) {
+    CHIPS_ASSERT(stub && stub->valid);
+    return stub->conn_sock >= 0;
+}
+
+bool gdbstub_before_exec(gdbstub_t* stub) {
+    CHIPS_ASSERT(stub && stub->valid);
+    if (!stub->listening) {
+        return true;
+    }
+    _gdbstub_poll(stub);
+    #if defined(GDBSTUB_USE_Z80)
+    if ((stub->conn_sock >= 0) && !stub->stopped) {
+        stub->z80_trap_cb = stub->z80->trap_cb;
+        stub->z80_trap_ud = stub->z80->trap_user_data;
+        z80_trap_cb(stub->z80, _gdbstub_z80_trap, stub);
+    }
+    #endif
+    return !stub->stopped;
+}
+
+void gdbstub_after_exec(gdbstub_t* stub) {
+    CHIPS_ASSERT(stub && stub->valid);
+    #if defined(GDBSTUB_USE_Z80)
+        /* uninstall our trap callback, but only if it hasn't been overwritten */
+        if (stub->z80->trap_cb == _gdbstub_z80_trap) {
+            z80_trap_cb(stub->z80, stub->z80_trap_cb, stub->z80_trap_ud);
+            stub->z80_trap_cb = 0;
+            stub->z80_trap_ud = 0;
+            if (stub->z80->trap_id == GDBSTUB_TRAPID) {
+                _gdbstub_stop(stub);
+            }
+        }
+    #else
+        (void)stub;
+    #endif
+}
+
+bool gdbstub_tick(gdbstub_t* stub, uint64_t pins) {
+    #if defined(GDBSTUB_USE_M6502)
+        if (stub->conn_sock < 0) {
+            return false;
+        }
+        if (pins & M6502_SYNC) {
+            /* start of a new instruction */
+            const uint16_t pc = M6502_GET_ADDR(pins);
+            if (stub->stepping || stub->watch_hit || _gdbstub_is_breakpoint(stub, pc)) {
+                _gdbstub_stop(stub);
+                return true;
+            }
+        }
+        else if (stub->num_watchpoints > 0) {
+            const uint16_t addr = M6502_GET_ADDR(pins);
+            const int type = (pins & M6502_RW) ? GDBSTUB_WATCH_READ : GDBSTUB_WATCH_WRITE;
+            for (int i = 0; i < stub->num_watchpoints; i++) {
+                const gdbstub_watchpoint_t* wp = &stub->watchpoints[i];
+                if ((uint16_t)(addr - wp->addr) < wp->len) {
+                    if ((wp->type == type) || (wp->type == GDBSTUB_WATCH_ACCESS)) {
+                        stub->watch_hit = true;
+                        stub->watch_type = wp->type;
+                        stub->watch_addr = addr;
+                    }
+                }
+            }
+        }
+        return false;
+    #else
+        (void)stub;
+        (void)pins;
+        return false;
+    #endif
+}
+#endif /* CHIPS_IMPL */
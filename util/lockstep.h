@@ -0,0 +1,946 @@
+#pragma once
+/*#
+    # lockstep.h
+
+    Run two CPU emulator cores side by side on the same program and report
+    the first divergence in bus cycles or register state. This is meant
+    to verify optimized code paths (for instance the computed-goto decoder
+    of z80.h/m6502.h, or changes to the code generators) against a
+    reference build of the same CPU emulator.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Select the ready-made CPU adapters to compile by defining one or both of:
+
+    LOCKSTEP_USE_Z80
+    LOCKSTEP_USE_M6502
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    You need to include the following headers before including lockstep.h:
+
+        - z80.h         (only if LOCKSTEP_USE_Z80 is defined)
+        - m6502.h       (only if LOCKSTEP_USE_M6502 is defined)
+
+    ## Usage
+
+    lockstep.h doesn't know anything about specific CPUs, each core
+    is wrapped in a 'step callback' which runs exactly one instruction,
+    records every bus cycle with lockstep_bus(), and records the
+    CPU register values after the instruction with lockstep_reg():
+
+    ~~~C
+    void step_cb(lockstep_state_t* state, void* user_data)
+    ~~~
+
+    Both cores must run in their own memory (usually a copy of the
+    same test program), and their tick callbacks must behave identically.
+
+    Since all chips headers use the same public function names, the
+    reference core and the optimized core must be compiled in separate
+    C files. Rename the public functions in the reference C file before
+    including the implementation, for instance:
+
+    ~~~C
+    // z80_ref.c: the reference core is the plain switch-case decoder
+    #define z80_init z80ref_init
+    #define z80_reset z80ref_reset
+    #define z80_exec z80ref_exec
+    // ...all other public z80_* functions
+    #define CHIPS_IMPL
+    #include "chips/chips_state.h"
+    #include "chips/z80.h"
+
+    // z80_opt.c: the optimized core
+    #define CHIPS_Z80_COMPUTED_GOTO
+    #define CHIPS_IMPL
+    #include "chips/chips_state.h"
+    #include "chips/z80.h"
+    ~~~
+
+    A Z80 step callback calls z80_exec() with a tick budget of 1 (which
+    runs exactly one instruction), calls lockstep_bus() from inside the
+    CPU tick callback, and records the register state afterwards:
+
+    ~~~C
+    static uint64_t tick(int num_ticks, uint64_t pins, void* user_data) {
+        core_t* core = (core_t*) user_data;
+        // ...memory and IO access on core->mem...
+        lockstep_bus(core->state, pins);
+        return pins;
+    }
+
+    static void step(lockstep_state_t* state, void* user_data) {
+        core_t* core = (core_t*) user_data;
+        core->state = state;
+        z80_exec(&core->cpu, 1);
+        lockstep_reg(state, z80_af(&core->cpu));
+        lockstep_reg(state, z80_bc(&core->cpu));
+        // ...
+    }
+    ~~~
+
+    A 6502 step callback calls the tick function until the SYNC pin
+    is set, and calls lockstep_bus() after each tick.
+
+    Then setup a lockstep_t instance with both cores:
+
+    ~~~C
+    void lockstep_init(lockstep_t* ls, const lockstep_desc_t* desc)
+    ~~~
+        Initialize a lockstep_t instance, the desc structure has the
+        following members:
+
+        lockstep_core_t ref     - the reference core (step_cb and user_data)
+        lockstep_core_t dut     - the core under test (step_cb and user_data)
+        uint64_t pin_mask       - the bus pins to compare, zero means 'all pins'
+        const char** reg_names  - optional register names for lockstep_report()
+
+    ~~~C
+    bool lockstep_run(lockstep_t* ls, uint32_t num_steps)
+    ~~~
+        Run both cores for up to num_steps instructions, comparing the
+        bus cycles and register values after each instruction. Returns
+        true if no divergence was found, or false at the first divergence.
+        Both cores are stopped at the instruction which diverged, the
+        details are in ls->div (see below).
+        lockstep_run() can be called repeatedly. If a core has no more
+        instructions to run (the end of a recorded trace), lockstep_run()
+        returns true and sets ls->finished.
+
+    ~~~C
+    void lockstep_report(const lockstep_t* ls, lockstep_output_t out_cb, void* user_data)
+    ~~~
+        Write a human-readable description of the first divergence
+        through a character output callback (the same callback signature
+        as the disassemblers in the util directory), which includes
+        the bus cycles and register values of both cores of the step which
+        diverged. This function doesn't call any CRT functions.
+
+    The divergence details are in the lockstep_t::div member:
+
+        bool diverged           - true if a divergence has been found
+        uint32_t step           - the instruction index (starting at 0)
+        lockstep_kind_t kind    - LOCKSTEP_DIV_NUM_CYCLES, LOCKSTEP_DIV_BUS or LOCKSTEP_DIV_REG
+        int index               - the bus cycle index or register index
+        lockstep_state_t ref    - the recorded state of the reference core
+        lockstep_state_t dut    - the recorded state of the core under test
+
+    ## Z80 and 6502 Adapters
+
+    With LOCKSTEP_USE_Z80 or LOCKSTEP_USE_M6502 defined, lockstep.h provides
+    ready-made step callbacks for a CPU with 64 KBytes of RAM. Memory
+    accesses go to the RAM array, IO reads return 0xFF and IO writes are
+    ignored.
+
+    Both adapters are compiled in the C file of the core under test, the
+    reference core is plugged in through the init and exec (or tick)
+    functions of the renamed reference build, which run on the same CPU
+    struct layout:
+
+    ~~~C
+    #define CHIPS_Z80_COMPUTED_GOTO
+    #define LOCKSTEP_USE_Z80
+    #define CHIPS_IMPL
+    #include "chips/chips_state.h"
+    #include "chips/z80.h"
+    #include "util/lockstep.h"
+
+    // the renamed reference build from z80_ref.c
+    void z80ref_init(z80_t* cpu, const z80_desc_t* desc);
+    uint32_t z80ref_exec(z80_t* cpu, uint32_t ticks);
+
+    static lockstep_z80_t ref, dut;
+    ...
+    lockstep_z80_init(&ref, &(lockstep_z80_desc_t){
+        .funcs = { .init = z80ref_init, .exec = z80ref_exec },
+        .mem = zexdoc_com, .mem_size = sizeof(zexdoc_com), .mem_addr = 0x0100,
+        .pc = 0x0100,
+    });
+    lockstep_z80_init(&dut, &(lockstep_z80_desc_t){
+        .mem = zexdoc_com, .mem_size = sizeof(zexdoc_com), .mem_addr = 0x0100,
+        .pc = 0x0100,
+    });
+    ~~~
+
+    Leaving the funcs member zeroed selects the functions of the build
+    which includes lockstep.h.
+
+    ~~~C
+    void lockstep_z80_init(lockstep_z80_t* sys, const lockstep_z80_desc_t* desc)
+    void lockstep_m6502_init(lockstep_m6502_t* sys, const lockstep_m6502_desc_t* desc)
+    ~~~
+        Initialize the CPU, copy mem_size bytes from mem into the RAM at
+        mem_addr, and start at the address pc. The 6502 always starts
+        through its reset vector, a non-zero pc is written to the reset
+        vector at 0xFFFC. lockstep_m6502_init() runs the reset sequence,
+        so with both adapters the first step executes the instruction at
+        pc. The RAM is public (sys->mem), so the program environment can
+        be patched after the init call.
+
+    ~~~C
+    lockstep_core_t lockstep_z80_core(lockstep_z80_t* sys)
+    lockstep_core_t lockstep_m6502_core(lockstep_m6502_t* sys)
+    ~~~
+        Return the step callback and user data for lockstep_desc_t.
+
+    ~~~C
+    const char** lockstep_z80_reg_names(void)
+    const char** lockstep_m6502_reg_names(void)
+    ~~~
+        Return the names of the recorded registers for lockstep_desc_t.
+
+    The Z80 adapter runs one complete instruction per step (including the
+    DD/FD prefix), and records the tick count of each machine cycle in
+    the pin bits 56..63 (LOCKSTEP_Z80_TICKS_SHIFT), so that timing
+    differences are detected as bus divergence. It records AF, BC, DE,
+    HL, the shadow registers, IX, IY, SP, PC, WZ, I, R, IM and the
+    interrupt flip-flops.
+
+    The 6502 adapter ticks the CPU from one SYNC (opcode fetch) to the next,
+    and records A, X, Y, S, P and PC. A jammed CPU (after a JAM/KIL opcode)
+    is stepped in chunks of LOCKSTEP_MAX_CYCLES ticks.
+
+    For instance, ZEXDOC or ZEXALL run as CP/M program at 0x0100. They
+    call BDOS at 0x0005 for output (a RET is enough when only comparing
+    two cores) and take the stack pointer from 0x0006, the test is over
+    when the PC reaches 0x0000:
+
+    ~~~C
+    lockstep_z80_t* cores[2] = { &ref, &dut };
+    for (int i = 0; i < 2; i++) {
+        cores[i]->mem[0x0005] = 0xC9;   // RET
+        cores[i]->mem[0x0006] = 0x00;   // stack at 0xF000
+        cores[i]->mem[0x0007] = 0xF0;
+    }
+    lockstep_init(&ls, &(lockstep_desc_t){
+        .ref = lockstep_z80_core(&ref),
+        .dut = lockstep_z80_core(&dut),
+        .reg_names = lockstep_z80_reg_names(),
+    });
+    while (lockstep_run(&ls, 100000) && (z80_pc(&dut.cpu) != 0x0000));
+    ~~~
+
+    Klaus Dormann's 6502_functional_test.bin is a 64 KByte image which
+    starts at 0x0400, and ends in an endless loop (a JMP to itself) at
+    the success address, or at the failing test:
+
+    ~~~C
+    lockstep_m6502_init(&dut, &(lockstep_m6502_desc_t){
+        .mem = dormann_bin, .mem_size = sizeof(dormann_bin),
+        .pc = 0x0400,
+    });
+    ~~~
+
+    ## Recorded Traces
+
+    Instead of running the reference core side by side with the core
+    under test, its bus cycles and registers can be recorded once into a
+    trace buffer (and saved to a file), and later be replayed as
+    reference core:
+
+    ~~~C
+    void lockstep_trace_init(lockstep_trace_t* trace, void* buf, int buf_size)
+    ~~~
+        Initialize an empty trace for recording into a caller-provided
+        buffer.
+
+    ~~~C
+    uint32_t lockstep_trace_record(lockstep_trace_t* trace, lockstep_core_t core, uint32_t num_steps)
+    ~~~
+        Run a core for up to num_steps instructions and append the
+        recorded states to the trace, returns the number of recorded
+        instructions. Recording stops early when the trace buffer is full
+        (trace->full is set, the last instruction was executed but not
+        recorded).
+
+    ~~~C
+    int lockstep_trace_size(const lockstep_trace_t* trace)
+    ~~~
+        Return the number of bytes in the trace, the trace data is the
+        first lockstep_trace_size() bytes of the buffer.
+
+    ~~~C
+    void lockstep_trace_load(lockstep_trace_t* trace, const void* data, int num_bytes)
+    ~~~
+        Initialize a trace for replaying previously recorded trace data
+        (for instance loaded from a file). The data must remain valid while
+        the trace is replayed.
+
+    ~~~C
+    lockstep_core_t lockstep_trace_core(lockstep_trace_t* trace)
+    ~~~
+        Return a core which replays the trace from the start, use it as
+        the reference core in lockstep_desc_t. lockstep_run() sets
+        ls->finished when the end of the trace is reached.
+
+    The trace data is a packed little-endian byte stream with the full
+    pin masks, the pin_mask of the lockstep_t instance is applied when
+    comparing.
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* max number of bus cycles recorded per instruction (enough for a Z80 LDIR step or 6502 interrupt) */
+#define LOCKSTEP_MAX_CYCLES (64)
+/* max number of register values recorded per instruction */
+#define LOCKSTEP_MAX_REGS (32)
+
+/* the recorded state of one core after one instruction */
+typedef struct {
+    bool end;                       /* set by a step callback which has no more instructions */
+    int num_cycles;
+    int num_regs;
+    uint64_t pins[LOCKSTEP_MAX_CYCLES];
+    uint32_t regs[LOCKSTEP_MAX_REGS];
+} lockstep_state_t;
+
+/* step callback, run one instruction and record bus cycles and registers */
+typedef void (*lockstep_step_t)(lockstep_state_t* state, void* user_data);
+/* character output callback for lockstep_report() */
+typedef void (*lockstep_output_t)(char c, void* user_data);
+
+/* one CPU core */
+typedef struct {
+    lockstep_step_t step_cb;
+    void* user_data;
+} lockstep_core_t;
+
+/* lockstep_t setup parameters */
+typedef struct {
+    lockstep_core_t ref;            /* the reference core */
+    lockstep_core_t dut;            /* the core under test */
+    uint64_t pin_mask;              /* the pins to compare (0: all pins) */
+    const char** reg_names;         /* optional register names for lockstep_report() */
+} lockstep_desc_t;
+
+/* the kind of divergence */
+typedef enum {
+    LOCKSTEP_DIV_NONE,
+    LOCKSTEP_DIV_NUM_CYCLES,        /* different number of bus cycles */
+    LOCKSTEP_DIV_BUS,               /* different pins in a bus cycle */
+    LOCKSTEP_DIV_REG,               /* different register value after the instruction */
+} lockstep_kind_t;
+
+/* details of the first divergence */
+typedef struct {
+    bool diverged;
+    uint32_t step;
+    lockstep_kind_t kind;
+    int index;
+    lockstep_state_t ref;
+    lockstep_state_t dut;
+} lockstep_div_t;
+
+/* lockstep state */
+typedef struct {
+    lockstep_core_t ref;
+    lockstep_core_t dut;
+    uint64_t pin_mask;
+    const char** reg_names;
+    uint32_t step;
+    bool finished;                  /* true when a core had no more instructions */
+    lockstep_div_t div;
+} lockstep_t;
+
+/* a recorded trace */
+typedef struct {
+    uint8_t* buf;                   /* record buffer (zero when replaying loaded data) */
+    const uint8_t* data;            /* trace data */
+    int buf_size;
+    int size;                       /* number of bytes in the trace */
+    int pos;                        /* replay position */
+    bool full;                      /* true if recording stopped because the buffer was full */
+} lockstep_trace_t;
+
+/* initialize a new lockstep_t instance */
+void lockstep_init(lockstep_t* ls, const lockstep_desc_t* desc);
+/* run both cores for up to num_steps instructions, return false on divergence */
+bool lockstep_run(lockstep_t* ls, uint32_t num_steps);
+/* write a description of the first divergence to a character output callback */
+void lockstep_report(const lockstep_t* ls, lockstep_output_t out_cb, void* user_data);
+
+/* initialize an empty trace for recording */
+void lockstep_trace_init(lockstep_trace_t* trace, void* buf, int buf_size);
+/* run a core and append its recorded states to the trace, return number of recorded instructions */
+uint32_t lockstep_trace_record(lockstep_trace_t* trace, lockstep_core_t core, uint32_t num_steps);
+/* return the size of the trace data in bytes */
+int lockstep_trace_size(const lockstep_trace_t* trace);
+/* initialize a trace for replaying recorded trace data */
+void lockstep_trace_load(lockstep_trace_t* trace, const void* data, int num_bytes);
+/* return a core which replays the trace from the start */
+lockstep_core_t lockstep_trace_core(lockstep_trace_t* trace);
+
+#if defined(LOCKSTEP_USE_Z80)
+/* the machine cycle tick count is recorded in the pin bits 56..63 */
+#define LOCKSTEP_Z80_TICKS_SHIFT (56)
+/* number of recorded Z80 registers */
+#define LOCKSTEP_Z80_NUM_REGS (16)
+
+/* the functions of a Z80 build (zero: the build which includes lockstep.h) */
+typedef struct {
+    void (*init)(z80_t* cpu, const z80_desc_t* desc);
+    uint32_t (*exec)(z80_t* cpu, uint32_t ticks);
+} lockstep_z80_funcs_t;
+
+/* lockstep_z80_init() setup parameters */
+typedef struct {
+    lockstep_z80_funcs_t funcs;
+    const void* mem;                /* program to copy into RAM */
+    int mem_size;
+    uint16_t mem_addr;              /* RAM address of the program */
+    uint16_t pc;                    /* start address */
+} lockstep_z80_desc_t;
+
+/* Z80 adapter state */
+typedef struct {
+    z80_t cpu;
+    lockstep_z80_funcs_t funcs;
+    lockstep_state_t* state;
+    uint8_t mem[1<<16];
+} lockstep_z80_t;
+
+/* initialize a Z80 adapter */
+void lockstep_z80_init(lockstep_z80_t* sys, const lockstep_z80_desc_t* desc);
+/* get the lockstep core of a Z80 adapter */
+lockstep_core_t lockstep_z80_core(lockstep_z80_t* sys);
+/* get the names of the recorded Z80 registers */
+const char** lockstep_z80_reg_names(void);
+#endif
+
+#if defined(LOCKSTEP_USE_M6502)
+/* number of recorded 6502 registers */
+#define LOCKSTEP_M6502_NUM_REGS (6)
+
+/* the functions of a 6502 build (zero: the build which includes lockstep.h) */
+typedef struct {
+    uint64_t (*init)(m6502_t* cpu, const m6502_desc_t* desc);
+    uint64_t (*tick)(m6502_t* cpu, uint64_t pins);
+} lockstep_m6502_funcs_t;
+
+/* lockstep_m6502_init() setup parameters */
+typedef struct {
+    lockstep_m6502_funcs_t funcs;
+    const void* mem;                /* program to copy into RAM */
+    int mem_size;
+    uint16_t mem_addr;              /* RAM address of the program */
+    uint16_t pc;                    /* start address (0: use the reset vector in RAM) */
+} lockstep_m6502_desc_t;
+
+/* 6502 adapter state */
+typedef struct {
+    m6502_t cpu;
+    lockstep_m6502_funcs_t funcs;
+    uint64_t pins;
+    uint8_t mem[1<<16];
+} lockstep_m6502_t;
+
+/* initialize a 6502 adapter */
+void lockstep_m6502_init(lockstep_m6502_t* sys, const lockstep_m6502_desc_t* desc);
+/* get the lockstep core of a 6502 adapter */
+lockstep_core_t lockstep_m6502_core(lockstep_m6502_t* sys);
+/* get the names of the recorded 6502 registers */
+const char** lockstep_m6502_reg_names(void);
+#endif
+
+/* record a bus cycle (call from the CPU tick callback) */
+static inline void lockstep_bus(lockstep_state_t* state, uint64_t pins) {
+    if (state->num_cycles < LOCKSTEP_MAX_CYCLES) {
+        state->pins[state->num_cycles] = pins;
+    }
+    state->num_cycles++;
+}
+
+/* record a register value (call after the instruction has been executed) */
+static inline void lockstep_reg(lockstep_state_t* state, uint32_t val) {
+    if (state->num_regs < LOCKSTEP_MAX_REGS) {
+        state->regs[state->num_regs++] = val;
+    }
+}
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#include <string.h>
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+
+void lockstep_init(lockstep_t* ls, const lockstep_desc_t* desc) {
+    CHIPS_ASSERT(ls && desc);
+    CHIPS_ASSERT(desc->ref.step_cb && desc->dut.step_cb);
+    memset(ls, 0, sizeof(*ls));
+    ls->ref = desc->ref;
+    ls->dut = desc->dut;
+    ls->pin_mask = desc->pin_mask ? desc->pin_mask : ~0ULL;
+    ls->reg_names = desc->reg_names;
+}
+
+/* compare the recorded states of both cores, fill in divergence details */
+static bool _lockstep_compare(lockstep_t* ls, const lockstep_state_t* ref, const lockstep_state_t* dut) {
+    lockstep_kind_t kind = LOCKSTEP_DIV_NONE;
+    int index = 0;
+    const int num_cycles = (ref->num_cycles < dut->num_cycles) ? ref->num_cycles : dut->num_cycles;
+    const int num_recorded = (num_cycles < LOCKSTEP_MAX_CYCLES) ? num_cycles : LOCKSTEP_MAX_CYCLES;
+    /* first check the bus cycles which both cores have in common */
+    for (int i = 0; i < num_recorded; i++) {
+        if ((ref->pins[i] ^ dut->pins[i]) & ls->pin_mask) {
+            kind = LOCKSTEP_DIV_BUS;
+            index = i;
+            break;
+        }
+    }
+    if (kind == LOCKSTEP_DIV_NONE) {
+        if (ref->num_cycles != dut->num_cycles) {
+            kind = LOCKSTEP_DIV_NUM_CYCLES;
+            index = num_cycles;
+        }
+        else if (ref->num_regs != dut->num_regs) {
+            kind = LOCKSTEP_DIV_REG;
+            index = (ref->num_regs < dut->num_regs) ? ref->num_regs : dut->num_regs;
+        }
+        else {
+            for (int i = 0; i < ref->num_regs; i++) {
+                if (ref->regs[i] != dut->regs[i]) {
+                    kind = LOCKSTEP_DIV_REG;
+                    index = i;
+                    break;
+                }
+            }
+        }
+    }
+    if (kind != LOCKSTEP_DIV_NONE) {
+        ls->div.diverged = true;
+        ls->div.step = ls->step;
+        ls->div.kind = kind;
+        ls->div.index = index;
+        ls->div.ref = *ref;
+        ls->div.dut = *dut;
+        return false;
+    }
+    return true;
+}
+
+bool lockstep_run(lockstep_t* ls, uint32_t num_steps) {
+    CHIPS_ASSERT(ls);
+    if (ls->div.diverged) {
+        return false;
+    }
+    lockstep_state_t ref, dut;
+    for (uint32_t i = 0; (i < num_steps) && !ls->finished; i++) {
+        ref.end = dut.end = false;
+        ref.num_cycles = ref.num_regs = 0;
+        dut.num_cycles = dut.num_regs = 0;
+        ls->ref.step_cb(&ref, ls->ref.user_data);
+        if (!ref.end) {
+            ls->dut.step_cb(&dut, ls->dut.user_data);
+        }
+        if (ref.end || dut.end) {
+            ls->finished = true;
+            break;
+        }
+        if (!_lockstep_compare(ls, &ref, &dut)) {
+            return false;
+        }
+        ls->step++;
+    }
+    return true;
+}
+
+/* CRT-free output helpers */
+static void _lockstep_str(const char* str, lockstep_output_t out_cb, void* user_data) {
+    while (*str) {
+        out_cb(*str++, user_data);
+    }
+}
+
+static void _lockstep_hex(uint64_t val, int digits, lockstep_output_t out_cb, void* user_data) {
+    for (int i = digits-1; i >= 0; i--) {
+        out_cb("0123456789ABCDEF"[(val>>(i*4)) & 0xF], user_data);
+    }
+}
+
+static void _lockstep_dec(uint32_t val, lockstep_output_t out_cb, void* user_data) {
+    char buf[10];
+    int i = 0;
+    do {
+        buf[i++] = '0' + (val % 10);
+        val /= 10;
+    } while (val > 0);
+    while (i > 0) {
+        out_cb(buf[--i], user_data);
+    }
+}
+
+static void _lockstep_reg_name(const lockstep_t* ls, int i, lockstep_output_t out_cb, void* user_data) {
+    if (ls->reg_names && ls->reg_names[i]) {
+        _lockstep_str(ls->reg_names[i], out_cb, user_data);
+    }
+    else {
+        _lockstep_str("reg", out_cb, user_data);
+        _lockstep_dec(i, out_cb, user_data);
+    }
+}
+
+static void _lockstep_state(const lockstep_t* ls, const char* name, const lockstep_state_t* state, lockstep_output_t out_cb, void* user_data) {
+    _lockstep_str(name, out_cb, user_data);
+    _lockstep_str(": ", out_cb, user_data);
+    _lockstep_dec(state->num_cycles, out_cb, user_data);
+    _lockstep_str(" bus cycles\n", out_cb, user_data);
+    const int num_recorded = (state->num_cycles < LOCKSTEP_MAX_CYCLES) ? state->num_cycles : LOCKSTEP_MAX_CYCLES;
+    for (int i = 0; i < num_recorded; i++) {
+        _lockstep_str("  ", out_cb, user_data);
+        _lockstep_dec(i, out_cb, user_data);
+        _lockstep_str(": ", out_cb, user_data);
+        _lockstep_hex(state->pins[i], 16, out_cb, user_data);
+        out_cb('\n', user_data);
+    }
+    for (int i = 0; i < state->num_regs; i++) {
+        _lockstep_str("  ", out_cb, user_data);
+        _lockstep_reg_name(ls, i, out_cb, user_data);
+        _lockstep_str("=", out_cb, user_data);
+        _lockstep_hex(state->regs[i], 8, out_cb, user_data);
+        out_cb('\n', user_data);
+    }
+}
+
+void lockstep_report(const lockstep_t* ls, lockstep_output_t out_cb, void* user_data) {
+    CHIPS_ASSERT(ls && out_cb);
+    const lockstep_div_t* div = &ls->div;
+    if (!div->diverged) {
+        _lockstep_str("no divergence after ", out_cb, user_data);
+        _lockstep_dec(ls->step, out_cb, user_data);
+        _lockstep_str(" instructions\n", out_cb, user_data);
+        return;
+    }
+    _lockstep_str("divergence at instruction ", out_cb, user_data);
+    _lockstep_dec(div->step, out_cb, user_data);
+    _lockstep_str(": ", out_cb, user_data);
+    switch (div->kind) {
+        case LOCKSTEP_DIV_NUM_CYCLES:
+            _lockstep_str("number of bus cycles differs\n", out_cb, user_data);
+            break;
+        case LOCKSTEP_DIV_BUS:
+            _lockstep_str("pins differ in bus cycle ", out_cb, user_data);
+            _lockstep_dec(div->index, out_cb, user_data);
+            _lockstep_str(" (mask ", out_cb, user_data);
+            _lockstep_hex((div->ref.pins[div->index] ^ div->dut.pins[div->index]) & ls->pin_mask, 16, out_cb, user_data);
+            _lockstep_str(")\n", out_cb, user_data);
+            break;
+        case LOCKSTEP_DIV_REG:
+            if (div->index < div->ref.num_regs && div->index < div->dut.num_regs) {
+                _lockstep_str("register ", out_cb, user_data);
+                _lockstep_reg_name(ls, div->index, out_cb, user_data);
+                _lockstep_str(" differs\n", out_cb, user_data);
+            }
+            else {
+                _lockstep_str("number of registers differs\n", out_cb, user_data);
+            }
+            break;
+        default:
+            break;
+    }
+    _lockstep_state(ls, "ref", &div->ref, out_cb, user_data);
+    _lockstep_state(ls, "dut", &div->dut, out_cb, user_data);
+}
+
+/*=== recorded traces ========================================================*/
+void lockstep_trace_init(lockstep_trace_t* trace, void* buf, int buf_size) {
+    CHIPS_ASSERT(trace && buf && (buf_size > 0));
+    memset(trace, 0, sizeof(*trace));
+    trace->buf = (uint8_t*) buf;
+    trace->data = trace->buf;
+    trace->buf_size = buf_size;
+}
+
+void lockstep_trace_load(lockstep_trace_t* trace, const void* data, int num_bytes) {
+    CHIPS_ASSERT(trace && data && (num_bytes >= 0));
+    memset(trace, 0, sizeof(*trace));
+    trace->data = (const uint8_t*) data;
+    trace->size = num_bytes;
+}
+
+int lockstep_trace_size(const lockstep_trace_t* trace) {
+    CHIPS_ASSERT(trace);
+    return trace->size;
+}
+
+static void _lockstep_put(uint8_t* ptr, uint64_t val, int num_bytes) {
+    for (int i = 0; i < num_bytes; i++) {
+        ptr[i] = (uint8_t)(val >> (i*8));
+    }
+}
+
+static uint64_t _lockstep_get(const uint8_t* ptr, int num_bytes) {
+    uint64_t val = 0;
+    for (int i = 0; i < num_bytes; i++) {
+        val |= ((uint64_t)ptr[i]) << (i*8);
+    }
+    return val;
+}
+
+/* one trace item: u32 num_cycles, u8 num_regs, then the recorded pins and registers */
+uint32_t lockstep_trace_record(lockstep_trace_t* trace, lockstep_core_t core, uint32_t num_steps) {
+    CHIPS_ASSERT(trace && trace->buf && core.step_cb);
+    lockstep_state_t state;
+    uint32_t i;
+    for (i = 0; (i < num_steps) && !trace->full; i++) {
+        state.end = false;
+        state.num_cycles = state.num_regs = 0;
+        core.step_cb(&state, core.user_data);
+        if (state.end) {
+            break;
+        }
+        const int num_recorded = (state.num_cycles < LOCKSTEP_MAX_CYCLES) ? state.num_cycles : LOCKSTEP_MAX_CYCLES;
+        const int item_size = 5 + num_recorded*8 + state.num_regs*4;
+        if ((trace->size + item_size) > trace->buf_size) {
+            trace->full = true;
+            break;
+        }
+        uint8_t* ptr = trace->buf + trace->size;
+        _lockstep_put(ptr, (uint32_t)state.num_cycles, 4); ptr += 4;
+        _lockstep_put(ptr, (uint8_t)state.num_regs, 1); ptr += 1;
+        for (int c = 0; c < num_recorded; c++, ptr += 8) {
+            _lockstep_put(ptr, state.pins[c], 8);
+        }
+        for (int r = 0; r < state.num_regs; r++, ptr += 4) {
+            _lockstep_put(ptr, state.regs[r], 4);
+        }
+        trace->size += item_size;
+    }
+    return i;
+}
+
+/* replay the next trace item, a truncated or corrupt item ends the trace */
+static void _lockstep_trace_step(lockstep_state_t* state, void* user_data) {
+    lockstep_trace_t* trace = (lockstep_trace_t*) user_data;
+    const int avail = trace->size - trace->pos;
+    if (avail < 5) {
+        state->end = true;
+        return;
+    }
+    const uint8_t* ptr = trace->data + trace->pos;
+    const uint32_t num_cycles = (uint32_t) _lockstep_get(ptr, 4);
+    const int num_regs = (int) _lockstep_get(ptr + 4, 1);
+    const int num_recorded = (num_cycles < LOCKSTEP_MAX_CYCLES) ? (int)num_cycles : LOCKSTEP_MAX_CYCLES;
+    const int item_size = 5 + num_recorded*8 + num_regs*4;
+    if ((num_cycles > 0x7FFFFFFF) || (num_regs > LOCKSTEP_MAX_REGS) || (item_size > avail)) {
+        state->end = true;
+        return;
+    }
+    ptr += 5;
+    state->num_cycles = (int) num_cycles;
+    for (int i = 0; i < num_recorded; i++, ptr += 8) {
+        state->pins[i] = _lockstep_get(ptr, 8);
+    }
+    state->num_regs = num_regs;
+    for (int i = 0; i < num_regs; i++, ptr += 4) {
+        state->regs[i] = (uint32_t) _lockstep_get(ptr, 4);
+    }
+    trace->pos += item_size;
+}
+
+lockstep_core_t lockstep_trace_core(lockstep_trace_t* trace) {
+    CHIPS_ASSERT(trace && trace->data);
+    trace->pos = 0;
+    lockstep_core_t core = { _lockstep_trace_step, trace };
+    return core;
+}
+
+/*=== Z80 adapter ============================================================*/
+#if defined(LOCKSTEP_USE_Z80)
+static uint64_t _lockstep_z80_tick(int num_ticks, uint64_t pins, void* user_data) {
+    lockstep_z80_t* sys = (lockstep_z80_t*) user_data;
+    const uint16_t addr = Z80_GET_ADDR(pins);
+    if (pins & Z80_MREQ) {
+        if (pins & Z80_RD) {
+            Z80_SET_DATA(pins, sys->mem[addr]);
+        }
+        else if (pins & Z80_WR) {
+            sys->mem[addr] = Z80_GET_DATA(pins);
+        }
+    }
+    else if ((pins & Z80_IORQ) && (pins & (Z80_RD|Z80_M1))) {
+        Z80_SET_DATA(pins, 0xFF);
+    }
+    if (sys->state) {
+        lockstep_bus(sys->state, (pins & Z80_PIN_MASK) | (((uint64_t)num_ticks) << LOCKSTEP_Z80_TICKS_SHIFT));
+    }
+    return pins;
+}
+
+static void _lockstep_z80_step(lockstep_state_t* state, void* user_data) {
+    lockstep_z80_t* sys = (lockstep_z80_t*) user_data;
+    z80_t* cpu = &sys->cpu;
+    sys->state = state;
+    do {
+        sys->funcs.exec(cpu, 1);
+    } while (!z80_opdone(cpu));
+    sys->state = 0;
+    lockstep_reg(state, z80_af(cpu));
+    lockstep_reg(state, z80_bc(cpu));
+    lockstep_reg(state, z80_de(cpu));
+    lockstep_reg(state, z80_hl(cpu));
+    lockstep_reg(state, z80_af_(cpu));
+    lockstep_reg(state, z80_bc_(cpu));
+    lockstep_reg(state, z80_de_(cpu));
+    lockstep_reg(state, z80_hl_(cpu));
+    lockstep_reg(state, z80_ix(cpu));
+    lockstep_reg(state, z80_iy(cpu));
+    lockstep_reg(state, z80_sp(cpu));
+    lockstep_reg(state, z80_pc(cpu));
+    lockstep_reg(state, z80_wz(cpu));
+    lockstep_reg(state, z80_i(cpu));
+    lockstep_reg(state, z80_r(cpu));
+    lockstep_reg(state, (uint32_t)(z80_im(cpu) << 4) | (z80_ei_pending(cpu) ? 4 : 0) | (z80_iff2(cpu) ? 2 : 0) | (z80_iff1(cpu) ? 1 : 0));
+}
+
+void lockstep_z80_init(lockstep_z80_t* sys, const lockstep_z80_desc_t* desc) {
+    CHIPS_ASSERT(sys && desc);
+    CHIPS_ASSERT((desc->mem_size >= 0) && ((desc->mem_addr + desc->mem_size) <= (int)sizeof(sys->mem)));
+    CHIPS_ASSERT((desc->funcs.init == 0) == (desc->funcs.exec == 0));
+    memset(sys, 0, sizeof(*sys));
+    if (desc->funcs.init) {
+        sys->funcs = desc->funcs;
+    }
+    else {
+        sys->funcs.init = z80_init;
+        sys->funcs.exec = z80_exec;
+    }
+    if (desc->mem) {
+        memcpy(&sys->mem[desc->mem_addr], desc->mem, (size_t)desc->mem_size);
+    }
+    z80_desc_t cpu_desc;
+    memset(&cpu_desc, 0, sizeof(cpu_desc));
+    cpu_desc.tick_cb = _lockstep_z80_tick;
+    cpu_desc.user_data = sys;
+    sys->funcs.init(&sys->cpu, &cpu_desc);
+    z80_set_pc(&sys->cpu, desc->pc);
+}
+
+lockstep_core_t lockstep_z80_core(lockstep_z80_t* sys) {
+    CHIPS_ASSERT(sys && sys->funcs.exec);
+    lockstep_core_t core = { _lockstep_z80_step, sys };
+    return core;
+}
+
+const char** lockstep_z80_reg_names(void) {
+    static const char* names[LOCKSTEP_Z80_NUM_REGS] = {
+        "AF", "BC", "DE", "HL", "AF'", "BC'", "DE'", "HL'",
+        "IX", "IY", "SP", "PC", "WZ", "I", "R", "IM/IFF"
+    };
+    return names;
+}
+#endif /* LOCKSTEP_USE_Z80 */
+
+/*=== 6502 adapter ===========================================================*/
+#if defined(LOCKSTEP_USE_M6502)
+static uint64_t _lockstep_m6502_tick(lockstep_m6502_t* sys, uint64_t pins) {
+    pins = sys->funcs.tick(&sys->cpu, pins);
+    const uint16_t addr = M6502_GET_ADDR(pins);
+    if (pins & M6502_RW) {
+        M6502_SET_DATA(pins, sys->mem[addr]);
+    }
+    else {
+        sys->mem[addr] = M6502_GET_DATA(pins);
+    }
+    return pins;
+}
+
+static void _lockstep_m6502_step(lockstep_state_t* state, void* user_data) {
+    lockstep_m6502_t* sys = (lockstep_m6502_t*) user_data;
+    m6502_t* cpu = &sys->cpu;
+    /* a jammed CPU never reaches the next SYNC, so cap the step length */
+    do {
+        sys->pins = _lockstep_m6502_tick(sys, sys->pins);
+        lockstep_bus(state, sys->pins & M6502_PIN_MASK);
+    } while (!(sys->pins & M6502_SYNC) && (state->num_cycles < LOCKSTEP_MAX_CYCLES));
+    lockstep_reg(state, m6502_a(cpu));
+    lockstep_reg(state, m6502_x(cpu));
+    lockstep_reg(state, m6502_y(cpu));
+    lockstep_reg(state, m6502_s(cpu));
+    lockstep_reg(state, m6502_p(cpu));
+    lockstep_reg(state, m6502_pc(cpu));
+}
+
+void lockstep_m6502_init(lockstep_m6502_t* sys, const lockstep_m6502_desc_t* desc) {
+    CHIPS_ASSERT(sys && desc);
+    CHIPS_ASSERT((desc->mem_size >= 0) && ((desc->mem_addr + desc->mem_size) <= (int)sizeof(sys->mem)));
+    CHIPS_ASSERT((desc->funcs.init == 0) == (desc->funcs.tick == 0));
+    memset(sys, 0, sizeof(*sys));
+    if (desc->funcs.init) {
+        sys->funcs = desc->funcs;
+    }
+    else {
+        sys->funcs.init = m6502_init;
+        sys->funcs.tick = m6502_tick;
+    }
+    if (desc->mem) {
+        memcpy(&sys->mem[desc->mem_addr], desc->mem, (size_t)desc->mem_size);
+    }
+    if (desc->pc != 0) {
+        sys->mem[0xFFFC] = (uint8_t) desc->pc;
+        sys->mem[0xFFFD] = (uint8_t) (desc->pc >> 8);
+    }
+    m6502_desc_t cpu_desc;
+    memset(&cpu_desc, 0, sizeof(cpu_desc));
+    sys->pins = sys->funcs.init(&sys->cpu, &cpu_desc);
+    /* run the reset sequence up to the first opcode fetch, the pins
+       returned by m6502_init() already have SYNC set, so tick at least once
+    */
+    int i = 0;
+    do {
+        sys->pins = _lockstep_m6502_tick(sys, sys->pins);
+    } while (!(sys->pins & M6502_SYNC) && (++i < LOCKSTEP_MAX_CYCLES));
+}
+
+lockstep_core_t lockstep_m6502_core(lockstep_m6502_t* sys) {
+    CHIPS_ASSERT(sys && sys->funcs.tick);
+    lockstep_core_t core = { _lockstep_m6502_step, sys };
+    return core;
+}
+
+const char** lockstep_m6502_reg_names(void) {
+    static const char* names[LOCKSTEP_M6502_NUM_REGS] = {
+        "A", "X", "Y", "S", "P", "PC"
+    };
+    return names;
+}
+#endif /* LOCKSTEP_USE_M6502 */
+#endif /* CHIPS_IMPL */
@@ -43,6 +43,17 @@
 
     Undocumented instructions are supported and are marked with a '*'.
 
+    To only get the length of an instruction in bytes (for instance to
+    track instruction boundaries in a debugger), call:
+
+    ~~~C
+    int m6502dasm_oplen(m6502dasm_input_t in_cb, void* user_data)
+    ~~~
+
+    This only reads the opcode byte through the input callback and looks
+    up the length in a table, the result is the same as the pc difference
+    after calling m6502dasm_op().
+
     ## zlib/libpng license
 
     Copyright (c) 2018 Andre Weissflog
@@ -75,6 +86,8 @@ typedef void (*m6502dasm_output_t)(char c, void* user_data);
 
 /* disassemble a single 6502 instruction into a stream of ASCII characters */
 uint16_t m6502dasm_op(uint16_t pc, m6502dasm_input_t in_cb, m6502dasm_output_t out_cb, void* user_data);
+/* get the length of a single 6502 instruction in bytes without disassembling it */
+int m6502dasm_oplen(m6502dasm_input_t in_cb, void* user_data);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -191,6 +204,26 @@ static uint8_t _m6502dasm_ops[4][8][8] = {
 
 static const char* _m6502dasm_hex = "0123456789ABCDEF";
 
+/* instruction lengths in bytes */
+static const uint8_t _m6502dasm_len[256] = {
+    1,2,1,2,2,2,2,2,1,2,1,1,3,3,3,3,  /* 00 */
+    2,2,1,2,2,2,2,2,1,3,1,3,3,3,3,3,  /* 10 */
+    3,2,1,2,2,2,2,2,1,2,1,1,3,3,3,3,  /* 20 */
+    2,2,1,2,2,2,2,2,1,3,1,3,3,3,3,3,  /* 30 */
+    1,2,1,2,2,2,2,2,1,2,1,1,3,3,3,3,  /* 40 */
+    2,2,1,2,2,2,2,2,1,3,1,3,3,3,3,3,  /* 50 */
+    1,2,1,2,2,2,2,2,1,2,1,1,3,3,3,3,  /* 60 */
+    2,2,1,2,2,2,2,2,1,3,1,3,3,3,3,3,  /* 70 */
+    2,2,2,2,2,2,2,2,1,2,1,1,3,3,3,3,  /* 80 */
+    2,2,1,1,2,2,2,2,1,3,1,1,1,3,1,1,  /* 90 */
+    2,2,2,2,2,2,2,2,1,2,1,1,3,3,3,3,  /* A0 */
+    2,2,1,2,2,2,2,2,1,3,1,1,3,3,3,3,  /* B0 */
+    2,2,2,2,2,2,2,2,1,2,1,1,3,3,3,3,  /* C0 */
+    2,2,1,2,2,2,2,2,1,3,1,3,3,3,3,3,  /* D0 */
+    2,2,2,2,2,2,2,2,1,2,1,2,3,3,3,3,  /* E0 */
+    2,2,1,2,2,2,2,2,1,3,1,3,3,3,3,3  /* F0 */
+};
+
 /* helper function to output string */
 static void _m6502dasm_str(const char* str, m6502dasm_output_t out_cb, void* user_data) {
     if (out_cb) {
@@ -458,6 +491,11 @@ uint16_t m6502dasm_op(uint16_t pc, m6502dasm_input_t in_cb, m6502dasm_output_t o
     return pc;
 }
 
+int m6502dasm_oplen(m6502dasm_input_t in_cb, void* user_data) {
+    CHIPS_ASSERT(in_cb);
+    return _m6502dasm_len[in_cb(user_data)];
+}
+
 #undef _FETCH_I8
 #undef _FETCH_U8
 #undef _FETCH_U16
@@ -0,0 +1,806 @@
+#pragma once
+/*#
+    # romdasm.h
+
+    Static bulk disassembler for Z80 and 6502 memory images which
+    separates code from data and writes an assembler-compatible listing.
+
+    Do this:
+    ~~~C
+    #define CHIPS_IMPL
+    ~~~
+    before you include this file in *one* C or C++ file to create the
+    implementation.
+
+    Select the supported CPUs with the following macros (at least
+    one must be defined):
+
+    ROMDASM_USE_Z80
+    ROMDASM_USE_M6502
+
+    Optionally provide the following macros with your own implementation
+
+    ~~~C
+    CHIPS_ASSERT(c)
+    ~~~
+        your own assert macro (default: assert(c))
+
+    ~~~C
+    CHIPS_REALLOC(ptr, size)
+    CHIPS_FREE(ptr)
+    ~~~
+        your own memory allocation functions (default: realloc and free),
+        only used for the listing text buffer
+
+    You need to include the following headers before including the
+    *implementation*:
+
+        - z80dasm.h     (only if ROMDASM_USE_Z80 is defined)
+        - m6502dasm.h   (only if ROMDASM_USE_M6502 is defined)
+
+    ## Overview
+
+    z80dasm.h and m6502dasm.h disassemble one instruction at a time, which
+    is what a debugger UI needs. romdasm.h works on an entire 64 KByte
+    memory image instead:
+
+    - starting at a set of entry points, the control flow is traced
+      through jumps, branches and calls, every byte reached this way is
+      marked as code, everything else is data
+    - the targets of jumps, branches and calls become labels
+    - finally an assembler-compatible listing is written into a
+      growable text buffer, code is disassembled with the label names
+      substituted for target addresses, and data is written as DB
+      (Z80) or .byte (6502) lines
+
+    The default entry points are the reset, NMI and IRQ vectors at FFFA..FFFF
+    for the 6502, and the reset address 0000, the RST vectors and the
+    NMI address 0066 for the Z80.
+
+    Computed jumps (JP (HL), JMP (ind)) and jump tables can't be followed
+    statically. To catch this code, add the addresses which have actually
+    been executed at runtime as additional entry points, for instance from
+    the execution counters of the ui_dbg.h heatmap:
+
+    ~~~C
+    for (int addr = 0; addr < (1<<16); addr++) {
+        if (ui_dbg.heatmap.items[addr].op_count > 0) {
+            romdasm_add_entry(&dasm, (uint16_t)addr);
+        }
+    }
+    ~~~
+
+    Instructions which a standard assembler wouldn't accept or would
+    encode differently are written as data bytes with the disassembled
+    instruction in a comment, so that the listing assembles back
+    into the original binary. These are:
+
+    - undocumented and invalid 6502 instructions
+    - Z80 DD/FD prefixes which don't modify the following instruction,
+      a DD/FD prefix followed by another DD, FD or ED is written as a
+      single data byte, and the next instruction starts at the second
+      prefix
+    - unassigned Z80 ED instructions
+    - the Z80 ED duplicates of NEG, IM, RETN, LD (nn),HL and LD HL,(nn)
+    - IN (C), OUT (C),0 and SLL
+    - the undocumented DD/FD CB instructions with a register result
+
+    ## Usage
+
+    ~~~C
+    static romdasm_t dasm;
+    romdasm_init(&dasm, &(romdasm_desc_t){
+        .cpu = ROMDASM_CPU_Z80,
+        .mem = mem_image,           // pointer to 64 KBytes
+        .start_addr = 0x0000,       // start and size of the listing,
+        .num_bytes = 0x4000,        // default is everything from start_addr
+    });
+    // optionally add more entry points
+    romdasm_add_entry(&dasm, 0x0100);
+    // trace the code and write the listing
+    romdasm_run(&dasm);
+    fwrite(dasm.listing, 1, dasm.listing_size, fp);
+    ...
+    romdasm_discard(&dasm);
+    ~~~
+
+    After romdasm_run() the code/data map can be inspected through
+    dasm.map[addr], which is a combination of the following bits:
+
+        ROMDASM_FLAG_CODE       - the byte is part of an instruction
+        ROMDASM_FLAG_OPSTART    - the byte is the first byte of an instruction
+        ROMDASM_FLAG_LABEL      - the address is an entry point or the target
+                                  of a jump, branch or call
+        ROMDASM_FLAG_ENTRY      - the address is an entry point
+        ROMDASM_FLAG_LINE       - the address starts a line in the listing
+
+    A label is only written into the listing if the labelled address starts
+    a line in the listing (overlapping instructions and targets outside
+    the listing range keep their numeric addresses).
+
+    ## Functions
+
+    ~~~C
+    void romdasm_init(romdasm_t* dasm, const romdasm_desc_t* desc)
+    ~~~
+        Initialize a romdasm_t instance, this adds the default entry points
+        unless desc->no_vectors is true. The memory image must remain
+        valid until romdasm_run() has been called.
+
+    ~~~C
+    void romdasm_add_entry(romdasm_t* dasm, uint16_t addr)
+    ~~~
+        Add an entry point, call before romdasm_run().
+
+    ~~~C
+    void romdasm_run(romdasm_t* dasm)
+    ~~~
+        Trace the code from all entry points and write the listing into
+        dasm->listing (a zero-terminated string of dasm->listing_size
+        characters).
+
+    ~~~C
+    void romdasm_discard(romdasm_t* dasm)
+    ~~~
+        Free the listing buffer.
+
+    ## zlib/libpng license
+
+    Copyright (c) 2026 Andre Weissflog
+    This software is provided 'as-is', without any express or implied warranty.
+    In no event will the authors be held liable for any damages arising from the
+    use of this software.
+    Permission is granted to anyone to use this software for any purpose,
+    including commercial applications, and to alter it and redistribute it
+    freely, subject to the following restrictions:
+        1. The origin of this software must not be misrepresented; you must not
+        claim that you wrote the original software. If you use this software in a
+        product, an acknowledgment in the product documentation would be
+        appreciated but is not required.
+        2. Altered source versions must be plainly marked as such, and must not
+        be misrepresented as being the original software.
+        3. This notice may not be removed or altered from any source
+        distribution.
+#*/
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* code/data map bits */
+#define ROMDASM_FLAG_CODE       (1<<0)
+#define ROMDASM_FLAG_OPSTART    (1<<1)
+#define ROMDASM_FLAG_LABEL      (1<<2)
+#define ROMDASM_FLAG_ENTRY      (1<<3)
+#define ROMDASM_FLAG_LINE       (1<<4)
+
+/* the CPU type of the memory image */
+typedef enum {
+    ROMDASM_CPU_Z80,
+    ROMDASM_CPU_M6502,
+} romdasm_cpu_t;
+
+/* config parameters for romdasm_init() */
+typedef struct {
+    romdasm_cpu_t cpu;
+    const uint8_t* mem;         /* pointer to a 64 KByte memory image */
+    uint16_t start_addr;        /* first address in the listing */
+    int num_bytes;              /* number of bytes in the listing, default is 0x10000 - start_addr */
+    bool no_vectors;            /* if true, don't add the default entry points */
+} romdasm_desc_t;
+
+/* romdasm state */
+typedef struct {
+    romdasm_cpu_t cpu;
+    const uint8_t* mem;
+    uint32_t start_addr;
+    uint32_t end_addr;          /* one past the last listing address */
+    int num_work;
+    uint16_t work[1<<16];       /* stack of addresses to trace */
+    uint8_t map[1<<16];         /* code/data map, ROMDASM_FLAG_* bits */
+    /* the listing, a zero-terminated string */
+    char* listing;
+    int listing_size;
+    int listing_capacity;
+    /* the current line */
+    char line[128];
+    int line_pos;
+} romdasm_t;
+
+/* initialize a new romdasm instance */
+void romdasm_init(romdasm_t* dasm, const romdasm_desc_t* desc);
+/* add an entry point */
+void romdasm_add_entry(romdasm_t* dasm, uint16_t addr);
+/* trace the code and write the listing */
+void romdasm_run(romdasm_t* dasm);
+/* free the listing */
+void romdasm_discard(romdasm_t* dasm);
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/*-- IMPLEMENTATION ----------------------------------------------------------*/
+#ifdef CHIPS_IMPL
+#if !defined(ROMDASM_USE_Z80) && !defined(ROMDASM_USE_M6502)
+#error "please define ROMDASM_USE_Z80 and/or ROMDASM_USE_M6502"
+#endif
+#include <string.h>
+#ifndef CHIPS_ASSERT
+    #include <assert.h>
+    #define CHIPS_ASSERT(c) assert(c)
+#endif
+#ifndef CHIPS_REALLOC
+    #include <stdlib.h>
+    #define CHIPS_REALLOC(ptr, size) realloc(ptr, size)
+    #define CHIPS_FREE(ptr) free(ptr)
+#endif
+
+#define _ROMDASM_MAX_DATA_BYTES (8)
+#define _ROMDASM_COMMENT_COLUMN (32)
+
+/* control flow properties of a single instruction */
+typedef struct {
+    int len;
+    bool falls_through;     /* execution continues with the next instruction */
+    bool has_target;        /* target is a jump, branch or call target */
+    bool target_operand;    /* target appears as address operand in the disassembly */
+    uint16_t target;
+} _romdasm_op_t;
+
+static const char* _romdasm_hex = "0123456789ABCDEF";
+
+static inline uint8_t _romdasm_rd(const romdasm_t* dasm, uint32_t addr) {
+    return dasm->mem[addr & 0xFFFF];
+}
+
+static inline uint16_t _romdasm_rd16(const romdasm_t* dasm, uint32_t addr) {
+    return (uint16_t)(_romdasm_rd(dasm, addr) | (_romdasm_rd(dasm, addr + 1) << 8));
+}
+
+/* context for the callbacks of the single-instruction disassemblers */
+typedef struct {
+    const romdasm_t* dasm;
+    uint32_t addr;
+    char* text;
+    int pos;
+    int size;
+} _romdasm_ctx_t;
+
+static uint8_t _romdasm_in_cb(void* user_data) {
+    _romdasm_ctx_t* ctx = (_romdasm_ctx_t*) user_data;
+    return _romdasm_rd(ctx->dasm, ctx->addr++);
+}
+
+static void _romdasm_out_cb(char c, void* user_data) {
+    _romdasm_ctx_t* ctx = (_romdasm_ctx_t*) user_data;
+    if (ctx->pos < (ctx->size - 1)) {
+        ctx->text[ctx->pos++] = c;
+    }
+}
+
+/* append a character to the current listing line */
+static void _romdasm_chr(romdasm_t* dasm, char c) {
+    if (dasm->line_pos < (int)(sizeof(dasm->line) - 1)) {
+        dasm->line[dasm->line_pos++] = c;
+    }
+}
+
+#if defined(ROMDASM_USE_Z80)
+static void _romdasm_z80_op(const romdasm_t* dasm, uint16_t addr, _romdasm_op_t* op) {
+    _romdasm_ctx_t ctx = { dasm, addr, 0, 0, 0 };
+    op->len = z80dasm_oplen(_romdasm_in_cb, &ctx);
+    op->falls_through = true;
+    op->has_target = false;
+    op->target_operand = true;
+    op->target = 0;
+    /* DD/FD prefixes don't change the control flow of the following opcode */
+    uint32_t p = addr;
+    uint8_t o = _romdasm_rd(dasm, p);
+    if ((o == 0xDD) || (o == 0xFD)) {
+        o = _romdasm_rd(dasm, ++p);
+        if ((o == 0xDD) || (o == 0xED) || (o == 0xFD)) {
+            /* the prefix acts as a NOP, the next instruction starts at the second prefix */
+            op->len = 1;
+            return;
+        }
+    }
+    if (o == 0xED) {
+        /* RETN/RETI */
+        if ((p == addr) && ((_romdasm_rd(dasm, p + 1) & 0xC7) == 0x45)) {
+            op->falls_through = false;
+        }
+        return;
+    }
+    switch (o) {
+        /* DJNZ, JR cc */
+        case 0x10: case 0x20: case 0x28: case 0x30: case 0x38:
+            op->has_target = true;
+            op->target = (uint16_t)(addr + op->len + (int8_t)_romdasm_rd(dasm, p + 1));
+            return;
+        /* JR */
+        case 0x18:
+            op->has_target = true;
+            op->falls_through = false;
+            op->target = (uint16_t)(addr + op->len + (int8_t)_romdasm_rd(dasm, p + 1));
+            return;
+        /* JP nn */
+        case 0xC3:
+            op->has_target = true;
+            op->falls_through = false;
+            op->target = _romdasm_rd16(dasm, p + 1);
+            return;
+        /* CALL nn */
+        case 0xCD:
+            op->has_target = true;
+            op->target = _romdasm_rd16(dasm, p + 1);
+            return;
+        /* RET, JP (HL/IX/IY) */
+        case 0xC9: case 0xE9:
+            op->falls_through = false;
+            return;
+        default:
+            break;
+    }
+    switch (o & 0xC7) {
+        /* JP cc,nn and CALL cc,nn */
+        case 0xC2: case 0xC4:
+            op->has_target = true;
+            op->target = _romdasm_rd16(dasm, p + 1);
+            break;
+        /* RST p */
+        case 0xC7:
+            op->has_target = true;
+            op->target_operand = false;
+            op->target = o & 0x38;
+            break;
+        default:
+            break;
+    }
+}
+#endif
+
+#if defined(ROMDASM_USE_M6502)
+static void _romdasm_m6502_op(const romdasm_t* dasm, uint16_t addr, _romdasm_op_t* op) {
+    _romdasm_ctx_t ctx = { dasm, addr, 0, 0, 0 };
+    op->len = m6502dasm_oplen(_romdasm_in_cb, &ctx);
+    op->falls_through = true;
+    op->has_target = false;
+    op->target_operand = true;
+    op->target = 0;
+    const uint8_t o = _romdasm_rd(dasm, addr);
+    if ((o & 0x1F) == 0x10) {
+        /* conditional relative branches */
+        op->has_target = true;
+        op->target = (uint16_t)(addr + 2 + (int8_t)_romdasm_rd(dasm, addr + 1));
+        return;
+    }
+    switch (o) {
+        /* JMP abs */
+        case 0x4C:
+            op->has_target = true;
+            op->falls_through = false;
+            op->target = _romdasm_rd16(dasm, addr + 1);
+            break;
+        /* JSR */
+        case 0x20:
+            op->has_target = true;
+            op->target = _romdasm_rd16(dasm, addr + 1);
+            break;
+        /* BRK, RTI, RTS, JMP (ind) */
+        case 0x00: case 0x40: case 0x60: case 0x6C:
+            op->falls_through = false;
+            break;
+        /* undocumented JAM instructions halt the CPU */
+        case 0x02: case 0x12: case 0x22: case 0x32: case 0x42: case 0x52:
+        case 0x62: case 0x72: case 0x92: case 0xB2: case 0xD2: case 0xF2:
+            op->falls_through = false;
+            break;
+        default:
+            break;
+    }
+}
+#endif
+
+static void _romdasm_op(const romdasm_t* dasm, uint16_t addr, _romdasm_op_t* op) {
+    #if defined(ROMDASM_USE_Z80) && defined(ROMDASM_USE_M6502)
+    if (dasm->cpu == ROMDASM_CPU_Z80) {
+        _romdasm_z80_op(dasm, addr, op);
+    }
+    else {
+        _romdasm_m6502_op(dasm, addr, op);
+    }
+    #elif defined(ROMDASM_USE_Z80)
+    _romdasm_z80_op(dasm, addr, op);
+    #else
+    _romdasm_m6502_op(dasm, addr, op);
+    #endif
+}
+
+void romdasm_init(romdasm_t* dasm, const romdasm_desc_t* desc) {
+    CHIPS_ASSERT(dasm && desc && desc->mem);
+    CHIPS_ASSERT((desc->num_bytes >= 0) && ((desc->start_addr + desc->num_bytes) <= 0x10000));
+    #if !defined(ROMDASM_USE_Z80)
+    CHIPS_ASSERT(desc->cpu != ROMDASM_CPU_Z80);
+    #endif
+    #if !defined(ROMDASM_USE_M6502)
+    CHIPS_ASSERT(desc->cpu != ROMDASM_CPU_M6502);
+    #endif
+    memset(dasm, 0, sizeof(romdasm_t));
+    dasm->cpu = desc->cpu;
+    dasm->mem = desc->mem;
+    dasm->start_addr = desc->start_addr;
+    dasm->end_addr = desc->start_addr + ((desc->num_bytes > 0) ? (uint32_t)desc->num_bytes : (uint32_t)(0x10000 - desc->start_addr));
+    if (!desc->no_vectors) {
+        if (dasm->cpu == ROMDASM_CPU_Z80) {
+            /* reset address, RST vectors and NMI */
+            for (uint16_t addr = 0x00; addr <= 0x38; addr += 8) {
+                romdasm_add_entry(dasm, addr);
+            }
+            romdasm_add_entry(dasm, 0x0066);
+        }
+        else {
+            /* NMI, reset and IRQ vectors */
+            for (uint16_t vec = 0xFFFA; vec != 0; vec += 2) {
+                romdasm_add_entry(dasm, _romdasm_rd16(dasm, vec));
+            }
+        }
+    }
+}
+
+void romdasm_add_entry(romdasm_t* dasm, uint16_t addr) {
+    CHIPS_ASSERT(dasm);
+    dasm->map[addr] |= ROMDASM_FLAG_ENTRY;
+    /* each address is only pushed once, so the work stack can't overflow */
+    if (0 == (dasm->map[addr] & ROMDASM_FLAG_LABEL)) {
+        dasm->map[addr] |= ROMDASM_FLAG_LABEL;
+        dasm->work[dasm->num_work++] = addr;
+    }
+}
+
+/* follow the control flow from all entry points and mark code bytes */
+static void _romdasm_trace(romdasm_t* dasm) {
+    _romdasm_op_t op;
+    while (dasm->num_work > 0) {
+        uint32_t addr = dasm->work[--dasm->num_work];
+        while (0 == (dasm->map[addr] & ROMDASM_FLAG_OPSTART)) {
+            _romdasm_op(dasm, (uint16_t)addr, &op);
+            if ((addr + op.len) > 0x10000) {
+                /* don't wrap around at the end of the address space */
+                break;
+            }
+            dasm->map[addr] |= ROMDASM_FLAG_OPSTART;
+            for (int i = 0; i < op.len; i++) {
+                dasm->map[addr + i] |= ROMDASM_FLAG_CODE;
+            }
+            if (op.has_target && (0 == (dasm->map[op.target] & ROMDASM_FLAG_LABEL))) {
+                dasm->map[op.target] |= ROMDASM_FLAG_LABEL;
+                dasm->work[dasm->num_work++] = op.target;
+            }
+            if (!op.falls_through) {
+                break;
+            }
+            addr += op.len;
+            if (addr >= 0x10000) {
+                break;
+            }
+        }
+    }
+}
+
+/* decide where the lines in the listing start, this must happen before
+   writing the listing to know which labels will exist
+*/
+static void _romdasm_layout(romdasm_t* dasm) {
+    _romdasm_op_t op;
+    uint32_t addr = dasm->start_addr;
+    while (addr < dasm->end_addr) {
+        dasm->map[addr] |= ROMDASM_FLAG_LINE;
+        if (dasm->map[addr] & ROMDASM_FLAG_OPSTART) {
+            _romdasm_op(dasm, (uint16_t)addr, &op);
+            if ((addr + op.len) <= dasm->end_addr) {
+                addr += op.len;
+                continue;
+            }
+        }
+        /* a data line ends before code, a label or after max bytes */
+        int num = 1;
+        addr++;
+        while ((addr < dasm->end_addr) && (num < _ROMDASM_MAX_DATA_BYTES) &&
+               (0 == (dasm->map[addr] & (ROMDASM_FLAG_OPSTART|ROMDASM_FLAG_LABEL))))
+        {
+            addr++;
+            num++;
+        }
+    }
+}
+
+static void _romdasm_reserve(romdasm_t* dasm, int num_chars) {
+    if ((dasm->listing_size + num_chars + 1) > dasm->listing_capacity) {
+        int capacity = (dasm->listing_capacity > 0) ? dasm->listing_capacity : (64 * 1024);
+        while ((dasm->listing_size + num_chars + 1) > capacity) {
+            capacity *= 2;
+        }
+        dasm->listing = (char*) CHIPS_REALLOC(dasm->listing, (size_t)capacity);
+        CHIPS_ASSERT(dasm->listing);
+        dasm->listing_capacity = capacity;
+    }
+}
+
+/* append the current line to the listing */
+static void _romdasm_flush_line(romdasm_t* dasm) {
+    _romdasm_reserve(dasm, dasm->line_pos + 1);
+    memcpy(dasm->listing + dasm->listing_size, dasm->line, (size_t)dasm->line_pos);
+    dasm->listing_size += dasm->line_pos;
+    dasm->listing[dasm->listing_size++] = '\n';
+    dasm->listing[dasm->listing_size] = 0;
+    dasm->line_pos = 0;
+}
+
+static void _romdasm_put(romdasm_t* dasm, const char* str) {
+    while (*str) {
+        _romdasm_chr(dasm, *str++);
+    }
+}
+
+static void _romdasm_pad(romdasm_t* dasm, int column) {
+    do {
+        _romdasm_chr(dasm, ' ');
+    } while (dasm->line_pos < column);
+}
+
+/* write an 8- or 16-bit value in the CPU's assembler syntax */
+static void _romdasm_hexval(romdasm_t* dasm, uint32_t val, int num_digits) {
+    if (dasm->cpu == ROMDASM_CPU_M6502) {
+        _romdasm_chr(dasm, '$');
+    }
+    else if (((val >> ((num_digits - 1) * 4)) & 0xF) > 9) {
+        /* Z80 hex numbers must start with a digit */
+        _romdasm_chr(dasm, '0');
+    }
+    for (int i = num_digits - 1; i >= 0; i--) {
+        _romdasm_chr(dasm, _romdasm_hex[(val >> (i * 4)) & 0xF]);
+    }
+    if (dasm->cpu == ROMDASM_CPU_Z80) {
+        _romdasm_chr(dasm, 'h');
+    }
+}
+
+static void _romdasm_label(romdasm_t* dasm, uint16_t addr) {
+    _romdasm_chr(dasm, 'L');
+    for (int i = 3; i >= 0; i--) {
+        _romdasm_chr(dasm, _romdasm_hex[(addr >> (i * 4)) & 0xF]);
+    }
+}
+
+/* true if a label for addr exists in the listing */
+static bool _romdasm_has_label(const romdasm_t* dasm, uint16_t addr) {
+    const uint8_t mask = ROMDASM_FLAG_LABEL|ROMDASM_FLAG_LINE;
+    return ((dasm->map[addr] & mask) == mask) && (addr >= dasm->start_addr) && (addr < dasm->end_addr);
+}
+
+/* start a new line with an optional label */
+static void _romdasm_begin_line(romdasm_t* dasm, uint16_t addr) {
+    if (_romdasm_has_label(dasm, addr)) {
+        _romdasm_label(dasm, addr);
+        _romdasm_chr(dasm, ':');
+    }
+    _romdasm_pad(dasm, 8);
+}
+
+/* append the address and bytes as comment and flush the line */
+static void _romdasm_end_line(romdasm_t* dasm, uint32_t addr, int num_bytes, const char* text) {
+    _romdasm_pad(dasm, _ROMDASM_COMMENT_COLUMN);
+    _romdasm_put(dasm, "; ");
+    for (int i = 3; i >= 0; i--) {
+        _romdasm_chr(dasm, _romdasm_hex[(addr >> (i * 4)) & 0xF]);
+    }
+    _romdasm_chr(dasm, ':');
+    for (int i = 0; i < num_bytes; i++) {
+        const uint8_t val = _romdasm_rd(dasm, addr + i);
+        _romdasm_chr(dasm, ' ');
+        _romdasm_chr(dasm, _romdasm_hex[val >> 4]);
+        _romdasm_chr(dasm, _romdasm_hex[val & 0xF]);
+    }
+    if (text) {
+        _romdasm_put(dasm, "  ");
+        _romdasm_put(dasm, text);
+    }
+    _romdasm_flush_line(dasm);
+}
+
+/* write a line of data bytes */
+static void _romdasm_data_line(romdasm_t* dasm, uint32_t addr, int num_bytes, const char* text) {
+    _romdasm_begin_line(dasm, (uint16_t)addr);
+    _romdasm_put(dasm, (dasm->cpu == ROMDASM_CPU_Z80) ? "DB " : ".byte ");
+    for (int i = 0; i < num_bytes; i++) {
+        if (i > 0) {
+            _romdasm_chr(dasm, ',');
+        }
+        _romdasm_hexval(dasm, _romdasm_rd(dasm, addr + i), 2);
+    }
+    _romdasm_end_line(dasm, addr, num_bytes, text);
+}
+
+/* ED ops which assemble back into the same bytes, the duplicates of
+   NEG, IM, RETN and LD (nn),HL / LD HL,(nn) are printed with the
+   mnemonic of the original, IN (C) and OUT (C),0 aren't accepted by
+   many assemblers
+*/
+static bool _romdasm_z80_ed_valid(uint8_t op) {
+    switch (op) {
+        case 0x63: case 0x6B:               /* LD (nn),HL / LD HL,(nn) */
+        case 0x4C: case 0x54: case 0x5C:    /* NEG */
+        case 0x64: case 0x6C: case 0x74: case 0x7C:
+        case 0x4E: case 0x66: case 0x6E:    /* IM */
+        case 0x76: case 0x7E:
+        case 0x55: case 0x5D: case 0x65:    /* RETN */
+        case 0x6D: case 0x75: case 0x7D:
+        case 0x70: case 0x71:               /* IN (C) / OUT (C),0 */
+            return false;
+        default:
+            return true;
+    }
+}
+
+/* disassemble an instruction into text, returns false if a standard assembler wouldn't accept it */
+static bool _romdasm_disasm(const romdasm_t* dasm, uint16_t addr, char* text, int text_size) {
+    _romdasm_ctx_t ctx = { dasm, addr, text, 0, text_size };
+    #if defined(ROMDASM_USE_Z80)
+    if (dasm->cpu == ROMDASM_CPU_Z80) {
+        z80dasm_op(addr, _romdasm_in_cb, _romdasm_out_cb, &ctx);
+    }
+    #endif
+    #if defined(ROMDASM_USE_M6502)
+    if (dasm->cpu == ROMDASM_CPU_M6502) {
+        m6502dasm_op(addr, _romdasm_in_cb, _romdasm_out_cb, &ctx);
+    }
+    #endif
+    text[ctx.pos] = 0;
+    if (dasm->cpu == ROMDASM_CPU_Z80) {
+        /* a DD/FD prefix followed by another prefix is a 1-byte NOP */
+        const uint8_t pre = _romdasm_rd(dasm, addr);
+        if ((pre == 0xDD) || (pre == 0xFD)) {
+            const uint8_t next = _romdasm_rd(dasm, addr + 1);
+            if ((next == 0xDD) || (next == 0xED) || (next == 0xFD)) {
+                const char* str = "ignored prefix";
+                int i = 0;
+                for (; str[i] && (i < (text_size - 1)); i++) {
+                    text[i] = str[i];
+                }
+                text[i] = 0;
+                return false;
+            }
+        }
+        /* unassigned ED ops, and DD/FD prefixes which don't modify the instruction */
+        if (strstr(text, "(ED)")) {
+            return false;
+        }
+        if ((pre == 0xDD) && !strstr(text, "IX")) {
+            return false;
+        }
+        if ((pre == 0xFD) && !strstr(text, "IY")) {
+            return false;
+        }
+        /* undocumented DD/FD CB ops which also store the result in a register, and SLL (IX/IY+d) */
+        if (((pre == 0xDD) || (pre == 0xFD)) && (_romdasm_rd(dasm, addr + 1) == 0xCB)) {
+            const uint8_t op = _romdasm_rd(dasm, addr + 3);
+            if (((op & 7) != 6) || ((op & 0xF8) == 0x30)) {
+                return false;
+            }
+        }
+        /* SLL r */
+        if ((pre == 0xCB) && ((_romdasm_rd(dasm, addr + 1) & 0xF8) == 0x30)) {
+            return false;
+        }
+        if (pre == 0xED) {
+            return _romdasm_z80_ed_valid(_romdasm_rd(dasm, addr + 1));
+        }
+        return true;
+    }
+    else {
+        /* undocumented and invalid 6502 ops */
+        return (text[0] != '*') && (0 == strchr(text, '?'));
+    }
+}
+
+/* write an instruction, substituting the label for the target address */
+static void _romdasm_code_line(romdasm_t* dasm, uint16_t addr, const _romdasm_op_t* op) {
+    char text[sizeof(dasm->line)];
+    if (!_romdasm_disasm(dasm, addr, text, (int)sizeof(text))) {
+        _romdasm_data_line(dasm, addr, op->len, text);
+        return;
+    }
+    /* find the target address in the disassembled text */
+    const char* target_pos = 0;
+    int target_len = 0;
+    if (op->has_target && op->target_operand && _romdasm_has_label(dasm, op->target)) {
+        char str[8];
+        int i = 0;
+        if (dasm->cpu == ROMDASM_CPU_M6502) {
+            str[i++] = '$';
+        }
+        for (int shift = 12; shift >= 0; shift -= 4) {
+            str[i++] = _romdasm_hex[(op->target >> shift) & 0xF];
+        }
+        if (dasm->cpu == ROMDASM_CPU_Z80) {
+            str[i++] = 'h';
+        }
+        str[i] = 0;
+        target_pos = strstr(text, str);
+        target_len = i;
+    }
+    _romdasm_begin_line(dasm, addr);
+    const char* p = text;
+    while (*p) {
+        if (p == target_pos) {
+            _romdasm_label(dasm, op->target);
+            p += target_len;
+            continue;
+        }
+        /* Z80 hex numbers starting with a letter need a leading zero */
+        if ((dasm->cpu == ROMDASM_CPU_Z80) && (*p >= 'A') && (*p <= 'F') &&
+            ((p == text) || !(((p[-1] >= '0') && (p[-1] <= '9')) || ((p[-1] >= 'A') && (p[-1] <= 'Z')))))
+        {
+            const char* q = p;
+            while (((*q >= '0') && (*q <= '9')) || ((*q >= 'A') && (*q <= 'F'))) {
+                q++;
+            }
+            if (*q == 'h') {
+                _romdasm_chr(dasm, '0');
+            }
+        }
+        _romdasm_chr(dasm, *p++);
+    }
+    _romdasm_end_line(dasm, addr, op->len, 0);
+}
+
+/* write the listing, one line per instruction or data run */
+static void _romdasm_write(romdasm_t* dasm) {
+    _romdasm_op_t op;
+    dasm->listing_size = 0;
+    _romdasm_reserve(dasm, 0);
+    dasm->listing[0] = 0;
+    _romdasm_pad(dasm, 8);
+    _romdasm_put(dasm, (dasm->cpu == ROMDASM_CPU_Z80) ? "ORG " : ".org ");
+    _romdasm_hexval(dasm, dasm->start_addr, 4);
+    _romdasm_flush_line(dasm);
+    _romdasm_flush_line(dasm);
+    uint32_t addr = dasm->start_addr;
+    while (addr < dasm->end_addr) {
+        if (dasm->map[addr] & ROMDASM_FLAG_OPSTART) {
+            _romdasm_op(dasm, (uint16_t)addr, &op);
+            if ((addr + op.len) <= dasm->end_addr) {
+                _romdasm_code_line(dasm, (uint16_t)addr, &op);
+                addr += op.len;
+                continue;
+            }
+        }
+        uint32_t end = addr + 1;
+        while ((end < dasm->end_addr) && (0 == (dasm->map[end] & ROMDASM_FLAG_LINE))) {
+            end++;
+        }
+        _romdasm_data_line(dasm, addr, (int)(end - addr), 0);
+        addr = end;
+    }
+}
+
+void romdasm_run(romdasm_t* dasm) {
+    CHIPS_ASSERT(dasm && dasm->mem);
+    _romdasm_trace(dasm);
+    _romdasm_layout(dasm);
+    _romdasm_write(dasm);
+}
+
+void romdasm_discard(romdasm_t* dasm) {
+    CHIPS_ASSERT(dasm);
+    if (dasm->listing) {
+        CHIPS_FREE(dasm->listing);
+        dasm->listing = 0;
+    }
+    dasm->listing_size = 0;
+    dasm->listing_capacity = 0;
+}
+#endif /* CHIPS_IMPL */
@@ -44,6 +44,17 @@
     All undocumented instructions are supported, but are currently
     not marked as such.
 
+    To only get the length of an instruction in bytes (for instance to
+    track instruction boundaries in a debugger), call:
+
+    ~~~C
+    int z80dasm_oplen(z80dasm_input_t in_cb, void* user_data)
+    ~~~
+
+    This only reads the prefix and opcode bytes (at most 3) through the input
+    callback and looks up the length in tables, the result is the same
+    as the pc difference after calling z80dasm_op().
+
     ## Links
 
     The disassembler uses this decoding strategy:
@@ -81,6 +92,8 @@ typedef void (*z80dasm_output_t)(char c, void* user_data);
 
 /* disassemble a single Z80 instruction into a stream of ASCII characters */
 uint16_t z80dasm_op(uint16_t pc, z80dasm_input_t in_cb, z80dasm_output_t out_cb, void* user_data);
+/* get the length of a single Z80 instruction in bytes without disassembling it */
+int z80dasm_oplen(z80dasm_input_t in_cb, void* user_data);
 
 #ifdef __cplusplus
 } /* extern "C" */
@@ -189,6 +202,64 @@ static const char* _z80dasm_oct = "01234567";
 static const char* _z80dasm_dec = "0123456789";
 static const char* _z80dasm_hex = "0123456789ABCDEF";
 
+/* instruction lengths in bytes of unprefixed ops */
+static const uint8_t _z80dasm_len[256] = {
+    1,3,1,1,1,1,2,1,1,1,1,1,1,1,2,1,  /* 00 */
+    2,3,1,1,1,1,2,1,2,1,1,1,1,1,2,1,  /* 10 */
+    2,3,3,1,1,1,2,1,2,1,3,1,1,1,2,1,  /* 20 */
+    2,3,3,1,1,1,2,1,2,1,3,1,1,1,2,1,  /* 30 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 40 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 50 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 60 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 70 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 80 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* 90 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* A0 */
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,  /* B0 */
+    1,1,3,3,3,1,2,1,1,1,3,2,3,3,2,1,  /* C0 */
+    1,1,3,2,3,1,2,1,1,1,3,2,3,2,2,1,  /* D0 */
+    1,1,3,1,3,1,2,1,1,1,3,1,3,2,2,1,  /* E0 */
+    1,1,3,1,3,1,2,1,1,1,3,1,3,2,2,1  /* F0 */
+};
+/* instruction lengths of ED-prefixed ops (including the ED prefix) */
+static const uint8_t _z80dasm_len_ed[256] = {
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* 00 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* 10 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* 20 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* 30 */
+    2,2,2,4,2,2,2,2,2,2,2,4,2,2,2,2,  /* 40 */
+    2,2,2,4,2,2,2,2,2,2,2,4,2,2,2,2,  /* 50 */
+    2,2,2,4,2,2,2,2,2,2,2,4,2,2,2,2,  /* 60 */
+    2,2,2,4,2,2,2,2,2,2,2,4,2,2,2,2,  /* 70 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* 80 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* 90 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* A0 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* B0 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* C0 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* D0 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,  /* E0 */
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2  /* F0 */
+};
+/* instruction lengths of DD/FD-prefixed ops (including the prefix, DD/FD CB d op is always 4) */
+static const uint8_t _z80dasm_len_dd[256] = {
+    2,4,2,2,2,2,3,2,2,2,2,2,2,2,3,2,  /* 00 */
+    3,4,2,2,2,2,3,2,3,2,2,2,2,2,3,2,  /* 10 */
+    3,4,4,2,2,2,3,2,3,2,4,2,2,2,3,2,  /* 20 */
+    3,4,4,2,3,3,4,2,3,2,4,2,2,2,3,2,  /* 30 */
+    2,2,2,2,2,2,3,2,2,2,2,2,2,2,3,2,  /* 40 */
+    2,2,2,2,2,2,3,2,2,2,2,2,2,2,3,2,  /* 50 */
+    2,2,2,2,2,2,3,2,2,2,2,2,2,2,3,2,  /* 60 */
+    3,3,3,3,3,3,2,3,2,2,2,2,2,2,3,2,  /* 70 */
+    2,2,2,2,2,2,3,2,2,2,2,2,2,2,3,2,  /* 80 */
+    2,2,2,2,2,2,3,2,2,2,2,2,2,2,3,2,  /* 90 */
+    2,2,2,2,2,2,3,2,2,2,2,2,2,2,3,2,  /* A0 */
+    2,2,2,2,2,2,3,2,2,2,2,2,2,2,3,2,  /* B0 */
+    2,2,4,4,4,2,3,2,2,2,4,4,4,4,3,2,  /* C0 */
+    2,2,4,3,4,2,3,2,2,2,4,3,4,2,3,2,  /* D0 */
+    2,2,4,2,4,2,3,2,2,2,4,2,4,3,3,2,  /* E0 */
+    2,2,4,2,4,2,3,2,2,2,4,2,4,2,3,2  /* F0 */
+};
+
 /* output a string */
 static void _z80dasm_str(const char* str, z80dasm_output_t out_cb, void* user_data) {
     if (out_cb) {
@@ -200,8 +271,10 @@ static void _z80dasm_str(const char* str, z80dasm_output_t out_cb, void* user_da
 }
 
 /* output a signed 8-bit offset value as decimal string */
-static void _z80dasm_d8(int8_t val, z80dasm_output_t out_cb, void* user_data) {
+static void _z80dasm_d8(int8_t d8, z80dasm_output_t out_cb, void* user_data) {
     if (out_cb) {
+        /* widen to int, -128 can't be negated as int8_t */
+        int val = d8;
         if (val < 0) {
             out_cb('-', user_data);
             val = -val;
@@ -212,8 +285,9 @@ static void _z80dasm_d8(int8_t val, z80dasm_output_t out_cb, void* user_data) {
         if (val >= 100) {
             out_cb('1', user_data);
             val -= 100;
+            out_cb(_z80dasm_dec[val/10], user_data);
         }
-        if ((val/10) != 0) {
+        else if ((val/10) != 0) {
             out_cb(_z80dasm_dec[val/10], user_data);
         }
         out_cb(_z80dasm_dec[val%10], user_data);
@@ -475,6 +549,25 @@ uint16_t z80dasm_op(uint16_t pc, z80dasm_input_t in_cb, z80dasm_output_t out_cb,
     return pc;
 }
 
+int z80dasm_oplen(z80dasm_input_t in_cb, void* user_data) {
+    CHIPS_ASSERT(in_cb);
+    uint8_t op = in_cb(user_data);
+    if ((0xDD == op) || (0xFD == op)) {
+        op = in_cb(user_data);
+        if (0xED == op) {
+            /* an ED following a prefix cancels the prefix */
+            return 1 + _z80dasm_len_ed[in_cb(user_data)];
+        }
+        return _z80dasm_len_dd[op];
+    }
+    else if (0xED == op) {
+        return _z80dasm_len_ed[in_cb(user_data)];
+    }
+    else {
+        return _z80dasm_len[op];
+    }
+}
+
 #undef _FETCH_U8
 #undef _FETCH_I8
 #undef _FETCH_U16